@@ -15,6 +15,7 @@
 
 #include "modules/blinky/service.h"
 #include "modules/board/service.h"
+#include "modules/log_policy/deferred_log.h"
 #include "pw_log/log.h"
 #include "pw_system/system.h"
 #include "system/system.h"
@@ -22,6 +23,8 @@
 
 int main() {
   sense::system::Init();
+  sense::DeferredLog::Global().Init(
+      sense::system::GetWorker(sense::system::LatencyClass::kBlocking));
   auto& rpc_server = pw::System().rpc_server();
   auto& worker = sense::system::GetWorker();
   auto& monochrome_led = sense::system::MonochromeLed();
@@ -31,9 +34,11 @@ int main() {
   board_service.Init(worker, sense::system::Board());
   rpc_server.RegisterService(board_service);
 
+  static sense::Blinky::FramePool blinky_frames(
+      PW_METRIC_TOKEN("blinky frames"));
   static sense::BlinkyService blinky_service;
   blinky_service.Init(pw::System().dispatcher(),
-                      pw::System().allocator(),
+                      blinky_frames,
                       monochrome_led,
                       polychrome_led);
   rpc_server.RegisterService(blinky_service);
@@ -18,9 +18,11 @@
 #include "modules/air_sensor/service.h"
 #include "modules/blinky/service.h"
 #include "modules/board/service.h"
+#include "modules/log_policy/deferred_log.h"
 #include "modules/proximity/manager.h"
 #include "modules/pubsub/service.h"
 #include "pw_log/log.h"
+#include "pw_metric/global.h"
 #include "pw_system/system.h"
 #include "system/pubsub.h"
 #include "system/system.h"
@@ -31,39 +33,46 @@ namespace {
 
 [[noreturn]] void InitializeApp() {
   system::Init();
+  DeferredLog::Global().Init(
+      system::GetWorker(system::LatencyClass::kBlocking));
 
   static BoardService board_service;
   board_service.Init(system::GetWorker(), system::Board());
   pw::System().rpc_server().RegisterService(board_service);
 
   static PubSubService pubsub_service;
-  pubsub_service.Init(system::PubSub());
+  pubsub_service.Init(system::GetWorker(), system::PubSub());
   pw::System().rpc_server().RegisterService(pubsub_service);
 
+  static Blinky::FramePool blinky_frames(PW_METRIC_TOKEN("blinky frames"));
   static sense::BlinkyService blinky_service;
   blinky_service.Init(pw::System().dispatcher(),
-                      pw::System().allocator(),
+                      blinky_frames,
                       system::MonochromeLed(),
                       system::PolychromeLed());
   pw::System().rpc_server().RegisterService(blinky_service);
 
   static AirSensor& air_sensor = system::AirSensor();
   static AirSensorService air_sensor_service;
-  air_sensor_service.Init(system::GetWorker(), air_sensor);
+  air_sensor_service.Init(
+      pw::System().dispatcher(), system::PubSub(), air_sensor);
   pw::System().rpc_server().RegisterService(air_sensor_service);
 
   auto& button_manager = system::ButtonManager();
-  button_manager.Init(system::PubSub(), system::GetWorker());
+  button_manager.Init(system::PubSub(),
+                      system::GetWorker(system::LatencyClass::kInteractive));
   button_manager.Stop();
 
   FactoryService factory_service;
-  factory_service.Init(system::Board(),
+  factory_service.Init(system::GetWorker(system::LatencyClass::kBlocking),
+                       system::Board(),
                        system::PubSub(),
                        button_manager,
                        system::ProximitySensor(),
                        system::AmbientLightSensor(),
                        air_sensor);
   pw::System().rpc_server().RegisterService(factory_service);
+  pw::metric::global_groups.push_back(factory_service.metrics());
 
   PW_LOG_INFO("Enviro+ Pack Diagnostics app");
   system::Start();
@@ -0,0 +1,43 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "apps/factory/sample_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sense {
+
+void SampleStatistics::Add(float sample) {
+  if (count_ == 0) {
+    min_ = sample;
+    max_ = sample;
+  } else {
+    min_ = std::min(min_, sample);
+    max_ = std::max(max_, sample);
+  }
+  ++count_;
+  const double delta = sample - mean_;
+  mean_ += delta / count_;
+  squared_deviations_ += delta * (sample - mean_);
+}
+
+float SampleStatistics::stddev() const {
+  if (count_ == 0) {
+    return 0.f;
+  }
+  return static_cast<float>(std::sqrt(squared_deviations_ / count_));
+}
+
+}  // namespace sense
@@ -0,0 +1,46 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+namespace sense {
+
+/// Running minimum, maximum, mean and standard deviation of a series of
+/// samples, kept without storing them.
+class SampleStatistics {
+ public:
+  void Add(float sample);
+
+  uint32_t count() const { return count_; }
+
+  /// The following are zero until a sample is added.
+  float min() const { return min_; }
+  float max() const { return max_; }
+  float mean() const { return static_cast<float>(mean_); }
+
+  /// Population standard deviation.
+  float stddev() const;
+
+ private:
+  uint32_t count_ = 0;
+  float min_ = 0.f;
+  float max_ = 0.f;
+
+  // Welford's algorithm, which avoids the cancellation of summing squares.
+  double mean_ = 0.;
+  double squared_deviations_ = 0.;
+};
+
+}  // namespace sense
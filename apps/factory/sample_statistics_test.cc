@@ -0,0 +1,64 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "apps/factory/sample_statistics.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+TEST(SampleStatisticsTest, Empty) {
+  SampleStatistics statistics;
+  EXPECT_EQ(statistics.count(), 0u);
+  EXPECT_EQ(statistics.min(), 0.f);
+  EXPECT_EQ(statistics.max(), 0.f);
+  EXPECT_EQ(statistics.mean(), 0.f);
+  EXPECT_EQ(statistics.stddev(), 0.f);
+}
+
+TEST(SampleStatisticsTest, SingleSample) {
+  SampleStatistics statistics;
+  statistics.Add(-3.5f);
+  EXPECT_EQ(statistics.count(), 1u);
+  EXPECT_EQ(statistics.min(), -3.5f);
+  EXPECT_EQ(statistics.max(), -3.5f);
+  EXPECT_EQ(statistics.mean(), -3.5f);
+  EXPECT_EQ(statistics.stddev(), 0.f);
+}
+
+TEST(SampleStatisticsTest, Series) {
+  SampleStatistics statistics;
+  for (float sample : {2.f, 4.f, 4.f, 4.f, 5.f, 5.f, 7.f, 9.f}) {
+    statistics.Add(sample);
+  }
+  EXPECT_EQ(statistics.count(), 8u);
+  EXPECT_EQ(statistics.min(), 2.f);
+  EXPECT_EQ(statistics.max(), 9.f);
+  EXPECT_FLOAT_EQ(statistics.mean(), 5.f);
+  EXPECT_FLOAT_EQ(statistics.stddev(), 2.f);
+}
+
+TEST(SampleStatisticsTest, LargeOffset) {
+  // Samples close together far from zero lose no precision to cancellation.
+  SampleStatistics statistics;
+  for (int i = 0; i < 1000; ++i) {
+    statistics.Add(i % 2 == 0 ? 60000.f : 60002.f);
+  }
+  EXPECT_FLOAT_EQ(statistics.mean(), 60001.f);
+  EXPECT_FLOAT_EQ(statistics.stddev(), 1.f);
+}
+
+}  // namespace
+}  // namespace sense
@@ -16,12 +16,61 @@
 
 #define PW_LOG_MODULE_NAME "FACT"
 
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_assert/check.h"
 #include "pw_log/log.h"
 #include "pw_status/try.h"
+#include "pw_thread/sleep.h"
 
 namespace sense {
+namespace {
+
+using Clock = pw::chrono::SystemClock;
+
+// How long to wait between polls when no burst has a sensor to read.
+constexpr auto kIdlePollInterval = std::chrono::milliseconds(5);
+
+bool WithinLimits(const SampleStatistics& statistics,
+                  const factory_Limits& limits) {
+  return statistics.min() >= limits.min && statistics.max() <= limits.max &&
+         (!limits.has_max_stddev || statistics.stddev() <= limits.max_stddev);
+}
+
+}  // namespace
+
+FactoryService::FactoryService()
+    : start_test_(PW_METRIC_TOKEN("StartTest"),
+                  [this](const factory_StartTestRequest& request,
+                         pw_protobuf_Empty&) { return DoStartTest(request); }),
+      sample_prox_(PW_METRIC_TOKEN("SampleLtr559Prox"),
+                   [this](const pw_protobuf_Empty&,
+                          factory_Ltr559ProxSample& response) {
+                     return DoSampleLtr559Prox(response);
+                   }),
+      sample_light_(PW_METRIC_TOKEN("SampleLtr559Light"),
+                    [this](const pw_protobuf_Empty&,
+                           factory_Ltr559LightSample& response) {
+                      return DoSampleLtr559Light(response);
+                    }),
+      run_burst_(PW_METRIC_TOKEN("RunBurst"),
+                 [this](const factory_BurstRequest& request,
+                        factory_BurstResult& response) {
+                   return DoRunBurst(request, response);
+                 }),
+      run_plan_([this]() { RunPlan(); }) {
+  metrics_.Add(start_test_.metrics().metrics());
+  metrics_.Add(sample_prox_.metrics().metrics());
+  metrics_.Add(sample_light_.metrics().metrics());
+  metrics_.Add(run_burst_.metrics().metrics());
+}
 
-void FactoryService::Init(Board& board,
+void FactoryService::Init(Worker& worker,
+                          Board& board,
                           PubSub& pubsub,
                           ButtonManager& button_manager,
                           ProximitySensor& proximity_sensor,
@@ -33,6 +82,23 @@ void FactoryService::Init(Board& board,
   proximity_sensor_ = &proximity_sensor;
   ambient_light_sensor_ = &ambient_light_sensor;
   air_sensor_ = &air_sensor;
+  worker_ = &worker;
+  start_test_.Init(worker);
+  sample_prox_.Init(worker);
+  sample_light_.Init(worker);
+  run_burst_.Init(worker);
+
+  PW_CHECK((pubsub.SubscribeToAny<ButtonA, ButtonB, ButtonX, ButtonY>(
+      [this](const Event& event) {
+        std::visit(
+            [this](const auto& button) {
+              if constexpr (std::is_base_of_v<ButtonStateChange,
+                                              std::decay_t<decltype(button)>>) {
+                HandleButton(button.pressed());
+              }
+            },
+            event);
+      })));
 }
 
 pw::Status FactoryService::GetDeviceInfo(const pw_protobuf_Empty&,
@@ -41,8 +107,8 @@ pw::Status FactoryService::GetDeviceInfo(const pw_protobuf_Empty&,
   return pw::OkStatus();
 }
 
-pw::Status FactoryService::StartTest(const factory_StartTestRequest& request,
-                                     pw_protobuf_Empty&) {
+pw::Status FactoryService::DoStartTest(
+    const factory_StartTestRequest& request) {
   switch (request.test) {
     case factory_Test_Type_BUTTONS:
       PW_LOG_INFO("Configured for buttons test");
@@ -80,8 +146,8 @@ pw::Status FactoryService::EndTest(const factory_EndTestRequest& request,
   return pw::OkStatus();
 }
 
-pw::Status FactoryService::SampleLtr559Prox(
-    const pw_protobuf_Empty&, factory_Ltr559ProxSample& response) {
+pw::Status FactoryService::DoSampleLtr559Prox(
+    factory_Ltr559ProxSample& response) {
   pw::Result<uint16_t> result = proximity_sensor_->ReadSample();
   PW_TRY(result);
 
@@ -89,8 +155,8 @@ pw::Status FactoryService::SampleLtr559Prox(
   return pw::OkStatus();
 }
 
-pw::Status FactoryService::SampleLtr559Light(
-    const pw_protobuf_Empty&, factory_Ltr559LightSample& response) {
+pw::Status FactoryService::DoSampleLtr559Light(
+    factory_Ltr559LightSample& response) {
   pw::Result<float> result = ambient_light_sensor_->ReadSampleLux();
   PW_TRY(result);
 
@@ -98,4 +164,271 @@ pw::Status FactoryService::SampleLtr559Light(
   return pw::OkStatus();
 }
 
+pw::Status FactoryService::DoRunBurst(const factory_BurstRequest& request,
+                                      factory_BurstResult& response) {
+  PW_TRY(Validate(request));
+  Burst burst = StartBurst(request);
+  RunBursts(pw::span(&burst, 1), [&response](const Burst& finished) {
+    FillResult(finished, response);
+  });
+  PW_LOG_INFO("Burst of %u samples %s in %u ms",
+              static_cast<unsigned>(response.statistics.count),
+              response.passed ? "passed" : "failed",
+              static_cast<unsigned>(response.duration_ms));
+  return pw::OkStatus();
+}
+
+void FactoryService::RunTestPlan(const factory_TestPlan& request,
+                                 ServerWriter<factory_TestResult>& writer) {
+  pw::Status status = request.tests_count == 0 ? pw::Status::InvalidArgument()
+                                               : pw::OkStatus();
+  uint32_t tests = 0;
+  for (pb_size_t i = 0; i < request.tests_count && status.ok(); ++i) {
+    status = Validate(request.tests[i]);
+    if (!status.ok()) {
+      break;
+    }
+    const uint32_t bit = 1u << request.tests[i].test;
+    if ((tests & bit) != 0) {
+      status = pw::Status::InvalidArgument();
+    }
+    tests |= bit;
+  }
+  if (status.ok()) {
+    std::lock_guard lock(plan_lock_);
+    if (plan_running_) {
+      status = pw::Status::Unavailable();
+    } else {
+      plan_running_ = true;
+      plan_ = request;
+      plan_writer_ = std::move(writer);
+    }
+  }
+  if (!status.ok()) {
+    if (const auto finish = writer.Finish(status); !finish.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", finish.str());
+    }
+    return;
+  }
+  if (!run_plan_.Post(*worker_)) {
+    PW_LOG_ERROR("Failed to queue test plan");
+    std::lock_guard lock(plan_lock_);
+    plan_running_ = false;
+    if (const auto finish = plan_writer_.Finish(pw::Status::Unavailable());
+        !finish.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", finish.str());
+    }
+  }
+}
+
+void FactoryService::RunPlan() {
+  // Start every test before sampling any, so that slow ones, like the
+  // BME688's heater, settle while the others run.
+  std::array<bool, kMaxPlanTests> started{};
+  for (pb_size_t i = 0; i < plan_.tests_count; ++i) {
+    const factory_BurstRequest& request = plan_.tests[i];
+    const pw::Status status = DoStartTest({.test = request.test});
+    started[i] = status.ok();
+    if (!status.ok()) {
+      PW_LOG_WARN("Failed to start test %d: %s",
+                  static_cast<int>(request.test),
+                  status.str());
+      factory_TestResult result = factory_TestResult_init_default;
+      result.test = request.test;
+      result.status = status.code();
+      std::ignore = plan_writer_.Write(result);
+    }
+  }
+
+  std::array<Burst, kMaxPlanTests> bursts;
+  size_t count = 0;
+  for (pb_size_t i = 0; i < plan_.tests_count; ++i) {
+    if (started[i]) {
+      bursts[count++] = StartBurst(plan_.tests[i]);
+    }
+  }
+  RunBursts(pw::span(bursts.data(), count), [this](const Burst& burst) {
+    factory_TestResult result = factory_TestResult_init_default;
+    result.test = burst.request.test;
+    result.has_result = true;
+    FillResult(burst, result.result);
+    if (const auto status = plan_writer_.Write(result); !status.ok()) {
+      PW_LOG_WARN("Failed to send test result: %s", status.str());
+    }
+  });
+
+  for (size_t i = 0; i < count; ++i) {
+    pw_protobuf_Empty empty;
+    std::ignore = EndTest({.test = bursts[i].request.test}, empty);
+  }
+  if (const auto status = plan_writer_.Finish(pw::OkStatus()); !status.ok()) {
+    PW_LOG_ERROR("Failed to write response: %s", status.str());
+  }
+
+  std::lock_guard lock(plan_lock_);
+  plan_running_ = false;
+}
+
+pw::Status FactoryService::Validate(const factory_BurstRequest& request) {
+  if (request.test < _factory_Test_Type_MIN ||
+      request.test > _factory_Test_Type_MAX || request.samples == 0 ||
+      request.samples > kMaxBurstSamples) {
+    return pw::Status::InvalidArgument();
+  }
+  return pw::OkStatus();
+}
+
+FactoryService::Burst FactoryService::StartBurst(
+    const factory_BurstRequest& request) {
+  Burst burst;
+  burst.request = request;
+  burst.start = Clock::now();
+  burst.deadline =
+      burst.start +
+      Clock::for_at_least(request.timeout_ms == 0
+                              ? std::chrono::milliseconds(kDefaultBurstTimeout)
+                              : std::chrono::milliseconds(request.timeout_ms));
+  return burst;
+}
+
+void FactoryService::FillResult(const Burst& burst,
+                                factory_BurstResult& result) {
+  const SampleStatistics& statistics = burst.statistics;
+  result.has_statistics = true;
+  result.statistics = {
+      .count = statistics.count(),
+      .min = statistics.min(),
+      .max = statistics.max(),
+      .mean = statistics.mean(),
+      .stddev = statistics.stddev(),
+  };
+  result.errors = burst.errors;
+  result.passed = burst.errors == 0 &&
+                  statistics.count() == burst.request.samples &&
+                  (!burst.request.has_limits ||
+                   WithinLimits(statistics, burst.request.limits));
+  result.duration_ms = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                            burst.start)
+          .count());
+}
+
+void FactoryService::RunBursts(
+    pw::span<Burst> bursts, const pw::Function<void(const Burst&)>& on_done) {
+  for (Burst& burst : bursts) {
+    if (burst.request.test == factory_Test_Type_BUTTONS) {
+      ArmButtons(burst);
+    }
+  }
+
+  size_t remaining = bursts.size();
+  while (remaining > 0) {
+    bool read_sensor = false;
+    for (Burst& burst : bursts) {
+      if (burst.done) {
+        continue;
+      }
+      read_sensor |= Step(burst);
+      // Button statistics are filled in by PubSub until the burst is
+      // disarmed, so only its own notification says it is complete.
+      const bool complete =
+          burst.request.test != factory_Test_Type_BUTTONS &&
+          burst.statistics.count() + burst.errors >= burst.request.samples;
+      if (!complete && !burst.done && Clock::now() < burst.deadline) {
+        continue;
+      }
+      burst.done = true;
+      if (burst.request.test == factory_Test_Type_BUTTONS) {
+        DisarmButtons();
+      }
+      on_done(burst);
+      --remaining;
+    }
+    // Bursts that only wait, such as for button presses or an air
+    // measurement, need not spin.
+    if (!read_sensor && remaining > 0) {
+      pw::this_thread::sleep_for(kIdlePollInterval);
+    }
+  }
+}
+
+bool FactoryService::Step(Burst& burst) {
+  switch (burst.request.test) {
+    case factory_Test_Type_BUTTONS:
+      burst.done = button_burst_done_.try_acquire();
+      return false;
+    case factory_Test_Type_LTR559_PROX:
+      if (const auto sample = proximity_sensor_->ReadSample(); sample.ok()) {
+        burst.statistics.Add(static_cast<float>(*sample));
+      } else {
+        ++burst.errors;
+      }
+      return true;
+    case factory_Test_Type_LTR559_LIGHT:
+      if (const auto lux = ambient_light_sensor_->ReadSampleLux(); lux.ok()) {
+        burst.statistics.Add(*lux);
+      } else {
+        ++burst.errors;
+      }
+      return true;
+    case factory_Test_Type_BME688:
+      // Measurements take a while, so other bursts run while the sensor
+      // measures. A measurement left over from an earlier burst that timed
+      // out is ignored.
+      if (!burst.measuring) {
+        std::ignore = air_measured_.try_acquire();
+        burst.measuring = air_sensor_->Measure(air_measured_).ok();
+        if (!burst.measuring) {
+          ++burst.errors;
+        }
+        return !burst.measuring;
+      }
+      if (air_measured_.try_acquire()) {
+        burst.measuring = false;
+        burst.statistics.Add(air_sensor_->temperature());
+      }
+      return false;
+  }
+  return false;
+}
+
+void FactoryService::ArmButtons(Burst& burst) {
+  // Clear a release left over from a burst that timed out as it finished.
+  std::ignore = button_burst_done_.try_acquire();
+  std::lock_guard lock(button_lock_);
+  button_burst_ = {
+      .statistics = &burst.statistics,
+      .samples = burst.request.samples,
+  };
+}
+
+void FactoryService::DisarmButtons() {
+  std::lock_guard lock(button_lock_);
+  button_burst_ = {};
+}
+
+void FactoryService::HandleButton(bool pressed) {
+  const Clock::time_point now = Clock::now();
+  std::lock_guard lock(button_lock_);
+  if (button_burst_.statistics == nullptr) {
+    return;
+  }
+  if (pressed) {
+    button_burst_.pressed_at = now;
+    return;
+  }
+  if (!button_burst_.pressed_at.has_value()) {
+    return;
+  }
+  button_burst_.statistics->Add(
+      std::chrono::duration<float, std::milli>(now -
+                                               *button_burst_.pressed_at)
+          .count());
+  button_burst_.pressed_at.reset();
+  if (button_burst_.statistics->count() == button_burst_.samples) {
+    button_burst_.statistics = nullptr;
+    button_burst_done_.release();
+  }
+}
+
 }  // namespace sense
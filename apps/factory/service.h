@@ -13,19 +13,57 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
 #include "apps/factory/factory_pb/factory.rpc.pb.h"
+#include "apps/factory/sample_statistics.h"
 #include "modules/air_sensor/air_sensor.h"
 #include "modules/board/board.h"
 #include "modules/buttons/manager.h"
 #include "modules/light/sensor.h"
 #include "modules/proximity/sensor.h"
+#include "modules/rpc_offload/offloaded_method.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_function/function.h"
+#include "pw_metric/metric.h"
+#include "pw_span/span.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_sync/timed_thread_notification.h"
 
 namespace sense {
 
 class FactoryService final
     : public ::factory::pw_rpc::nanopb::Factory::Service<FactoryService> {
  public:
-  void Init(Board& board,
+  using StartTestMethod =
+      OffloadedUnaryMethod<factory_StartTestRequest, pw_protobuf_Empty>;
+  using SampleProxMethod =
+      OffloadedUnaryMethod<pw_protobuf_Empty, factory_Ltr559ProxSample>;
+  using SampleLightMethod =
+      OffloadedUnaryMethod<pw_protobuf_Empty, factory_Ltr559LightSample>;
+  using RunBurstMethod =
+      OffloadedUnaryMethod<factory_BurstRequest, factory_BurstResult>;
+
+  static constexpr uint32_t kMaxBurstSamples = 1000;
+  static constexpr auto kDefaultBurstTimeout = std::chrono::seconds(10);
+
+  /// A plan runs each test type at most once.
+  static constexpr size_t kMaxPlanTests = 4;
+
+  FactoryService();
+
+  /// Handlers that wait on sensors run on `worker`, so that a slow sensor
+  /// does not hold up the other services.
+  void Init(Worker& worker,
+            Board& board,
             PubSub& pubsub,
             ButtonManager& button_manager,
             ProximitySensor& proximity_sensor,
@@ -35,24 +73,109 @@ class FactoryService final
   pw::Status GetDeviceInfo(const pw_protobuf_Empty&,
                            factory_DeviceInfo& response);
 
-  pw::Status StartTest(const factory_StartTestRequest& request,
-                       pw_protobuf_Empty&);
+  void StartTest(const factory_StartTestRequest& request,
+                 StartTestMethod::Responder& responder) {
+    start_test_.Call(request, responder);
+  }
 
   pw::Status EndTest(const factory_EndTestRequest& request, pw_protobuf_Empty&);
 
-  pw::Status SampleLtr559Prox(const pw_protobuf_Empty&,
-                              factory_Ltr559ProxSample& response);
+  void SampleLtr559Prox(const pw_protobuf_Empty& request,
+                        SampleProxMethod::Responder& responder) {
+    sample_prox_.Call(request, responder);
+  }
+
+  void SampleLtr559Light(const pw_protobuf_Empty& request,
+                         SampleLightMethod::Responder& responder) {
+    sample_light_.Call(request, responder);
+  }
 
-  pw::Status SampleLtr559Light(const pw_protobuf_Empty&,
-                               factory_Ltr559LightSample& response);
+  void RunBurst(const factory_BurstRequest& request,
+                RunBurstMethod::Responder& responder) {
+    run_burst_.Call(request, responder);
+  }
+
+  /// Only one plan may run at a time.
+  void RunTestPlan(const factory_TestPlan& request,
+                   ServerWriter<factory_TestResult>& writer)
+      PW_LOCKS_EXCLUDED(plan_lock_);
+
+  /// Call counts and latencies of the offloaded methods.
+  pw::metric::Group& metrics() { return metrics_; }
 
  private:
+  pw::Status DoStartTest(const factory_StartTestRequest& request);
+  pw::Status DoSampleLtr559Prox(factory_Ltr559ProxSample& response);
+  pw::Status DoSampleLtr559Light(factory_Ltr559LightSample& response);
+  pw::Status DoRunBurst(const factory_BurstRequest& request,
+                        factory_BurstResult& response);
+
+  /// A burst of samples being taken for one test.
+  struct Burst {
+    factory_BurstRequest request;
+    pw::chrono::SystemClock::time_point start;
+    pw::chrono::SystemClock::time_point deadline;
+    SampleStatistics statistics;
+    uint32_t errors = 0;
+    bool measuring = false;
+    bool done = false;
+  };
+
+  static pw::Status Validate(const factory_BurstRequest& request);
+  static Burst StartBurst(const factory_BurstRequest& request);
+  static void FillResult(const Burst& burst, factory_BurstResult& result);
+
+  /// Runs the bursts together, interleaving sensor reads, and calls
+  /// `on_done` for each as it finishes. Their tests must have been started.
+  void RunBursts(pw::span<Burst> bursts,
+                 const pw::Function<void(const Burst&)>& on_done)
+      PW_LOCKS_EXCLUDED(button_lock_);
+
+  /// Advances `burst` without blocking. Returns whether it read a sensor.
+  bool Step(Burst& burst) PW_LOCKS_EXCLUDED(button_lock_);
+
+  /// Starts timing button presses into `burst`'s statistics.
+  void ArmButtons(Burst& burst) PW_LOCKS_EXCLUDED(button_lock_);
+  void DisarmButtons() PW_LOCKS_EXCLUDED(button_lock_);
+
+  void HandleButton(bool pressed) PW_LOCKS_EXCLUDED(button_lock_);
+
+  /// Starts the plan's tests, runs their bursts and ends the tests.
+  void RunPlan() PW_LOCKS_EXCLUDED(plan_lock_);
+
+  /// Button presses being timed by a burst.
+  struct ButtonBurst {
+    SampleStatistics* statistics = nullptr;
+    uint32_t samples = 0;
+    std::optional<pw::chrono::SystemClock::time_point> pressed_at;
+  };
+
+  Worker* worker_ = nullptr;
   Board* board_;
   PubSub* pubsub_;
   ButtonManager* button_manager_;
   ProximitySensor* proximity_sensor_;
   AmbientLightSensor* ambient_light_sensor_;
   AirSensor* air_sensor_;
+
+  StartTestMethod start_test_;
+  SampleProxMethod sample_prox_;
+  SampleLightMethod sample_light_;
+  RunBurstMethod run_burst_;
+
+  pw::sync::Mutex button_lock_;
+  ButtonBurst button_burst_ PW_GUARDED_BY(button_lock_);
+  pw::sync::TimedThreadNotification button_burst_done_;
+  pw::sync::ThreadNotification air_measured_;
+
+  pw::sync::Mutex plan_lock_;
+  bool plan_running_ PW_GUARDED_BY(plan_lock_) = false;
+  // Only used by `RunPlan` while a plan runs.
+  factory_TestPlan plan_;
+  ServerWriter<factory_TestResult> plan_writer_;
+  WorkItem run_plan_;
+
+  PW_METRIC_GROUP(metrics_, "factory rpc");
 };
 
 }  // namespace sense
@@ -14,36 +14,223 @@
 
 #define PW_LOG_MODULE_NAME "MAIN"
 
-#include "apps/production/threads.h"
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <optional>
+
+#include "modules/air_sensor/iaq_model.h"
 #include "modules/air_sensor/service.h"
 #include "modules/board/service.h"
+#include "modules/config/config_store.h"
+#include "modules/cpu_usage/service.h"
+#include "modules/energy/service.h"
 #include "modules/event_timers/event_timers.h"
+#include "modules/history/history.h"
+#include "modules/history/service.h"
+#include "modules/led/led_morse_playback.h"
+#include "modules/log_policy/deferred_log.h"
+#include "modules/memory/service.h"
 #include "modules/morse_code/encoder.h"
 #include "modules/proximity/manager.h"
+#include "modules/pubsub/bridge.h"
 #include "modules/pubsub/service.h"
 #include "modules/sampling_thread/sampling_thread.h"
+#include "modules/sampling_thread/service.h"
 #include "modules/state_manager/service.h"
 #include "modules/state_manager/state_manager.h"
+#include "modules/telemetry/service.h"
+#include "modules/uplink/uplink.h"
+#include "modules/worker/latency_watchdog.h"
 #include "pw_assert/check.h"
+#include "pw_chrono/system_clock.h"
 #include "pw_log/log.h"
+#include "pw_metric/global.h"
+#include "pw_metric/metric_service_pwpb.h"
+#include "pw_sync/mutex.h"
 #include "pw_system/system.h"
-#include "pw_thread/detached_thread.h"
+#include "pw_trace/trace.h"
 #include "system/pubsub.h"
 #include "system/system.h"
 #include "system/worker.h"
 
+#ifndef SENSE_TRACE_ENABLED
+#define SENSE_TRACE_ENABLED 0
+#endif  // SENSE_TRACE_ENABLED
+
+#if SENSE_TRACE_ENABLED
+#include "modules/profiling/service.h"
+#endif  // SENSE_TRACE_ENABLED
+
 namespace sense {
 namespace {
 
+// Logs how long after boot an initialization phase finished.
+void LogBootPhase(const char* phase) {
+  const auto since_boot = std::chrono::ceil<std::chrono::milliseconds>(
+      pw::chrono::SystemClock::now().time_since_epoch());
+  PW_LOG_INFO("Boot: %s ready at %u ms",
+              phase,
+              static_cast<unsigned>(since_boot.count()));
+}
+
+// The IAQ model the air sensor scores with, if any. See `SENSE_IAQ_MODEL`.
+constexpr std::optional<IaqModel::Config> kIaqModel =
+    SENSE_IAQ_MODEL == 1   ? std::optional(IaqModel::kLowPower)
+    : SENSE_IAQ_MODEL == 2 ? std::optional(IaqModel::kUltraLowPower)
+                           : std::nullopt;
+
+// Services that ask the sampler to sample a sensor at least so often.
+enum class SampleRequester : size_t {
+  kAirSensorStream = 0,
+  kTelemetry,
+};
+constexpr size_t kNumSampleRequesters = 2;
+
+// Gives the sampler the shortest period any requester still needs, since each
+// call to `SetMaxPeriod` replaces the previous limit.
+void RequestMaxPeriod(SampleRequester requester,
+                      Sampler::Sensor sensor,
+                      pw::chrono::SystemClock::duration period) {
+  if (kIaqModel.has_value() && sensor == Sampler::Sensor::kAir) {
+    return;  // the model needs the air sensor kept to its schedule
+  }
+  static pw::sync::Mutex lock;
+  static std::array<std::array<pw::chrono::SystemClock::duration,
+                               kNumSampleRequesters>,
+                    Sampler::kNumSensors>
+      periods = {};
+
+  std::lock_guard guard(lock);
+  auto& requested = periods[static_cast<size_t>(sensor)];
+  requested[static_cast<size_t>(requester)] = period;
+  pw::chrono::SystemClock::duration shortest = {};
+  for (const auto& p : requested) {
+    if (p != p.zero() && (shortest == shortest.zero() || p < shortest)) {
+      shortest = p;
+    }
+  }
+  GetSampler().SetMaxPeriod(sensor, shortest);
+}
+
+// The subscribers below are fixed for the life of the app, so they are routed
+// to by `ProductionSubscribers` instead of taking runtime PubSub slots.
+
+StateManager& GetStateManager() {
+  static StateManager state_manager(
+      system::PubSub(), system::PolychromeLed(), kStaticallySubscribed);
+  return state_manager;
+}
+
+StateManagerService& GetStateManagerService() {
+  static StateManagerService state_manager_service(
+      system::PubSub(),
+      kStaticallySubscribed,
+      &GetStateManager().transition_metrics());
+  return state_manager_service;
+}
+
+EventTimers<3>& GetEventTimers() {
+  static EventTimers<3> event_timers(system::PubSub(), kStaticallySubscribed);
+  return event_timers;
+}
+
+Encoder& GetMorseEncoder() {
+  static Encoder morse_encoder;
+  return morse_encoder;
+}
+
+Sampler& GetSampler() {
+  static Sampler sampler;
+  return sampler;
+}
+
+void UpdateStateManager(const Event& event) { GetStateManager().Update(event); }
+
+void UpdateStateManagerService(const SenseState& state) {
+  GetStateManagerService().Update(state);
+}
+
+// Keeps the alarm threshold across reboots. Only changes are written.
+void SaveAlarmThreshold(const SenseState& state) {
+  system::ConfigStore().Set(ConfigStore::Key::kAlarmThreshold,
+                            state.alarm_threshold);
+}
+
+void StartTimer(const TimerRequest& request) {
+  GetEventTimers().OnTimerRequest(request);
+}
+
+void CancelTimer(const TimerCancel& cancel) {
+  GetEventTimers().OnTimerCancel(cancel);
+}
+
+void EncodeMorse(const MorseEncodeRequest& request) {
+  if (!request.runs.empty()) {
+    PW_CHECK_OK(GetMorseEncoder().Encode(
+        request.runs, request.repeat, Encoder::kDefaultIntervalMs));
+    return;
+  }
+  PW_CHECK_OK(GetMorseEncoder().Encode(
+      request.payload.str(), request.repeat, Encoder::kDefaultIntervalMs));
+}
+
+// Logs when proximity is detected.
+void LogProximity(const ProximityStateChange& state) {
+  if (state.proximity) {
+    PW_LOG_INFO("Proximity detected!");
+  } else {
+    PW_LOG_INFO("Proximity NOT detected!");
+  }
+}
+
+// Samples at full rate while someone is nearby.
+void SampleFastWhenNear(const ProximityStateChange& state) {
+  if (state.proximity) {
+    GetSampler().RequestFastSampling();
+  }
+}
+
+using ProductionSubscribers = StaticSubscribers<
+    StaticSubscriber<&UpdateStateManager>,
+    StaticSubscriberTo<SenseState, &UpdateStateManagerService>,
+    StaticSubscriberTo<SenseState, &SaveAlarmThreshold>,
+    StaticSubscriberTo<TimerRequest, &StartTimer>,
+    StaticSubscriberTo<TimerCancel, &CancelTimer>,
+    StaticSubscriberTo<MorseEncodeRequest, &EncodeMorse>,
+    StaticSubscriberTo<ProximityStateChange, &LogProximity>,
+    StaticSubscriberTo<ProximityStateChange, &SampleFastWhenNear>>;
+
+void InitPubSubBridges() {
+  // Control subscribers, including the host's PubSub stream, still see every
+  // reading. The data consumers on the sensor bus keep its dispatch off the
+  // control bus.
+  static PubSubBridge<Event,
+                      ProximitySample,
+                      AmbientLightSample,
+                      AirQuality,
+                      AirMeasurement>
+      sensor_to_control;
+  PW_CHECK(sensor_to_control.Init(system::SensorPubSub(), system::PubSub()));
+
+  // Telemetry streams the state alongside the readings.
+  static PubSubBridge<Event, SenseState> control_to_sensor;
+  PW_CHECK(control_to_sensor.Init(system::PubSub(), system::SensorPubSub()));
+}
+
 void InitStateManager() {
-  static StateManager state_manager(system::PubSub(), system::PolychromeLed());
-  static StateManagerService state_manager_service(system::PubSub());
-  pw::System().rpc_server().RegisterService(state_manager_service);
+  StateManager& state_manager = GetStateManager();
+  if (std::optional<uint32_t> threshold =
+          system::ConfigStore().Get(ConfigStore::Key::kAlarmThreshold)) {
+    state_manager.RestoreAlarmThreshold(static_cast<uint16_t>(
+        std::min<uint32_t>(*threshold, AirSensor::kMaxScore)));
+  }
+  pw::System().rpc_server().RegisterService(GetStateManagerService());
 }
 
 void InitEventTimers() {
-  auto& pubsub = system::PubSub();
-  static EventTimers<3> event_timers(pubsub);
+  EventTimers<3>& event_timers = GetEventTimers();
   PW_CHECK_OK(event_timers.AddEventTimer(StateManager::kRepeatAlarmToken));
   PW_CHECK_OK(event_timers.AddEventTimer(StateManager::kSilenceAlarmToken));
   PW_CHECK_OK(event_timers.AddEventTimer(StateManager::kThresholdModeToken));
@@ -56,67 +243,290 @@ void InitBoardService() {
 }
 
 void InitMorseEncoder() {
-  // The morse encoder will emit pubsub events to the state manager.
-  static Encoder morse_encoder;
-  morse_encoder.Init(system::GetWorker(),
-                     [](bool turn_on, const Encoder::State& state) {
-                       std::ignore = system::PubSub().Publish(MorseCodeValue{
-                           .turn_on = turn_on,
-                           .message_finished = state.message_finished(),
-                       });
-                     });
-
-  PW_CHECK(system::PubSub().SubscribeTo<MorseEncodeRequest>(
-      [](MorseEncodeRequest request) {
-        PW_CHECK_OK(morse_encoder.Encode(
-            request.message, request.repeat, Encoder::kDefaultIntervalMs));
-      }));
-}
-
-void InitProximitySensor() {
-  // Set up a proximity detector state machine.
+  // The morse encoder will emit pubsub events to the state manager. Messages
+  // that fit in the LED's level stream are blinked by hardware instead, and
+  // only report when they finish. Encoding only happens from PubSub callbacks,
+  // which is also where the state manager updates the LED.
+  Encoder& morse_encoder = GetMorseEncoder();
+  static LedMorsePlayback morse_playback(system::PolychromeLed());
+  morse_encoder.Init([](bool turn_on, const Encoder::State& state) {
+    std::ignore = system::PubSub().Publish(MorseCodeValue{
+        .turn_on = turn_on,
+        .message_finished = state.message_finished(),
+    });
+  });
+  morse_encoder.UsePlayback(morse_playback);
+}
+
+ProximityManager& InitProximitySensor() {
+  // Set up a proximity detector state machine. These are the lowest
+  // thresholds; the manager raises them above each unit's baseline.
   constexpr uint16_t kInitialNearTheshold = 16384;
   constexpr uint16_t kInitialFarTheshold = 512;
-  static ProximityManager proximity(
-      system::PubSub(), kInitialFarTheshold, kInitialNearTheshold);
-
-  // Log when proximity is detected.
-  PW_CHECK(system::PubSub().SubscribeTo<ProximityStateChange>(
-      [](ProximityStateChange state) {
-        if (state.proximity) {
-          PW_LOG_INFO("Proximity detected!");
-        } else {
-          PW_LOG_INFO("Proximity NOT detected!");
-        }
-      }));
+  static ProximityManager proximity(system::PubSub(),
+                                    system::ProximitySensor(),
+                                    kInitialFarTheshold,
+                                    kInitialNearTheshold);
+  pw::metric::global_groups.push_back(proximity.metrics());
+  return proximity;
 }
 
 void InitAirSensor() {
   static AirSensor& air_sensor = sense::system::AirSensor();
+  if (kIaqModel.has_value()) {
+    air_sensor.UseIaqModel(*kIaqModel);
+  }
   static sense::AirSensorService air_sensor_service;
-  air_sensor_service.Init(system::GetWorker(), air_sensor);
+  // Streams share the sampler's measurements, so have it measure at least as
+  // often as the fastest stream.
+  air_sensor_service.Init(
+      pw::System().dispatcher(),
+      system::SensorPubSub(),
+      air_sensor,
+      [](pw::chrono::SystemClock::duration interval) {
+        RequestMaxPeriod(SampleRequester::kAirSensorStream,
+                         Sampler::Sensor::kAir,
+                         interval);
+      });
   pw::System().rpc_server().RegisterService(air_sensor_service);
 }
 
+void InitTelemetry() {
+  static TelemetryService telemetry_service;
+  telemetry_service.Init(
+      system::GetWorker(),
+      system::SensorPubSub(),
+      system::Board(),
+      [](TelemetrySchedule::Channel channel,
+         pw::chrono::SystemClock::duration interval) {
+        switch (channel) {
+          case TelemetrySchedule::kAir:
+            RequestMaxPeriod(
+                SampleRequester::kTelemetry, Sampler::Sensor::kAir, interval);
+            break;
+          case TelemetrySchedule::kLight:
+            RequestMaxPeriod(SampleRequester::kTelemetry,
+                             Sampler::Sensor::kAmbientLight,
+                             interval);
+            break;
+          case TelemetrySchedule::kProximity:
+            RequestMaxPeriod(SampleRequester::kTelemetry,
+                             Sampler::Sensor::kProximity,
+                             interval);
+            break;
+          case TelemetrySchedule::kBoardTemperature:
+          case TelemetrySchedule::kState:
+            // Read on demand or published on change.
+            break;
+        }
+      });
+  pw::System().rpc_server().RegisterService(telemetry_service);
+}
+
+History& InitHistory() {
+  static History history;
+  history.Init(system::SensorPubSub());
+  static HistoryService history_service;
+  history_service.Init(history);
+  pw::System().rpc_server().RegisterService(history_service);
+  return history;
+}
+
+void InitUplink(History& history) {
+  Radio* radio = system::Radio();
+  if (radio == nullptr) {
+    return;
+  }
+  static Uplink uplink(history, *radio);
+  // Joining the network blocks, so bursts run on the low-priority worker.
+  uplink.Init(system::GetWorker(system::LatencyClass::kBlocking),
+              system::SensorPubSub(),
+              system::Board().UniqueFlashId());
+  pw::metric::global_groups.push_back(uplink.metrics());
+}
+
+// Where each sensor's sampling period is saved, indexed by `Sampler::Sensor`.
+constexpr std::array<ConfigStore::Key, Sampler::kNumSensors> kPeriodKeys = {
+    ConfigStore::Key::kProximityPeriodMs,
+    ConfigStore::Key::kAmbientLightPeriodMs,
+    ConfigStore::Key::kAirPeriodMs,
+};
+
+// Applies the sampling periods last set over RPC.
+void RestoreSamplingPeriods(Sampler& sampler) {
+  for (size_t i = 0; i < Sampler::kNumSensors; ++i) {
+    std::optional<uint32_t> period_ms =
+        system::ConfigStore().Get(kPeriodKeys[i]);
+    if (!period_ms.has_value()) {
+      continue;
+    }
+    const auto sensor = static_cast<Sampler::Sensor>(i);
+    Sampler::Schedule schedule = sampler.GetSchedule(sensor);
+    schedule.period = pw::chrono::SystemClock::for_at_least(
+        std::chrono::milliseconds(*period_ms));
+    sampler.SetSchedule(sensor, schedule);
+  }
+}
+
+void SaveSamplingPeriod(Sampler::Sensor sensor,
+                        const Sampler::Schedule& schedule) {
+  system::ConfigStore().Set(
+      kPeriodKeys[static_cast<size_t>(sensor)],
+      static_cast<uint32_t>(
+          std::chrono::ceil<std::chrono::milliseconds>(schedule.period)
+              .count()));
+}
+
+void InitSampling(const ProximityManager& proximity) {
+  Sampler& sampler = GetSampler();
+  if (proximity.uses_sensor_thresholds()) {
+    // Proximity transitions arrive by interrupt, so it only needs to be
+    // sampled alongside ambient light.
+    Sampler::Schedule schedule =
+        sampler.GetSchedule(Sampler::Sensor::kProximity);
+    schedule.period = {};
+    sampler.SetSchedule(Sampler::Sensor::kProximity, schedule);
+  }
+  // A period chosen over RPC wins over the defaults above.
+  RestoreSamplingPeriods(sampler);
+  if (kIaqModel.has_value()) {
+    // Except for the air sensor with the IAQ model, which counts time in
+    // samples and so is measured on its fixed schedule without backing off.
+    sampler.SetSchedule(Sampler::Sensor::kAir,
+                        {
+                            .period = kIaqModel->sample_interval,
+                            .offset = Sampler::kDefaultAirSchedule.offset,
+                            .max_period = {},
+                        });
+  }
+  sampler.Init(pw::System().dispatcher(),
+               pw::System().allocator(),
+               system::GetWorker(system::LatencyClass::kBlocking));
+  pw::metric::global_groups.push_back(sampler.metrics());
+
+  static SamplingService sampling_service;
+  sampling_service.Init(sampler, SaveSamplingPeriod);
+  pw::System().rpc_server().RegisterService(sampling_service);
+}
+
+void InitMemoryService() {
+  static MemoryService memory_service;
+  memory_service.Init(pw::System().allocator(), system::PubSub());
+  pw::System().rpc_server().RegisterService(memory_service);
+}
+
+void InitCpuUsageService() {
+  CpuCounterSource* source = system::CpuCounterSource();
+  if (source == nullptr) {
+    return;
+  }
+  // Reading every task's stats briefly suspends the scheduler, so it runs on
+  // the low-priority worker.
+  static CpuUsageTracker tracker(*source);
+  tracker.Start(system::GetWorker(system::LatencyClass::kBlocking));
+  static CpuUsageService cpu_usage_service;
+  cpu_usage_service.Init(tracker);
+  pw::System().rpc_server().RegisterService(cpu_usage_service);
+}
+
+void InitEnergyService() {
+  EnergyMeter* meter = system::EnergyMeter();
+  if (meter == nullptr) {
+    return;
+  }
+  // Reads the LED, so it runs alongside the state manager that drives it.
+  meter->Start(system::GetWorker());
+  static EnergyService energy_service;
+  energy_service.Init(*meter);
+  pw::System().rpc_server().RegisterService(energy_service);
+}
+
+void InitProfilingService() {
+#if SENSE_TRACE_ENABLED
+  // Record from boot; the host stops the trace before reading it.
+  PW_TRACE_SET_ENABLED(true);
+  static ProfilingService profiling_service;
+  pw::System().rpc_server().RegisterService(profiling_service);
+#endif  // SENSE_TRACE_ENABLED
+}
+
+void InitConfigStore() {
+  // Loads the saved settings before the modules that apply them start.
+  pw::metric::global_groups.push_back(system::ConfigStore().metrics());
+}
+
+void InitLatencyWatchdog() {
+  using namespace std::chrono_literals;
+  // Button handling and Morse timing run on the interactive worker, so it has
+  // the tightest objective. Blocking work such as flash writes and radio
+  // bursts is expected to hold its queue for a while.
+  static LatencyWatchdog watchdog;
+  PW_CHECK_OK(
+      watchdog.Watch(system::GetWorker(system::LatencyClass::kInteractive),
+                     PW_METRIC_TOKEN("interactive worker"),
+                     20ms));
+  PW_CHECK_OK(watchdog.Watch(
+      system::GetWorker(), PW_METRIC_TOKEN("system worker"), 100ms));
+  PW_CHECK_OK(
+      watchdog.Watch(system::GetWorker(system::LatencyClass::kBlocking),
+                     PW_METRIC_TOKEN("blocking worker"),
+                     5s));
+  pw::metric::global_groups.push_back(watchdog.metrics());
+  // Only feed the hardware watchdog while every worker keeps up, so a wedged
+  // queue resets the device.
+  watchdog.Start([] { system::FeedHardwareWatchdog(); });
+}
+
+void InitMetricService() {
+  // Serves the metric groups registered as global groups, such as the workers'.
+  static pw::metric::MetricService metric_service(pw::metric::global_metrics,
+                                                  pw::metric::global_groups);
+  pw::System().rpc_server().RegisterService(metric_service);
+}
+
 [[noreturn]] void InitializeApp() {
   system::Init();
+  // Hot paths defer their logs to the low-priority worker.
+  DeferredLog::Global().Init(
+      system::GetWorker(system::LatencyClass::kBlocking));
+  system::PubSub().SetStaticSubscribers<ProductionSubscribers>();
+  InitPubSubBridges();
+  InitProfilingService();
+  PW_TRACE_START("Boot", "boot");
+  LogBootPhase("system");
 
+  InitConfigStore();
   InitStateManager();
   InitEventTimers();
   InitBoardService();
   InitMorseEncoder();
-  InitProximitySensor();
+  LogBootPhase("LED");
+  ProximityManager& proximity = InitProximitySensor();
   InitAirSensor();
+  InitUplink(InitHistory());
+  InitTelemetry();
+  InitMetricService();
+  InitMemoryService();
+  InitCpuUsageService();
+  InitEnergyService();
+  LogBootPhase("services");
 
-  pw::thread::DetachedThread(SamplingThreadOptions(), SamplingLoop);
+  // Sensors that are slow to bring up finish in the background, so RPC and
+  // the LED are available as soon as the system starts.
+  InitSampling(proximity);
+  LogBootPhase("sampling");
 
   static PubSubService pubsub_service;
-  pubsub_service.Init(system::PubSub());
+  pubsub_service.Init(system::GetWorker(), system::PubSub());
   pw::System().rpc_server().RegisterService(pubsub_service);
 
   auto& button_manager = system::ButtonManager();
-  button_manager.Init(system::PubSub(), system::GetWorker());
+  button_manager.EnableGestures();
+  button_manager.Init(system::PubSub(),
+                      system::GetWorker(system::LatencyClass::kInteractive));
+  InitLatencyWatchdog();
 
+  PW_TRACE_END("Boot", "boot");
   PW_LOG_INFO("Welcome to Pigweed Sense 🌿☁️");
   system::Start();
 }
@@ -16,8 +16,10 @@
 
 #include "device/bme688.h"
 
+#include <array>
 #include <chrono>
 #include <cstdint>
+#include <utility>
 
 #include "bme68x.h"
 #include "pw_assert/check.h"
@@ -28,83 +30,110 @@
 #include "pw_span/span.h"
 #include "pw_status/try.h"
 #include "pw_thread/sleep.h"
+#include "pw_trace/trace.h"
 
 namespace sense {
 
 static constexpr pw::i2c::Address kAddress =
     pw::i2c::Address::SevenBit<BME68X_I2C_ADDR_HIGH>();
-static constexpr uint16_t kHeaterTemperature = 300;
-static constexpr uint16_t kHeaterDuration = 100;
 static constexpr auto kTimeout =
     pw::chrono::SystemClock::for_at_least(std::chrono::seconds(1));
 
-static int8_t Write(uint8_t reg_address,
-                    const uint8_t* data,
-                    uint32_t length,
-                    void* context) {
-  PW_LOG_INFO("Write(reg_address=0x%02x, data=%p, length=%u, context=%p)",
-              reg_address,
-              static_cast<const void*>(data),
-              length,
-              context);
-  auto i2c_device = static_cast<pw::i2c::RegisterDevice*>(context);
+// Sleeping rounds up to a whole tick, so shorter delays busy-wait instead.
+static constexpr auto kSystemClockTick = pw::chrono::SystemClock::duration(1);
+
+int8_t Bme688::Write(uint8_t reg_address,
+                     const uint8_t* data,
+                     uint32_t length,
+                     void* context) {
+  auto& self = *static_cast<Bme688*>(context);
+  // Reading the clock is not free, so only do it when tracing.
+  pw::chrono::SystemClock::time_point start;
+  if constexpr (Bme688Trace::kEnabled) {
+    start = pw::chrono::SystemClock::now();
+  }
 
   std::array<std::byte, 16> write_buffer;
   pw::span<const uint8_t> bytes(data, length);
-  auto status =
-      i2c_device->WriteRegisters8(reg_address, bytes, write_buffer, kTimeout);
-  PW_LOG_INFO("WriteRegisters8 returned %s", pw_StatusString(status));
+  auto status = self.i2c_device_.WriteRegisters8(
+      reg_address, bytes, write_buffer, kTimeout);
+  self.trace_.Add(
+      Bme688Trace::Kind::kWrite, reg_address, length, status, start);
   return status.ok() ? 0 : 1;
 }
 
-static int8_t Read(uint8_t reg_address,
-                   uint8_t* data,
-                   uint32_t length,
-                   void* context) {
-  PW_LOG_INFO("Read(reg_address=0x%02x, data=%p, length=%u, context=%p)",
-              reg_address,
-              static_cast<const void*>(data),
-              length,
-              context);
-  auto i2c_device = static_cast<pw::i2c::RegisterDevice*>(context);
+int8_t Bme688::Read(uint8_t reg_address,
+                    uint8_t* data,
+                    uint32_t length,
+                    void* context) {
+  auto& self = *static_cast<Bme688*>(context);
+  pw::chrono::SystemClock::time_point start;
+  if constexpr (Bme688Trace::kEnabled) {
+    start = pw::chrono::SystemClock::now();
+  }
 
   pw::span<uint8_t> read_buffer(data, length);
-  auto status = i2c_device->ReadRegisters8(reg_address, read_buffer, kTimeout);
-  PW_LOG_INFO("ReadRegisters8 returned %s", pw_StatusString(status));
+  auto status =
+      self.i2c_device_.ReadRegisters8(reg_address, read_buffer, kTimeout);
+  self.trace_.Add(Bme688Trace::Kind::kRead, reg_address, length, status, start);
   return status.ok() ? 0 : 1;
 }
 
-static void Delay(uint32_t interval_us, void* context) {
-  PW_LOG_INFO("Delay(interval_us=%u, context=%p)", interval_us, context);
-  auto interval = pw::chrono::SystemClock::for_at_least(
-      std::chrono::microseconds(interval_us));
-  pw::this_thread::sleep_for(interval);
+void Bme688::Delay(uint32_t interval_us, void* context) {
+  auto& self = *static_cast<Bme688*>(context);
+  if constexpr (Bme688Trace::kEnabled) {
+    self.trace_.Add(Bme688Trace::Kind::kDelay,
+                    0,
+                    interval_us,
+                    pw::OkStatus(),
+                    pw::chrono::SystemClock::now());
+  }
+  const auto interval = std::chrono::microseconds(interval_us);
+  if (self.busy_wait_ != nullptr && interval < kSystemClockTick) {
+    self.busy_wait_(interval_us);
+    return;
+  }
+  pw::this_thread::sleep_for(pw::chrono::SystemClock::for_at_least(interval));
 }
 
-Bme688::Bme688(pw::i2c::Initiator& initiator, Worker& worker)
+Bme688::Bme688(pw::i2c::Initiator& initiator, Worker& worker, Mode mode)
     : AirSensor(),
+      mode_(mode),
       worker_(worker),
       i2c_device_(initiator,
                   kAddress,
                   pw::endian::native,
                   pw::i2c::RegisterAddressSize::k1Byte),
-      get_data_(pw::bind_member<&Bme688::GetDataCallback>(this)) {}
+      get_data_(pw::bind_member<&Bme688::GetDataCallback>(this)) {
+  PW_CHECK_OK(SetHeaterProfile(kDefaultHeaterProfile));
+}
+
+pw::Status Bme688::SetHeaterProfile(pw::span<const HeaterStep> profile) {
+  if (profile.empty() || profile.size() > kMaxHeaterSteps) {
+    return pw::Status::InvalidArgument();
+  }
+  for (size_t i = 0; i < profile.size(); ++i) {
+    heater_temperatures_[i] = profile[i].temperature_c;
+    heater_multipliers_[i] = profile[i].duration_multiplier;
+  }
+  heater_steps_ = static_cast<uint8_t>(profile.size());
+  InvalidateConfig();
+  return pw::OkStatus();
+}
 
 pw::Status Bme688::DoInit() {
-  bme688_.intf_ptr = &i2c_device_;
+  bme688_.intf_ptr = this;
   bme688_.intf = bme68x_intf::BME68X_I2C_INTF;
   bme688_.read = Read;
   bme688_.write = Write;
   bme688_.delay_us = Delay;
   bme688_.amb_temp = 21;  // Celsius, approximately 70 degrees Fahrenheit.
 
-  PW_LOG_INFO("bme68x_init");
   auto init_status = Check(bme68x_init(&bme688_));
   if (!init_status.ok()) {
     return init_status;
   }
 
-  PW_LOG_INFO("bme68x_get_conf");
   auto get_conf_status = Check(bme68x_get_conf(&config_, &bme688_));
   if (!get_conf_status.ok()) {
     return get_conf_status;
@@ -116,52 +145,142 @@ pw::Status Bme688::DoInit() {
   config_.os_pres = BME68X_OS_1X;
   config_.os_temp = BME68X_OS_2X;
 
-  PW_LOG_INFO("bme68x_set_conf");
-  auto set_conf_status = Check(bme68x_set_conf(&config_, &bme688_));
-  if (!set_conf_status.ok()) {
-    return set_conf_status;
-  }
-
+  // The configuration is written, along with the heater, before the next
+  // measurement.
+  InvalidateConfig();
   return pw::OkStatus();
 }
 
-pw::Status Bme688::DoMeasure(pw::sync::ThreadNotification& notification) {
+pw::Status Bme688::DoMeasure(MeasureCallback&& on_complete) {
   get_data_.Cancel();
+  // A measurement still in progress is replaced by this one.
+  CompleteMeasurement();
   {
     std::lock_guard lock(lock_);
-    if (notification_ != nullptr) {
-      notification_->release();
+    on_complete_ = std::move(on_complete);
+  }
+
+  pw::Status status = ApplyConfig();
+  if (status.ok() && mode_ == Mode::kForced) {
+    // The heater and oversampling registers persist between measurements, so
+    // each one only needs the mode trigger.
+    status = Check(bme68x_set_op_mode(BME68X_FORCED_MODE, &bme688_));
+  }
+  if (!status.ok()) {
+    CompleteMeasurement();
+    return status;
+  }
+
+  AccountHeater();
+  worker_.RunOnce([this]() { get_data_.InvokeAfter(measure_delay_); });
+  return pw::OkStatus();
+}
+
+void Bme688::AccountHeater() {
+  uint32_t on_ms = forced_heater_duration_ms_;
+  if (mode_ == Mode::kParallel) {
+    const auto now = pw::chrono::SystemClock::now();
+    if (heater_since_ == pw::chrono::SystemClock::time_point{}) {
+      heater_since_ = now;
     }
-    notification_ = &notification;
+    on_ms = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                              heater_since_)
+            .count());
+    heater_since_ = now;
   }
+  heater_on_ms_.fetch_add(on_ms, std::memory_order_relaxed);
+}
+
+void Bme688::CompleteMeasurement() {
+  MeasureCallback on_complete;
+  {
+    std::lock_guard lock(lock_);
+    on_complete = std::exchange(on_complete_, nullptr);
+  }
+  if (on_complete != nullptr) {
+    on_complete();
+  }
+}
+
+void Bme688::SetForcedHeater(uint16_t temperature_c, uint16_t duration_ms) {
+  forced_heater_temperature_c_ = temperature_c;
+  forced_heater_duration_ms_ = duration_ms;
+  InvalidateConfig();
+}
+
+pw::Status Bme688::ApplyConfig() {
+  if (!config_dirty_) {
+    return pw::OkStatus();
+  }
+  PW_TRY(Check(bme68x_set_conf(&config_, &bme688_)));
 
   heater_.enable = BME68X_ENABLE;
-  heater_.heatr_temp = kHeaterTemperature;
-  heater_.heatr_dur = kHeaterDuration;
-  PW_TRY(Check(bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heater_, &bme688_)));
-  PW_TRY(Check(bme68x_set_op_mode(BME68X_FORCED_MODE, &bme688_)));
-
-  worker_.RunOnce([this]() {
-    uint32_t delay_us =
-        bme68x_get_meas_dur(BME68X_FORCED_MODE, &config_, &bme688_);
-    delay_us += (heater_.heatr_dur * 1000);
-    auto delay = pw::chrono::SystemClock::for_at_least(
-        std::chrono::microseconds(delay_us));
-    get_data_.InvokeAfter(delay);
-  });
+  uint32_t delay_us = bme68x_get_meas_dur(op_mode(), &config_, &bme688_);
+  if (mode_ == Mode::kParallel) {
+    heater_.heatr_temp_prof = heater_temperatures_.data();
+    heater_.heatr_dur_prof = heater_multipliers_.data();
+    heater_.profile_len = heater_steps_;
+    // Bosch's reference timing: one TPHG cycle every 140 ms.
+    heater_.shared_heatr_dur = static_cast<uint16_t>(140 - delay_us / 1000);
+    PW_TRY(Check(
+        bme68x_set_heatr_conf(BME68X_PARALLEL_MODE, &heater_, &bme688_)));
+    PW_TRY(Check(bme68x_set_op_mode(BME68X_PARALLEL_MODE, &bme688_)));
+    // Wait for the sensor to fill its buffer.
+    delay_us += heater_.shared_heatr_dur * 1000;
+    delay_us *= kMaxFields;
+  } else {
+    heater_.heatr_temp = forced_heater_temperature_c_;
+    heater_.heatr_dur = forced_heater_duration_ms_;
+    PW_TRY(
+        Check(bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heater_, &bme688_)));
+    delay_us += heater_.heatr_dur * 1000;
+  }
+
+  measure_delay_ = pw::chrono::SystemClock::for_at_least(
+      std::chrono::microseconds(delay_us));
+  config_dirty_ = false;
   return pw::OkStatus();
 }
 
 void Bme688::GetDataCallback(pw::chrono::SystemClock::time_point) {
-  bme68x_data data;
-  uint8_t n;
-  if (Check(bme68x_get_data(BME68X_FORCED_MODE, &data, &n, &bme688_)).ok() &&
-      n != 0) {
-    Update(data.temperature, data.pressure, data.humidity, data.gas_resistance);
-  }
-  std::lock_guard lock(lock_);
-  notification_->release();
-  notification_ = nullptr;
+  PW_TRACE_SCOPE("Bme688::GetDataCallback", "air");
+  std::array<bme68x_data, kMaxFields> data;
+  uint8_t n = 0;
+  if (Check(bme68x_get_data(op_mode(), data.data(), &n, &bme688_)).ok()) {
+    // Fields are averaged into one update, so that each measurement weighs
+    // the same in the score's statistics whatever the mode.
+    float temperature = 0.f;
+    float pressure = 0.f;
+    float humidity = 0.f;
+    float gas_resistance = 0.f;
+    uint8_t used = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+      const bme68x_data& field = data[i];
+      if (mode_ == Mode::kParallel) {
+        // Skip fields whose heater had not stabilized, or that were taken at
+        // a different temperature from the one scores are comparable at.
+        constexpr uint8_t kValid = BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK;
+        if ((field.status & kValid) != kValid ||
+            field.gas_index >= heater_steps_ ||
+            heater_temperatures_[field.gas_index] != heater_temperatures_[0]) {
+          continue;
+        }
+      }
+      temperature += field.temperature;
+      pressure += field.pressure;
+      humidity += field.humidity;
+      gas_resistance += field.gas_resistance;
+      ++used;
+    }
+    if (used != 0) {
+      Update(temperature / used,
+             pressure / used,
+             humidity / used,
+             gas_resistance / used);
+    }
+  }
+  CompleteMeasurement();
 }
 
 pw::Status Bme688::Check(int8_t result) {
@@ -13,25 +13,133 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 #include "bme68x_defs.h"
+#include "device/bme688_trace.h"
 #include "modules/air_sensor/air_sensor.h"
 #include "modules/worker/worker.h"
 #include "pw_chrono/system_clock.h"
 #include "pw_chrono/system_timer.h"
 #include "pw_i2c/initiator.h"
 #include "pw_i2c/register_device.h"
+#include "pw_span/span.h"
 #include "pw_status/status.h"
 
 namespace sense {
 
 class Bme688 : public AirSensor {
  public:
-  explicit Bme688(pw::i2c::Initiator& initiator, Worker& worker);
+  enum class Mode {
+    /// Each measurement is triggered individually with one heater step.
+    kForced,
+
+    /// The sensor measures continuously, cycling through a heater profile,
+    /// and each measurement reads every field it has buffered and scores
+    /// their mean. The heater stays on, so this draws far more power.
+    kParallel,
+  };
+
+  /// One step of the heater profile used in parallel mode.
+  struct HeaterStep {
+    uint16_t temperature_c;
+
+    /// Time to heat for, in multiples of the shared heater duration.
+    uint8_t duration_multiplier;
+  };
+
+  /// Most steps the sensor supports in a heater profile.
+  static constexpr size_t kMaxHeaterSteps = 10;
+
+  /// Steps at the forced mode default of 300 C, so that every reading is
+  /// comparable when scoring.
+  static constexpr std::array<HeaterStep, 4> kDefaultHeaterProfile = {{
+      {.temperature_c = 300, .duration_multiplier = 5},
+      {.temperature_c = 300, .duration_multiplier = 5},
+      {.temperature_c = 300, .duration_multiplier = 5},
+      {.temperature_c = 300, .duration_multiplier = 5},
+  }};
+
+  explicit Bme688(pw::i2c::Initiator& initiator,
+                  Worker& worker,
+                  Mode mode = Mode::kForced);
+
+  /// Replaces the parallel mode heater profile. Only readings taken at the
+  /// first step's temperature are scored, since gas resistance depends on
+  /// the heater temperature. Takes effect at the next measurement.
+  ///
+  /// @returns
+  /// * @OK - The profile was replaced.
+  /// * @INVALID_ARGUMENT - The profile is empty or has more than
+  ///   `kMaxHeaterSteps` steps.
+  pw::Status SetHeaterProfile(pw::span<const HeaterStep> profile);
+
+  /// Sets the forced mode heater step. Takes effect at the next measurement.
+  void SetForcedHeater(uint16_t temperature_c, uint16_t duration_ms);
+
+  /// Forces the configuration and heater to be rewritten, and the measurement
+  /// duration recomputed, before the next measurement. Use this if the
+  /// sensor may have been reset.
+  void InvalidateConfig() { config_dirty_ = true; }
+
+  /// Busy-waits for at least the given number of microseconds.
+  using BusyWaitFunction = void (*)(uint32_t microseconds);
+
+  /// Sets a microsecond-resolution busy wait, such as one backed by a
+  /// hardware timer. The vendor API's delays that are shorter than a system
+  /// clock tick use it rather than sleeping for a whole tick; longer delays
+  /// always sleep, so other threads run meanwhile.
+  void SetBusyWait(BusyWaitFunction busy_wait) { busy_wait_ = busy_wait; }
+
+  /// Logs the driver's recent bus transfers. Does nothing unless
+  /// `SENSE_BME688_TRACE_CAPACITY` is set.
+  void DumpTrace() const { trace_.Dump(); }
+
+  /// Returns roughly how long the heater has been on, for energy accounting.
+  /// Parallel mode cycles the heater continuously, so counts all the time
+  /// since the first measurement. Wraps after about 49 days.
+  uint32_t heater_on_ms() const {
+    return heater_on_ms_.load(std::memory_order_relaxed);
+  }
 
  private:
+  static constexpr uint16_t kDefaultHeaterTemperature = 300;
+  static constexpr uint16_t kDefaultHeaterDuration = 100;
+
+  /// Fields the sensor buffers in parallel mode.
+  static constexpr size_t kMaxFields = 3;
+
+  // Bus callbacks for the vendor API. `context` is the `Bme688`.
+  static int8_t Write(uint8_t reg_address,
+                      const uint8_t* data,
+                      uint32_t length,
+                      void* context);
+  static int8_t Read(uint8_t reg_address,
+                     uint8_t* data,
+                     uint32_t length,
+                     void* context);
+  static void Delay(uint32_t interval_us, void* context);
+
+  /// Writes the configuration and heater if they have changed, and caches how
+  /// long a measurement takes with them.
+  pw::Status ApplyConfig();
+
+  /// Adds the heater time of a measurement just triggered.
+  void AccountHeater();
+
+  uint8_t op_mode() const {
+    return mode_ == Mode::kParallel ? BME68X_PARALLEL_MODE : BME68X_FORCED_MODE;
+  }
+
   pw::Status DoInit() override;
 
-  pw::Status DoMeasure(pw::sync::ThreadNotification& notification) override;
+  pw::Status DoMeasure(MeasureCallback&& on_complete) override;
+
+  /// Reports that the current measurement, if any, is over.
+  void CompleteMeasurement() PW_LOCKS_EXCLUDED(lock_);
 
   void GetDataCallback(pw::chrono::SystemClock::time_point);
 
@@ -40,11 +148,23 @@ class Bme688 : public AirSensor {
   bme68x_dev bme688_;
   bme68x_conf config_;
   bme68x_heatr_conf heater_;
+  const Mode mode_;
+  std::array<uint16_t, kMaxHeaterSteps> heater_temperatures_;
+  std::array<uint16_t, kMaxHeaterSteps> heater_multipliers_;
+  uint8_t heater_steps_ = 0;
+  uint16_t forced_heater_temperature_c_ = kDefaultHeaterTemperature;
+  uint16_t forced_heater_duration_ms_ = kDefaultHeaterDuration;
+  bool config_dirty_ = true;
+  pw::chrono::SystemClock::duration measure_delay_{};
+  pw::chrono::SystemClock::time_point heater_since_;
+  std::atomic<uint32_t> heater_on_ms_ = 0;
   Worker& worker_;
   pw::i2c::RegisterDevice i2c_device_;
+  Bme688Trace trace_;
+  BusyWaitFunction busy_wait_ = nullptr;
   pw::chrono::SystemTimer get_data_;
   pw::sync::InterruptSpinLock lock_;
-  pw::sync::ThreadNotification* notification_ PW_GUARDED_BY(lock_) = nullptr;
+  MeasureCallback on_complete_ PW_GUARDED_BY(lock_);
 };
 
 }  // namespace sense
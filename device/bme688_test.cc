@@ -0,0 +1,113 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/bme688.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "bme68x_defs.h"
+#include "modules/i2c/register_fake.h"
+#include "modules/worker/test_worker.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+using Traffic = I2cRegisterFake::Traffic;
+
+constexpr pw::i2c::Address kAddress =
+    pw::i2c::Address::SevenBit<BME68X_I2C_ADDR_HIGH>();
+
+// Bus budgets for forced mode. A steady-state measurement should only trigger
+// the sensor and read back one field; rewriting the configuration or heater
+// every time would show up here.
+constexpr uint32_t kInitTransactions = 7;
+constexpr uint32_t kConfigureTransactions = 8;
+constexpr uint32_t kMeasureTransactions = 6;
+constexpr auto kMeasureBusTime = 1ms;
+
+class Bme688Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(
+        bus_.AddDevice(kAddress, I2cRegisterFake::WriteMode::kAddressDataPairs),
+        pw::OkStatus());
+    bus_.SetRegister(kAddress, BME68X_REG_CHIP_ID, BME68X_CHIP_ID);
+    // Every field reports new data.
+    bus_.SetRegister(kAddress, BME68X_REG_FIELD0, BME68X_NEW_DATA_MSK);
+  }
+
+  void TearDown() override { worker_.Stop(); }
+
+  // The sensor returns to sleep once a forced measurement completes.
+  void FinishForcedMeasurement() {
+    const uint8_t ctrl_meas = bus_.GetRegister(kAddress, BME68X_REG_CTRL_MEAS);
+    bus_.SetRegister(kAddress,
+                     BME68X_REG_CTRL_MEAS,
+                     static_cast<uint8_t>(ctrl_meas & ~BME68X_MODE_MSK));
+  }
+
+  Traffic Measure() {
+    EXPECT_EQ(sensor_.MeasureSync().status(), pw::OkStatus());
+    FinishForcedMeasurement();
+    return bus_.TakeTraffic();
+  }
+
+  TestWorker<> worker_;
+  I2cRegisterFake bus_;
+  Bme688 sensor_{bus_, worker_};
+};
+
+TEST_F(Bme688Test, InitWithinBudget) {
+  ASSERT_EQ(sensor_.Init(), pw::OkStatus());
+  EXPECT_LE(bus_.TakeTraffic().transactions, kInitTransactions);
+}
+
+TEST_F(Bme688Test, OnlyFirstMeasurementConfigures) {
+  ASSERT_EQ(sensor_.Init(), pw::OkStatus());
+  bus_.TakeTraffic();
+
+  EXPECT_LE(Measure().transactions,
+            kConfigureTransactions + kMeasureTransactions);
+  for (int i = 0; i < 3; ++i) {
+    const Traffic traffic = Measure();
+    EXPECT_LE(traffic.transactions, kMeasureTransactions);
+    EXPECT_LE(traffic.bus_time, kMeasureBusTime);
+  }
+}
+
+TEST_F(Bme688Test, HeaterChangeConfiguresOnce) {
+  ASSERT_EQ(sensor_.Init(), pw::OkStatus());
+  Measure();
+
+  sensor_.SetForcedHeater(320, 150);
+  EXPECT_LE(Measure().transactions,
+            kConfigureTransactions + kMeasureTransactions);
+  EXPECT_LE(Measure().transactions, kMeasureTransactions);
+}
+
+TEST_F(Bme688Test, CountsForcedHeaterTime) {
+  ASSERT_EQ(sensor_.Init(), pw::OkStatus());
+  EXPECT_EQ(sensor_.heater_on_ms(), 0u);
+
+  sensor_.SetForcedHeater(320, 150);
+  Measure();
+  Measure();
+  EXPECT_EQ(sensor_.heater_on_ms(), 300u);
+}
+
+}  // namespace
+}  // namespace sense
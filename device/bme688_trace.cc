@@ -0,0 +1,90 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "BME688"
+
+#include "device/bme688_trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "pw_log/log.h"
+
+namespace sense {
+#if SENSE_BME688_TRACE_CAPACITY > 0
+namespace {
+
+uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration) {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+const char* KindName(Bme688Trace::Kind kind) {
+  switch (kind) {
+    case Bme688Trace::Kind::kRead:
+      return "read";
+    case Bme688Trace::Kind::kWrite:
+      return "write";
+    case Bme688Trace::Kind::kDelay:
+      return "delay";
+  }
+  return "?";
+}
+
+}  // namespace
+#endif  // SENSE_BME688_TRACE_CAPACITY > 0
+
+void Bme688Trace::AddRecord(Kind kind,
+                            uint8_t register_address,
+                            uint32_t length,
+                            pw::Status status,
+                            pw::chrono::SystemClock::time_point start) {
+#if SENSE_BME688_TRACE_CAPACITY > 0
+  const auto elapsed = pw::chrono::SystemClock::now() - start;
+  records_[total_ % kCapacity] = {
+      .timestamp_us = ToMicroseconds(start.time_since_epoch()),
+      .duration_us = kind == Kind::kDelay ? length : ToMicroseconds(elapsed),
+      .kind = kind,
+      .register_address = register_address,
+      .length = static_cast<uint8_t>(
+          kind == Kind::kDelay ? 0 : std::min<uint32_t>(length, UINT8_MAX)),
+      .status = static_cast<uint8_t>(status.code()),
+  };
+  ++total_;
+#else
+  static_cast<void>(kind);
+  static_cast<void>(register_address);
+  static_cast<void>(length);
+  static_cast<void>(status);
+  static_cast<void>(start);
+#endif  // SENSE_BME688_TRACE_CAPACITY > 0
+}
+
+void Bme688Trace::Dump() const {
+#if SENSE_BME688_TRACE_CAPACITY > 0
+  const uint32_t oldest = total_ > kCapacity ? total_ - kCapacity : 0;
+  for (uint32_t i = oldest; i < total_; ++i) {
+    const Record& record = records_[i % kCapacity];
+    PW_LOG_INFO("%10u us %-5s reg=0x%02x len=%2u %s (%u us)",
+                static_cast<unsigned>(record.timestamp_us),
+                KindName(record.kind),
+                record.register_address,
+                record.length,
+                pw::Status(static_cast<pw_Status>(record.status)).str(),
+                static_cast<unsigned>(record.duration_us));
+  }
+#endif  // SENSE_BME688_TRACE_CAPACITY > 0
+}
+
+}  // namespace sense
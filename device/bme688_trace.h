@@ -0,0 +1,85 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_status/status.h"
+
+/// Number of BME688 bus transfers kept for debugging. The default of 0
+/// compiles tracing out entirely; set it to trace the driver without changing
+/// code.
+#ifndef SENSE_BME688_TRACE_CAPACITY
+#define SENSE_BME688_TRACE_CAPACITY 0
+#endif  // SENSE_BME688_TRACE_CAPACITY
+
+namespace sense {
+
+/// Ring of compact records describing the BME688 driver's bus traffic.
+///
+/// The vendor API calls the driver's callbacks from a single thread at a
+/// time, so recording takes no lock.
+class Bme688Trace {
+ public:
+  static constexpr size_t kCapacity = SENSE_BME688_TRACE_CAPACITY;
+  static constexpr bool kEnabled = kCapacity > 0;
+
+  enum class Kind : uint8_t {
+    kRead,
+    kWrite,
+    kDelay,
+  };
+
+  struct Record {
+    /// Low 32 bits of the system clock, in microseconds.
+    uint32_t timestamp_us;
+    /// Transfer time, or the requested delay.
+    uint32_t duration_us;
+    Kind kind;
+    uint8_t register_address;
+    uint8_t length;
+    /// `pw_Status` code of the transfer.
+    uint8_t status;
+  };
+  static_assert(sizeof(Record) == 12);
+
+  /// Records a transfer that started at `start`.
+  void Add(Kind kind,
+           uint8_t register_address,
+           uint32_t length,
+           pw::Status status,
+           pw::chrono::SystemClock::time_point start) {
+    if constexpr (kEnabled) {
+      AddRecord(kind, register_address, length, status, start);
+    }
+  }
+
+  /// Logs every record in the ring, oldest first.
+  void Dump() const;
+
+ private:
+  void AddRecord(Kind kind,
+                 uint8_t register_address,
+                 uint32_t length,
+                 pw::Status status,
+                 pw::chrono::SystemClock::time_point start);
+
+  std::array<Record, kCapacity> records_;
+  uint32_t total_ = 0;
+};
+
+}  // namespace sense
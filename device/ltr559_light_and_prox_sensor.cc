@@ -17,6 +17,9 @@
 
 #include "device/ltr559_light_and_prox_sensor.h"
 
+#include <algorithm>
+#include <array>
+
 #include "pw_log/log.h"
 
 namespace sense {
@@ -29,6 +32,19 @@ constexpr int kChannel1Constants[] = {-11059, 19548, -1185, 0};
 
 }  // namespace
 
+constexpr std::array<Ltr559LightAndProxSensor::AlsRange, 9>
+    Ltr559LightAndProxSensor::kAlsRanges = {
+        MakeAlsRange(1, 50),
+        MakeAlsRange(1, 100),
+        MakeAlsRange(2, 100),
+        MakeAlsRange(4, 100),
+        MakeAlsRange(8, 100),
+        MakeAlsRange(48, 100),
+        MakeAlsRange(96, 100),
+        MakeAlsRange(96, 200),
+        MakeAlsRange(96, 400),
+};
+
 Ltr559LightAndProxSensor::Ltr559LightAndProxSensor(
     pw::i2c::Initiator& i2c_initiator,
     pw::chrono::SystemClock::duration timeout)
@@ -42,16 +58,53 @@ Ltr559LightAndProxSensor::Ltr559LightAndProxSensor(
 
 pw::Result<uint16_t> Ltr559LightAndProxSensor::ReadProximitySample() {
   // 11-bit samples in PS_DATA_0 (0x8D) and PS_DATA_1 (0x8E), little-endian.
-  static constexpr uint8_t kPsData0 = 0x8D;
-  PW_TRY_ASSIGN(uint16_t sample, device_.ReadRegister16(kPsData0, timeout_));
-  return sample & 0x3FFu;  // mask to the 11-bit sample
+  PW_TRY_ASSIGN(uint16_t sample,
+                device_.ReadRegister16(kPsDataAddress, timeout_));
+  return ProximityFromData(sample);
 }
 
 pw::Result<float> Ltr559LightAndProxSensor::ReadLightSampleLux() {
-  uint16_t channels_1_0_samples[2] = {};
-  const auto& [channel_1, channel_0] = channels_1_0_samples;
-  PW_TRY(device_.ReadRegisters16(
-      kAlsDataCh1Address, channels_1_0_samples, timeout_));
+  // Both channels and the status, which reports whether the data is new.
+  std::array<uint8_t, kAlsDataSize> data;
+  PW_TRY(device_.ReadRegisters8(kAlsDataCh1Address, data, timeout_));
+  return ProcessAls(static_cast<uint16_t>(data[0] | (data[1] << 8)),
+                    static_cast<uint16_t>(data[2] | (data[3] << 8)),
+                    data[4]);
+}
+
+pw::Result<Ltr559LightAndProxSensor::Samples>
+Ltr559LightAndProxSensor::ReadAllSamples() {
+  // The register address auto-increments, so a single read covers both
+  // ambient light channels, the status register and the proximity data.
+  std::array<uint8_t, kAllDataSize> data;
+  PW_TRY(device_.ReadRegisters8(kAlsDataCh1Address, data, timeout_));
+  auto read16 = [&data](uint8_t address) {
+    const size_t offset = address - kAlsDataCh1Address;
+    return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+  };
+  return Samples{
+      .light_lux = ProcessAls(read16(kAlsDataCh1Address),
+                              read16(kAlsDataCh1Address + 2),
+                              data[kStatusAddress - kAlsDataCh1Address]),
+      .proximity = ProximityFromData(read16(kPsDataAddress)),
+  };
+}
+
+pw::Status Ltr559LightAndProxSensor::ApplyAlsRange() {
+  const AlsRange& range = kAlsRanges[als_range_];
+  PW_TRY(device_.WriteRegister(kAlsMeasRateAddress, range.meas_rate, timeout_));
+  return device_.WriteRegister(kAlsContrAddress, range.contr, timeout_);
+}
+
+float Ltr559LightAndProxSensor::ProcessAls(uint16_t channel_1,
+                                           uint16_t channel_0,
+                                           uint8_t status) {
+  if (als_settling_samples_ != 0) {
+    if ((status & kAlsNewDataBit) != 0) {
+      --als_settling_samples_;
+    }
+    return last_lux_;
+  }
 
   // Calculate the lux from the two channels based on a formula from the
   // manufacturer.
@@ -59,13 +112,54 @@ pw::Result<float> Ltr559LightAndProxSensor::ReadLightSampleLux() {
                         ? 101
                         : (channel_1 * 100 / (channel_1 + channel_0));
   const int index = ratio < 45 ? 0 : ratio < 64 ? 1 : ratio < 85 ? 2 : 3;
+  // Near saturation the products no longer fit in an int.
+  last_lux_ =
+      static_cast<float>(int64_t{channel_0} * kChannel0Constants[index] -
+                         int64_t{channel_1} * kChannel1Constants[index]) *
+      kAlsRanges[als_range_].lux_scale;
 
-  float lux = channel_0 * kChannel0Constants[index] -
-              channel_1 * kChannel1Constants[index];
-  lux /= (kDefaultIntegrationTimeMillis / 100);
-  lux /= kDefaultGain;
-  lux /= 10000;
-  return lux;
+  const uint16_t counts = std::max(channel_0, channel_1);
+  size_t range = als_range_;
+  if (counts > kAlsHighCounts && range > 0) {
+    --range;
+  } else if (counts < kAlsLowCounts && range + 1 < kAlsRanges.size()) {
+    ++range;
+  }
+  if (range != als_range_) {
+    als_range_ = range;
+    if (pw::Status status = ApplyAlsRange(); status.ok()) {
+      als_settling_samples_ = 1;
+    } else {
+      PW_LOG_WARN("Failed to change ALS range: %s", status.str());
+    }
+  }
+  return last_lux_;
+}
+
+pw::Status Ltr559LightAndProxSensor::SetProximityThresholds(uint16_t low,
+                                                          uint16_t high) {
+  // The register address followed by PS_THRES_UP_0, PS_THRES_UP_1,
+  // PS_THRES_LOW_0 and PS_THRES_LOW_1, written in one auto-incrementing burst.
+  const std::array<std::byte, 5> command = {
+      std::byte{kPsThresholdAddress},
+      std::byte(high & 0xFF),
+      std::byte(high >> 8),
+      std::byte(low & 0xFF),
+      std::byte(low >> 8),
+  };
+  return device_.WriteFor(command, timeout_);
+}
+
+pw::Status Ltr559LightAndProxSensor::EnableProximityInterrupt() {
+  // Assert after two consecutive samples outside the window to reject noise.
+  PW_TRY(device_.WriteRegister(
+      kInterruptPersistAddress, std::byte{0x10}, timeout_));
+  // PS measurement can trigger interrupt, active low.
+  return device_.WriteRegister(kInterruptAddress, std::byte{0x01}, timeout_);
+}
+
+pw::Status Ltr559LightAndProxSensor::ClearInterrupt() {
+  return device_.ReadRegister(kStatusAddress, timeout_).status();
 }
 
 pw::Result<Ltr559LightAndProxSensor::Info> Ltr559LightAndProxSensor::ReadIds() {
@@ -75,13 +169,120 @@ pw::Result<Ltr559LightAndProxSensor::Info> Ltr559LightAndProxSensor::ReadIds() {
 }
 
 pw::Result<uint16_t> Ltr559ProxAndLightSensorImpl::DoReadProxSample() {
-  // Readings are 11-bit unsigned integers. Scale them to 16 bits.
   PW_TRY_ASSIGN(uint16_t raw_sample, sensor_.ReadProximitySample());
   PW_LOG_DEBUG("LTR-559 sample: %4hu (0x%4hx), scaled: %5u",
                raw_sample,
                raw_sample,
-               (raw_sample << 5));
-  return raw_sample << 5;
+               ScaleProximity(raw_sample));
+  return ScaleProximity(raw_sample);
+}
+
+pw::Result<LightAndProximitySensor::Samples>
+Ltr559ProxAndLightSensorImpl::DoReadLightAndProxSamples() {
+  PW_TRY_ASSIGN(Ltr559LightAndProxSensor::Samples samples,
+                sensor_.ReadAllSamples());
+  return Samples{
+      .light_lux = samples.light_lux,
+      .proximity = ScaleProximity(samples.proximity),
+  };
+}
+
+pw::Status Ltr559ProxAndLightSensorImpl::DoEnableThresholdDetection(
+    uint16_t inactive_threshold,
+    uint16_t active_threshold,
+    ThresholdCallback&& callback) {
+  if (interrupt_ == nullptr) {
+    return pw::Status::Unimplemented();
+  }
+  PW_TRY(interrupt_->DisableInterruptHandler());
+  inactive_threshold_ = inactive_threshold;
+  active_threshold_ = active_threshold;
+  callback_ = std::move(callback);
+  near_.store(false, std::memory_order_relaxed);
+  interrupt_configured_ = false;
+
+  // Start out far, waiting for samples to rise above the active threshold.
+  // This may be called before the scheduler starts, so the chip is
+  // programmed from the worker.
+  rearm_work_.Post(*worker_);
+  PW_TRY(interrupt_->Enable());
+  PW_TRY(interrupt_->SetInterruptHandler(
+      pw::digital_io::InterruptTrigger::kActivatingEdge,
+      [this](pw::digital_io::State) { HandleInterrupt(); }));
+  return interrupt_->EnableInterruptHandler();
+}
+
+pw::Status Ltr559ProxAndLightSensorImpl::DoSetThresholds(
+    uint16_t inactive_threshold, uint16_t active_threshold) {
+  if (interrupt_ == nullptr) {
+    return pw::Status::Unimplemented();
+  }
+  if (callback_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+  inactive_threshold_.store(inactive_threshold, std::memory_order_relaxed);
+  active_threshold_.store(active_threshold, std::memory_order_relaxed);
+  // Reprogram the window for the current state, which the rearm first
+  // checks against the latest sample under the new thresholds.
+  rearm_work_.Post(*worker_);
+  return pw::OkStatus();
+}
+
+pw::Status Ltr559ProxAndLightSensorImpl::DoDisableThresholdDetection() {
+  if (interrupt_ == nullptr) {
+    return pw::Status::Unimplemented();
+  }
+  PW_TRY(interrupt_->DisableInterruptHandler());
+  PW_TRY(interrupt_->ClearInterruptHandler());
+  return sensor_.DisableInterrupts();
+}
+
+void Ltr559ProxAndLightSensorImpl::HandleInterrupt() {
+  // The I2C work to find out which way the sample moved is deferred.
+  rearm_work_.Post(*worker_);
+}
+
+void Ltr559ProxAndLightSensorImpl::UpdateState(uint16_t sample) {
+  const bool near = near_.load(std::memory_order_relaxed);
+  const bool now_near =
+      near ? sample > inactive_threshold_.load(std::memory_order_relaxed)
+           : sample >= active_threshold_.load(std::memory_order_relaxed);
+  if (now_near != near) {
+    near_.store(now_near, std::memory_order_relaxed);
+    callback_(now_near);
+  }
+}
+
+void Ltr559ProxAndLightSensorImpl::RearmThresholds() {
+  // Decide from the latest sample rather than flipping the state on each
+  // assertion. A spurious edge then changes nothing, and neither does INT
+  // being released early by the status read in `ReadAllSamples`.
+  if (pw::Result<uint16_t> sample = sensor_.ReadProximitySample();
+      sample.ok()) {
+    UpdateState(ScaleProximity(*sample));
+  } else {
+    PW_LOG_WARN("Failed to read proximity sample: %s",
+                sample.status().str());
+  }
+
+  pw::Status status =
+      near_.load(std::memory_order_relaxed)
+          ? sensor_.SetProximityThresholds(
+                inactive_threshold_.load(std::memory_order_relaxed) >> 5, 0x7FF)
+          : sensor_.SetProximityThresholds(
+                0, active_threshold_.load(std::memory_order_relaxed) >> 5);
+  if (status.ok() && !interrupt_configured_) {
+    status = sensor_.EnableProximityInterrupt();
+    interrupt_configured_ = status.ok();
+  }
+  // Releasing INT after the new window is set means a sample that has already
+  // crossed back asserts it again instead of being missed.
+  if (status.ok()) {
+    status = sensor_.ClearInterrupt();
+  }
+  if (!status.ok()) {
+    PW_LOG_WARN("Failed to rearm proximity thresholds: %s", status.str());
+  }
 }
 
 }  // namespace sense
@@ -13,12 +13,20 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <utility>
 
 #include "modules/light/sensor.h"
+#include "modules/light_and_proximity/sensor.h"
 #include "modules/proximity/sensor.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
 #include "pw_chrono/system_clock.h"
+#include "pw_digital_io/digital_io.h"
 #include "pw_i2c/address.h"
 #include "pw_i2c/initiator.h"
 #include "pw_i2c/register_device.h"
@@ -41,10 +49,9 @@ class Ltr559LightAndProxSensor {
                            pw::chrono::SystemClock::duration timeout =
                                std::chrono::milliseconds(100));
 
-  /// Enables the ambient light sensor.
-  pw::Status EnableLight() {
-    return device_.WriteRegister(kAlsContrAddress, std::byte{0x01}, timeout_);
-  }
+  /// Enables the ambient light sensor. Its gain and integration time are
+  /// adjusted automatically to suit the light level.
+  pw::Status EnableLight() { return ApplyAlsRange(); }
 
   pw::Status DisableLight() {
     return device_.WriteRegister(kAlsContrAddress, std::byte{0}, timeout_);
@@ -70,9 +77,107 @@ class Ltr559LightAndProxSensor {
 
   pw::Result<float> ReadLightSampleLux();
 
+  struct Samples {
+    float light_lux;
+    uint16_t proximity;
+  };
+
+  /// Reads ALS_DATA through PS_DATA in one burst. The proximity sample is
+  /// unscaled, as from `ReadProximitySample`. Like `ReadLightSampleLux`, this
+  /// reads ALS_PS_STATUS and so releases the INT pin.
+  pw::Result<Samples> ReadAllSamples();
+
+  /// Sets the window of unscaled proximity samples outside of which the INT
+  /// pin is asserted.
+  pw::Status SetProximityThresholds(uint16_t low, uint16_t high);
+
+  /// Asserts the active-low INT pin while proximity samples are outside the
+  /// threshold window.
+  pw::Status EnableProximityInterrupt();
+
+  pw::Status DisableInterrupts() {
+    return device_.WriteRegister(kInterruptAddress, std::byte{0}, timeout_);
+  }
+
+  /// Reads the status register, which releases the INT pin.
+  pw::Status ClearInterrupt();
+
+  /// Returns the current ALS gain and integration time in milliseconds.
+  uint8_t als_gain() const { return kAlsRanges[als_range_].gain; }
+  uint16_t als_integration_time_ms() const {
+    return kAlsRanges[als_range_].integration_time_ms;
+  }
+
  private:
+  /// An ALS gain and integration time, with the factor that converts the
+  /// manufacturer's lux formula to lux for that combination.
+  struct AlsRange {
+    uint8_t gain;
+    uint16_t integration_time_ms;
+    std::byte contr;
+    std::byte meas_rate;
+    float lux_scale;
+  };
+
+  static constexpr AlsRange MakeAlsRange(uint8_t gain,
+                                         uint16_t integration_time_ms) {
+    // ALS_CONTR gain field, bits 4:2, with the active-mode bit set.
+    const uint8_t gain_bits = gain == 1    ? 0b000
+                              : gain == 2  ? 0b001
+                              : gain == 4  ? 0b010
+                              : gain == 8  ? 0b011
+                              : gain == 48 ? 0b110
+                                           : 0b111;
+    // ALS_MEAS_RATE integration time field, bits 5:3.
+    const uint8_t time_bits = integration_time_ms == 50    ? 0b001
+                              : integration_time_ms == 100 ? 0b000
+                              : integration_time_ms == 200 ? 0b010
+                                                           : 0b011;
+    // ALS_MEAS_RATE repeat rate field, bits 2:0. The rate must not be shorter
+    // than the integration time.
+    const uint8_t rate_bits = integration_time_ms <= 50    ? 0b000
+                              : integration_time_ms <= 100 ? 0b001
+                              : integration_time_ms <= 200 ? 0b010
+                                                           : 0b011;
+    return {
+        .gain = gain,
+        .integration_time_ms = integration_time_ms,
+        .contr = std::byte(gain_bits << 2 | 0x01),
+        .meas_rate = std::byte(time_bits << 3 | rate_bits),
+        .lux_scale = 1.f / (integration_time_ms / 100.f * gain * 10000.f),
+    };
+  }
+
+  /// Ranges in order of increasing sensitivity. Gain is raised before
+  /// integration time, so the sensor integrates for as short a time as the
+  /// light level allows.
+  ///
+  /// Defined out of line, since `MakeAlsRange` cannot be evaluated until the
+  /// class is complete.
+  static const std::array<AlsRange, 9> kAlsRanges;
+  static constexpr size_t kDefaultAlsRange = 1;
+
+  /// Channel counts above which the range steps down, before the ADC
+  /// saturates.
+  static constexpr uint16_t kAlsHighCounts = 50000;
+
+  /// Channel counts below which the range steps up. The largest step in
+  /// sensitivity is 6x, so stepping up cannot push a reading above
+  /// `kAlsHighCounts`.
+  static constexpr uint16_t kAlsLowCounts = 4000;
+
+  static_assert(kAlsLowCounts * 6 < kAlsHighCounts);
+
+  /// Writes the current range to ALS_MEAS_RATE and ALS_CONTR.
+  pw::Status ApplyAlsRange();
+
+  /// Converts the two ambient light channels to lux and adjusts the range for
+  /// the next reading.
+  float ProcessAls(uint16_t channel_1, uint16_t channel_0, uint8_t status);
+
   static constexpr uint8_t kAlsContrAddress = 0x80;
   static constexpr uint8_t kPsContrAddress = 0x81;
+  static constexpr uint8_t kAlsMeasRateAddress = 0x85;
 
   // 0x86: PART_ID
   // 0x87: MANUFAC_ID
@@ -82,22 +187,61 @@ class Ltr559LightAndProxSensor {
   // 0x8A-8B: ALS_DATA_CH0
   static constexpr uint8_t kAlsDataCh1Address = 0x88;
 
-  static constexpr int kDefaultIntegrationTimeMillis = 100;
-  static constexpr int kDefaultGain = 1;
+  // 0x8C: ALS_PS_STATUS
+  // 0x8D-8E: PS_DATA
+  static constexpr uint8_t kPsDataAddress = 0x8D;
+
+  static constexpr uint8_t kInterruptAddress = 0x8F;
+  static constexpr uint8_t kStatusAddress = 0x8C;
+  static constexpr uint8_t kAlsNewDataBit = 0x04;
+
+  // 0x90-91: PS_THRES_UP
+  // 0x92-93: PS_THRES_LOW
+  static constexpr uint8_t kPsThresholdAddress = 0x90;
+  static constexpr uint8_t kInterruptPersistAddress = 0x9E;
+
+  // ALS_DATA_CH1 through PS_DATA_1.
+  static constexpr size_t kAllDataSize =
+      kPsDataAddress + 2 - kAlsDataCh1Address;
+
+  // ALS_DATA_CH1 through ALS_PS_STATUS.
+  static constexpr size_t kAlsDataSize =
+      kStatusAddress + 1 - kAlsDataCh1Address;
+
+  // Masks the proximity data registers to the 11-bit sample.
+  static constexpr uint16_t ProximityFromData(uint16_t data) {
+    return data & 0x3FFu;
+  }
 
   pw::i2c::Initiator& i2c_initiator_;
   pw::i2c::RegisterDevice device_;
   pw::chrono::SystemClock::duration timeout_;
+
+  size_t als_range_ = kDefaultAlsRange;
+  // New samples to discard after a range change, since the measurement in
+  // progress may have used either range.
+  uint8_t als_settling_samples_ = 0;
+  float last_lux_ = 0.f;
 };
 
 // LTR559 that implements the generic ProximitySensor and AmbientLightSensor
 // interfaces.
 class Ltr559ProxAndLightSensorImpl final : public AmbientLightSensor,
-                                           public ProximitySensor {
+                                           public ProximitySensor,
+                                           public LightAndProximitySensor {
  public:
   template <typename... Args>
   explicit Ltr559ProxAndLightSensorImpl(Args&&... args)
-      : sensor_(std::forward<Args>(args)...) {}
+      : sensor_(std::forward<Args>(args)...),
+        rearm_work_([this]() { RearmThresholds(); }) {}
+
+  /// Injects the GPIO connected to the INT pin and the worker used to service
+  /// it, enabling `EnableThresholdDetection`.
+  void InitThresholdInterrupt(pw::digital_io::DigitalInterrupt& interrupt,
+                              Worker& worker) {
+    interrupt_ = &interrupt;
+    worker_ = &worker;
+  }
 
  private:
   pw::Status DoEnableProximitySensor() override {
@@ -114,11 +258,50 @@ class Ltr559ProxAndLightSensorImpl final : public AmbientLightSensor,
 
   pw::Result<uint16_t> DoReadProxSample() override;
 
+  pw::Result<Samples> DoReadLightAndProxSamples() override;
+
+  pw::Status DoEnableThresholdDetection(uint16_t inactive_threshold,
+                                        uint16_t active_threshold,
+                                        ThresholdCallback&& callback) override;
+
+  pw::Status DoSetThresholds(uint16_t inactive_threshold,
+                             uint16_t active_threshold) override;
+
+  pw::Status DoDisableThresholdDetection() override;
+
+  // Runs in interrupt context when the INT pin asserts.
+  void HandleInterrupt();
+
+  // Applies the thresholds' hysteresis to a scaled sample, calling the
+  // callback if the state changes.
+  void UpdateState(uint16_t sample);
+
+  // Updates the state from the latest sample, then programs the window for
+  // it and releases the INT pin.
+  void RearmThresholds();
+
+  // Readings are 11-bit unsigned integers. Scale them to 16 bits.
+  static constexpr uint16_t ScaleProximity(uint16_t raw_sample) {
+    return static_cast<uint16_t>(raw_sample << 5);
+  }
+
   pw::Result<float> DoReadLightSampleLux() override {
     return sensor_.ReadLightSampleLux();
   }
 
   Ltr559LightAndProxSensor sensor_;
+
+  pw::digital_io::DigitalInterrupt* interrupt_ = nullptr;
+  Worker* worker_ = nullptr;
+  WorkItem rearm_work_;
+  ThresholdCallback callback_;
+  // Read by the worker when rearming, so they may change while enabled.
+  std::atomic<uint16_t> inactive_threshold_ = 0;
+  std::atomic<uint16_t> active_threshold_ = 0;
+  bool interrupt_configured_ = false;
+
+  // Only changed from the worker, or while the interrupt is disabled.
+  std::atomic<bool> near_ = false;
 };
 
 }  // namespace sense
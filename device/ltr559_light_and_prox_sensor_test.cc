@@ -0,0 +1,281 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/ltr559_light_and_prox_sensor.h"
+
+#include <chrono>
+#include <utility>
+
+#include "modules/i2c/register_fake.h"
+#include "modules/worker/worker.h"
+#include "pw_containers/vector.h"
+#include "pw_digital_io/digital_io.h"
+#include "pw_function/function.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+using Traffic = I2cRegisterFake::Traffic;
+
+constexpr pw::i2c::Address kAddress = pw::i2c::Address::SevenBit<0x23>();
+
+// Bus budgets for each operation. Raising one of these should be a deliberate
+// choice, since the sampling thread runs these at up to 100 Hz.
+constexpr uint32_t kReadAllSamplesTransactions = 1;
+constexpr auto kReadAllSamplesBusTime = 250us;
+constexpr uint32_t kReadLightTransactions = 1;
+constexpr uint32_t kReadProximityTransactions = 1;
+constexpr uint32_t kRangeChangeTransactions = 2;
+constexpr uint32_t kSetThresholdsTransactions = 1;
+
+class Ltr559Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(bus_.AddDevice(kAddress), pw::OkStatus());
+    // Counts within the default range, so that reads do not change it.
+    SetAlsChannels(20'000, 20'000);
+    ASSERT_EQ(sensor_.EnableLight(), pw::OkStatus());
+    ASSERT_EQ(sensor_.EnableProximity(), pw::OkStatus());
+    bus_.TakeTraffic();
+  }
+
+  // Sets the ALS channels, along with the new data bit of ALS_PS_STATUS.
+  void SetAlsChannels(uint16_t channel_1,
+                      uint16_t channel_0,
+                      bool new_data = true) {
+    const uint8_t data[] = {
+        static_cast<uint8_t>(channel_1 & 0xFF),
+        static_cast<uint8_t>(channel_1 >> 8),
+        static_cast<uint8_t>(channel_0 & 0xFF),
+        static_cast<uint8_t>(channel_0 >> 8),
+        static_cast<uint8_t>(new_data ? 0x04 : 0x00),
+    };
+    bus_.SetRegisters(kAddress, 0x88, data);
+  }
+
+  I2cRegisterFake bus_;
+  Ltr559LightAndProxSensor sensor_{bus_};
+};
+
+TEST_F(Ltr559Test, ReadAllSamplesIsOneTransaction) {
+  ASSERT_EQ(sensor_.ReadAllSamples().status(), pw::OkStatus());
+  const Traffic traffic = bus_.TakeTraffic();
+  EXPECT_LE(traffic.transactions, kReadAllSamplesTransactions);
+  EXPECT_LE(traffic.bus_time, kReadAllSamplesBusTime);
+}
+
+TEST_F(Ltr559Test, SeparateReadsAreOneTransactionEach) {
+  ASSERT_EQ(sensor_.ReadLightSampleLux().status(), pw::OkStatus());
+  EXPECT_LE(bus_.TakeTraffic().transactions, kReadLightTransactions);
+
+  ASSERT_EQ(sensor_.ReadProximitySample().status(), pw::OkStatus());
+  EXPECT_LE(bus_.TakeTraffic().transactions, kReadProximityTransactions);
+}
+
+TEST_F(Ltr559Test, RangeChangeOnlyWritesTheRange) {
+  SetAlsChannels(60'000, 60'000);
+  ASSERT_EQ(sensor_.ReadAllSamples().status(), pw::OkStatus());
+  EXPECT_LE(bus_.TakeTraffic().transactions,
+            kReadAllSamplesTransactions + kRangeChangeTransactions);
+
+  // The settling read and those after it do not touch the range again.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(sensor_.ReadAllSamples().status(), pw::OkStatus());
+  }
+  EXPECT_LE(bus_.TakeTraffic().transactions, 3 * kReadAllSamplesTransactions);
+}
+
+// Lux for equal channel counts, from the manufacturer's formula for a channel
+// ratio of 50%, at the given gain and integration time.
+constexpr float EqualChannelsLux(uint16_t counts,
+                                 uint8_t gain,
+                                 uint16_t integration_time_ms) {
+  return static_cast<float>(counts * (42785 - 19548)) /
+         (integration_time_ms / 100.f * gain * 10000.f);
+}
+
+TEST_F(Ltr559Test, StartsAtDefaultRange) {
+  EXPECT_EQ(sensor_.als_gain(), 1);
+  EXPECT_EQ(sensor_.als_integration_time_ms(), 100);
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x80), 0x01);  // 1x gain, active.
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x85), 0x01);  // 100 ms, 100 ms rate.
+}
+
+TEST_F(Ltr559Test, StepsDownBeforeSaturating) {
+  SetAlsChannels(60'000, 60'000);
+  pw::Result<float> lux = sensor_.ReadLightSampleLux();
+  ASSERT_EQ(lux.status(), pw::OkStatus());
+  EXPECT_FLOAT_EQ(*lux, EqualChannelsLux(60'000, 1, 100));
+
+  EXPECT_EQ(sensor_.als_gain(), 1);
+  EXPECT_EQ(sensor_.als_integration_time_ms(), 50);
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x80), 0x01);  // 1x gain, active.
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x85), 0x08);  // 50 ms, 50 ms rate.
+}
+
+TEST_F(Ltr559Test, StepsUpInLowLight) {
+  SetAlsChannels(1'000, 1'000);
+  ASSERT_EQ(sensor_.ReadLightSampleLux().status(), pw::OkStatus());
+
+  EXPECT_EQ(sensor_.als_gain(), 2);
+  EXPECT_EQ(sensor_.als_integration_time_ms(), 100);
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x80), 0x05);  // 2x gain, active.
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x85), 0x01);  // 100 ms, 100 ms rate.
+}
+
+TEST_F(Ltr559Test, RangeChangeSettlesForOneNewSample) {
+  SetAlsChannels(60'000, 60'000);
+  const float before = sensor_.ReadLightSampleLux().value();
+
+  // Until a new sample arrives, and for that first sample, which may have
+  // been measured with either range, the last lux is repeated.
+  SetAlsChannels(20'000, 20'000, /*new_data=*/false);
+  EXPECT_FLOAT_EQ(sensor_.ReadLightSampleLux().value(), before);
+  SetAlsChannels(20'000, 20'000);
+  EXPECT_FLOAT_EQ(sensor_.ReadLightSampleLux().value(), before);
+
+  // Later samples are scaled for the new range.
+  EXPECT_FLOAT_EQ(sensor_.ReadLightSampleLux().value(),
+                  EqualChannelsLux(20'000, 1, 50));
+}
+
+TEST_F(Ltr559Test, SetProximityThresholdsIsOneBurst) {
+  ASSERT_EQ(sensor_.SetProximityThresholds(100, 200), pw::OkStatus());
+  const Traffic traffic = bus_.TakeTraffic();
+  EXPECT_LE(traffic.transactions, kSetThresholdsTransactions);
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x90), 200);
+  EXPECT_EQ(bus_.GetRegister(kAddress, 0x92), 100);
+}
+
+class TestDigitalInterrupt : public pw::digital_io::DigitalInterrupt {
+ public:
+  /// Calls the handler as if the INT pin asserted, if it is enabled.
+  void Trigger() {
+    if (enabled_ && handler_ != nullptr) {
+      handler_(pw::digital_io::State::kActive);
+    }
+  }
+
+ private:
+  pw::Status DoEnable(bool) override { return pw::OkStatus(); }
+  pw::Status DoSetInterruptHandler(
+      pw::digital_io::InterruptTrigger,
+      pw::digital_io::InterruptHandler&& handler) override {
+    handler_ = std::move(handler);
+    return pw::OkStatus();
+  }
+  pw::Status DoEnableInterruptHandler(bool enable) override {
+    enabled_ = enable;
+    return pw::OkStatus();
+  }
+
+  pw::digital_io::InterruptHandler handler_;
+  bool enabled_ = false;
+};
+
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+};
+
+class Ltr559ThresholdTest : public ::testing::Test {
+ protected:
+  // Scaled thresholds, which are 16 and 62 in the 11-bit samples.
+  static constexpr uint16_t kInactiveThreshold = 512;
+  static constexpr uint16_t kActiveThreshold = 2000;
+
+  void SetUp() override {
+    ASSERT_EQ(bus_.AddDevice(kAddress), pw::OkStatus());
+    sensor_.InitThresholdInterrupt(interrupt_, worker_);
+    ProximitySensor& sensor = sensor_;
+    ASSERT_EQ(sensor.EnableThresholdDetection(
+                  kInactiveThreshold,
+                  kActiveThreshold,
+                  [this](bool near) { changes_.push_back(near); }),
+              pw::OkStatus());
+    worker_.RunAll();
+  }
+
+  void SetProximity(uint16_t raw_sample) {
+    const uint8_t data[] = {
+        static_cast<uint8_t>(raw_sample & 0xFF),
+        static_cast<uint8_t>(raw_sample >> 8),
+    };
+    bus_.SetRegisters(kAddress, 0x8D, data);
+  }
+
+  void Interrupt() {
+    interrupt_.Trigger();
+    worker_.RunAll();
+  }
+
+  uint16_t upper_threshold() const {
+    return static_cast<uint16_t>(bus_.GetRegister(kAddress, 0x90) |
+                                 bus_.GetRegister(kAddress, 0x91) << 8);
+  }
+
+  I2cRegisterFake bus_;
+  TestDigitalInterrupt interrupt_;
+  ManualWorker worker_;
+  Ltr559ProxAndLightSensorImpl sensor_{bus_};
+  pw::Vector<bool, 8> changes_;
+};
+
+TEST_F(Ltr559ThresholdTest, InterruptReportsStateOfLatestSample) {
+  EXPECT_EQ(upper_threshold(), kActiveThreshold >> 5);
+
+  SetProximity(100);
+  Interrupt();
+  SetProximity(10);
+  Interrupt();
+
+  ASSERT_EQ(changes_.size(), 2u);
+  EXPECT_TRUE(changes_[0]);
+  EXPECT_FALSE(changes_[1]);
+}
+
+TEST_F(Ltr559ThresholdTest, SpuriousInterruptKeepsState) {
+  SetProximity(100);
+  Interrupt();
+  ASSERT_EQ(changes_.size(), 1u);
+
+  // An extra edge, or INT released early by a status read, while the sample
+  // is still near does not flip the state.
+  Interrupt();
+  EXPECT_EQ(changes_.size(), 1u);
+  EXPECT_EQ(upper_threshold(), 0x7FF);
+
+  // Inside the hysteresis band the state holds as well.
+  SetProximity(40);
+  Interrupt();
+  EXPECT_EQ(changes_.size(), 1u);
+}
+
+}  // namespace
+}  // namespace sense
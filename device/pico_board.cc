@@ -14,22 +14,110 @@
 
 #include "device/pico_board.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
 #include "hardware/flash.h"
 #include "pico/bootrom.h"
 #include "pw_bytes/endian.h"
 
 namespace sense {
+namespace {
+
+constexpr unsigned kTemperatureInput = 4;  // 4 is the on board temp sensor.
+
+// Log2 of a power of two, as the DMA ring setting takes the ring size.
+constexpr unsigned Log2(size_t value) {
+  unsigned bits = 0;
+  while (value > 1) {
+    value >>= 1;
+    ++bits;
+  }
+  return bits;
+}
 
-PicoBoard::PicoBoard() { adc_init(); }
+}  // namespace
+
+PicoBoard::PicoBoard() {
+  adc_init();
+  adc_set_temp_sensor_enabled(true);
+  adc_select_input(kTemperatureInput);
+
+  // Fill the ring with a real reading, so reads before the first DMA pass
+  // do not average in zeros.
+  samples_.fill(adc_read());
+  StartSampling();
+}
+
+void PicoBoard::StartSampling() {
+  data_channel_ = dma_claim_unused_channel(true);
+  rewind_channel_ = dma_claim_unused_channel(true);
+
+  // The divider sets the ADC clocks between the starts of conversions.
+  adc_set_clkdiv(static_cast<float>(clock_get_hz(clk_adc)) / kSampleRateHz -
+                 1.f);
+  adc_fifo_setup(/*en=*/true,
+                 /*dreq_en=*/true,
+                 /*dreq_thresh=*/1,
+                 /*err_in_fifo=*/false,
+                 /*byte_shift=*/false);
+  adc_fifo_drain();
+
+  // The data channel writes around the ring once per pass, and the rewind
+  // channel restarts it by writing its transfer count trigger. The write
+  // address wraps, so it does not need to be reset.
+  dma_channel_config data = dma_channel_get_default_config(data_channel_);
+  channel_config_set_transfer_data_size(&data, DMA_SIZE_16);
+  channel_config_set_read_increment(&data, false);
+  channel_config_set_write_increment(&data, true);
+  channel_config_set_ring(&data, /*write=*/true, Log2(kRingBytes));
+  channel_config_set_dreq(&data, DREQ_ADC);
+  channel_config_set_chain_to(&data, rewind_channel_);
+  dma_channel_configure(data_channel_,
+                        &data,
+                        samples_.data(),
+                        &adc_hw->fifo,
+                        kNumSamples,
+                        false);
+
+  dma_channel_config rewind = dma_channel_get_default_config(rewind_channel_);
+  channel_config_set_transfer_data_size(&rewind, DMA_SIZE_32);
+  channel_config_set_read_increment(&rewind, false);
+  channel_config_set_write_increment(&rewind, false);
+  dma_channel_configure(rewind_channel_,
+                        &rewind,
+                        &dma_hw->ch[data_channel_].al1_transfer_count_trig,
+                        &transfer_count_,
+                        1,
+                        false);
+
+  dma_channel_start(data_channel_);
+  adc_run(true);
+}
 
 // See raspberry-pi-pico-c-sdk.pdf, Section '4.1.1. hardware_adc'
 float PicoBoard::ReadInternalTemperature() {
-  adc_set_temp_sensor_enabled(true);
-  adc_select_input(4);  // 4 is the on board temp sensor.
+  // Drop the highest and lowest samples, which catch most conversion
+  // spikes, and average the rest. DMA keeps writing while this runs, so
+  // read each sample once.
+  const volatile uint16_t* samples = samples_.data();
+  uint32_t sum = 0;
+  uint16_t lowest = std::numeric_limits<uint16_t>::max();
+  uint16_t highest = 0;
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    const uint16_t sample = samples[i];
+    sum += sample;
+    lowest = std::min(lowest, sample);
+    highest = std::max(highest, sample);
+  }
+  const float average = static_cast<float>(sum - lowest - highest) /
+                        static_cast<float>(kNumSamples - 2);
 
   constexpr float kConversionFactor = 3.3f / (1 << 12);
-  float adc = static_cast<float>(adc_read()) * kConversionFactor;
+  float adc = average * kConversionFactor;
   return 27.0f - (adc - 0.706f) / 0.001721f;
 }
 
@@ -13,17 +13,51 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 #include "modules/board/board.h"
 #include "pw_status/status.h"
 
 namespace sense {
 
+/// The RP2040 board.
+///
+/// The ADC runs freely on the temperature sensor channel, and DMA copies its
+/// conversions into a ring, so reading the temperature averages the latest
+/// samples instead of waiting for a conversion. The board owns the ADC; no
+/// other code may change its input or start conversions.
 class PicoBoard : public Board {
  public:
+  /// Conversions per second.
+  static constexpr uint32_t kSampleRateHz = 1000;
+
+  /// Samples averaged by each read. Must be a power of two so that DMA can
+  /// wrap around the ring.
+  static constexpr size_t kNumSamples = 64;
+
   PicoBoard();
   float ReadInternalTemperature() override;
   pw::Status Reboot(board_RebootType_Enum reboot_type) override;
   uint64_t UniqueFlashId() const override;
+
+ private:
+  static constexpr size_t kRingBytes = kNumSamples * sizeof(uint16_t);
+  static_assert((kRingBytes & (kRingBytes - 1)) == 0,
+                "The sample ring must be a power of two bytes");
+
+  /// Starts DMA from the ADC FIFO into `samples_`.
+  void StartSampling();
+
+  int data_channel_ = -1;
+  int rewind_channel_ = -1;
+
+  /// Copied into the data channel's transfer count to restart it.
+  uint32_t transfer_count_ = kNumSamples;
+
+  /// Aligned to its size for the DMA write ring.
+  alignas(kRingBytes) std::array<uint16_t, kNumSamples> samples_;
 };
 
 }  // namespace sense
\ No newline at end of file
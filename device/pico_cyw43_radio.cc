@@ -0,0 +1,108 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "CYW43"
+
+#include "device/pico_cyw43_radio.h"
+
+#include <cstring>
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "pico/cyw43_arch.h"
+#include "pw_log/log.h"
+
+namespace sense {
+
+pw::Status PicoCyw43Radio::DoConnect() {
+  if (pcb_ != nullptr) {
+    return pw::OkStatus();
+  }
+  if (!powered_) {
+    if (cyw43_arch_init() != 0) {
+      PW_LOG_ERROR("Failed to initialize the radio");
+      return pw::Status::Unavailable();
+    }
+    powered_ = true;
+    cyw43_arch_enable_sta_mode();
+  }
+
+  int result = cyw43_arch_wifi_connect_timeout_ms(config_.ssid,
+                                                  config_.password,
+                                                  CYW43_AUTH_WPA2_AES_PSK,
+                                                  config_.connect_timeout_ms);
+  if (result != 0) {
+    PW_LOG_WARN("Failed to join the network: %d", result);
+    DoPowerOff();
+    return pw::Status::Unavailable();
+  }
+
+  cyw43_arch_lwip_begin();
+  pcb_ = udp_new();
+  cyw43_arch_lwip_end();
+  if (pcb_ == nullptr) {
+    DoPowerOff();
+    return pw::Status::ResourceExhausted();
+  }
+  return pw::OkStatus();
+}
+
+pw::Status PicoCyw43Radio::DoSend(pw::ConstByteSpan datagram) {
+  if (pcb_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+  if (datagram.size() > kMaxDatagramSize) {
+    return pw::Status::ResourceExhausted();
+  }
+
+  ip_addr_t address;
+  if (!ipaddr_aton(config_.host, &address)) {
+    PW_LOG_ERROR("Invalid collector address %s", config_.host);
+    return pw::Status::InvalidArgument();
+  }
+
+  cyw43_arch_lwip_begin();
+  pbuf* buffer = pbuf_alloc(
+      PBUF_TRANSPORT, static_cast<uint16_t>(datagram.size()), PBUF_RAM);
+  err_t err = ERR_MEM;
+  if (buffer != nullptr) {
+    std::memcpy(buffer->payload, datagram.data(), datagram.size());
+    err = udp_sendto(pcb_, buffer, &address, config_.port);
+    pbuf_free(buffer);
+  }
+  cyw43_arch_lwip_end();
+
+  if (err != ERR_OK) {
+    PW_LOG_WARN("Failed to send a datagram: %d", err);
+    return err == ERR_MEM ? pw::Status::ResourceExhausted()
+                          : pw::Status::Unavailable();
+  }
+  return pw::OkStatus();
+}
+
+void PicoCyw43Radio::DoPowerOff() {
+  if (pcb_ != nullptr) {
+    cyw43_arch_lwip_begin();
+    udp_remove(pcb_);
+    cyw43_arch_lwip_end();
+    pcb_ = nullptr;
+  }
+  if (powered_) {
+    cyw43_arch_deinit();
+    powered_ = false;
+  }
+}
+
+}  // namespace sense
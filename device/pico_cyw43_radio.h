@@ -0,0 +1,77 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/uplink/radio.h"
+#include "pw_bytes/span.h"
+#include "pw_status/status.h"
+
+/// Network the radio joins.
+#ifndef SENSE_UPLINK_SSID
+#define SENSE_UPLINK_SSID ""
+#endif  // SENSE_UPLINK_SSID
+
+#ifndef SENSE_UPLINK_PASSWORD
+#define SENSE_UPLINK_PASSWORD ""
+#endif  // SENSE_UPLINK_PASSWORD
+
+/// Collector that datagrams are sent to, as a dotted IPv4 address.
+#ifndef SENSE_UPLINK_HOST
+#define SENSE_UPLINK_HOST "192.168.1.2"
+#endif  // SENSE_UPLINK_HOST
+
+#ifndef SENSE_UPLINK_PORT
+#define SENSE_UPLINK_PORT 33336
+#endif  // SENSE_UPLINK_PORT
+
+struct udp_pcb;
+
+namespace sense {
+
+/// Wi-Fi radio of the Pico W, sending UDP datagrams to a fixed collector.
+///
+/// The CYW43 chip is only initialized while connected; `PowerOff`
+/// deinitializes it, which cuts its supply through WL_ON.
+class PicoCyw43Radio final : public Radio {
+ public:
+  struct Config {
+    const char* ssid = SENSE_UPLINK_SSID;
+    const char* password = SENSE_UPLINK_PASSWORD;
+    const char* host = SENSE_UPLINK_HOST;
+    uint16_t port = SENSE_UPLINK_PORT;
+    /// Longest time to wait for the network to be joined.
+    uint32_t connect_timeout_ms = 10'000;
+  };
+
+  PicoCyw43Radio() : PicoCyw43Radio(Config{}) {}
+  explicit PicoCyw43Radio(const Config& config) : config_(config) {}
+
+ private:
+  // Room in a single Ethernet frame after the IPv4 and UDP headers.
+  static constexpr size_t kMaxDatagramSize = 1472;
+
+  pw::Status DoConnect() override;
+  pw::Status DoSend(pw::ConstByteSpan datagram) override;
+  void DoPowerOff() override;
+  size_t DoMaxDatagramSize() const override { return kMaxDatagramSize; }
+
+  const Config config_;
+  bool powered_ = false;
+  udp_pcb* pcb_ = nullptr;
+};
+
+}  // namespace sense
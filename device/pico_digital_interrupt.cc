@@ -0,0 +1,117 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/pico_digital_interrupt.h"
+
+#include <tuple>
+#include <utility>
+
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "pw_assert/check.h"
+
+namespace sense {
+
+using ::pw::digital_io::InterruptTrigger;
+using ::pw::digital_io::Polarity;
+using ::pw::digital_io::State;
+
+std::array<PicoDigitalInterrupt*, NUM_BANK0_GPIOS>
+    PicoDigitalInterrupt::active_{};
+bool PicoDigitalInterrupt::handler_installed_ = false;
+
+pw::Status PicoDigitalInterrupt::DoEnable(bool enable) {
+  if (!enable) {
+    std::ignore = DoEnableInterruptHandler(false);
+    gpio_deinit(config_.pin);
+    return pw::OkStatus();
+  }
+  gpio_init(config_.pin);
+  gpio_set_dir(config_.pin, GPIO_IN);
+  if (config_.enable_pull_up) {
+    gpio_pull_up(config_.pin);
+  }
+  return pw::OkStatus();
+}
+
+pw::Status PicoDigitalInterrupt::DoSetInterruptHandler(
+    InterruptTrigger trigger, pw::digital_io::InterruptHandler&& handler) {
+  trigger_ = trigger;
+  handler_ = std::move(handler);
+  return pw::OkStatus();
+}
+
+pw::Status PicoDigitalInterrupt::DoEnableInterruptHandler(bool enable) {
+  PicoDigitalInterrupt*& active = active_[config_.pin];
+  if (!enable) {
+    if (active == this) {
+      gpio_set_irq_enabled(config_.pin, EventMask(), false);
+      active = nullptr;
+    }
+    return pw::OkStatus();
+  }
+  PW_CHECK(active == nullptr || active == this,
+           "Only one GPIO interrupt handler per pin is supported");
+  active = this;
+  if (!handler_installed_) {
+    // The raw handler runs for every GPIO bank interrupt, and checks each
+    // active pin itself.
+    gpio_add_raw_irq_handler_masked(0xffffffff, IrqHandler);
+    handler_installed_ = true;
+  }
+  gpio_acknowledge_irq(config_.pin, EventMask());
+  gpio_set_irq_enabled(config_.pin, EventMask(), true);
+  irq_set_enabled(IO_IRQ_BANK0, true);
+  return pw::OkStatus();
+}
+
+uint32_t PicoDigitalInterrupt::EventMask() const {
+  const bool active_low = config_.polarity == Polarity::kActiveLow;
+  const uint32_t activating =
+      active_low ? GPIO_IRQ_EDGE_FALL : GPIO_IRQ_EDGE_RISE;
+  const uint32_t deactivating =
+      active_low ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+  switch (trigger_) {
+    case InterruptTrigger::kActivatingEdge:
+      return activating;
+    case InterruptTrigger::kDeactivatingEdge:
+      return deactivating;
+    case InterruptTrigger::kBothEdges:
+      return activating | deactivating;
+  }
+  return 0;
+}
+
+void PicoDigitalInterrupt::IrqHandler() {
+  for (PicoDigitalInterrupt* interrupt : active_) {
+    if (interrupt != nullptr) {
+      interrupt->HandleEvents();
+    }
+  }
+}
+
+void PicoDigitalInterrupt::HandleEvents() {
+  const uint32_t events = gpio_get_irq_event_mask(config_.pin);
+  if ((events & EventMask()) == 0) {
+    return;
+  }
+  gpio_acknowledge_irq(config_.pin, events);
+  const bool high = gpio_get(config_.pin);
+  const bool active = config_.polarity == Polarity::kActiveLow ? !high : high;
+  if (handler_ != nullptr) {
+    handler_(active ? State::kActive : State::kInactive);
+  }
+}
+
+}  // namespace sense
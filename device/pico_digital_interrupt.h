@@ -0,0 +1,67 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "hardware/gpio.h"
+#include "pw_digital_io/digital_io.h"
+#include "pw_digital_io/polarity.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// GPIO input that reports edges through a `pw::digital_io::DigitalInterrupt`
+/// handler, which runs in interrupt context.
+///
+/// Instances on different pins may have their handlers enabled at the same
+/// time. They share one handler for the GPIO bank interrupt.
+class PicoDigitalInterrupt final : public pw::digital_io::DigitalInterrupt {
+ public:
+  struct Config {
+    uint32_t pin;
+    pw::digital_io::Polarity polarity;
+    bool enable_pull_up;
+  };
+
+  explicit constexpr PicoDigitalInterrupt(const Config& config)
+      : config_(config) {}
+
+ private:
+  pw::Status DoEnable(bool enable) override;
+  pw::Status DoSetInterruptHandler(
+      pw::digital_io::InterruptTrigger trigger,
+      pw::digital_io::InterruptHandler&& handler) override;
+  pw::Status DoEnableInterruptHandler(bool enable) override;
+
+  /// Returns the GPIO events that correspond to `trigger_`.
+  uint32_t EventMask() const;
+
+  static void IrqHandler();
+
+  /// Dispatches the pending events for this instance's pin.
+  void HandleEvents();
+
+  /// Instances with enabled handlers, indexed by pin.
+  static std::array<PicoDigitalInterrupt*, NUM_BANK0_GPIOS> active_;
+  static bool handler_installed_;
+
+  const Config config_;
+  pw::digital_io::InterruptTrigger trigger_ =
+      pw::digital_io::InterruptTrigger::kActivatingEdge;
+  pw::digital_io::InterruptHandler handler_;
+};
+
+}  // namespace sense
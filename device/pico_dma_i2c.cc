@@ -0,0 +1,223 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "I2C"
+
+#include "device/pico_dma_i2c.h"
+
+#include <mutex>
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "pw_assert/check.h"
+#include "pw_log/log.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+using ::pw::Status;
+using ::pw::chrono::SystemClock;
+
+namespace {
+
+constexpr uint32_t kInterrupts =
+    I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+constexpr uint32_t kNoAckAbortBits =
+    I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS |
+    I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS;
+
+}  // namespace
+
+PicoDmaI2cInitiator* PicoDmaI2cInitiator::instances_[2] = {};
+
+PicoDmaI2cInitiator::PicoDmaI2cInitiator(const Config& config,
+                                         i2c_inst_t* instance)
+    : config_(config),
+      instance_(instance) {}
+
+void PicoDmaI2cInitiator::Enable() {
+  if (enabled_) {
+    return;
+  }
+  const unsigned index = i2c_hw_index(instance_);
+  PW_CHECK(instances_[index] == nullptr, "I2C%u already has a DMA initiator",
+           index);
+  instances_[index] = this;
+
+  i2c_init(instance_, config_.clock_frequency);
+  gpio_set_function(config_.sda_pin, GPIO_FUNC_I2C);
+  gpio_set_function(config_.scl_pin, GPIO_FUNC_I2C);
+  gpio_pull_up(config_.sda_pin);
+  gpio_pull_up(config_.scl_pin);
+
+  tx_channel_ = dma_claim_unused_channel(true);
+  rx_channel_ = dma_claim_unused_channel(true);
+
+  i2c_hw_t* hw = i2c_get_hw(instance_);
+  hw->intr_mask = 0;
+  const unsigned irq = index == 0 ? I2C0_IRQ : I2C1_IRQ;
+  irq_set_exclusive_handler(irq, index == 0 ? I2c0IrqHandler : I2c1IrqHandler);
+  irq_set_enabled(irq, true);
+  enabled_ = true;
+}
+
+void PicoDmaI2cInitiator::Abort() {
+  std::lock_guard lock(lock_);
+  if (!busy_) {
+    return;
+  }
+  StopDma();
+  // Abort the controller so that it releases the bus with a STOP.
+  i2c_hw_t* hw = i2c_get_hw(instance_);
+  hw->intr_mask = 0;
+  hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+  while (hw->enable & I2C_IC_ENABLE_ABORT_BITS) {
+  }
+  static_cast<void>(hw->clr_tx_abrt);
+  static_cast<void>(hw->clr_stop_det);
+  Complete(Status::DeadlineExceeded());
+}
+
+Status PicoDmaI2cInitiator::DoWriteReadFor(pw::i2c::Address address,
+                                           pw::ConstByteSpan tx_buffer,
+                                           pw::ByteSpan rx_buffer,
+                                           SystemClock::duration timeout) {
+  const SystemClock::time_point deadline =
+      SystemClock::TimePointAfterAtLeast(timeout);
+  std::lock_guard mutex(mutex_);
+  PW_TRY(StartTransfer(address, tx_buffer, rx_buffer));
+
+  if (!done_.try_acquire_until(deadline)) {
+    // Either the abort or the interrupt, if it won the race, completes the
+    // transfer. Consume its release so that the next transfer waits for its
+    // own.
+    Abort();
+    done_.acquire();
+  }
+  std::lock_guard lock(lock_);
+  return result_;
+}
+
+Status PicoDmaI2cInitiator::StartTransfer(pw::i2c::Address address,
+                                          pw::ConstByteSpan tx_buffer,
+                                          pw::ByteSpan rx_buffer) {
+  if (!enabled_) {
+    return Status::FailedPrecondition();
+  }
+  const size_t length = tx_buffer.size() + rx_buffer.size();
+  if (length == 0 || length > kMaxTransferSize) {
+    return Status::OutOfRange();
+  }
+
+  std::lock_guard lock(lock_);
+  if (busy_) {
+    return Status::Unavailable();
+  }
+  busy_ = true;
+
+  // Each command word is a byte to write or a read request. A read that
+  // follows a write is preceded by a repeated start, and the last command
+  // ends the transfer with a STOP.
+  size_t i = 0;
+  for (std::byte value : tx_buffer) {
+    commands_[i++] = static_cast<uint32_t>(value);
+  }
+  for (size_t j = 0; j < rx_buffer.size(); ++j) {
+    uint32_t command = I2C_IC_DATA_CMD_CMD_BITS;
+    if (j == 0 && !tx_buffer.empty()) {
+      command |= I2C_IC_DATA_CMD_RESTART_BITS;
+    }
+    commands_[i++] = command;
+  }
+  commands_[length - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  i2c_hw_t* hw = i2c_get_hw(instance_);
+  hw->enable = 0;
+  hw->tar = address.GetSevenBit();
+  hw->enable = 1;
+  static_cast<void>(hw->clr_intr);
+
+  if (!rx_buffer.empty()) {
+    dma_channel_config rx = dma_channel_get_default_config(rx_channel_);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, true);
+    channel_config_set_dreq(&rx, i2c_get_dreq(instance_, false));
+    dma_channel_configure(rx_channel_,
+                          &rx,
+                          rx_buffer.data(),
+                          &hw->data_cmd,
+                          rx_buffer.size(),
+                          true);
+  }
+
+  dma_channel_config tx = dma_channel_get_default_config(tx_channel_);
+  channel_config_set_transfer_data_size(&tx, DMA_SIZE_32);
+  channel_config_set_read_increment(&tx, true);
+  channel_config_set_write_increment(&tx, false);
+  channel_config_set_dreq(&tx, i2c_get_dreq(instance_, true));
+  hw->intr_mask = kInterrupts;
+  dma_channel_configure(
+      tx_channel_, &tx, &hw->data_cmd, commands_.data(), length, true);
+  return pw::OkStatus();
+}
+
+void PicoDmaI2cInitiator::Complete(Status status) {
+  busy_ = false;
+  result_ = status;
+  done_.release();
+}
+
+void PicoDmaI2cInitiator::StopDma() {
+  dma_channel_abort(tx_channel_);
+  dma_channel_abort(rx_channel_);
+}
+
+void PicoDmaI2cInitiator::HandleInterrupt() {
+  i2c_hw_t* hw = i2c_get_hw(instance_);
+  const uint32_t raised = hw->intr_stat;
+  if ((raised & kInterrupts) == 0) {
+    return;
+  }
+  std::lock_guard lock(lock_);
+  hw->intr_mask = 0;
+
+  if (raised & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+    const uint32_t source = hw->tx_abrt_source;
+    static_cast<void>(hw->clr_tx_abrt);
+    static_cast<void>(hw->clr_stop_det);
+    StopDma();
+    if (busy_) {
+      Complete((source & kNoAckAbortBits) != 0 ? Status::Unavailable()
+                                               : Status::Unknown());
+    }
+    return;
+  }
+
+  static_cast<void>(hw->clr_stop_det);
+  // The STOP can be raised just before the last byte leaves the RX FIFO.
+  while (dma_channel_is_busy(rx_channel_)) {
+  }
+  if (busy_) {
+    Complete(pw::OkStatus());
+  }
+}
+
+void PicoDmaI2cInitiator::I2c0IrqHandler() { instances_[0]->HandleInterrupt(); }
+
+void PicoDmaI2cInitiator::I2c1IrqHandler() { instances_[1]->HandleInterrupt(); }
+
+}  // namespace sense
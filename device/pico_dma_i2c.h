@@ -0,0 +1,94 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "hardware/i2c.h"
+#include "pw_bytes/span.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_i2c/address.h"
+#include "pw_i2c/initiator.h"
+#include "pw_status/status.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+#include "pw_sync/timed_thread_notification.h"
+
+namespace sense {
+
+/// I2C initiator for the RP2 that moves every byte with DMA.
+///
+/// The command stream is fed to the controller by one DMA channel and read
+/// data is drained by another, so the CPU is only involved when a transfer
+/// starts and when the controller raises STOP or ABORT. Transfers made through
+/// the `pw::i2c::Initiator` interface sleep on a notification instead of
+/// polling the FIFOs, and run one at a time.
+class PicoDmaI2cInitiator : public pw::i2c::Initiator {
+ public:
+  struct Config {
+    uint32_t clock_frequency;
+    uint8_t sda_pin;
+    uint8_t scl_pin;
+  };
+
+  /// Longest transfer, counting both written and read bytes.
+  static constexpr size_t kMaxTransferSize = 64;
+
+  PicoDmaI2cInitiator(const Config& config, i2c_inst_t* instance);
+
+  /// Configures the pins and controller and claims the DMA channels.
+  void Enable();
+
+ private:
+  pw::Status DoWriteReadFor(pw::i2c::Address address,
+                            pw::ConstByteSpan tx_buffer,
+                            pw::ByteSpan rx_buffer,
+                            pw::chrono::SystemClock::duration timeout) override;
+
+  pw::Status StartTransfer(pw::i2c::Address address,
+                           pw::ConstByteSpan tx_buffer,
+                           pw::ByteSpan rx_buffer) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Aborts the transfer in flight, if any, with `DEADLINE_EXCEEDED`.
+  void Abort() PW_LOCKS_EXCLUDED(lock_);
+
+  void Complete(pw::Status status) PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void StopDma();
+  void HandleInterrupt();
+
+  static void I2c0IrqHandler();
+  static void I2c1IrqHandler();
+
+  static PicoDmaI2cInitiator* instances_[2];
+
+  const Config config_;
+  i2c_inst_t* const instance_;
+  int tx_channel_ = -1;
+  int rx_channel_ = -1;
+  bool enabled_ = false;
+
+  /// Serializes transfers, so that each release of `done_` belongs to the
+  /// transfer of the thread waiting on it.
+  pw::sync::Mutex mutex_;
+  pw::sync::TimedThreadNotification done_;
+
+  pw::sync::InterruptSpinLock lock_;
+  bool busy_ PW_GUARDED_BY(lock_) = false;
+  pw::Status result_ PW_GUARDED_BY(lock_);
+  std::array<uint32_t, kMaxTransferSize> commands_;
+};
+
+}  // namespace sense
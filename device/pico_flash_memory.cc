@@ -0,0 +1,113 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/pico_flash_memory.h"
+
+#include <cstring>
+
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "pico/flash.h"
+#include "pw_assert/check.h"
+
+namespace sense {
+namespace {
+
+constexpr uint32_t kFlashEnterExitTimeoutMs = 100;
+
+struct EraseParams {
+  uint32_t offset;
+  size_t size;
+};
+
+struct ProgramParams {
+  uint32_t offset;
+  const std::byte* data;
+  size_t size;
+};
+
+void DoErase(void* param) {
+  auto& params = *static_cast<EraseParams*>(param);
+  flash_range_erase(params.offset, params.size);
+}
+
+void DoProgram(void* param) {
+  auto& params = *static_cast<ProgramParams*>(param);
+  flash_range_program(params.offset,
+                      reinterpret_cast<const uint8_t*>(params.data),
+                      params.size);
+}
+
+pw::Status ToStatus(int result) {
+  switch (result) {
+    case PICO_OK:
+      return pw::OkStatus();
+    case PICO_ERROR_TIMEOUT:
+      return pw::Status::DeadlineExceeded();
+    case PICO_ERROR_NOT_PERMITTED:
+      return pw::Status::FailedPrecondition();
+    default:
+      return pw::Status::Internal();
+  }
+}
+
+}  // namespace
+
+PicoFlashMemory::PicoFlashMemory(size_t sector_count)
+    : pw::kvs::FlashMemory(
+          FLASH_SECTOR_SIZE,
+          sector_count,
+          FLASH_PAGE_SIZE,
+          XIP_BASE + PICO_FLASH_SIZE_BYTES - sector_count * FLASH_SECTOR_SIZE) {
+  PW_CHECK_UINT_LT(sector_count * FLASH_SECTOR_SIZE, PICO_FLASH_SIZE_BYTES);
+}
+
+bool PicoFlashMemory::Contains(Address address, size_t size) const {
+  return address >= start_address() &&
+         address - start_address() + size <= size_bytes();
+}
+
+pw::Status PicoFlashMemory::Erase(Address address, size_t num_sectors) {
+  const size_t size = num_sectors * sector_size_bytes();
+  if (!Contains(address, size) || address % sector_size_bytes() != 0) {
+    return pw::Status::InvalidArgument();
+  }
+  EraseParams params{.offset = address - XIP_BASE, .size = size};
+  return ToStatus(
+      flash_safe_execute(DoErase, &params, kFlashEnterExitTimeoutMs));
+}
+
+pw::StatusWithSize PicoFlashMemory::Read(Address address,
+                                         pw::span<std::byte> output) {
+  if (!Contains(address, output.size())) {
+    return pw::StatusWithSize::OutOfRange();
+  }
+  std::memcpy(output.data(), FlashAddressToMcuAddress(address), output.size());
+  return pw::StatusWithSize(output.size());
+}
+
+pw::StatusWithSize PicoFlashMemory::Write(Address address,
+                                          pw::span<const std::byte> data) {
+  if (!Contains(address, data.size()) || address % alignment_bytes() != 0 ||
+      data.size() % alignment_bytes() != 0) {
+    return pw::StatusWithSize::InvalidArgument();
+  }
+  ProgramParams params{
+      .offset = address - XIP_BASE, .data = data.data(), .size = data.size()};
+  pw::Status status = ToStatus(
+      flash_safe_execute(DoProgram, &params, kFlashEnterExitTimeoutMs));
+  return pw::StatusWithSize(status, status.ok() ? data.size() : 0);
+}
+
+}  // namespace sense
@@ -0,0 +1,47 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+
+#include "pw_kvs/flash_memory.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
+#include "pw_status/status_with_size.h"
+
+namespace sense {
+
+/// The last sectors of the RP2's onboard flash, for use by `pw_kvs`.
+///
+/// Reads go through the XIP window. Erases and writes run with the other core
+/// and interrupts paused, since code cannot execute from flash meanwhile.
+class PicoFlashMemory : public pw::kvs::FlashMemory {
+ public:
+  explicit PicoFlashMemory(size_t sector_count);
+
+  pw::Status Enable() override { return pw::OkStatus(); }
+  pw::Status Disable() override { return pw::OkStatus(); }
+  bool IsEnabled() const override { return true; }
+
+  pw::Status Erase(Address address, size_t num_sectors) override;
+  pw::StatusWithSize Read(Address address,
+                          pw::span<std::byte> output) override;
+  pw::StatusWithSize Write(Address address,
+                           pw::span<const std::byte> data) override;
+
+ private:
+  bool Contains(Address address, size_t size) const;
+};
+
+}  // namespace sense
@@ -0,0 +1,68 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/pico_gpio_port.h"
+
+#include "hardware/gpio.h"
+#include "pw_assert/check.h"
+
+namespace sense {
+
+using ::pw::digital_io::Polarity;
+
+PicoGpioPort::PicoGpioPort(const Config& config) : config_(config) {
+  const size_t num_pins = config_.pins.size();
+  PW_CHECK_UINT_LE(num_pins, 32u);
+  states_mask_ =
+      num_pins == 32 ? ~uint32_t{0} : (uint32_t{1} << num_pins) - 1;
+
+  bool contiguous = true;
+  for (size_t i = 0; i < num_pins; ++i) {
+    const uint32_t pin = config_.pins[i];
+    PW_CHECK_UINT_LT(pin, NUM_BANK0_GPIOS);
+    contiguous = contiguous && pin == config_.pins[0] + i;
+    if (config_.polarity == Polarity::kActiveLow) {
+      active_low_mask_ |= uint32_t{1} << pin;
+    }
+  }
+  if (contiguous && num_pins > 0) {
+    contiguous_shift_ = static_cast<int>(config_.pins[0]);
+  }
+}
+
+pw::Status PicoGpioPort::DoEnable() {
+  for (const uint32_t pin : config_.pins) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    if (config_.enable_pull_up) {
+      gpio_pull_up(pin);
+    }
+  }
+  return pw::OkStatus();
+}
+
+pw::Result<uint32_t> PicoGpioPort::DoGetStates() {
+  // Inverting the active-low pins makes every set bit an active input.
+  const uint32_t levels = gpio_get_all() ^ active_low_mask_;
+  if (contiguous_shift_ >= 0) {
+    return (levels >> contiguous_shift_) & states_mask_;
+  }
+  uint32_t states = 0;
+  for (size_t i = 0; i < config_.pins.size(); ++i) {
+    states |= ((levels >> config_.pins[i]) & 1u) << i;
+  }
+  return states;
+}
+
+}  // namespace sense
@@ -0,0 +1,54 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "modules/buttons/multi_digital_in.h"
+#include "pw_digital_io/polarity.h"
+#include "pw_result/result.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// GPIO inputs that are all read with a single load of the SIO input register.
+///
+/// Bit `i` of the states is the input on `pins[i]`. When the pins are
+/// consecutive, the states are extracted with one shift and mask.
+class PicoGpioPort final : public MultiDigitalIn {
+ public:
+  struct Config {
+    pw::span<const uint32_t> pins;
+    pw::digital_io::Polarity polarity;
+    bool enable_pull_up;
+  };
+
+  explicit PicoGpioPort(const Config& config);
+
+ private:
+  pw::Status DoEnable() override;
+  pw::Result<uint32_t> DoGetStates() override;
+
+  const Config config_;
+
+  /// Raw levels that read as active, shifted like the pins in `gpio_get_all`.
+  uint32_t active_low_mask_ = 0;
+
+  /// Shift of the first pin, or -1 if the pins are not consecutive.
+  int contiguous_shift_ = -1;
+  uint32_t states_mask_ = 0;
+};
+
+}  // namespace sense
@@ -17,17 +17,20 @@
 #include "device/pico_pwm_gpio.h"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <limits>
 
 #include "hardware/irq.h"
+#include "modules/log_policy/deferred_log.h"
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "pw_log/log.h"
 
 namespace sense {
 
-PicoPwmGpio::PicoPwmGpio(const GpioConfig& config) : gpio_config_(config) {
+PicoPwmGpio::PicoPwmGpio(const GpioConfig& config)
+    : PwmDigitalOut(&kBatchId), gpio_config_(config) {
   slice_num_ = pwm_gpio_to_slice_num(gpio_config_.pin);
   pwm_config_ = pwm_get_default_config();
 }
@@ -48,14 +51,49 @@ void PicoPwmGpio::DoDisable() {
   gpio_deinit(gpio_config_.pin);
 }
 
+uint16_t PicoPwmGpio::ToCompareLevel(uint16_t level) const {
+  return gpio_config_.polarity == pw::digital_io::Polarity::kActiveLow
+             ? std::numeric_limits<uint16_t>::max() - level
+             : level;
+}
+
 void PicoPwmGpio::DoSetLevel(uint16_t level) {
   pwm_clear_irq(slice_num_);
-  level_ = gpio_config_.polarity == pw::digital_io::Polarity::kActiveLow
-               ? std::numeric_limits<uint16_t>::max() - level
-               : level;
+  level_ = ToCompareLevel(level);
   pwm_set_gpio_level(gpio_config_.pin, level_);
 }
 
+void PicoPwmGpio::DoSetLevels(pw::span<const LevelUpdate> updates) {
+  // Both channels of a slice share a double-buffered compare register, which
+  // latches at the end of the PWM period. Writing it once per slice changes
+  // the channels together.
+  std::array<bool, NUM_PWM_SLICES> written{};
+  for (size_t i = 0; i < updates.size(); ++i) {
+    auto& first = static_cast<PicoPwmGpio&>(*updates[i].output);
+    if (written[first.slice_num_]) {
+      continue;
+    }
+    written[first.slice_num_] = true;
+
+    uint32_t compare = pwm_hw->slice[first.slice_num_].cc;
+    for (size_t j = i; j < updates.size(); ++j) {
+      auto& gpio = static_cast<PicoPwmGpio&>(*updates[j].output);
+      if (gpio.slice_num_ != first.slice_num_) {
+        continue;
+      }
+      gpio.level_ = gpio.ToCompareLevel(updates[j].level);
+      const unsigned shift =
+          pwm_gpio_to_channel(gpio.gpio_config_.pin) == PWM_CHAN_B
+              ? PWM_CH0_CC_B_LSB
+              : PWM_CH0_CC_A_LSB;
+      compare = (compare & ~(uint32_t{0xffff} << shift)) |
+                uint32_t{gpio.level_} << shift;
+    }
+    pwm_clear_irq(first.slice_num_);
+    pwm_hw->slice[first.slice_num_].cc = compare;
+  }
+}
+
 void PicoPwmGpio::DoSetCallback(uint16_t per_interval,
                                 pw::chrono::SystemClock::duration interval) {
   if (gpio_with_callback != nullptr) {
@@ -76,7 +114,9 @@ void PicoPwmGpio::DoSetCallback(uint16_t per_interval,
   float clkdiv = 65536.f / (60.f * freq * per_interval);
   clkdiv = std::min(clkdiv, kClkDivMax);
 
-  PW_LOG_INFO("Pulsing at frequency of %f times per second", freq);
+  SENSE_LOG_DEFERRED(PW_LOG_INFO,
+                     "Pulsing at %u mHz",
+                     static_cast<uint32_t>(freq * 1000.f));
   if (clkdiv < 1.f) {
     uint16_t wrap = std::numeric_limits<uint16_t>::max();
     wrap = static_cast<uint16_t>(clkdiv * wrap);
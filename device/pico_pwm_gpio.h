@@ -20,6 +20,7 @@
 #include "pw_chrono/system_clock.h"
 #include "pw_digital_io_rp2040/digital_io.h"
 #include "pw_function/function.h"
+#include "pw_span/span.h"
 
 namespace sense {
 
@@ -34,6 +35,7 @@ class PicoPwmGpio : public PwmDigitalOut {
   void DoEnable() override;
   void DoDisable() override;
   void DoSetLevel(uint16_t level) override;
+  void DoSetLevels(pw::span<const LevelUpdate> updates) override;
   void DoSetCallback(uint16_t per_interval,
                      pw::chrono::SystemClock::duration interval_ms) override;
   void DoClearCallback() override;
@@ -43,6 +45,11 @@ class PicoPwmGpio : public PwmDigitalOut {
 
   static void IrqHandler();
 
+  /// Applies the output's polarity to a level.
+  uint16_t ToCompareLevel(uint16_t level) const;
+
+  static constexpr char kBatchId = 0;
+
   static PicoPwmGpio* gpio_with_callback;
 
   uint16_t slice_num_;
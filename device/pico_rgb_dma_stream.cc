@@ -0,0 +1,173 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "device/pico_rgb_dma_stream.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pwm.h"
+#include "pw_assert/check.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+PicoRgbDmaStream::PicoRgbDmaStream(const GpioConfig& red,
+                                   const GpioConfig& green,
+                                   const GpioConfig& blue,
+                                   unsigned pacing_slice)
+    : outputs_{red, green, blue}, pacing_slice_(pacing_slice) {
+  // Each slice's compare register holds the levels of both of its channels,
+  // so outputs sharing a slice share a DMA channel.
+  for (size_t output = 0; output < kNumOutputs; ++output) {
+    const unsigned index = pwm_gpio_to_slice_num(outputs_[output].pin);
+    PW_CHECK_UINT_NE(index, pacing_slice_, "LED pins use the pacing slice");
+    size_t slice = 0;
+    while (slice < num_slices_ && slices_[slice].index != index) {
+      ++slice;
+    }
+    if (slice == num_slices_) {
+      slices_[num_slices_++].index = index;
+    }
+    output_slices_[output] = slice;
+  }
+}
+
+void PicoRgbDmaStream::ClaimChannels() {
+  for (size_t i = 0; i < num_slices_; ++i) {
+    Slice& slice = slices_[i];
+    if (slice.data_channel < 0) {
+      slice.data_channel = dma_claim_unused_channel(true);
+      slice.rewind_channel = dma_claim_unused_channel(true);
+    }
+  }
+}
+
+uint16_t PicoRgbDmaStream::Level(size_t output,
+                                 const LedAnimation::Levels& levels) const {
+  uint16_t level = output == 0 ? levels.red
+                   : output == 1 ? levels.green
+                                 : levels.blue;
+  if (outputs_[output].polarity == pw::digital_io::Polarity::kActiveLow) {
+    level = std::numeric_limits<uint16_t>::max() - level;
+  }
+  return level;
+}
+
+pw::Status PicoRgbDmaStream::ConfigurePacing(uint32_t step_ms) const {
+  // The slice counts (wrap + 1) * clkdiv system clock cycles per step.
+  constexpr uint32_t kMaxDivider = 255;
+  constexpr uint32_t kMaxCount = std::numeric_limits<uint16_t>::max() + 1u;
+  const uint64_t cycles = uint64_t{clock_get_hz(clk_sys)} * step_ms / 1000;
+  const uint64_t divider =
+      std::max<uint64_t>((cycles + kMaxCount - 1) / kMaxCount, 1);
+  if (divider > kMaxDivider) {
+    return pw::Status::OutOfRange();
+  }
+  pwm_config config = pwm_get_default_config();
+  pwm_config_set_clkdiv_int(&config, static_cast<uint32_t>(divider));
+  pwm_config_set_wrap(&config, static_cast<uint16_t>(cycles / divider - 1));
+  pwm_init(pacing_slice_, &config, false);
+  return pw::OkStatus();
+}
+
+pw::Status PicoRgbDmaStream::DoStart(pw::span<const LedAnimation::Levels> steps,
+                                     uint32_t step_ms,
+                                     bool repeat) {
+  if (steps.empty() || steps.size() > LedAnimation::kMaxSteps) {
+    return pw::Status::InvalidArgument();
+  }
+  DoStop();
+  PW_TRY(ConfigurePacing(step_ms));
+  ClaimChannels();
+
+  // Start from the current compare values, so that channels that are not
+  // part of the LED keep their levels.
+  for (size_t i = 0; i < num_slices_; ++i) {
+    Slice& slice = slices_[i];
+    const uint32_t current = pwm_hw->slice[slice.index].cc;
+    for (size_t step = 0; step < steps.size(); ++step) {
+      slice.words[step] = current;
+    }
+    slice.words_address = slice.words.data();
+  }
+  for (size_t output = 0; output < kNumOutputs; ++output) {
+    Slice& slice = slices_[output_slices_[output]];
+    const unsigned shift =
+        pwm_gpio_to_channel(outputs_[output].pin) == PWM_CHAN_B ? 16 : 0;
+    const uint32_t mask = ~(uint32_t{0xffff} << shift);
+    for (size_t step = 0; step < steps.size(); ++step) {
+      slice.words[step] = (slice.words[step] & mask) |
+                          uint32_t{Level(output, steps[step])} << shift;
+    }
+  }
+
+  uint32_t channel_mask = 0;
+  for (size_t i = 0; i < num_slices_; ++i) {
+    Slice& slice = slices_[i];
+    dma_channel_config data =
+        dma_channel_get_default_config(slice.data_channel);
+    channel_config_set_transfer_data_size(&data, DMA_SIZE_32);
+    channel_config_set_read_increment(&data, true);
+    channel_config_set_write_increment(&data, false);
+    channel_config_set_dreq(&data, pwm_get_dreq(pacing_slice_));
+    if (repeat) {
+      channel_config_set_chain_to(&data, slice.rewind_channel);
+    }
+    dma_channel_configure(slice.data_channel,
+                          &data,
+                          &pwm_hw->slice[slice.index].cc,
+                          slice.words.data(),
+                          steps.size(),
+                          false);
+
+    if (repeat) {
+      // Writing the read address trigger restarts the data channel with its
+      // original transfer count.
+      dma_channel_config rewind =
+          dma_channel_get_default_config(slice.rewind_channel);
+      channel_config_set_transfer_data_size(&rewind, DMA_SIZE_32);
+      channel_config_set_read_increment(&rewind, false);
+      channel_config_set_write_increment(&rewind, false);
+      dma_channel_configure(slice.rewind_channel,
+                            &rewind,
+                            &dma_hw->ch[slice.data_channel].al3_read_addr_trig,
+                            &slice.words_address,
+                            1,
+                            false);
+    }
+    channel_mask |= 1u << slice.data_channel;
+  }
+
+  dma_start_channel_mask(channel_mask);
+  pwm_set_enabled(pacing_slice_, true);
+  running_ = true;
+  return pw::OkStatus();
+}
+
+void PicoRgbDmaStream::DoStop() {
+  if (!running_) {
+    return;
+  }
+  pwm_set_enabled(pacing_slice_, false);
+  for (size_t i = 0; i < num_slices_; ++i) {
+    // Abort the rewind channel first, so it cannot restart the data channel.
+    dma_channel_abort(slices_[i].rewind_channel);
+    dma_channel_abort(slices_[i].data_channel);
+  }
+  running_ = false;
+}
+
+}  // namespace sense
@@ -0,0 +1,84 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/led/led_animation.h"
+#include "modules/led/rgb_level_stream.h"
+#include "pw_digital_io_rp2040/digital_io.h"
+
+namespace sense {
+
+/// Streams RGB LED levels into the PWM compare registers with DMA.
+///
+/// Each PWM slice driving the LED gets a DMA channel, which writes one
+/// precomputed compare value per step. Transfers are paced by the wrap DREQ
+/// of an otherwise unused "pacing" slice that only counts time, so steps take
+/// no CPU time or interrupts. Repeating animations use a second channel per
+/// slice to rewind the first.
+class PicoRgbDmaStream final : public RgbLevelStream {
+ public:
+  using GpioConfig = ::pw::digital_io::Rp2040Config;
+
+  /// `pacing_slice` must not drive any outputs. The GPIO configs must match
+  /// those of the LED's `PicoPwmGpio`s.
+  PicoRgbDmaStream(const GpioConfig& red,
+                   const GpioConfig& green,
+                   const GpioConfig& blue,
+                   unsigned pacing_slice);
+
+ private:
+  static constexpr size_t kNumOutputs = 3;
+
+  /// A PWM slice driving at least one of the outputs.
+  struct Slice {
+    unsigned index = 0;
+    int data_channel = -1;
+    int rewind_channel = -1;
+
+    /// Compare register values, holding the levels of both channels.
+    std::array<uint32_t, LedAnimation::kMaxSteps> words;
+
+    /// Start of `words`, which the rewind channel copies to the data channel.
+    const uint32_t* words_address = nullptr;
+  };
+
+  pw::Status DoStart(pw::span<const LedAnimation::Levels> steps,
+                     uint32_t step_ms,
+                     bool repeat) override;
+
+  void DoStop() override;
+
+  /// Claims DMA channels for each slice on first use.
+  void ClaimChannels();
+
+  /// Sets the pacing slice's wrap period to `step_ms`.
+  pw::Status ConfigurePacing(uint32_t step_ms) const;
+
+  uint16_t Level(size_t output, const LedAnimation::Levels& levels) const;
+
+  const std::array<GpioConfig, kNumOutputs> outputs_;
+  const unsigned pacing_slice_;
+  std::array<Slice, kNumOutputs> slices_;
+  size_t num_slices_ = 0;
+
+  /// Index into `slices_` of each output's slice.
+  std::array<size_t, kNumOutputs> output_slices_;
+  bool running_ = false;
+};
+
+}  // namespace sense
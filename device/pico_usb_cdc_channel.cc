@@ -0,0 +1,164 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "device/pico_usb_cdc_channel.h"
+
+#include <mutex>
+
+#include "pico/stdio.h"
+#include "pw_assert/check.h"
+#include "tusb.h"
+
+namespace sense {
+
+using ::pw::Result;
+using ::pw::Status;
+using ::pw::async2::Context;
+using ::pw::async2::Pending;
+using ::pw::async2::Poll;
+using ::pw::async2::Ready;
+using ::pw::async2::WaitReason;
+using ::pw::multibuf::MultiBuf;
+
+PicoUsbCdcChannel* PicoUsbCdcChannel::instance_ = nullptr;
+
+PicoUsbCdcChannel::PicoUsbCdcChannel(pw::multibuf::MultiBufAllocator& allocator,
+                                     const Config& config)
+    : allocator_(allocator), config_(config) {
+  PW_CHECK_UINT_LE(config_.min_read_size, config_.max_read_size);
+}
+
+void PicoUsbCdcChannel::Enable() {
+  PW_CHECK(instance_ == nullptr, "USB CDC channel already enabled");
+  instance_ = this;
+  stdio_set_chars_available_callback(&PicoUsbCdcChannel::OnCharsAvailable,
+                                     this);
+}
+
+void PicoUsbCdcChannel::OnCharsAvailable(void* channel) {
+  auto& self = *static_cast<PicoUsbCdcChannel*>(channel);
+  std::lock_guard lock(self.lock_);
+  std::move(self.read_waker_).Wake();
+}
+
+void PicoUsbCdcChannel::OnTxComplete() {
+  if (instance_ == nullptr) {
+    return;
+  }
+  std::lock_guard lock(instance_->lock_);
+  std::move(instance_->write_waker_).Wake();
+}
+
+Poll<Result<MultiBuf>> PicoUsbCdcChannel::DoPendRead(Context& cx) {
+  // Allocate ahead of the data, so the next buffer is usually ready by the
+  // time the host sends more.
+  if (!read_buffer_.has_value()) {
+    if (!read_allocation_.has_value()) {
+      read_allocation_.emplace(allocator_.AllocateContiguousAsync(
+          config_.min_read_size, config_.max_read_size));
+    }
+    Poll<std::optional<MultiBuf>> allocation = read_allocation_->Pend(cx);
+    if (allocation.IsPending()) {
+      return Pending();
+    }
+    read_allocation_.reset();
+    if (!allocation->has_value()) {
+      return Ready(Result<MultiBuf>(Status::ResourceExhausted()));
+    }
+    read_buffer_ = std::move(**allocation);
+  }
+
+  std::optional<pw::ByteSpan> span = read_buffer_->ContiguousSpan();
+  PW_CHECK(span.has_value());
+  size_t read = 0;
+  {
+    std::lock_guard lock(lock_);
+    read = tud_cdc_read(span->data(), span->size());
+    if (read == 0) {
+      read_waker_ = cx.GetWaker(WaitReason::Unspecified());
+      return Pending();
+    }
+  }
+  read_buffer_->Truncate(read);
+  MultiBuf buffer = std::move(*read_buffer_);
+  read_buffer_.reset();
+  return Ready(Result<MultiBuf>(std::move(buffer)));
+}
+
+Poll<Status> PicoUsbCdcChannel::DoPendReadyToWrite(Context& cx) {
+  return PendWriteDrained(cx);
+}
+
+Status PicoUsbCdcChannel::DoStageWrite(MultiBuf&& data) {
+  std::lock_guard lock(lock_);
+  if (staged_.has_value()) {
+    return Status::FailedPrecondition();
+  }
+  staged_ = std::move(data);
+  staged_offset_ = 0;
+  // Start sending right away rather than waiting for `PendWrite`.
+  PushStagedLocked();
+  return pw::OkStatus();
+}
+
+Poll<Status> PicoUsbCdcChannel::DoPendWrite(Context& cx) {
+  return PendWriteDrained(cx);
+}
+
+Poll<Status> PicoUsbCdcChannel::PendWriteDrained(Context& cx) {
+  std::lock_guard lock(lock_);
+  if (PushStagedLocked()) {
+    return Ready(pw::OkStatus());
+  }
+  write_waker_ = cx.GetWaker(WaitReason::Unspecified());
+  return Pending();
+}
+
+bool PicoUsbCdcChannel::PushStagedLocked() {
+  if (!staged_.has_value()) {
+    return true;
+  }
+  if (!tud_cdc_connected()) {
+    staged_.reset();
+    return true;
+  }
+
+  size_t skip = staged_offset_;
+  for (const pw::multibuf::Chunk& chunk : staged_->Chunks()) {
+    if (skip >= chunk.size()) {
+      skip -= chunk.size();
+      continue;
+    }
+    const size_t remaining = chunk.size() - skip;
+    const size_t written = tud_cdc_write(chunk.data() + skip, remaining);
+    staged_offset_ += written;
+    skip = 0;
+    if (written < remaining) {
+      break;
+    }
+  }
+  tud_cdc_write_flush();
+
+  if (staged_offset_ < staged_->size()) {
+    return false;
+  }
+  staged_.reset();
+  return true;
+}
+
+}  // namespace sense
+
+extern "C" void tud_cdc_tx_complete_cb(uint8_t /* itf */) {
+  sense::PicoUsbCdcChannel::OnTxComplete();
+}
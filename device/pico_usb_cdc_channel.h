@@ -0,0 +1,120 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+#include "pw_async2/context.h"
+#include "pw_async2/poll.h"
+#include "pw_async2/waker.h"
+#include "pw_channel/channel.h"
+#include "pw_multibuf/allocator.h"
+#include "pw_multibuf/multibuf.h"
+#include "pw_result/result.h"
+#include "pw_status/status.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+
+namespace sense {
+
+/// Byte channel that moves multibufs directly through the TinyUSB CDC FIFOs.
+///
+/// The Pico SDK's USB stdio driver still enumerates the device and runs the
+/// TinyUSB task, but bytes no longer go through stdio one character at a
+/// time. A read copies everything waiting in the RX FIFO into one multibuf,
+/// and the buffer for the next read is allocated as soon as the previous one
+/// is handed out. A write copies each chunk of the staged multibuf straight
+/// into the TX FIFO; TinyUSB sends one packet from the FIFO while the next is
+/// queued behind it, and the multibuf goes back to the pool as soon as it has
+/// been copied.
+///
+/// Writes are dropped while no host has the port open, as stdio does, so a
+/// disconnected console never stalls the system.
+class PicoUsbCdcChannel final : public pw::channel::ByteReaderWriter {
+ public:
+  struct Config {
+    /// Smallest read buffer worth waiting for.
+    size_t min_read_size = 64;
+    /// Largest read buffer. Reads are capped at what the RX FIFO holds, so
+    /// larger buffers only help when the host sends in bursts.
+    size_t max_read_size = 512;
+  };
+
+  /// Reads and writes are allocated from `allocator`, whose size sets how
+  /// much data may be in flight at once.
+  explicit PicoUsbCdcChannel(pw::multibuf::MultiBufAllocator& allocator)
+      : PicoUsbCdcChannel(allocator, Config{}) {}
+
+  PicoUsbCdcChannel(pw::multibuf::MultiBufAllocator& allocator,
+                    const Config& config);
+
+  PicoUsbCdcChannel(const PicoUsbCdcChannel&) = delete;
+  PicoUsbCdcChannel& operator=(const PicoUsbCdcChannel&) = delete;
+
+  /// Registers for USB callbacks. Must be called once, after
+  /// `stdio_usb_init`.
+  void Enable();
+
+  /// Called from the TinyUSB task when a CDC IN transfer finishes, which frees
+  /// space in the TX FIFO.
+  static void OnTxComplete();
+
+ private:
+  pw::async2::Poll<pw::Result<pw::multibuf::MultiBuf>> DoPendRead(
+      pw::async2::Context& cx) override;
+
+  pw::async2::Poll<pw::Status> DoPendReadyToWrite(
+      pw::async2::Context& cx) override;
+
+  pw::multibuf::MultiBufAllocator& DoGetWriteAllocator() override {
+    return allocator_;
+  }
+
+  pw::Status DoStageWrite(pw::multibuf::MultiBuf&& data) override;
+
+  pw::async2::Poll<pw::Status> DoPendWrite(pw::async2::Context& cx) override;
+
+  pw::async2::Poll<pw::Status> DoPendClose(pw::async2::Context&) override {
+    return pw::async2::Ready(pw::OkStatus());
+  }
+
+  /// Copies as much of the staged write as fits into the TX FIFO. Returns
+  /// whether all of it has been copied.
+  bool PushStagedLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /// Waits until the staged write has been copied into the TX FIFO.
+  pw::async2::Poll<pw::Status> PendWriteDrained(pw::async2::Context& cx);
+
+  static void OnCharsAvailable(void* channel);
+
+  static PicoUsbCdcChannel* instance_;
+
+  pw::multibuf::MultiBufAllocator& allocator_;
+  const Config config_;
+
+  /// Only touched from `DoPendRead`.
+  std::optional<pw::multibuf::MultiBufAllocationFuture> read_allocation_;
+  std::optional<pw::multibuf::MultiBuf> read_buffer_;
+
+  /// Keeps the TinyUSB task, which runs from an interrupt, out of the FIFOs
+  /// while the channel uses them.
+  pw::sync::InterruptSpinLock lock_;
+  pw::async2::Waker read_waker_ PW_GUARDED_BY(lock_);
+  pw::async2::Waker write_waker_ PW_GUARDED_BY(lock_);
+  std::optional<pw::multibuf::MultiBuf> staged_ PW_GUARDED_BY(lock_);
+  size_t staged_offset_ PW_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace sense
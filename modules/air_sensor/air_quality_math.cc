@@ -0,0 +1,128 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/air_quality_math.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace sense::air_quality {
+namespace {
+
+constexpr uint16_t kMaxScore = 1023;
+constexpr int32_t kAverageOffset = 768;
+
+// log2(1 + i / 64) in Q16.16, for i in [0, 64].
+constexpr std::array<uint32_t, 65> kLog2Table = {
+    0,     1466,  2909,  4331,  5732,  7112,  8473,  9814,  11136, 12440,
+    13727, 14996, 16248, 17484, 18704, 19909, 21098, 22272, 23433, 24579,
+    25711, 26830, 27936, 29029, 30109, 31178, 32234, 33279, 34312, 35334,
+    36346, 37346, 38336, 39316, 40286, 41246, 42196, 43137, 44068, 44990,
+    45904, 46809, 47705, 48593, 49472, 50344, 51207, 52063, 52911, 53751,
+    54584, 55410, 56229, 57040, 57845, 58643, 59434, 60219, 60997, 61769,
+    62534, 63294, 64047, 64794, 65536,
+};
+constexpr int kTableBits = 6;
+
+// Fractional bits kept when converting resistances to integers, so that
+// truncation does not dominate the error for low resistances.
+constexpr int kResistanceFractionBits = 4;
+// The largest float below 2^32, so that clamped scaled resistances always
+// convert to uint32_t. 2^32 - 1 is not representable and rounds up to 2^32.
+constexpr float kMaxScaledResistance = 4294967040.f;
+
+// ln(2) in Q16.16.
+constexpr int64_t kLn2 = 45426;
+
+}  // namespace
+
+float Quality(float gas_resistance, float humidity) {
+  if (gas_resistance < 1.f) {
+    return 0.f;
+  }
+  return std::log(gas_resistance) + kHumidityFactor * humidity;
+}
+
+uint16_t Score(float quality, float mean, float variance) {
+  float score = ((quality - mean) / std::sqrt(variance)) + 3.f;
+  score = std::min(std::max(score * 256.f, 0.f), static_cast<float>(kMaxScore));
+  return static_cast<uint16_t>(score);
+}
+
+int32_t Log2Fixed(uint32_t value) {
+  const int exponent = 31 - __builtin_clz(value);
+  // Left-align the mantissa so the bits below the leading one are a fraction
+  // in Q0.31.
+  const uint32_t fraction = (value << (31 - exponent)) & 0x7fffffff;
+  const uint32_t index = fraction >> (31 - kTableBits);
+  const uint32_t remainder = fraction & ((1u << (31 - kTableBits)) - 1);
+  const uint32_t low = kLog2Table[index];
+  const uint32_t high = kLog2Table[index + 1];
+  // Interpolate with the 16 most significant bits of the remainder.
+  const uint32_t step =
+      ((high - low) * (remainder >> (31 - kTableBits - 16))) >> 16;
+  return (exponent << kFractionBits) + static_cast<int32_t>(low + step);
+}
+
+uint32_t SqrtFixed(uint64_t value) {
+  uint64_t root = 0;
+  uint64_t bit = uint64_t{1} << 62;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return static_cast<uint32_t>(root);
+}
+
+int32_t QualityFixed(float gas_resistance, float humidity) {
+  // Also rejects NaN, which would not survive the clamp below.
+  if (!(gas_resistance >= 1.f)) {
+    return 0;
+  }
+  const auto scaled = static_cast<uint32_t>(
+      std::min(gas_resistance * (1 << kResistanceFractionBits),
+               kMaxScaledResistance));
+  const int32_t log2 =
+      Log2Fixed(scaled) - (kResistanceFractionBits << kFractionBits);
+  const int64_t ln = (int64_t{log2} * kLn2) >> kFractionBits;
+  const auto humidity_term =
+      static_cast<int32_t>(humidity * (kHumidityFactor * kOne));
+  return static_cast<int32_t>(ln) + humidity_term;
+}
+
+uint16_t ScoreFixed(int32_t quality, int32_t mean, float variance) {
+  // Scaling by a power of two is exact, so the only rounding is in the
+  // conversion.
+  const auto variance_q32 = static_cast<uint64_t>(variance * 4294967296.f);
+  const int64_t stddev = std::max<uint32_t>(SqrtFixed(variance_q32), 1);
+  int64_t offset = (int64_t{quality - mean} * 256) / stddev;
+  // Round towards negative infinity, as the float version truncates after
+  // adding the positive offset.
+  if ((int64_t{quality - mean} * 256) % stddev < 0) {
+    --offset;
+  }
+  return static_cast<uint16_t>(
+      std::clamp<int64_t>(offset + kAverageOffset, 0, kMaxScore));
+}
+
+}  // namespace sense::air_quality
@@ -0,0 +1,65 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+/// Whether `AirSensor` scores with integer arithmetic instead of floats.
+/// Defaults to integer math on ARM cores without an FPU, such as the
+/// RP2040's Cortex-M0+, where float logs, roots and divides are slow library
+/// calls.
+#ifndef SENSE_AIR_SENSOR_FIXED_POINT
+#if defined(__arm__) && !defined(__ARM_FP)
+#define SENSE_AIR_SENSOR_FIXED_POINT 1
+#else
+#define SENSE_AIR_SENSOR_FIXED_POINT 0
+#endif  // defined(__arm__) && !defined(__ARM_FP)
+#endif  // SENSE_AIR_SENSOR_FIXED_POINT
+
+namespace sense::air_quality {
+
+inline constexpr bool kFixedPoint = SENSE_AIR_SENSOR_FIXED_POINT != 0;
+
+/// Weight of relative humidity, in percent, in the quality value.
+inline constexpr float kHumidityFactor = 0.04f;
+
+/// Number of fractional bits in fixed-point values.
+inline constexpr int kFractionBits = 16;
+inline constexpr int32_t kOne = int32_t{1} << kFractionBits;
+
+/// Returns the quality value that scores are computed from: the natural log
+/// of the gas resistance plus a humidity term.
+float Quality(float gas_resistance, float humidity);
+
+/// Returns the 10-bit score of a quality value, given the baseline's mean and
+/// variance. The variance must be positive.
+uint16_t Score(float quality, float mean, float variance);
+
+/// Base 2 logarithm of a positive integer, in Q16.16.
+///
+/// Uses a 64-entry table with linear interpolation. The result is within
+/// 1e-4 of the exact value.
+int32_t Log2Fixed(uint32_t value);
+
+/// Floor of the square root.
+uint32_t SqrtFixed(uint64_t value);
+
+/// `Quality` in Q16.16, computed with `Log2Fixed`.
+int32_t QualityFixed(float gas_resistance, float humidity);
+
+/// `Score` with the quality and mean in Q16.16, computed with integer
+/// arithmetic apart from converting the variance.
+uint16_t ScoreFixed(int32_t quality, int32_t mean, float variance);
+
+}  // namespace sense::air_quality
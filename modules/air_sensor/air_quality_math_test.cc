@@ -0,0 +1,91 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/air_quality_math.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense::air_quality {
+namespace {
+
+TEST(AirQualityMathTest, Log2FixedIsAccurate) {
+  EXPECT_EQ(Log2Fixed(1), 0);
+  EXPECT_EQ(Log2Fixed(2), kOne);
+  EXPECT_EQ(Log2Fixed(1024), 10 * kOne);
+  for (uint32_t value = 3; value < 2'000'000; value = value * 5 / 4 + 1) {
+    const float expected = std::log2(static_cast<float>(value));
+    EXPECT_NEAR(static_cast<float>(Log2Fixed(value)) / kOne, expected, 1e-4f);
+  }
+}
+
+TEST(AirQualityMathTest, SqrtFixedRoundsDown) {
+  EXPECT_EQ(SqrtFixed(0), 0u);
+  EXPECT_EQ(SqrtFixed(1), 1u);
+  EXPECT_EQ(SqrtFixed(15), 3u);
+  EXPECT_EQ(SqrtFixed(16), 4u);
+  EXPECT_EQ(SqrtFixed(uint64_t{1} << 40), 1u << 20);
+  EXPECT_EQ(SqrtFixed(123'456'789'012), 351'364u);
+}
+
+TEST(AirQualityMathTest, QualityFixedMatchesFloat) {
+  for (float ohms = 1000.f; ohms < 500'000.f; ohms *= 1.1f) {
+    for (float humidity = 10.f; humidity < 90.f; humidity += 20.f) {
+      EXPECT_NEAR(static_cast<float>(QualityFixed(ohms, humidity)) / kOne,
+                  Quality(ohms, humidity),
+                  2e-4f);
+    }
+  }
+  EXPECT_EQ(QualityFixed(0.5f, 40.f), 0);
+  EXPECT_EQ(QualityFixed(NAN, 40.f), 0);
+}
+
+TEST(AirQualityMathTest, QualityFixedClampsHugeResistances) {
+  // Beyond 2^28 ohms the scaled resistance no longer fits in 32 bits.
+  const int32_t max = QualityFixed(268'435'440.f, 40.f);
+  EXPECT_EQ(QualityFixed(268'435'456.f, 40.f), max);
+  EXPECT_EQ(QualityFixed(1e12f, 40.f), max);
+  EXPECT_EQ(QualityFixed(INFINITY, 40.f), max);
+  EXPECT_NEAR(static_cast<float>(max) / kOne,
+              Quality(268'435'440.f, 40.f),
+              2e-4f);
+}
+
+TEST(AirQualityMathTest, ScoreFixedMatchesFloat) {
+  const float mean = Quality(50'000.f, 40.f);
+  const auto mean_fixed = static_cast<int32_t>(std::lround(mean * kOne));
+  for (float variance : {0.0004f, 0.01f, 0.3f, 2.f}) {
+    for (float ohms = 1000.f; ohms < 500'000.f; ohms *= 1.05f) {
+      for (float humidity = 10.f; humidity < 90.f; humidity += 15.f) {
+        const int expected = Score(Quality(ohms, humidity), mean, variance);
+        const int actual =
+            ScoreFixed(QualityFixed(ohms, humidity), mean_fixed, variance);
+        EXPECT_LE(std::abs(expected - actual), 2)
+            << "ohms=" << ohms << " humidity=" << humidity
+            << " variance=" << variance;
+      }
+    }
+  }
+}
+
+TEST(AirQualityMathTest, ScoreFixedClamps) {
+  EXPECT_EQ(ScoreFixed(-100 * kOne, 0, 1.f), 0u);
+  EXPECT_EQ(ScoreFixed(100 * kOne, 0, 1.f), 1023u);
+  EXPECT_EQ(ScoreFixed(0, 0, 1.f), 768u);
+}
+
+}  // namespace
+}  // namespace sense::air_quality
@@ -14,16 +14,28 @@
 
 #include "modules/air_sensor/air_sensor.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <mutex>
+#include <utility>
 
+#include "modules/air_sensor/air_quality_math.h"
 #include "pw_assert/check.h"
 #include "pw_log/log.h"
 #include "pw_status/try.h"
 
 namespace sense {
+namespace {
 
-static constexpr float kHumidityFactor = 0.04f;
+// Maps an IAQ index onto a score, from 1023 for 0 to 0 for the maximum index.
+uint16_t ScoreFromIaq(uint16_t index) {
+  const uint32_t clamped = std::min(index, IaqModel::kMaxIndex);
+  return static_cast<uint16_t>((IaqModel::kMaxIndex - clamped) *
+                               AirSensor::kMaxScore / IaqModel::kMaxIndex);
+}
+
+}  // namespace
 
 LedValue AirSensor::GetLedValue(uint16_t score) {
   uint8_t red = 0;
@@ -45,29 +57,184 @@ LedValue AirSensor::GetLedValue(uint16_t score) {
   return LedValue(red, green, blue);
 }
 
-float AirSensor::temperature() const {
+AirMeasurement AirSensor::Readings::ToEvent(
+    pw::chrono::SystemClock::time_point timestamp) const {
+  const float clamped_temperature = std::clamp(temperature, -300.f, 300.f);
+  const float clamped_humidity = std::clamp(humidity, 0.f, 100.f);
+  return {
+      .temperature_centi_c =
+          static_cast<int16_t>(std::lround(clamped_temperature * 100.f)),
+      .humidity_centi_percent =
+          static_cast<uint16_t>(std::lround(clamped_humidity * 100.f)),
+      .score = score,
+      .pressure = pressure,
+      .gas_resistance = gas_resistance,
+      .timestamp = timestamp,
+  };
+}
+
+AirSensor::Baseline AirSensor::baseline() const {
   std::lock_guard lock(lock_);
-  return temperature_.value();
+  return BaselineLocked();
 }
 
-float AirSensor::pressure() const {
+AirSensor::Baseline AirSensor::BaselineLocked() const {
+  return {
+      .count = count_.value(),
+      .average = average_.value(),
+      .variance = variance_.value(),
+  };
+}
+
+void AirSensor::UseExponentialBaseline(uint32_t half_life) {
   std::lock_guard lock(lock_);
-  return pressure_.value();
+  estimator_.UseExponential(half_life);
+  PublishBaselineLocked();
 }
 
-float AirSensor::humidity() const {
+void AirSensor::UseWindowedBaseline(pw::span<float> window) {
   std::lock_guard lock(lock_);
-  return humidity_.value();
+  estimator_.UseWindowed(window);
+  PublishBaselineLocked();
 }
 
-float AirSensor::gas_resistance() const {
+void AirSensor::UseIaqModel(const IaqModel::Config& config) {
   std::lock_guard lock(lock_);
-  return gas_resistance_.value();
+  iaq_model_.emplace(config);
+}
+
+void AirSensor::SetBaselineStore(BaselineStore& store,
+                                 uint32_t save_interval,
+                                 Worker& worker) {
+  PW_CHECK_UINT_GT(save_interval, 0);
+  baseline_store_ = &store;
+  save_interval_ = save_interval;
+  save_worker_ = &worker;
+}
+
+pw::Status AirSensor::Init() {
+  if (baseline_store_ != nullptr) {
+    pw::Result<Baseline> baseline = baseline_store_->Load();
+    if (baseline.ok()) {
+      RestoreBaseline(*baseline);
+      PW_LOG_INFO("Restored air quality baseline of %u measurements",
+                  static_cast<unsigned>(baseline->count));
+    } else if (!baseline.status().IsNotFound()) {
+      PW_LOG_WARN("Failed to load air quality baseline: %s",
+                  baseline.status().str());
+    }
+  }
+  return DoInit();
 }
 
-uint16_t AirSensor::score() const {
+void AirSensor::RestoreBaseline(const Baseline& baseline) {
   std::lock_guard lock(lock_);
-  return score_.value();
+  estimator_.Restore(baseline.count, baseline.average, baseline.variance);
+  PublishBaselineLocked();
+}
+
+void AirSensor::SaveBaseline() {
+  // Save the latest baseline, which may include measurements made since the
+  // save was requested.
+  if (pw::Status status = baseline_store_->Save(baseline()); !status.ok()) {
+    PW_LOG_WARN("Failed to save air quality baseline: %s", status.str());
+  }
+}
+
+void AirSensor::PublishBaselineLocked() {
+  count_.Set(estimator_.count());
+  average_.Set(estimator_.mean());
+  variance_.Set(estimator_.variance());
+}
+
+AirSensor::MeasureFuture AirSensor::MeasureAsync() {
+  uint32_t sequence;
+  bool start;
+  size_t slot = 0;
+  {
+    std::lock_guard lock(lock_);
+    while (slot < kMaxMeasureFutures && async_waker_in_use_[slot]) {
+      ++slot;
+    }
+    if (slot == kMaxMeasureFutures) {
+      return MeasureFuture(*this,
+                           0,
+                           MeasureFuture::kNoSlot,
+                           pw::Status::ResourceExhausted());
+    }
+    async_waker_in_use_[slot] = true;
+
+    // Join a measurement in progress rather than replacing it, which would
+    // discard another waiter's heater cycle.
+    start = async_completed_ == async_requested_;
+    if (start) {
+      ++async_requested_;
+    }
+    sequence = async_requested_;
+  }
+  pw::Status status = pw::OkStatus();
+  if (start) {
+    status = DoMeasure([this] { CompleteAsyncMeasurement(); });
+  }
+  return MeasureFuture(*this, sequence, slot, status);
+}
+
+void AirSensor::CompleteAsyncMeasurement() {
+  std::array<pw::async2::Waker, kMaxMeasureFutures> wakers;
+  {
+    std::lock_guard lock(lock_);
+    ++async_completed_;
+    for (size_t i = 0; i < kMaxMeasureFutures; ++i) {
+      wakers[i] = std::move(async_wakers_[i]);
+    }
+  }
+  for (pw::async2::Waker& waker : wakers) {
+    std::move(waker).Wake();
+  }
+}
+
+AirSensor::MeasureFuture& AirSensor::MeasureFuture::operator=(
+    MeasureFuture&& other) {
+  if (this != &other) {
+    Release();
+    air_sensor_ = other.air_sensor_;
+    sequence_ = other.sequence_;
+    slot_ = std::exchange(other.slot_, kNoSlot);
+    status_ = std::exchange(other.status_, pw::Status::FailedPrecondition());
+  }
+  return *this;
+}
+
+void AirSensor::MeasureFuture::Release() {
+  if (slot_ == kNoSlot) {
+    return;
+  }
+  // Destroy the waker outside of the spin lock.
+  pw::async2::Waker waker;
+  {
+    std::lock_guard lock(air_sensor_->lock_);
+    waker = std::move(air_sensor_->async_wakers_[slot_]);
+    air_sensor_->async_waker_in_use_[slot_] = false;
+  }
+  slot_ = kNoSlot;
+}
+
+pw::async2::Poll<pw::Result<uint16_t>> AirSensor::MeasureFuture::Pend(
+    pw::async2::Context& cx) {
+  if (!status_.ok()) {
+    return pw::async2::Ready(status_);
+  }
+  pw::async2::Waker waker = cx.GetWaker(pw::async2::WaitReason::Unspecified());
+  {
+    std::lock_guard lock(air_sensor_->lock_);
+    // Compare as a signed difference so that the sequence numbers may wrap.
+    if (static_cast<int32_t>(air_sensor_->async_completed_ - sequence_) < 0) {
+      // Swap so that any previous waker is destroyed outside of the lock.
+      std::swap(air_sensor_->async_wakers_[slot_], waker);
+      return pw::async2::Pending();
+    }
+  }
+  return pw::async2::Ready(air_sensor_->score());
 }
 
 pw::Result<uint16_t> AirSensor::MeasureSync() {
@@ -81,40 +248,108 @@ void AirSensor::Update(float temperature,
                        float pressure,
                        float humidity,
                        float gas_resistance) {
-  std::lock_guard lock(lock_);
+  const Reading reading = {
+      .temperature = temperature,
+      .pressure = pressure,
+      .humidity = humidity,
+      .gas_resistance = gas_resistance,
+  };
+  UpdateBatch(pw::span(&reading, 1));
+}
+
+void AirSensor::UpdateBatch(pw::span<const Reading> readings) {
+  while (!readings.empty()) {
+    const pw::span<const Reading> batch =
+        readings.first(std::min(readings.size(), kMaxBatchSize));
+    readings = readings.subspan(batch.size());
+
+    // The qualities take most of the time, so compute them before taking the
+    // lock, which masks interrupts.
+    std::array<float, kMaxBatchSize> qualities;
+    int32_t quality_fixed = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if constexpr (air_quality::kFixedPoint) {
+        quality_fixed = air_quality::QualityFixed(batch[i].gas_resistance,
+                                                  batch[i].humidity);
+        qualities[i] =
+            static_cast<float>(quality_fixed) * (1.f / air_quality::kOne);
+      } else {
+        qualities[i] =
+            air_quality::Quality(batch[i].gas_resistance, batch[i].humidity);
+      }
+    }
+
+    {
+      std::lock_guard lock(lock_);
+      const uint32_t saves_before =
+          baseline_store_ == nullptr ? 0 : count_.value() / save_interval_;
+      UpdateLocked(
+          batch, pw::span(qualities).first(batch.size()), quality_fixed);
+      if (baseline_store_ == nullptr ||
+          count_.value() / save_interval_ == saves_before) {
+        continue;
+      }
+    }
+
+    // Flash writes are slow and may run here from a timer callback, so the
+    // save is deferred. A save still pending covers this one too.
+    save_baseline_.Post(*save_worker_);
+  }
+}
+
+void AirSensor::UpdateLocked(pw::span<const Reading> readings,
+                             pw::span<const float> qualities,
+                             int32_t last_quality_fixed) {
   // Record the sensor data.
-  temperature_.Set(temperature);
-  pressure_.Set(pressure);
-  humidity_.Set(humidity);
-  gas_resistance_.Set(gas_resistance);
+  const Reading& last = readings.back();
+  temperature_.Set(last.temperature);
+  pressure_.Set(last.pressure);
+  humidity_.Set(last.humidity);
+  gas_resistance_.Set(last.gas_resistance);
 
   // Update the aggregate air qualities values.
-  count_.Increment();
-  float average = average_.value();
-  float quality = gas_resistance < 1.f
-                      ? 0.f
-                      : (std::log(gas_resistance) + kHumidityFactor * humidity);
-  float delta = quality - average;
-  average += delta / count_.value();
-  float sum_of_squares =
-      sum_of_squares_.value() + (delta * (quality - average));
-  average_.Set(average);
+  const float quality = qualities.back();
+  estimator_.AddAll(qualities);
   quality_.Set(quality);
-  sum_of_squares_.Set(sum_of_squares);
+  PublishBaselineLocked();
 
   // Calculate the air quality score.
-  size_t count = count_.value();
-  if (count < 2) {
-    return;
-  }
-  float stddev = std::sqrt(sum_of_squares / (count - 1));
-  if (stddev == 0.f) {
+  const float average = average_.value();
+  const float variance = variance_.value();
+  if (estimator_.count() < 2) {
+    // Keep the previous score.
+  } else if (variance <= 0.f) {
     score_.Set(kAverageScore);
-    return;
+  } else if constexpr (air_quality::kFixedPoint) {
+    const auto average_fixed =
+        static_cast<int32_t>(average * static_cast<float>(air_quality::kOne));
+    score_.Set(
+        air_quality::ScoreFixed(last_quality_fixed, average_fixed, variance));
+  } else {
+    score_.Set(air_quality::Score(quality, average, variance));
   }
-  float score = ((quality - average) / stddev) + 3.f;
-  score = std::min(std::max(score * 256.f, 0.f), static_cast<float>(kMaxScore));
-  score_.Set(static_cast<uint32_t>(score));
+
+  // The model is cheap next to the qualities, so it runs under the lock.
+  std::optional<IaqEstimate> iaq;
+  if (iaq_model_.has_value()) {
+    for (const float q : qualities) {
+      iaq = iaq_model_->Update(q);
+    }
+    score_.Set(ScoreFromIaq(iaq->index));
+  }
+
+  measurements_since_init_ += static_cast<uint32_t>(readings.size());
+  readings_.Store({
+      .temperature = last.temperature,
+      .pressure = last.pressure,
+      .humidity = last.humidity,
+      .gas_resistance = last.gas_resistance,
+      .score = static_cast<uint16_t>(score_.value()),
+      .warming_up = iaq.has_value()
+                        ? iaq->accuracy == IaqAccuracy::kStabilizing
+                        : measurements_since_init_ <= kWarmUpMeasurements,
+      .iaq = iaq,
+  });
 }
 
 }  // namespace sense
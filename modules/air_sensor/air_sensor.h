@@ -13,9 +13,24 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "modules/air_sensor/baseline_estimator.h"
+#include "modules/air_sensor/iaq_model.h"
 #include "modules/pubsub/pubsub_events.h"
+#include "modules/seqlock/seqlock.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_async2/dispatcher.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_function/function.h"
 #include "pw_metric/metric.h"
 #include "pw_result/result.h"
+#include "pw_span/span.h"
 #include "pw_status/status.h"
 #include "pw_sync/interrupt_spin_lock.h"
 #include "pw_sync/lock_annotations.h"
@@ -25,6 +40,12 @@ namespace sense {
 
 class AirSensor {
  public:
+  /// Invoked once when a requested measurement completes, fails or is
+  /// replaced by a newer request.
+  using MeasureCallback = pw::Function<void()>;
+
+  class MeasureFuture;
+
   // Default starting values representing decent air quality.
   static constexpr float kDefaultTemperature = 20.f;
   static constexpr float kDefaultPressure = 100.f;
@@ -54,31 +75,122 @@ class AirSensor {
   static constexpr uint16_t kMaxScore = static_cast<uint16_t>(Score::kBlue);
   static constexpr uint16_t kAverageScore = static_cast<uint16_t>(Score::kCyan);
 
+  /// Number of `MeasureFuture`s that may exist at once, e.g. one for the
+  /// sampler and one for each RPC service that measures on demand.
+  static constexpr size_t kMaxMeasureFutures = 4;
+
   /// Get the RGB values corresponding to an air quality score.
   static LedValue GetLedValue(uint16_t score);
   static LedValue GetLedValue(Score score) {
     return GetLedValue(static_cast<uint16_t>(score));
   }
 
+  /// Running statistics of the air quality, from which scores are derived.
+  struct Baseline {
+    uint32_t count = 0;
+    float average = 0.f;
+    float variance = 0.f;
+  };
+
+  /// Persistent storage for the baseline, so that scores are meaningful
+  /// right after a reboot.
+  class BaselineStore {
+   public:
+    virtual ~BaselineStore() = default;
+
+    /// Returns the most recently saved baseline, or NOT_FOUND if there is
+    /// none.
+    virtual pw::Result<Baseline> Load() = 0;
+
+    /// Replaces the saved baseline.
+    virtual pw::Status Save(const Baseline& baseline) = 0;
+  };
+
+  /// Measurements after `Init` that are flagged as warming up, while the
+  /// heater and the score settle.
+  static constexpr uint32_t kWarmUpMeasurements = 10;
+
+  /// Raw results of one measurement, for `UpdateBatch`.
+  struct Reading {
+    float temperature = kDefaultTemperature;
+    float pressure = kDefaultPressure;
+    float humidity = kDefaultHumidity;
+    float gas_resistance = kDefaultGasResistance;
+  };
+
+  /// Readings that `UpdateBatch` records under a single lock.
+  static constexpr size_t kMaxBatchSize = 16;
+
+  /// The readings of one measurement and the score derived from them.
+  struct Readings {
+    float temperature = kDefaultTemperature;
+    float pressure = kDefaultPressure;
+    float humidity = kDefaultHumidity;
+    float gas_resistance = kDefaultGasResistance;
+    uint16_t score = kAverageScore;
+
+    /// Whether this is one of the first `kWarmUpMeasurements` since `Init`,
+    /// or with an `IaqModel`, whether the model is still stabilizing.
+    bool warming_up = true;
+
+    /// The model's estimate, when scoring with an `IaqModel`.
+    std::optional<IaqEstimate> iaq;
+
+    /// Returns the readings as a PubSub event.
+    AirMeasurement ToEvent(pw::chrono::SystemClock::time_point timestamp) const;
+  };
+
   virtual ~AirSensor() = default;
 
+  /// Returns the most recent readings, all from the same measurement.
+  ///
+  /// Does not take a lock or disable interrupts, so it is safe to call from
+  /// any context.
+  Readings Snapshot() const { return readings_.Load(); }
+
   /// Returns the most recent temperature reading.
-  float temperature() const PW_LOCKS_EXCLUDED(lock_);
+  float temperature() const { return Snapshot().temperature; }
 
   /// Returns the most recent barometric pressure reading.
-  float pressure() const PW_LOCKS_EXCLUDED(lock_);
+  float pressure() const { return Snapshot().pressure; }
 
   /// Returns the most recent relative humidity reading.
-  float humidity() const PW_LOCKS_EXCLUDED(lock_);
+  float humidity() const { return Snapshot().humidity; }
 
   /// Returns the most recent gas resistance reading.
-  float gas_resistance() const PW_LOCKS_EXCLUDED(lock_);
+  float gas_resistance() const { return Snapshot().gas_resistance; }
 
   /// Returns a 10-bit air quality score from 0 (terrible) to 1023 (excellent).
-  uint16_t score() const PW_LOCKS_EXCLUDED(lock_);
+  uint16_t score() const { return Snapshot().score; }
+
+  /// Returns the statistics the score is currently computed from.
+  Baseline baseline() const PW_LOCKS_EXCLUDED(lock_);
+
+  /// Weights measurements in the baseline by age, halving their weight every
+  /// `half_life` measurements. By default, every measurement since boot is
+  /// weighted equally.
+  void UseExponentialBaseline(uint32_t half_life) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Computes the baseline over only the most recent measurements, which are
+  /// kept in `window`.
+  void UseWindowedBaseline(pw::span<float> window) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Scores air quality with an `IaqModel` instead of the baseline's z-score.
+  /// The sensor must then be measured every `config.sample_interval`; any
+  /// measurement requested in between counts as a scheduled one. Must be
+  /// called before `Init`.
+  void UseIaqModel(const IaqModel::Config& config) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Restores the baseline from `store` when initialized, and saves it back
+  /// after every `save_interval` measurements. Saves run on `worker`, since
+  /// measurements may complete in a timer callback and flash writes are slow.
+  /// Must be called before `Init`.
+  void SetBaselineStore(BaselineStore& store,
+                        uint32_t save_interval,
+                        Worker& worker);
 
   /// Sets up the sensor.
-  pw::Status Init() { return DoInit(); }
+  pw::Status Init();
 
   /// Requests an air measurement.
   ///
@@ -86,9 +198,20 @@ class AirSensor {
   /// given notification will be released.
   pw::Status Measure(pw::sync::ThreadNotification& notification)
       PW_LOCKS_EXCLUDED(lock_) {
-    return DoMeasure(notification);
+    return DoMeasure([&notification] { notification.release(); });
   }
 
+  /// Requests an air measurement and returns a future that resolves to the
+  /// resulting score, so that a coroutine can wait for it without blocking
+  /// its dispatcher.
+  ///
+  /// A request made while another async measurement is in progress shares
+  /// it rather than restarting the sensor, so several tasks may wait at once.
+  /// If `Measure` replaces the measurement, its futures resolve with the
+  /// readings current at that time. Fails with RESOURCE_EXHAUSTED if
+  /// `kMaxMeasureFutures` futures already exist.
+  MeasureFuture MeasureAsync() PW_LOCKS_EXCLUDED(lock_);
+
   /// Like `Measure`, but runs synchronously and returns the same score as
   /// `GetScore`.
   pw::Result<uint16_t> MeasureSync() PW_LOCKS_EXCLUDED(lock_);
@@ -105,17 +228,69 @@ class AirSensor {
               float humidity,
               float gas_resistance) PW_LOCKS_EXCLUDED(lock_);
 
+  /// Records the results of several measurements, oldest first, e.g. from a
+  /// sensor FIFO. The baseline and metrics are updated once per
+  /// `kMaxBatchSize` readings, and the snapshot and score only reflect the
+  /// last of them.
+  void UpdateBatch(pw::span<const Reading> readings) PW_LOCKS_EXCLUDED(lock_);
+
  private:
   /// @copydoc `AirSensor::Init`.
   ///
   /// By default, does nothing.
   virtual pw::Status DoInit() { return pw::OkStatus(); }
 
-  /// @copydoc `AirSensor::Measure`.
-  virtual pw::Status DoMeasure(pw::sync::ThreadNotification& notification)
+  /// Starts a measurement, calling `Update` with its results and then
+  /// `on_complete`. `on_complete` must be called exactly once, including when
+  /// starting fails or a newer request replaces this one, and may be called
+  /// from interrupt context.
+  virtual pw::Status DoMeasure(MeasureCallback&& on_complete)
       PW_LOCKS_EXCLUDED(lock_) = 0;
 
+  /// Records that a measurement requested by `MeasureAsync` has completed.
+  void CompleteAsyncMeasurement() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Restores the baseline statistics, e.g. from a `BaselineStore`.
+  void RestoreBaseline(const Baseline& baseline) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Writes the current baseline to the `BaselineStore`. Runs on the save
+  /// worker.
+  void SaveBaseline() PW_LOCKS_EXCLUDED(lock_);
+
+  Baseline BaselineLocked() const PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Copies the estimator's state into the metrics.
+  void PublishBaselineLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Records `readings`, whose air qualities were computed beforehand.
+  // `last_quality_fixed` is the fixed-point quality of the last reading.
+  void UpdateLocked(pw::span<const Reading> readings,
+                    pw::span<const float> qualities,
+                    int32_t last_quality_fixed)
+      PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  BaselineStore* baseline_store_ = nullptr;
+  uint32_t save_interval_ = 0;
+  Worker* save_worker_ = nullptr;
+  WorkItem save_baseline_{[this] { SaveBaseline(); }};
+
   mutable pw::sync::InterruptSpinLock lock_;
+  BaselineEstimator estimator_ PW_GUARDED_BY(lock_);
+  uint32_t measurements_since_init_ PW_GUARDED_BY(lock_) = 0;
+  std::optional<IaqModel> iaq_model_ PW_GUARDED_BY(lock_);
+
+  // Written under `lock_`, read without it.
+  SeqLock<Readings> readings_;
+
+  // Sequence numbers of async measurements, which complete in order.
+  uint32_t async_requested_ PW_GUARDED_BY(lock_) = 0;
+  uint32_t async_completed_ PW_GUARDED_BY(lock_) = 0;
+
+  // One waker per live `MeasureFuture`, so waiters do not replace each other.
+  std::array<pw::async2::Waker, kMaxMeasureFutures> async_wakers_
+      PW_GUARDED_BY(lock_);
+  std::array<bool, kMaxMeasureFutures> async_waker_in_use_
+      PW_GUARDED_BY(lock_) = {};
 
   // Thread safety: metric values should be atomic.
   //
@@ -134,8 +309,46 @@ class AirSensor {
   PW_METRIC(metrics_, count_, "number of measurements", 0u);
   PW_METRIC(metrics_, quality_, "current air quality", 0.f);
   PW_METRIC(metrics_, average_, "average air quality", 0.f);
-  PW_METRIC(metrics_, sum_of_squares_, "aggregate air quality variance", 0.f);
+  PW_METRIC(metrics_, variance_, "air quality variance", 0.f);
   PW_METRIC(metrics_, score_, "air quality score", kAverageScore);
 };
 
+/// Future returned by `AirSensor::MeasureAsync`.
+class AirSensor::MeasureFuture {
+ public:
+  MeasureFuture(const MeasureFuture&) = delete;
+  MeasureFuture& operator=(const MeasureFuture&) = delete;
+
+  MeasureFuture(MeasureFuture&& other) { *this = std::move(other); }
+  MeasureFuture& operator=(MeasureFuture&& other);
+
+  ~MeasureFuture() { Release(); }
+
+  /// Resolves to the air quality score once the measurement completes, or to
+  /// the error that prevented it from starting.
+  pw::async2::Poll<pw::Result<uint16_t>> Pend(pw::async2::Context& cx);
+
+ private:
+  friend class AirSensor;
+
+  static constexpr size_t kNoSlot = kMaxMeasureFutures;
+
+  MeasureFuture(AirSensor& air_sensor,
+                uint32_t sequence,
+                size_t slot,
+                pw::Status status)
+      : air_sensor_(&air_sensor),
+        sequence_(sequence),
+        slot_(slot),
+        status_(status) {}
+
+  /// Frees this future's waker slot.
+  void Release();
+
+  AirSensor* air_sensor_ = nullptr;
+  uint32_t sequence_ = 0;
+  size_t slot_ = kNoSlot;
+  pw::Status status_ = pw::Status::FailedPrecondition();
+};
+
 }  // namespace sense
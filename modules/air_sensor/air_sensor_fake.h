@@ -14,9 +14,14 @@
 #pragma once
 
 #include "modules/air_sensor/air_sensor.h"
+#include <mutex>
+#include <utility>
+
 #include "pw_assert/assert.h"
+#include "pw_span/span.h"
 #include "pw_status/status.h"
-#include "pw_sync/thread_notification.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
 
 namespace sense {
 
@@ -32,25 +37,34 @@ class AirSensorFake : public AirSensor {
     gas_resistance_ = gas_resistance;
   }
 
+  /// Records several measurements at once, without completing a request.
+  void PublishBatch(pw::span<const Reading> readings) {
+    UpdateBatch(readings);
+  }
+
   void Publish() {
     Update(temperature_, pressure_, humidity_, gas_resistance_);
+    MeasureCallback on_complete;
     {
       std::lock_guard lock(lock_);
-      PW_ASSERT(notification_ != nullptr);
-      notification_->release();
-      notification_ = nullptr;
+      PW_ASSERT(on_complete_ != nullptr);
+      on_complete = std::exchange(on_complete_, nullptr);
     }
+    on_complete();
   }
 
  private:
-  pw::Status DoMeasure(pw::sync::ThreadNotification& notification) override {
+  pw::Status DoMeasure(MeasureCallback&& on_complete) override {
+    MeasureCallback replaced;
     {
       std::lock_guard lock(lock_);
-      notification_ = &notification;
+      replaced = std::exchange(on_complete_, std::move(on_complete));
+    }
+    if (replaced != nullptr) {
+      replaced();
     }
     if (autopublish_) {
       Publish();
-    } else {
     }
     return pw::OkStatus();
   }
@@ -61,7 +75,7 @@ class AirSensorFake : public AirSensor {
   float humidity_ = AirSensor::kDefaultHumidity;
   float gas_resistance_ = AirSensor::kDefaultGasResistance;
   pw::sync::InterruptSpinLock lock_;
-  pw::sync::ThreadNotification* notification_ PW_GUARDED_BY(lock_) = nullptr;
+  MeasureCallback on_complete_ PW_GUARDED_BY(lock_);
 };
 
 }  // namespace sense
@@ -14,7 +14,12 @@
 
 #include "modules/air_sensor/air_sensor.h"
 
+#include <array>
+#include <optional>
+
 #include "modules/air_sensor/air_sensor_fake.h"
+#include "pw_async2/dispatcher.h"
+#include "pw_async2/pend_func_task.h"
 #include "pw_sync/timed_thread_notification.h"
 #include "pw_thread/test_thread_context.h"
 #include "pw_thread/thread.h"
@@ -45,7 +50,28 @@ class AirSensorTest : public ::testing::Test {
     }
   }
 
+  // Pends `future` until the dispatcher stalls, and returns its result if it
+  // resolved.
+  std::optional<pw::Result<uint16_t>> PendUntilStalled(
+      AirSensor::MeasureFuture& future) {
+    std::optional<pw::Result<uint16_t>> result;
+    pw::async2::PendFuncTask task(
+        [&](pw::async2::Context& cx) -> pw::async2::Poll<> {
+          pw::async2::Poll<pw::Result<uint16_t>> poll = future.Pend(cx);
+          if (poll.IsPending()) {
+            return pw::async2::Pending();
+          }
+          result = *poll;
+          return pw::async2::Ready();
+        });
+    dispatcher_.Post(task);
+    dispatcher_.RunUntilStalled().IgnorePoll();
+    task.Deregister();
+    return result;
+  }
+
   AirSensorFake air_sensor_;
+  pw::async2::Dispatcher dispatcher_;
   pw::sync::TimedThreadNotification request_;
   pw::sync::TimedThreadNotification response_;
 };
@@ -56,6 +82,60 @@ TEST_F(AirSensorTest, GetScoreBeforeMeasuring) {
   EXPECT_EQ(air_sensor_.score(), AirSensor::kAverageScore);
 }
 
+TEST_F(AirSensorTest, SnapshotHasLatestReadings) {
+  air_sensor_.set_temperature(25.f);
+  air_sensor_.set_pressure(98.f);
+  air_sensor_.set_humidity(55.f);
+  air_sensor_.set_gas_resistance(42000.f);
+  pw::Result<uint16_t> score = air_sensor_.MeasureSync();
+  ASSERT_EQ(score.status(), pw::OkStatus());
+
+  AirSensor::Readings readings = air_sensor_.Snapshot();
+  EXPECT_EQ(readings.temperature, 25.f);
+  EXPECT_EQ(readings.pressure, 98.f);
+  EXPECT_EQ(readings.humidity, 55.f);
+  EXPECT_EQ(readings.gas_resistance, 42000.f);
+  EXPECT_EQ(readings.score, *score);
+}
+
+TEST_F(AirSensorTest, WarmsUpAfterInit) {
+  EXPECT_TRUE(air_sensor_.Snapshot().warming_up);
+  MeasureRepeated(AirSensor::kWarmUpMeasurements);
+  EXPECT_TRUE(air_sensor_.Snapshot().warming_up);
+  MeasureRepeated(1);
+  EXPECT_FALSE(air_sensor_.Snapshot().warming_up);
+}
+
+TEST(AirSensorIaqTest, ScoresWithIaqModel) {
+  using namespace std::chrono_literals;
+  AirSensorFake air_sensor;
+  air_sensor.UseIaqModel({
+      .sample_interval = 1s,
+      .stabilization = 2s,
+      .medium_accuracy = 10s,
+      .high_accuracy = 20s,
+  });
+  ASSERT_EQ(pw::OkStatus(), air_sensor.Init());
+
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(air_sensor.MeasureSync().status(), pw::OkStatus());
+  }
+  AirSensor::Readings readings = air_sensor.Snapshot();
+  ASSERT_TRUE(readings.iaq.has_value());
+  EXPECT_EQ(readings.iaq->accuracy, IaqAccuracy::kStabilizing);
+  EXPECT_EQ(readings.iaq->index, IaqModel::kCleanIndex);
+  EXPECT_TRUE(readings.warming_up);
+
+  air_sensor.set_gas_resistance(AirSensor::kDefaultGasResistance / 2);
+  ASSERT_EQ(air_sensor.MeasureSync().status(), pw::OkStatus());
+  readings = air_sensor.Snapshot();
+  ASSERT_TRUE(readings.iaq.has_value());
+  EXPECT_EQ(readings.iaq->accuracy, IaqAccuracy::kLow);
+  EXPECT_GT(readings.iaq->index, IaqModel::kCleanIndex);
+  EXPECT_FALSE(readings.warming_up);
+  EXPECT_LT(readings.score, AirSensor::kAverageScore);
+}
+
 TEST_F(AirSensorTest, MeasureOnce) {
   pw::Result<uint16_t> score = air_sensor_.MeasureSync();
   ASSERT_EQ(score.status(), pw::OkStatus());
@@ -113,6 +193,29 @@ TEST_F(AirSensorTest, MeasureFarValues) {
   EXPECT_GE(*score, 1023);
 }
 
+TEST_F(AirSensorTest, UpdateBatchMatchesSequentialUpdates) {
+  std::array<AirSensor::Reading, AirSensor::kMaxBatchSize + 4> readings;
+  for (size_t i = 0; i < readings.size(); ++i) {
+    readings[i].gas_resistance =
+        AirSensor::kDefaultGasResistance + 1000.f * static_cast<float>(i % 7);
+    air_sensor_.set_gas_resistance(readings[i].gas_resistance);
+    MeasureRepeated(1);
+  }
+
+  AirSensorFake batched;
+  ASSERT_EQ(pw::OkStatus(), batched.Init());
+  batched.PublishBatch(readings);
+
+  const AirSensor::Baseline expected = air_sensor_.baseline();
+  const AirSensor::Baseline actual = batched.baseline();
+  EXPECT_EQ(actual.count, expected.count);
+  EXPECT_FLOAT_EQ(actual.average, expected.average);
+  EXPECT_NEAR(actual.variance, expected.variance, expected.variance * 1e-4f);
+  EXPECT_NEAR(batched.score(), air_sensor_.score(), 1);
+  EXPECT_EQ(batched.gas_resistance(), readings.back().gas_resistance);
+  EXPECT_FALSE(batched.Snapshot().warming_up);
+}
+
 TEST_F(AirSensorTest, MeasureAsync) {
   air_sensor_.set_autopublish(false);
 
@@ -143,4 +246,94 @@ TEST_F(AirSensorTest, MeasureAsync) {
   thread.join();
 }
 
+TEST_F(AirSensorTest, MeasureFutureResolvesWhenMeasured) {
+  air_sensor_.set_autopublish(false);
+  air_sensor_.set_gas_resistance(AirSensor::kDefaultGasResistance * 2);
+
+  AirSensor::MeasureFuture future = air_sensor_.MeasureAsync();
+  EXPECT_FALSE(PendUntilStalled(future).has_value());
+
+  air_sensor_.Publish();
+  std::optional<pw::Result<uint16_t>> result = PendUntilStalled(future);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->status(), pw::OkStatus());
+  EXPECT_EQ(**result, air_sensor_.score());
+  EXPECT_EQ(air_sensor_.gas_resistance(),
+            AirSensor::kDefaultGasResistance * 2);
+}
+
+TEST_F(AirSensorTest, ReplacedMeasureFutureResolves) {
+  air_sensor_.set_autopublish(false);
+
+  AirSensor::MeasureFuture future = air_sensor_.MeasureAsync();
+  ASSERT_EQ(pw::OkStatus(), air_sensor_.Measure(response_));
+  EXPECT_TRUE(PendUntilStalled(future).has_value());
+
+  air_sensor_.Publish();
+  EXPECT_TRUE(response_.try_acquire());
+}
+
+TEST_F(AirSensorTest, ConcurrentMeasureFuturesShareMeasurement) {
+  air_sensor_.set_autopublish(false);
+  air_sensor_.set_gas_resistance(AirSensor::kDefaultGasResistance * 2);
+
+  std::array<std::optional<AirSensor::MeasureFuture>, 2> futures;
+  std::array<std::optional<pw::Result<uint16_t>>, 2> results;
+  auto pend = [&](size_t i) {
+    return [&futures, &results, i](pw::async2::Context& cx)
+               -> pw::async2::Poll<> {
+      pw::async2::Poll<pw::Result<uint16_t>> poll = futures[i]->Pend(cx);
+      if (poll.IsPending()) {
+        return pw::async2::Pending();
+      }
+      results[i] = *poll;
+      return pw::async2::Ready();
+    };
+  };
+  pw::async2::PendFuncTask first_task(pend(0));
+  pw::async2::PendFuncTask second_task(pend(1));
+
+  // Both tasks wait at once, and the second request does not restart the
+  // measurement the first one started.
+  futures[0] = air_sensor_.MeasureAsync();
+  futures[1] = air_sensor_.MeasureAsync();
+  dispatcher_.Post(first_task);
+  dispatcher_.Post(second_task);
+  dispatcher_.RunUntilStalled().IgnorePoll();
+  EXPECT_FALSE(results[0].has_value());
+  EXPECT_FALSE(results[1].has_value());
+
+  air_sensor_.Publish();
+  dispatcher_.RunUntilStalled().IgnorePoll();
+  for (const std::optional<pw::Result<uint16_t>>& result : results) {
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->status(), pw::OkStatus());
+    EXPECT_EQ(**result, air_sensor_.score());
+  }
+  first_task.Deregister();
+  second_task.Deregister();
+}
+
+TEST_F(AirSensorTest, MeasureFuturesAreBounded) {
+  air_sensor_.set_autopublish(false);
+
+  std::array<std::optional<AirSensor::MeasureFuture>,
+             AirSensor::kMaxMeasureFutures>
+      futures;
+  for (std::optional<AirSensor::MeasureFuture>& future : futures) {
+    future = air_sensor_.MeasureAsync();
+  }
+  AirSensor::MeasureFuture extra = air_sensor_.MeasureAsync();
+  std::optional<pw::Result<uint16_t>> result = PendUntilStalled(extra);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->status(), pw::Status::ResourceExhausted());
+
+  // Destroying a future frees its slot.
+  futures[0].reset();
+  AirSensor::MeasureFuture replacement = air_sensor_.MeasureAsync();
+  EXPECT_FALSE(PendUntilStalled(replacement).has_value());
+  air_sensor_.Publish();
+  EXPECT_TRUE(PendUntilStalled(replacement).has_value());
+}
+
 }  // namespace sense
@@ -0,0 +1,173 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/baseline_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+
+void BaselineEstimator::UseCumulative() {
+  const float mean = this->mean();
+  const float variance = this->variance();
+  mode_ = Mode::kCumulative;
+  Restore(count_, mean, variance);
+}
+
+void BaselineEstimator::UseExponential(uint32_t half_life) {
+  PW_CHECK_UINT_GT(half_life, 0);
+  const float mean = this->mean();
+  const float variance = this->variance();
+  mode_ = Mode::kExponential;
+  alpha_ = 1.f - std::exp2(-1.f / static_cast<float>(half_life));
+  Restore(count_, mean, variance);
+}
+
+void BaselineEstimator::UseWindowed(pw::span<float> window) {
+  PW_CHECK(!window.empty());
+  const float mean = this->mean();
+  const float variance = this->variance();
+  mode_ = Mode::kWindowed;
+  window_ = window;
+  Restore(count_, mean, variance);
+}
+
+void BaselineEstimator::Add(float value) {
+  ++count_;
+  switch (mode_) {
+    case Mode::kCumulative: {
+      // Welford's algorithm.
+      const float delta = value - mean_;
+      mean_ += delta / static_cast<float>(count_);
+      spread_ += delta * (value - mean_);
+      break;
+    }
+    case Mode::kExponential: {
+      // Start out as a plain average so that early values are not pulled
+      // towards zero.
+      const float weight = std::max(alpha_, 1.f / static_cast<float>(count_));
+      const float delta = value - mean_;
+      mean_ += weight * delta;
+      spread_ = (1.f - weight) * (spread_ + weight * delta * delta);
+      break;
+    }
+    case Mode::kWindowed:
+      AddToWindow(value);
+      break;
+  }
+}
+
+void BaselineEstimator::AddAll(pw::span<const float> values) {
+  if (mode_ != Mode::kCumulative) {
+    for (float value : values) {
+      Add(value);
+    }
+    return;
+  }
+  if (values.empty()) {
+    return;
+  }
+
+  // Welford's algorithm over the batch alone, whose values are close
+  // together, then Chan et al.'s formula to merge it with the estimate.
+  float batch_mean = 0.f;
+  float batch_spread = 0.f;
+  uint32_t batch_count = 0;
+  for (float value : values) {
+    ++batch_count;
+    const float delta = value - batch_mean;
+    batch_mean += delta / static_cast<float>(batch_count);
+    batch_spread += delta * (value - batch_mean);
+  }
+
+  const auto count = static_cast<float>(count_);
+  const auto total = static_cast<float>(count_ + batch_count);
+  const float delta = batch_mean - mean_;
+  mean_ += delta * (static_cast<float>(batch_count) / total);
+  spread_ += batch_spread + delta * delta * count *
+                                (static_cast<float>(batch_count) / total);
+  count_ += batch_count;
+}
+
+void BaselineEstimator::AddToWindow(float value) {
+  float& slot = window_[window_next_];
+  window_next_ = (window_next_ + 1) % window_.size();
+
+  if (window_filled_ < window_.size()) {
+    ++window_filled_;
+    const float delta = value - mean_;
+    mean_ += delta / static_cast<float>(window_filled_);
+    spread_ += delta * (value - mean_);
+  } else {
+    // Replace the oldest value in a single Welford update.
+    const float oldest = slot;
+    const float old_mean = mean_;
+    mean_ += (value - oldest) / static_cast<float>(window_filled_);
+    spread_ += (value - oldest) * (value - mean_ + oldest - old_mean);
+    spread_ = std::max(spread_, 0.f);
+  }
+  slot = value;
+}
+
+void BaselineEstimator::Restore(uint32_t count, float mean, float variance) {
+  count_ = count;
+  switch (mode_) {
+    case Mode::kCumulative:
+      mean_ = mean;
+      spread_ = count > 1 ? variance * static_cast<float>(count - 1) : 0.f;
+      break;
+    case Mode::kExponential:
+      mean_ = mean;
+      spread_ = variance;
+      break;
+    case Mode::kWindowed:
+      // The values themselves are gone, so report the restored estimate
+      // until the window has enough new ones.
+      window_next_ = 0;
+      window_filled_ = 0;
+      mean_ = 0.f;
+      spread_ = 0.f;
+      prior_mean_ = mean;
+      prior_variance_ = variance;
+      break;
+  }
+}
+
+float BaselineEstimator::mean() const {
+  if (mode_ == Mode::kWindowed && window_filled_ < 2) {
+    return window_filled_ == 0 || count_ > window_filled_ ? prior_mean_
+                                                          : mean_;
+  }
+  return mean_;
+}
+
+float BaselineEstimator::variance() const {
+  switch (mode_) {
+    case Mode::kCumulative:
+      return count_ > 1 ? spread_ / static_cast<float>(count_ - 1) : 0.f;
+    case Mode::kExponential:
+      return spread_;
+    case Mode::kWindowed:
+      if (window_filled_ < 2) {
+        return prior_variance_;
+      }
+      return spread_ / static_cast<float>(window_filled_ - 1);
+  }
+  return 0.f;
+}
+
+}  // namespace sense
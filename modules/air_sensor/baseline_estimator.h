@@ -0,0 +1,86 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_span/span.h"
+
+namespace sense {
+
+/// Running mean and variance of a series of values, updated in constant time
+/// per value.
+///
+/// By default every value is weighted equally. Alternatively, older values
+/// can be decayed exponentially or dropped once they fall out of a fixed
+/// window, so that the estimate keeps tracking slow changes.
+class BaselineEstimator {
+ public:
+  /// Weights every value since the start equally.
+  void UseCumulative();
+
+  /// Halves the weight of values every `half_life` newer values.
+  void UseExponential(uint32_t half_life);
+
+  /// Only considers the last `window.size()` values, kept in `window`.
+  ///
+  /// Until the window holds two values, the previous estimate is reported.
+  void UseWindowed(pw::span<float> window);
+
+  void Add(float value);
+
+  /// Adds `values` in order. Cumulative estimates merge the batch's own mean
+  /// and variance in one step; the other modes add the values one by one.
+  void AddAll(pw::span<const float> values);
+
+  /// Replaces the estimate, e.g. with one saved before a reboot.
+  void Restore(uint32_t count, float mean, float variance);
+
+  /// Number of values added or restored.
+  uint32_t count() const { return count_; }
+
+  float mean() const;
+
+  /// Sample variance, or zero with fewer than two values.
+  float variance() const;
+
+ private:
+  enum class Mode : uint8_t {
+    kCumulative,
+    kExponential,
+    kWindowed,
+  };
+
+  void AddToWindow(float value);
+
+  Mode mode_ = Mode::kCumulative;
+  uint32_t count_ = 0;
+  float mean_ = 0.f;
+  // Sum of squared differences from the mean, or the variance itself when
+  // exponential.
+  float spread_ = 0.f;
+
+  // Exponential state.
+  float alpha_ = 0.f;
+
+  // Windowed state.
+  pw::span<float> window_;
+  size_t window_next_ = 0;
+  size_t window_filled_ = 0;
+  float prior_mean_ = 0.f;
+  float prior_variance_ = 0.f;
+};
+
+}  // namespace sense
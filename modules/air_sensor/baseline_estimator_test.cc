@@ -0,0 +1,131 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/baseline_estimator.h"
+
+#include <array>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+TEST(BaselineEstimatorTest, CumulativeMatchesSampleStatistics) {
+  BaselineEstimator estimator;
+  for (float value : {2.f, 4.f, 4.f, 4.f, 5.f, 5.f, 7.f, 9.f}) {
+    estimator.Add(value);
+  }
+  EXPECT_EQ(estimator.count(), 8u);
+  EXPECT_FLOAT_EQ(estimator.mean(), 5.f);
+  EXPECT_FLOAT_EQ(estimator.variance(), 32.f / 7.f);
+}
+
+TEST(BaselineEstimatorTest, CumulativeBatchMatchesSequential) {
+  constexpr std::array<float, 8> kValues = {
+      2.f, 4.f, 4.f, 4.f, 5.f, 5.f, 7.f, 9.f};
+  BaselineEstimator sequential;
+  BaselineEstimator batched;
+  for (float value : kValues) {
+    sequential.Add(value);
+  }
+  batched.Add(kValues[0]);
+  batched.AddAll(pw::span(kValues).subspan(1, 4));
+  batched.AddAll({});
+  batched.AddAll(pw::span(kValues).subspan(5));
+  EXPECT_EQ(batched.count(), sequential.count());
+  EXPECT_FLOAT_EQ(batched.mean(), sequential.mean());
+  EXPECT_FLOAT_EQ(batched.variance(), sequential.variance());
+}
+
+TEST(BaselineEstimatorTest, WindowedBatchMatchesSequential) {
+  constexpr std::array<float, 6> kValues = {1.f, 2.f, 3.f, 10.f, 20.f, 30.f};
+  std::array<float, 3> sequential_window;
+  std::array<float, 3> batched_window;
+  BaselineEstimator sequential;
+  BaselineEstimator batched;
+  sequential.UseWindowed(sequential_window);
+  batched.UseWindowed(batched_window);
+  for (float value : kValues) {
+    sequential.Add(value);
+  }
+  batched.AddAll(kValues);
+  EXPECT_FLOAT_EQ(batched.mean(), sequential.mean());
+  EXPECT_FLOAT_EQ(batched.variance(), sequential.variance());
+}
+
+TEST(BaselineEstimatorTest, ExponentialTracksStepChange) {
+  BaselineEstimator estimator;
+  estimator.UseExponential(10);
+  for (int i = 0; i < 100; ++i) {
+    estimator.Add(0.f);
+  }
+  for (int i = 0; i < 10; ++i) {
+    estimator.Add(1.f);
+  }
+  // After one half-life, the mean is half way to the new value.
+  EXPECT_NEAR(estimator.mean(), 0.5f, 0.01f);
+  for (int i = 0; i < 100; ++i) {
+    estimator.Add(1.f);
+  }
+  EXPECT_NEAR(estimator.mean(), 1.f, 0.001f);
+  EXPECT_NEAR(estimator.variance(), 0.f, 0.001f);
+}
+
+TEST(BaselineEstimatorTest, ExponentialStartsAsPlainAverage) {
+  BaselineEstimator estimator;
+  estimator.UseExponential(1000);
+  estimator.Add(10.f);
+  estimator.Add(20.f);
+  EXPECT_FLOAT_EQ(estimator.mean(), 15.f);
+}
+
+TEST(BaselineEstimatorTest, WindowedForgetsOldValues) {
+  std::array<float, 4> window;
+  BaselineEstimator estimator;
+  estimator.UseWindowed(window);
+  for (float value : {100.f, -50.f, 1.f, 2.f, 3.f, 4.f}) {
+    estimator.Add(value);
+  }
+  EXPECT_EQ(estimator.count(), 6u);
+  EXPECT_FLOAT_EQ(estimator.mean(), 2.5f);
+  EXPECT_NEAR(estimator.variance(), 5.f / 3.f, 1e-4f);
+}
+
+TEST(BaselineEstimatorTest, WindowedReportsRestoredEstimateUntilFilled) {
+  std::array<float, 8> window;
+  BaselineEstimator estimator;
+  estimator.UseWindowed(window);
+  estimator.Restore(1000, 12.f, 0.25f);
+  estimator.Add(14.f);
+  EXPECT_FLOAT_EQ(estimator.mean(), 12.f);
+  EXPECT_FLOAT_EQ(estimator.variance(), 0.25f);
+
+  estimator.Add(16.f);
+  EXPECT_FLOAT_EQ(estimator.mean(), 15.f);
+  EXPECT_FLOAT_EQ(estimator.variance(), 2.f);
+}
+
+TEST(BaselineEstimatorTest, SwitchingModesKeepsEstimate) {
+  BaselineEstimator estimator;
+  for (float value : {1.f, 2.f, 3.f}) {
+    estimator.Add(value);
+  }
+  estimator.UseExponential(100);
+  EXPECT_FLOAT_EQ(estimator.mean(), 2.f);
+  EXPECT_FLOAT_EQ(estimator.variance(), 1.f);
+  EXPECT_EQ(estimator.count(), 3u);
+}
+
+}  // namespace
+}  // namespace sense
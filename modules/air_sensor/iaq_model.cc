@@ -0,0 +1,103 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/iaq_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace sense {
+namespace {
+
+using ::pw::chrono::SystemClock;
+
+// How much the index rises per unit the quality, a natural log, falls below
+// the reference. Gas resistance at a third of clean air's is about 300.
+constexpr float kIndexPerQuality = 250.f;
+
+// Fraction of the way the reference moves towards cleaner air per sample.
+// Less than one so that a single noisy reading does not become the reference.
+constexpr float kReferenceRise = 0.5f;
+
+// How far the reference falls per hour, so that it tracks sensor drift.
+constexpr float kReferenceDecayPerHour = 0.05f;
+
+// Equivalent CO2 of the cleanest air, and its increase per index point.
+constexpr float kBaseCo2Ppm = 400.f;
+constexpr float kCo2PpmPerIndex = 8.f;
+
+// Returns how many samples at `interval` cover `duration`, and at least one.
+uint32_t SamplesIn(SystemClock::duration duration,
+                   SystemClock::duration interval) {
+  const auto samples =
+      (duration + interval - SystemClock::duration(1)) / interval;
+  return static_cast<uint32_t>(std::max<decltype(samples)>(samples, 1));
+}
+
+}  // namespace
+
+IaqModel::IaqModel(const Config& config)
+    : stabilization_samples_(
+          SamplesIn(config.stabilization, config.sample_interval)),
+      medium_samples_(
+          stabilization_samples_ +
+          SamplesIn(config.medium_accuracy, config.sample_interval)),
+      high_samples_(stabilization_samples_ +
+                    SamplesIn(config.high_accuracy, config.sample_interval)),
+      decay_per_sample_(
+          kReferenceDecayPerHour *
+          std::chrono::duration<float, std::ratio<3600>>(config.sample_interval)
+              .count()) {}
+
+IaqAccuracy IaqModel::accuracy() const {
+  if (samples_ <= stabilization_samples_) {
+    return IaqAccuracy::kStabilizing;
+  }
+  if (samples_ <= medium_samples_) {
+    return IaqAccuracy::kLow;
+  }
+  if (samples_ <= high_samples_) {
+    return IaqAccuracy::kMedium;
+  }
+  return IaqAccuracy::kHigh;
+}
+
+IaqEstimate IaqModel::Update(float quality) {
+  if (samples_ < UINT32_MAX) {
+    ++samples_;
+  }
+  if (samples_ <= stabilization_samples_) {
+    reference_ = quality;
+  } else if (quality > reference_) {
+    reference_ += (quality - reference_) * kReferenceRise;
+  } else {
+    reference_ -= decay_per_sample_;
+  }
+
+  const float index = std::clamp(
+      static_cast<float>(kCleanIndex) +
+          (reference_ - quality) * kIndexPerQuality,
+      0.f,
+      static_cast<float>(kMaxIndex));
+  return {
+      .index = static_cast<uint16_t>(std::lround(index)),
+      .co2_ppm =
+          static_cast<uint16_t>(std::lround(kBaseCo2Ppm +
+                                            index * kCo2PpmPerIndex)),
+      .accuracy = accuracy(),
+  };
+}
+
+}  // namespace sense
@@ -0,0 +1,100 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_chrono/system_clock.h"
+
+/// Schedule the production app runs `IaqModel` on: 0 scores with the
+/// baseline's z-score instead, 1 selects `IaqModel::kLowPower` and 2
+/// `IaqModel::kUltraLowPower`.
+#ifndef SENSE_IAQ_MODEL
+#define SENSE_IAQ_MODEL 0
+#endif  // SENSE_IAQ_MODEL
+
+namespace sense {
+
+/// Estimates a BSEC-style indoor air quality index from the quality values
+/// `AirSensor` computes, i.e. humidity-compensated log gas resistances.
+///
+/// Clean air is taken to be the highest quality seen recently, and the index
+/// rises as the quality falls below it. That reference decays slowly, so the
+/// model recovers from sensor drift and from starting in stale air. Time is
+/// counted in samples, so the sensor must be measured on the configured
+/// schedule rather than adaptively.
+class IaqModel {
+ public:
+  struct Config {
+    /// Time between measurements.
+    pw::chrono::SystemClock::duration sample_interval;
+
+    /// Time after start during which estimates are `kStabilizing` while the
+    /// heater settles. The reference follows every sample meanwhile.
+    pw::chrono::SystemClock::duration stabilization;
+
+    /// Time after stabilizing until estimates are `kMedium`.
+    pw::chrono::SystemClock::duration medium_accuracy;
+
+    /// Time after stabilizing until estimates are `kHigh`.
+    pw::chrono::SystemClock::duration high_accuracy;
+  };
+
+  /// One measurement every 3 s, like BSEC's low-power mode.
+  static constexpr Config kLowPower = {
+      .sample_interval = std::chrono::seconds(3),
+      .stabilization = std::chrono::minutes(5),
+      .medium_accuracy = std::chrono::hours(1),
+      .high_accuracy = std::chrono::hours(4),
+  };
+
+  /// One measurement every 300 s, like BSEC's ultra-low-power mode. Uses two
+  /// orders of magnitude less heater energy, but takes longer to calibrate.
+  static constexpr Config kUltraLowPower = {
+      .sample_interval = std::chrono::seconds(300),
+      .stabilization = std::chrono::minutes(10),
+      .medium_accuracy = std::chrono::hours(4),
+      .high_accuracy = std::chrono::hours(12),
+  };
+
+  /// Index of air as clean as the reference.
+  static constexpr uint16_t kCleanIndex = 25;
+
+  /// Index of extremely polluted air, beyond which estimates are clamped.
+  static constexpr uint16_t kMaxIndex = 500;
+
+  explicit IaqModel(const Config& config);
+
+  /// Adds the quality value of the next scheduled measurement and returns the
+  /// resulting estimate.
+  IaqEstimate Update(float quality);
+
+  /// Quality value of clean air that the index is relative to.
+  float reference() const { return reference_; }
+
+ private:
+  IaqAccuracy accuracy() const;
+
+  const uint32_t stabilization_samples_;
+  const uint32_t medium_samples_;
+  const uint32_t high_samples_;
+  const float decay_per_sample_;
+
+  uint32_t samples_ = 0;
+  float reference_ = 0.f;
+};
+
+}  // namespace sense
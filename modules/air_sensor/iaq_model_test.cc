@@ -0,0 +1,98 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/iaq_model.h"
+
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr IaqModel::Config kTestConfig = {
+    .sample_interval = 1s,
+    .stabilization = 3s,
+    .medium_accuracy = 5s,
+    .high_accuracy = 10s,
+};
+
+// Feeds the model clean air until it is done stabilizing.
+void Stabilize(IaqModel& model, float quality) {
+  for (int i = 0; i < 3; ++i) {
+    model.Update(quality);
+  }
+}
+
+TEST(IaqModelTest, AccuracyRisesWithTime) {
+  IaqModel model(kTestConfig);
+  for (int i = 0; i < 3; ++i) {
+    const IaqEstimate estimate = model.Update(10.f);
+    EXPECT_EQ(estimate.accuracy, IaqAccuracy::kStabilizing);
+    EXPECT_EQ(estimate.index, IaqModel::kCleanIndex);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(model.Update(10.f).accuracy, IaqAccuracy::kLow);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(model.Update(10.f).accuracy, IaqAccuracy::kMedium);
+  }
+  EXPECT_EQ(model.Update(10.f).accuracy, IaqAccuracy::kHigh);
+}
+
+TEST(IaqModelTest, IndexRisesAsQualityFalls) {
+  IaqModel model(kTestConfig);
+  Stabilize(model, 10.f);
+  const IaqEstimate estimate = model.Update(9.f);
+  EXPECT_EQ(estimate.index, 275u);
+  EXPECT_EQ(estimate.co2_ppm, 2600u);
+  EXPECT_EQ(estimate.accuracy, IaqAccuracy::kLow);
+}
+
+TEST(IaqModelTest, IndexIsClamped) {
+  IaqModel model(kTestConfig);
+  Stabilize(model, 10.f);
+  const IaqEstimate estimate = model.Update(2.f);
+  EXPECT_EQ(estimate.index, IaqModel::kMaxIndex);
+  EXPECT_EQ(estimate.co2_ppm, 4400u);
+}
+
+TEST(IaqModelTest, CleanerAirRaisesReference) {
+  IaqModel model(kTestConfig);
+  Stabilize(model, 10.f);
+  EXPECT_EQ(model.Update(11.f).index, 0u);
+  EXPECT_FLOAT_EQ(model.reference(), 10.5f);
+  model.Update(11.f);
+  EXPECT_FLOAT_EQ(model.reference(), 10.75f);
+}
+
+TEST(IaqModelTest, ReferenceDecaysInPollutedAir) {
+  IaqModel model({
+      .sample_interval = 1h,
+      .stabilization = 1h,
+      .medium_accuracy = 1h,
+      .high_accuracy = 1h,
+  });
+  model.Update(10.f);
+  const uint16_t first = model.Update(9.5f).index;
+  const uint16_t second = model.Update(9.5f).index;
+  EXPECT_GT(first, IaqModel::kCleanIndex);
+  EXPECT_LT(second, first);
+  EXPECT_NEAR(model.reference(), 9.9f, 1e-4f);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,38 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/kvs_baseline_store.h"
+
+#include "pw_status/try.h"
+
+namespace sense {
+
+pw::Result<AirSensor::Baseline> KvsBaselineStore::Load() {
+  Record record;
+  PW_TRY(kvs_.Get(kKey, &record));
+  if (record.version != Record::kVersion) {
+    return pw::Status::NotFound();
+  }
+  return record.baseline;
+}
+
+pw::Status KvsBaselineStore::Save(const AirSensor::Baseline& baseline) {
+  return kvs_.Put(kKey,
+                  Record{
+                      .version = Record::kVersion,
+                      .baseline = baseline,
+                  });
+}
+
+}  // namespace sense
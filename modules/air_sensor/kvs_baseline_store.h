@@ -0,0 +1,50 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <string_view>
+
+#include "modules/air_sensor/air_sensor.h"
+#include "pw_kvs/key_value_store.h"
+#include "pw_result/result.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Keeps the air quality baseline in a key-value store.
+///
+/// The store appends a new entry for each save and reclaims sectors as they
+/// fill, which spreads erases across its whole partition.
+class KvsBaselineStore : public AirSensor::BaselineStore {
+ public:
+  static constexpr std::string_view kKey = "air_baseline";
+
+  explicit KvsBaselineStore(pw::kvs::KeyValueStore& kvs) : kvs_(kvs) {}
+
+  pw::Result<AirSensor::Baseline> Load() override;
+  pw::Status Save(const AirSensor::Baseline& baseline) override;
+
+ private:
+  // Versioned so that a change to the layout discards old entries.
+  struct Record {
+    static constexpr uint32_t kVersion = 2;
+
+    uint32_t version;
+    AirSensor::Baseline baseline;
+  };
+
+  pw::kvs::KeyValueStore& kvs_;
+};
+
+}  // namespace sense
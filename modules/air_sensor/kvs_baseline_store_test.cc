@@ -0,0 +1,125 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/kvs_baseline_store.h"
+
+#include <utility>
+
+#include "modules/air_sensor/air_sensor_fake.h"
+#include "pw_containers/vector.h"
+#include "pw_function/function.h"
+#include "pw_kvs/crc16_checksum.h"
+#include "pw_kvs/fake_flash_memory.h"
+#include "pw_kvs/flash_memory.h"
+#include "pw_kvs/key_value_store.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+// Holds work until the test runs it.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+};
+
+class KvsBaselineStoreTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kSectorSize = 512;
+  static constexpr size_t kSectors = 4;
+
+  KvsBaselineStoreTest()
+      : partition_(&flash_),
+        kvs_(&partition_, {.magic = 0xa12b5e15, .checksum = &checksum_}),
+        store_(kvs_) {}
+
+  void SetUp() override { ASSERT_EQ(kvs_.Init(), pw::OkStatus()); }
+
+  pw::kvs::FakeFlashMemoryBuffer<kSectorSize, kSectors> flash_;
+  pw::kvs::FlashPartition partition_;
+  pw::kvs::ChecksumCrc16 checksum_;
+  pw::kvs::KeyValueStoreBuffer<4, kSectors> kvs_;
+  KvsBaselineStore store_;
+};
+
+TEST_F(KvsBaselineStoreTest, LoadWithoutSave) {
+  EXPECT_EQ(store_.Load().status(), pw::Status::NotFound());
+}
+
+TEST_F(KvsBaselineStoreTest, SaveAndLoad) {
+  ASSERT_EQ(store_.Save({.count = 42, .average = 11.f, .variance = 3.f}),
+            pw::OkStatus());
+  pw::Result<AirSensor::Baseline> baseline = store_.Load();
+  ASSERT_EQ(baseline.status(), pw::OkStatus());
+  EXPECT_EQ(baseline->count, 42u);
+  EXPECT_EQ(baseline->average, 11.f);
+  EXPECT_EQ(baseline->variance, 3.f);
+}
+
+TEST_F(KvsBaselineStoreTest, RepeatedSavesReclaimSectors) {
+  for (uint32_t i = 1; i <= 200; ++i) {
+    ASSERT_EQ(store_.Save({.count = i}), pw::OkStatus());
+  }
+  pw::Result<AirSensor::Baseline> baseline = store_.Load();
+  ASSERT_EQ(baseline.status(), pw::OkStatus());
+  EXPECT_EQ(baseline->count, 200u);
+}
+
+TEST_F(KvsBaselineStoreTest, AirSensorRestoresAndSaves) {
+  ManualWorker worker;
+  AirSensorFake first;
+  first.SetBaselineStore(store_, 2, worker);
+  ASSERT_EQ(first.Init(), pw::OkStatus());
+  for (float ohms : {40000.f, 60000.f, 45000.f, 55000.f}) {
+    first.set_gas_resistance(ohms);
+    ASSERT_EQ(first.MeasureSync().status(), pw::OkStatus());
+  }
+
+  // Saves wait for the worker, and one save covers both intervals.
+  EXPECT_EQ(store_.Load().status(), pw::Status::NotFound());
+  worker.RunAll();
+  pw::Result<AirSensor::Baseline> saved = store_.Load();
+  ASSERT_EQ(saved.status(), pw::OkStatus());
+  EXPECT_EQ(saved->count, 4u);
+
+  AirSensorFake second;
+  second.SetBaselineStore(store_, 2, worker);
+  ASSERT_EQ(second.Init(), pw::OkStatus());
+  EXPECT_EQ(second.baseline().count, 4u);
+  EXPECT_EQ(second.baseline().average, first.baseline().average);
+
+  // The restored baseline scores the first reading.
+  second.set_gas_resistance(60000.f);
+  first.set_gas_resistance(60000.f);
+  // The variance is restored rather than the sum of squares, so allow for
+  // rounding.
+  const int restored = *second.MeasureSync();
+  EXPECT_NEAR(restored, static_cast<int>(*first.MeasureSync()), 1);
+}
+
+}  // namespace
+}  // namespace sense
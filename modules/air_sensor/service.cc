@@ -14,25 +14,92 @@
 
 #include "modules/air_sensor/service.h"
 
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+
 #include "pw_assert/check.h"
 #include "pw_log/log.h"
 
 namespace sense {
+namespace {
+
+air_sensor_Measurement ToResponse(const AirSensor& air_sensor) {
+  const AirSensor::Readings readings = air_sensor.Snapshot();
+  air_sensor_Measurement response = {
+      .temperature = readings.temperature,
+      .pressure = readings.pressure,
+      .humidity = readings.humidity,
+      .gas_resistance = readings.gas_resistance,
+      .score = readings.score,
+      .dropped = 0,
+  };
+  if (readings.iaq.has_value()) {
+    response.has_iaq = true;
+    response.iaq = readings.iaq->index;
+    response.has_co2_ppm = true;
+    response.co2_ppm = readings.iaq->co2_ppm;
+    response.has_iaq_accuracy = true;
+    response.iaq_accuracy = static_cast<uint32_t>(readings.iaq->accuracy);
+  }
+  return response;
+}
 
-void AirSensorService::Init(Worker& worker, AirSensor& air_sensor) {
-  worker_ = &worker;
+}  // namespace
+
+AirSensorService::AirSensorService()
+    : measure_task_([this](pw::async2::Context& cx) {
+        return PendMeasurement(cx);
+      }) {}
+
+void AirSensorService::Init(pw::async2::Dispatcher& dispatcher,
+                            PubSub& pubsub,
+                            AirSensor& air_sensor,
+                            RequestIntervalCallback&& request_interval) {
+  dispatcher_ = &dispatcher;
+  pubsub_ = &pubsub;
   air_sensor_ = &air_sensor;
+  request_interval_ = std::move(request_interval);
+  PW_CHECK(pubsub.SubscribeTo<AirMeasurement>(
+      [this](AirMeasurement measurement) { HandleMeasurement(measurement); }));
 }
 
-pw::Status AirSensorService::Measure(const pw_protobuf_Empty&,
-                                     air_sensor_Measurement& response) {
-  PW_TRY(air_sensor_->Measure(notification_));
-  notification_.acquire();
-  response.temperature = air_sensor_->temperature();
-  response.pressure = air_sensor_->pressure();
-  response.humidity = air_sensor_->humidity();
-  response.gas_resistance = air_sensor_->gas_resistance();
-  return pw::OkStatus();
+void AirSensorService::Measure(const pw_protobuf_Empty&,
+                               MeasureResponder& responder) {
+  const auto now = pw::chrono::SystemClock::now();
+  std::lock_guard lock(lock_);
+
+  // A burst of requests shares one recent measurement rather than running
+  // the heater for each.
+  if (last_measured_.has_value() &&
+      now - *last_measured_ <=
+          pw::chrono::SystemClock::for_at_least(kMaxCachedAge)) {
+    if (const auto status = responder.Finish(ToResponse(*air_sensor_));
+        !status.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", status.str());
+    }
+    return;
+  }
+
+  auto pending =
+      std::find_if(pending_measures_.begin(),
+                   pending_measures_.end(),
+                   [](const MeasureResponder& r) { return !r.active(); });
+  if (pending == pending_measures_.end()) {
+    if (const auto status =
+            responder.Finish({}, pw::Status::ResourceExhausted());
+        !status.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", status.str());
+    }
+    return;
+  }
+  *pending = std::move(responder);
+
+  if (!measuring_) {
+    measuring_ = true;
+    measure_start_ = now;
+    dispatcher_->Post(measure_task_);
+  }
 }
 
 void AirSensorService::MeasureStream(
@@ -46,11 +113,26 @@ void AirSensorService::MeasureStream(
     return;
   }
 
-  sample_interval_ = pw::chrono::SystemClock::for_at_least(
-      std::chrono::milliseconds(request.sample_interval_ms));
-  sample_writer_ = std::move(writer);
+  std::lock_guard lock(lock_);
+  auto stream = std::find_if(streams_.begin(), streams_.end(), [](auto& s) {
+    return !s.writer.active();
+  });
+  if (stream == streams_.end()) {
+    PW_LOG_WARN("No free air sensor stream for RPC channel %u",
+                writer.channel_id());
+    if (const auto status = writer.Finish(pw::Status::ResourceExhausted());
+        !status.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", status.str());
+    }
+    return;
+  }
 
-  ScheduleSample();
+  stream->interval = pw::chrono::SystemClock::for_at_least(
+      std::chrono::milliseconds(request.sample_interval_ms));
+  stream->sent_any = false;
+  stream->dropped = 0;
+  stream->writer = std::move(writer);
+  UpdateRequestedInterval();
 }
 
 pw::Status AirSensorService::LogMetrics(const pw_protobuf_Empty&,
@@ -59,29 +141,107 @@ pw::Status AirSensorService::LogMetrics(const pw_protobuf_Empty&,
   return pw::OkStatus();
 }
 
-void AirSensorService::SampleCallback(pw::chrono::SystemClock::time_point) {
-  float temperature = air_sensor_->temperature();
-  float pressure = air_sensor_->pressure();
-  float humidity = air_sensor_->humidity();
-  float gas_resistance = air_sensor_->gas_resistance();
-  uint16_t score = air_sensor_->score();
-
-  pw::Status status = sample_writer_.Write({
-      .temperature = temperature,
-      .pressure = pressure,
-      .humidity = humidity,
-      .gas_resistance = gas_resistance,
-      .score = score,
-  });
-  if (status.ok()) {
-    ScheduleSample();
-  } else {
+void AirSensorService::HandleMeasurement(const AirMeasurement& measurement) {
+  std::lock_guard lock(lock_);
+  if (!last_measured_.has_value() || measurement.timestamp > *last_measured_) {
+    last_measured_ = measurement.timestamp;
+  }
+  bool closed = false;
+  for (Stream& stream : streams_) {
+    if (stream.writer.active() && !stream.Send(measurement)) {
+      closed = true;
+    }
+  }
+  if (closed) {
     PW_LOG_INFO("Air Sensor stream closed; ending periodic sampling");
+    UpdateRequestedInterval();
   }
 }
 
-void AirSensorService::ScheduleSample() {
-  worker_->RunOnce([this]() { sample_timer_.InvokeAfter(sample_interval_); });
+pw::async2::Poll<> AirSensorService::PendMeasurement(
+    pw::async2::Context& cx) {
+  if (!measure_future_.has_value()) {
+    measure_future_ = air_sensor_->MeasureAsync();
+  }
+  pw::async2::Poll<pw::Result<uint16_t>> result = measure_future_->Pend(cx);
+  if (result.IsPending()) {
+    return pw::async2::Pending();
+  }
+  measure_future_.reset();
+
+  std::lock_guard lock(lock_);
+  if (result->ok()) {
+    last_measured_ = measure_start_;
+    // Share the measurement, e.g. with streams in apps that do not sample
+    // in the background.
+    std::ignore =
+        pubsub_->Publish(air_sensor_->Snapshot().ToEvent(measure_start_));
+  }
+  FinishMeasures(result->status());
+  return pw::async2::Ready();
+}
+
+void AirSensorService::FinishMeasures(pw::Status status) {
+  measuring_ = false;
+  air_sensor_Measurement response = air_sensor_Measurement_init_default;
+  if (status.ok()) {
+    response = ToResponse(*air_sensor_);
+  }
+  for (MeasureResponder& responder : pending_measures_) {
+    if (!responder.active()) {
+      continue;
+    }
+    if (const auto write_status = responder.Finish(response, status);
+        !write_status.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", write_status.str());
+    }
+  }
+}
+
+void AirSensorService::UpdateRequestedInterval() {
+  auto fastest = pw::chrono::SystemClock::duration::zero();
+  for (const Stream& stream : streams_) {
+    if (stream.writer.active() &&
+        (fastest == pw::chrono::SystemClock::duration::zero() ||
+         stream.interval < fastest)) {
+      fastest = stream.interval;
+    }
+  }
+  if (fastest != requested_interval_) {
+    requested_interval_ = fastest;
+    if (request_interval_ != nullptr) {
+      request_interval_(fastest);
+    }
+  }
+}
+
+bool AirSensorService::Stream::Send(const AirMeasurement& measurement) {
+  // Measurements are shared with faster streams and arrive with some jitter,
+  // so accept one that is up to a quarter interval early.
+  if (sent_any && measurement.timestamp - last_sample < interval * 3 / 4) {
+    return true;
+  }
+
+  pw::Status status = writer.Write({
+      .temperature = measurement.temperature(),
+      .pressure = measurement.pressure,
+      .humidity = measurement.humidity(),
+      .gas_resistance = measurement.gas_resistance,
+      .score = measurement.score,
+      .dropped = dropped,
+  });
+  if (status.ok()) {
+    last_sample = measurement.timestamp;
+    sent_any = true;
+    dropped = 0;
+    return true;
+  }
+  if (writer.active()) {
+    // The channel is backed up. Skip this sample and report it with the next.
+    ++dropped;
+    return true;
+  }
+  return false;
 }
 
 }  // namespace sense
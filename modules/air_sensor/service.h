@@ -13,14 +13,22 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
 #include "modules/air_sensor/air_sensor.h"
 #include "modules/air_sensor/air_sensor.rpc.pb.h"
-#include "modules/worker/worker.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_async2/dispatcher.h"
+#include "pw_async2/pend_func_task.h"
 #include "pw_chrono/system_clock.h"
-#include "pw_chrono/system_timer.h"
 #include "pw_function/function.h"
+#include "pw_rpc/nanopb/server_reader_writer.h"
 #include "pw_status/status.h"
-#include "pw_sync/thread_notification.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
 
 namespace sense {
 
@@ -28,31 +36,94 @@ class AirSensorService final
     : public ::air_sensor::pw_rpc::nanopb::AirSensor::Service<
           AirSensorService> {
  public:
-  AirSensorService()
-      : sample_timer_(
-            pw::bind_member<&AirSensorService::SampleCallback>(this)) {}
+  /// Called with the shortest interval any open stream needs, or zero when
+  /// no stream is open.
+  using RequestIntervalCallback =
+      pw::Function<void(pw::chrono::SystemClock::duration)>;
+
+  using MeasureResponder =
+      pw::rpc::NanopbUnaryResponder<air_sensor_Measurement>;
+
+  /// Number of `MeasureStream` calls that may be open at once.
+  static constexpr size_t kMaxStreams = 3;
+
+  /// Number of `Measure` calls that may wait for a measurement at once.
+  static constexpr size_t kMaxPendingMeasures = 4;
+
+  /// `Measure` answers with the latest readings instead of measuring again if
+  /// they are at most this old.
+  static constexpr auto kMaxCachedAge = std::chrono::seconds(1);
+
+  AirSensorService();
 
-  void Init(Worker& worker, AirSensor& air_sensor);
+  /// Measurements requested by `Measure` are awaited on `dispatcher`.
+  ///
+  /// Streams share the measurements that `pubsub` carries rather than taking
+  /// their own. `request_interval`, if provided, should have whatever takes
+  /// those measurements run at least as often as the fastest stream.
+  void Init(pw::async2::Dispatcher& dispatcher,
+            PubSub& pubsub,
+            AirSensor& air_sensor,
+            RequestIntervalCallback&& request_interval = nullptr);
 
-  pw::Status Measure(const pw_protobuf_Empty&,
-                     air_sensor_Measurement& response);
+  /// Responds once a measurement completes, without blocking the RPC thread
+  /// while the sensor heats up. Calls that arrive during a measurement share
+  /// its result.
+  void Measure(const pw_protobuf_Empty&, MeasureResponder& responder)
+      PW_LOCKS_EXCLUDED(lock_);
 
   void MeasureStream(const air_sensor_MeasureStreamRequest& request,
-                     ServerWriter<air_sensor_Measurement>& writer);
+                     ServerWriter<air_sensor_Measurement>& writer)
+      PW_LOCKS_EXCLUDED(lock_);
 
   pw::Status LogMetrics(const pw_protobuf_Empty&, pw_protobuf_Empty&);
 
  private:
-  void SampleCallback(pw::chrono::SystemClock::time_point);
+  /// A `MeasureStream` call and its sampling state.
+  struct Stream {
+    ServerWriter<air_sensor_Measurement> writer;
+    pw::chrono::SystemClock::duration interval;
+    pw::chrono::SystemClock::time_point last_sample;
+    bool sent_any = false;
+    uint32_t dropped = 0;
 
-  void ScheduleSample();
+    /// Sends the measurement if the stream is due for one. Returns false if
+    /// the stream has closed.
+    bool Send(const AirMeasurement& measurement);
+  };
 
-  Worker* worker_ = nullptr;
+  void HandleMeasurement(const AirMeasurement& measurement)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Runs on the dispatcher: starts a measurement and answers the pending
+  /// `Measure` calls when it completes.
+  pw::async2::Poll<> PendMeasurement(pw::async2::Context& cx)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Answers every pending `Measure` call with the latest readings.
+  void FinishMeasures(pw::Status status) PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /// Reports the fastest open stream's interval if it changed.
+  void UpdateRequestedInterval() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  PubSub* pubsub_ = nullptr;
   AirSensor* air_sensor_ = nullptr;
-  pw::sync::ThreadNotification notification_;
-  pw::chrono::SystemTimer sample_timer_;
-  pw::chrono::SystemClock::duration sample_interval_;
-  ServerWriter<air_sensor_Measurement> sample_writer_;
+  RequestIntervalCallback request_interval_;
+  pw::async2::Dispatcher* dispatcher_ = nullptr;
+  pw::async2::PendFuncTask<> measure_task_;
+  // Only used by the measure task.
+  std::optional<AirSensor::MeasureFuture> measure_future_;
+
+  pw::sync::Mutex lock_;
+  std::array<Stream, kMaxStreams> streams_ PW_GUARDED_BY(lock_);
+  std::array<MeasureResponder, kMaxPendingMeasures> pending_measures_
+      PW_GUARDED_BY(lock_);
+  bool measuring_ PW_GUARDED_BY(lock_) = false;
+  pw::chrono::SystemClock::time_point measure_start_ PW_GUARDED_BY(lock_);
+  std::optional<pw::chrono::SystemClock::time_point> last_measured_
+      PW_GUARDED_BY(lock_);
+  pw::chrono::SystemClock::duration requested_interval_ PW_GUARDED_BY(lock_) =
+      pw::chrono::SystemClock::duration::zero();
 };
 
 }  // namespace sense
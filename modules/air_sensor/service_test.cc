@@ -0,0 +1,111 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/air_sensor/service.h"
+
+#include <optional>
+
+#include "modules/air_sensor/air_sensor_fake.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/worker/test_worker.h"
+#include "pw_async2/dispatcher.h"
+#include "pw_async2/pend_func_task.h"
+#include "pw_rpc/nanopb/test_method_context.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+class AirSensorServiceTest : public ::testing::Test {
+ protected:
+  using PubSub = GenericPubSubBuffer<Event, 4, 4>;
+
+  AirSensorServiceTest() : pubsub_(worker_) {}
+
+  void SetUp() override {
+    air_sensor_.set_autopublish(false);
+    ASSERT_EQ(pw::OkStatus(), air_sensor_.Init());
+  }
+
+  void TearDown() override { worker_.Stop(); }
+
+  // Waits for the events published so far to reach their subscribers.
+  void FlushPubSub() {
+    pw::sync::ThreadNotification notification;
+    worker_.RunOnce([&notification]() { notification.release(); });
+    notification.acquire();
+  }
+
+  TestWorker<> worker_;
+  PubSub pubsub_;
+  AirSensorFake air_sensor_;
+  pw::async2::Dispatcher dispatcher_;
+};
+
+TEST_F(AirSensorServiceTest, MeasureRespondsWhenMeasured) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(AirSensorService, Measure) ctx;
+  ctx.service().Init(dispatcher_, pubsub_, air_sensor_);
+  air_sensor_.set_gas_resistance(AirSensor::kDefaultGasResistance * 2);
+
+  ctx.call({});
+  dispatcher_.RunUntilStalled().IgnorePoll();
+  EXPECT_FALSE(ctx.done());
+
+  air_sensor_.Publish();
+  dispatcher_.RunUntilStalled().IgnorePoll();
+  ASSERT_TRUE(ctx.done());
+  EXPECT_EQ(ctx.status(), pw::OkStatus());
+  EXPECT_EQ(ctx.response().score, air_sensor_.score());
+  EXPECT_EQ(ctx.response().gas_resistance,
+            AirSensor::kDefaultGasResistance * 2);
+  FlushPubSub();
+}
+
+TEST_F(AirSensorServiceTest, MeasureSharesSamplerMeasurement) {
+  // A sampler task waits on its own measurement.
+  AirSensor::MeasureFuture future = air_sensor_.MeasureAsync();
+  std::optional<pw::Result<uint16_t>> sampled;
+  pw::async2::PendFuncTask sampler(
+      [&](pw::async2::Context& cx) -> pw::async2::Poll<> {
+        pw::async2::Poll<pw::Result<uint16_t>> poll = future.Pend(cx);
+        if (poll.IsPending()) {
+          return pw::async2::Pending();
+        }
+        sampled = *poll;
+        return pw::async2::Ready();
+      });
+  dispatcher_.Post(sampler);
+
+  PW_NANOPB_TEST_METHOD_CONTEXT(AirSensorService, Measure) ctx;
+  ctx.service().Init(dispatcher_, pubsub_, air_sensor_);
+  ctx.call({});
+  dispatcher_.RunUntilStalled().IgnorePoll();
+
+  // The call neither restarts the sampler's measurement nor takes its waker.
+  EXPECT_FALSE(sampled.has_value());
+  EXPECT_FALSE(ctx.done());
+
+  air_sensor_.Publish();
+  dispatcher_.RunUntilStalled().IgnorePoll();
+  ASSERT_TRUE(sampled.has_value());
+  EXPECT_EQ(sampled->status(), pw::OkStatus());
+  ASSERT_TRUE(ctx.done());
+  EXPECT_EQ(ctx.status(), pw::OkStatus());
+  EXPECT_EQ(ctx.response().score, air_sensor_.score());
+  FlushPubSub();
+}
+
+}  // namespace
+}  // namespace sense
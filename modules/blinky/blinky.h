@@ -15,6 +15,7 @@
 
 #include <chrono>
 
+#include "modules/frame_pool/frame_pool.h"
 #include "modules/led/monochrome_led.h"
 #include "modules/led/polychrome_led.h"
 #include "modules/timer_future/timer_future.h"
@@ -37,10 +38,19 @@ class Blinky final {
       pw::chrono::SystemClock::for_at_least(
           std::chrono::milliseconds(kDefaultIntervalMs));
 
+  /// Largest blink coroutine frame across the supported targets.
+  static constexpr size_t kMaxFrameSize = 256;
+
+  /// Pool for the blink coroutine's frames. A new frame is created before the
+  /// previous one is released, so it holds two.
+  using FramePool = FramePoolBuffer<kMaxFrameSize, 2>;
+
   Blinky();
   ~Blinky();
 
-  /// Injects this object's dependencies.
+  /// Injects this object's dependencies. Coroutine frames come from
+  /// `allocator`, which should be a `Blinky::FramePool` so that repeated
+  /// blinks do not fragment a shared heap.
   ///
   /// This method MUST be called before using any other method.
   void Init(pw::async2::Dispatcher& dispatcher,
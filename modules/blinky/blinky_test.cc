@@ -165,4 +165,22 @@ TEST_F(BlinkyTest, BlinkSlow) {
   EXPECT_GE(ToMs(event->timestamp - start), kIntervalMs * 32);
 }
 
+TEST_F(BlinkyTest, BlinkFromFramePool) {
+  Blinky::FramePool frame_pool(PW_METRIC_TOKEN("blinky frames"));
+  Blinky blinky;
+  blinky.Init(dispatcher_, frame_pool, monochrome_led_, polychrome_led_);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(blinky.Blink(1, kIntervalMs), pw::OkStatus());
+    while (!blinky.IsIdle()) {
+      dispatcher_.RunUntilStalled().IgnorePoll();
+      pw::this_thread::sleep_for(kInterval);
+    }
+  }
+
+  EXPECT_EQ(frame_pool.failures(), 0u);
+  EXPECT_LE(frame_pool.largest_request(), Blinky::kMaxFrameSize);
+  EXPECT_LE(frame_pool.peak_in_use(), 2u);
+}
+
 }  // namespace sense
@@ -0,0 +1,132 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/buttons/gesture_recognizer.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace sense {
+
+using pw::chrono::SystemClock;
+
+void GestureRecognizer::Update(SystemClock::time_point now, uint32_t states) {
+  states &= 0xf;
+  const uint32_t pressed = states & ~states_;
+  const uint32_t released = states_ & ~states;
+  states_ = states;
+
+  switch (phase_) {
+    case Phase::kIdle:
+      if (pressed == 0) {
+        return;
+      }
+      phase_ = Phase::kPending;
+      buttons_ = static_cast<uint8_t>(pressed);
+      started_ = now;
+      // A press and release within one sample is still a tap.
+      if (std::popcount(pressed) > 1 || (released & buttons_) == 0) {
+        break;
+      }
+      [[fallthrough]];
+    case Phase::kPending:
+      buttons_ |= static_cast<uint8_t>(pressed & ~released);
+      if ((released & buttons_) == 0 && now - started_ < config_.chord_window) {
+        return;
+      }
+      Commit(now);
+      break;
+    case Phase::kHeld:
+    case Phase::kChord:
+      break;
+  }
+
+  if (phase_ == Phase::kChord) {
+    if ((states_ & buttons_) == 0) {
+      phase_ = Phase::kIdle;
+    }
+    return;
+  }
+  if (phase_ != Phase::kHeld) {
+    return;
+  }
+  if ((states_ & buttons_) == 0) {
+    // Held buttons end a multi-tap sequence.
+    if (repeats_ == 0) {
+      last_tap_buttons_ = buttons_;
+      last_release_ = now;
+    } else {
+      last_tap_buttons_ = 0;
+    }
+    phase_ = Phase::kIdle;
+    return;
+  }
+  if (now < next_) {
+    return;
+  }
+  if (repeats_ == 0) {
+    Emit(ButtonGesture::kLongPress, 1, now);
+  } else {
+    Emit(ButtonGesture::kRepeat, repeats_, now);
+  }
+  repeats_ = static_cast<uint8_t>(std::min(repeats_ + 1, int{UINT8_MAX}));
+  // Repeats missed while the device was busy are skipped, not bunched up.
+  next_ += config_.repeat_interval;
+  if (next_ <= now) {
+    next_ = now + config_.repeat_interval;
+  }
+}
+
+std::optional<SystemClock::time_point> GestureRecognizer::deadline() const {
+  switch (phase_) {
+    case Phase::kPending:
+      return started_ + config_.chord_window;
+    case Phase::kHeld:
+      return next_;
+    case Phase::kIdle:
+    case Phase::kChord:
+      break;
+  }
+  return std::nullopt;
+}
+
+void GestureRecognizer::Commit(SystemClock::time_point now) {
+  if (std::popcount(buttons_) > 1) {
+    last_tap_buttons_ = 0;
+    phase_ = Phase::kChord;
+    Emit(ButtonGesture::kChord, 1, now);
+    return;
+  }
+
+  uint8_t taps = 1;
+  if (buttons_ == last_tap_buttons_ &&
+      started_ - last_release_ <= config_.multi_tap_window) {
+    taps = static_cast<uint8_t>(
+        std::min(last_tap_count_ + 1, int{UINT8_MAX}));
+  }
+  last_tap_count_ = taps;
+  phase_ = Phase::kHeld;
+  next_ = started_ + config_.long_press;
+  repeats_ = 0;
+  Emit(ButtonGesture::kPress, taps, now);
+}
+
+void GestureRecognizer::Emit(ButtonGesture::Kind kind,
+                             uint8_t count,
+                             SystemClock::time_point now) {
+  on_gesture_(ButtonGesture{
+      .kind = kind, .buttons = buttons_, .count = count, .timestamp = now});
+}
+
+}  // namespace sense
@@ -0,0 +1,108 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_function/function.h"
+
+namespace sense {
+
+/// Timing of the gestures a `GestureRecognizer` distinguishes.
+struct GestureConfig {
+  /// Buttons pressed within this long of the first are a chord. Single
+  /// presses are reported this long after they start.
+  pw::chrono::SystemClock::duration chord_window =
+      std::chrono::milliseconds(50);
+
+  /// How long a button is held before it is a long press.
+  pw::chrono::SystemClock::duration long_press = std::chrono::milliseconds(600);
+
+  /// Time between repeats while a button is held after a long press.
+  pw::chrono::SystemClock::duration repeat_interval =
+      std::chrono::milliseconds(150);
+
+  /// Longest time from a release to the next press of the same button for
+  /// the presses to count as a double tap.
+  pw::chrono::SystemClock::duration multi_tap_window =
+      std::chrono::milliseconds(300);
+};
+
+/// Turns debounced button states into `ButtonGesture`s.
+///
+/// Recognizes one gesture at a time: buttons pressed while another is held
+/// past the chord window are ignored until every button of the gesture is
+/// released. Presses are reported as soon as the chord window ends, rather
+/// than after waiting to see whether a second tap follows, so a double tap
+/// is reported as a press with a count of 1 and then one with a count of 2.
+///
+/// NOT thread safe.
+class GestureRecognizer {
+ public:
+  using Callback = pw::Function<void(const ButtonGesture&)>;
+
+  GestureRecognizer(const GestureConfig& config, Callback&& on_gesture)
+      : config_(config), on_gesture_(std::move(on_gesture)) {}
+
+  /// Updates with button states sampled at `now`, with bits 0 through 3 for
+  /// A, B, X and Y. Calls the callback with each gesture recognized.
+  void Update(pw::chrono::SystemClock::time_point now, uint32_t states);
+
+  /// Returns when `Update` must next be called for timed gestures to be
+  /// recognized on time, even if no button changes.
+  std::optional<pw::chrono::SystemClock::time_point> deadline() const;
+
+ private:
+  enum class Phase : uint8_t {
+    kIdle,
+    // Waiting out the chord window after the first press.
+    kPending,
+    // One button is held.
+    kHeld,
+    // A chord was reported; waiting for its buttons to be released.
+    kChord,
+  };
+
+  // Reports the press or chord of `buttons_`.
+  void Commit(pw::chrono::SystemClock::time_point now);
+
+  void Emit(ButtonGesture::Kind kind,
+            uint8_t count,
+            pw::chrono::SystemClock::time_point now);
+
+  const GestureConfig config_;
+  Callback on_gesture_;
+
+  Phase phase_ = Phase::kIdle;
+  uint32_t states_ = 0;
+
+  // Buttons of the current gesture and when it started.
+  uint8_t buttons_ = 0;
+  pw::chrono::SystemClock::time_point started_;
+
+  // When the held button next long-presses or repeats.
+  pw::chrono::SystemClock::time_point next_;
+  uint8_t repeats_ = 0;
+
+  // The last press that was released without a long press, for multi-taps.
+  uint8_t last_tap_buttons_ = 0;
+  uint8_t last_tap_count_ = 0;
+  pw::chrono::SystemClock::time_point last_release_;
+};
+
+}  // namespace sense
@@ -0,0 +1,150 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/buttons/gesture_recognizer.h"
+
+#include <chrono>
+
+#include "pw_containers/vector.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+using pw::chrono::SystemClock;
+
+constexpr uint32_t kA = ButtonGesture::kButtonA;
+constexpr uint32_t kB = ButtonGesture::kButtonB;
+
+class GestureRecognizerTest : public ::testing::Test {
+ protected:
+  // Advances the fake clock to `time` after the start and samples `states`.
+  void At(SystemClock::duration time, uint32_t states) {
+    recognizer_.Update(SystemClock::time_point(time), states);
+  }
+
+  const ButtonGesture& only() {
+    EXPECT_EQ(gestures_.size(), 1u);
+    return gestures_.front();
+  }
+
+  GestureConfig config_;
+  pw::Vector<ButtonGesture, 8> gestures_;
+  GestureRecognizer recognizer_{
+      config_, [this](const ButtonGesture& g) { gestures_.push_back(g); }};
+};
+
+TEST_F(GestureRecognizerTest, PressIsReportedAfterTheChordWindow) {
+  At(0ms, kA);
+  EXPECT_TRUE(gestures_.empty());
+  EXPECT_EQ(recognizer_.deadline(), SystemClock::time_point(50ms));
+
+  At(50ms, kA);
+  EXPECT_EQ(only().kind, ButtonGesture::kPress);
+  EXPECT_EQ(only().buttons, kA);
+  EXPECT_EQ(only().count, 1u);
+  EXPECT_EQ(only().timestamp, SystemClock::time_point(50ms));
+}
+
+TEST_F(GestureRecognizerTest, ShortTapIsReportedOnRelease) {
+  At(0ms, kA);
+  At(20ms, 0);
+  EXPECT_EQ(only().kind, ButtonGesture::kPress);
+  EXPECT_EQ(recognizer_.deadline(), std::nullopt);
+}
+
+TEST_F(GestureRecognizerTest, SecondTapCountsAsDoubleTap) {
+  At(0ms, kA);
+  At(80ms, 0);
+  At(300ms, kA);
+  At(360ms, 0);
+  ASSERT_EQ(gestures_.size(), 2u);
+  EXPECT_EQ(gestures_[1].kind, ButtonGesture::kPress);
+  EXPECT_EQ(gestures_[1].count, 2u);
+
+  // Too late for a triple tap.
+  At(700ms, kA);
+  At(750ms, 0);
+  ASSERT_EQ(gestures_.size(), 3u);
+  EXPECT_EQ(gestures_[2].count, 1u);
+}
+
+TEST_F(GestureRecognizerTest, OtherButtonDoesNotContinueTaps) {
+  At(0ms, kA);
+  At(80ms, 0);
+  At(200ms, kB);
+  At(260ms, 0);
+  ASSERT_EQ(gestures_.size(), 2u);
+  EXPECT_EQ(gestures_[1].buttons, kB);
+  EXPECT_EQ(gestures_[1].count, 1u);
+}
+
+TEST_F(GestureRecognizerTest, HoldingLongPressesThenRepeats) {
+  At(0ms, kA);
+  At(50ms, kA);
+  EXPECT_EQ(recognizer_.deadline(), SystemClock::time_point(600ms));
+  At(600ms, kA);
+  At(750ms, kA);
+  At(900ms, kA);
+  ASSERT_EQ(gestures_.size(), 4u);
+  EXPECT_EQ(gestures_[1].kind, ButtonGesture::kLongPress);
+  EXPECT_EQ(gestures_[2].kind, ButtonGesture::kRepeat);
+  EXPECT_EQ(gestures_[2].count, 1u);
+  EXPECT_EQ(gestures_[3].count, 2u);
+  EXPECT_EQ(recognizer_.deadline(), SystemClock::time_point(1050ms));
+
+  At(950ms, 0);
+  EXPECT_EQ(recognizer_.deadline(), std::nullopt);
+  // A long press does not start a double tap.
+  At(1000ms, kA);
+  At(1050ms, 0);
+  EXPECT_EQ(gestures_.back().count, 1u);
+}
+
+TEST_F(GestureRecognizerTest, LateUpdatesSkipMissedRepeats) {
+  At(0ms, kA);
+  At(50ms, kA);
+  At(600ms, kA);
+  At(2000ms, kA);
+  ASSERT_EQ(gestures_.size(), 3u);
+  EXPECT_EQ(recognizer_.deadline(), SystemClock::time_point(2150ms));
+}
+
+TEST_F(GestureRecognizerTest, ButtonsPressedTogetherAreAChord) {
+  At(0ms, kA);
+  At(30ms, kA | kB);
+  At(50ms, kA | kB);
+  EXPECT_EQ(only().kind, ButtonGesture::kChord);
+  EXPECT_EQ(only().buttons, kA | kB);
+
+  // Holding a chord neither long-presses nor repeats.
+  EXPECT_EQ(recognizer_.deadline(), std::nullopt);
+  At(1000ms, kA | kB);
+  At(1100ms, kB);
+  At(1200ms, 0);
+  EXPECT_EQ(gestures_.size(), 1u);
+}
+
+TEST_F(GestureRecognizerTest, ButtonPressedDuringAHoldIsIgnored) {
+  At(0ms, kA);
+  At(50ms, kA);
+  At(100ms, kA | kB);
+  At(200ms, kB);
+  At(300ms, 0);
+  EXPECT_EQ(only().buttons, kA);
+}
+
+}  // namespace
+}  // namespace sense
@@ -14,12 +14,17 @@
 #include "modules/buttons/manager.h"
 #define PW_LOG_MODULE_NAME "BUTTONS"
 
+#include <mutex>
+
+#include "modules/profiling/gpio_markers.h"
 #include "pw_assert/check.h"
 #include "pw_log/log.h"
 #include "pw_status/try.h"
 
 using pw::chrono::SystemClock;
 using pw::digital_io::DigitalIn;
+using pw::digital_io::DigitalInterrupt;
+using pw::digital_io::InterruptTrigger;
 using pw::digital_io::State;
 
 namespace sense {
@@ -47,26 +52,57 @@ EdgeDetector::StateChange EdgeDetector::UpdateState(State state) {
   return StateChange::kNone;
 }
 
-pw::Result<EdgeDetector::StateChange> Button::Sample(
-    SystemClock::time_point now) {
-  PW_TRY_ASSIGN(auto raw_state, io_.GetState());
-  auto deboucned_state = debouncer_.UpdateState(now, raw_state);
-  return edge_detector_.UpdateState(deboucned_state);
+ButtonManager::ButtonManager(DigitalIn& button_a,
+                             DigitalIn& button_b,
+                             DigitalIn& button_x,
+                             DigitalIn& button_y)
+    : input_group_(std::in_place, button_a, button_b, button_x, button_y),
+      inputs_(*input_group_),
+      timer_(pw::bind_member<&ButtonManager::SampleCallback>(this)),
+      sample_work_(pw::bind_member<&ButtonManager::Sample>(this)),
+      settle_work_(pw::bind_member<&ButtonManager::ScheduleSettle>(this)),
+      active_(false) {
+  PW_CHECK_OK(inputs_.Enable());
 }
 
-ButtonManager::ButtonManager(pw::digital_io::DigitalIn& button_a,
-                pw::digital_io::DigitalIn& button_b,
-                pw::digital_io::DigitalIn& button_x,
-                pw::digital_io::DigitalIn& button_y) : buttons_{
-                  Button(button_a),
-                  Button(button_b),
-                  Button(button_x),
-                  Button(button_y),
-                }
-    , timer_(pw::bind_member<&ButtonManager::SampleCallback>(this)), active_(false) {}
+ButtonManager::ButtonManager(MultiDigitalIn& buttons)
+    : inputs_(buttons),
+      timer_(pw::bind_member<&ButtonManager::SampleCallback>(this)),
+      sample_work_(pw::bind_member<&ButtonManager::Sample>(this)),
+      settle_work_(pw::bind_member<&ButtonManager::ScheduleSettle>(this)),
+      active_(false) {
+  PW_CHECK_OK(inputs_.Enable());
+}
 
 ButtonManager::~ButtonManager() {}
 
+void ButtonManager::UseInterrupts(DigitalInterrupt& button_a,
+                                  DigitalInterrupt& button_b,
+                                  DigitalInterrupt& button_x,
+                                  DigitalInterrupt& button_y) {
+  interrupts_ = {&button_a, &button_b, &button_x, &button_y};
+  PW_CHECK_OK(button_a.SetInterruptHandler(
+      InterruptTrigger::kBothEdges,
+      pw::bind_member<&ButtonManager::OnEdge<0>>(this)));
+  PW_CHECK_OK(button_b.SetInterruptHandler(
+      InterruptTrigger::kBothEdges,
+      pw::bind_member<&ButtonManager::OnEdge<1>>(this)));
+  PW_CHECK_OK(button_x.SetInterruptHandler(
+      InterruptTrigger::kBothEdges,
+      pw::bind_member<&ButtonManager::OnEdge<2>>(this)));
+  PW_CHECK_OK(button_y.SetInterruptHandler(
+      InterruptTrigger::kBothEdges,
+      pw::bind_member<&ButtonManager::OnEdge<3>>(this)));
+  for (DigitalInterrupt* interrupt : interrupts_) {
+    PW_CHECK_OK(interrupt->Enable());
+  }
+}
+
+void ButtonManager::EnableGestures(const GestureConfig& config) {
+  gestures_.emplace(config,
+                    [this](const ButtonGesture& gesture) { Publish(gesture); });
+}
+
 void ButtonManager::Init(PubSub& pub_sub, Worker& worker) {
   pub_sub_ = &pub_sub;
   worker_ = &worker;
@@ -75,34 +111,133 @@ void ButtonManager::Init(PubSub& pub_sub, Worker& worker) {
   Start();
 }
 
+void ButtonManager::Start() {
+  if (active_) {
+    return;
+  }
+  active_ = true;
+  if (use_interrupts()) {
+    for (DigitalInterrupt* interrupt : interrupts_) {
+      PW_CHECK_OK(interrupt->EnableInterruptHandler());
+    }
+  }
+  // When using interrupts, this first sample picks up buttons that are
+  // already held, and sampling stops once they settle.
+  timer_.InvokeAfter(kSampleInterval);
+}
+
+void ButtonManager::Stop() {
+  if (use_interrupts()) {
+    for (DigitalInterrupt* interrupt : interrupts_) {
+      PW_CHECK_OK(interrupt->DisableInterruptHandler());
+    }
+  }
+  timer_.Cancel();
+  active_ = false;
+}
+
 void ButtonManager::SampleCallback(SystemClock::time_point now) {
+  if (use_interrupts()) {
+    Settle(now);
+    return;
+  }
   PW_CHECK_NOTNULL(worker_);
-  worker_->RunOnce([this, now]() {
-    if (const auto status = SampleButtons(now); !status.ok()) {
-      PW_LOG_ERROR("Failed to sample buttons: %s", status.str());
+  sample_time_ = now;
+  sample_work_.Post(*worker_);
+}
+
+void ButtonManager::Sample() {
+  if (const auto status = SampleButtons(sample_time_); !status.ok()) {
+    PW_LOG_ERROR("Failed to sample buttons: %s", status.str());
+  }
+  // Start the periodic sampling callbacks.
+  timer_.InvokeAfter(kSampleInterval);
+}
+
+template <size_t kIndex>
+void ButtonManager::OnEdge(State state) {
+  SENSE_GPIO_MARK(kButtonEdge);
+  const SystemClock::time_point now = SystemClock::now();
+  {
+    std::lock_guard lock(lock_);
+    debouncer_.RecordState(kIndex, now, state == State::kActive);
+    settle_time_ = now + Debouncer::kDebounceInterval;
+  }
+  // Timers are armed from the worker rather than the interrupt.
+  settle_work_.Post(*worker_);
+}
+
+void ButtonManager::ScheduleSettle() {
+  SystemClock::time_point settle_time;
+  {
+    std::lock_guard lock(lock_);
+    settle_time = settle_time_;
+  }
+  timer_.InvokeAt(settle_time);
+}
+
+void ButtonManager::Settle(SystemClock::time_point now) {
+  pw::Status status;
+  bool settled;
+  std::optional<SystemClock::time_point> gesture_deadline;
+  {
+    std::lock_guard lock(lock_);
+    status = SampleButtons(now);
+    settled = debouncer_.settled();
+    if (gestures_.has_value()) {
+      gesture_deadline = gestures_->deadline();
     }
-    // Start the periodic sampling callbacks.
+  }
+  if (!status.ok()) {
+    PW_LOG_ERROR("Failed to sample buttons: %s", status.str());
+  }
+
+  // An edge may have been missed, e.g. if a button bounced faster than its
+  // interrupt could be handled. Keep sampling until the inputs are stable.
+  if (!settled) {
     timer_.InvokeAfter(kSampleInterval);
-  });
+  } else if (gesture_deadline.has_value()) {
+    // Held buttons make no edges, so sample again when a long press or
+    // repeat is due.
+    timer_.InvokeAt(*gesture_deadline);
+  }
 }
 
-template <typename ButtonEvent>
-pw::Status ButtonManager::SampleButton(Button& button,
-                                       SystemClock::time_point now) {
-  PW_TRY_ASSIGN(auto state_change, button.Sample(now));
-  if (state_change == EdgeDetector::StateChange::kActivate) {
-    std::ignore = pub_sub_->Publish(ButtonEvent(true));
-  } else if (state_change == EdgeDetector::StateChange::kDeactivate) {
-    std::ignore = pub_sub_->Publish(ButtonEvent(false));
+void ButtonManager::Publish(Event event) {
+  SENSE_GPIO_MARK(kButtonPublish);
+  if (use_interrupts()) {
+    std::ignore = pub_sub_->PublishFromInterrupt(event);
+  } else {
+    std::ignore = pub_sub_->Publish(event);
+  }
+}
+
+template <typename ButtonEvent, size_t kIndex>
+void ButtonManager::PublishEdges(const EdgeDetectorBank::Edges& edges,
+                                 SystemClock::time_point now) {
+  constexpr uint32_t kBit = uint32_t{1} << kIndex;
+  if ((edges.activated & kBit) != 0) {
+    Publish(ButtonEvent(true, now));
+  } else if ((edges.deactivated & kBit) != 0) {
+    Publish(ButtonEvent(false, now));
   }
-  return pw::OkStatus();
 }
 
 pw::Status ButtonManager::SampleButtons(SystemClock::time_point now) {
-  PW_TRY(SampleButton<sense::ButtonA>(buttons_[0], now));
-  PW_TRY(SampleButton<sense::ButtonB>(buttons_[1], now));
-  PW_TRY(SampleButton<sense::ButtonX>(buttons_[2], now));
-  PW_TRY(SampleButton<sense::ButtonY>(buttons_[3], now));
+  PW_TRY_ASSIGN(const uint32_t states, inputs_.GetStates());
+  const uint32_t debounced = debouncer_.UpdateState(now, states);
+  if (gestures_.has_value()) {
+    gestures_->Update(now, debounced);
+    return pw::OkStatus();
+  }
+  const EdgeDetectorBank::Edges edges = edge_detector_.UpdateState(debounced);
+  if ((edges.activated | edges.deactivated) == 0) {
+    return pw::OkStatus();
+  }
+  PublishEdges<ButtonA, 0>(edges, now);
+  PublishEdges<ButtonB, 1>(edges, now);
+  PublishEdges<ButtonX, 2>(edges, now);
+  PublishEdges<ButtonY, 3>(edges, now);
   return pw::OkStatus();
 }
 
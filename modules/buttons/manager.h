@@ -13,9 +13,17 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 
+#include "modules/buttons/gesture_recognizer.h"
+#include "modules/buttons/multi_digital_in.h"
 #include "modules/pubsub/pubsub_events.h"
+#include "modules/worker/work_item.h"
 #include "modules/worker/worker.h"
 #include "pw_assert/check.h"
 #include "pw_chrono/system_clock.h"
@@ -61,19 +69,89 @@ class EdgeDetector final {
   pw::digital_io::State current_state_;
 };
 
-class Button {
+/// Debounces several inputs at once, given their states as a bitmask with bit
+/// `i` set if input `i` is active.
+///
+/// Each bit behaves like a `Debouncer`: its output follows the input once the
+/// input has been stable for `kDebounceInterval`. Inputs are compared with
+/// bitwise operations, so only those that changed or are still settling cost
+/// anything per update.
+template <size_t kNumInputs>
+class DebouncerBank final {
  public:
-  Button(pw::digital_io::DigitalIn& io) : io_(io) {
-    PW_CHECK_OK(io_.Enable());
+  static_assert(kNumInputs <= 32, "A bank holds at most 32 inputs");
+
+  constexpr static pw::chrono::SystemClock::duration kDebounceInterval =
+      Debouncer::kDebounceInterval;
+
+  DebouncerBank() {
+    last_update_.fill(pw::chrono::SystemClock::time_point::min());
+  }
+
+  /// Updates the inputs with states sampled at `now`. Returns the debounced
+  /// states.
+  uint32_t UpdateState(pw::chrono::SystemClock::time_point now,
+                       uint32_t states) {
+    RecordStates(now, states);
+    uint32_t pending = last_input_ ^ output_;
+    while (pending != 0) {
+      const int index = std::countr_zero(pending);
+      const uint32_t bit = uint32_t{1} << index;
+      pending &= ~bit;
+      if (now - last_update_[index] >= kDebounceInterval) {
+        output_ ^= bit;
+      }
+    }
+    return output_;
+  }
+
+  /// Records the new state of one input, e.g. from an edge interrupt, without
+  /// updating the debounced states.
+  void RecordState(size_t index,
+                   pw::chrono::SystemClock::time_point now,
+                   bool active) {
+    const uint32_t bit = uint32_t{1} << index;
+    RecordStates(now, active ? last_input_ | bit : last_input_ & ~bit);
+  }
+
+  /// Returns whether the debounced states have caught up with the inputs.
+  bool settled() const { return output_ == last_input_; }
+
+ private:
+  static constexpr uint32_t kMask =
+      kNumInputs == 32 ? ~uint32_t{0} : (uint32_t{1} << kNumInputs) - 1;
+
+  void RecordStates(pw::chrono::SystemClock::time_point now, uint32_t states) {
+    uint32_t changed = (states ^ last_input_) & kMask;
+    last_input_ = states & kMask;
+    while (changed != 0) {
+      const int index = std::countr_zero(changed);
+      changed &= changed - 1;
+      last_update_[index] = now;
+    }
+  }
+
+  std::array<pw::chrono::SystemClock::time_point, kNumInputs> last_update_;
+  uint32_t last_input_ = 0;
+  uint32_t output_ = 0;
+};
+
+/// Detects edges of several inputs at once, given their states as a bitmask.
+class EdgeDetectorBank final {
+ public:
+  struct Edges {
+    uint32_t activated;
+    uint32_t deactivated;
   };
 
-  pw::Result<EdgeDetector::StateChange> Sample(
-      pw::chrono::SystemClock::time_point now);
+  Edges UpdateState(uint32_t states) {
+    const uint32_t changed = states ^ current_states_;
+    current_states_ = states;
+    return {.activated = changed & states, .deactivated = changed & ~states};
+  }
 
  private:
-  pw::digital_io::DigitalIn& io_;
-  Debouncer debouncer_ = Debouncer(pw::digital_io::State::kInactive);
-  EdgeDetector edge_detector_ = EdgeDetector(pw::digital_io::State::kInactive);
+  uint32_t current_states_ = 0;
 };
 
 /// DOCME
@@ -86,35 +164,89 @@ class ButtonManager final {
                 pw::digital_io::DigitalIn& button_b,
                 pw::digital_io::DigitalIn& button_x,
                 pw::digital_io::DigitalIn& button_y);
+
+  /// Samples all of the buttons with a single read. Bits 0 through 3 of
+  /// `buttons` are A, B, X, and Y.
+  explicit ButtonManager(MultiDigitalIn& buttons);
+
   ~ButtonManager();
 
+  /// Captures button edges with GPIO interrupts instead of sampling every
+  /// `kSampleInterval`. Buttons are then only sampled once they have been
+  /// stable for the debounce interval after an edge, so idle buttons never
+  /// wake the device. Events are published from the timer callback.
+  ///
+  /// Each interrupt must watch the same pin as the corresponding input.
+  /// Must be called before `Init`.
+  void UseInterrupts(pw::digital_io::DigitalInterrupt& button_a,
+                     pw::digital_io::DigitalInterrupt& button_b,
+                     pw::digital_io::DigitalInterrupt& button_x,
+                     pw::digital_io::DigitalInterrupt& button_y);
+
+  /// Publishes a `ButtonGesture` for each press, long press, repeat or chord
+  /// instead of a `ButtonA` through `ButtonY` event for every press and
+  /// release. Must be called before `Init`.
+  void EnableGestures(const GestureConfig& config = {});
+
   void Init(PubSub& pub_sub, Worker& worker);
 
-  void Start() {
-    if (!active_) {
-      timer_.InvokeAfter(kSampleInterval);
-    }
-    active_ = true;
-  }
+  void Start();
 
-  void Stop() {
-    timer_.Cancel();
-    active_ = false;
-  }
+  void Stop();
 
  private:
-  Button buttons_[4];
+  static constexpr size_t kNumButtons = 4;
+
+  // Only set when constructed from separate inputs.
+  std::optional<DigitalInGroup<kNumButtons>> input_group_;
+  MultiDigitalIn& inputs_;
+
+  // Guarded by `lock_` when using interrupts, since edges are recorded by
+  // their handlers.
+  DebouncerBank<kNumButtons> debouncer_;
+  EdgeDetectorBank edge_detector_;
+  // Set by `EnableGestures`. Updated with the debouncer, so guarded likewise.
+  std::optional<GestureRecognizer> gestures_;
+
+  bool use_interrupts() const { return interrupts_[0] != nullptr; }
 
-  pw::Status ScheduleSampleCallback();
   void SampleCallback(pw::chrono::SystemClock::time_point);
+  void Sample();
+
+  /// Interrupt handler for edges on the button at `kIndex`.
+  template <size_t kIndex>
+  void OnEdge(pw::digital_io::State state) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Arms the timer to sample the buttons once the last edge has settled.
+  void ScheduleSettle() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Samples the buttons after edges, until all of them have settled.
+  void Settle(pw::chrono::SystemClock::time_point) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Publishes from the worker when polling, and from the timer callback when
+  /// using interrupts.
+  void Publish(Event event);
+
+  /// Publishes the edges of the button at `kIndex`, if any, stamped with the
+  /// time of the sample that found them.
+  template <typename ButtonEvent, size_t kIndex>
+  void PublishEdges(const EdgeDetectorBank::Edges& edges,
+                    pw::chrono::SystemClock::time_point now);
 
-  template <typename ButtonEvent>
-  pw::Status SampleButton(Button& button, pw::chrono::SystemClock::time_point);
   pw::Status SampleButtons(pw::chrono::SystemClock::time_point);
 
   PubSub* pub_sub_ = nullptr;
   Worker* worker_ = nullptr;
+  std::array<pw::digital_io::DigitalInterrupt*, kNumButtons> interrupts_{};
   pw::chrono::SystemTimer timer_;
+  WorkItem sample_work_;
+  WorkItem settle_work_;
+
+  pw::sync::InterruptSpinLock lock_;
+  pw::chrono::SystemClock::time_point settle_time_ PW_GUARDED_BY(lock_);
+  // Written by the timer and read by `sample_work_`. The timer is only re-armed
+  // once sampling completes, so the two never overlap.
+  pw::chrono::SystemClock::time_point sample_time_;
   bool active_;
 };
 }  // namespace sense
@@ -19,6 +19,7 @@
 #include "pw_status/status.h"
 #include "pw_sync/interrupt_spin_lock.h"
 #include "pw_sync/timed_thread_notification.h"
+#include "pw_thread/sleep.h"
 #include "pw_unit_test/framework.h"
 
 using ::pw::chrono::SystemClock;
@@ -68,6 +69,50 @@ class TestDigitalInOut : public DigitalInOut {
   int settle_iterations_ PW_GUARDED_BY(lock_) = 0;
 };
 
+class TestDigitalInterrupt : public pw::digital_io::DigitalInterrupt {
+ public:
+  /// Calls the handler as if an edge was seen, if it is enabled.
+  void Trigger(State state) {
+    if (enabled_ && handler_ != nullptr) {
+      handler_(state);
+    }
+  }
+
+ private:
+  pw::Status DoEnable(bool) override { return pw::OkStatus(); }
+  pw::Status DoSetInterruptHandler(
+      pw::digital_io::InterruptTrigger,
+      pw::digital_io::InterruptHandler&& handler) override {
+    handler_ = std::move(handler);
+    return pw::OkStatus();
+  }
+  pw::Status DoEnableInterruptHandler(bool enable) override {
+    enabled_ = enable;
+    return pw::OkStatus();
+  }
+
+  pw::digital_io::InterruptHandler handler_;
+  bool enabled_ = false;
+};
+
+class TestMultiDigitalIn : public MultiDigitalIn {
+ public:
+  void SetStates(uint32_t states) {
+    std::lock_guard lock(lock_);
+    states_ = states;
+  }
+
+ private:
+  pw::Status DoEnable() override { return pw::OkStatus(); }
+  pw::Result<uint32_t> DoGetStates() override {
+    std::lock_guard lock(lock_);
+    return states_;
+  }
+
+  InterruptSpinLock lock_;
+  uint32_t states_ PW_GUARDED_BY(lock_) = 0;
+};
+
 // A test harness for writing tests that use pubsub.
 class ManagerTest : public ::testing::Test {
  public:
@@ -110,7 +155,7 @@ class ManagerTest : public ::testing::Test {
     return true;
   }
 
-  pw::InlineDeque<Event, 4> event_queue_;
+  PackedEventQueueBuffer<Event, 4> event_queue_;
   std::array<typename PubSub::Subscriber, 4> subscribers_buffer_;
   std::optional<Event> last_event_;
   int events_processed_ = 0;
@@ -120,6 +165,11 @@ class ManagerTest : public ::testing::Test {
   TestDigitalInOut io_b_;
   TestDigitalInOut io_x_;
   TestDigitalInOut io_y_;
+
+  TestDigitalInterrupt irq_a_;
+  TestDigitalInterrupt irq_b_;
+  TestDigitalInterrupt irq_x_;
+  TestDigitalInterrupt irq_y_;
 };
 
 TEST(DebounceTest, SingleEdgePropagatesAfterDelay) {
@@ -256,6 +306,70 @@ TEST(EdgeDetectorTest, EdgesDetected) {
             EdgeDetector::StateChange::kNone);
 }
 
+TEST(DebouncerBankTest, EachInputDebouncesSeparately) {
+  DebouncerBank<4> debouncer;
+  auto time = SystemClock::now();
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0000), 0b0000u);
+
+  // Input 0 becomes active, then input 2 does 10ms later.
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0001), 0b0000u);
+  time += 10ms;
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0101), 0b0000u);
+  EXPECT_FALSE(debouncer.settled());
+
+  // Each propagates once it has been stable for the debounce interval.
+  time += Debouncer::kDebounceInterval - 10ms;
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0101), 0b0001u);
+  time += 10ms;
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0101), 0b0101u);
+  EXPECT_TRUE(debouncer.settled());
+}
+
+TEST(DebouncerBankTest, RapidStateChangesAreDebounced) {
+  DebouncerBank<4> debouncer;
+  auto time = SystemClock::now();
+  EXPECT_EQ(debouncer.UpdateState(time, 0b0000), 0b0000u);
+
+  // Input 1 changes once every ms for 10ms, while input 3 is held active.
+  for (int i = 0; i < 10; ++i) {
+    time += 1ms;
+    const uint32_t states = i % 2 == 1 ? 0b1010 : 0b1000;
+    EXPECT_EQ(debouncer.UpdateState(time, states), 0b0000u);
+  }
+
+  // Input 3 settles first, since input 1 last changed 9ms after it.
+  time += Debouncer::kDebounceInterval - 9ms;
+  EXPECT_EQ(debouncer.UpdateState(time, 0b1010), 0b1000u);
+  time += 9ms;
+  EXPECT_EQ(debouncer.UpdateState(time, 0b1010), 0b1010u);
+}
+
+TEST(DebouncerBankTest, RecordedStatesPropagateOnNextUpdate) {
+  DebouncerBank<4> debouncer;
+  auto time = SystemClock::now();
+  debouncer.RecordState(3, time, true);
+  EXPECT_FALSE(debouncer.settled());
+  EXPECT_EQ(debouncer.UpdateState(time + Debouncer::kDebounceInterval, 0b1000),
+            0b1000u);
+  EXPECT_TRUE(debouncer.settled());
+}
+
+TEST(EdgeDetectorBankTest, EdgesDetected) {
+  EdgeDetectorBank edge_detector;
+
+  auto edges = edge_detector.UpdateState(0b0011);
+  EXPECT_EQ(edges.activated, 0b0011u);
+  EXPECT_EQ(edges.deactivated, 0b0000u);
+
+  edges = edge_detector.UpdateState(0b0110);
+  EXPECT_EQ(edges.activated, 0b0100u);
+  EXPECT_EQ(edges.deactivated, 0b0001u);
+
+  edges = edge_detector.UpdateState(0b0110);
+  EXPECT_EQ(edges.activated, 0b0000u);
+  EXPECT_EQ(edges.deactivated, 0b0000u);
+}
+
 TEST_F(ManagerTest, AllButtonsTurnOnAndOffEvents) {
   sense::TestWorker<> worker;
   PubSub pubsub(worker, event_queue_, subscribers_buffer_);
@@ -295,6 +409,32 @@ TEST_F(ManagerTest, AllButtonsTurnOnAndOffEvents) {
   worker.Stop();
 }
 
+TEST_F(ManagerTest, PortReadsAllButtonsAtOnce) {
+  sense::TestWorker<> worker;
+  PubSub pubsub(worker, event_queue_, subscribers_buffer_);
+  TestMultiDigitalIn port;
+  ButtonManager manager(port);
+  manager.Init(pubsub, worker);
+
+  ASSERT_TRUE(pubsub.Subscribe([this](Event event) {
+    last_event_ = event;
+    events_processed_ += 1;
+    notification_.release();
+  }));
+
+  port.SetStates(0b0100);
+  ASSERT_TRUE(AssertPressed<sense::ButtonX>());
+
+  port.SetStates(0b1100);
+  ASSERT_TRUE(AssertPressed<sense::ButtonY>());
+
+  port.SetStates(0b1000);
+  ASSERT_TRUE(AssertPressed<sense::ButtonX>(false));
+  EXPECT_EQ(events_processed_, 3);
+
+  worker.Stop();
+}
+
 TEST_F(ManagerTest, DebouncingWorksOnNoisyIo) {
   sense::TestWorker<> worker;
   PubSub pubsub(worker, event_queue_, subscribers_buffer_);
@@ -321,4 +461,69 @@ TEST_F(ManagerTest, DebouncingWorksOnNoisyIo) {
 
   worker.Stop();
 }
+
+TEST_F(ManagerTest, InterruptsSampleOnlyAfterEdges) {
+  sense::TestWorker<> worker;
+  PubSub pubsub(worker, event_queue_, subscribers_buffer_);
+  ASSERT_TRUE(pubsub.Subscribe([this](Event event) {
+    last_event_ = event;
+    events_processed_ += 1;
+    notification_.release();
+  }));
+
+  ButtonManager manager(io_a_, io_b_, io_x_, io_y_);
+  manager.UseInterrupts(irq_a_, irq_b_, irq_x_, irq_y_);
+  manager.Init(pubsub, worker);
+
+  // Let the initial sample settle, after which nothing polls the inputs.
+  pw::this_thread::sleep_for(Debouncer::kDebounceInterval * 2);
+  ASSERT_EQ(pw::OkStatus(), io_b_.SetState(State::kActive));
+  EXPECT_FALSE(notification_.try_acquire_for(Debouncer::kDebounceInterval * 3));
+
+  irq_b_.Trigger(State::kActive);
+  ASSERT_TRUE(AssertPressed<sense::ButtonB>());
+
+  ASSERT_EQ(pw::OkStatus(), io_b_.SetState(State::kInactive));
+  irq_b_.Trigger(State::kInactive);
+  ASSERT_TRUE(AssertPressed<sense::ButtonB>(false));
+  EXPECT_EQ(events_processed_, 2);
+
+  worker.Stop();
+}
+
+TEST_F(ManagerTest, GesturesAreTimedWithoutEdges) {
+  sense::TestWorker<> worker;
+  PubSub pubsub(worker, event_queue_, subscribers_buffer_);
+  ASSERT_TRUE(pubsub.Subscribe([this](Event event) {
+    last_event_ = event;
+    events_processed_ += 1;
+    notification_.release();
+  }));
+
+  ButtonManager manager(io_a_, io_b_, io_x_, io_y_);
+  manager.UseInterrupts(irq_a_, irq_b_, irq_x_, irq_y_);
+  manager.EnableGestures({.long_press = 100ms});
+  manager.Init(pubsub, worker);
+  pw::this_thread::sleep_for(Debouncer::kDebounceInterval * 2);
+
+  // Only the press edge is seen; the long press still follows.
+  ASSERT_EQ(pw::OkStatus(), io_b_.SetState(State::kActive));
+  irq_b_.Trigger(State::kActive);
+  for (ButtonGesture::Kind kind :
+       {ButtonGesture::kPress, ButtonGesture::kLongPress}) {
+    ASSERT_TRUE(notification_.try_acquire_for(kMaxWaitOnFailedTest));
+    ASSERT_TRUE(std::holds_alternative<ButtonGesture>(*last_event_));
+    EXPECT_EQ(std::get<ButtonGesture>(*last_event_).kind, kind);
+    EXPECT_EQ(std::get<ButtonGesture>(*last_event_).buttons,
+              ButtonGesture::kButtonB);
+  }
+
+  // Releasing publishes nothing.
+  ASSERT_EQ(pw::OkStatus(), io_b_.SetState(State::kInactive));
+  irq_b_.Trigger(State::kInactive);
+  EXPECT_FALSE(notification_.try_acquire_for(Debouncer::kDebounceInterval * 3));
+
+  worker.Stop();
+}
+
 }  // namespace sense
@@ -0,0 +1,83 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_digital_io/digital_io.h"
+#include "pw_result/result.h"
+#include "pw_status/status.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+/// Group of digital inputs that are read together, such as several pins of
+/// one GPIO port.
+class MultiDigitalIn {
+ public:
+  virtual ~MultiDigitalIn() = default;
+
+  /// Enables all of the inputs.
+  pw::Status Enable() { return DoEnable(); }
+
+  /// Returns the states of all of the inputs, with bit `i` set if input `i` is
+  /// active.
+  pw::Result<uint32_t> GetStates() { return DoGetStates(); }
+
+ protected:
+  MultiDigitalIn() = default;
+
+ private:
+  virtual pw::Status DoEnable() = 0;
+
+  virtual pw::Result<uint32_t> DoGetStates() = 0;
+};
+
+/// `MultiDigitalIn` made of separate `DigitalIn`s, which are read one at a
+/// time. Useful for targets that cannot read their inputs at once.
+template <size_t kNumInputs>
+class DigitalInGroup final : public MultiDigitalIn {
+ public:
+  static_assert(kNumInputs <= 32, "A group holds at most 32 inputs");
+
+  template <typename... Inputs>
+  explicit DigitalInGroup(Inputs&... inputs) : inputs_{&inputs...} {
+    static_assert(sizeof...(Inputs) == kNumInputs);
+  }
+
+ private:
+  pw::Status DoEnable() override {
+    for (pw::digital_io::DigitalIn* input : inputs_) {
+      PW_TRY(input->Enable());
+    }
+    return pw::OkStatus();
+  }
+
+  pw::Result<uint32_t> DoGetStates() override {
+    uint32_t states = 0;
+    for (size_t i = 0; i < kNumInputs; ++i) {
+      PW_TRY_ASSIGN(const pw::digital_io::State state, inputs_[i]->GetState());
+      if (state == pw::digital_io::State::kActive) {
+        states |= uint32_t{1} << i;
+      }
+    }
+    return states;
+  }
+
+  std::array<pw::digital_io::DigitalIn*, kNumInputs> inputs_;
+};
+
+}  // namespace sense
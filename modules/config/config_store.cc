@@ -0,0 +1,128 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "CONFIG"
+
+#include "modules/config/config_store.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "pw_bytes/span.h"
+#include "pw_log/log.h"
+
+namespace sense {
+
+ConfigStore::ConfigStore(Clock::duration flush_delay)
+    : flush_delay_(flush_delay), timer_([this](Clock::time_point) {
+        if (!worker_->RunOnce([this] {
+              flush_scheduled_.store(false, std::memory_order_relaxed);
+              std::ignore = Flush();
+            })) {
+          // Otherwise no later `Set` would schedule a flush again.
+          flush_scheduled_.store(false, std::memory_order_relaxed);
+          ScheduleFlush();
+        }
+      }) {}
+
+void ConfigStore::Init(Worker& worker) {
+  worker_ = &worker;
+  if (dirty()) {
+    ScheduleFlush();
+  }
+}
+
+pw::Status ConfigStore::Init(Worker& worker, pw::kvs::KeyValueStore& kvs) {
+  kvs_ = &kvs;
+
+  Record record = {};
+  pw::StatusWithSize result = kvs.Get(kKvsKey, pw::as_writable_bytes(
+                                                   pw::span(&record, 1)));
+  pw::Status status = result.status();
+  if (status.IsResourceExhausted()) {
+    // Written by newer firmware with more keys; keep the ones known here.
+    status = pw::OkStatus();
+  }
+  if (status.ok() && (result.size() < Record::kHeaderSize ||
+                      record.version != Record::kVersion)) {
+    status = pw::Status::DataLoss();
+  }
+  if (status.ok()) {
+    // Only the keys that were written fit in a shorter entry.
+    const size_t stored_keys = std::min(
+        kNumKeys, (result.size() - Record::kHeaderSize) / sizeof(uint32_t));
+    const uint32_t stored_mask =
+        stored_keys == 32 ? ~0u : (1u << stored_keys) - 1;
+    for (size_t i = 0; i < stored_keys; ++i) {
+      values_[i].store(record.values[i], std::memory_order_relaxed);
+    }
+    present_.store(record.present & stored_mask, std::memory_order_release);
+  } else if (!status.IsNotFound()) {
+    PW_LOG_WARN("Discarding saved settings: %s", status.str());
+  }
+
+  Init(worker);
+  return status;
+}
+
+void ConfigStore::Set(Key key, uint32_t value) {
+  const auto index = static_cast<size_t>(key);
+  if (Get(key) == value) {
+    return;
+  }
+  values_[index].store(value, std::memory_order_relaxed);
+  present_.fetch_or(1u << index, std::memory_order_release);
+  dirty_.store(true, std::memory_order_relaxed);
+  sets_.Increment();
+  if (worker_ != nullptr) {
+    ScheduleFlush();
+  }
+}
+
+void ConfigStore::ScheduleFlush() {
+  if (!flush_scheduled_.exchange(true, std::memory_order_relaxed)) {
+    timer_.InvokeAfter(flush_delay_);
+  }
+}
+
+pw::Status ConfigStore::Flush() {
+  if (!dirty_.exchange(false, std::memory_order_relaxed)) {
+    return pw::OkStatus();
+  }
+  if (kvs_ == nullptr) {
+    return pw::OkStatus();
+  }
+
+  Record record = {
+      .version = Record::kVersion,
+      .present = present_.load(std::memory_order_acquire),
+      .values = {},
+  };
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    record.values[i] = values_[i].load(std::memory_order_relaxed);
+  }
+
+  pw::Status status = kvs_->Put(kKvsKey, record);
+  if (!status.ok()) {
+    // Try again with the next change rather than retrying a failing flash.
+    dirty_.store(true, std::memory_order_relaxed);
+    flush_errors_.Increment();
+    PW_LOG_WARN("Failed to save settings: %s", status.str());
+    return status;
+  }
+  flushes_.Increment();
+  return pw::OkStatus();
+}
+
+}  // namespace sense
@@ -0,0 +1,126 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_kvs/key_value_store.h"
+#include "pw_metric/metric.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Settings that survive a reboot, such as those changed over RPC.
+///
+/// Values are cached in RAM, so `Get` is a pair of relaxed atomic loads and
+/// safe to call from any thread on a hot path. `Set` only updates the cache;
+/// changes are written to the key-value store together, as one entry, a
+/// flush delay after the first unsaved change. Adjusting a setting several
+/// times in a row therefore costs a single flash write.
+class ConfigStore {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  /// Settings are stored by position, so new keys must go at the end.
+  enum class Key : size_t {
+    kAlarmThreshold = 0,
+    kProximityPeriodMs,
+    kAmbientLightPeriodMs,
+    kAirPeriodMs,
+  };
+  static constexpr size_t kNumKeys = 4;
+
+  static constexpr std::string_view kKvsKey = "config";
+
+  static constexpr Clock::duration kDefaultFlushDelay =
+      std::chrono::seconds(10);
+
+  explicit ConfigStore(Clock::duration flush_delay = kDefaultFlushDelay);
+
+  ConfigStore(const ConfigStore&) = delete;
+  ConfigStore& operator=(const ConfigStore&) = delete;
+
+  /// Keeps settings in RAM only, for targets without persistent storage.
+  void Init(Worker& worker);
+
+  /// Loads the settings saved in `kvs` and saves later changes to it. Saves
+  /// are written from `worker`, which must tolerate a flash erase.
+  pw::Status Init(Worker& worker, pw::kvs::KeyValueStore& kvs);
+
+  /// Returns a setting, or `std::nullopt` if it has never been set.
+  std::optional<uint32_t> Get(Key key) const {
+    const auto index = static_cast<size_t>(key);
+    if ((present_.load(std::memory_order_acquire) & (1u << index)) == 0) {
+      return std::nullopt;
+    }
+    return values_[index].load(std::memory_order_relaxed);
+  }
+
+  uint32_t Get(Key key, uint32_t default_value) const {
+    return Get(key).value_or(default_value);
+  }
+
+  /// Changes a setting. Does nothing if it already has `value`.
+  void Set(Key key, uint32_t value);
+
+  /// Writes any pending changes now instead of waiting for the flush delay.
+  pw::Status Flush();
+
+  /// Whether there are changes that have not been written.
+  bool dirty() const { return dirty_.load(std::memory_order_relaxed); }
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+ private:
+  // Versioned so that a change to the layout discards old entries. Entries
+  // written with fewer keys still load; the missing keys are left unset.
+  struct Record {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 2 * sizeof(uint32_t);
+
+    uint32_t version;
+    uint32_t present;
+    std::array<uint32_t, kNumKeys> values;
+  };
+
+  // The present mask must fit a bit per key.
+  static_assert(kNumKeys <= 32);
+
+  void ScheduleFlush();
+
+  const Clock::duration flush_delay_;
+  Worker* worker_ = nullptr;
+  pw::kvs::KeyValueStore* kvs_ = nullptr;
+  pw::chrono::SystemTimer timer_;
+
+  std::array<std::atomic<uint32_t>, kNumKeys> values_ = {};
+  std::atomic<uint32_t> present_ = 0;
+  std::atomic<bool> dirty_ = false;
+  std::atomic<bool> flush_scheduled_ = false;
+
+  PW_METRIC_GROUP(metrics_, "config");
+  PW_METRIC(metrics_, sets_, "sets", 0u);
+  PW_METRIC(metrics_, flushes_, "flushes", 0u);
+  PW_METRIC(metrics_, flush_errors_, "flush_errors", 0u);
+};
+
+}  // namespace sense
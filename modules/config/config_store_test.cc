@@ -0,0 +1,176 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/config/config_store.h"
+
+#include <chrono>
+#include <utility>
+
+#include "pw_containers/vector.h"
+#include "pw_kvs/crc16_checksum.h"
+#include "pw_kvs/fake_flash_memory.h"
+#include "pw_kvs/flash_memory.h"
+#include "pw_kvs/key_value_store.h"
+#include "pw_sync/timed_thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using Key = ConfigStore::Key;
+
+// Holds work until the test runs it.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+};
+
+// Rejects the first posts like a full queue, then runs work right away.
+class FlakyWorker final : public Worker {
+ public:
+  explicit FlakyWorker(int rejections) : rejections_(rejections) {}
+
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (rejections_ > 0) {
+      --rejections_;
+      return false;
+    }
+    work();
+    ran_.release();
+    return true;
+  }
+
+  pw::sync::TimedThreadNotification& ran() { return ran_; }
+
+ private:
+  int rejections_;
+  pw::sync::TimedThreadNotification ran_;
+};
+
+class ConfigStoreTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kSectorSize = 512;
+  static constexpr size_t kSectors = 4;
+
+  // Long enough that the timer never flushes during a test.
+  static constexpr auto kFlushDelay = std::chrono::hours(1);
+
+  ConfigStoreTest()
+      : partition_(&flash_),
+        kvs_(&partition_, {.magic = 0xc0f16500, .checksum = &checksum_}),
+        store_(kFlushDelay) {}
+
+  void SetUp() override { ASSERT_EQ(kvs_.Init(), pw::OkStatus()); }
+
+  pw::kvs::FakeFlashMemoryBuffer<kSectorSize, kSectors> flash_;
+  pw::kvs::FlashPartition partition_;
+  pw::kvs::ChecksumCrc16 checksum_;
+  pw::kvs::KeyValueStoreBuffer<4, kSectors> kvs_;
+  ManualWorker worker_;
+  ConfigStore store_;
+};
+
+TEST_F(ConfigStoreTest, UnsetKeysUseDefault) {
+  EXPECT_EQ(store_.Init(worker_, kvs_), pw::Status::NotFound());
+  EXPECT_FALSE(store_.Get(Key::kAlarmThreshold).has_value());
+  EXPECT_EQ(store_.Get(Key::kAlarmThreshold, 300), 300u);
+}
+
+TEST_F(ConfigStoreTest, SetIsCachedUntilFlush) {
+  std::ignore = store_.Init(worker_, kvs_);
+  store_.Set(Key::kAlarmThreshold, 200);
+  EXPECT_EQ(store_.Get(Key::kAlarmThreshold), 200u);
+  EXPECT_TRUE(store_.dirty());
+  EXPECT_EQ(kvs_.size(), 0u);
+
+  ASSERT_EQ(store_.Flush(), pw::OkStatus());
+  EXPECT_FALSE(store_.dirty());
+  EXPECT_EQ(kvs_.size(), 1u);
+}
+
+TEST_F(ConfigStoreTest, SettingSameValueIsNotAChange) {
+  std::ignore = store_.Init(worker_, kvs_);
+  store_.Set(Key::kAirPeriodMs, 3000);
+  ASSERT_EQ(store_.Flush(), pw::OkStatus());
+  store_.Set(Key::kAirPeriodMs, 3000);
+  EXPECT_FALSE(store_.dirty());
+}
+
+TEST_F(ConfigStoreTest, ChangesAreRestored) {
+  std::ignore = store_.Init(worker_, kvs_);
+  store_.Set(Key::kAlarmThreshold, 100);
+  store_.Set(Key::kAlarmThreshold, 200);
+  store_.Set(Key::kProximityPeriodMs, 250);
+  ASSERT_EQ(store_.Flush(), pw::OkStatus());
+
+  ConfigStore restored(kFlushDelay);
+  ASSERT_EQ(restored.Init(worker_, kvs_), pw::OkStatus());
+  EXPECT_EQ(restored.Get(Key::kAlarmThreshold), 200u);
+  EXPECT_EQ(restored.Get(Key::kProximityPeriodMs), 250u);
+  EXPECT_FALSE(restored.Get(Key::kAirPeriodMs).has_value());
+  EXPECT_FALSE(restored.dirty());
+}
+
+TEST_F(ConfigStoreTest, ShorterEntryLoadsKeysItHas) {
+  struct {
+    uint32_t version = 1;
+    uint32_t present = 0b11;
+    uint32_t values[1] = {42};
+  } old_record;
+  ASSERT_EQ(kvs_.Put(ConfigStore::kKvsKey, old_record), pw::OkStatus());
+
+  ASSERT_EQ(store_.Init(worker_, kvs_), pw::OkStatus());
+  EXPECT_EQ(store_.Get(Key::kAlarmThreshold), 42u);
+  EXPECT_FALSE(store_.Get(Key::kProximityPeriodMs).has_value());
+}
+
+TEST_F(ConfigStoreTest, OtherVersionIsDiscarded) {
+  struct {
+    uint32_t version = 99;
+    uint32_t present = 0b1;
+    uint32_t values[ConfigStore::kNumKeys] = {42};
+  } other_record;
+  ASSERT_EQ(kvs_.Put(ConfigStore::kKvsKey, other_record), pw::OkStatus());
+
+  EXPECT_EQ(store_.Init(worker_, kvs_), pw::Status::DataLoss());
+  EXPECT_FALSE(store_.Get(Key::kAlarmThreshold).has_value());
+}
+
+TEST_F(ConfigStoreTest, RejectedFlushIsRescheduled) {
+  FlakyWorker worker(/*rejections=*/1);
+  ConfigStore store(std::chrono::milliseconds(1));
+  std::ignore = store.Init(worker, kvs_);
+  store.Set(Key::kAlarmThreshold, 200);
+
+  ASSERT_TRUE(worker.ran().try_acquire_for(std::chrono::seconds(5)));
+  EXPECT_FALSE(store.dirty());
+  EXPECT_EQ(kvs_.size(), 1u);
+}
+
+TEST_F(ConfigStoreTest, RamOnlyStoreKeepsValues) {
+  store_.Init(worker_);
+  store_.Set(Key::kAmbientLightPeriodMs, 500);
+  EXPECT_EQ(store_.Flush(), pw::OkStatus());
+  EXPECT_EQ(store_.Get(Key::kAmbientLightPeriodMs), 500u);
+  EXPECT_EQ(kvs_.size(), 0u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,146 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/cpu_usage/cpu_usage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace sense {
+
+CpuUsageTracker::CpuUsageTracker(CpuCounterSource& source,
+                                 Clock::duration sample_period)
+    : source_(source),
+      sample_period_(sample_period),
+      timer_([this](Clock::time_point) {
+        worker_->RunOnce([this] { Sample(); });
+        timer_.InvokeAfter(sample_period_);
+      }) {}
+
+void CpuUsageTracker::Start(Worker& worker) {
+  worker_ = &worker;
+  timer_.InvokeAfter(sample_period_);
+}
+
+void CpuUsageTracker::Sample() {
+  const pw::StatusWithSize result = source_.Read(scratch_);
+  if (!result.ok() && !result.IsResourceExhausted()) {
+    return;
+  }
+  const Clock::time_point now = Clock::now();
+
+  std::lock_guard lock(lock_);
+  Read& read = reads_[next_read_];
+  read.time = now;
+  read.threads = {};
+  for (size_t i = 0; i < result.size(); ++i) {
+    const ThreadCpuCounters& counters = scratch_[i];
+    const size_t slot = FindSlot(counters);
+    if (slot == kMaxThreads) {
+      continue;
+    }
+    read.threads[slot] = {
+        .run_time = counters.run_time,
+        .context_switches = counters.context_switches,
+        .present = true,
+    };
+  }
+
+  // Release the slots of threads that have exited, so a new thread in the
+  // slot is not compared against the old one's counters.
+  for (size_t slot = 0; slot < kMaxThreads; ++slot) {
+    if (!threads_[slot].in_use || read.threads[slot].present) {
+      continue;
+    }
+    threads_[slot].in_use = false;
+    for (Read& old_read : reads_) {
+      old_read.threads[slot].present = false;
+    }
+  }
+
+  next_read_ = (next_read_ + 1) % kSamples;
+  read_count_ = std::min(read_count_ + 1, kSamples);
+}
+
+size_t CpuUsageTracker::FindSlot(const ThreadCpuCounters& counters) {
+  size_t free_slot = kMaxThreads;
+  for (size_t slot = 0; slot < kMaxThreads; ++slot) {
+    const Thread& thread = threads_[slot];
+    if (!thread.in_use) {
+      free_slot = std::min(free_slot, slot);
+    } else if (thread.id == counters.id) {
+      return slot;
+    }
+  }
+  if (free_slot == kMaxThreads) {
+    return kMaxThreads;
+  }
+
+  Thread& thread = threads_[free_slot];
+  thread.id = counters.id;
+  std::memcpy(thread.name, counters.name, sizeof(thread.name));
+  thread.name[sizeof(thread.name) - 1] = '\0';
+  thread.idle = counters.idle;
+  thread.in_use = true;
+  return free_slot;
+}
+
+pw::Status CpuUsageTracker::GetUsage(Usage& usage) const {
+  std::lock_guard lock(lock_);
+  if (read_count_ < 2) {
+    return pw::Status::Unavailable();
+  }
+  const Read& newest = reads_[(next_read_ + kSamples - 1) % kSamples];
+  const Read& oldest = reads_[(next_read_ + kSamples - read_count_) % kSamples];
+
+  // Counters wrap, so differences are taken in their own width.
+  std::array<uint32_t, kMaxThreads> run_time = {};
+  uint64_t total_run_time = 0;
+  uint64_t idle_run_time = 0;
+  for (size_t slot = 0; slot < kMaxThreads; ++slot) {
+    if (!threads_[slot].in_use || !oldest.threads[slot].present) {
+      continue;
+    }
+    run_time[slot] =
+        newest.threads[slot].run_time - oldest.threads[slot].run_time;
+    total_run_time += run_time[slot];
+    if (threads_[slot].idle) {
+      idle_run_time += run_time[slot];
+    }
+  }
+
+  const auto basis_points = [total_run_time](uint64_t part) {
+    return total_run_time == 0
+               ? uint16_t{0}
+               : static_cast<uint16_t>(part * 10'000 / total_run_time);
+  };
+
+  usage.thread_count = 0;
+  for (size_t slot = 0; slot < kMaxThreads; ++slot) {
+    if (!threads_[slot].in_use || !oldest.threads[slot].present) {
+      continue;
+    }
+    ThreadUsage& thread = usage.threads[usage.thread_count++];
+    std::memcpy(thread.name, threads_[slot].name, sizeof(thread.name));
+    thread.cpu_basis_points = basis_points(run_time[slot]);
+    thread.context_switches = newest.threads[slot].context_switches -
+                              oldest.threads[slot].context_switches;
+  }
+  usage.idle_basis_points = basis_points(idle_run_time);
+  usage.window = newest.time - oldest.time;
+  return pw::OkStatus();
+}
+
+}  // namespace sense
@@ -0,0 +1,157 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
+#include "pw_status/status_with_size.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+
+namespace sense {
+
+/// Cumulative counters of one thread, as kept by the RTOS. Both counters may
+/// wrap.
+struct ThreadCpuCounters {
+  static constexpr size_t kMaxNameLength = 15;
+
+  /// Distinguishes threads with the same name.
+  uint32_t id;
+  char name[kMaxNameLength + 1];
+
+  /// Whether this is an idle thread, whose run time is unused capacity.
+  bool idle;
+
+  /// Time spent running, in any unit shared by every thread.
+  uint32_t run_time;
+  uint32_t context_switches;
+};
+
+/// Reads per-thread CPU counters from the RTOS.
+class CpuCounterSource {
+ public:
+  virtual ~CpuCounterSource() = default;
+
+  /// Fills `threads` with the counters of every thread.
+  ///
+  /// @returns the number of threads written, or ResourceExhausted with the
+  /// threads that fit if there are more than `threads.size()`.
+  pw::StatusWithSize Read(pw::span<ThreadCpuCounters> threads) {
+    return DoRead(threads);
+  }
+
+ private:
+  virtual pw::StatusWithSize DoRead(pw::span<ThreadCpuCounters> threads) = 0;
+};
+
+/// Turns periodic reads of `CpuCounterSource` into per-thread CPU shares over
+/// a sliding window.
+///
+/// Shares are fractions of the run time of all threads, so on a target with
+/// several cores 100% means every core is busy.
+class CpuUsageTracker {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  static constexpr size_t kMaxThreads = 16;
+
+  /// Reads kept; the window spans one fewer sample periods.
+  static constexpr size_t kSamples = 11;
+
+  static constexpr Clock::duration kDefaultSamplePeriod =
+      std::chrono::seconds(1);
+
+  struct ThreadUsage {
+    char name[ThreadCpuCounters::kMaxNameLength + 1];
+
+    /// Share of the window's run time, in hundredths of a percent.
+    uint16_t cpu_basis_points;
+    uint32_t context_switches;
+  };
+
+  struct Usage {
+    std::array<ThreadUsage, kMaxThreads> threads;
+    size_t thread_count;
+
+    /// Share of the window's run time spent in idle threads.
+    uint16_t idle_basis_points;
+    Clock::duration window;
+  };
+
+  explicit CpuUsageTracker(
+      CpuCounterSource& source,
+      Clock::duration sample_period = kDefaultSamplePeriod);
+
+  CpuUsageTracker(const CpuUsageTracker&) = delete;
+  CpuUsageTracker& operator=(const CpuUsageTracker&) = delete;
+
+  /// Reads the counters every sample period from `worker`.
+  void Start(Worker& worker);
+
+  /// Reads the counters now. Called by `Start`'s timer.
+  void Sample() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Reports usage between the oldest and newest reads in the window.
+  ///
+  /// @returns Unavailable until two reads have been made.
+  pw::Status GetUsage(Usage& usage) const PW_LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct Thread {
+    uint32_t id;
+    char name[ThreadCpuCounters::kMaxNameLength + 1];
+    bool idle;
+    bool in_use;
+  };
+
+  struct Counters {
+    uint32_t run_time;
+    uint32_t context_switches;
+    bool present;
+  };
+
+  struct Read {
+    Clock::time_point time;
+    std::array<Counters, kMaxThreads> threads;
+  };
+
+  // Returns the slot tracking `counters`' thread, claiming a free one if it
+  // is new, or `kMaxThreads` if every slot is taken.
+  size_t FindSlot(const ThreadCpuCounters& counters)
+      PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  CpuCounterSource& source_;
+  const Clock::duration sample_period_;
+  Worker* worker_ = nullptr;
+  pw::chrono::SystemTimer timer_;
+
+  // Scratch space for `Sample`, which only runs on the worker.
+  std::array<ThreadCpuCounters, kMaxThreads> scratch_;
+
+  mutable pw::sync::Mutex lock_;
+  std::array<Thread, kMaxThreads> threads_ PW_GUARDED_BY(lock_) = {};
+  std::array<Read, kSamples> reads_ PW_GUARDED_BY(lock_) = {};
+  size_t next_read_ PW_GUARDED_BY(lock_) = 0;
+  size_t read_count_ PW_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace sense
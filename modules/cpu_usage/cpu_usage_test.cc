@@ -0,0 +1,181 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/cpu_usage/cpu_usage.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "pw_containers/vector.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+class FakeCpuCounterSource final : public CpuCounterSource {
+ public:
+  // Adds a thread, or advances its counters if it already exists.
+  void Run(uint32_t id,
+           std::string_view name,
+           uint32_t run_time,
+           uint32_t context_switches = 0,
+           bool idle = false) {
+    for (ThreadCpuCounters& thread : threads_) {
+      if (thread.id == id) {
+        thread.run_time += run_time;
+        thread.context_switches += context_switches;
+        return;
+      }
+    }
+    ThreadCpuCounters& thread = threads_.emplace_back();
+    thread = {.id = id,
+              .name = {},
+              .idle = idle,
+              .run_time = run_time,
+              .context_switches = context_switches};
+    std::memcpy(thread.name, name.data(), name.size());
+  }
+
+  void Exit(uint32_t id) {
+    for (size_t i = 0; i < threads_.size(); ++i) {
+      if (threads_[i].id == id) {
+        threads_.erase(threads_.begin() + i);
+        return;
+      }
+    }
+  }
+
+ private:
+  pw::StatusWithSize DoRead(pw::span<ThreadCpuCounters> threads) override {
+    const size_t count = std::min(threads.size(), threads_.size());
+    std::copy(threads_.begin(), threads_.begin() + count, threads.begin());
+    if (count < threads_.size()) {
+      return pw::StatusWithSize::ResourceExhausted(count);
+    }
+    return pw::StatusWithSize(count);
+  }
+
+  pw::Vector<ThreadCpuCounters, CpuUsageTracker::kMaxThreads> threads_;
+};
+
+const CpuUsageTracker::ThreadUsage* Find(const CpuUsageTracker::Usage& usage,
+                                         std::string_view name) {
+  for (size_t i = 0; i < usage.thread_count; ++i) {
+    if (name == usage.threads[i].name) {
+      return &usage.threads[i];
+    }
+  }
+  return nullptr;
+}
+
+TEST(CpuUsageTrackerTest, UnavailableUntilTwoReads) {
+  FakeCpuCounterSource source;
+  CpuUsageTracker tracker(source);
+  CpuUsageTracker::Usage usage;
+  EXPECT_EQ(tracker.GetUsage(usage), pw::Status::Unavailable());
+  source.Run(1, "main", 100);
+  tracker.Sample();
+  EXPECT_EQ(tracker.GetUsage(usage), pw::Status::Unavailable());
+  tracker.Sample();
+  EXPECT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+}
+
+TEST(CpuUsageTrackerTest, ReportsSharesOfRunTime) {
+  FakeCpuCounterSource source;
+  CpuUsageTracker tracker(source);
+  source.Run(1, "sampling", 5000);
+  source.Run(2, "IDLE", 9000, 0, /*idle=*/true);
+  tracker.Sample();
+
+  source.Run(1, "sampling", 300, 12);
+  source.Run(2, "IDLE", 700, 11);
+  tracker.Sample();
+
+  CpuUsageTracker::Usage usage;
+  ASSERT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+  ASSERT_EQ(usage.thread_count, 2u);
+  const auto* sampling = Find(usage, "sampling");
+  ASSERT_NE(sampling, nullptr);
+  EXPECT_EQ(sampling->cpu_basis_points, 3000u);
+  EXPECT_EQ(sampling->context_switches, 12u);
+  EXPECT_EQ(usage.idle_basis_points, 7000u);
+}
+
+TEST(CpuUsageTrackerTest, OldReadsLeaveTheWindow) {
+  FakeCpuCounterSource source;
+  CpuUsageTracker tracker(source);
+  source.Run(1, "busy", 0);
+  source.Run(2, "IDLE", 0, 0, /*idle=*/true);
+  tracker.Sample();
+  source.Run(1, "busy", 1000);
+  tracker.Sample();
+
+  for (size_t i = 0; i < CpuUsageTracker::kSamples; ++i) {
+    source.Run(2, "IDLE", 1000);
+    tracker.Sample();
+  }
+
+  CpuUsageTracker::Usage usage;
+  ASSERT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+  EXPECT_EQ(Find(usage, "busy")->cpu_basis_points, 0u);
+  EXPECT_EQ(usage.idle_basis_points, 10000u);
+}
+
+TEST(CpuUsageTrackerTest, ExitedThreadsAreDropped) {
+  FakeCpuCounterSource source;
+  CpuUsageTracker tracker(source);
+  source.Run(1, "main", 0);
+  source.Run(2, "oneshot", 0);
+  tracker.Sample();
+  source.Exit(2);
+  source.Run(3, "next", 0);
+  source.Run(1, "main", 100);
+  tracker.Sample();
+
+  // The new thread is not reported until the window only holds reads that
+  // include it.
+  CpuUsageTracker::Usage usage;
+  ASSERT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+  EXPECT_EQ(usage.thread_count, 1u);
+  EXPECT_EQ(Find(usage, "oneshot"), nullptr);
+
+  for (size_t i = 1; i < CpuUsageTracker::kSamples; ++i) {
+    source.Run(3, "next", 100);
+    tracker.Sample();
+  }
+  ASSERT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+  EXPECT_EQ(usage.thread_count, 2u);
+  ASSERT_NE(Find(usage, "next"), nullptr);
+}
+
+TEST(CpuUsageTrackerTest, CountersMayWrap) {
+  FakeCpuCounterSource source;
+  CpuUsageTracker tracker(source);
+  source.Run(1, "main", UINT32_MAX - 99, UINT32_MAX);
+  source.Run(2, "IDLE", 0, 0, /*idle=*/true);
+  tracker.Sample();
+  source.Run(1, "main", 200, 2);
+  source.Run(2, "IDLE", 200);
+  tracker.Sample();
+
+  CpuUsageTracker::Usage usage;
+  ASSERT_EQ(tracker.GetUsage(usage), pw::OkStatus());
+  EXPECT_EQ(Find(usage, "main")->cpu_basis_points, 5000u);
+  EXPECT_EQ(Find(usage, "main")->context_switches, 2u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,59 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/cpu_usage/service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+#include "pw_status/try.h"
+
+namespace sense {
+namespace {
+
+float ToPercent(uint16_t basis_points) {
+  return static_cast<float>(basis_points) / 100.f;
+}
+
+}  // namespace
+
+pw::Status CpuUsageService::GetUsage(const pw_protobuf_Empty&,
+                                     cpu_usage_Usage& response) {
+  if (tracker_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+
+  CpuUsageTracker::Usage usage;
+  PW_TRY(tracker_->GetUsage(usage));
+
+  response.threads_count = static_cast<pb_size_t>(
+      std::min(usage.thread_count, std::size(response.threads)));
+  for (size_t i = 0; i < response.threads_count; ++i) {
+    const CpuUsageTracker::ThreadUsage& thread = usage.threads[i];
+    cpu_usage_ThreadUsage& entry = response.threads[i];
+    static_assert(sizeof(entry.name) == sizeof(thread.name));
+    std::memcpy(entry.name, thread.name, sizeof(entry.name));
+    entry.cpu_percent = ToPercent(thread.cpu_basis_points);
+    entry.context_switches = thread.context_switches;
+  }
+  response.idle_percent = ToPercent(usage.idle_basis_points);
+  response.window_ms = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(usage.window)
+          .count());
+  return pw::OkStatus();
+}
+
+}  // namespace sense
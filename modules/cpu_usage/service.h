@@ -0,0 +1,35 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/cpu_usage/cpu_usage.h"
+#include "modules/cpu_usage/cpu_usage.rpc.pb.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Reports per-thread CPU usage, e.g. to check the headroom left before
+/// raising sample rates.
+class CpuUsageService final
+    : public ::cpu_usage::pw_rpc::nanopb::CpuUsage::Service<CpuUsageService> {
+ public:
+  void Init(const CpuUsageTracker& tracker) { tracker_ = &tracker; }
+
+  pw::Status GetUsage(const pw_protobuf_Empty&, cpu_usage_Usage& response);
+
+ private:
+  const CpuUsageTracker* tracker_ = nullptr;
+};
+
+}  // namespace sense
@@ -13,6 +13,10 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 #include "pw_assert/assert.h"
 
 namespace sense {
@@ -79,7 +83,7 @@ class HysteresisEdgeDetector : public internal::BaseHysteresisEdgeDetector {
   /// Sets the low and high thresholds, inclusive. Resets the internal state.
   void set_low_and_high_thresholds(Sample low_threshold,
                                    Sample high_threshold) {
-    PW_ASSERT(low_threshold_ <= high_threshold_);
+    PW_ASSERT(low_threshold <= high_threshold);
     low_threshold_ = low_threshold;
     high_threshold_ = high_threshold;
     ResetState();
@@ -102,4 +106,94 @@ class HysteresisEdgeDetector : public internal::BaseHysteresisEdgeDetector {
   Sample high_threshold_;
 };
 
+/// Bank of `kChannels` independent hysteresis edge detectors.
+///
+/// Each channel behaves like a `HysteresisEdgeDetector`, but the thresholds
+/// are kept in parallel arrays and the states in bitmasks, so all channels
+/// are updated together and their edges are reported as bitmasks, with bit
+/// `i` for channel `i`.
+///
+/// This class is NOT thread safe. It must only be used from one thread or have
+/// external synchronization.
+template <typename Sample, size_t kChannels>
+class HysteresisEdgeDetectorBank {
+ public:
+  static_assert(kChannels > 0 && kChannels <= 32,
+                "A bank holds between 1 and 32 channels");
+
+  using Samples = std::array<Sample, kChannels>;
+
+  /// Channels with edges in one update.
+  struct Edges {
+    uint32_t rising = 0;
+    uint32_t falling = 0;
+
+    constexpr bool any() const { return (rising | falling) != 0; }
+  };
+
+  explicit constexpr HysteresisEdgeDetectorBank(const Samples& low_thresholds,
+                                                const Samples& high_thresholds)
+      : low_thresholds_(low_thresholds), high_thresholds_(high_thresholds) {
+    for (size_t i = 0; i < kChannels; ++i) {
+      PW_ASSERT(low_thresholds_[i] <= high_thresholds_[i]);
+    }
+  }
+
+  /// Sets the low and high thresholds of one channel, inclusive. Resets that
+  /// channel's state.
+  void set_low_and_high_thresholds(size_t channel,
+                                   Sample low_threshold,
+                                   Sample high_threshold) {
+    PW_ASSERT(channel < kChannels && low_threshold <= high_threshold);
+    low_thresholds_[channel] = low_threshold;
+    high_thresholds_[channel] = high_threshold;
+    const uint32_t bit = uint32_t{1} << channel;
+    known_ &= ~bit;
+    high_ &= ~bit;
+  }
+
+  /// Adds a new sample to every channel.
+  [[nodiscard]] Edges Update(const Samples& samples) {
+    uint32_t low = 0;
+    uint32_t high = 0;
+    for (size_t i = 0; i < kChannels; ++i) {
+      low |= uint32_t{samples[i] <= low_thresholds_[i]} << i;
+      high |= uint32_t{samples[i] >= high_thresholds_[i]} << i;
+    }
+    return UpdateStates(low, high & ~low);
+  }
+
+  /// Adds a new sample to one channel.
+  [[nodiscard]] Edges Update(size_t channel, Sample sample) {
+    PW_ASSERT(channel < kChannels);
+    const uint32_t bit = uint32_t{1} << channel;
+    if (sample <= low_thresholds_[channel]) {
+      return UpdateStates(bit, 0);
+    }
+    if (sample >= high_thresholds_[channel]) {
+      return UpdateStates(0, bit);
+    }
+    return {};
+  }
+
+ private:
+  /// Applies the low and high samples of the channels in each mask. Channels
+  /// without a previous state only take their first state, like the
+  /// `kInitial` state of `HysteresisEdgeDetector`.
+  constexpr Edges UpdateStates(uint32_t low, uint32_t high) {
+    const Edges edges{
+        .rising = known_ & ~high_ & high,
+        .falling = known_ & high_ & low,
+    };
+    high_ = (high_ | high) & ~low;
+    known_ |= low | high;
+    return edges;
+  }
+
+  Samples low_thresholds_;
+  Samples high_thresholds_;
+  uint32_t known_ = 0;
+  uint32_t high_ = 0;
+};
+
 }  // namespace sense
@@ -14,6 +14,8 @@
 
 #include "modules/edge_detector/hysteresis_edge_detector.h"
 
+#include <array>
+#include <cstdint>
 #include <optional>
 
 #include "modules/edge_detector/pubsub.h"  // include as compilation test
@@ -73,4 +75,67 @@ TEST(HysteresisEdgeDetector, ChangingThresholdResetsState) {
   EXPECT_EQ(edge_detector.Update(0), sense::Edge::kFalling);
 }
 
+using Bank = sense::HysteresisEdgeDetectorBank<uint16_t, 3>;
+
+TEST(HysteresisEdgeDetectorBank, ChannelsAreIndependent) {
+  Bank bank({10, 100, 50}, {20, 200, 50});
+
+  auto edges = bank.Update({0, 300, 50});  // initial states
+  EXPECT_FALSE(edges.any());
+
+  edges = bank.Update({20, 300, 51});
+  EXPECT_EQ(edges.rising, 0b101u);
+  EXPECT_EQ(edges.falling, 0u);
+
+  edges = bank.Update({15, 100, 50});
+  EXPECT_EQ(edges.rising, 0u);
+  EXPECT_EQ(edges.falling, 0b110u);
+}
+
+TEST(HysteresisEdgeDetectorBank, SingleChannelUpdates) {
+  Bank bank({10, 10, 10}, {20, 20, 20});
+
+  EXPECT_FALSE(bank.Update(1, 0).any());
+  EXPECT_FALSE(bank.Update(2, 30).any());
+  EXPECT_EQ(bank.Update(1, 20).rising, 0b010u);
+  EXPECT_EQ(bank.Update(2, 10).falling, 0b100u);
+  EXPECT_FALSE(bank.Update(0, 15).any());
+}
+
+TEST(HysteresisEdgeDetectorBank, MatchesSingleDetectors) {
+  Bank bank({100, 0, 500}, {200, 1000, 500});
+  std::array<sense::HysteresisEdgeDetector<uint16_t>, 3> detectors = {
+      sense::HysteresisEdgeDetector<uint16_t>(100, 200),
+      sense::HysteresisEdgeDetector<uint16_t>(0, 1000),
+      sense::HysteresisEdgeDetector<uint16_t>(500, 500),
+  };
+
+  uint32_t seed = 7;
+  for (int i = 0; i < 200; ++i) {
+    Bank::Samples samples;
+    for (auto& sample : samples) {
+      seed = seed * 1664525u + 1013904223u;
+      sample = static_cast<uint16_t>((seed >> 16) % 1100);
+    }
+    const Bank::Edges edges = bank.Update(samples);
+    for (size_t c = 0; c < detectors.size(); ++c) {
+      const sense::Edge edge = detectors[c].Update(samples[c]);
+      EXPECT_EQ((edges.rising >> c) & 1,
+                edge == sense::Edge::kRising ? 1u : 0u);
+      EXPECT_EQ((edges.falling >> c) & 1,
+                edge == sense::Edge::kFalling ? 1u : 0u);
+    }
+  }
+}
+
+TEST(HysteresisEdgeDetectorBank, ChangingThresholdResetsChannel) {
+  Bank bank({10, 10, 10}, {20, 20, 20});
+
+  EXPECT_FALSE(bank.Update({0, 0, 0}).any());
+  bank.set_low_and_high_thresholds(1, 50, 60);
+  auto edges = bank.Update({30, 70, 30});
+  EXPECT_EQ(edges.rising, 0b101u);
+  EXPECT_EQ(edges.falling, 0u);
+}
+
 }  // namespace
@@ -62,4 +62,41 @@ class PubSubHysteresisEdgeDetector
   PubSub& pubsub_;
 };
 
+/// Bank of edge detectors that are all fed by one subscription.
+///
+///   - `PubSub`: Type of the PubSub object (`sense::GenericPubSub<EventType>`)
+///   - `Sample`: The sample type (e.g. `uint16_t`).
+///   - `kChannels`: The number of detectors in the bank.
+///   - `SampleEvent`: Event type to subscribe to for samples.
+///   - `GetSamples(SampleEvent)`: Returns the samples of every channel.
+///   - `PublishEdges(PubSub&, Edges)`: Publishes events for detected edges.
+template <typename PubSubSamplerMeta>
+class PubSubHysteresisEdgeDetectorBank
+    : public HysteresisEdgeDetectorBank<typename PubSubSamplerMeta::Sample,
+                                        PubSubSamplerMeta::kChannels> {
+  using Bank = HysteresisEdgeDetectorBank<typename PubSubSamplerMeta::Sample,
+                                          PubSubSamplerMeta::kChannels>;
+  using PubSub = typename PubSubSamplerMeta::PubSub;
+  using SampleEvent = typename PubSubSamplerMeta::SampleEvent;
+
+ public:
+  PubSubHysteresisEdgeDetectorBank(
+      PubSub& pubsub,
+      const typename Bank::Samples& low_thresholds,
+      const typename Bank::Samples& high_thresholds)
+      : Bank(low_thresholds, high_thresholds), pubsub_(pubsub) {
+    PW_ASSERT(
+        pubsub_.template SubscribeTo<SampleEvent>([this](SampleEvent event) {
+          const typename Bank::Edges edges =
+              Bank::Update(PubSubSamplerMeta::GetSamples(event));
+          if (edges.any()) {
+            PubSubSamplerMeta::PublishEdges(pubsub_, edges);
+          }
+        }));
+  }
+
+ private:
+  PubSub& pubsub_;
+};
+
 }  // namespace sense
@@ -0,0 +1,111 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/energy/energy_meter.h"
+
+#include <mutex>
+
+namespace sense {
+namespace {
+
+// Microamp-milliseconds in a nanoamp-hour.
+constexpr uint64_t kUaMsPerNah = 3600;
+
+uint64_t Charge(uint32_t ms, uint32_t ua) { return uint64_t{ms} * ua; }
+
+// Charge drawn by one LED channel held at `level` for `ms`.
+uint64_t LedCharge(uint64_t ms, uint16_t level, uint32_t full_ua) {
+  return ms * level * full_ua / 0xffff;
+}
+
+}  // namespace
+
+const char* EnergyMeter::SubsystemName(Subsystem subsystem) {
+  switch (subsystem) {
+    case Subsystem::kCpu:
+      return "cpu";
+    case Subsystem::kAirHeater:
+      return "air heater";
+    case Subsystem::kLed:
+      return "led";
+    case Subsystem::kI2c:
+      return "i2c";
+  }
+  return "";
+}
+
+EnergyMeter::EnergyMeter(EnergyCounterSource& source,
+                         const CurrentModel& model,
+                         Clock::duration sample_period)
+    : source_(source),
+      model_(model),
+      sample_period_(sample_period),
+      timer_([this](Clock::time_point) {
+        worker_->RunOnce([this] { Sample(); });
+        timer_.InvokeAfter(sample_period_);
+      }) {}
+
+void EnergyMeter::Start(Worker& worker) {
+  worker_ = &worker;
+  worker_->RunOnce([this] { Sample(); });
+  timer_.InvokeAfter(sample_period_);
+}
+
+void EnergyMeter::Sample(Clock::time_point now) {
+  const EnergyCounters counters = source_.Read();
+
+  std::lock_guard lock(lock_);
+  if (!started_) {
+    started_ = true;
+    reset_time_ = now;
+  } else {
+    // Unsigned subtraction gives the right deltas across a wrap.
+    const EnergyCounters& last = last_;
+    const auto elapsed_ms = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                              last_time_)
+            .count());
+    charge_ua_ms_[static_cast<size_t>(Subsystem::kCpu)] +=
+        Charge(counters.cpu_awake_ms - last.cpu_awake_ms, model_.cpu_awake_ua) +
+        Charge(counters.cpu_sleep_ms - last.cpu_sleep_ms, model_.cpu_sleep_ua);
+    charge_ua_ms_[static_cast<size_t>(Subsystem::kAirHeater)] +=
+        Charge(counters.air_heater_ms - last.air_heater_ms,
+               model_.air_heater_ua);
+    charge_ua_ms_[static_cast<size_t>(Subsystem::kLed)] +=
+        LedCharge(elapsed_ms, last.led_red, model_.led_red_ua) +
+        LedCharge(elapsed_ms, last.led_green, model_.led_green_ua) +
+        LedCharge(elapsed_ms, last.led_blue, model_.led_blue_ua);
+    charge_ua_ms_[static_cast<size_t>(Subsystem::kI2c)] +=
+        Charge(counters.i2c_busy_ms - last.i2c_busy_ms, model_.i2c_busy_ua);
+  }
+  last_ = counters;
+  last_time_ = now;
+}
+
+EnergyMeter::Usage EnergyMeter::GetUsage() const {
+  std::lock_guard lock(lock_);
+  Usage usage = {.charge_nah = {}, .period = last_time_ - reset_time_};
+  for (size_t i = 0; i < kNumSubsystems; ++i) {
+    usage.charge_nah[i] = charge_ua_ms_[i] / kUaMsPerNah;
+  }
+  return usage;
+}
+
+void EnergyMeter::Reset() {
+  std::lock_guard lock(lock_);
+  charge_ua_ms_ = {};
+  reset_time_ = last_time_;
+}
+
+}  // namespace sense
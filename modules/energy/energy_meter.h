@@ -0,0 +1,141 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+
+namespace sense {
+
+/// Currents a board's subsystems draw in each state they are accounted in,
+/// in microamps. These are constants, so estimates are only as good as the
+/// figures; calibrate them against a meter where it matters.
+struct CurrentModel {
+  uint32_t cpu_awake_ua;
+  uint32_t cpu_sleep_ua;
+  uint32_t air_heater_ua;
+
+  /// Each LED channel at its full PWM level.
+  uint32_t led_red_ua;
+  uint32_t led_green_ua;
+  uint32_t led_blue_ua;
+
+  uint32_t i2c_busy_ua;
+};
+
+/// Activity counters of the subsystems an `EnergyMeter` accounts for.
+struct EnergyCounters {
+  /// Cumulative times, which may wrap.
+  uint32_t cpu_awake_ms;
+  uint32_t cpu_sleep_ms;
+  uint32_t air_heater_ms;
+  uint32_t i2c_busy_ms;
+
+  /// The LED's PWM levels, from 0 to 0xffff, at the time of the read. These
+  /// are assumed to hold until the next read.
+  uint16_t led_red;
+  uint16_t led_green;
+  uint16_t led_blue;
+};
+
+/// Reads activity counters from the places that keep them.
+class EnergyCounterSource {
+ public:
+  virtual ~EnergyCounterSource() = default;
+
+  EnergyCounters Read() { return DoRead(); }
+
+ private:
+  virtual EnergyCounters DoRead() = 0;
+};
+
+/// Estimates the charge each subsystem draws by applying a `CurrentModel` to
+/// periodic reads of an `EnergyCounterSource`.
+class EnergyMeter {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  enum class Subsystem : uint8_t {
+    kCpu,
+    kAirHeater,
+    kLed,
+    kI2c,
+  };
+
+  static constexpr size_t kNumSubsystems = 4;
+
+  static constexpr Clock::duration kDefaultSamplePeriod =
+      std::chrono::seconds(1);
+
+  static const char* SubsystemName(Subsystem subsystem);
+
+  struct Usage {
+    /// Charge drawn by each subsystem, in nanoamp-hours, indexed by
+    /// `Subsystem`.
+    std::array<uint64_t, kNumSubsystems> charge_nah;
+
+    /// Time the estimates cover.
+    Clock::duration period;
+  };
+
+  EnergyMeter(EnergyCounterSource& source,
+              const CurrentModel& model,
+              Clock::duration sample_period = kDefaultSamplePeriod);
+
+  EnergyMeter(const EnergyMeter&) = delete;
+  EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+  /// Reads the counters now and every sample period from `worker`, which
+  /// must be a context the source may be read from.
+  void Start(Worker& worker);
+
+  /// Reads the counters and accounts for the time since the previous read.
+  /// Called by `Start`'s timer.
+  void Sample() { Sample(Clock::now()); }
+  void Sample(Clock::time_point now) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Returns the charge drawn since the first read or the last `Reset`, up to
+  /// the latest read.
+  Usage GetUsage() const PW_LOCKS_EXCLUDED(lock_);
+
+  /// Starts the estimates again from the latest read.
+  void Reset() PW_LOCKS_EXCLUDED(lock_);
+
+ private:
+  EnergyCounterSource& source_;
+  const CurrentModel model_;
+  const Clock::duration sample_period_;
+  Worker* worker_ = nullptr;
+  pw::chrono::SystemTimer timer_;
+
+  mutable pw::sync::Mutex lock_;
+  bool started_ PW_GUARDED_BY(lock_) = false;
+  EnergyCounters last_ PW_GUARDED_BY(lock_) = {};
+  Clock::time_point last_time_ PW_GUARDED_BY(lock_);
+  Clock::time_point reset_time_ PW_GUARDED_BY(lock_);
+
+  // Microamp-milliseconds, to keep the arithmetic exact between reads.
+  std::array<uint64_t, kNumSubsystems> charge_ua_ms_ PW_GUARDED_BY(lock_) =
+      {};
+};
+
+}  // namespace sense
@@ -0,0 +1,138 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/energy/energy_meter.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+using Subsystem = EnergyMeter::Subsystem;
+
+constexpr CurrentModel kModel = {
+    .cpu_awake_ua = 20'000,
+    .cpu_sleep_ua = 2'000,
+    .air_heater_ua = 12'000,
+    .led_red_ua = 6'000,
+    .led_green_ua = 4'000,
+    .led_blue_ua = 3'000,
+    .i2c_busy_ua = 1'800,
+};
+
+class FakeEnergyCounterSource final : public EnergyCounterSource {
+ public:
+  EnergyCounters counters = {};
+
+ private:
+  EnergyCounters DoRead() override { return counters; }
+};
+
+uint64_t ChargeNah(const EnergyMeter::Usage& usage, Subsystem subsystem) {
+  return usage.charge_nah[static_cast<size_t>(subsystem)];
+}
+
+class EnergyMeterTest : public ::testing::Test {
+ protected:
+  // Advances the fake clock and samples.
+  void SampleAfter(EnergyMeter::Clock::duration elapsed) {
+    now_ += elapsed;
+    meter_.Sample(now_);
+  }
+
+  FakeEnergyCounterSource source_;
+  EnergyMeter meter_{source_, kModel};
+  EnergyMeter::Clock::time_point now_;
+};
+
+TEST_F(EnergyMeterTest, FirstReadIsTheBaseline) {
+  source_.counters.cpu_awake_ms = 5000;
+  source_.counters.air_heater_ms = 5000;
+  SampleAfter(0s);
+
+  const EnergyMeter::Usage usage = meter_.GetUsage();
+  EXPECT_EQ(usage.period, EnergyMeter::Clock::duration(0));
+  for (uint64_t charge : usage.charge_nah) {
+    EXPECT_EQ(charge, 0u);
+  }
+}
+
+TEST_F(EnergyMeterTest, AppliesTheModelToEachCounter) {
+  SampleAfter(0s);
+  source_.counters = {
+      .cpu_awake_ms = 900,
+      .cpu_sleep_ms = 2700,
+      .air_heater_ms = 1800,
+      .i2c_busy_ms = 3600,
+      .led_red = 0,
+      .led_green = 0,
+      .led_blue = 0,
+  };
+  SampleAfter(3600ms);
+
+  // 1 nAh is 3.6 uA for a second.
+  const EnergyMeter::Usage usage = meter_.GetUsage();
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kCpu), 5000u + 1500u);
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kAirHeater), 6000u);
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kI2c), 1800u);
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kLed), 0u);
+  EXPECT_EQ(usage.period, EnergyMeter::Clock::duration(3600ms));
+}
+
+TEST_F(EnergyMeterTest, LedLevelsHoldUntilTheNextRead) {
+  SampleAfter(0s);
+  source_.counters.led_red = 0xffff;
+  source_.counters.led_blue = 0xffff / 3;
+  SampleAfter(3600ms);
+  // The levels just read have not been held for any time yet.
+  EXPECT_EQ(ChargeNah(meter_.GetUsage(), Subsystem::kLed), 0u);
+
+  source_.counters.led_red = 0;
+  source_.counters.led_blue = 0;
+  SampleAfter(3600ms);
+  EXPECT_EQ(ChargeNah(meter_.GetUsage(), Subsystem::kLed), 6000u + 1000u);
+}
+
+TEST_F(EnergyMeterTest, CountersMayWrap) {
+  source_.counters.cpu_sleep_ms = UINT32_MAX - 1799;
+  SampleAfter(0s);
+  source_.counters.cpu_sleep_ms = 1800;
+  SampleAfter(3600ms);
+
+  EXPECT_EQ(ChargeNah(meter_.GetUsage(), Subsystem::kCpu), 2000u);
+}
+
+TEST_F(EnergyMeterTest, ResetStartsFromTheLatestRead) {
+  SampleAfter(0s);
+  source_.counters.cpu_awake_ms = 3600;
+  SampleAfter(3600ms);
+  meter_.Reset();
+
+  EnergyMeter::Usage usage = meter_.GetUsage();
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kCpu), 0u);
+  EXPECT_EQ(usage.period, EnergyMeter::Clock::duration(0));
+
+  source_.counters.cpu_awake_ms += 1800;
+  SampleAfter(1800ms);
+  usage = meter_.GetUsage();
+  EXPECT_EQ(ChargeNah(usage, Subsystem::kCpu), 10000u);
+  EXPECT_EQ(usage.period, EnergyMeter::Clock::duration(1800ms));
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,67 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/energy/service.h"
+
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+namespace sense {
+namespace {
+
+float ToMilliampHours(uint64_t charge_nah) {
+  return static_cast<float>(charge_nah) / 1e6f;
+}
+
+}  // namespace
+
+pw::Status EnergyService::GetUsage(const pw_protobuf_Empty&,
+                                   energy_Usage& response) {
+  if (meter_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+
+  const EnergyMeter::Usage usage = meter_->GetUsage();
+  const auto period_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(usage.period)
+          .count();
+  const float hours = static_cast<float>(period_ms) / 3.6e6f;
+
+  uint64_t total_nah = 0;
+  static_assert(EnergyMeter::kNumSubsystems == std::size(response.subsystems));
+  response.subsystems_count = EnergyMeter::kNumSubsystems;
+  for (size_t i = 0; i < EnergyMeter::kNumSubsystems; ++i) {
+    energy_SubsystemUsage& entry = response.subsystems[i];
+    const char* name =
+        EnergyMeter::SubsystemName(static_cast<EnergyMeter::Subsystem>(i));
+    std::strncpy(entry.name, name, sizeof(entry.name) - 1);
+    entry.charge_mah = ToMilliampHours(usage.charge_nah[i]);
+    entry.average_ma = hours > 0 ? entry.charge_mah / hours : 0;
+    total_nah += usage.charge_nah[i];
+  }
+  response.total_mah = ToMilliampHours(total_nah);
+  response.period_ms = static_cast<uint32_t>(period_ms);
+  return pw::OkStatus();
+}
+
+pw::Status EnergyService::Reset(const pw_protobuf_Empty&, pw_protobuf_Empty&) {
+  if (meter_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+  meter_->Reset();
+  return pw::OkStatus();
+}
+
+}  // namespace sense
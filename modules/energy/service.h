@@ -0,0 +1,37 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/energy/energy.rpc.pb.h"
+#include "modules/energy/energy_meter.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Reports estimated charge per subsystem, e.g. to compare sampling schedules
+/// for battery deployments.
+class EnergyService final
+    : public ::energy::pw_rpc::nanopb::Energy::Service<EnergyService> {
+ public:
+  void Init(EnergyMeter& meter) { meter_ = &meter; }
+
+  pw::Status GetUsage(const pw_protobuf_Empty&, energy_Usage& response);
+
+  pw::Status Reset(const pw_protobuf_Empty&, pw_protobuf_Empty&);
+
+ private:
+  EnergyMeter* meter_ = nullptr;
+};
+
+}  // namespace sense
@@ -13,10 +13,14 @@
 // the License.
 #pragma once
 
-#include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <optional>
 
+#include "modules/event_timers/timer_wheel.h"
+#include "modules/log_policy/deferred_log.h"
 #include "modules/pubsub/pubsub.h"
 #include "modules/pubsub/pubsub_events.h"
 #include "pw_assert/assert.h"
@@ -35,7 +39,13 @@ namespace sense {
 ///
 /// Each timer is identified by a pw_tokenizer token. If a request is handled
 /// while another request for the same token is pending, the previous request is
-/// replaced by the new one.
+/// replaced by the new one. A `TimerCancel` event stops a pending timer.
+///
+/// Requests with a period restart their timer each time it expires, without
+/// another request, so periodic events cost one `TimerExpired` per period.
+///
+/// All of the timers share a `TimerWheel` and a single `SystemTimer`, which is
+/// only armed for the wheel's next event.
 ///
 /// @tparam   kCapacity   The total number of timers that can be added to this
 ///                       object. Timers cannot be removed once added.
@@ -45,51 +55,74 @@ class EventTimers {
   using Clock = ::pw::chrono::SystemClock;
   using Token = ::pw::tokenizer::Token;
 
- private:
-  /// Internal class that associates a timer with a token, and can publish a
-  /// `TimerExpired` event when the timer fires.
-  class EventTimer {
-   public:
-    constexpr EventTimer(PubSub& pubsub, Token token)
-        : pubsub_(pubsub),
-          token_(token),
-          timer_(pw::bind_member<&EventTimer::OnExpiration>(this)) {}
-
-    Token token() const { return token_; }
-
-    /// Schedules the callback to publish the `TimerExpired` event.
-    void Schedule(Clock::time_point expiry);
-
-   private:
-    /// Callback that publishes the `TimerExpired` event.
-    void OnExpiration(Clock::time_point);
-
-    PubSub& pubsub_;
-    const Token token_;
-    pw::chrono::SystemTimer timer_;
-  };
-
- public:
-  explicit EventTimers(PubSub& pubsub) : pubsub_(pubsub) {
+  explicit EventTimers(PubSub& pubsub)
+      : EventTimers(pubsub, kStaticallySubscribed) {
     PW_ASSERT(pubsub.SubscribeTo<TimerRequest>(
         pw::bind_member<&EventTimers::OnTimerRequest>(this)));
+    PW_ASSERT(pubsub.SubscribeTo<TimerCancel>(
+        pw::bind_member<&EventTimers::OnTimerCancel>(this)));
   }
 
+  /// Does not subscribe to `pubsub`; a static subscriber list must call
+  /// `OnTimerRequest` and `OnTimerCancel` instead.
+  EventTimers(PubSub& pubsub, StaticallySubscribed)
+      : pubsub_(pubsub),
+        timer_(pw::bind_member<&EventTimers::OnExpiration>(this)),
+        wheel_(NowTick()) {}
+
   /// Adds a timer for the given token.
   ///
   /// This does NOT schedule a timed event. Timed events are schduled by
   /// handling `TimerRequests`.
-  ///
-  /// @param  pubsub  Used to publish `TimerExpired` events.
-  pw::Status AddEventTimer(Token token);
+  pw::Status AddEventTimer(Token token) PW_LOCKS_EXCLUDED(lock_);
 
   /// Handles a `TimerRequest` by scheduling a timed event.
   void OnTimerRequest(TimerRequest request) PW_LOCKS_EXCLUDED(lock_);
 
+  /// Handles a `TimerCancel` by stopping the timer, if it is pending.
+  void OnTimerCancel(TimerCancel cancel) PW_LOCKS_EXCLUDED(lock_);
+
  private:
+  using Wheel = TimerWheel<kCapacity>;
+  using Expired = pw::Vector<Token, kCapacity>;
+
+  /// The wheel counts milliseconds since the clock's epoch. Deadlines round
+  /// up and the current time rounds down, so timers never expire early.
+  static typename Wheel::Tick DeadlineTick(Clock::time_point time) {
+    return static_cast<typename Wheel::Tick>(
+        std::chrono::ceil<std::chrono::milliseconds>(time.time_since_epoch())
+            .count());
+  }
+
+  static typename Wheel::Tick NowTick() {
+    return static_cast<typename Wheel::Tick>(
+        std::chrono::floor<std::chrono::milliseconds>(
+            Clock::now().time_since_epoch())
+            .count());
+  }
+
+  static Clock::time_point FromTick(typename Wheel::Tick tick) {
+    return Clock::time_point(std::chrono::ceil<Clock::duration>(
+        std::chrono::milliseconds(tick)));
+  }
+
+  /// Advances the wheel to the current time, collecting the expired timers.
+  void AdvanceLocked(Expired& expired) PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /// Arms the system timer for the wheel's next event, if it changed.
+  void RearmLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /// Publishes `TimerExpired` events. Must be called without the lock held.
+  void PublishExpired(const Expired& expired) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Callback of the system timer.
+  void OnExpiration(Clock::time_point) PW_LOCKS_EXCLUDED(lock_);
+
   PubSub& pubsub_;
+  pw::chrono::SystemTimer timer_;
   pw::sync::InterruptSpinLock lock_;
-  pw::Vector<EventTimer, kCapacity> timers_ PW_GUARDED_BY(lock_);
+  Wheel wheel_ PW_GUARDED_BY(lock_);
+  std::optional<typename Wheel::Tick> armed_tick_ PW_GUARDED_BY(lock_);
 };
 
 // Template method implementations.
@@ -97,42 +130,90 @@ class EventTimers {
 template <size_t kCapacity>
 pw::Status EventTimers<kCapacity>::AddEventTimer(Token token) {
   std::lock_guard lock(lock_);
-  for (auto& timer : timers_) {
-    if (timer.token() == token) {
-      PW_LOG_WARN("Timer already exists: " PW_TOKEN_FMT(), token);
-      return pw::Status::AlreadyExists();
-    }
+  pw::Status status = wheel_.Add(token);
+  if (status.IsAlreadyExists()) {
+    PW_LOG_WARN("Timer already exists: " PW_TOKEN_FMT(), token);
   }
-  timers_.emplace_back(pubsub_, token);
-  return pw::OkStatus();
+  return status;
 }
 
 template <size_t kCapacity>
 void EventTimers<kCapacity>::OnTimerRequest(TimerRequest request) {
-  PW_LOG_INFO("Adding timed event: " PW_TOKEN_FMT() " after %u seconds",
-              request.token,
-              request.timeout_s);
-  auto expiry = pw::chrono::SystemClock::TimePointAfterAtLeast(
-      std::chrono::seconds(request.timeout_s));
-  std::lock_guard lock(lock_);
-  for (auto& timer : timers_) {
-    if (timer.token() == request.token) {
-      timer.Schedule(expiry);
-      return;
-    }
+  SENSE_LOG_DEFERRED(
+      PW_LOG_INFO,
+      "Adding timed event: " PW_TOKEN_FMT() " after %u ms, period %u ms",
+      request.token,
+      request.timeout_ms,
+      request.period_ms);
+  const auto deadline = DeadlineTick(Clock::TimePointAfterAtLeast(
+      std::chrono::milliseconds(request.timeout_ms)));
+  Expired expired;
+  pw::Status status;
+  {
+    std::lock_guard lock(lock_);
+    AdvanceLocked(expired);
+    status = wheel_.Schedule(request.token, deadline, request.period_ms);
+    RearmLocked();
+  }
+  if (!status.ok()) {
+    PW_LOG_WARN("No timer found for timed event: " PW_TOKEN_FMT(),
+                request.token);
+  }
+  PublishExpired(expired);
+}
+
+template <size_t kCapacity>
+void EventTimers<kCapacity>::OnTimerCancel(TimerCancel cancel) {
+  pw::Status status;
+  {
+    std::lock_guard lock(lock_);
+    status = wheel_.Cancel(cancel.token);
+    RearmLocked();
+  }
+  if (!status.ok()) {
+    PW_LOG_WARN("No timer found to cancel: " PW_TOKEN_FMT(), cancel.token);
   }
-  PW_LOG_WARN("No timer found for timed event: " PW_TOKEN_FMT(), request.token);
 }
 
 template <size_t kCapacity>
-void EventTimers<kCapacity>::EventTimer::Schedule(Clock::time_point expiry) {
-  timer_.InvokeAt(expiry);
+void EventTimers<kCapacity>::AdvanceLocked(Expired& expired) {
+  wheel_.Advance(NowTick(),
+                 [&expired](Token token) { expired.push_back(token); });
 }
 
 template <size_t kCapacity>
-void EventTimers<kCapacity>::EventTimer::OnExpiration(Clock::time_point) {
-  PW_LOG_INFO("Timed event triggered: " PW_TOKEN_FMT(), token_);
-  PW_ASSERT(pubsub_.Publish(TimerExpired{.token = token_}));
+void EventTimers<kCapacity>::RearmLocked() {
+  const std::optional<typename Wheel::Tick> next = wheel_.NextEvent();
+  if (next == armed_tick_) {
+    return;
+  }
+  armed_tick_ = next;
+  if (next.has_value()) {
+    timer_.InvokeAt(FromTick(*next));
+  } else {
+    timer_.Cancel();
+  }
+}
+
+template <size_t kCapacity>
+void EventTimers<kCapacity>::PublishExpired(const Expired& expired) {
+  for (const Token token : expired) {
+    SENSE_LOG_DEFERRED(
+        PW_LOG_INFO, "Timed event triggered: " PW_TOKEN_FMT(), token);
+    PW_ASSERT(pubsub_.Publish(TimerExpired{.token = token}));
+  }
+}
+
+template <size_t kCapacity>
+void EventTimers<kCapacity>::OnExpiration(Clock::time_point) {
+  Expired expired;
+  {
+    std::lock_guard lock(lock_);
+    armed_tick_.reset();
+    AdvanceLocked(expired);
+    RearmLocked();
+  }
+  PublishExpired(expired);
 }
 
 }  // namespace sense
@@ -0,0 +1,283 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "pw_status/status.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Tickless hierarchical timer wheel keyed by pw_tokenizer tokens.
+///
+/// Time is counted in abstract ticks. Each of the `kLevels` levels has 64
+/// slots, and each slot of level `n` covers `64^n` ticks. A pending timer is
+/// kept in the lowest level whose current block contains its deadline, and is
+/// moved down a level when the wheel reaches its slot. Nothing runs between
+/// those points: `NextEvent` returns the only tick at which `Advance` has work
+/// to do, so a single hardware timer can serve every token.
+///
+/// Tokens are found through an open-addressed hash table, so registering,
+/// scheduling and cancelling are constant time. The wheel is not thread safe.
+///
+/// @tparam   kCapacity   The number of tokens that can be registered.
+template <size_t kCapacity>
+class TimerWheel {
+ public:
+  using Tick = uint64_t;
+  using Token = ::pw::tokenizer::Token;
+
+  static constexpr size_t kLevels = 5;
+  static constexpr size_t kSlotBits = 6;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+  /// Longest delay or period that can be scheduled. Longer ones are clamped.
+  static constexpr Tick kMaxDelay = Tick{kSlots - 2}
+                                    << (kSlotBits * (kLevels - 1));
+
+  static_assert(kCapacity > 0 && kCapacity < 255,
+                "TimerWheel indexes timers with uint8_t");
+
+  explicit constexpr TimerWheel(Tick now = 0) : now_(now) {
+    heads_.fill(kNone);
+    table_.fill(kNone);
+  }
+
+  /// Registers a token. Returns ALREADY_EXISTS if it was registered before,
+  /// or RESOURCE_EXHAUSTED if the wheel is full.
+  pw::Status Add(Token token) {
+    if (Find(token) != kNone) {
+      return pw::Status::AlreadyExists();
+    }
+    if (size_ == kCapacity) {
+      return pw::Status::ResourceExhausted();
+    }
+    const Index index = size_++;
+    entries_[index].token = token;
+    size_t bucket = Hash(token);
+    while (table_[bucket] != kNone) {
+      bucket = (bucket + 1) & kTableMask;
+    }
+    table_[bucket] = index;
+    return pw::OkStatus();
+  }
+
+  /// Starts or restarts the timer for `token` so that it expires at
+  /// `deadline`. Deadlines at or before `now()` expire on the next `Advance`.
+  ///
+  /// If `period` is nonzero, the timer restarts each time it expires, at
+  /// multiples of `period` after `deadline`, until it is cancelled or
+  /// rescheduled. Periods that pass within one `Advance` expire once.
+  ///
+  /// Returns NOT_FOUND if the token was not registered.
+  pw::Status Schedule(Token token, Tick deadline, Tick period = 0) {
+    const Index index = Find(token);
+    if (index == kNone) {
+      return pw::Status::NotFound();
+    }
+    Entry& entry = entries_[index];
+    if (entry.pending) {
+      Unlink(index);
+    }
+    entry.deadline =
+        deadline > now_ + kMaxDelay ? now_ + kMaxDelay : deadline;
+    entry.period = period > kMaxDelay ? kMaxDelay : period;
+    entry.pending = true;
+    Place(index);
+    return pw::OkStatus();
+  }
+
+  /// Stops the timer for `token` if it is pending. Returns NOT_FOUND if the
+  /// token was not registered.
+  pw::Status Cancel(Token token) {
+    const Index index = Find(token);
+    if (index == kNone) {
+      return pw::Status::NotFound();
+    }
+    if (entries_[index].pending) {
+      Unlink(index);
+      entries_[index].pending = false;
+    }
+    return pw::OkStatus();
+  }
+
+  /// Returns whether the timer for `token` is pending.
+  bool pending(Token token) const {
+    const Index index = Find(token);
+    return index != kNone && entries_[index].pending;
+  }
+
+  /// Returns the tick at which `Advance` next has work to do, or nothing if no
+  /// timers are pending. This is either a deadline or the start of a slot
+  /// whose timers move to a lower level.
+  std::optional<Tick> NextEvent() const {
+    size_t level;
+    return FindNext(level);
+  }
+
+  /// Moves the wheel forward to `now`, calling `on_expired(token)` for each
+  /// timer whose deadline has passed. Periodic timers are restarted for their
+  /// first deadline after `now`. `on_expired` must not modify the wheel.
+  template <typename Function>
+  void Advance(Tick now, Function&& on_expired) {
+    size_t level;
+    std::optional<Tick> next;
+    while ((next = FindNext(level)).has_value() && *next <= now) {
+      now_ = *next;
+      const size_t slot = Slot(now_, level);
+      const size_t bucket = level * kSlots + slot;
+      Index index = heads_[bucket];
+      heads_[bucket] = kNone;
+      occupied_[level] &= ~(uint64_t{1} << slot);
+      while (index != kNone) {
+        const Index next_index = entries_[index].next;
+        Entry& entry = entries_[index];
+        if (level != 0) {
+          Place(index);
+        } else if (entry.period == 0) {
+          entry.pending = false;
+          on_expired(entry.token);
+        } else {
+          const Tick missed = now - entry.deadline;
+          entry.deadline += (missed / entry.period + 1) * entry.period;
+          Place(index);
+          on_expired(entry.token);
+        }
+        index = next_index;
+      }
+    }
+    if (now > now_) {
+      now_ = now;
+    }
+  }
+
+  /// The time the wheel has advanced to.
+  Tick now() const { return now_; }
+
+ private:
+  using Index = uint8_t;
+  static constexpr Index kNone = 0xff;
+
+  static constexpr size_t kTableSize = std::bit_ceil(kCapacity * 2);
+  static constexpr size_t kTableMask = kTableSize - 1;
+
+  struct Entry {
+    Token token = 0;
+    Tick deadline = 0;
+    Tick period = 0;
+    Index prev = kNone;
+    Index next = kNone;
+    uint16_t bucket = 0;
+    bool pending = false;
+  };
+
+  static constexpr size_t Hash(Token token) {
+    // Fibonacci hashing spreads tokens that differ only in their high bits.
+    return static_cast<size_t>((token * 2654435769u) >> 16) & kTableMask;
+  }
+
+  static constexpr size_t Shift(size_t level) { return kSlotBits * level; }
+
+  static constexpr size_t Slot(Tick tick, size_t level) {
+    return static_cast<size_t>(tick >> Shift(level)) & (kSlots - 1);
+  }
+
+  Index Find(Token token) const {
+    for (size_t bucket = Hash(token); table_[bucket] != kNone;
+         bucket = (bucket + 1) & kTableMask) {
+      if (entries_[table_[bucket]].token == token) {
+        return table_[bucket];
+      }
+    }
+    return kNone;
+  }
+
+  /// Returns the first tick that has work, and the level of its slot.
+  ///
+  /// Every slot in use is at or after the wheel's current slot on its level,
+  /// and lower levels only hold deadlines before the next slot of the levels
+  /// above, so the lowest level in use has the earliest event.
+  std::optional<Tick> FindNext(size_t& level) const {
+    for (level = 0; level + 1 < kLevels; ++level) {
+      if (occupied_[level] != 0) {
+        const size_t block_shift = Shift(level + 1);
+        return ((now_ >> block_shift) << block_shift) +
+               (Tick{static_cast<size_t>(std::countr_zero(occupied_[level]))}
+                << Shift(level));
+      }
+    }
+    // The top level wraps around, so its slots are searched from the one
+    // after the current slot.
+    const uint64_t occupied = occupied_[level];
+    if (occupied == 0) {
+      return std::nullopt;
+    }
+    const size_t current = Slot(now_, level);
+    const auto distance = static_cast<Tick>(
+        std::countr_zero(std::rotr(occupied, static_cast<int>(current + 1))) +
+        1);
+    return ((now_ >> Shift(level)) + distance) << Shift(level);
+  }
+
+  /// Links a pending entry into the slot for its deadline.
+  void Place(Index index) {
+    Entry& entry = entries_[index];
+    const Tick deadline = entry.deadline > now_ ? entry.deadline : now_;
+    size_t level = 0;
+    while (level + 1 < kLevels &&
+           (deadline >> Shift(level + 1)) != (now_ >> Shift(level + 1))) {
+      ++level;
+    }
+    const size_t slot = Slot(deadline, level);
+    const size_t bucket = level * kSlots + slot;
+    entry.bucket = static_cast<uint16_t>(bucket);
+    entry.prev = kNone;
+    entry.next = heads_[bucket];
+    if (entry.next != kNone) {
+      entries_[entry.next].prev = index;
+    }
+    heads_[bucket] = index;
+    occupied_[level] |= uint64_t{1} << slot;
+  }
+
+  void Unlink(Index index) {
+    Entry& entry = entries_[index];
+    if (entry.prev != kNone) {
+      entries_[entry.prev].next = entry.next;
+    } else {
+      heads_[entry.bucket] = entry.next;
+    }
+    if (entry.next != kNone) {
+      entries_[entry.next].prev = entry.prev;
+    }
+    if (heads_[entry.bucket] == kNone) {
+      occupied_[entry.bucket / kSlots] &=
+          ~(uint64_t{1} << (entry.bucket % kSlots));
+    }
+  }
+
+  Tick now_;
+  std::array<Entry, kCapacity> entries_;
+  std::array<Index, kLevels * kSlots> heads_;
+  std::array<uint64_t, kLevels> occupied_ = {};
+  std::array<Index, kTableSize> table_;
+  size_t size_ = 0;
+};
+
+}  // namespace sense
@@ -0,0 +1,167 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/event_timers/timer_wheel.h"
+
+#include <array>
+#include <cstdint>
+
+#include "pw_containers/vector.h"
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using Wheel = sense::TimerWheel<32>;
+using Tick = Wheel::Tick;
+using Token = Wheel::Token;
+
+/// Advances the wheel to `now` and returns the tokens that expired.
+pw::Vector<Token, 32> AdvanceTo(Wheel& wheel, Tick now) {
+  pw::Vector<Token, 32> expired;
+  wheel.Advance(now, [&expired](Token token) { expired.push_back(token); });
+  return expired;
+}
+
+TEST(TimerWheelTest, AddRejectsDuplicatesAndOverflow) {
+  sense::TimerWheel<2> wheel;
+  EXPECT_EQ(wheel.Add(1), pw::OkStatus());
+  EXPECT_EQ(wheel.Add(1), pw::Status::AlreadyExists());
+  EXPECT_EQ(wheel.Add(2), pw::OkStatus());
+  EXPECT_EQ(wheel.Add(3), pw::Status::ResourceExhausted());
+  EXPECT_EQ(wheel.Schedule(3, 10), pw::Status::NotFound());
+  EXPECT_EQ(wheel.Cancel(3), pw::Status::NotFound());
+}
+
+TEST(TimerWheelTest, ExpiresAtDeadline) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(7), pw::OkStatus());
+  EXPECT_FALSE(wheel.NextEvent().has_value());
+
+  ASSERT_EQ(wheel.Schedule(7, 10), pw::OkStatus());
+  EXPECT_TRUE(wheel.pending(7));
+  EXPECT_EQ(wheel.NextEvent(), Tick{10});
+  EXPECT_TRUE(AdvanceTo(wheel, 9).empty());
+
+  auto expired = AdvanceTo(wheel, 10);
+  ASSERT_EQ(expired.size(), 1u);
+  EXPECT_EQ(expired[0], 7u);
+  EXPECT_FALSE(wheel.pending(7));
+  EXPECT_FALSE(wheel.NextEvent().has_value());
+}
+
+TEST(TimerWheelTest, RescheduleReplacesDeadline) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(7), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(7, 10), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(7, 5000), pw::OkStatus());
+  EXPECT_TRUE(AdvanceTo(wheel, 4999).empty());
+  EXPECT_EQ(AdvanceTo(wheel, 5000).size(), 1u);
+}
+
+TEST(TimerWheelTest, CancelStopsTimer) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(1), pw::OkStatus());
+  ASSERT_EQ(wheel.Add(2), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(1, 100), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(2, 100), pw::OkStatus());
+  EXPECT_EQ(wheel.Cancel(1), pw::OkStatus());
+  EXPECT_EQ(wheel.Cancel(1), pw::OkStatus());
+
+  auto expired = AdvanceTo(wheel, 1000);
+  ASSERT_EQ(expired.size(), 1u);
+  EXPECT_EQ(expired[0], 2u);
+}
+
+TEST(TimerWheelTest, PastDeadlinesExpireOnNextAdvance) {
+  Wheel wheel(1000);
+  ASSERT_EQ(wheel.Add(1), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(1, 10), pw::OkStatus());
+  EXPECT_EQ(wheel.NextEvent(), Tick{1000});
+  EXPECT_EQ(AdvanceTo(wheel, 1000).size(), 1u);
+}
+
+TEST(TimerWheelTest, ClampsLongDelays) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(1), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(1, ~Tick{0}), pw::OkStatus());
+  EXPECT_TRUE(AdvanceTo(wheel, Wheel::kMaxDelay - 1).empty());
+  EXPECT_EQ(AdvanceTo(wheel, Wheel::kMaxDelay).size(), 1u);
+}
+
+// Steps the wheel through every event, like a hardware timer would, and
+// checks that each timer expires exactly at its deadline.
+TEST(TimerWheelTest, ManyTimersExpireAtTheirDeadlines) {
+  constexpr Tick kStart = (Tick{1} << 24) * 63 - 12345;
+  Wheel wheel(kStart);
+  std::array<Tick, 32> deadlines{};
+  uint32_t seed = 1;
+  for (Token token = 0; token < deadlines.size(); ++token) {
+    seed = seed * 1664525u + 1013904223u;
+    // Spread the delays over every level of the wheel.
+    const Tick delay = Tick{seed} >> (token % 5 * 6 + 3);
+    deadlines[token] = kStart + delay;
+    ASSERT_EQ(wheel.Add(token), pw::OkStatus());
+    ASSERT_EQ(wheel.Schedule(token, deadlines[token]), pw::OkStatus());
+  }
+
+  size_t expired = 0;
+  while (auto next = wheel.NextEvent()) {
+    ASSERT_GE(*next, wheel.now());
+    wheel.Advance(*next, [&](Token token) {
+      EXPECT_EQ(wheel.now(), deadlines[token]);
+      expired += 1;
+    });
+  }
+  EXPECT_EQ(expired, deadlines.size());
+}
+
+TEST(TimerWheelTest, PeriodicTimerRestarts) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(1), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(1, 100, 250), pw::OkStatus());
+  EXPECT_EQ(AdvanceTo(wheel, 100).size(), 1u);
+  EXPECT_TRUE(wheel.pending(1));
+  ASSERT_TRUE(wheel.NextEvent().has_value());
+  EXPECT_LE(*wheel.NextEvent(), Tick{350});
+  EXPECT_TRUE(AdvanceTo(wheel, 349).empty());
+  EXPECT_EQ(AdvanceTo(wheel, 350).size(), 1u);
+
+  EXPECT_EQ(wheel.Cancel(1), pw::OkStatus());
+  EXPECT_FALSE(wheel.NextEvent().has_value());
+}
+
+TEST(TimerWheelTest, PeriodicTimerSkipsMissedPeriods) {
+  Wheel wheel;
+  ASSERT_EQ(wheel.Add(1), pw::OkStatus());
+  ASSERT_EQ(wheel.Schedule(1, 100, 250), pw::OkStatus());
+
+  // A late advance expires the timer once and keeps its phase.
+  EXPECT_EQ(AdvanceTo(wheel, 1000).size(), 1u);
+  EXPECT_TRUE(AdvanceTo(wheel, 1099).empty());
+  EXPECT_EQ(AdvanceTo(wheel, 1100).size(), 1u);
+}
+
+TEST(TimerWheelTest, AdvancePastSeveralDeadlines) {
+  Wheel wheel;
+  for (Token token = 1; token <= 3; ++token) {
+    ASSERT_EQ(wheel.Add(token), pw::OkStatus());
+    ASSERT_EQ(wheel.Schedule(token, token * 100'000), pw::OkStatus());
+  }
+  EXPECT_EQ(AdvanceTo(wheel, 250'000).size(), 2u);
+  EXPECT_EQ(wheel.now(), Tick{250'000});
+  EXPECT_TRUE(wheel.pending(3));
+  EXPECT_EQ(AdvanceTo(wheel, 300'000).size(), 1u);
+}
+
+}  // namespace
@@ -0,0 +1,197 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/filters/batch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "pw_assert/check.h"
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include <arm_acle.h>
+#define SENSE_FILTERS_USE_DSP 1
+#else
+#define SENSE_FILTERS_USE_DSP 0
+#endif  // defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+
+namespace sense {
+namespace {
+
+#if SENSE_FILTERS_USE_DSP
+
+// Flips the sign bit of both halfwords, turning unsigned samples into signed
+// ones 32768 lower, which SMLALD can multiply.
+constexpr uint32_t kSignBits = 0x80008000u;
+constexpr int16x2_t kOnes = 0x00010001;
+
+// USUB16 sets the GE flags that SEL reads. They are kept in one statement,
+// since the compiler does not track the flags between the two intrinsics.
+inline uint32_t Min16x2(uint32_t a, uint32_t b) {
+  uint32_t result;
+  asm("usub16 %0, %1, %2\n\tsel %0, %2, %1"
+      : "=&r"(result)
+      : "r"(a), "r"(b)
+      : "cc");
+  return result;
+}
+
+inline uint32_t Max16x2(uint32_t a, uint32_t b) {
+  uint32_t result;
+  asm("usub16 %0, %1, %2\n\tsel %0, %1, %2"
+      : "=&r"(result)
+      : "r"(a), "r"(b)
+      : "cc");
+  return result;
+}
+
+inline uint32_t LoadPair(const uint16_t* samples) {
+  uint32_t pair;
+  std::memcpy(&pair, samples, sizeof(pair));
+  return pair;
+}
+
+#endif  // SENSE_FILTERS_USE_DSP
+
+uint64_t Sum(pw::span<const uint16_t> samples) {
+  uint64_t sum = 0;
+  size_t i = 0;
+#if SENSE_FILTERS_USE_DSP
+  int64_t offset_sum = 0;
+  for (; i + 2 <= samples.size(); i += 2) {
+    const auto pair =
+        static_cast<int16x2_t>(LoadPair(&samples[i]) ^ kSignBits);
+    offset_sum = __smlald(pair, kOnes, offset_sum);
+  }
+  sum = static_cast<uint64_t>(offset_sum + 32768 * static_cast<int64_t>(i));
+#endif  // SENSE_FILTERS_USE_DSP
+  for (; i < samples.size(); ++i) {
+    sum += samples[i];
+  }
+  return sum;
+}
+
+uint16_t RoundedMean(uint64_t sum, size_t count) {
+  return static_cast<uint16_t>((sum + count / 2) / count);
+}
+
+}  // namespace
+
+float BatchSummary::mean() const {
+  if (count == 0) {
+    return 0.f;
+  }
+  return static_cast<float>(sum) / static_cast<float>(count);
+}
+
+float BatchSummary::variance() const {
+  if (count < 2) {
+    return 0.f;
+  }
+  // sum^2 / n, split as (q * n + r)^2 / n so that nothing overflows and the
+  // large terms cancel exactly.
+  const uint64_t n = count;
+  const uint64_t q = sum / n;
+  const uint64_t r = sum % n;
+  const uint64_t spread = sum_of_squares - q * q * n - 2 * q * r;
+  const float squared_error =
+      static_cast<float>(spread) -
+      static_cast<float>(r * r) / static_cast<float>(n);
+  return std::max(squared_error, 0.f) / static_cast<float>(n - 1);
+}
+
+BatchSummary Summarize(pw::span<const uint16_t> samples) {
+  BatchSummary summary;
+  summary.count = samples.size();
+  if (samples.empty()) {
+    return summary;
+  }
+
+  uint16_t min = std::numeric_limits<uint16_t>::max();
+  uint16_t max = 0;
+  size_t i = 0;
+#if SENSE_FILTERS_USE_DSP
+  uint32_t min_pair = 0xffffffffu;
+  uint32_t max_pair = 0;
+  int64_t offset_sum = 0;
+  int64_t offset_squares = 0;
+  for (; i + 2 <= samples.size(); i += 2) {
+    const uint32_t pair = LoadPair(&samples[i]);
+    min_pair = Min16x2(pair, min_pair);
+    max_pair = Max16x2(pair, max_pair);
+    const auto offset = static_cast<int16x2_t>(pair ^ kSignBits);
+    offset_sum = __smlald(offset, kOnes, offset_sum);
+    offset_squares = __smlald(offset, offset, offset_squares);
+  }
+  if (i > 0) {
+    min = std::min(static_cast<uint16_t>(min_pair),
+                   static_cast<uint16_t>(min_pair >> 16));
+    max = std::max(static_cast<uint16_t>(max_pair),
+                   static_cast<uint16_t>(max_pair >> 16));
+  }
+  // Undo the offset: x = y + 32768, so x^2 = y^2 + 65536 y + 2^30.
+  const auto pairs_count = static_cast<int64_t>(i);
+  summary.sum = static_cast<uint64_t>(offset_sum + 32768 * pairs_count);
+  summary.sum_of_squares = static_cast<uint64_t>(
+      offset_squares + 65536 * offset_sum + (int64_t{1} << 30) * pairs_count);
+#endif  // SENSE_FILTERS_USE_DSP
+  for (; i < samples.size(); ++i) {
+    const uint16_t sample = samples[i];
+    min = std::min(min, sample);
+    max = std::max(max, sample);
+    summary.sum += sample;
+    summary.sum_of_squares += uint64_t{sample} * sample;
+  }
+  summary.min = min;
+  summary.max = max;
+  return summary;
+}
+
+size_t MovingAverage(pw::span<const uint16_t> samples,
+                     size_t window,
+                     pw::span<uint16_t> output) {
+  PW_CHECK_UINT_GT(window, 0);
+  if (samples.size() < window) {
+    return 0;
+  }
+  const size_t count = std::min(samples.size() - window + 1, output.size());
+  if (count == 0) {
+    return 0;
+  }
+
+  // A running sum costs one add and one subtract per output whatever the
+  // window, so only the first window is summed in bulk.
+  uint64_t sum = Sum(samples.first(window));
+  output[0] = RoundedMean(sum, window);
+  for (size_t i = 1; i < count; ++i) {
+    sum += samples[i + window - 1];
+    sum -= samples[i - 1];
+    output[i] = RoundedMean(sum, window);
+  }
+  return count;
+}
+
+size_t Downsample(pw::span<const uint16_t> samples,
+                  size_t factor,
+                  pw::span<uint16_t> output) {
+  PW_CHECK_UINT_GT(factor, 0);
+  const size_t count = std::min(samples.size() / factor, output.size());
+  for (size_t i = 0; i < count; ++i) {
+    output[i] = RoundedMean(Sum(samples.subspan(i * factor, factor)), factor);
+  }
+  return count;
+}
+
+}  // namespace sense
@@ -0,0 +1,62 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_span/span.h"
+
+namespace sense {
+
+/// Statistics of a batch of samples, from `Summarize`.
+struct BatchSummary {
+  size_t count = 0;
+  uint16_t min = 0;
+  uint16_t max = 0;
+  uint64_t sum = 0;
+  uint64_t sum_of_squares = 0;
+
+  /// Mean of the samples, or zero if there are none.
+  float mean() const;
+
+  /// Sample variance, or zero with fewer than two samples.
+  float variance() const;
+};
+
+// Kernels for processing samples a batch at a time, e.g. a sensor FIFO read.
+// On cores with the DSP extension, such as the RP2350's Cortex-M33, they work
+// on two samples per instruction; elsewhere they are scalar.
+
+/// Returns the count, range, sum and sum of squares of `samples`.
+BatchSummary Summarize(pw::span<const uint16_t> samples);
+
+/// Writes the rounded mean of each run of `window` consecutive samples, i.e.
+/// one output per sample once the window has filled.
+///
+/// @returns the number of outputs written, which is at most
+/// `samples.size() - window + 1` and `output.size()`.
+size_t MovingAverage(pw::span<const uint16_t> samples,
+                     size_t window,
+                     pw::span<uint16_t> output);
+
+/// Writes the rounded mean of each group of `factor` samples. A trailing
+/// partial group is not written.
+///
+/// @returns the number of outputs written.
+size_t Downsample(pw::span<const uint16_t> samples,
+                  size_t factor,
+                  pw::span<uint16_t> output);
+
+}  // namespace sense
@@ -0,0 +1,93 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/filters/batch.h"
+
+#include <array>
+#include <cstdint>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using sense::BatchSummary;
+
+TEST(SummarizeTest, Empty) {
+  const BatchSummary summary = sense::Summarize({});
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.mean(), 0.f);
+  EXPECT_EQ(summary.variance(), 0.f);
+}
+
+TEST(SummarizeTest, OddCount) {
+  constexpr std::array<uint16_t, 5> kSamples = {4, 8, 1, 9, 3};
+  const BatchSummary summary = sense::Summarize(kSamples);
+  EXPECT_EQ(summary.count, 5u);
+  EXPECT_EQ(summary.min, 1u);
+  EXPECT_EQ(summary.max, 9u);
+  EXPECT_EQ(summary.sum, 25u);
+  EXPECT_EQ(summary.sum_of_squares, 171u);
+  EXPECT_FLOAT_EQ(summary.mean(), 5.f);
+  EXPECT_FLOAT_EQ(summary.variance(), 11.5f);
+}
+
+TEST(SummarizeTest, FullRange) {
+  constexpr std::array<uint16_t, 4> kSamples = {65535, 0, 32768, 32767};
+  const BatchSummary summary = sense::Summarize(kSamples);
+  EXPECT_EQ(summary.min, 0u);
+  EXPECT_EQ(summary.max, 65535u);
+  EXPECT_EQ(summary.sum, 131070u);
+  EXPECT_EQ(summary.sum_of_squares,
+            65535ull * 65535 + 32768ull * 32768 + 32767ull * 32767);
+}
+
+TEST(SummarizeTest, VarianceOfLargeValuesWithSmallSpread) {
+  // Float sums of squares would lose the spread entirely at this magnitude.
+  std::array<uint16_t, 1000> samples;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = i % 2 == 0 ? 60000 : 60002;
+  }
+  const BatchSummary summary = sense::Summarize(samples);
+  EXPECT_FLOAT_EQ(summary.mean(), 60001.f);
+  EXPECT_NEAR(summary.variance(), 1.001f, 0.001f);
+}
+
+TEST(MovingAverageTest, OneOutputPerFullWindow) {
+  constexpr std::array<uint16_t, 6> kSamples = {0, 3, 6, 9, 12, 15};
+  std::array<uint16_t, 6> output{};
+  ASSERT_EQ(sense::MovingAverage(kSamples, 3, output), 4u);
+  EXPECT_EQ(output[0], 3u);
+  EXPECT_EQ(output[1], 6u);
+  EXPECT_EQ(output[2], 9u);
+  EXPECT_EQ(output[3], 12u);
+}
+
+TEST(MovingAverageTest, StopsAtOutputSize) {
+  constexpr std::array<uint16_t, 6> kSamples = {1, 2, 3, 4, 5, 6};
+  std::array<uint16_t, 2> output{};
+  EXPECT_EQ(sense::MovingAverage(kSamples, 2, output), 2u);
+  EXPECT_EQ(output[0], 2u);  // 1.5 rounds up
+  EXPECT_EQ(output[1], 3u);
+  EXPECT_EQ(sense::MovingAverage(kSamples, 7, output), 0u);
+}
+
+TEST(DownsampleTest, AveragesCompleteGroups) {
+  constexpr std::array<uint16_t, 7> kSamples = {1, 2, 3, 10, 20, 30, 99};
+  std::array<uint16_t, 4> output{};
+  ASSERT_EQ(sense::Downsample(kSamples, 3, output), 2u);
+  EXPECT_EQ(output[0], 2u);
+  EXPECT_EQ(output[1], 20u);
+}
+
+}  // namespace
@@ -0,0 +1,215 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+
+namespace sense {
+
+/// Median of the last `kWindow` samples, which rejects isolated spikes.
+///
+/// Until the window fills, the median of the samples seen so far is returned.
+/// Samples must be integers: the oldest sample is found again by value, which
+/// would fail for a NaN.
+template <typename Sample, size_t kWindow>
+class MovingMedian {
+ public:
+  static_assert(kWindow > 0 && kWindow % 2 == 1,
+                "The median window must have an odd size");
+  static_assert(std::is_integral_v<Sample>,
+                "The median only supports integer samples");
+
+  /// Adds a sample and returns the median of the window.
+  Sample Update(Sample sample) {
+    // Replace the oldest sample in the sorted copy, then restore its order
+    // with one pass of insertion sort.
+    size_t index;
+    if (count_ < kWindow) {
+      index = count_++;
+    } else {
+      const auto oldest =
+          std::find(sorted_.begin(), sorted_.end(), history_[next_]);
+      index = static_cast<size_t>(oldest - sorted_.begin());
+    }
+    history_[next_] = sample;
+    next_ = (next_ + 1) % kWindow;
+    sorted_[index] = sample;
+    while (index > 0 && sorted_[index - 1] > sorted_[index]) {
+      std::swap(sorted_[index - 1], sorted_[index]);
+      --index;
+    }
+    while (index + 1 < count_ && sorted_[index + 1] < sorted_[index]) {
+      std::swap(sorted_[index + 1], sorted_[index]);
+      ++index;
+    }
+    return sorted_[count_ / 2];
+  }
+
+  void Reset() {
+    count_ = 0;
+    next_ = 0;
+  }
+
+ private:
+  std::array<Sample, kWindow> history_{};
+  std::array<Sample, kWindow> sorted_{};
+  size_t count_ = 0;
+  size_t next_ = 0;
+};
+
+/// One-pole low-pass filter: `y += (x - y) / 2^kShift`.
+///
+/// Integer samples are filtered in fixed point, with 16 fractional bits of
+/// state, so steps smaller than `2^kShift` are not lost to truncation. The
+/// first sample initializes the output.
+template <typename Sample, unsigned kShift>
+class OnePoleLowPass {
+ public:
+  static_assert(kShift > 0 && kShift < 16, "The shift must be from 1 to 15");
+  static_assert(std::is_arithmetic_v<Sample>);
+
+  /// Adds a sample and returns the filtered value.
+  Sample Update(Sample sample) {
+    if constexpr (std::is_floating_point_v<Sample>) {
+      if (!primed_) {
+        state_ = sample;
+        primed_ = true;
+      } else {
+        state_ += (sample - state_) / static_cast<Sample>(1u << kShift);
+      }
+      return state_;
+    } else {
+      const State scaled = static_cast<State>(sample) << kFractionBits;
+      if (!primed_) {
+        state_ = scaled;
+        primed_ = true;
+      } else {
+        state_ += (scaled - state_) >> kShift;
+      }
+      return Round(state_);
+    }
+  }
+
+  /// Returns the filtered value, or nothing before the first sample.
+  std::optional<Sample> value() const {
+    if (!primed_) {
+      return std::nullopt;
+    }
+    if constexpr (std::is_floating_point_v<Sample>) {
+      return state_;
+    } else {
+      return Round(state_);
+    }
+  }
+
+  void Reset() { primed_ = false; }
+
+ private:
+  using State = std::conditional_t<std::is_floating_point_v<Sample>,
+                                   Sample,
+                                   int64_t>;
+
+  static constexpr unsigned kFractionBits = 16;
+
+  /// Rounds fixed-point state to the nearest sample value.
+  static constexpr Sample Round(State state) {
+    return static_cast<Sample>((state + (State{1} << (kFractionBits - 1))) >>
+                               kFractionBits);
+  }
+
+  State state_ = 0;
+  bool primed_ = false;
+};
+
+/// Passes one of every `kFactor` samples.
+template <typename Sample, size_t kFactor>
+class Decimator {
+ public:
+  static_assert(kFactor > 0);
+
+  /// Returns the sample if it is the last of its group of `kFactor`.
+  std::optional<Sample> Update(Sample sample) {
+    if (++count_ < kFactor) {
+      return std::nullopt;
+    }
+    count_ = 0;
+    return sample;
+  }
+
+  void Reset() { count_ = 0; }
+
+ private:
+  size_t count_ = 0;
+};
+
+/// Runs samples through `Filters` in order.
+///
+/// Each filter has an `Update(Sample)` that returns either the filtered sample
+/// or an optional one. A filter that returns nothing, like a `Decimator`, ends
+/// the chain for that sample.
+///
+/// Example:
+///
+/// @code{.cpp}
+///   FilterChain<uint16_t,
+///               MovingMedian<uint16_t, 5>,
+///               OnePoleLowPass<uint16_t, 2>,
+///               Decimator<uint16_t, 4>>
+///       chain;
+///   if (std::optional<uint16_t> sample = chain.Update(raw)) {
+///     Publish(*sample);
+///   }
+/// @endcode
+template <typename Sample, typename... Filters>
+class FilterChain {
+ public:
+  /// Adds a sample and returns the output of the last filter, if any.
+  std::optional<Sample> Update(Sample sample) {
+    return UpdateFrom<0>(sample);
+  }
+
+  void Reset() {
+    std::apply([](auto&... filters) { (filters.Reset(), ...); }, filters_);
+  }
+
+  /// Returns the filter at `kIndex`, e.g. to read its state.
+  template <size_t kIndex>
+  auto& get() {
+    return std::get<kIndex>(filters_);
+  }
+
+ private:
+  template <size_t kIndex>
+  std::optional<Sample> UpdateFrom(Sample sample) {
+    if constexpr (kIndex == sizeof...(Filters)) {
+      return sample;
+    } else {
+      std::optional<Sample> output = std::get<kIndex>(filters_).Update(sample);
+      if (!output.has_value()) {
+        return std::nullopt;
+      }
+      return UpdateFrom<kIndex + 1>(*output);
+    }
+  }
+
+  std::tuple<Filters...> filters_;
+};
+
+}  // namespace sense
@@ -0,0 +1,111 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/filters/filters.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+TEST(MovingMedianTest, RejectsSpikes) {
+  sense::MovingMedian<uint16_t, 3> median;
+  EXPECT_EQ(median.Update(10), 10u);
+  EXPECT_EQ(median.Update(1000), 1000u);  // median of {10, 1000}
+  EXPECT_EQ(median.Update(12), 12u);
+  EXPECT_EQ(median.Update(11), 12u);
+  EXPECT_EQ(median.Update(0), 11u);
+  EXPECT_EQ(median.Update(13), 11u);
+  EXPECT_EQ(median.Update(14), 13u);
+}
+
+TEST(MovingMedianTest, MatchesSortedWindow) {
+  sense::MovingMedian<int, 5> median;
+  std::array<int, 5> window{};
+  uint32_t seed = 3;
+  for (size_t i = 0; i < 100; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    const int sample = static_cast<int>(seed >> 24) - 128;
+    window[i % window.size()] = sample;
+    const int result = median.Update(sample);
+    if (i + 1 >= window.size()) {
+      std::array<int, 5> sorted = window;
+      std::sort(sorted.begin(), sorted.end());
+      EXPECT_EQ(result, sorted[2]);
+    }
+  }
+}
+
+TEST(OnePoleLowPassTest, FixedPointConverges) {
+  sense::OnePoleLowPass<uint16_t, 2> filter;
+  EXPECT_FALSE(filter.value().has_value());
+  EXPECT_EQ(filter.Update(100), 100u);
+  EXPECT_EQ(filter.Update(200), 125u);
+  for (int i = 0; i < 40; ++i) {
+    filter.Update(200);
+  }
+  EXPECT_EQ(filter.value(), 200u);
+
+  // A step smaller than 2^kShift still moves the output.
+  for (int i = 0; i < 40; ++i) {
+    filter.Update(201);
+  }
+  EXPECT_EQ(filter.value(), 201u);
+}
+
+TEST(OnePoleLowPassTest, FloatingPoint) {
+  sense::OnePoleLowPass<float, 2> filter;
+  EXPECT_FLOAT_EQ(filter.Update(40.f), 40.f);
+  EXPECT_FLOAT_EQ(filter.Update(80.f), 50.f);
+  filter.Reset();
+  EXPECT_FLOAT_EQ(filter.Update(8.f), 8.f);
+}
+
+TEST(DecimatorTest, PassesEveryNthSample) {
+  sense::Decimator<int, 3> decimator;
+  EXPECT_FALSE(decimator.Update(1).has_value());
+  EXPECT_FALSE(decimator.Update(2).has_value());
+  EXPECT_EQ(decimator.Update(3), 3);
+  EXPECT_FALSE(decimator.Update(4).has_value());
+  decimator.Reset();
+  EXPECT_FALSE(decimator.Update(5).has_value());
+  EXPECT_FALSE(decimator.Update(6).has_value());
+  EXPECT_EQ(decimator.Update(7), 7);
+}
+
+TEST(FilterChainTest, AppliesFiltersInOrder) {
+  sense::FilterChain<uint16_t,
+                     sense::MovingMedian<uint16_t, 3>,
+                     sense::Decimator<uint16_t, 2>>
+      chain;
+  EXPECT_FALSE(chain.Update(10).has_value());
+  EXPECT_EQ(chain.Update(900), 900u);
+  EXPECT_FALSE(chain.Update(12).has_value());
+  EXPECT_EQ(chain.Update(11), 12u);
+
+  chain.Reset();
+  EXPECT_FALSE(chain.Update(5).has_value());
+  EXPECT_EQ(chain.Update(5), 5u);
+}
+
+TEST(FilterChainTest, EmptyChainPassesSamples) {
+  sense::FilterChain<int> chain;
+  EXPECT_EQ(chain.Update(4), 4);
+}
+
+}  // namespace
@@ -0,0 +1,77 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/frame_pool/frame_pool.h"
+
+#include <mutex>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+
+FramePool::FramePool(pw::span<std::byte> storage,
+                     size_t block_size,
+                     pw::tokenizer::Token name)
+    : begin_(storage.data()),
+      block_size_(AlignedBlockSize(block_size)),
+      blocks_(storage.size() / block_size_),
+      metrics_(name) {
+  PW_CHECK(reinterpret_cast<uintptr_t>(begin_) % kAlignment == 0,
+           "Frame pool storage must be aligned");
+  // Thread the free list through the blocks, lowest address first.
+  for (size_t i = blocks_; i > 0; --i) {
+    auto* block = reinterpret_cast<FreeBlock*>(begin_ + (i - 1) * block_size_);
+    block->next = free_;
+    free_ = block;
+  }
+}
+
+void* FramePool::DoAllocate(Layout layout) {
+  std::lock_guard lock(lock_);
+  if (layout.size() > largest_request_.value()) {
+    largest_request_.Set(layout.size());
+  }
+  if (free_ == nullptr || layout.size() > block_size_ ||
+      layout.alignment() > kAlignment) {
+    failures_.Increment();
+    return nullptr;
+  }
+  FreeBlock* block = free_;
+  free_ = block->next;
+
+  allocations_.Increment();
+  in_use_.Increment();
+  if (in_use_.value() > peak_in_use_.value()) {
+    peak_in_use_.Set(in_use_.value());
+  }
+  return block;
+}
+
+void FramePool::DoDeallocate(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto* bytes = static_cast<std::byte*>(ptr);
+  PW_CHECK(bytes >= begin_ && bytes < begin_ + blocks_ * block_size_ &&
+               (bytes - begin_) % block_size_ == 0,
+           "Freed a pointer that is not a frame pool block");
+
+  std::lock_guard lock(lock_);
+  auto* block = static_cast<FreeBlock*>(ptr);
+  block->next = free_;
+  free_ = block;
+  in_use_.Set(in_use_.value() - 1);
+}
+
+}  // namespace sense
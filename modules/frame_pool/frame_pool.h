@@ -0,0 +1,103 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_allocator/allocator.h"
+#include "pw_metric/metric.h"
+#include "pw_span/span.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Allocator that hands out fixed-size blocks from dedicated storage.
+///
+/// A coroutine's frame is the same size every time it is created, so a pool
+/// whose blocks fit the largest frame allocates in constant time and cannot
+/// fragment, unlike the shared system heap. Requests larger than a block, or
+/// made while every block is in use, fail.
+class FramePool : public pw::Allocator {
+ public:
+  /// Blocks are aligned to this, which suits any coroutine frame.
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+  /// Splits `storage` into blocks of at least `block_size` bytes. The metric
+  /// group is named by `name`, e.g. `PW_METRIC_TOKEN("blinky frames")`.
+  FramePool(pw::span<std::byte> storage,
+            size_t block_size,
+            pw::tokenizer::Token name);
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  size_t block_size() const { return block_size_; }
+  size_t blocks() const { return blocks_; }
+
+  uint32_t in_use() const { return in_use_.value(); }
+  uint32_t peak_in_use() const { return peak_in_use_.value(); }
+  uint32_t failures() const { return failures_.value(); }
+  uint32_t largest_request() const { return largest_request_.value(); }
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+  /// Rounds a block size up so that every block stays aligned.
+  static constexpr size_t AlignedBlockSize(size_t size) {
+    const size_t bytes = size < sizeof(void*) ? sizeof(void*) : size;
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  void* DoAllocate(Layout layout) override;
+  void DoDeallocate(void* ptr) override;
+
+  std::byte* const begin_;
+  const size_t block_size_;
+  const size_t blocks_;
+
+  pw::sync::InterruptSpinLock lock_;
+  FreeBlock* free_ PW_GUARDED_BY(lock_) = nullptr;
+
+  pw::metric::Group metrics_;
+  PW_METRIC(metrics_, allocations_, "allocations", 0u);
+  PW_METRIC(metrics_, failures_, "failures", 0u);
+  PW_METRIC(metrics_, in_use_, "in use", 0u);
+  PW_METRIC(metrics_, peak_in_use_, "peak in use", 0u);
+  PW_METRIC(metrics_, largest_request_, "largest request bytes", 0u);
+};
+
+/// `FramePool` with its own storage for `kBlocks` frames of up to
+/// `kBlockSize` bytes.
+template <size_t kBlockSize, size_t kBlocks>
+class FramePoolBuffer : public FramePool {
+ public:
+  static_assert(kBlocks > 0, "A frame pool needs at least one block");
+
+  explicit FramePoolBuffer(pw::tokenizer::Token name)
+      : FramePool(storage_, kBlockSize, name) {}
+
+ private:
+  alignas(kAlignment)
+      std::array<std::byte, AlignedBlockSize(kBlockSize) * kBlocks> storage_;
+};
+
+}  // namespace sense
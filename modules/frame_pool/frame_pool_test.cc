@@ -0,0 +1,78 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/frame_pool/frame_pool.h"
+
+#include <cstdint>
+
+#include "pw_allocator/layout.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using ::pw::allocator::Layout;
+
+constexpr size_t kBlockSize = 64;
+constexpr size_t kBlocks = 3;
+
+class FramePoolTest : public ::testing::Test {
+ protected:
+  FramePoolBuffer<kBlockSize, kBlocks> pool_{PW_METRIC_TOKEN("test frames")};
+};
+
+TEST_F(FramePoolTest, AllocatesEveryBlockThenFails) {
+  void* blocks[kBlocks];
+  for (void*& block : blocks) {
+    block = pool_.Allocate(Layout(kBlockSize));
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % FramePool::kAlignment, 0u);
+  }
+  EXPECT_EQ(pool_.Allocate(Layout(1)), nullptr);
+  EXPECT_EQ(pool_.in_use(), kBlocks);
+  EXPECT_EQ(pool_.failures(), 1u);
+
+  for (void* block : blocks) {
+    pool_.Deallocate(block);
+  }
+  EXPECT_EQ(pool_.in_use(), 0u);
+  EXPECT_EQ(pool_.peak_in_use(), kBlocks);
+}
+
+TEST_F(FramePoolTest, ReusesFreedBlock) {
+  void* first = pool_.Allocate(Layout(16));
+  pool_.Deallocate(first);
+  EXPECT_EQ(pool_.Allocate(Layout(32)), first);
+}
+
+TEST_F(FramePoolTest, RejectsOversizedRequest) {
+  EXPECT_EQ(pool_.Allocate(Layout(kBlockSize + 1)), nullptr);
+  EXPECT_EQ(pool_.failures(), 1u);
+  EXPECT_EQ(pool_.largest_request(), kBlockSize + 1);
+  EXPECT_EQ(pool_.in_use(), 0u);
+}
+
+TEST_F(FramePoolTest, RoundsBlocksUpToAlignment) {
+  FramePoolBuffer<1, 2> pool(PW_METRIC_TOKEN("tiny frames"));
+  EXPECT_EQ(pool.block_size(), FramePool::kAlignment);
+  EXPECT_EQ(pool.blocks(), 2u);
+  void* a = pool.Allocate(Layout(1));
+  void* b = pool.Allocate(Layout(1));
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a, b);
+}
+
+}  // namespace
+}  // namespace sense
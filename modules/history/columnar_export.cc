@@ -0,0 +1,83 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/columnar_export.h"
+
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace sense {
+
+ColumnarExport::ColumnarExport(pw::ByteSpan buffer,
+                               uint32_t period_s,
+                               bool include_range)
+    : buffer_(buffer),
+      period_s_(period_s),
+      include_range_(include_range),
+      capacity_(buffer.size() /
+                (lanes() * sizeof(int32_t) + kTimeDeltaSize)) {}
+
+bool ColumnarExport::Add(const HistoryTier::Point& point) {
+  if (count_ == capacity_) {
+    return false;
+  }
+  uint32_t periods = 0;
+  if (count_ == 0) {
+    start_s_ = point.time_s;
+  } else {
+    periods = (point.time_s - last_s_) / period_s_;
+    if (periods > std::numeric_limits<uint16_t>::max()) {
+      return false;
+    }
+  }
+  last_s_ = point.time_s;
+
+  const std::array<int32_t, HistoryTier::kLanes> values = {
+      point.mean, point.min, point.max};
+  for (size_t lane = 0; lane < lanes(); ++lane) {
+    Put(ColumnOffset(lane, capacity_) + count_ * sizeof(int32_t),
+        static_cast<uint32_t>(values[lane]),
+        sizeof(int32_t));
+  }
+  Put(ColumnOffset(lanes(), capacity_) + count_ * kTimeDeltaSize,
+      periods,
+      kTimeDeltaSize);
+  ++count_;
+  return true;
+}
+
+pw::ConstByteSpan ColumnarExport::Finish() {
+  // Every column starts at or before its position in the full layout, so
+  // moving them up in order never overwrites one that is still to be moved.
+  for (size_t lane = 1; lane <= lanes(); ++lane) {
+    const size_t size =
+        count_ * (lane < lanes() ? sizeof(int32_t) : kTimeDeltaSize);
+    std::memmove(buffer_.data() + ColumnOffset(lane, count_),
+                 buffer_.data() + ColumnOffset(lane, capacity_),
+                 size);
+  }
+  const size_t size =
+      ColumnOffset(lanes(), count_) + count_ * kTimeDeltaSize;
+  capacity_ = count_;
+  return buffer_.first(size);
+}
+
+void ColumnarExport::Put(size_t offset, uint32_t value, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    buffer_[offset + i] = static_cast<std::byte>(value >> (8 * i));
+  }
+}
+
+}  // namespace sense
@@ -0,0 +1,83 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/history/history_tier.h"
+#include "pw_bytes/span.h"
+
+namespace sense {
+
+/// Packs history points into the columnar layout of
+/// `history.ExportChunk.data`, so that clients can read each column directly
+/// as a typed array.
+///
+/// For `n` points the layout is, all little-endian:
+///
+///   int32  mean[n]
+///   int32  min[n]            (only with ranges)
+///   int32  max[n]            (only with ranges)
+///   uint16 time_delta[n]
+///
+/// Values are quantized as in the history store. Each time delta is the
+/// number of periods since the previous point; the first is relative to the
+/// first point's time, so it is always 0.
+class ColumnarExport {
+ public:
+  /// Packs points into `buffer`, which must stay valid until `Finish`.
+  ColumnarExport(pw::ByteSpan buffer, uint32_t period_s, bool include_range);
+
+  ColumnarExport(const ColumnarExport&) = delete;
+  ColumnarExport& operator=(const ColumnarExport&) = delete;
+
+  /// Adds a point. Points must be added in time order.
+  ///
+  /// @returns false if the point does not fit, either because the buffer is
+  /// full or because the time since the previous point is too long to
+  /// encode. The point should then start the next export.
+  bool Add(const HistoryTier::Point& point);
+
+  /// Moves the columns next to each other and returns the packed data. No
+  /// more points can be added afterwards.
+  pw::ConstByteSpan Finish();
+
+  size_t count() const { return count_; }
+
+  /// Time of the first point, in seconds since boot.
+  uint32_t start_s() const { return start_s_; }
+
+ private:
+  static constexpr size_t kTimeDeltaSize = sizeof(uint16_t);
+
+  size_t lanes() const { return include_range_ ? HistoryTier::kLanes : 1; }
+
+  // Columns are written at offsets for a full buffer, then compacted.
+  size_t ColumnOffset(size_t lane, size_t points) const {
+    return lane * points * sizeof(int32_t);
+  }
+
+  void Put(size_t offset, uint32_t value, size_t size);
+
+  pw::ByteSpan buffer_;
+  const uint32_t period_s_;
+  const bool include_range_;
+  size_t capacity_;
+  size_t count_ = 0;
+  uint32_t start_s_ = 0;
+  uint32_t last_s_ = 0;
+};
+
+}  // namespace sense
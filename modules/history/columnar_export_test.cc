@@ -0,0 +1,98 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/columnar_export.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using sense::ColumnarExport;
+using sense::HistoryTier;
+
+int32_t ReadInt32(pw::ConstByteSpan data, size_t offset) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < sizeof(value); ++i) {
+    value |= static_cast<uint32_t>(data[offset + i]) << (8 * i);
+  }
+  return static_cast<int32_t>(value);
+}
+
+uint16_t ReadUint16(pw::ConstByteSpan data, size_t offset) {
+  return static_cast<uint16_t>(static_cast<uint16_t>(data[offset]) |
+                               static_cast<uint16_t>(data[offset + 1]) << 8);
+}
+
+TEST(ColumnarExportTest, PacksColumns) {
+  std::array<std::byte, 64> buffer;
+  ColumnarExport packer(buffer, 60, /*include_range=*/true);
+  ASSERT_TRUE(packer.Add({.time_s = 120, .mean = 5, .min = 4, .max = 6}));
+  ASSERT_TRUE(packer.Add({.time_s = 180, .mean = -7, .min = -9, .max = 0}));
+  ASSERT_TRUE(packer.Add({.time_s = 420, .mean = 70000, .min = 1, .max = 2}));
+
+  EXPECT_EQ(packer.count(), 3u);
+  EXPECT_EQ(packer.start_s(), 120u);
+  pw::ConstByteSpan data = packer.Finish();
+  ASSERT_EQ(data.size(), 3u * (3 * 4 + 2));
+
+  EXPECT_EQ(ReadInt32(data, 0), 5);
+  EXPECT_EQ(ReadInt32(data, 4), -7);
+  EXPECT_EQ(ReadInt32(data, 8), 70000);
+  EXPECT_EQ(ReadInt32(data, 12), 4);
+  EXPECT_EQ(ReadInt32(data, 16), -9);
+  EXPECT_EQ(ReadInt32(data, 20), 1);
+  EXPECT_EQ(ReadInt32(data, 24), 6);
+  EXPECT_EQ(ReadInt32(data, 28), 0);
+  EXPECT_EQ(ReadInt32(data, 32), 2);
+  EXPECT_EQ(ReadUint16(data, 36), 0u);
+  EXPECT_EQ(ReadUint16(data, 38), 1u);
+  EXPECT_EQ(ReadUint16(data, 40), 4u);
+}
+
+TEST(ColumnarExportTest, MeansOnly) {
+  std::array<std::byte, 64> buffer;
+  ColumnarExport packer(buffer, 1, /*include_range=*/false);
+  ASSERT_TRUE(packer.Add({.time_s = 10, .mean = 1, .min = 0, .max = 0}));
+  ASSERT_TRUE(packer.Add({.time_s = 12, .mean = 2, .min = 0, .max = 0}));
+
+  pw::ConstByteSpan data = packer.Finish();
+  ASSERT_EQ(data.size(), 2u * (4 + 2));
+  EXPECT_EQ(ReadInt32(data, 0), 1);
+  EXPECT_EQ(ReadInt32(data, 4), 2);
+  EXPECT_EQ(ReadUint16(data, 8), 0u);
+  EXPECT_EQ(ReadUint16(data, 10), 2u);
+}
+
+TEST(ColumnarExportTest, StopsWhenFull) {
+  std::array<std::byte, 13> buffer;
+  ColumnarExport packer(buffer, 1, /*include_range=*/false);
+  EXPECT_TRUE(packer.Add({.time_s = 0, .mean = 1, .min = 1, .max = 1}));
+  EXPECT_TRUE(packer.Add({.time_s = 1, .mean = 2, .min = 2, .max = 2}));
+  EXPECT_FALSE(packer.Add({.time_s = 2, .mean = 3, .min = 3, .max = 3}));
+  EXPECT_EQ(packer.Finish().size(), 12u);
+}
+
+TEST(ColumnarExportTest, StopsAtLongGap) {
+  std::array<std::byte, 64> buffer;
+  ColumnarExport packer(buffer, 1, /*include_range=*/false);
+  EXPECT_TRUE(packer.Add({.time_s = 0, .mean = 1, .min = 1, .max = 1}));
+  EXPECT_FALSE(packer.Add({.time_s = 70000, .mean = 2, .min = 2, .max = 2}));
+  EXPECT_EQ(packer.count(), 1u);
+}
+
+}  // namespace
@@ -0,0 +1,143 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/history.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+namespace {
+
+int32_t Quantize(float value, float scale) {
+  // Stay clear of the int32 limits, which floats cannot represent exactly.
+  constexpr float kMax = 2e9f;
+  const float scaled = std::clamp(value * scale, -kMax, kMax);
+  return static_cast<int32_t>(std::lround(scaled));
+}
+
+uint32_t ToSeconds(pw::chrono::SystemClock::time_point time) {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch())
+          .count());
+}
+
+}  // namespace
+
+void History::Accumulator::Add(const HistoryTier::Point& point) {
+  if (!active) {
+    active = true;
+    count = 0;
+    sum = 0;
+    min = point.min;
+    max = point.max;
+  }
+  sum += point.mean;
+  ++count;
+  min = std::min(min, point.min);
+  max = std::max(max, point.max);
+}
+
+HistoryTier::Point History::Accumulator::Take() {
+  active = false;
+  return {
+      .time_s = start_s,
+      .mean = static_cast<int32_t>(sum / static_cast<int64_t>(count)),
+      .min = min,
+      .max = max,
+  };
+}
+
+History::SeriesHistory::SeriesHistory()
+    : tiers{{
+          HistoryTier(second_blocks, kTierPeriods[0]),
+          HistoryTier(minute_blocks, kTierPeriods[1]),
+          HistoryTier(hour_blocks, kTierPeriods[2]),
+      }} {}
+
+History::History() = default;
+
+void History::Init(PubSub& pubsub) {
+  PW_CHECK(pubsub.SubscribeTo<AirMeasurement>([this](AirMeasurement event) {
+    Add(Series::kAirQuality, event.timestamp, event.score);
+    Add(Series::kTemperature, event.timestamp, event.temperature());
+    Add(Series::kHumidity, event.timestamp, event.humidity());
+    Add(Series::kPressure, event.timestamp, event.pressure);
+    Add(Series::kGasResistance, event.timestamp, event.gas_resistance);
+  }));
+  PW_CHECK(
+      pubsub.SubscribeTo<AmbientLightSample>([this](AmbientLightSample event) {
+        Add(Series::kAmbientLight, event.timestamp, event.sample_lux);
+      }));
+}
+
+void History::Add(Series series,
+                  pw::chrono::SystemClock::time_point time,
+                  float value) {
+  const int32_t quantized = Quantize(value, scale(series));
+  std::lock_guard lock(mutex_);
+  AddPoint(series_[static_cast<size_t>(series)],
+           0,
+           {
+               .time_s = ToSeconds(time),
+               .mean = quantized,
+               .min = quantized,
+               .max = quantized,
+           });
+}
+
+void History::AddPoint(SeriesHistory& series,
+                       size_t index,
+                       HistoryTier::Point point) {
+  Accumulator& accumulator = series.accumulators[index];
+  const uint32_t start_s = point.time_s - point.time_s % kTierPeriods[index];
+
+  // A period is only complete once a point from a later one arrives.
+  if (accumulator.active && accumulator.start_s != start_s) {
+    const HistoryTier::Point completed = accumulator.Take();
+    series.tiers[index].Append(completed);
+    if (index + 1 < kNumTiers) {
+      AddPoint(series, index + 1, completed);
+    }
+  }
+
+  if (!accumulator.active) {
+    accumulator.start_s = start_s;
+  }
+  accumulator.Add(point);
+}
+
+bool History::ReadBlock(Series series,
+                        Tier tier,
+                        uint32_t sequence,
+                        HistoryTier::Block& out) const {
+  std::lock_guard lock(mutex_);
+  return series_[static_cast<size_t>(series)]
+      .tiers[static_cast<size_t>(tier)]
+      .Read(sequence, out);
+}
+
+std::pair<uint32_t, uint32_t> History::BlockRange(Series series,
+                                                  Tier tier) const {
+  std::lock_guard lock(mutex_);
+  const HistoryTier& history_tier =
+      series_[static_cast<size_t>(series)].tiers[static_cast<size_t>(tier)];
+  return {history_tier.oldest(), history_tier.end()};
+}
+
+}  // namespace sense
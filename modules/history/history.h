@@ -0,0 +1,135 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "modules/history/history_tier.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+
+namespace sense {
+
+/// Fixed-memory store of recent sensor readings.
+///
+/// Each series is kept at three resolutions: per-second points for the last
+/// minute or so, per-minute points for the last couple of hours and per-hour
+/// points for the last few days. Readings are quantized with a per-series
+/// scale, averaged over each period and folded into the coarser tiers as each
+/// period ends.
+class History {
+ public:
+  enum class Series : uint8_t {
+    kAirQuality = 0,
+    kAmbientLight,
+    kTemperature,
+    kHumidity,
+    kPressure,
+    kGasResistance,
+  };
+  static constexpr size_t kNumSeries = 6;
+
+  enum class Tier : uint8_t {
+    kSecond = 0,
+    kMinute,
+    kHour,
+  };
+  static constexpr size_t kNumTiers = 3;
+
+  static constexpr std::array<uint32_t, kNumTiers> kTierPeriods = {
+      1, 60, 60 * 60};
+  static constexpr std::array<size_t, kNumTiers> kTierBlocks = {4, 8, 4};
+
+  /// Quantized units per unit of each series' reading.
+  static constexpr std::array<float, kNumSeries> kScales = {
+      1.f,    // Score
+      10.f,   // Lux
+      100.f,  // Degrees C
+      100.f,  // Percent relative humidity
+      10.f,   // Pressure
+      0.1f,   // Ohms
+  };
+
+  History();
+
+  History(const History&) = delete;
+  History& operator=(const History&) = delete;
+
+  /// Starts recording air measurement and ambient light events from
+  /// `pubsub`.
+  void Init(PubSub& pubsub);
+
+  /// Records a reading.
+  void Add(Series series, pw::chrono::SystemClock::time_point time, float value)
+      PW_LOCKS_EXCLUDED(mutex_);
+
+  /// Copies the block with the given sequence number, as for
+  /// `HistoryTier::Read`.
+  bool ReadBlock(Series series,
+                 Tier tier,
+                 uint32_t sequence,
+                 HistoryTier::Block& out) const PW_LOCKS_EXCLUDED(mutex_);
+
+  /// Returns the range of readable block sequence numbers, as
+  /// `[oldest, end)`.
+  std::pair<uint32_t, uint32_t> BlockRange(Series series, Tier tier) const
+      PW_LOCKS_EXCLUDED(mutex_);
+
+  static constexpr float scale(Series series) {
+    return kScales[static_cast<size_t>(series)];
+  }
+
+  static constexpr uint32_t period_s(Tier tier) {
+    return kTierPeriods[static_cast<size_t>(tier)];
+  }
+
+ private:
+  // Running aggregate of the points in the current period of one tier.
+  struct Accumulator {
+    bool active = false;
+    uint32_t start_s = 0;
+    uint32_t count = 0;
+    int64_t sum = 0;
+    int32_t min = 0;
+    int32_t max = 0;
+
+    void Add(const HistoryTier::Point& point);
+    HistoryTier::Point Take();
+  };
+
+  struct SeriesHistory {
+    SeriesHistory();
+
+    std::array<HistoryTier::Block, kTierBlocks[0]> second_blocks;
+    std::array<HistoryTier::Block, kTierBlocks[1]> minute_blocks;
+    std::array<HistoryTier::Block, kTierBlocks[2]> hour_blocks;
+    std::array<HistoryTier, kNumTiers> tiers;
+    std::array<Accumulator, kNumTiers> accumulators;
+  };
+
+  // Adds a point to tier `index`, flushing the tier's previous period into
+  // it and the next tier when the period changes.
+  void AddPoint(SeriesHistory& series, size_t index, HistoryTier::Point point)
+      PW_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable pw::sync::Mutex mutex_;
+  std::array<SeriesHistory, kNumSeries> series_ PW_GUARDED_BY(mutex_);
+};
+
+}  // namespace sense
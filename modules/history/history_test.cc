@@ -0,0 +1,84 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/history.h"
+
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using namespace std::literals::chrono_literals;
+
+using sense::History;
+using sense::HistoryTier;
+using Series = History::Series;
+using Tier = History::Tier;
+
+pw::chrono::SystemClock::time_point At(std::chrono::seconds time) {
+  return pw::chrono::SystemClock::time_point(
+      std::chrono::duration_cast<pw::chrono::SystemClock::duration>(time));
+}
+
+TEST(HistoryTest, CompletedSecondsAreStored) {
+  History history;
+  history.Add(Series::kTemperature, At(1s), 20.f);
+  history.Add(Series::kTemperature, At(1s), 22.f);
+
+  // The period is still open.
+  EXPECT_EQ(history.BlockRange(Series::kTemperature, Tier::kSecond).second,
+            0u);
+
+  history.Add(Series::kTemperature, At(2s), 25.f);
+  HistoryTier::Block block;
+  ASSERT_TRUE(history.ReadBlock(Series::kTemperature, Tier::kSecond, 0, block));
+  EXPECT_EQ(block.start_s, 1u);
+  EXPECT_EQ(block.count, 1u);
+  EXPECT_EQ(block.base[0], 2100);  // Mean, in hundredths of a degree.
+  EXPECT_EQ(block.base[1], 2000);
+  EXPECT_EQ(block.base[2], 2200);
+}
+
+TEST(HistoryTest, AggregatesIntoMinutes) {
+  History history;
+  for (int i = 0; i < 60; ++i) {
+    history.Add(Series::kAirQuality, At(std::chrono::seconds(i)), i);
+  }
+  history.Add(Series::kAirQuality, At(60s), 0);
+  history.Add(Series::kAirQuality, At(61s), 0);
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(history.ReadBlock(Series::kAirQuality, Tier::kMinute, 0, block));
+  EXPECT_EQ(block.start_s, 0u);
+  EXPECT_EQ(block.base[0], 29);
+  EXPECT_EQ(block.base[1], 0);
+  EXPECT_EQ(block.base[2], 59);
+
+  EXPECT_EQ(history.BlockRange(Series::kAirQuality, Tier::kHour).second, 0u);
+}
+
+TEST(HistoryTest, SeriesAreIndependent) {
+  History history;
+  history.Add(Series::kAmbientLight, At(1s), 12.34f);
+  history.Add(Series::kAmbientLight, At(2s), 0.f);
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(
+      history.ReadBlock(Series::kAmbientLight, Tier::kSecond, 0, block));
+  EXPECT_EQ(block.base[0], 123);  // Tenths of a lux.
+  EXPECT_FALSE(history.ReadBlock(Series::kHumidity, Tier::kSecond, 0, block));
+}
+
+}  // namespace
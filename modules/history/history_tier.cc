@@ -0,0 +1,100 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/history_tier.h"
+
+namespace sense {
+namespace {
+
+bool FitsDelta(int64_t delta) {
+  return delta > HistoryTier::kGap && delta <= INT16_MAX;
+}
+
+}  // namespace
+
+size_t HistoryTier::Block::Decode(uint32_t period_s,
+                                  pw::span<Point> out) const {
+  std::array<int32_t, kLanes> value = base;
+  size_t written = 0;
+  for (size_t i = 0; i < count && written < out.size(); ++i) {
+    if (i != 0) {
+      if (deltas[0][i] == kGap) {
+        continue;
+      }
+      for (size_t lane = 0; lane < kLanes; ++lane) {
+        value[lane] += deltas[lane][i];
+      }
+    }
+    out[written++] = {
+        .time_s = start_s + static_cast<uint32_t>(i) * period_s,
+        .mean = value[0],
+        .min = value[1],
+        .max = value[2],
+    };
+  }
+  return written;
+}
+
+void HistoryTier::Append(const Point& point) {
+  if (started_ == 0) {
+    StartBlock(point);
+    return;
+  }
+
+  Block& block = current();
+  const uint32_t next_s = block.end_s(period_s_);
+  const uint32_t gaps =
+      point.time_s > next_s ? (point.time_s - next_s) / period_s_ : 0;
+  const std::array<int32_t, kLanes> values = {point.mean, point.min, point.max};
+  bool fits = block.count + gaps < kBlockPoints && point.time_s >= next_s;
+  for (size_t lane = 0; fits && lane < kLanes; ++lane) {
+    fits = FitsDelta(int64_t{values[lane]} - last_[lane]);
+  }
+  if (!fits) {
+    StartBlock(point);
+    return;
+  }
+
+  for (uint32_t i = 0; i < gaps; ++i) {
+    block.deltas[0][block.count] = kGap;
+    block.deltas[1][block.count] = 0;
+    block.deltas[2][block.count] = 0;
+    ++block.count;
+  }
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    block.deltas[lane][block.count] =
+        static_cast<int16_t>(values[lane] - last_[lane]);
+  }
+  ++block.count;
+  last_ = values;
+}
+
+bool HistoryTier::Read(uint32_t sequence, Block& out) const {
+  if (sequence < oldest() || sequence >= started_) {
+    return false;
+  }
+  out = blocks_[sequence % blocks_.size()];
+  return true;
+}
+
+void HistoryTier::StartBlock(const Point& point) {
+  ++started_;
+  Block& block = current();
+  block.start_s = point.time_s;
+  block.count = 1;
+  block.base = {point.mean, point.min, point.max};
+  last_ = block.base;
+}
+
+}  // namespace sense
@@ -0,0 +1,118 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "pw_span/span.h"
+
+namespace sense {
+
+/// Time series of aggregated readings at a single resolution, stored in a
+/// fixed ring of delta-encoded blocks.
+///
+/// Each point holds the mean, minimum and maximum of the quantized readings
+/// in one period. A block stores its first point in full and each later point
+/// as 16-bit deltas from the previous one, so a point takes 6 bytes instead of
+/// 12. A block ends early when a delta does not fit or when a gap is too long
+/// to mark inside it. When every block is in use, the oldest is overwritten.
+class HistoryTier {
+ public:
+  static constexpr size_t kBlockPoints = 16;
+  static constexpr size_t kLanes = 3;
+
+  /// Delta that marks a period with no readings.
+  static constexpr int16_t kGap = std::numeric_limits<int16_t>::min();
+
+  struct Point {
+    /// Start of the period, in seconds since boot.
+    uint32_t time_s;
+    int32_t mean;
+    int32_t min;
+    int32_t max;
+  };
+
+  struct Block {
+    /// Time of the first point.
+    uint32_t start_s = 0;
+    /// Number of periods covered, including gaps.
+    uint16_t count = 0;
+    /// The first point's mean, minimum and maximum.
+    std::array<int32_t, kLanes> base = {};
+    /// Delta from the previous point for each lane. Element 0 is unused.
+    std::array<std::array<int16_t, kBlockPoints>, kLanes> deltas = {};
+
+    uint32_t end_s(uint32_t period_s) const {
+      return start_s + count * period_s;
+    }
+
+    /// Decodes the block's points, skipping gaps. Returns the number written.
+    size_t Decode(uint32_t period_s, pw::span<Point> out) const;
+  };
+
+  HistoryTier(pw::span<Block> blocks, uint32_t period_s)
+      : blocks_(blocks), period_s_(period_s) {}
+
+  HistoryTier(const HistoryTier&) = delete;
+  HistoryTier& operator=(const HistoryTier&) = delete;
+
+  /// Adds a point. Points must be added in time order, with `time_s` a
+  /// multiple of the period.
+  void Append(const Point& point);
+
+  /// Copies the block with the given sequence number into `out`. Sequence
+  /// numbers start at 0 and increase by one for each block started; blocks
+  /// that have been overwritten cannot be read.
+  ///
+  /// @returns false if the block has been overwritten or not started yet.
+  bool Read(uint32_t sequence, Block& out) const;
+
+  /// Sequence number of the oldest block that can still be read.
+  uint32_t oldest() const {
+    return started_ > blocks_.size()
+               ? static_cast<uint32_t>(started_ - blocks_.size())
+               : 0;
+  }
+
+  /// Sequence number following the newest block.
+  uint32_t end() const { return started_; }
+
+  uint32_t period_s() const { return period_s_; }
+
+ private:
+  void StartBlock(const Point& point);
+
+  Block& current() { return blocks_[(started_ - 1) % blocks_.size()]; }
+
+  pw::span<Block> blocks_;
+  const uint32_t period_s_;
+  uint32_t started_ = 0;
+  std::array<int32_t, kLanes> last_ = {};
+};
+
+/// `HistoryTier` with its own storage.
+template <size_t kBlocks>
+class HistoryTierBuffer : public HistoryTier {
+ public:
+  explicit HistoryTierBuffer(uint32_t period_s)
+      : HistoryTier(storage_, period_s) {}
+
+ private:
+  std::array<Block, kBlocks> storage_;
+};
+
+}  // namespace sense
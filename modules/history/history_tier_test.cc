@@ -0,0 +1,110 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/history_tier.h"
+
+#include <array>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using sense::HistoryTier;
+using sense::HistoryTierBuffer;
+
+HistoryTier::Point MakePoint(uint32_t time_s, int32_t value) {
+  return {.time_s = time_s, .mean = value, .min = value - 1, .max = value + 1};
+}
+
+TEST(HistoryTierTest, RoundTripsPoints) {
+  HistoryTierBuffer<2> tier(1);
+  tier.Append(MakePoint(10, 100));
+  tier.Append(MakePoint(11, 90));
+  tier.Append(MakePoint(12, 120));
+
+  EXPECT_EQ(tier.oldest(), 0u);
+  EXPECT_EQ(tier.end(), 1u);
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(tier.Read(0, block));
+  std::array<HistoryTier::Point, HistoryTier::kBlockPoints> points;
+  ASSERT_EQ(block.Decode(tier.period_s(), points), 3u);
+  for (size_t i = 0; i < 3; ++i) {
+    const HistoryTier::Point expected =
+        MakePoint(10 + i, std::array{100, 90, 120}[i]);
+    EXPECT_EQ(points[i].time_s, expected.time_s);
+    EXPECT_EQ(points[i].mean, expected.mean);
+    EXPECT_EQ(points[i].min, expected.min);
+    EXPECT_EQ(points[i].max, expected.max);
+  }
+}
+
+TEST(HistoryTierTest, MarksGaps) {
+  HistoryTierBuffer<2> tier(60);
+  tier.Append(MakePoint(0, 5));
+  tier.Append(MakePoint(180, 7));
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(tier.Read(0, block));
+  EXPECT_EQ(block.count, 4u);
+  EXPECT_EQ(block.end_s(60), 240u);
+
+  std::array<HistoryTier::Point, HistoryTier::kBlockPoints> points;
+  ASSERT_EQ(block.Decode(tier.period_s(), points), 2u);
+  EXPECT_EQ(points[1].time_s, 180u);
+  EXPECT_EQ(points[1].mean, 7);
+}
+
+TEST(HistoryTierTest, StartsBlockWhenDeltaOverflows) {
+  HistoryTierBuffer<2> tier(1);
+  tier.Append(MakePoint(0, 0));
+  tier.Append(MakePoint(1, 100000));
+  EXPECT_EQ(tier.end(), 2u);
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(tier.Read(1, block));
+  EXPECT_EQ(block.start_s, 1u);
+  EXPECT_EQ(block.base[0], 100000);
+}
+
+TEST(HistoryTierTest, StartsBlockWhenFull) {
+  HistoryTierBuffer<2> tier(1);
+  for (uint32_t i = 0; i <= HistoryTier::kBlockPoints; ++i) {
+    tier.Append(MakePoint(i, 1));
+  }
+  EXPECT_EQ(tier.end(), 2u);
+
+  HistoryTier::Block block;
+  ASSERT_TRUE(tier.Read(1, block));
+  EXPECT_EQ(block.start_s, HistoryTier::kBlockPoints);
+  EXPECT_EQ(block.count, 1u);
+}
+
+TEST(HistoryTierTest, OverwritesOldestBlock) {
+  HistoryTierBuffer<2> tier(1);
+  tier.Append(MakePoint(0, 0));
+  tier.Append(MakePoint(1, 100000));
+  tier.Append(MakePoint(2, 0));
+
+  EXPECT_EQ(tier.oldest(), 1u);
+  EXPECT_EQ(tier.end(), 3u);
+
+  HistoryTier::Block block;
+  EXPECT_FALSE(tier.Read(0, block));
+  EXPECT_FALSE(tier.Read(3, block));
+  ASSERT_TRUE(tier.Read(2, block));
+  EXPECT_EQ(block.start_s, 2u);
+}
+
+}  // namespace
@@ -0,0 +1,166 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/history/service.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+#include "modules/history/columnar_export.h"
+#include "pw_bytes/span.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_log/log.h"
+#include "pw_span/span.h"
+
+namespace sense {
+namespace {
+
+// Packs the deltas of every point after the first, lane by lane.
+void EncodeDeltas(const HistoryTier::Block& block,
+                  history_HistoryBlock& proto) {
+  proto.deltas.size = 0;
+  for (const auto& lane : block.deltas) {
+    for (size_t i = 1; i < block.count; ++i) {
+      const auto delta = static_cast<uint16_t>(lane[i]);
+      proto.deltas.bytes[proto.deltas.size++] = delta & 0xff;
+      proto.deltas.bytes[proto.deltas.size++] = delta >> 8;
+    }
+  }
+}
+
+bool IsValid(history_Series series, history_Tier tier) {
+  return series <= history_Series_GAS_RESISTANCE && tier <= history_Tier_HOUR;
+}
+
+// Resolves a requested end time, where zero means now.
+uint32_t EndSeconds(uint32_t end_s) {
+  if (end_s != 0) {
+    return end_s;
+  }
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::seconds>(
+          pw::chrono::SystemClock::now().time_since_epoch())
+          .count());
+}
+
+}  // namespace
+
+static_assert(sizeof(history_HistoryBlock{}.deltas.bytes) >=
+                  HistoryTier::kLanes * (HistoryTier::kBlockPoints - 1) *
+                      sizeof(int16_t),
+              "history.options must fit a full block of deltas");
+
+void HistoryService::GetHistory(const history_HistoryRequest& request,
+                                ServerWriter<history_HistoryBlock>& writer) {
+  if (history_ == nullptr || !IsValid(request.series, request.tier)) {
+    writer.Finish(pw::Status::InvalidArgument()).IgnoreError();
+    return;
+  }
+
+  const auto series = static_cast<History::Series>(request.series);
+  const auto tier = static_cast<History::Tier>(request.tier);
+  const uint32_t period_s = History::period_s(tier);
+  const uint32_t end_s = EndSeconds(request.end_s);
+
+  auto [sequence, end] = history_->BlockRange(series, tier);
+  HistoryTier::Block block;
+  history_HistoryBlock proto = history_HistoryBlock_init_default;
+  proto.series = request.series;
+  proto.period_s = period_s;
+  proto.scale = History::scale(series);
+
+  pw::Status status;
+  for (; sequence < end && status.ok(); ++sequence) {
+    // The block may have been overwritten since the range was read.
+    if (!history_->ReadBlock(series, tier, sequence, block)) {
+      continue;
+    }
+    if (block.end_s(period_s) <= request.start_s) {
+      continue;
+    }
+    if (block.start_s > end_s) {
+      break;
+    }
+    proto.start_s = block.start_s;
+    proto.count = block.count;
+    proto.base_mean = block.base[0];
+    proto.base_min = block.base[1];
+    proto.base_max = block.base[2];
+    EncodeDeltas(block, proto);
+    status = writer.Write(proto);
+  }
+
+  if (!status.ok()) {
+    PW_LOG_WARN("History stream on RPC channel %u ended early: %s",
+                writer.channel_id(),
+                status.str());
+  }
+  writer.Finish(status).IgnoreError();
+}
+
+pw::Status HistoryService::ExportHistory(const history_ExportRequest& request,
+                                         history_ExportChunk& response) {
+  if (history_ == nullptr || !IsValid(request.series, request.tier)) {
+    return pw::Status::InvalidArgument();
+  }
+
+  const auto series = static_cast<History::Series>(request.series);
+  const auto tier = static_cast<History::Tier>(request.tier);
+  const uint32_t period_s = History::period_s(tier);
+  const uint32_t end_s = EndSeconds(request.end_s);
+  response.series = request.series;
+  response.period_s = period_s;
+  response.scale = History::scale(series);
+  response.include_range = request.include_range;
+
+  ColumnarExport packer(pw::as_writable_bytes(pw::span(response.data.bytes)),
+                        period_s,
+                        request.include_range);
+  auto [sequence, end] = history_->BlockRange(series, tier);
+  HistoryTier::Block block;
+  std::array<HistoryTier::Point, HistoryTier::kBlockPoints> points;
+  bool full = false;
+  for (; sequence < end && !full; ++sequence) {
+    // The block may have been overwritten since the range was read.
+    if (!history_->ReadBlock(series, tier, sequence, block)) {
+      continue;
+    }
+    if (block.end_s(period_s) <= request.start_s) {
+      continue;
+    }
+    if (block.start_s > end_s) {
+      break;
+    }
+    const size_t count = block.Decode(period_s, points);
+    for (const HistoryTier::Point& point : pw::span(points).first(count)) {
+      if (point.time_s < request.start_s || point.time_s > end_s) {
+        continue;
+      }
+      if (!packer.Add(point)) {
+        response.has_next_start_s = true;
+        response.next_start_s = point.time_s;
+        full = true;
+        break;
+      }
+    }
+  }
+
+  response.start_s = packer.start_s();
+  response.count = packer.count();
+  response.data.size = packer.Finish().size();
+  return pw::OkStatus();
+}
+
+}  // namespace sense
@@ -0,0 +1,36 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/history/history.h"
+#include "modules/history/history.rpc.pb.h"
+
+namespace sense {
+
+class HistoryService final
+    : public ::history::pw_rpc::nanopb::History::Service<HistoryService> {
+ public:
+  void Init(History& history) { history_ = &history; }
+
+  void GetHistory(const history_HistoryRequest& request,
+                  ServerWriter<history_HistoryBlock>& writer);
+
+  pw::Status ExportHistory(const history_ExportRequest& request,
+                           history_ExportChunk& response);
+
+ private:
+  History* history_ = nullptr;
+};
+
+}  // namespace sense
@@ -0,0 +1,209 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/i2c/bus_arbiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+namespace {
+
+using ::pw::chrono::SystemClock;
+
+uint32_t ToMicroseconds(SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+void SetMax(pw::metric::TypedMetric<uint32_t>& metric, uint32_t value) {
+  if (value > metric.value()) {
+    metric.Set(value);
+  }
+}
+
+}  // namespace
+
+I2cBusArbiter::Client::Batch::Batch(Client& client) : client_(client) {
+  client_.users_.lock();
+  client_.arbiter_.Acquire(client_, SystemClock::time_point::max());
+}
+
+I2cBusArbiter::Client::Batch::~Batch() {
+  client_.arbiter_.Release(client_);
+  client_.users_.unlock();
+}
+
+pw::Status I2cBusArbiter::Client::Batch::DoWriteReadFor(
+    pw::i2c::Address device_address,
+    pw::ConstByteSpan tx_buffer,
+    pw::ByteSpan rx_buffer,
+    SystemClock::duration timeout) {
+  return client_.Transfer(device_address,
+                          tx_buffer,
+                          rx_buffer,
+                          SystemClock::now(),
+                          SystemClock::TimePointAfterAtLeast(timeout));
+}
+
+I2cBusArbiter::Client::Client(I2cBusArbiter& arbiter,
+                              Priority priority,
+                              pw::tokenizer::Token name)
+    : arbiter_(arbiter), priority_(priority), metrics_(name) {
+  arbiter_.Register(*this);
+}
+
+I2cBusArbiter::Client::~Client() { arbiter_.Unregister(*this); }
+
+pw::Status I2cBusArbiter::Client::DoWriteReadFor(
+    pw::i2c::Address device_address,
+    pw::ConstByteSpan tx_buffer,
+    pw::ByteSpan rx_buffer,
+    SystemClock::duration timeout) {
+  const SystemClock::time_point start = SystemClock::now();
+  const SystemClock::time_point deadline =
+      SystemClock::TimePointAfterAtLeast(timeout);
+  if (!users_.try_lock_until(deadline)) {
+    timeouts_.Increment();
+    return pw::Status::DeadlineExceeded();
+  }
+  std::lock_guard users(users_, std::adopt_lock);
+  if (!arbiter_.Acquire(*this, deadline)) {
+    timeouts_.Increment();
+    return pw::Status::DeadlineExceeded();
+  }
+
+  pw::Status status =
+      Transfer(device_address, tx_buffer, rx_buffer, start, deadline);
+  arbiter_.Release(*this);
+  return status;
+}
+
+pw::Status I2cBusArbiter::Client::Transfer(pw::i2c::Address device_address,
+                                           pw::ConstByteSpan tx_buffer,
+                                           pw::ByteSpan rx_buffer,
+                                           SystemClock::time_point start,
+                                           SystemClock::time_point deadline) {
+  const SystemClock::time_point granted = SystemClock::now();
+  pw::Status status = arbiter_.bus_.WriteReadFor(
+      device_address,
+      tx_buffer,
+      rx_buffer,
+      std::max(deadline - granted, SystemClock::duration(0)));
+  const SystemClock::time_point done = SystemClock::now();
+
+  transactions_.Increment();
+  if (!status.ok()) {
+    errors_.Increment();
+  }
+  SetMax(max_wait_us_, ToMicroseconds(granted - start));
+  last_latency_us_.Set(ToMicroseconds(done - start));
+  SetMax(max_latency_us_, last_latency_us_.value());
+  return status;
+}
+
+I2cBusArbiter::I2cBusArbiter(pw::i2c::Initiator& bus)
+    : bus_(bus), window_start_(SystemClock::now()) {}
+
+bool I2cBusArbiter::Acquire(Client& client,
+                            SystemClock::time_point deadline) {
+  {
+    std::lock_guard lock(lock_);
+    PW_CHECK(owner_ != &client, "I2C client acquired the bus twice");
+    if (owner_ == nullptr) {
+      Grant(client);
+      return true;
+    }
+    client.waiting_ = true;
+    client.ticket_ = next_ticket_++;
+    client.contended_.Increment();
+  }
+
+  if (deadline == SystemClock::time_point::max()) {
+    client.granted_.acquire();
+    return true;
+  }
+  if (client.granted_.try_acquire_until(deadline)) {
+    return true;
+  }
+
+  std::lock_guard lock(lock_);
+  if (client.waiting_) {
+    client.waiting_ = false;
+    return false;
+  }
+  // The bus was granted just as the wait timed out.
+  client.granted_.acquire();
+  return true;
+}
+
+void I2cBusArbiter::Release(Client& client) {
+  std::lock_guard lock(lock_);
+  PW_CHECK(owner_ == &client, "I2C client released a bus it does not hold");
+  const SystemClock::time_point now = SystemClock::now();
+  const SystemClock::duration held = now - granted_at_;
+  window_busy_ += held;
+  total_busy_ += held;
+  busy_ms_.Set(static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(total_busy_)
+          .count()));
+  if (const SystemClock::duration elapsed = now - window_start_;
+      elapsed >= kUtilizationWindow) {
+    utilization_percent_.Set(
+        static_cast<uint32_t>(window_busy_ * 100 / elapsed));
+    window_busy_ = {};
+    window_start_ = now;
+  }
+  owner_ = nullptr;
+
+  Client* next = nullptr;
+  for (Client& waiter : clients_) {
+    if (!waiter.waiting_) {
+      continue;
+    }
+    if (next == nullptr || waiter.priority_ > next->priority_ ||
+        (waiter.priority_ == next->priority_ &&
+         static_cast<int32_t>(waiter.ticket_ - next->ticket_) < 0)) {
+      next = &waiter;
+    }
+  }
+  if (next != nullptr) {
+    next->waiting_ = false;
+    Grant(*next);
+    next->granted_.release();
+  }
+}
+
+void I2cBusArbiter::Register(Client& client) {
+  std::lock_guard lock(lock_);
+  clients_.push_back(client);
+}
+
+void I2cBusArbiter::Unregister(Client& client) {
+  std::lock_guard lock(lock_);
+  PW_CHECK(owner_ != &client && !client.waiting_,
+           "I2C client destroyed while using the bus");
+  clients_.remove(client);
+}
+
+void I2cBusArbiter::Grant(Client& client) {
+  owner_ = &client;
+  granted_at_ = SystemClock::now();
+  grants_.Increment();
+}
+
+}  // namespace sense
@@ -0,0 +1,176 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "pw_bytes/span.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_containers/intrusive_list.h"
+#include "pw_i2c/address.h"
+#include "pw_i2c/initiator.h"
+#include "pw_metric/metric.h"
+#include "pw_status/status.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+#include "pw_sync/timed_mutex.h"
+#include "pw_sync/timed_thread_notification.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Owns a shared I2C bus and grants it to one device at a time.
+///
+/// Each device driver is given its own `Client`, which implements
+/// `pw::i2c::Initiator` and so can be passed to any driver unchanged. When
+/// the bus is busy, clients wait and are granted the bus in priority order,
+/// oldest request first among equal priorities.
+///
+/// A client may be shared by several threads, such as a driver's sampling
+/// task and the worker that services its interrupt. Their transactions are
+/// serialized by the client, so each still waits its turn for the bus.
+///
+/// Drivers that issue several dependent transactions, such as a register
+/// pointer write followed by a burst of reads, can hold the bus across them
+/// with a `Client::Batch` so that other devices cannot interleave.
+class I2cBusArbiter {
+ public:
+  enum class Priority : uint8_t {
+    kLow,
+    kNormal,
+    kHigh,
+  };
+
+  class Client : public pw::i2c::Initiator,
+                 public pw::IntrusiveList<Client>::Item {
+   public:
+    /// Holds the bus and the client for the lifetime of the object.
+    ///
+    /// Issue the batched transactions through the batch itself. Other
+    /// threads using the client wait until the batch closes, so the thread
+    /// that opened it must not use the client directly in the meantime.
+    class Batch : public pw::i2c::Initiator {
+     public:
+      explicit Batch(Client& client);
+      ~Batch() override;
+
+      Batch(const Batch&) = delete;
+      Batch& operator=(const Batch&) = delete;
+
+     private:
+      pw::Status DoWriteReadFor(
+          pw::i2c::Address device_address,
+          pw::ConstByteSpan tx_buffer,
+          pw::ByteSpan rx_buffer,
+          pw::chrono::SystemClock::duration timeout) override;
+
+      Client& client_;
+    };
+
+    /// Registers a device on the bus. `name` should be a `PW_METRIC_TOKEN`.
+    Client(I2cBusArbiter& arbiter,
+           Priority priority,
+           pw::tokenizer::Token name);
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    Priority priority() const { return priority_; }
+
+    pw::metric::Group& metrics() { return metrics_; }
+
+   private:
+    friend class I2cBusArbiter;
+
+    pw::Status DoWriteReadFor(
+        pw::i2c::Address device_address,
+        pw::ConstByteSpan tx_buffer,
+        pw::ByteSpan rx_buffer,
+        pw::chrono::SystemClock::duration timeout) override;
+
+    /// Runs one transaction on a bus this client holds and records it.
+    pw::Status Transfer(pw::i2c::Address device_address,
+                        pw::ConstByteSpan tx_buffer,
+                        pw::ByteSpan rx_buffer,
+                        pw::chrono::SystemClock::time_point start,
+                        pw::chrono::SystemClock::time_point deadline);
+
+    I2cBusArbiter& arbiter_;
+    const Priority priority_;
+
+    // Held for each transaction and for the lifetime of a batch, so that at
+    // most one thread at a time asks the arbiter for the bus on this client.
+    pw::sync::TimedMutex users_;
+
+    // Written by the arbiter under its lock.
+    bool waiting_ = false;
+    uint32_t ticket_ = 0;
+    pw::sync::TimedThreadNotification granted_;
+
+    pw::metric::Group metrics_;
+    PW_METRIC(metrics_, transactions_, "transactions", 0u);
+    PW_METRIC(metrics_, errors_, "errors", 0u);
+    PW_METRIC(metrics_, timeouts_, "timeouts", 0u);
+    PW_METRIC(metrics_, contended_, "contended", 0u);
+    PW_METRIC(metrics_, max_wait_us_, "max wait us", 0u);
+    PW_METRIC(metrics_, last_latency_us_, "last latency us", 0u);
+    PW_METRIC(metrics_, max_latency_us_, "max latency us", 0u);
+  };
+
+  explicit I2cBusArbiter(pw::i2c::Initiator& bus);
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+  /// Percent of time the bus was held during the last complete window.
+  uint32_t utilization_percent() const { return utilization_percent_.value(); }
+
+  /// Milliseconds the bus has been held since it was created. Wraps after
+  /// about 49 days.
+  uint32_t busy_ms() const { return busy_ms_.value(); }
+
+ private:
+  /// How often utilization is recomputed.
+  static constexpr auto kUtilizationWindow = std::chrono::seconds(1);
+
+  /// Waits for the bus until `deadline`. Returns false on timeout.
+  bool Acquire(Client& client, pw::chrono::SystemClock::time_point deadline)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Hands the bus to the highest priority waiter, if any.
+  void Release(Client& client) PW_LOCKS_EXCLUDED(lock_);
+
+  void Register(Client& client) PW_LOCKS_EXCLUDED(lock_);
+  void Unregister(Client& client) PW_LOCKS_EXCLUDED(lock_);
+
+  void Grant(Client& client) PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  pw::i2c::Initiator& bus_;
+
+  pw::sync::Mutex lock_;
+  pw::IntrusiveList<Client> clients_ PW_GUARDED_BY(lock_);
+  Client* owner_ PW_GUARDED_BY(lock_) = nullptr;
+  uint32_t next_ticket_ PW_GUARDED_BY(lock_) = 0;
+  pw::chrono::SystemClock::time_point granted_at_ PW_GUARDED_BY(lock_);
+  pw::chrono::SystemClock::time_point window_start_ PW_GUARDED_BY(lock_);
+  pw::chrono::SystemClock::duration window_busy_ PW_GUARDED_BY(lock_){};
+  pw::chrono::SystemClock::duration total_busy_ PW_GUARDED_BY(lock_){};
+
+  PW_METRIC_GROUP(metrics_, "i2c");
+  PW_METRIC(metrics_, grants_, "grants", 0u);
+  PW_METRIC(metrics_, busy_ms_, "busy ms", 0u);
+  PW_METRIC(metrics_, utilization_percent_, "utilization percent", 0u);
+};
+
+}  // namespace sense
@@ -0,0 +1,226 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/i2c/bus_arbiter.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+
+#include "pw_bytes/array.h"
+#include "pw_i2c/initiator.h"
+#include "pw_i2c/initiator_mock.h"
+#include "pw_sync/mutex.h"
+#include "pw_thread/sleep.h"
+#include "pw_thread/test_thread_context.h"
+#include "pw_thread/thread.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using ::pw::i2c::Address;
+using ::pw::i2c::MockInitiator;
+using ::pw::i2c::ReadTransaction;
+using ::pw::i2c::WriteTransaction;
+
+constexpr Address kLight = Address::SevenBit<0x23>();
+constexpr Address kAir = Address::SevenBit<0x76>();
+constexpr auto kTimeout = std::chrono::milliseconds(100);
+
+/// Gives threads time to start waiting on the bus.
+constexpr auto kSettle = std::chrono::milliseconds(20);
+
+/// Bus that records the order of transactions and whether any overlapped.
+class RecordingBus : public pw::i2c::Initiator {
+ public:
+  static constexpr size_t kCapacity = 64;
+
+  size_t size() {
+    std::lock_guard lock(lock_);
+    return size_;
+  }
+
+  Address at(size_t index) {
+    std::lock_guard lock(lock_);
+    return addresses_[index];
+  }
+
+  bool overlapped() const { return overlapped_; }
+
+ private:
+  pw::Status DoWriteReadFor(Address device_address,
+                            pw::ConstByteSpan,
+                            pw::ByteSpan,
+                            pw::chrono::SystemClock::duration) override {
+    if (in_flight_.fetch_add(1) != 0) {
+      overlapped_ = true;
+    }
+    pw::this_thread::sleep_for(std::chrono::milliseconds(1));
+    {
+      std::lock_guard lock(lock_);
+      if (size_ < kCapacity) {
+        addresses_[size_++] = device_address;
+      }
+    }
+    in_flight_.fetch_sub(1);
+    return pw::OkStatus();
+  }
+
+  std::atomic<int> in_flight_ = 0;
+  std::atomic<bool> overlapped_ = false;
+  pw::sync::Mutex lock_;
+  std::array<Address, kCapacity> addresses_{};
+  size_t size_ = 0;
+};
+
+TEST(I2cBusArbiterTest, ForwardsTransactionsFromEachClient) {
+  constexpr auto kWrite = pw::bytes::Array<0x80, 0x01>();
+  constexpr auto kRead = pw::bytes::Array<0x12, 0x34>();
+  std::array expected{
+      WriteTransaction(pw::OkStatus(), kLight, kWrite),
+      ReadTransaction(pw::OkStatus(), kAir, kRead),
+  };
+  MockInitiator bus(expected);
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client light(
+      arbiter, I2cBusArbiter::Priority::kHigh, PW_METRIC_TOKEN("light"));
+  I2cBusArbiter::Client air(
+      arbiter, I2cBusArbiter::Priority::kLow, PW_METRIC_TOKEN("air"));
+
+  EXPECT_EQ(light.WriteFor(kLight, kWrite, kTimeout), pw::OkStatus());
+  std::array<std::byte, 2> rx{};
+  EXPECT_EQ(air.ReadFor(kAir, rx, kTimeout), pw::OkStatus());
+  EXPECT_EQ(rx, kRead);
+  EXPECT_EQ(bus.Finalize(), pw::OkStatus());
+}
+
+TEST(I2cBusArbiterTest, CountsErrors) {
+  constexpr auto kWrite = pw::bytes::Array<0x80>();
+  std::array expected{
+      WriteTransaction(pw::Status::Unavailable(), kLight, kWrite),
+  };
+  MockInitiator bus(expected);
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client light(
+      arbiter, I2cBusArbiter::Priority::kNormal, PW_METRIC_TOKEN("light"));
+
+  EXPECT_EQ(light.WriteFor(kLight, kWrite, kTimeout),
+            pw::Status::Unavailable());
+  EXPECT_EQ(bus.Finalize(), pw::OkStatus());
+}
+
+TEST(I2cBusArbiterTest, BatchHoldsBusAcrossTransactions) {
+  constexpr auto kFirst = pw::bytes::Array<0x8D>();
+  constexpr auto kSecond = pw::bytes::Array<0x8E>();
+  std::array expected{
+      WriteTransaction(pw::OkStatus(), kLight, kFirst),
+      WriteTransaction(pw::OkStatus(), kLight, kSecond),
+  };
+  MockInitiator bus(expected);
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client light(
+      arbiter, I2cBusArbiter::Priority::kNormal, PW_METRIC_TOKEN("light"));
+
+  {
+    I2cBusArbiter::Client::Batch batch(light);
+    EXPECT_EQ(batch.WriteFor(kLight, kFirst, kTimeout), pw::OkStatus());
+    EXPECT_EQ(batch.WriteFor(kLight, kSecond, kTimeout), pw::OkStatus());
+  }
+  EXPECT_EQ(bus.Finalize(), pw::OkStatus());
+}
+
+TEST(I2cBusArbiterTest, SharedClientSerializesThreads) {
+  constexpr auto kWrite = pw::bytes::Array<0x8F>();
+  constexpr size_t kWritesPerThread = 20;
+  RecordingBus bus;
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client light(
+      arbiter, I2cBusArbiter::Priority::kNormal, PW_METRIC_TOKEN("light"));
+
+  auto write = [&light, &kWrite]() {
+    for (size_t i = 0; i < kWritesPerThread; ++i) {
+      EXPECT_EQ(light.WriteFor(kLight, kWrite, kTimeout), pw::OkStatus());
+    }
+  };
+  pw::thread::test::TestThreadContext context;
+  pw::thread::Thread other(context.options(), write);
+  write();
+  other.join();
+
+  EXPECT_EQ(bus.size(), 2 * kWritesPerThread);
+  EXPECT_FALSE(bus.overlapped());
+}
+
+TEST(I2cBusArbiterTest, GrantsHigherPriorityWaiterFirst) {
+  constexpr auto kWrite = pw::bytes::Array<0x80>();
+  constexpr Address kButtons = Address::SevenBit<0x3C>();
+  RecordingBus bus;
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client holder(
+      arbiter, I2cBusArbiter::Priority::kNormal, PW_METRIC_TOKEN("holder"));
+  I2cBusArbiter::Client low(
+      arbiter, I2cBusArbiter::Priority::kLow, PW_METRIC_TOKEN("low"));
+  I2cBusArbiter::Client high(
+      arbiter, I2cBusArbiter::Priority::kHigh, PW_METRIC_TOKEN("high"));
+
+  pw::thread::test::TestThreadContext low_context;
+  pw::thread::test::TestThreadContext high_context;
+  std::optional<I2cBusArbiter::Client::Batch> batch(std::in_place, holder);
+  pw::thread::Thread low_thread(low_context.options(), [&] {
+    EXPECT_EQ(low.WriteFor(kAir, kWrite, kTimeout * 10), pw::OkStatus());
+  });
+  pw::this_thread::sleep_for(kSettle);
+  pw::thread::Thread high_thread(high_context.options(), [&] {
+    EXPECT_EQ(high.WriteFor(kButtons, kWrite, kTimeout * 10), pw::OkStatus());
+  });
+  pw::this_thread::sleep_for(kSettle);
+  EXPECT_EQ(batch->WriteFor(kLight, kWrite, kTimeout), pw::OkStatus());
+  batch.reset();
+  low_thread.join();
+  high_thread.join();
+
+  ASSERT_EQ(bus.size(), 3u);
+  EXPECT_EQ(bus.at(0), kLight);
+  EXPECT_EQ(bus.at(1), kButtons);
+  EXPECT_EQ(bus.at(2), kAir);
+}
+
+TEST(I2cBusArbiterTest, TimesOutWhileBusIsHeld) {
+  constexpr auto kWrite = pw::bytes::Array<0x80>();
+  RecordingBus bus;
+  I2cBusArbiter arbiter(bus);
+  I2cBusArbiter::Client light(
+      arbiter, I2cBusArbiter::Priority::kNormal, PW_METRIC_TOKEN("light"));
+  I2cBusArbiter::Client air(
+      arbiter, I2cBusArbiter::Priority::kHigh, PW_METRIC_TOKEN("air"));
+
+  I2cBusArbiter::Client::Batch batch(light);
+  EXPECT_EQ(air.WriteFor(kAir, kWrite, std::chrono::milliseconds(10)),
+            pw::Status::DeadlineExceeded());
+
+  // Another thread sharing the batched client times out on the client.
+  pw::thread::test::TestThreadContext context;
+  pw::thread::Thread other(context.options(), [&] {
+    EXPECT_EQ(light.WriteFor(kLight, kWrite, std::chrono::milliseconds(10)),
+              pw::Status::DeadlineExceeded());
+  });
+  other.join();
+  EXPECT_EQ(bus.size(), 0u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,120 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/i2c/register_fake.h"
+
+#include "pw_assert/check.h"
+
+namespace sense {
+
+pw::Status I2cRegisterFake::AddDevice(pw::i2c::Address address,
+                                      WriteMode mode) {
+  if (Find(address) != nullptr) {
+    return pw::Status::AlreadyExists();
+  }
+  if (num_devices_ == kMaxDevices) {
+    return pw::Status::ResourceExhausted();
+  }
+  devices_[num_devices_++] = {
+      .address = static_cast<uint8_t>(address.GetSevenBit()),
+      .mode = mode,
+      .registers = {},
+  };
+  return pw::OkStatus();
+}
+
+void I2cRegisterFake::SetRegisters(pw::i2c::Address address,
+                                   uint8_t first_register,
+                                   pw::span<const uint8_t> values) {
+  Device* device = Find(address);
+  PW_CHECK_NOTNULL(device);
+  uint8_t reg = first_register;
+  for (uint8_t value : values) {
+    device->registers[reg++] = value;
+  }
+}
+
+uint8_t I2cRegisterFake::GetRegister(pw::i2c::Address address,
+                                     uint8_t reg) const {
+  const Device* device = Find(address);
+  PW_CHECK_NOTNULL(device);
+  return device->registers[reg];
+}
+
+I2cRegisterFake::Traffic I2cRegisterFake::TakeTraffic() {
+  const Traffic traffic = traffic_;
+  traffic_ = {};
+  return traffic;
+}
+
+pw::Status I2cRegisterFake::DoWriteReadFor(
+    pw::i2c::Address device_address,
+    pw::ConstByteSpan tx_buffer,
+    pw::ByteSpan rx_buffer,
+    pw::chrono::SystemClock::duration) {
+  Count(tx_buffer.size(), rx_buffer.size());
+
+  Device* device = Find(device_address);
+  if (device == nullptr || tx_buffer.empty()) {
+    return pw::Status::Unavailable();
+  }
+
+  auto reg = static_cast<uint8_t>(tx_buffer[0]);
+  for (size_t i = 1; i < tx_buffer.size(); ++i) {
+    const auto value = static_cast<uint8_t>(tx_buffer[i]);
+    if (device->mode == WriteMode::kAddressDataPairs && i % 2 == 0) {
+      reg = value;
+    } else {
+      device->registers[reg++] = value;
+    }
+  }
+  for (std::byte& value : rx_buffer) {
+    value = static_cast<std::byte>(device->registers[reg++]);
+  }
+  return pw::OkStatus();
+}
+
+I2cRegisterFake::Device* I2cRegisterFake::Find(pw::i2c::Address address) {
+  for (size_t i = 0; i < num_devices_; ++i) {
+    if (devices_[i].address == address.GetSevenBit()) {
+      return &devices_[i];
+    }
+  }
+  return nullptr;
+}
+
+const I2cRegisterFake::Device* I2cRegisterFake::Find(
+    pw::i2c::Address address) const {
+  return const_cast<I2cRegisterFake*>(this)->Find(address);
+}
+
+void I2cRegisterFake::Count(size_t tx_bytes, size_t rx_bytes) {
+  // Each byte takes 9 clocks with its acknowledgement. Every segment starts
+  // with the device address, and a write followed by a read has a repeated
+  // start. Start and stop conditions take about a clock each.
+  size_t clocks = 2;
+  if (tx_bytes != 0) {
+    clocks += 9 * (1 + tx_bytes);
+  }
+  if (rx_bytes != 0) {
+    clocks += 9 * (1 + rx_bytes) + (tx_bytes != 0 ? 1 : 0);
+  }
+
+  ++traffic_.transactions;
+  traffic_.bytes += static_cast<uint32_t>(tx_bytes + rx_bytes);
+  traffic_.bus_time += std::chrono::nanoseconds(
+      static_cast<int64_t>(clocks) * 1'000'000'000 / clock_hz_);
+}
+
+}  // namespace sense
@@ -0,0 +1,117 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_bytes/span.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_i2c/address.h"
+#include "pw_i2c/initiator.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Fake I2C bus of register-based devices that counts the traffic drivers
+/// generate, so that tests can hold driver operations to a budget.
+///
+/// Each device is a file of 256 one-byte registers. A transaction starts with
+/// the register address; the bytes written after it set registers and the
+/// bytes read return them, both starting from that address. Transactions to
+/// other addresses fail with `UNAVAILABLE`, as if NACKed.
+///
+/// This class is not thread safe. Tests must not read the traffic while a
+/// driver may be using the bus.
+class I2cRegisterFake : public pw::i2c::Initiator {
+ public:
+  static constexpr size_t kMaxDevices = 4;
+  static constexpr uint32_t kDefaultClockHz = 400'000;
+
+  /// How a device interprets bytes written after the register address.
+  enum class WriteMode {
+    /// Each byte sets the next register.
+    kAutoIncrement,
+
+    /// The bytes alternate between data and the next register address, as
+    /// in Bosch sensors' burst writes.
+    kAddressDataPairs,
+  };
+
+  /// Bus usage accumulated since the last `TakeTraffic`.
+  struct Traffic {
+    uint32_t transactions = 0;
+
+    /// Bytes written and read, not counting device addresses.
+    uint32_t bytes = 0;
+
+    /// Time the bus would be busy at the configured clock, including device
+    /// addresses, acknowledgements, and start and stop conditions.
+    std::chrono::nanoseconds bus_time{};
+  };
+
+  explicit I2cRegisterFake(uint32_t clock_hz = kDefaultClockHz)
+      : clock_hz_(clock_hz) {}
+
+  /// Adds a device with all registers cleared.
+  ///
+  /// @returns
+  /// * @OK - The device was added.
+  /// * @ALREADY_EXISTS - A device already has the address.
+  /// * @RESOURCE_EXHAUSTED - `kMaxDevices` devices have been added.
+  pw::Status AddDevice(pw::i2c::Address address,
+                       WriteMode mode = WriteMode::kAutoIncrement);
+
+  /// Sets registers of a device that has been added, without counting any
+  /// traffic. Used to model values the device produces itself.
+  void SetRegisters(pw::i2c::Address address,
+                    uint8_t first_register,
+                    pw::span<const uint8_t> values);
+
+  void SetRegister(pw::i2c::Address address, uint8_t reg, uint8_t value) {
+    SetRegisters(address, reg, pw::span(&value, 1));
+  }
+
+  uint8_t GetRegister(pw::i2c::Address address, uint8_t reg) const;
+
+  /// Returns the traffic since the last call, and starts counting again.
+  Traffic TakeTraffic();
+
+ private:
+  struct Device {
+    uint8_t address;
+    WriteMode mode;
+    std::array<uint8_t, 256> registers;
+  };
+
+  pw::Status DoWriteReadFor(pw::i2c::Address device_address,
+                            pw::ConstByteSpan tx_buffer,
+                            pw::ByteSpan rx_buffer,
+                            pw::chrono::SystemClock::duration) override;
+
+  Device* Find(pw::i2c::Address address);
+  const Device* Find(pw::i2c::Address address) const;
+
+  void Count(size_t tx_bytes, size_t rx_bytes);
+
+  const uint32_t clock_hz_;
+  std::array<Device, kMaxDevices> devices_;
+  size_t num_devices_ = 0;
+  Traffic traffic_;
+};
+
+}  // namespace sense
@@ -0,0 +1,87 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/i2c/register_fake.h"
+
+#include <array>
+#include <chrono>
+
+#include "pw_bytes/array.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using ::pw::i2c::Address;
+
+constexpr Address kDevice = Address::SevenBit<0x23>();
+constexpr Address kOther = Address::SevenBit<0x76>();
+constexpr auto kTimeout = std::chrono::milliseconds(100);
+
+TEST(I2cRegisterFakeTest, ReadsAndWritesAutoIncrementingRegisters) {
+  I2cRegisterFake bus;
+  ASSERT_EQ(bus.AddDevice(kDevice), pw::OkStatus());
+  constexpr auto kWrite = pw::bytes::Array<0x80, 0x01, 0x02>();
+  EXPECT_EQ(bus.WriteFor(kDevice, kWrite, kTimeout), pw::OkStatus());
+  EXPECT_EQ(bus.GetRegister(kDevice, 0x80), 0x01);
+  EXPECT_EQ(bus.GetRegister(kDevice, 0x81), 0x02);
+
+  constexpr auto kRegister = pw::bytes::Array<0x81>();
+  std::array<std::byte, 1> rx{};
+  EXPECT_EQ(bus.WriteReadFor(kDevice, kRegister, rx, kTimeout),
+            pw::OkStatus());
+  EXPECT_EQ(rx[0], std::byte{0x02});
+}
+
+TEST(I2cRegisterFakeTest, WritesAddressDataPairs) {
+  I2cRegisterFake bus;
+  ASSERT_EQ(
+      bus.AddDevice(kDevice, I2cRegisterFake::WriteMode::kAddressDataPairs),
+      pw::OkStatus());
+  constexpr auto kWrite = pw::bytes::Array<0x72, 0x05, 0x74, 0x01>();
+  EXPECT_EQ(bus.WriteFor(kDevice, kWrite, kTimeout), pw::OkStatus());
+  EXPECT_EQ(bus.GetRegister(kDevice, 0x72), 0x05);
+  EXPECT_EQ(bus.GetRegister(kDevice, 0x73), 0x00);
+  EXPECT_EQ(bus.GetRegister(kDevice, 0x74), 0x01);
+}
+
+TEST(I2cRegisterFakeTest, CountsTraffic) {
+  I2cRegisterFake bus(100'000);
+  ASSERT_EQ(bus.AddDevice(kDevice), pw::OkStatus());
+  constexpr auto kRegister = pw::bytes::Array<0x88>();
+  std::array<std::byte, 7> rx{};
+  EXPECT_EQ(bus.WriteReadFor(kDevice, kRegister, rx, kTimeout),
+            pw::OkStatus());
+  EXPECT_EQ(bus.WriteFor(kDevice, kRegister, kTimeout), pw::OkStatus());
+
+  const I2cRegisterFake::Traffic traffic = bus.TakeTraffic();
+  EXPECT_EQ(traffic.transactions, 2u);
+  EXPECT_EQ(traffic.bytes, 9u);
+  // (2 + 18 + 72 + 1) + (2 + 18) clocks at 10 us each.
+  EXPECT_EQ(traffic.bus_time, std::chrono::microseconds(1130));
+  EXPECT_EQ(bus.TakeTraffic().transactions, 0u);
+}
+
+TEST(I2cRegisterFakeTest, UnknownDeviceIsUnavailable) {
+  I2cRegisterFake bus;
+  ASSERT_EQ(bus.AddDevice(kDevice), pw::OkStatus());
+  EXPECT_EQ(bus.AddDevice(kDevice), pw::Status::AlreadyExists());
+  constexpr auto kWrite = pw::bytes::Array<0x80, 0x01>();
+  EXPECT_EQ(bus.WriteFor(kOther, kWrite, kTimeout),
+            pw::Status::Unavailable());
+  EXPECT_EQ(bus.TakeTraffic().transactions, 1u);
+}
+
+}  // namespace
+}  // namespace sense
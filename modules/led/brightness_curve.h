@@ -0,0 +1,158 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace sense {
+namespace internal {
+
+// Returns x^(1/n) for x > 0, using Newton's method.
+constexpr double NthRoot(double x, size_t n) {
+  double y = x < 1.0 ? 1.0 : x;
+  for (int i = 0; i < 128; ++i) {
+    double power = 1.0;
+    for (size_t j = 1; j < n; ++j) {
+      power *= y;
+    }
+    y -= (power * y - x) / (static_cast<double>(n) * power);
+  }
+  return y;
+}
+
+// CIE 1976 lightness L* from relative luminance Y, and back.
+constexpr double Lightness(double luminance) {
+  return luminance > 216.0 / 24389.0 ? 116.0 * NthRoot(luminance, 3) - 16.0
+                                     : luminance * (24389.0 / 27.0);
+}
+
+constexpr double Luminance(double lightness) {
+  const double f = (lightness + 16.0) / 116.0;
+  return lightness > 8.0 ? f * f * f : lightness * (27.0 / 24389.0);
+}
+
+}  // namespace internal
+
+/// Maps ambient light to LED brightness in `kLevels` steps.
+///
+/// Levels are spaced evenly in log lux, and their brightnesses evenly in
+/// perceived lightness, so each step looks the same size. Moving to another
+/// level takes a change in light larger than the deadband, so a steady room
+/// never flickers between levels. The table is built at compile time, and
+/// an update is a few float comparisons.
+template <size_t kLevels>
+class BrightnessCurve {
+ public:
+  static_assert(kLevels >= 2);
+
+  /// Lux at or below `min_lux` gets `min_brightness`, and lux at or above
+  /// `max_lux` gets `max_brightness`. A level changes once the light is
+  /// `deadband` (as a fraction) past the boundary with the next.
+  constexpr BrightnessCurve(float min_lux,
+                            float max_lux,
+                            uint8_t min_brightness,
+                            uint8_t max_brightness,
+                            float deadband = 0.15f) {
+    const double ratio = internal::NthRoot(
+        static_cast<double>(max_lux) / static_cast<double>(min_lux),
+        kLevels - 1);
+    const double boundary_ratio = internal::NthRoot(ratio, 2);
+    const double min_lightness = internal::Lightness(min_brightness / 255.0);
+    const double max_lightness = internal::Lightness(max_brightness / 255.0);
+
+    double lux = min_lux;
+    for (size_t i = 0; i < kLevels; ++i) {
+      const double lightness =
+          min_lightness + (max_lightness - min_lightness) *
+                              static_cast<double>(i) /
+                              static_cast<double>(kLevels - 1);
+      brightness_[i] = static_cast<uint8_t>(
+          internal::Luminance(lightness) * 255.0 + 0.5);
+      if (i + 1 < kLevels) {
+        // Boundaries sit halfway between levels in log lux.
+        const double boundary = lux * boundary_ratio;
+        rise_lux_[i] = static_cast<float>(boundary * (1.0 + deadband));
+        boundary_lux_[i] = static_cast<float>(boundary);
+        fall_lux_[i] = static_cast<float>(boundary * (1.0 - deadband));
+      }
+      lux *= ratio;
+    }
+  }
+
+  static constexpr size_t levels() { return kLevels; }
+
+  /// Brightness of a level.
+  constexpr uint8_t brightness(size_t level) const {
+    return brightness_[level];
+  }
+
+  /// Returns the level for `lux`, ignoring the deadband.
+  constexpr size_t Level(float lux) const {
+    size_t level = 0;
+    while (level + 1 < kLevels && lux >= boundary_lux_[level]) {
+      ++level;
+    }
+    return level;
+  }
+
+  /// Returns the level for `lux` when currently at `level`, which only
+  /// changes once `lux` is past the deadband.
+  constexpr size_t Level(float lux, size_t level) const {
+    while (level + 1 < kLevels && lux >= rise_lux_[level]) {
+      ++level;
+    }
+    while (level > 0 && lux < fall_lux_[level - 1]) {
+      --level;
+    }
+    return level;
+  }
+
+ private:
+  std::array<uint8_t, kLevels> brightness_{};
+  // Indexed by the lower of the two levels they separate.
+  std::array<float, kLevels - 1> boundary_lux_{};
+  std::array<float, kLevels - 1> rise_lux_{};
+  std::array<float, kLevels - 1> fall_lux_{};
+};
+
+/// Tracks the level of ambient light on a `BrightnessCurve`.
+template <size_t kLevels>
+class AmbientBrightness {
+ public:
+  explicit constexpr AmbientBrightness(const BrightnessCurve<kLevels>& curve)
+      : curve_(curve) {}
+
+  /// Returns the new brightness if `lux` moved to another level.
+  std::optional<uint8_t> Update(float lux) {
+    const size_t level =
+        level_.has_value() ? curve_.Level(lux, *level_) : curve_.Level(lux);
+    if (level == level_) {
+      return std::nullopt;
+    }
+    level_ = level;
+    return curve_.brightness(level);
+  }
+
+  /// Current level, or nothing before the first update.
+  std::optional<size_t> level() const { return level_; }
+
+ private:
+  const BrightnessCurve<kLevels>& curve_;
+  std::optional<size_t> level_;
+};
+
+}  // namespace sense
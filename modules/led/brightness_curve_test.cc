@@ -0,0 +1,72 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/brightness_curve.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+constexpr BrightnessCurve<16> kCurve(40.f, 3000.f, 10, 255);
+
+static_assert(kCurve.brightness(0) == 10);
+static_assert(kCurve.brightness(15) == 255);
+static_assert(kCurve.Level(1.f) == 0);
+static_assert(kCurve.Level(40.f) == 0);
+static_assert(kCurve.Level(3000.f) == 15);
+static_assert(kCurve.Level(100000.f) == 15);
+
+TEST(BrightnessCurveTest, BrightnessRisesWithLight) {
+  for (size_t i = 1; i < kCurve.levels(); ++i) {
+    EXPECT_GT(kCurve.brightness(i), kCurve.brightness(i - 1));
+  }
+  for (float lux = 40.f; lux < 3000.f; lux *= 1.1f) {
+    EXPECT_LE(kCurve.Level(lux), kCurve.Level(lux * 1.1f));
+  }
+}
+
+TEST(BrightnessCurveTest, StepsAreEvenInLog) {
+  // 3000 / 40 = 1.334^15, so each level spans a third more light.
+  EXPECT_EQ(kCurve.Level(40.f * 1.334f), 1u);
+  EXPECT_EQ(kCurve.Level(40.f * 1.334f * 1.334f * 1.334f), 3u);
+}
+
+TEST(AmbientBrightnessTest, FirstUpdateSetsBrightness) {
+  AmbientBrightness brightness(kCurve);
+  EXPECT_FALSE(brightness.level().has_value());
+  EXPECT_EQ(brightness.Update(10.f), 10u);
+  EXPECT_EQ(brightness.level(), 0u);
+  EXPECT_FALSE(brightness.Update(10.f).has_value());
+}
+
+TEST(AmbientBrightnessTest, DeadbandHoldsLevel) {
+  AmbientBrightness brightness(kCurve);
+  const float lux = 400.f;
+  ASSERT_TRUE(brightness.Update(lux).has_value());
+  const size_t level = brightness.level().value();
+
+  // Flickering light a few percent either side of a level stays put.
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(brightness.Update(i % 2 == 0 ? lux * 1.1f : lux / 1.1f));
+  }
+  EXPECT_EQ(brightness.level(), level);
+
+  // A visible change moves it.
+  EXPECT_EQ(brightness.Update(lux * 2.f), kCurve.brightness(level + 2));
+  EXPECT_EQ(brightness.Update(lux / 2.f), kCurve.brightness(level - 2));
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,63 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sense {
+namespace internal {
+
+// Returns x^(1/5) for x in [0, 1], using Newton's method.
+constexpr double FifthRoot(double x) {
+  if (x <= 0.0) {
+    return 0.0;
+  }
+  double y = 1.0;
+  for (int i = 0; i < 32; ++i) {
+    const double y4 = y * y * y * y;
+    y -= (y4 * y - x) / (5.0 * y4);
+  }
+  return y;
+}
+
+// Builds a table of g(x) = (x/255)^2.2, scaled to 16 bits and rounded.
+constexpr std::array<uint16_t, 256> MakeGammaTable() {
+  std::array<uint16_t, 256> table{};
+  for (size_t i = 0; i < table.size(); ++i) {
+    const double x = static_cast<double>(i) / 255.0;
+    const double gamma = x * x * FifthRoot(x);
+    table[i] = static_cast<uint16_t>(gamma * 65535.0 + 0.5);
+  }
+  return table;
+}
+
+}  // namespace internal
+
+/// 16-bit PWM levels for each 8-bit sRGB channel value at full brightness.
+inline constexpr std::array<uint16_t, 256> kGammaTable =
+    internal::MakeGammaTable();
+
+/// Returns the PWM level for an 8-bit sRGB channel value at the given
+/// brightness.
+///
+/// Gamma correction is done at 16 bits, so dim colors keep their hue rather
+/// than rounding to zero.
+constexpr uint16_t GammaCorrect(uint8_t value, uint8_t brightness) {
+  return static_cast<uint16_t>(
+      (uint32_t{kGammaTable[value]} * brightness + 127) / 255);
+}
+
+}  // namespace sense
@@ -0,0 +1,51 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/gamma.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+static_assert(GammaCorrect(0, 0xff) == 0);
+static_assert(GammaCorrect(0xff, 0xff) == 0xffff);
+static_assert(GammaCorrect(0xff, 0) == 0);
+
+TEST(GammaTest, TableIsMonotonic) {
+  for (size_t i = 1; i < kGammaTable.size(); ++i) {
+    EXPECT_GE(kGammaTable[i], kGammaTable[i - 1]);
+  }
+}
+
+TEST(GammaTest, MatchesSrgbCurve) {
+  // (128 / 255)^2.2 * 65535 = 14386.2
+  EXPECT_EQ(kGammaTable[128], 14386u);
+  // (64 / 255)^2.2 * 65535 = 3131.0
+  EXPECT_EQ(kGammaTable[64], 3131u);
+}
+
+TEST(GammaTest, DimColorsAreNotZero) {
+  for (uint8_t value = 8; value != 0; ++value) {
+    EXPECT_GT(GammaCorrect(value, 10), 0u) << "value " << int{value};
+  }
+}
+
+TEST(GammaTest, ScalesWithBrightness) {
+  EXPECT_NEAR(GammaCorrect(0xff, 0x80), 0x8080u, 1u);
+  EXPECT_LT(GammaCorrect(0x80, 10), GammaCorrect(0x80, 11));
+}
+
+}  // namespace
+}  // namespace sense
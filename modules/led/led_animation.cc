@@ -0,0 +1,81 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/led_animation.h"
+
+#include <algorithm>
+#include <initializer_list>
+
+#include "modules/led/gamma.h"
+#include "modules/lerp/lerp.h"
+
+namespace sense {
+namespace {
+
+constexpr uint8_t Channel(uint32_t color_hex, uint32_t shift) {
+  return static_cast<uint8_t>(color_hex >> shift);
+}
+
+uint32_t LerpColor(uint32_t a, uint32_t b, uint16_t step, uint16_t steps) {
+  uint32_t color_hex = 0;
+  for (uint32_t shift : {16u, 8u, 0u}) {
+    const uint8_t channel =
+        Lerp(Channel(a, shift), Channel(b, shift), step, steps);
+    color_hex |= uint32_t{channel} << shift;
+  }
+  return color_hex;
+}
+
+}  // namespace
+
+LedAnimation::Levels LedAnimation::LevelsFor(uint32_t color_hex,
+                                             uint8_t brightness) {
+  return {
+      .red = GammaCorrect(Channel(color_hex, 16), brightness),
+      .green = GammaCorrect(Channel(color_hex, 8), brightness),
+      .blue = GammaCorrect(Channel(color_hex, 0), brightness),
+  };
+}
+
+void LedAnimation::Build(const Keyframe& start,
+                         pw::span<const Keyframe> keyframes,
+                         bool repeat) {
+  uint32_t total_ms = 0;
+  for (const Keyframe& keyframe : keyframes) {
+    total_ms += keyframe.duration_ms;
+  }
+  step_ms_ = std::max(kMinStepMs,
+                      static_cast<uint32_t>(total_ms + kMaxSteps - 1) /
+                          static_cast<uint32_t>(kMaxSteps));
+  repeat_ = repeat;
+  index_ = 0;
+  size_ = 0;
+
+  Keyframe from = start;
+  for (const Keyframe& to : keyframes) {
+    if (size_ == kMaxSteps) {
+      break;
+    }
+    const auto steps = static_cast<uint16_t>(
+        std::clamp<uint32_t>(to.duration_ms / step_ms_, 1, kMaxSteps - size_));
+    for (uint16_t step = 1; step <= steps; ++step) {
+      steps_[size_++] =
+          LevelsFor(LerpColor(from.color_hex, to.color_hex, step, steps),
+                    Lerp(from.brightness, to.brightness, step, steps));
+    }
+    from = to;
+  }
+}
+
+}  // namespace sense
@@ -0,0 +1,99 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_span/span.h"
+
+namespace sense {
+
+/// Sequence of precomputed PWM levels for an RGB LED.
+///
+/// Keyframes are expanded up front into per-step channel levels, with gamma
+/// correction and brightness applied, so playing the animation from a PWM
+/// interrupt only copies levels to the outputs.
+///
+/// NOT thread safe. The animation must not be rebuilt while it is playing.
+class LedAnimation {
+ public:
+  /// Color and brightness to reach at the end of `duration_ms`.
+  struct Keyframe {
+    uint32_t color_hex;
+    uint8_t brightness;
+    uint32_t duration_ms;
+  };
+
+  struct Levels {
+    uint16_t red;
+    uint16_t green;
+    uint16_t blue;
+  };
+
+  static constexpr size_t kMaxSteps = 128;
+
+  /// Shortest time between steps, in milliseconds.
+  static constexpr uint32_t kMinStepMs = 10;
+
+  /// Returns the PWM levels for a color at the given brightness.
+  static Levels LevelsFor(uint32_t color_hex, uint8_t brightness);
+
+  /// Replaces the animation with ramps from `start` through each keyframe in
+  /// turn. `start`'s duration is ignored. Steps are lengthened as needed to
+  /// fit the whole animation in `kMaxSteps`.
+  void Build(const Keyframe& start,
+             pw::span<const Keyframe> keyframes,
+             bool repeat);
+
+  /// Returns the levels for the next step, or nullptr once a non-repeating
+  /// animation has finished.
+  const Levels* Next() {
+    if (index_ == size_) {
+      if (!repeat_ || size_ == 0) {
+        return nullptr;
+      }
+      index_ = 0;
+    }
+    return &steps_[index_++];
+  }
+
+  /// All of the animation's steps.
+  pw::span<const Levels> steps() const {
+    return pw::span(steps_.data(), size_);
+  }
+
+  /// Number of steps in the animation.
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  /// Time between steps, in milliseconds.
+  uint32_t step_ms() const { return step_ms_; }
+
+  /// Total duration of the animation, in milliseconds.
+  uint32_t duration_ms() const {
+    return static_cast<uint32_t>(size_) * step_ms_;
+  }
+
+ private:
+  std::array<Levels, kMaxSteps> steps_;
+  size_t size_ = 0;
+  size_t index_ = 0;
+  uint32_t step_ms_ = kMinStepMs;
+  bool repeat_ = false;
+};
+
+}  // namespace sense
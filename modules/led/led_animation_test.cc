@@ -0,0 +1,101 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/led_animation.h"
+
+#include "modules/led/gamma.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using Keyframe = LedAnimation::Keyframe;
+
+TEST(LedAnimationTest, FadeEndsAtKeyframe) {
+  LedAnimation animation;
+  const Keyframe fade[] = {
+      {.color_hex = 0x00ff00, .brightness = 0xff, .duration_ms = 100},
+  };
+  const Keyframe start = {
+      .color_hex = 0xff0000,
+      .brightness = 0xff,
+      .duration_ms = 0,
+  };
+  animation.Build(start, fade, false);
+  EXPECT_EQ(animation.step_ms(), LedAnimation::kMinStepMs);
+  ASSERT_EQ(animation.size(), 10u);
+
+  const LedAnimation::Levels* levels = nullptr;
+  for (size_t i = 0; i < animation.size(); ++i) {
+    levels = animation.Next();
+    ASSERT_NE(levels, nullptr);
+  }
+  EXPECT_EQ(levels->red, 0u);
+  EXPECT_EQ(levels->green, GammaCorrect(0xff, 0xff));
+  EXPECT_EQ(levels->blue, 0u);
+  EXPECT_EQ(animation.Next(), nullptr);
+}
+
+TEST(LedAnimationTest, RampsAreMonotonic) {
+  LedAnimation animation;
+  const Keyframe fade[] = {
+      {.color_hex = 0xffffff, .brightness = 0xff, .duration_ms = 500},
+  };
+  const Keyframe start = {
+      .color_hex = 0xffffff,
+      .brightness = 0,
+      .duration_ms = 0,
+  };
+  animation.Build(start, fade, false);
+
+  uint16_t previous = 0;
+  while (const LedAnimation::Levels* levels = animation.Next()) {
+    EXPECT_GE(levels->red, previous);
+    EXPECT_EQ(levels->red, levels->green);
+    EXPECT_EQ(levels->red, levels->blue);
+    previous = levels->red;
+  }
+  EXPECT_EQ(previous, GammaCorrect(0xff, 0xff));
+}
+
+TEST(LedAnimationTest, LongAnimationFitsInMaxSteps) {
+  LedAnimation animation;
+  const Keyframe keyframes[] = {
+      {.color_hex = 0xffffff, .brightness = 0xff, .duration_ms = 5000},
+      {.color_hex = 0x000000, .brightness = 0xff, .duration_ms = 5000},
+  };
+  const Keyframe start = {.color_hex = 0, .brightness = 0xff, .duration_ms = 0};
+  animation.Build(start, keyframes, false);
+  EXPECT_LE(animation.size(), LedAnimation::kMaxSteps);
+  EXPECT_GT(animation.step_ms(), LedAnimation::kMinStepMs);
+  EXPECT_NEAR(animation.duration_ms(), 10000u, animation.step_ms());
+}
+
+TEST(LedAnimationTest, RepeatingAnimationWraps) {
+  LedAnimation animation;
+  const Keyframe keyframes[] = {
+      {.color_hex = 0xff0000, .brightness = 0xff, .duration_ms = 10},
+      {.color_hex = 0x0000ff, .brightness = 0xff, .duration_ms = 10},
+  };
+  const Keyframe start = {.color_hex = 0, .brightness = 0xff, .duration_ms = 0};
+  animation.Build(start, keyframes, true);
+  ASSERT_EQ(animation.size(), 2u);
+
+  const LedAnimation::Levels* first = animation.Next();
+  animation.Next();
+  EXPECT_EQ(animation.Next(), first);
+}
+
+}  // namespace
+}  // namespace sense
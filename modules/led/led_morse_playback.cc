@@ -0,0 +1,62 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/led_morse_playback.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "pw_span/span.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+pw::Status LedMorsePlayback::DoStart(MorseRuns runs,
+                                     uint32_t interval_ms,
+                                     bool repeat) {
+  if (runs.empty()) {
+    return pw::Status::InvalidArgument();
+  }
+
+  // When repeating, the repeat gap replaces the leading blanks of the message,
+  // which the stream plays again each time.
+  size_t num_steps = runs.dits();
+  if (repeat) {
+    num_steps += kMorseRepeatGap - runs[0];
+  }
+  if (num_steps > steps_.size()) {
+    return pw::Status::ResourceExhausted();
+  }
+
+  const LedAnimation::Levels on = led_.levels();
+  const LedAnimation::Levels off = {.red = 0, .green = 0, .blue = 0};
+  auto step = steps_.begin();
+  for (size_t i = 0; i < runs.size(); ++i) {
+    step = std::fill_n(step, runs[i], MorseRuns::is_on(i) ? on : off);
+  }
+  std::fill(step, steps_.begin() + num_steps, off);
+
+  PW_TRY(led_.StreamLevels(
+      pw::span(steps_.data(), num_steps), interval_ms, repeat));
+  playing_ = true;
+  return pw::OkStatus();
+}
+
+void LedMorsePlayback::DoStop() {
+  if (std::exchange(playing_, false)) {
+    led_.CancelAnimation();
+  }
+}
+
+}  // namespace sense
@@ -0,0 +1,49 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "modules/led/led_animation.h"
+#include "modules/led/polychrome_led.h"
+#include "modules/morse_code/playback.h"
+#include "modules/morse_code/timeline.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Blinks Morse code on an RGB LED through its level stream.
+///
+/// Each dit of the timeline becomes one step of the LED's current levels or
+/// of zero, so the stream's hardware times every transition.
+///
+/// NOT thread safe. Must be used from the same context as the LED.
+class LedMorsePlayback final : public MorsePlayback {
+ public:
+  explicit LedMorsePlayback(PolychromeLed& led) : led_(led) {}
+
+ private:
+  pw::Status DoStart(MorseRuns runs,
+                     uint32_t interval_ms,
+                     bool repeat) override;
+
+  void DoStop() override;
+
+  PolychromeLed& led_;
+  std::array<LedAnimation::Levels, LedAnimation::kMaxSteps> steps_;
+  bool playing_ = false;
+};
+
+}  // namespace sense
@@ -17,8 +17,13 @@
 
 #include "modules/led/polychrome_led.h"
 
+#include <utility>
+
+#include "modules/profiling/gpio_markers.h"
 #include "pw_assert/check.h"
 #include "pw_log/log.h"
+#include "pw_status/try.h"
+#include "pw_trace/trace.h"
 
 namespace sense {
 
@@ -31,6 +36,7 @@ void PolychromeLed::Enable() {
 }
 
 void PolychromeLed::Disable() {
+  StopAnimation();
   state_ = kDisabled;
   UpdateZeroBrightness();
   red_.Disable();
@@ -40,6 +46,7 @@ void PolychromeLed::Disable() {
 
 void PolychromeLed::TurnOff() {
   if (state_ == kOn) {
+    StopAnimation();
     UpdateZeroBrightness();
     state_ = kOff;
     PW_LOG_DEBUG("LED off");
@@ -57,8 +64,12 @@ void PolychromeLed::TurnOn() {
 }
 
 void PolychromeLed::SetBrightness(uint8_t brightness) {
-  red_.ClearCallback();
-  if (brightness_ == brightness) {
+  if (holding_) {
+    brightness_ = brightness;
+    return;
+  }
+  const bool was_animating = StopAnimation();
+  if (brightness_ == brightness && !was_animating) {
     return;
   }
 
@@ -69,8 +80,13 @@ void PolychromeLed::SetBrightness(uint8_t brightness) {
 }
 
 void PolychromeLed::SetColor(uint32_t color_hex) {
-  red_.ClearCallback();
-  if (color_ == color_hex) {
+  if (holding_) {
+    color_ = color_hex;
+    return;
+  }
+  // If an animation was interrupted, the levels still need to be updated.
+  const bool was_animating = StopAnimation();
+  if (color_ == color_hex && !was_animating) {
     return;
   }
 
@@ -80,107 +96,179 @@ void PolychromeLed::SetColor(uint32_t color_hex) {
   }
 }
 
-void PolychromeLed::Pulse(uint32_t color_hex, uint32_t interval_ms) {
-  TurnOff();
-  brightness_ = 0;
-  color_ = color_hex;
+void PolychromeLed::FadeTo(uint32_t color_hex, uint32_t duration_ms) {
+  if (holding_ || state_ != kOn || duration_ms == 0) {
+    SetColor(color_hex);
+    return;
+  }
+  const LedAnimation::Keyframe keyframe = {
+      .color_hex = color_hex,
+      .brightness = brightness_,
+      .duration_ms = duration_ms,
+  };
+  Animate(pw::span(&keyframe, 1), /*repeat=*/false);
+}
+
+void PolychromeLed::Animate(pw::span<const LedAnimation::Keyframe> keyframes,
+                            bool repeat) {
+  StopAnimation();
+  if (keyframes.empty()) {
+    return;
+  }
+  animation_.Build(
+      {.color_hex = color_, .brightness = brightness_, .duration_ms = 0},
+      keyframes,
+      repeat);
+
+  // Track where the animation ends up, so later changes start from there.
+  color_ = keyframes.back().color_hex;
+  brightness_ = keyframes.back().brightness;
+  if (state_ != kOn) {
+    return;
+  }
+  animating_ = true;
+  playing_ = animation_.steps();
+  repeating_ = repeat;
+
+  if (level_stream_ != nullptr) {
+    const pw::Status status = level_stream_->Start(
+        animation_.steps(), animation_.step_ms(), repeat);
+    if (status.ok()) {
+      streaming_ = true;
+      return;
+    }
+    PW_LOG_DEBUG("Animating from the PWM callback: %s", status.str());
+  }
+
+  // Clearing the callback from its own invocation is not safe, so once a
+  // one-shot animation finishes it is detached from the worker. Until then,
+  // or without a worker, it only checks for a next step.
   red_.SetCallback(
       [this]() {
-        static uint16_t counter = 0;
-        if (counter < 0x100) {
-          brightness_ = counter;
-        } else {
-          brightness_ = 0x200 - counter;
+        if (const LedAnimation::Levels* levels = animation_.Next()) {
+          SetLevels(*levels);
+        } else if (worker_ != nullptr &&
+                   !callback_finished_.exchange(true,
+                                                std::memory_order_relaxed)) {
+          detach_callback_.Post(*worker_);
         }
-        Update();
-        counter = (counter + 1) % 0x200;
       },
-      0x200,
-      interval_ms);
+      static_cast<uint16_t>(animation_.size()),
+      animation_.duration_ms());
+}
+
+pw::Status PolychromeLed::StreamLevels(
+    pw::span<const LedAnimation::Levels> steps, uint32_t step_ms, bool repeat) {
+  CancelAnimation();
+  if (state_ != kOn || level_stream_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+  PW_TRY(level_stream_->Start(steps, step_ms, repeat));
+  animating_ = true;
+  streaming_ = true;
+  holding_ = true;
+  playing_ = steps;
+  repeating_ = repeat;
+  return pw::OkStatus();
+}
+
+void PolychromeLed::CancelAnimation() {
+  if (StopAnimation() && state_ == kOn) {
+    Update();
+  }
+}
+
+void PolychromeLed::Pulse(uint32_t color_hex, uint32_t interval_ms) {
+  TurnOff();
+  brightness_ = 0;
+  color_ = color_hex;
   TurnOn();
+  const uint32_t half_ms = interval_ms / 2;
+  const LedAnimation::Keyframe keyframes[] = {
+      {.color_hex = color_hex, .brightness = 0xff, .duration_ms = half_ms},
+      {.color_hex = color_hex, .brightness = 0, .duration_ms = half_ms},
+  };
+  Animate(keyframes, /*repeat=*/true);
 }
 
 void PolychromeLed::Rainbow(uint32_t interval_ms) {
   TurnOff();
   brightness_ = 0xff;
   color_ = 0xff0000;
-  red_.SetCallback(
-      [this]() {
-        static uint16_t counter = 0;
-        if (counter < 0x100) {
-          color_ = 0xff0000 + (counter << 8);
-        } else if (counter < 0x200) {
-          color_ = 0xffff00 - ((counter - 0x100) << 16);
-        } else if (counter < 0x300) {
-          color_ = 0x00ff00 + (counter - 0x200);
-        } else if (counter < 0x400) {
-          color_ = 0x00ffff - ((counter - 0x300) << 8);
-        } else if (counter < 0x500) {
-          color_ = 0x0000ff + ((counter - 0x400) << 16);
-        } else {
-          color_ = 0xff00ff - (counter - 0x500);
-        }
-        Update();
-        counter = (counter + 1) % 0x600;
-      },
-      0x600,
-      interval_ms);
   TurnOn();
+  const uint32_t duration_ms = interval_ms / 6;
+  const LedAnimation::Keyframe keyframes[] = {
+      {.color_hex = 0xffff00, .brightness = 0xff, .duration_ms = duration_ms},
+      {.color_hex = 0x00ff00, .brightness = 0xff, .duration_ms = duration_ms},
+      {.color_hex = 0x00ffff, .brightness = 0xff, .duration_ms = duration_ms},
+      {.color_hex = 0x0000ff, .brightness = 0xff, .duration_ms = duration_ms},
+      {.color_hex = 0xff00ff, .brightness = 0xff, .duration_ms = duration_ms},
+      {.color_hex = 0xff0000, .brightness = 0xff, .duration_ms = duration_ms},
+  };
+  Animate(keyframes, /*repeat=*/true);
+}
+
+LedAnimation::Levels PolychromeLed::mean_levels() const {
+  if (state_ != kOn) {
+    return {.red = 0, .green = 0, .blue = 0};
+  }
+  if (!animating_ || playing_.empty()) {
+    return levels();
+  }
+  if (!repeating_) {
+    return playing_.back();
+  }
+  uint32_t red = 0;
+  uint32_t green = 0;
+  uint32_t blue = 0;
+  for (const LedAnimation::Levels& step : playing_) {
+    red += step.red;
+    green += step.green;
+    blue += step.blue;
+  }
+  const auto size = static_cast<uint32_t>(playing_.size());
+  return {.red = static_cast<uint16_t>(red / size),
+          .green = static_cast<uint16_t>(green / size),
+          .blue = static_cast<uint16_t>(blue / size)};
+}
+
+bool PolychromeLed::StopAnimation() {
+  if (std::exchange(streaming_, false)) {
+    level_stream_->Stop();
+  }
+  red_.ClearCallback();
+  callback_finished_.store(false, std::memory_order_relaxed);
+  holding_ = false;
+  return std::exchange(animating_, false);
+}
+
+void PolychromeLed::DetachFinishedCallback() {
+  // A later change may already have ended the animation, or replaced it.
+  if (callback_finished_.load(std::memory_order_relaxed)) {
+    StopAnimation();
+  }
 }
 
 void PolychromeLed::Update() {
+  PW_TRACE_SCOPE("PolychromeLed::Update", "led");
+  SENSE_GPIO_MARK(kLedUpdate);
   PW_LOG_DEBUG("LED update: rgb=%06x brightness=%hu", color_, brightness_);
-  red_.SetLevel(GammaCorrect(color_ >> kRedShift));
-  green_.SetLevel(GammaCorrect(color_ >> kGreenShift));
-  blue_.SetLevel(GammaCorrect(color_ >> kBlueShift));
+  SetLevels(LedAnimation::LevelsFor(color_, brightness_));
+}
+
+void PolychromeLed::SetLevels(const LedAnimation::Levels& levels) {
+  const PwmDigitalOut::LevelUpdate updates[] = {
+      {.output = &red_, .level = levels.red},
+      {.output = &green_, .level = levels.green},
+      {.output = &blue_, .level = levels.blue},
+  };
+  PwmDigitalOut::SetLevels(updates);
 }
 
 void PolychromeLed::UpdateZeroBrightness() {
+  SENSE_GPIO_MARK(kLedUpdate);
   PW_LOG_DEBUG("LED update: rgb=%06x brightness=0", color_);
-  red_.SetLevel(0);
-  green_.SetLevel(0);
-  blue_.SetLevel(0);
-}
-
-uint16_t PolychromeLed::GammaCorrect(uint32_t val) const {
-  /// sRGB gamma correction is given by g(x) = ((x/255)^2.2)*255, rounded down.
-  // clang-format off
-  static constexpr std::array<uint8_t, 256> kGammaCorrection = {
-    0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   0,   0,   1,   1,
-    1,   1,   1,   1,   1,   2,   2,   2,
-    2,   2,   2,   3,   3,   3,   3,   3,
-    4,   4,   4,   4,   5,   5,   5,   5,
-    6,   6,   6,   7,   7,   7,   8,   8,
-    8,   9,   9,   9,   10,  10,  11,  11,
-    11,  12,  12,  13,  13,  13,  14,  14,
-    15,  15,  16,  16,  17,  17,  18,  18,
-    19,  19,  20,  21,  21,  22,  22,  23,
-    23,  24,  25,  25,  26,  27,  27,  28,
-    29,  29,  30,  31,  31,  32,  33,  34,
-    34,  35,  36,  37,  37,  38,  39,  40,
-    40,  41,  42,  43,  44,  45,  46,  46,
-    47,  48,  49,  50,  51,  52,  53,  54,
-    55,  56,  57,  58,  59,  60,  61,  62,
-    63,  64,  65,  66,  67,  68,  69,  70,
-    71,  72,  73,  74,  76,  77,  78,  79,
-    80,  81,  83,  84,  85,  86,  88,  89,
-    90,  91,  93,  94,  95,  96,  98,  99,
-    100, 102, 103, 104, 106, 107, 109, 110,
-    111, 113, 114, 116, 117, 119, 120, 121,
-    123, 124, 126, 128, 129, 131, 132, 134,
-    135, 137, 138, 140, 142, 143, 145, 146,
-    148, 150, 151, 153, 155, 157, 158, 160,
-    162, 163, 165, 167, 169, 170, 172, 174,
-    176, 178, 179, 181, 183, 185, 187, 189,
-    191, 193, 194, 196, 198, 200, 202, 204,
-    206, 208, 210, 212, 214, 216, 218, 220,
-    222, 224, 227, 229, 231, 233, 235, 237,
-    239, 241, 244, 246, 248, 250, 252, 255,
-  };
-  // clang-format on
-  return static_cast<uint16_t>(kGammaCorrection[val % 256]) * brightness_;
+  SetLevels({.red = 0, .green = 0, .blue = 0});
 }
 
 }  // namespace sense
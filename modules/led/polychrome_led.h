@@ -13,9 +13,16 @@
 // the License.
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
+#include "modules/led/led_animation.h"
+#include "modules/led/rgb_level_stream.h"
 #include "modules/pwm/digital_out.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
 
 namespace sense {
 
@@ -37,10 +44,23 @@ class PolychromeLed {
   }
 
   PolychromeLed(PwmDigitalOut& red, PwmDigitalOut& green, PwmDigitalOut& blue)
-      : red_(red), green_(green), blue_(blue) {}
+      : red_(red),
+        green_(green),
+        blue_(blue),
+        detach_callback_([this]() { DetachFinishedCallback(); }) {}
 
   ~PolychromeLed() = default;
 
+  /// Plays animations through `stream` rather than from the PWM callback,
+  /// falling back to the callback for any the stream cannot play.
+  void UseLevelStream(RgbLevelStream& stream) { level_stream_ = &stream; }
+
+  /// Detaches the PWM callback on `worker` once a one-shot animation played
+  /// from it finishes, so that its interrupt stops firing. `worker` must
+  /// accept posts from interrupts and be the context the LED is driven from.
+  /// Without one, the callback stays installed until the LED next changes.
+  void UseWorker(Worker& worker) { worker_ = &worker; }
+
   /// Enables the LED in the off state. Must be called for `TurnOn()` to work.
   void Enable();
 
@@ -73,6 +93,49 @@ class PolychromeLed {
   /// Sets the RGB LED using a 24-bit hex color code.
   void SetColor(uint32_t color_hex);
 
+  /// Fades from the current color to a new one over the given duration.
+  ///
+  /// The fade is only animated if the LED is on. Otherwise, or if
+  /// `duration_ms` is zero, this is the same as `SetColor`.
+  void FadeTo(uint32_t color_hex, uint32_t duration_ms);
+
+  /// Animates the LED through each keyframe in turn, starting from its
+  /// current color and brightness. The LED is left at the last keyframe, or
+  /// repeats the animation from the first one if `repeat` is set.
+  ///
+  /// Levels for each step are computed up front and written by the level
+  /// stream, if any, or from the PWM interrupt. Setting the color or
+  /// brightness, or turning the LED off, ends the animation.
+  void Animate(pw::span<const LedAnimation::Keyframe> keyframes, bool repeat);
+
+  /// Plays precomputed levels through the level stream, one step every
+  /// `step_ms`, for effects that need exact timing. `steps` must remain valid
+  /// until the stream ends.
+  ///
+  /// The stream is only ended by `CancelAnimation`, another animation, or
+  /// turning the LED off. `SetColor`, `SetBrightness` and `FadeTo` just
+  /// record the new color and brightness while it plays, and they take effect
+  /// once it ends.
+  ///
+  /// Returns FAILED_PRECONDITION if the LED is not on or has no level stream,
+  /// or the stream's error if it cannot play the steps.
+  pw::Status StreamLevels(pw::span<const LedAnimation::Levels> steps,
+                          uint32_t step_ms,
+                          bool repeat);
+
+  /// Ends any animation or stream, restoring the current color and brightness.
+  void CancelAnimation();
+
+  /// Returns the PWM levels for the current color and brightness.
+  LedAnimation::Levels levels() const {
+    return LedAnimation::LevelsFor(color_, brightness_);
+  }
+
+  /// Returns the PWM levels the LED is driven at on average, for energy
+  /// accounting: zero when off, the mean step of a repeating animation, and
+  /// the final step of any other.
+  LedAnimation::Levels mean_levels() const;
+
   /// Fades the LED on and off continuously.
   ///
   /// @param interval_ms The duration of a fade cycle, in milliseconds.
@@ -85,12 +148,18 @@ class PolychromeLed {
   /// Sets the levels of the red, green, and blue PWM slices.
   void Update();
 
+  void SetLevels(const LedAnimation::Levels& levels);
+
+  /// Stops any effect driven by the PWM callback or level stream. Returns
+  /// whether an animation may have left the levels short of `color_` and
+  /// `brightness_`.
+  bool StopAnimation();
+
   /// Sets the levels of the PWM slices to 0, preserving the prior brightness_.
   void UpdateZeroBrightness();
 
-  /// Adjusts the given 8-bit value using sRGB, and scales according to the
-  /// current brightness. The `uint32_t` value is masked to the bottom 8 bits.
-  uint16_t GammaCorrect(uint32_t value) const;
+  /// Ends a one-shot animation whose PWM callback has run out of steps.
+  void DetachFinishedCallback();
 
   PwmDigitalOut& red_;
   PwmDigitalOut& green_;
@@ -98,6 +167,23 @@ class PolychromeLed {
   uint32_t color_ = 0;
   uint8_t brightness_ = 0;
   enum : uint8_t { kDisabled, kOff, kOn } state_ = kDisabled;
+  RgbLevelStream* level_stream_ = nullptr;
+  LedAnimation animation_;
+  bool animating_ = false;
+  bool streaming_ = false;
+
+  // Set while `StreamLevels` plays, to defer color and brightness changes.
+  bool holding_ = false;
+
+  // Set from the PWM callback once a one-shot animation has played its last
+  // step, for `detach_callback_`.
+  std::atomic<bool> callback_finished_ = false;
+  Worker* worker_ = nullptr;
+  WorkItem detach_callback_;
+
+  // Steps of the current animation or stream, for `mean_levels`.
+  pw::span<const LedAnimation::Levels> playing_;
+  bool repeating_ = false;
 };
 
 inline void PolychromeLed::SetOnOff(bool turn_on) {
@@ -31,6 +31,12 @@ class PolychromeLedFake : public PolychromeLed {
   /// Returns whether any LED component has a non-zero level.
   bool is_on() const;
 
+  /// Returns whether an animation has a PWM callback installed.
+  bool has_pwm_callback() const { return red_.has_callback(); }
+
+  /// Runs the PWM callback once, as the PWM interrupt would.
+  void TickPwm() { red_.Tick(); }
+
   /// Enables "synchronous mode".
   ///
   /// When enabled, each call to `SetColor` or `SetBrightness` will block until
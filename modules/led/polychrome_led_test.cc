@@ -0,0 +1,159 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/led/polychrome_led.h"
+
+#include <array>
+#include <utility>
+
+#include "modules/led/polychrome_led_fake.h"
+#include "modules/led/rgb_level_stream.h"
+#include "modules/worker/worker.h"
+#include "pw_containers/vector.h"
+#include "pw_function/function.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+/// Level stream that records whether it is playing.
+class FakeLevelStream : public RgbLevelStream {
+ public:
+  bool playing() const { return playing_; }
+
+ private:
+  pw::Status DoStart(pw::span<const LedAnimation::Levels>,
+                     uint32_t,
+                     bool) override {
+    playing_ = true;
+    return pw::OkStatus();
+  }
+
+  void DoStop() override { playing_ = false; }
+
+  bool playing_ = false;
+};
+
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  size_t size() const { return work_.size(); }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+};
+
+class PolychromeLedTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    led_.UseLevelStream(stream_);
+    led_.Enable();
+    led_.SetColor(0xff0000);
+    led_.SetBrightness(0xff);
+    led_.TurnOn();
+  }
+
+  PolychromeLedFake led_;
+  FakeLevelStream stream_;
+  std::array<LedAnimation::Levels, 2> steps_{{
+      {.red = 1, .green = 2, .blue = 3},
+      {.red = 0, .green = 0, .blue = 0},
+  }};
+};
+
+TEST_F(PolychromeLedTest, StreamDefersColorAndBrightnessChanges) {
+  ASSERT_EQ(led_.StreamLevels(steps_, 100, /*repeat=*/true), pw::OkStatus());
+
+  led_.SetBrightness(0x40);
+  led_.SetColor(0x0000ff);
+  led_.FadeTo(0x00ff00, 500);
+  EXPECT_TRUE(stream_.playing());
+
+  led_.CancelAnimation();
+  EXPECT_FALSE(stream_.playing());
+  const LedAnimation::Levels expected = LedAnimation::LevelsFor(0x00ff00, 0x40);
+  EXPECT_EQ(led_.red(), expected.red);
+  EXPECT_EQ(led_.green(), expected.green);
+  EXPECT_EQ(led_.blue(), expected.blue);
+}
+
+TEST_F(PolychromeLedTest, TurnOffEndsStream) {
+  ASSERT_EQ(led_.StreamLevels(steps_, 100, /*repeat=*/true), pw::OkStatus());
+  led_.TurnOff();
+  EXPECT_FALSE(stream_.playing());
+
+  // Changes after the stream ends apply immediately.
+  led_.SetColor(0x0000ff);
+  led_.TurnOn();
+  const LedAnimation::Levels expected = LedAnimation::LevelsFor(0x0000ff, 0xff);
+  EXPECT_EQ(led_.blue(), expected.blue);
+}
+
+TEST(PolychromeLedCallbackTest, FinishedFadeDetachesCallback) {
+  PolychromeLedFake led;
+  ManualWorker worker;
+  led.UseWorker(worker);
+  led.Enable();
+  led.SetBrightness(0xff);
+  led.TurnOn();
+
+  led.FadeTo(0x00ff00, 100);
+  ASSERT_TRUE(led.has_pwm_callback());
+  for (size_t i = 0; i < LedAnimation::kMaxSteps && worker.size() == 0; ++i) {
+    led.TickPwm();
+  }
+  ASSERT_EQ(worker.size(), 1u);
+
+  // Further interrupts before the worker runs do not post again.
+  led.TickPwm();
+  EXPECT_EQ(worker.size(), 1u);
+
+  worker.RunAll();
+  EXPECT_FALSE(led.has_pwm_callback());
+  const LedAnimation::Levels expected = LedAnimation::LevelsFor(0x00ff00, 0xff);
+  EXPECT_EQ(led.green(), expected.green);
+}
+
+TEST(PolychromeLedCallbackTest, StaleDetachKeepsNewAnimation) {
+  PolychromeLedFake led;
+  ManualWorker worker;
+  led.UseWorker(worker);
+  led.Enable();
+  led.SetBrightness(0xff);
+  led.TurnOn();
+
+  led.FadeTo(0x00ff00, 100);
+  for (size_t i = 0; i < LedAnimation::kMaxSteps && worker.size() == 0; ++i) {
+    led.TickPwm();
+  }
+  ASSERT_EQ(worker.size(), 1u);
+
+  led.Pulse(0x0000ff, 1000);
+  worker.RunAll();
+  EXPECT_TRUE(led.has_pwm_callback());
+}
+
+}  // namespace
+}  // namespace sense
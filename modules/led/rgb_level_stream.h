@@ -0,0 +1,56 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "modules/led/led_animation.h"
+#include "pw_span/span.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Plays precomputed RGB levels without running any code per step, e.g. by
+/// streaming them to the PWM hardware with DMA.
+class RgbLevelStream {
+ public:
+  virtual ~RgbLevelStream() = default;
+
+  /// Starts writing `steps` to the red, green, and blue outputs, one step
+  /// every `step_ms`. Once finished, the last step is held, unless `repeat` is
+  /// set. `steps` must remain valid until `Stop` is called.
+  ///
+  /// Returns an error, without writing any levels, if the stream cannot play
+  /// the steps at the given rate.
+  pw::Status Start(pw::span<const LedAnimation::Levels> steps,
+                   uint32_t step_ms,
+                   bool repeat) {
+    return DoStart(steps, step_ms, repeat);
+  }
+
+  /// Stops writing levels. The outputs keep the last levels written.
+  void Stop() { DoStop(); }
+
+ protected:
+  RgbLevelStream() = default;
+
+ private:
+  virtual pw::Status DoStart(pw::span<const LedAnimation::Levels> steps,
+                             uint32_t step_ms,
+                             bool repeat) = 0;
+
+  virtual void DoStop() = 0;
+};
+
+}  // namespace sense
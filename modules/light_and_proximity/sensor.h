@@ -0,0 +1,66 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "modules/light/sensor.h"
+#include "modules/proximity/sensor.h"
+#include "pw_result/result.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+/// Represents a device that measures both ambient light and proximity and
+/// can read the two together more cheaply than separately.
+class LightAndProximitySensor {
+ public:
+  struct Samples {
+    /// Ambient light in lux, as returned by `AmbientLightSensor`.
+    float light_lux;
+    /// Proximity scaled to 0-65535, as returned by `ProximitySensor`.
+    uint16_t proximity;
+  };
+
+  /// Reads a light and a proximity sample together. Both sensors must be
+  /// enabled through their own interfaces first.
+  pw::Result<Samples> ReadSamples() { return DoReadLightAndProxSamples(); }
+
+ protected:
+  // Prohibit polymorphic destruction for now.
+  ~LightAndProximitySensor() = default;
+
+ private:
+  virtual pw::Result<Samples> DoReadLightAndProxSamples() = 0;
+};
+
+/// Combines separate light and proximity sensors by reading each in turn.
+class SeparateLightAndProximitySensors final : public LightAndProximitySensor {
+ public:
+  constexpr SeparateLightAndProximitySensors(AmbientLightSensor& light,
+                                             ProximitySensor& proximity)
+      : light_(light), proximity_(proximity) {}
+
+ private:
+  pw::Result<Samples> DoReadLightAndProxSamples() override {
+    PW_TRY_ASSIGN(const float lux, light_.ReadSampleLux());
+    PW_TRY_ASSIGN(const uint16_t proximity, proximity_.ReadSample());
+    return Samples{.light_lux = lux, .proximity = proximity};
+  }
+
+  AmbientLightSensor& light_;
+  ProximitySensor& proximity_;
+};
+
+}  // namespace sense
@@ -0,0 +1,61 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/log_policy/deferred_log.h"
+
+#include <optional>
+
+#include "pw_log/log.h"
+
+namespace sense {
+
+DeferredLog& DeferredLog::Global() {
+  static DeferredLog deferred_log;
+  return deferred_log;
+}
+
+void DeferredLog::Init(Worker& worker) {
+  worker_.store(&worker, std::memory_order_release);
+  ScheduleDrain();
+}
+
+void DeferredLog::Push(const Record& record) {
+  if (!queue_.push(record)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    total_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+  ScheduleDrain();
+}
+
+void DeferredLog::ScheduleDrain() {
+  // The work item is marked idle before `Drain` runs, so a log added while
+  // draining schedules another drain rather than waiting in the queue. A
+  // dropped post leaves it idle too, so the next log retries.
+  if (Worker* worker = worker_.load(std::memory_order_acquire);
+      worker != nullptr) {
+    drain_.Post(*worker);
+  }
+}
+
+void DeferredLog::Drain() {
+  while (std::optional<Record> record = queue_.pop()) {
+    record->emit(record->args);
+  }
+  if (uint32_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+      dropped > 0) {
+    PW_LOG_WARN("Dropped %u deferred logs", static_cast<unsigned>(dropped));
+  }
+}
+
+}  // namespace sense
@@ -0,0 +1,119 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "modules/pubsub/mpsc_queue.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_preprocessor/arguments.h"
+#include "pw_preprocessor/concat.h"
+
+/// Number of deferred logs that may wait to be emitted. Must be a power of
+/// two.
+#ifndef SENSE_DEFERRED_LOG_CAPACITY
+#define SENSE_DEFERRED_LOG_CAPACITY 32
+#endif  // SENSE_DEFERRED_LOG_CAPACITY
+
+namespace sense {
+
+/// Queue of logs whose formatting and output are deferred to a worker.
+///
+/// Adding a log copies a function pointer and up to three 32-bit arguments
+/// into a lock-free queue, so it is cheap enough for hot paths and safe to
+/// call from interrupts. The worker then emits the logs through the regular
+/// log backend. Logs added while the queue is full are dropped and counted.
+class DeferredLog {
+ public:
+  static constexpr size_t kCapacity = SENSE_DEFERRED_LOG_CAPACITY;
+  static constexpr size_t kMaxArgs = 3;
+
+  // Arguments are stored as `unsigned` so they match `%u` and `%x` on every
+  // target, including those where `uint32_t` is `unsigned long`.
+  using Args = std::array<unsigned, kMaxArgs>;
+  using Emitter = void (*)(const Args&);
+
+  /// Queue used by `SENSE_LOG_DEFERRED`.
+  static DeferredLog& Global();
+
+  DeferredLog() = default;
+  DeferredLog(const DeferredLog&) = delete;
+  DeferredLog& operator=(const DeferredLog&) = delete;
+
+  /// Sets the worker that emits logs. Logs added before this are emitted once
+  /// the worker is set.
+  void Init(Worker& worker);
+
+  /// Queues a log to be emitted by `emit` with the given arguments.
+  template <typename... T>
+  void Add(Emitter emit, T... args) {
+    static_assert(sizeof...(T) <= kMaxArgs, "Too many deferred log arguments");
+    static_assert(((std::is_integral_v<T> || std::is_enum_v<T>) && ...),
+                  "Deferred log arguments must be integers");
+    static_assert(((sizeof(T) <= sizeof(unsigned)) && ...),
+                  "Deferred log arguments must fit in an unsigned int");
+    Push(Record{emit, Args{static_cast<unsigned>(args)...}});
+  }
+
+  /// Emits every queued log. Only one context may drain at a time; this is
+  /// normally the worker.
+  void Drain();
+
+  /// Total number of logs dropped because the queue was full.
+  uint32_t dropped() const {
+    return total_dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Record {
+    Emitter emit;
+    Args args;
+  };
+
+  void Push(const Record& record);
+  void ScheduleDrain();
+
+  MpscQueueBuffer<Record, kCapacity> queue_;
+  std::atomic<Worker*> worker_ = nullptr;
+  WorkItem drain_{[this] { Drain(); }};
+  std::atomic<uint32_t> dropped_ = 0;
+  std::atomic<uint32_t> total_dropped_ = 0;
+};
+
+}  // namespace sense
+
+/// Logs with `log_macro` (e.g. `PW_LOG_INFO`) from the deferred log worker
+/// rather than the caller. Takes up to three integer arguments, which are
+/// passed to the log as `unsigned` and so should use `%u`, `%x` or
+/// `PW_TOKEN_FMT()`.
+#define SENSE_LOG_DEFERRED(log_macro, message, ...)                        \
+  ::sense::DeferredLog::Global().Add(                                      \
+      [](const ::sense::DeferredLog::Args& _sense_log_args) {              \
+        static_cast<void>(_sense_log_args);                                \
+        PW_CONCAT(_SENSE_LOG_DEFERRED_EMIT_, PW_MACRO_ARG_COUNT(__VA_ARGS__)) \
+        (log_macro, message);                                              \
+      } PW_COMMA_ARGS(__VA_ARGS__))
+
+#define _SENSE_LOG_DEFERRED_EMIT_0(log_macro, message) log_macro(message)
+#define _SENSE_LOG_DEFERRED_EMIT_1(log_macro, message) \
+  log_macro(message, _sense_log_args[0])
+#define _SENSE_LOG_DEFERRED_EMIT_2(log_macro, message) \
+  log_macro(message, _sense_log_args[0], _sense_log_args[1])
+#define _SENSE_LOG_DEFERRED_EMIT_3(log_macro, message) \
+  log_macro(message, _sense_log_args[0], _sense_log_args[1], _sense_log_args[2])
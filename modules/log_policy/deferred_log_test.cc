@@ -0,0 +1,152 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/log_policy/deferred_log.h"
+
+#include <cstdio>
+#include <utility>
+
+#include "pw_containers/vector.h"
+#include "pw_function/function.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+// Holds work until the test runs it.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (closed_) {
+      return false;
+    }
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  size_t pending() const { return work_.size(); }
+
+  // Drops any work posted while closed.
+  void set_closed(bool closed) { closed_ = closed; }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 8> work_;
+  bool closed_ = false;
+};
+
+unsigned emitted_sum = 0;
+int emitted_count = 0;
+
+void Sum(const DeferredLog::Args& args) {
+  emitted_sum += args[0] + args[1] + args[2];
+  ++emitted_count;
+}
+
+class DeferredLogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    emitted_sum = 0;
+    emitted_count = 0;
+  }
+};
+
+TEST_F(DeferredLogTest, EmitsOnWorker) {
+  DeferredLog log;
+  ManualWorker worker;
+  log.Init(worker);
+  worker.RunAll();
+
+  log.Add(Sum, 1, 2u, uint8_t{3});
+  log.Add(Sum);
+  EXPECT_EQ(emitted_count, 0);
+  EXPECT_EQ(worker.pending(), 1u);
+
+  worker.RunAll();
+  EXPECT_EQ(emitted_count, 2);
+  EXPECT_EQ(emitted_sum, 6u);
+}
+
+TEST_F(DeferredLogTest, HoldsLogsUntilInit) {
+  DeferredLog log;
+  log.Add(Sum, 5);
+  EXPECT_EQ(emitted_count, 0);
+
+  ManualWorker worker;
+  log.Init(worker);
+  worker.RunAll();
+  EXPECT_EQ(emitted_count, 1);
+  EXPECT_EQ(emitted_sum, 5u);
+}
+
+TEST_F(DeferredLogTest, RetriesDroppedDrain) {
+  DeferredLog log;
+  ManualWorker worker;
+  log.Init(worker);
+  worker.RunAll();
+
+  worker.set_closed(true);
+  log.Add(Sum, 1);
+  EXPECT_EQ(worker.pending(), 0u);
+
+  worker.set_closed(false);
+  log.Add(Sum, 2);
+  EXPECT_EQ(worker.pending(), 1u);
+  worker.RunAll();
+  EXPECT_EQ(emitted_count, 2);
+  EXPECT_EQ(emitted_sum, 3u);
+}
+
+TEST_F(DeferredLogTest, CountsDroppedLogs) {
+  DeferredLog log;
+  for (size_t i = 0; i < DeferredLog::kCapacity + 3; ++i) {
+    log.Add(Sum, 1);
+  }
+  EXPECT_EQ(log.dropped(), 3u);
+
+  log.Drain();
+  EXPECT_EQ(emitted_count, static_cast<int>(DeferredLog::kCapacity));
+
+  log.Add(Sum, 1);
+  log.Drain();
+  EXPECT_EQ(emitted_count, static_cast<int>(DeferredLog::kCapacity) + 1);
+  EXPECT_EQ(log.dropped(), 3u);
+}
+
+char last_log[64];
+
+#define TEST_LOG(...) std::snprintf(last_log, sizeof(last_log), __VA_ARGS__)
+
+TEST_F(DeferredLogTest, LogDeferredFormatsWhenDrained) {
+  last_log[0] = '\0';
+  const uint16_t repeat = 3;
+  SENSE_LOG_DEFERRED(TEST_LOG, "repeat %u every %ums", repeat, 250u);
+  EXPECT_STREQ(last_log, "");
+
+  DeferredLog::Global().Drain();
+  EXPECT_STREQ(last_log, "repeat 3 every 250ms");
+
+  SENSE_LOG_DEFERRED(TEST_LOG, "no arguments");
+  DeferredLog::Global().Drain();
+  EXPECT_STREQ(last_log, "no arguments");
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,37 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/log_policy/rate_limiter.h"
+
+namespace sense {
+
+bool LogRateLimiter::Allow(Clock::time_point now, uint32_t& suppressed) {
+  const auto now_tick = static_cast<uint32_t>(now.time_since_epoch().count());
+  uint32_t next = next_tick_.load(std::memory_order_relaxed);
+
+  // The first log from a call site always goes through.
+  bool due = !started_.load(std::memory_order_acquire) ||
+             static_cast<int32_t>(now_tick - next) >= 0;
+  if (!due ||
+      !next_tick_.compare_exchange_strong(
+          next, now_tick + interval_ticks_, std::memory_order_relaxed)) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  started_.store(true, std::memory_order_release);
+  suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace sense
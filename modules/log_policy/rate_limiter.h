@@ -0,0 +1,72 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_preprocessor/arguments.h"
+
+namespace sense {
+
+/// Lets one log through per interval and counts the ones it holds back.
+///
+/// Each `SENSE_LOG_EVERY` call site owns one of these. It is lock-free, so it
+/// may be used from interrupts as well as threads.
+class LogRateLimiter {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  explicit constexpr LogRateLimiter(Clock::duration interval)
+      : interval_ticks_(static_cast<uint32_t>(interval.count())) {}
+
+  LogRateLimiter(const LogRateLimiter&) = delete;
+  LogRateLimiter& operator=(const LogRateLimiter&) = delete;
+
+  /// Returns whether a log at `now` should be emitted. If so, `suppressed` is
+  /// set to the number of logs held back since the last one emitted.
+  ///
+  /// Only the low 32 bits of the clock are compared, so intervals must be
+  /// shorter than half the wrap period (about 35 minutes at 1 MHz).
+  bool Allow(Clock::time_point now, uint32_t& suppressed);
+
+  bool Allow(uint32_t& suppressed) { return Allow(Clock::now(), suppressed); }
+
+ private:
+  const uint32_t interval_ticks_;
+  std::atomic<bool> started_ = false;
+  std::atomic<uint32_t> next_tick_ = 0;
+  std::atomic<uint32_t> suppressed_ = 0;
+};
+
+}  // namespace sense
+
+/// Logs with `log_macro` (e.g. `PW_LOG_INFO`) at most once per `interval`
+/// from this call site. Logs in between are dropped and counted, and the next
+/// one emitted is suffixed with how many were held back.
+#define SENSE_LOG_EVERY(log_macro, interval, message, ...)                  \
+  do {                                                                      \
+    static ::sense::LogRateLimiter _sense_log_limiter(                      \
+        ::pw::chrono::SystemClock::for_at_least(interval));                 \
+    uint32_t _sense_log_suppressed = 0;                                     \
+    if (_sense_log_limiter.Allow(_sense_log_suppressed)) {                  \
+      if (_sense_log_suppressed == 0) {                                     \
+        log_macro(message PW_COMMA_ARGS(__VA_ARGS__));                      \
+      } else {                                                              \
+        log_macro(message " (%u suppressed)" PW_COMMA_ARGS(__VA_ARGS__),    \
+                  static_cast<unsigned>(_sense_log_suppressed));            \
+      }                                                                     \
+    }                                                                       \
+  } while (0)
@@ -0,0 +1,90 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/log_policy/rate_limiter.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using Clock = pw::chrono::SystemClock;
+using namespace std::chrono_literals;
+
+Clock::time_point At(Clock::duration offset) {
+  return Clock::time_point(offset);
+}
+
+TEST(LogRateLimiterTest, AllowsFirstLogAndOnePerInterval) {
+  LogRateLimiter limiter(Clock::for_at_least(100ms));
+  uint32_t suppressed = 99;
+
+  ASSERT_TRUE(limiter.Allow(At(5s), suppressed));
+  EXPECT_EQ(suppressed, 0u);
+
+  EXPECT_FALSE(limiter.Allow(At(5s + 1ms), suppressed));
+  EXPECT_FALSE(limiter.Allow(At(5s + 50ms), suppressed));
+  EXPECT_FALSE(limiter.Allow(At(5s + 99ms), suppressed));
+
+  ASSERT_TRUE(limiter.Allow(At(5s + 100ms), suppressed));
+  EXPECT_EQ(suppressed, 3u);
+
+  ASSERT_TRUE(limiter.Allow(At(6s), suppressed));
+  EXPECT_EQ(suppressed, 0u);
+}
+
+TEST(LogRateLimiterTest, HandlesClockWrap) {
+  LogRateLimiter limiter(Clock::for_at_least(10ms));
+  uint32_t suppressed = 0;
+  // The low 32 bits of the clock wrap between these logs.
+  const auto before_wrap = Clock::duration(0xffffff00);
+
+  ASSERT_TRUE(limiter.Allow(At(before_wrap), suppressed));
+  EXPECT_FALSE(limiter.Allow(At(before_wrap + 5ms), suppressed));
+  EXPECT_FALSE(limiter.Allow(At(before_wrap + 9ms), suppressed));
+  ASSERT_TRUE(limiter.Allow(At(before_wrap + 10ms), suppressed));
+  EXPECT_EQ(suppressed, 2u);
+}
+
+char last_log[64];
+int log_count = 0;
+
+#define TEST_LOG(...)                                       \
+  do {                                                      \
+    std::snprintf(last_log, sizeof(last_log), __VA_ARGS__); \
+    ++log_count;                                            \
+  } while (0)
+
+void LogValue(unsigned value) {
+  SENSE_LOG_EVERY(TEST_LOG, std::chrono::minutes(10), "value %u", value);
+}
+
+TEST(LogRateLimiterTest, LogEveryEmitsOncePerCallSite) {
+  log_count = 0;
+  for (unsigned i = 0; i < 5; ++i) {
+    LogValue(i);
+  }
+  EXPECT_EQ(log_count, 1);
+  EXPECT_STREQ(last_log, "value 0");
+
+  SENSE_LOG_EVERY(TEST_LOG, std::chrono::minutes(10), "other call site");
+  EXPECT_EQ(log_count, 2);
+  EXPECT_STREQ(last_log, "other call site");
+}
+
+}  // namespace
+}  // namespace sense
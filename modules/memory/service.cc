@@ -0,0 +1,94 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/memory/service.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include "pw_thread/thread_info.h"
+#include "pw_thread/thread_iteration.h"
+
+namespace sense {
+namespace {
+
+uint32_t Clamp(size_t value) {
+  return static_cast<uint32_t>(
+      std::min<size_t>(value, std::numeric_limits<uint32_t>::max()));
+}
+
+// Adds a thread's stack to the response. Stacks grow down, so the peak is the
+// distance from the top of the stack to the deepest address written.
+bool AddThread(const pw::thread::ThreadInfo& info, memory_Usage& response) {
+  if (response.threads_count >= std::size(response.threads)) {
+    return false;
+  }
+  memory_ThreadStack& thread = response.threads[response.threads_count++];
+  thread = memory_ThreadStack_init_default;
+
+  if (auto name = info.thread_name(); name.has_value()) {
+    const size_t length = std::min(name->size(), sizeof(thread.name) - 1);
+    std::memcpy(thread.name, name->data(), length);
+    thread.name[length] = '\0';
+  }
+  if (!info.stack_low_addr().has_value() ||
+      !info.stack_high_addr().has_value()) {
+    return true;
+  }
+  const uintptr_t high = *info.stack_high_addr();
+  thread.size_bytes = Clamp(high - *info.stack_low_addr());
+  if (auto peak = info.stack_peak_addr(); peak.has_value()) {
+    thread.has_peak_bytes = true;
+    thread.peak_bytes = Clamp(high - *peak);
+  }
+  return true;
+}
+
+}  // namespace
+
+void MemoryService::Init(pw::Allocator& allocator, PubSub& pubsub) {
+  allocator_ = &allocator;
+  pubsub_ = &pubsub;
+}
+
+pw::Status MemoryService::GetUsage(const pw_protobuf_Empty&,
+                                   memory_Usage& response) {
+  if (allocator_ == nullptr || pubsub_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+
+  // Not every RTOS supports iterating threads; the rest is still useful.
+  pw::thread::ForEachThread([&response](const pw::thread::ThreadInfo& info) {
+    return AddThread(info, response);
+  }).IgnoreError();
+
+  response.has_allocator = true;
+  if (pw::StatusWithSize capacity = allocator_->GetCapacity(); capacity.ok()) {
+    response.allocator.capacity_bytes = Clamp(capacity.size());
+  }
+  const size_t allocated = allocator_->GetAllocated();
+  if (allocated != std::numeric_limits<size_t>::max()) {
+    response.allocator.allocated_bytes = Clamp(allocated);
+  }
+
+  response.has_pubsub_queue = true;
+  response.pubsub_queue.capacity = Clamp(pubsub_->queue_capacity());
+  response.pubsub_queue.high_water_mark =
+      pubsub_->metrics().queue_high_water_mark();
+  return pw::OkStatus();
+}
+
+}  // namespace sense
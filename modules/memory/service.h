@@ -0,0 +1,37 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/memory/memory.rpc.pb.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_allocator/allocator.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Reports stack, allocator and queue usage so that statically sized buffers
+/// can be tuned from measurements.
+class MemoryService final
+    : public ::memory::pw_rpc::nanopb::Memory::Service<MemoryService> {
+ public:
+  void Init(pw::Allocator& allocator, PubSub& pubsub);
+
+  pw::Status GetUsage(const pw_protobuf_Empty&, memory_Usage& response);
+
+ private:
+  pw::Allocator* allocator_ = nullptr;
+  PubSub* pubsub_ = nullptr;
+};
+
+}  // namespace sense
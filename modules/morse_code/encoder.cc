@@ -11,134 +11,146 @@
 // WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
 // License for the specific language governing permissions and limitations under
 // the License.
-
 #define PW_LOG_MODULE_NAME "MORSE"
 #define PW_LOG_LOG_LEVEL PW_LOG_LEVEL_INFO
 
 #include "modules/morse_code/encoder.h"
 
-#include <cctype>
+#include <limits>
 #include <mutex>
 
+#include "modules/log_policy/deferred_log.h"
 #include "pw_function/function.h"
 #include "pw_log/log.h"
+#include "pw_trace/trace.h"
 
 namespace sense {
+namespace {
+
+constexpr uint32_t kRepeatForever = std::numeric_limits<uint32_t>::max();
+
+/// Logs the request and returns the number of times to emit the message.
+uint32_t CheckRepeat(uint32_t repeat, uint32_t interval_ms) {
+  if (repeat == 0) {
+    SENSE_LOG_DEFERRED(PW_LOG_INFO,
+                       "Encoding message forever at a %ums interval",
+                       interval_ms);
+    return kRepeatForever;
+  }
+  SENSE_LOG_DEFERRED(PW_LOG_INFO,
+                     "Encoding message %u times at a %ums interval",
+                     repeat,
+                     interval_ms);
+  return repeat;
+}
+
+}  // namespace
 
 Encoder::Encoder() : timer_(pw::bind_member<&Encoder::ToggleLed>(this)) {}
 
 Encoder::~Encoder() { timer_.Cancel(); }
 
-void Encoder::Init(Worker& worker, OutputFunction&& output) {
-  worker_ = &worker;
-  output_ = std::move(output);
-}
+void Encoder::Init(OutputFunction&& output) { output_ = std::move(output); }
 
 pw::Status Encoder::Encode(std::string_view msg,
                            uint32_t repeat,
                            uint32_t interval_ms) {
-  if (repeat == 0) {
-    PW_LOG_INFO("Encoding message forever at a %ums interval", interval_ms);
-    repeat = std::numeric_limits<uint32_t>::max();
-  } else {
-    PW_LOG_INFO(
-        "Encoding message %u times at a %ums interval", repeat, interval_ms);
+  repeat = CheckRepeat(repeat, interval_ms);
+  timer_.Cancel();
+  MorseRuns runs;
+  {
+    std::lock_guard lock(lock_);
+    timeline_.Compile(msg);
+    runs = timeline_.runs();
   }
-  pw::chrono::SystemClock::duration interval =
-      pw::chrono::SystemClock::for_at_least(
-          std::chrono::milliseconds(interval_ms));
+  Start(runs, repeat, interval_ms);
+  return pw::OkStatus();
+}
 
+pw::Status Encoder::Encode(MorseRuns runs,
+                           uint32_t repeat,
+                           uint32_t interval_ms) {
+  repeat = CheckRepeat(repeat, interval_ms);
   timer_.Cancel();
   {
     std::lock_guard lock(lock_);
-    is_on_ = false;
-    state_.msg_ = msg;
-    state_.msg_offset_ = 0;
-    state_.repeat_ = repeat;
-    interval_ = interval;
-    output_(false, state_);
+    if (timeline_.Assign(runs)) {
+      runs = timeline_.runs();
+    }
   }
-  worker_->RunOnce([this]() { ScheduleUpdate(); });
+  Start(runs, repeat, interval_ms);
   return pw::OkStatus();
 }
 
 bool Encoder::IsIdle() const {
   std::lock_guard lock(lock_);
-  return state_.repeat_ == 0 && state_.msg_offset_ == state_.msg_.size() &&
-         state_.num_bits_ == 0;
+  return state_.repeat_ == 0;
 }
 
-void Encoder::ScheduleUpdate() {
-  pw::chrono::SystemClock::duration interval(0);
-  bool want_on = false;
-  while (true) {
-    std::lock_guard lock(lock_);
-    if (state_.num_bits_ == 0 && !EnqueueNextLocked()) {
-      return;
-    }
-    want_on = (state_.bits_ % 2) != 0;
-    if (want_on != is_on_) {
-      break;
+void Encoder::Start(MorseRuns runs, uint32_t repeat, uint32_t interval_ms) {
+  bool in_hardware = false;
+  if (playback_ != nullptr) {
+    playback_->Stop();
+    if (!runs.empty() && (repeat == 1 || repeat == kRepeatForever)) {
+      const pw::Status status =
+          playback_->Start(runs, interval_ms, repeat != 1);
+      in_hardware = status.ok();
+      if (!in_hardware) {
+        PW_LOG_DEBUG("Encoding message with timers: %s", status.str());
+      }
     }
-    state_.bits_ >>= 1;
-    --state_.num_bits_;
-    interval += interval_;
   }
 
-  timer_.InvokeAfter(interval);
+  std::lock_guard lock(lock_);
+  interval_ = pw::chrono::SystemClock::for_at_least(
+      std::chrono::milliseconds(interval_ms));
+  in_hardware_ = in_hardware;
+  state_.runs_ = runs;
+  state_.run_ = 0;
+  state_.repeat_ = runs.empty() ? 0 : repeat;
+  if (in_hardware_) {
+    // Wake up once, when the last symbol of the message ends.
+    timer_.InvokeAfter(interval_ * (runs.dits() - runs[runs.size() - 1]));
+    return;
+  }
+  output_(false, state_);
+  if (state_.repeat_ != 0) {
+    timer_.InvokeAfter(interval_ * runs[0]);
+  }
 }
 
-bool Encoder::EnqueueNextLocked() {
-  state_.bits_ = 0;
-  state_.num_bits_ = 0;
-  char c;
-
-  // Try to get the next character, repeating the message as requested and
-  // merging consecutive whitespace characters.
-  bool needs_word_break = false;
-  while (true) {
-    if (state_.msg_offset_ == state_.msg_.size()) {
-      if (--state_.repeat_ == 0) {
-        return false;
-      }
-      needs_word_break = true;
-      state_.msg_offset_ = 0;
-    }
-    c = state_.msg_[state_.msg_offset_++];
-    if (c == '\0') {
-      state_.msg_offset_ = state_.msg_.size();
-      continue;
-    }
-    if (!isspace(c)) {
-      break;
-    }
-    needs_word_break = true;
+void Encoder::ToggleLed(pw::chrono::SystemClock::time_point) {
+  PW_TRACE_SCOPE("Encoder::ToggleLed", "morse");
+  std::lock_guard lock(lock_);
+  if (state_.repeat_ == 0) {
+    return;
   }
-
-  if (needs_word_break) {
-    // Words are separated by 7 dits worth of blanks.
-    // The previous symbol ended with 3 blanks, so add 4 more.
-    state_.num_bits_ += 4;
+  if (in_hardware_) {
+    state_.run_ = state_.runs_.size() - 1;
+    output_(false, state_);
+    if (--state_.repeat_ != 0) {
+      // The hardware repeats the message with its leading blanks replaced by
+      // the repeat gap.
+      timer_.InvokeAfter(interval_ * (state_.runs_.dits() + kMorseRepeatGap -
+                                      state_.runs_[0]));
+    }
+    return;
   }
 
-  // Encode the character.
-  auto it = internal::kEncodings.find(toupper(c));
-  if (it == internal::kEncodings.end()) {
-    it = internal::kEncodings.find('?');
+  if (++state_.run_ == state_.runs_.size()) {
+    // The repeat gap replaces the leading blanks of the message.
+    state_.run_ = 1;
   }
-  const internal::Encoding& encoding = it->second;
-  state_.bits_ |= encoding.bits << state_.num_bits_;
-  state_.num_bits_ += encoding.num_bits;
-  return state_.num_bits_ != 0;
-}
+  output_(MorseRuns::is_on(state_.run_), state_);
 
-void Encoder::ToggleLed(pw::chrono::SystemClock::time_point) {
-  {
-    std::lock_guard lock(lock_);
-    is_on_ = !is_on_;
-    output_(is_on_, state_);
+  uint32_t dits = state_.runs_[state_.run_];
+  if (state_.message_finished()) {
+    if (--state_.repeat_ == 0) {
+      return;
+    }
+    dits += kMorseRepeatGap;
   }
-  worker_->RunOnce([this]() { ScheduleUpdate(); });
+  timer_.InvokeAfter(interval_ * dits);
 }
 
 }  // namespace sense
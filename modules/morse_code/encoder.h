@@ -18,68 +18,16 @@
 #include <string_view>
 
 #include "modules/morse_code/morse_code.rpc.pb.h"
-#include "modules/worker/worker.h"
+#include "modules/morse_code/playback.h"
+#include "modules/morse_code/timeline.h"
 #include "pw_chrono/system_clock.h"
 #include "pw_chrono/system_timer.h"
-#include "pw_containers/flat_map.h"
+#include "pw_function/function.h"
 #include "pw_status/status.h"
-#include "pw_string/string.h"
 #include "pw_sync/interrupt_spin_lock.h"
 #include "pw_sync/lock_annotations.h"
 
 namespace sense {
-namespace internal {
-
-struct Encoding {
-  uint32_t bits = 0;
-
-  // Letters are separated by 3 dits worth of blanks.
-  // The symbol will always end with 1 blank, so add 2 more.
-  uint8_t num_bits = 2;
-
-  constexpr explicit Encoding(const char* s) { Encode(s); }
-
- private:
-  /// Converts a string of "dits" and "dahs", i.e. '.' and '-' respectively,
-  /// into a bit sequence of ons and offs.
-  constexpr void Encode(const char* s) {
-    if (*s == '.') {
-      bits |= (0x1 << num_bits);
-      num_bits += 2;
-      Encode(s + 1);
-    } else if (*s == '-') {
-      bits |= (0x7 << num_bits);
-      num_bits += 4;
-      Encode(s + 1);
-    }
-  }
-};
-
-// clang-format off
-constexpr pw::containers::FlatMap<char, Encoding, 38> kEncodings({{
-  {'A', Encoding(".-") },   {'T', Encoding("-") },
-  {'B', Encoding("-...") }, {'U', Encoding("..-") },
-  {'C', Encoding("-.-.") }, {'V', Encoding("...-") },
-  {'D', Encoding("-..") },  {'W', Encoding(".--") },
-  {'E', Encoding(".") },    {'X', Encoding("-..-") },
-  {'F', Encoding("..-.") }, {'Y', Encoding("-.--") },
-  {'G', Encoding("--.") },  {'Z', Encoding("--..") },
-  {'H', Encoding("....") }, {'0', Encoding("-----") },
-  {'I', Encoding("..") },   {'1', Encoding(".----") },
-  {'J', Encoding(".---") }, {'2', Encoding("..---") },
-  {'K', Encoding("-.-") },  {'3', Encoding("...--") },
-  {'L', Encoding(".-..") }, {'4', Encoding("....-") },
-  {'M', Encoding("--") },   {'5', Encoding(".....") },
-  {'N', Encoding("-.") },   {'6', Encoding("-....") },
-  {'O', Encoding("---") },  {'7', Encoding("--...") },
-  {'P', Encoding(".--.") }, {'8', Encoding("---..") },
-  {'Q', Encoding("--.-") }, {'9', Encoding("----.") },
-  {'R', Encoding(".-.") },  {'?', Encoding("..--..") },
-  {'S', Encoding("...") },  {'@', Encoding(".--.-.") },
-}});
-// clang-format on
-
-}  // namespace internal
 
 class Encoder final {
  public:
@@ -99,7 +47,7 @@ class Encoder final {
     /// encoder is repeating, this is true at the end of each repeated
     /// message.
     [[nodiscard]] bool message_finished() const {
-      return msg_offset_ == msg_.size() && num_bits_ == 1;
+      return !runs_.empty() && run_ + 1 == runs_.size();
     };
 
    private:
@@ -107,11 +55,9 @@ class Encoder final {
 
     constexpr State() = default;
 
-    pw::InlineString<kMaxMsgLen> msg_;
-    size_t msg_offset_ = 0;
-    size_t repeat_ = 1;
-    uint32_t bits_ = 0;
-    size_t num_bits_ = 0;
+    MorseRuns runs_;
+    size_t run_ = 0;
+    size_t repeat_ = 0;
   };
 
   using OutputFunction = pw::Function<void(bool turn_on, const State& status)>;
@@ -123,7 +69,15 @@ class Encoder final {
   /// Injects this object's dependencies.
   ///
   /// This method MUST be called before using any other method.
-  void Init(Worker& worker, OutputFunction&& output);
+  void Init(OutputFunction&& output);
+
+  /// Emits messages through `playback` where possible, falling back to timer
+  /// callbacks for those it cannot play.
+  ///
+  /// Only messages sent once or forever are played in hardware. The output
+  /// function is then only called at the end of each message, as an OFF with
+  /// `message_finished` set.
+  void UsePlayback(MorsePlayback& playback) { playback_ = &playback; }
 
   /// Queues a sequence of callbacks to emit the given message in Morse code.
   ///
@@ -134,6 +88,9 @@ class Encoder final {
   /// three "dit" intervals between each letter, and 7 "dit" intervals between
   /// each word.
   ///
+  /// The whole message is compiled into a `MorseTimeline` before the first
+  /// callback, so emitting it only arms a timer for each toggle.
+  ///
   /// @param  request       Message to emit in Morse code.
   /// @param  repeat        Number of times to repeat the message; 0 is forever
   /// @param  interval_ms   Duration of a "dit" in milliseconds.
@@ -141,34 +98,36 @@ class Encoder final {
                     uint32_t repeat,
                     uint32_t interval_ms) PW_LOCKS_EXCLUDED(lock_);
 
+  /// Queues a sequence of callbacks to emit a precompiled message, such as one
+  /// from `CompileMorse`. Runs that fit in a `kMaxMsgLen` message are copied,
+  /// so they only need to remain valid for the call. Longer runs must remain
+  /// valid until the message is finished or another one is encoded.
+  pw::Status Encode(MorseRuns runs, uint32_t repeat, uint32_t interval_ms)
+      PW_LOCKS_EXCLUDED(lock_);
+
   /// Returns whether this instance is currently emitting a message or not.
   bool IsIdle() const PW_LOCKS_EXCLUDED(lock_);
 
  private:
-  /// Adds a toggle callback to the work queue.
-  void ScheduleUpdate() PW_LOCKS_EXCLUDED(lock_);
+  /// Starts emitting the given runs.
+  void Start(MorseRuns runs, uint32_t repeat, uint32_t interval_ms)
+      PW_LOCKS_EXCLUDED(lock_);
 
-  /// Encodes the next character into a sequence of LED toggles.
-  ///
-  /// Returns whether more toggles remain, or if the message is done.
-  bool EnqueueNextLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
-
-  /// Callback for toggling the LED.
+  /// Callback for toggling the LED at the end of each run, or for reporting
+  /// the end of each message played in hardware.
   void ToggleLed(pw::chrono::SystemClock::time_point);
 
-  /// Emits an "off" to all configured outputs.
-  void TurnOff();
-
-  Worker* worker_ = nullptr;
   pw::chrono::SystemTimer timer_;
   OutputFunction output_;
+  MorsePlayback* playback_ = nullptr;
 
   mutable pw::sync::InterruptSpinLock lock_;
 
   State state_ PW_GUARDED_BY(lock_);
+  MorseTimeline<MaxMorseRuns(kMaxMsgLen)> timeline_ PW_GUARDED_BY(lock_);
   pw::chrono::SystemClock::duration interval_ PW_GUARDED_BY(lock_) =
       kDefaultInterval;
-  bool is_on_ PW_GUARDED_BY(lock_) = false;
+  bool in_hardware_ PW_GUARDED_BY(lock_) = false;
 };
 
 }  // namespace sense
@@ -18,7 +18,7 @@
 #include <cstdint>
 
 #include "modules/led/monochrome_led_fake.h"
-#include "modules/worker/test_worker.h"
+#include "modules/morse_code/timeline.h"
 #include "pw_containers/vector.h"
 #include "pw_status/status.h"
 #include "pw_sync/timed_thread_notification.h"
@@ -30,6 +30,26 @@ namespace sense {
 
 // Test fixtures.
 
+class FakeMorsePlayback : public MorsePlayback {
+ public:
+  void set_status(pw::Status status) { status_ = status; }
+
+  const pw::Vector<uint32_t, 1>& starts() const { return starts_; }
+
+ private:
+  pw::Status DoStart(MorseRuns runs, uint32_t, bool) override {
+    if (status_.ok()) {
+      starts_.push_back(runs.dits());
+    }
+    return status_;
+  }
+
+  void DoStop() override {}
+
+  pw::Status status_;
+  pw::Vector<uint32_t, 1> starts_;
+};
+
 class MorseCodeEncoderTest : public ::testing::Test {
  protected:
   using Event = ::sense::MonochromeLedFake::Event;
@@ -167,79 +187,105 @@ class MorseCodeEncoderTest : public ::testing::Test {
 // Unit tests.
 
 TEST_F(MorseCodeEncoderTest, EncodeEmpty) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   expected_messages_ = 0;
   EXPECT_EQ(encoder_.Encode("", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect("");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeOneLetter) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   EXPECT_EQ(encoder_.Encode("E", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect(".");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeOneWord) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   EXPECT_EQ(encoder_.Encode("PARIS", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect(".--. .- .-. .. ...");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeHelloWorld) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   EXPECT_EQ(encoder_.Encode("hello world", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
 
   Expect(".... . .-.. .-.. ---  .-- --- .-. .-.. -..");
 }
 
+TEST_F(MorseCodeEncoderTest, EncodePrecompiled) {
+  static constexpr auto kSos = CompileMorse("SOS");
+  encoder_.Init(LedOutput());
+  EXPECT_EQ(encoder_.Encode(kSos.runs(), 1, interval_ms_), pw::OkStatus());
+  SleepUntilDone();
+  Expect("... --- ...");
+}
+
+TEST_F(MorseCodeEncoderTest, EncodePrecompiledCopiesRuns) {
+  MorseTimeline<MaxMorseRuns(3)> timeline("SOS");
+  encoder_.Init(LedOutput());
+  EXPECT_EQ(encoder_.Encode(timeline.runs(), 1, interval_ms_), pw::OkStatus());
+  timeline.Compile("E");
+  SleepUntilDone();
+  Expect("... --- ...");
+}
+
+TEST_F(MorseCodeEncoderTest, EncodeInHardware) {
+  FakeMorsePlayback playback;
+  encoder_.Init(LedOutput());
+  encoder_.UsePlayback(playback);
+  EXPECT_EQ(encoder_.Encode("SOS", 1, interval_ms_), pw::OkStatus());
+  SleepUntilDone();
+  ASSERT_EQ(playback.starts().size(), 1u);
+  EXPECT_EQ(playback.starts()[0], 30u);
+
+  // Only the end of the message is reported.
+  Expect("");
+}
+
+TEST_F(MorseCodeEncoderTest, EncodeFallsBackToTimers) {
+  FakeMorsePlayback playback;
+  playback.set_status(pw::Status::ResourceExhausted());
+  encoder_.Init(LedOutput());
+  encoder_.UsePlayback(playback);
+  EXPECT_EQ(encoder_.Encode("SOS", 1, interval_ms_), pw::OkStatus());
+  SleepUntilDone();
+  EXPECT_TRUE(playback.starts().empty());
+  Expect("... --- ...");
+}
+
 // TODO(b/352327457): Without simulated time, this test is too slow to run every
 // case on device.
 #if defined(AM_MORSE_CODE_ENCODER_TEST_FULL) && AM_MORSE_CODE_ENCODER_TEST_FULL
 
 TEST_F(MorseCodeEncoderTest, EncodeRepeated) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   expected_messages_ = 2;
   EXPECT_EQ(encoder_.Encode("hello", 2, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect(".... . .-.. .-.. ---  .... . .-.. .-.. ---");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeSlow) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   interval_ms_ = 25;
   EXPECT_EQ(encoder_.Encode("hello", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect(".... . .-.. .-.. ---");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeConsecutiveWhitespace) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   EXPECT_EQ(encoder_.Encode("hello    world", 1, interval_ms_), pw::OkStatus());
   SleepUntilDone();
-  worker.Stop();
   Expect(".... . .-.. .-.. ---  .-- --- .-. .-.. -..");
 }
 
 TEST_F(MorseCodeEncoderTest, EncodeInvalidChars) {
-  TestWorker<> worker;
-  encoder_.Init(worker, LedOutput());
+  encoder_.Init(LedOutput());
   char s[2];
   s[1] = 0;
 
@@ -255,7 +301,6 @@ TEST_F(MorseCodeEncoderTest, EncodeInvalidChars) {
     SleepUntilDone();
     Expect("..--..");
   }
-  worker.Stop();
 }
 #endif  // AM_MORSE_CODE_ENCODER_TEST_FULL
 
@@ -0,0 +1,54 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "modules/morse_code/timeline.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Emits compiled Morse code timelines with hardware timing, e.g. by
+/// streaming LED levels with DMA, rather than toggling an output from a timer
+/// callback for every run.
+class MorsePlayback {
+ public:
+  virtual ~MorsePlayback() = default;
+
+  /// Starts emitting `runs`, one dit every `interval_ms`. If `repeat` is set,
+  /// the message repeats forever, separated by word breaks. `runs` must remain
+  /// valid until `Stop` is called.
+  ///
+  /// Returns an error, without emitting anything, if the timeline cannot be
+  /// played.
+  pw::Status Start(MorseRuns runs, uint32_t interval_ms, bool repeat) {
+    return DoStart(runs, interval_ms, repeat);
+  }
+
+  /// Stops emitting the current timeline.
+  void Stop() { DoStop(); }
+
+ protected:
+  MorsePlayback() = default;
+
+ private:
+  virtual pw::Status DoStart(MorseRuns runs,
+                             uint32_t interval_ms,
+                             bool repeat) = 0;
+
+  virtual void DoStop() = 0;
+};
+
+}  // namespace sense
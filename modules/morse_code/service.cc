@@ -16,8 +16,8 @@
 
 namespace sense {
 
-void MorseCodeService::Init(Worker& worker, Encoder::OutputFunction&& output) {
-  encoder_.Init(worker, std::move(output));
+void MorseCodeService::Init(Encoder::OutputFunction&& output) {
+  encoder_.Init(std::move(output));
 }
 
 pw::Status MorseCodeService::Send(const morse_code_SendRequest& request,
@@ -0,0 +1,208 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sense {
+namespace internal {
+
+/// Returns the dits ('.') and dahs ('-') for a character. Letters are case
+/// insensitive, and unsupported characters are sent as '?'.
+constexpr std::string_view MorseSymbols(char c) {
+  switch (c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c) {
+    // clang-format off
+    case 'A': return ".-";     case 'T': return "-";
+    case 'B': return "-...";   case 'U': return "..-";
+    case 'C': return "-.-.";   case 'V': return "...-";
+    case 'D': return "-..";    case 'W': return ".--";
+    case 'E': return ".";      case 'X': return "-..-";
+    case 'F': return "..-.";   case 'Y': return "-.--";
+    case 'G': return "--.";    case 'Z': return "--..";
+    case 'H': return "....";   case '0': return "-----";
+    case 'I': return "..";     case '1': return ".----";
+    case 'J': return ".---";   case '2': return "..---";
+    case 'K': return "-.-";    case '3': return "...--";
+    case 'L': return ".-..";   case '4': return "....-";
+    case 'M': return "--";     case '5': return ".....";
+    case 'N': return "-.";     case '6': return "-....";
+    case 'O': return "---";    case '7': return "--...";
+    case 'P': return ".--.";   case '8': return "---..";
+    case 'Q': return "--.-";   case '9': return "----.";
+    case 'R': return ".-.";    case '@': return ".--.-.";
+    case 'S': return "...";    default:  return "..--..";
+    // clang-format on
+  }
+}
+
+constexpr bool IsMorseSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+}  // namespace internal
+
+/// Blanks added to the last run of a message before it repeats, giving the
+/// 7 dit word break that separates repetitions.
+inline constexpr uint8_t kMorseRepeatGap = 6;
+
+/// Returns the most runs a message of `len` characters can compile to.
+///
+/// The longest characters have six symbols, each an on run and an off run,
+/// and the message starts with one more off run.
+constexpr size_t MaxMorseRuns(size_t len) { return 1 + 12 * len; }
+
+/// Read-only view of a compiled Morse code timeline.
+///
+/// Runs alternate between off and on, starting with off, and are measured in
+/// "dits". Two runs are packed into each byte.
+class MorseRuns {
+ public:
+  constexpr MorseRuns() = default;
+
+  constexpr MorseRuns(const uint8_t* packed, size_t size)
+      : packed_(packed), size_(size) {}
+
+  constexpr size_t size() const { return size_; }
+  constexpr bool empty() const { return size_ == 0; }
+
+  /// Returns whether the run at `index` turns the output on.
+  static constexpr bool is_on(size_t index) { return index % 2 != 0; }
+
+  constexpr uint8_t operator[](size_t index) const {
+    return (packed_[index / 2] >> (index % 2 == 0 ? 0 : 4)) & 0xF;
+  }
+
+  /// Returns the total length of the runs, in dits.
+  constexpr uint32_t dits() const {
+    uint32_t dits = 0;
+    for (size_t i = 0; i < size_; ++i) {
+      dits += operator[](i);
+    }
+    return dits;
+  }
+
+ private:
+  const uint8_t* packed_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// Morse code message compiled into a packed timeline of on and off runs.
+///
+/// Compiling does all of the per-character work up front: case folding,
+/// replacing unsupported characters, and merging consecutive whitespace into
+/// a single word break. Playing the result back only needs one timer per LED
+/// transition. Fixed messages can be compiled at build time with
+/// `CompileMorse`.
+template <size_t kMaxRuns>
+class MorseTimeline {
+ public:
+  constexpr MorseTimeline() = default;
+
+  constexpr explicit MorseTimeline(std::string_view msg) { Compile(msg); }
+
+  /// Replaces the timeline with the given message.
+  ///
+  /// A NUL character ends the message. Characters that do not fit are
+  /// dropped.
+  constexpr void Compile(std::string_view msg) {
+    packed_ = {};
+    size_ = 0;
+    bool needs_word_break = false;
+    for (char c : msg) {
+      if (c == '\0') {
+        break;
+      }
+      if (internal::IsMorseSpace(c)) {
+        needs_word_break = true;
+        continue;
+      }
+      std::string_view symbols = internal::MorseSymbols(c);
+      if (size_ + (size_ == 0 ? 1 : 0) + 2 * symbols.size() > kMaxRuns) {
+        break;
+      }
+
+      // Letters are separated by 3 dits worth of blanks, and words by 7. The
+      // previous symbol always ends with 1 blank.
+      uint8_t blanks = needs_word_break ? 6 : 2;
+      needs_word_break = false;
+      if (size_ == 0) {
+        Append(blanks);
+      } else {
+        Extend(blanks);
+      }
+      for (char symbol : symbols) {
+        Append(symbol == '-' ? 3 : 1);
+        Append(1);
+      }
+    }
+  }
+
+  /// Replaces the timeline with a copy of already compiled runs. Returns
+  /// false, leaving the timeline unchanged, if they do not fit.
+  constexpr bool Assign(MorseRuns runs) {
+    if (runs.size() > kMaxRuns) {
+      return false;
+    }
+    packed_ = {};
+    size_ = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+      Append(runs[i]);
+    }
+    return true;
+  }
+
+  constexpr MorseRuns runs() const { return MorseRuns(packed_.data(), size_); }
+
+  constexpr size_t size() const { return size_; }
+
+  constexpr uint8_t operator[](size_t index) const { return runs()[index]; }
+
+ private:
+  constexpr void Append(uint8_t run) {
+    auto shift = size_ % 2 == 0 ? 0 : 4;
+    packed_[size_ / 2] |= static_cast<uint8_t>(run << shift);
+    ++size_;
+  }
+
+  constexpr void Extend(uint8_t blanks) {
+    size_t index = --size_;
+    auto run = static_cast<uint8_t>(operator[](index) + blanks);
+    packed_[index / 2] &= index % 2 == 0 ? 0xF0 : 0x0F;
+    Append(run);
+  }
+
+  std::array<uint8_t, (kMaxRuns + 1) / 2> packed_{};
+  size_t size_ = 0;
+};
+
+/// Compiles a string literal into a `MorseTimeline` sized to fit it.
+///
+/// This is `constexpr`, so fixed messages cost no work at runtime:
+///
+/// @code{.cpp}
+///   static constexpr auto kBlinks = CompileMorse("TTT");
+///   encoder.Encode(kBlinks.runs(), 1, Encoder::kDefaultIntervalMs);
+/// @endcode
+template <size_t kLen>
+constexpr MorseTimeline<MaxMorseRuns(kLen - 1)> CompileMorse(
+    const char (&msg)[kLen]) {
+  return MorseTimeline<MaxMorseRuns(kLen - 1)>(
+      std::string_view(msg, kLen - 1));
+}
+
+}  // namespace sense
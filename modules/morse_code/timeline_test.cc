@@ -0,0 +1,116 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/morse_code/timeline.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+// "E" is a dit, preceded by the letter gap and followed by a symbol gap.
+constexpr auto kE = CompileMorse("E");
+static_assert(kE.size() == 3);
+static_assert(kE[0] == 2 && kE[1] == 1 && kE[2] == 1);
+
+// "TTT" is three dahs separated by letter gaps.
+constexpr auto kTtt = CompileMorse("TTT");
+static_assert(kTtt.size() == 7);
+static_assert(kTtt[1] == 3 && kTtt[2] == 3 && kTtt[3] == 3 && kTtt[6] == 1);
+static_assert(kTtt.runs().dits() == 18);
+
+/// Converts runs back into dits, dahs, and blanks for readable comparisons.
+///
+/// Symbols are separated by nothing, letters by one space, and words by two.
+template <size_t kMaxRuns>
+std::string ToSymbols(const MorseTimeline<kMaxRuns>& timeline) {
+  std::string symbols;
+  MorseRuns runs = timeline.runs();
+  for (size_t i = 1; i < runs.size(); ++i) {
+    if (MorseRuns::is_on(i)) {
+      symbols += runs[i] == 3 ? '-' : runs[i] == 1 ? '.' : '!';
+    } else if (i + 1 < runs.size()) {
+      symbols += runs[i] == 7 ? "  " : runs[i] == 3 ? " " : "";
+    }
+  }
+  return symbols;
+}
+
+TEST(MorseTimelineTest, CompileEmpty) {
+  MorseTimeline<MaxMorseRuns(4)> timeline("");
+  EXPECT_EQ(timeline.size(), 0u);
+  EXPECT_TRUE(timeline.runs().empty());
+}
+
+TEST(MorseTimelineTest, CompileOneWord) {
+  MorseTimeline<MaxMorseRuns(5)> timeline("PARIS");
+  EXPECT_EQ(timeline[0], 2u);
+  EXPECT_EQ(ToSymbols(timeline), ".--. .- .-. .. ...");
+}
+
+TEST(MorseTimelineTest, CompileIgnoresCase) {
+  MorseTimeline<MaxMorseRuns(11)> timeline("hello WORLD");
+  EXPECT_EQ(ToSymbols(timeline), ".... . .-.. .-.. ---  .-- --- .-. .-.. -..");
+}
+
+TEST(MorseTimelineTest, CompileMergesWhitespace) {
+  MorseTimeline<MaxMorseRuns(16)> timeline(" hello \t\n world ");
+  EXPECT_EQ(timeline[0], 6u);
+  EXPECT_EQ(ToSymbols(timeline), ".... . .-.. .-.. ---  .-- --- .-. .-.. -..");
+}
+
+TEST(MorseTimelineTest, CompileUnsupportedAsQuestionMark) {
+  MorseTimeline<MaxMorseRuns(2)> timeline("#e");
+  EXPECT_EQ(ToSymbols(timeline), "..--.. .");
+}
+
+TEST(MorseTimelineTest, CompileStopsAtNul) {
+  MorseTimeline<MaxMorseRuns(3)> timeline(std::string_view("E\0E", 3));
+  EXPECT_EQ(ToSymbols(timeline), ".");
+}
+
+TEST(MorseTimelineTest, CompileDropsWhatDoesNotFit) {
+  MorseTimeline<6> timeline("ETE");
+  EXPECT_EQ(ToSymbols(timeline), ". -");
+}
+
+TEST(MorseTimelineTest, CompileReplacesPrevious) {
+  MorseTimeline<MaxMorseRuns(5)> timeline("PARIS");
+  timeline.Compile("T");
+  EXPECT_EQ(timeline.size(), 3u);
+  EXPECT_EQ(ToSymbols(timeline), "-");
+}
+
+TEST(MorseTimelineTest, AssignCopiesRuns) {
+  MorseTimeline<MaxMorseRuns(5)> timeline("T");
+  {
+    MorseTimeline<MaxMorseRuns(5)> source("PARIS");
+    EXPECT_TRUE(timeline.Assign(source.runs()));
+    source.Compile("E");
+  }
+  EXPECT_EQ(ToSymbols(timeline), ".--. .- .-. .. ...");
+}
+
+TEST(MorseTimelineTest, AssignRejectsRunsThatDoNotFit) {
+  MorseTimeline<6> timeline("T");
+  EXPECT_FALSE(timeline.Assign(CompileMorse("PARIS").runs()));
+  EXPECT_EQ(ToSymbols(timeline), "-");
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,65 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/power/power_manager.h"
+
+#include <algorithm>
+
+namespace sense {
+
+void PowerManager::BeginSleep(uint64_t now_us, uint32_t expected_ms) {
+  if (started_ && !sleeping_) {
+    awake_us_ += now_us - last_us_;
+    awake_ms_.Set(ToMilliseconds(awake_us_));
+  }
+  started_ = true;
+  sleeping_ = true;
+  last_us_ = now_us;
+  expected_ms_ = expected_ms;
+}
+
+void PowerManager::EndSleep(uint64_t now_us) {
+  if (!sleeping_) {
+    return;
+  }
+  const uint64_t slept_us = now_us - last_us_;
+  sleeping_ = false;
+  last_us_ = now_us;
+  sleep_us_ += slept_us;
+
+  sleeps_.Increment();
+  // Anything other than the tick timer ending the sleep, e.g. a button or a
+  // DMA completion, wakes the CPU before the kernel expected.
+  if (slept_us / 1000 < expected_ms_) {
+    early_wakeups_.Increment();
+  }
+  sleep_ms_.Set(ToMilliseconds(sleep_us_));
+  max_sleep_ms_.Set(
+      std::max(max_sleep_ms_.value(), ToMilliseconds(slept_us)));
+  sleep_permille_.Set(sleep_permille());
+}
+
+uint32_t PowerManager::sleep_permille() const {
+  const uint64_t total_us = sleep_us_ + awake_us_;
+  if (total_us == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(sleep_us_ * 1000 / total_us);
+}
+
+uint32_t PowerManager::ToMilliseconds(uint64_t us) {
+  return static_cast<uint32_t>(std::min<uint64_t>(us / 1000, UINT32_MAX));
+}
+
+}  // namespace sense
@@ -0,0 +1,64 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "pw_metric/metric.h"
+
+namespace sense {
+
+/// Accounts for the time the CPU spends asleep in the idle task.
+///
+/// The target's idle hooks call `BeginSleep` just before waiting for an
+/// interrupt and `EndSleep` as soon as it wakes, both with interrupts masked.
+/// Everything between one `EndSleep` and the next `BeginSleep` counts as
+/// awake time.
+class PowerManager {
+ public:
+  /// Records that the CPU is about to sleep for up to `expected_ms`.
+  void BeginSleep(uint64_t now_us, uint32_t expected_ms);
+
+  /// Records that the CPU woke from the sleep begun by `BeginSleep`.
+  void EndSleep(uint64_t now_us);
+
+  uint64_t sleep_us() const { return sleep_us_; }
+  uint64_t awake_us() const { return awake_us_; }
+
+  /// Returns the share of time spent asleep in thousandths.
+  uint32_t sleep_permille() const;
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+ private:
+  static uint32_t ToMilliseconds(uint64_t us);
+
+  bool started_ = false;
+  bool sleeping_ = false;
+  uint64_t last_us_ = 0;
+  uint64_t sleep_us_ = 0;
+  uint64_t awake_us_ = 0;
+  uint32_t expected_ms_ = 0;
+
+  PW_METRIC_GROUP(metrics_, "power");
+  PW_METRIC(metrics_, sleeps_, "sleeps", 0u);
+  PW_METRIC(metrics_, early_wakeups_, "early wakeups", 0u);
+  PW_METRIC(metrics_, sleep_ms_, "sleep ms", 0u);
+  PW_METRIC(metrics_, awake_ms_, "awake ms", 0u);
+  PW_METRIC(metrics_, max_sleep_ms_, "max sleep ms", 0u);
+  PW_METRIC(metrics_, sleep_permille_, "sleep permille", 0u);
+
+};
+
+}  // namespace sense
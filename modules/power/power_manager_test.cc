@@ -0,0 +1,59 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/power/power_manager.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+TEST(PowerManagerTest, StartsWithNoTime) {
+  PowerManager power;
+  EXPECT_EQ(power.sleep_us(), 0u);
+  EXPECT_EQ(power.awake_us(), 0u);
+  EXPECT_EQ(power.sleep_permille(), 0u);
+}
+
+TEST(PowerManagerTest, AccumulatesSleepAndAwakeTime) {
+  PowerManager power;
+  power.BeginSleep(1'000, 10);
+  power.EndSleep(11'000);
+  power.BeginSleep(13'000, 5);
+  power.EndSleep(18'000);
+
+  EXPECT_EQ(power.sleep_us(), 15'000u);
+  EXPECT_EQ(power.awake_us(), 2'000u);
+  EXPECT_EQ(power.sleep_permille(), 882u);
+}
+
+TEST(PowerManagerTest, TimeBeforeFirstSleepIsNotCounted) {
+  PowerManager power;
+  power.BeginSleep(500'000, 1);
+  power.EndSleep(501'000);
+  EXPECT_EQ(power.sleep_us(), 1'000u);
+  EXPECT_EQ(power.awake_us(), 0u);
+}
+
+TEST(PowerManagerTest, IgnoresUnmatchedEndSleep) {
+  PowerManager power;
+  power.EndSleep(1'000);
+  power.BeginSleep(2'000, 1);
+  power.EndSleep(3'000);
+  power.EndSleep(9'000);
+  EXPECT_EQ(power.sleep_us(), 1'000u);
+}
+
+}  // namespace
+}  // namespace sense
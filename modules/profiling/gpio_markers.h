@@ -0,0 +1,57 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Set by `--config=gpio_markers`.
+#ifndef SENSE_GPIO_MARKERS_ENABLED
+#define SENSE_GPIO_MARKERS_ENABLED 0
+#endif  // SENSE_GPIO_MARKERS_ENABLED
+
+namespace sense {
+
+/// Stages between a button press and the LED changing. Each has its own
+/// GPIO, which toggles every time the stage is reached, so that a logic
+/// analyzer can time the whole path. Events other than button presses also
+/// pass through the PubSub and LED stages; `tools/sense/marker_latency.py`
+/// follows each press through to the first edge of every later stage.
+enum class GpioMarker : uint8_t {
+  kButtonEdge = 0,
+  kButtonPublish,
+  kPublish,
+  kNotifySubscribers,
+  kStateManagerUpdate,
+  kLedUpdate,
+};
+inline constexpr size_t kNumGpioMarkers = 6;
+
+/// Configures the marker GPIOs as outputs. Implemented by the target.
+void InitGpioMarkers();
+
+/// Toggles the GPIO of `marker`. Implemented by the target, ideally with a
+/// single register write, and safe to call from interrupts.
+void ToggleGpioMarker(GpioMarker marker);
+
+}  // namespace sense
+
+/// Toggles the GPIO of a `GpioMarker`, e.g. `SENSE_GPIO_MARK(kPublish)`.
+/// Compiles to nothing unless markers are enabled.
+#if SENSE_GPIO_MARKERS_ENABLED
+#define SENSE_GPIO_MARK(marker) \
+  ::sense::ToggleGpioMarker(::sense::GpioMarker::marker)
+#else
+#define SENSE_GPIO_MARK(marker) static_cast<void>(0)
+#endif  // SENSE_GPIO_MARKERS_ENABLED
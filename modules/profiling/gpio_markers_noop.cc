@@ -11,14 +11,13 @@
 // WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
 // License for the specific language governing permissions and limitations under
 // the License.
-#pragma once
 
-#include "pw_thread/thread.h"
+#include "modules/profiling/gpio_markers.h"
 
 namespace sense {
 
-/// Thread options to use for the sampling thread. Must be implemented by the
-/// target.
-const pw::thread::Options& SamplingThreadOptions();
+void InitGpioMarkers() {}
+
+void ToggleGpioMarker(GpioMarker) {}
 
 }  // namespace sense
@@ -0,0 +1,61 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/profiling/service.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "pw_trace/trace.h"
+#include "pw_trace_tokenized/config.h"
+#include "pw_trace_tokenized/trace_buffer.h"
+
+namespace sense {
+
+pw::Status ProfilingService::Start(const pw_protobuf_Empty&,
+                                   pw_protobuf_Empty&) {
+  trace_ = {};
+  pw::trace::ClearBuffer();
+  PW_TRACE_SET_ENABLED(true);
+  recording_ = true;
+  return pw::OkStatus();
+}
+
+pw::Status ProfilingService::Stop(const pw_protobuf_Empty&,
+                                  pw_protobuf_Empty&) {
+  PW_TRACE_SET_ENABLED(false);
+  recording_ = false;
+  trace_ = pw::trace::DeringAndViewRawBuffer();
+  return pw::OkStatus();
+}
+
+pw::Status ProfilingService::ReadTrace(
+    const profiling_ReadTraceRequest& request, profiling_TraceChunk& response) {
+  if (recording_) {
+    return pw::Status::FailedPrecondition();
+  }
+  if (request.offset > trace_.size()) {
+    return pw::Status::OutOfRange();
+  }
+  const pw::ConstByteSpan chunk = trace_.subspan(request.offset);
+  response.data.size = static_cast<pb_size_t>(
+      std::min(chunk.size(), sizeof(response.data.bytes)));
+  std::memcpy(response.data.bytes, chunk.data(), response.data.size);
+  response.total_size = static_cast<uint32_t>(trace_.size());
+  response.ticks_per_second =
+      static_cast<uint32_t>(pw_trace_GetTraceTimeTicksPerSecond());
+  return pw::OkStatus();
+}
+
+}  // namespace sense
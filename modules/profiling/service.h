@@ -0,0 +1,44 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/profiling/profiling.rpc.pb.h"
+#include "pw_bytes/span.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Starts and stops the tokenized trace, and serves what it recorded.
+///
+/// Only linked into builds with `--config=trace`, which select the
+/// pw_trace_tokenized backend. The app enables tracing at boot, so the first
+/// trace read after `Stop` covers boot as well, if the buffer has room.
+class ProfilingService final
+    : public ::profiling::pw_rpc::nanopb::Profiling::Service<ProfilingService> {
+ public:
+  pw::Status Start(const pw_protobuf_Empty&, pw_protobuf_Empty&);
+
+  pw::Status Stop(const pw_protobuf_Empty&, pw_protobuf_Empty&);
+
+  pw::Status ReadTrace(const profiling_ReadTraceRequest& request,
+                       profiling_TraceChunk& response);
+
+ private:
+  bool recording_ = true;
+
+  // The trace buffer, unwrapped by the last `Stop`. Empty while recording.
+  pw::ConstByteSpan trace_;
+};
+
+}  // namespace sense
@@ -0,0 +1,101 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/proximity/calibrator.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+namespace {
+
+constexpr uint32_t kMaxSample = std::numeric_limits<uint16_t>::max();
+
+uint16_t Saturate(uint32_t value) {
+  return static_cast<uint16_t>(std::min(value, kMaxSample));
+}
+
+}  // namespace
+
+ProximityCalibrator::ProximityCalibrator(Thresholds minimum,
+                                         const Config& config)
+    : minimum_(minimum), config_(config), thresholds_(minimum) {
+  PW_CHECK_UINT_LT(minimum.far, minimum.near);
+  PW_CHECK_UINT_GT(config.samples_per_adjustment, 0);
+}
+
+std::optional<ProximityCalibrator::Thresholds> ProximityCalibrator::Update(
+    uint16_t sample, bool near) {
+  // Approaching objects raise samples well before they count as near, so
+  // only samples below the near threshold describe the background.
+  if (near || sample >= thresholds_.near) {
+    return std::nullopt;
+  }
+  if (std::optional<uint16_t> baseline = baseline_.value()) {
+    noise_.Update(static_cast<uint16_t>(
+        std::max(sample, *baseline) - std::min(sample, *baseline)));
+  }
+  baseline_.Update(sample);
+
+  if (++samples_since_adjustment_ < config_.samples_per_adjustment) {
+    return std::nullopt;
+  }
+  samples_since_adjustment_ = 0;
+
+  const Thresholds target = Target();
+  Thresholds next = {
+      .far = Step(thresholds_.far, target.far),
+      .near = Step(thresholds_.near, target.near),
+  };
+  next.near = std::max(next.near, static_cast<uint16_t>(next.far + 1));
+  if (next.far == thresholds_.far && next.near == thresholds_.near) {
+    return std::nullopt;
+  }
+  thresholds_ = next;
+  return thresholds_;
+}
+
+ProximityCalibrator::Thresholds ProximityCalibrator::Target() const {
+  const uint32_t baseline = baseline_.value().value_or(0);
+  const uint32_t noise = this->noise();
+  const uint32_t gap = minimum_.near - minimum_.far;
+
+  // Leave room above the far threshold for the near one.
+  const uint32_t far_above_noise =
+      baseline + config_.far_noise_multiple * noise;
+  const uint16_t far =
+      std::min(Saturate(std::max<uint32_t>(minimum_.far, far_above_noise)),
+               static_cast<uint16_t>(kMaxSample - 1));
+  const uint16_t near = Saturate(std::max({
+      uint32_t{minimum_.near},
+      baseline + config_.near_noise_multiple * noise,
+      far + gap,
+  }));
+  return {.far = far, .near = near};
+}
+
+uint16_t ProximityCalibrator::Step(uint16_t current, uint16_t target) const {
+  const int32_t distance = int32_t{target} - int32_t{current};
+  const int32_t abs_distance = distance < 0 ? -distance : distance;
+  if (abs_distance < config_.min_step) {
+    return current;
+  }
+  // Move halfway, but by at least a step so that the target is reached.
+  const int32_t step = std::max<int32_t>(abs_distance / 2, config_.min_step);
+  return static_cast<uint16_t>(current + (distance < 0 ? -step : step));
+}
+
+}  // namespace sense
@@ -0,0 +1,85 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "modules/filters/filters.h"
+
+namespace sense {
+
+/// Learns a proximity sensor's baseline and noise while nothing is near, and
+/// slowly raises the near and far thresholds to clear them.
+///
+/// Units in different enclosures see different amounts of reflected light,
+/// so fixed thresholds suit some and leave others chattering between near
+/// and far. The thresholds never go below the configured ones, so a quiet
+/// unit behaves exactly as before.
+class ProximityCalibrator {
+ public:
+  struct Thresholds {
+    /// Samples at or below this are far.
+    uint16_t far = 0;
+    /// Samples at or above this are near.
+    uint16_t near = 0;
+  };
+
+  struct Config {
+    /// Far samples between adjustments. Each adjustment moves the thresholds
+    /// halfway to their targets.
+    uint32_t samples_per_adjustment = 64;
+
+    /// Targets above the baseline, in multiples of the mean deviation.
+    uint16_t far_noise_multiple = 4;
+    uint16_t near_noise_multiple = 16;
+
+    /// Smallest change worth applying. The LTR559 only resolves multiples of
+    /// 32 in these units.
+    uint16_t min_step = 32;
+  };
+
+  explicit ProximityCalibrator(Thresholds minimum)
+      : ProximityCalibrator(minimum, Config{}) {}
+
+  ProximityCalibrator(Thresholds minimum, const Config& config);
+
+  /// Adds a sample, along with whether an object is currently near. Only far
+  /// samples are learned from. Returns the new thresholds if they changed.
+  std::optional<Thresholds> Update(uint16_t sample, bool near);
+
+  const Thresholds& thresholds() const { return thresholds_; }
+
+  /// Average far sample, or nothing before the first one.
+  std::optional<uint16_t> baseline() const { return baseline_.value(); }
+
+  /// Mean deviation of far samples from the baseline.
+  uint16_t noise() const { return noise_.value().value_or(0); }
+
+ private:
+  // Time constant of the baseline and noise, in samples.
+  static constexpr unsigned kFilterShift = 6;
+
+  Thresholds Target() const;
+  uint16_t Step(uint16_t current, uint16_t target) const;
+
+  const Thresholds minimum_;
+  const Config config_;
+  Thresholds thresholds_;
+  OnePoleLowPass<uint16_t, kFilterShift> baseline_;
+  OnePoleLowPass<uint16_t, kFilterShift> noise_;
+  uint32_t samples_since_adjustment_ = 0;
+};
+
+}  // namespace sense
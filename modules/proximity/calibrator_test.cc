@@ -0,0 +1,97 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/proximity/calibrator.h"
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using Thresholds = ProximityCalibrator::Thresholds;
+
+constexpr Thresholds kMinimum = {.far = 512, .near = 16384};
+
+// Alternates between `center - spread` and `center + spread`.
+uint16_t Noisy(uint32_t i, uint16_t center, uint16_t spread) {
+  return static_cast<uint16_t>(i % 2 == 0 ? center - spread : center + spread);
+}
+
+TEST(ProximityCalibratorTest, QuietSensorKeepsMinimumThresholds) {
+  ProximityCalibrator calibrator(kMinimum);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    EXPECT_FALSE(calibrator.Update(Noisy(i, 100, 10), false).has_value());
+  }
+  EXPECT_EQ(calibrator.thresholds().far, kMinimum.far);
+  EXPECT_EQ(calibrator.thresholds().near, kMinimum.near);
+  EXPECT_NEAR(calibrator.baseline().value(), 100, 10);
+  EXPECT_NEAR(calibrator.noise(), 10, 2);
+}
+
+TEST(ProximityCalibratorTest, RaisesThresholdsAboveBrightBaseline) {
+  ProximityCalibrator calibrator(kMinimum);
+  size_t changes = 0;
+  for (uint32_t i = 0; i < 2000; ++i) {
+    if (calibrator.Update(Noisy(i, 6000, 500), false).has_value()) {
+      ++changes;
+    }
+  }
+  // Adjusted gradually, a step at a time.
+  EXPECT_GT(changes, 2u);
+  const Thresholds& thresholds = calibrator.thresholds();
+  EXPECT_NEAR(thresholds.far, 6000 + 4 * 500, 100);
+  EXPECT_NEAR(thresholds.near, 6000 + 4 * 500 + (16384 - 512), 100);
+}
+
+TEST(ProximityCalibratorTest, AdjustsSlowly) {
+  ProximityCalibrator calibrator(kMinimum);
+  for (uint32_t i = 0; i < 63; ++i) {
+    EXPECT_FALSE(calibrator.Update(5000, false).has_value());
+  }
+  std::optional<Thresholds> thresholds = calibrator.Update(5000, false);
+  ASSERT_TRUE(thresholds.has_value());
+  EXPECT_GT(thresholds->far, kMinimum.far);
+  EXPECT_LT(thresholds->far, 5000);
+}
+
+TEST(ProximityCalibratorTest, IgnoresSamplesWhileNear) {
+  ProximityCalibrator calibrator(kMinimum);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    EXPECT_FALSE(calibrator.Update(40000, true).has_value());
+    EXPECT_FALSE(calibrator.Update(20000, false).has_value());
+  }
+  EXPECT_FALSE(calibrator.baseline().has_value());
+  EXPECT_EQ(calibrator.thresholds().far, kMinimum.far);
+}
+
+TEST(ProximityCalibratorTest, FallsBackTowardsMinimum) {
+  ProximityCalibrator calibrator(kMinimum);
+  for (uint32_t i = 0; i < 2000; ++i) {
+    std::ignore = calibrator.Update(8000, false);
+  }
+  EXPECT_GT(calibrator.thresholds().far, 7000);
+  for (uint32_t i = 0; i < 4000; ++i) {
+    std::ignore = calibrator.Update(0, false);
+  }
+  // Within a step of the minimum.
+  EXPECT_NEAR(calibrator.thresholds().far, kMinimum.far, 32);
+  EXPECT_NEAR(calibrator.thresholds().near, kMinimum.near, 32);
+}
+
+}  // namespace
+}  // namespace sense
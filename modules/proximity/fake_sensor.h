@@ -13,6 +13,9 @@
 // the License.
 #pragma once
 
+#include <cstdint>
+#include <utility>
+
 #include "modules/proximity/sensor.h"
 
 namespace sense {
@@ -28,6 +31,20 @@ class FakeProximitySensor final : public ProximitySensor {
     sample_ = pw::Result<uint16_t>(error);
   }
 
+  /// Has `EnableThresholdDetection` succeed, as for a sensor that detects
+  /// thresholds in hardware.
+  void set_detects_thresholds(bool detects) { detects_thresholds_ = detects; }
+
+  /// Reports a transition the way the sensor's hardware would.
+  void TriggerThreshold(bool near) {
+    if (callback_ != nullptr) {
+      callback_(near);
+    }
+  }
+
+  uint16_t inactive_threshold() const { return inactive_threshold_; }
+  uint16_t active_threshold() const { return active_threshold_; }
+
  private:
   pw::Status DoEnableProximitySensor() override { return pw::OkStatus(); }
 
@@ -35,7 +52,36 @@ class FakeProximitySensor final : public ProximitySensor {
 
   pw::Result<uint16_t> DoReadProxSample() override { return sample_; }
 
+  pw::Status DoEnableThresholdDetection(uint16_t inactive_threshold,
+                                        uint16_t active_threshold,
+                                        ThresholdCallback&& callback) override {
+    if (!detects_thresholds_) {
+      return pw::Status::Unimplemented();
+    }
+    callback_ = std::move(callback);
+    return DoSetThresholds(inactive_threshold, active_threshold);
+  }
+
+  pw::Status DoSetThresholds(uint16_t inactive_threshold,
+                             uint16_t active_threshold) override {
+    if (callback_ == nullptr) {
+      return pw::Status::FailedPrecondition();
+    }
+    inactive_threshold_ = inactive_threshold;
+    active_threshold_ = active_threshold;
+    return pw::OkStatus();
+  }
+
+  pw::Status DoDisableThresholdDetection() override {
+    callback_ = nullptr;
+    return pw::OkStatus();
+  }
+
   pw::Result<uint16_t> sample_;
+  bool detects_thresholds_ = false;
+  ThresholdCallback callback_;
+  uint16_t inactive_threshold_ = 0;
+  uint16_t active_threshold_ = 0;
 };
 
 }  // namespace sense
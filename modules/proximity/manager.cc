@@ -14,13 +14,103 @@
 
 #include "modules/proximity/manager.h"
 
+#include <tuple>
+
 #include "pw_assert/check.h"
+#include "pw_log/log.h"
 
 namespace sense {
 
 ProximityManager::ProximityManager(PubSub& pubsub,
                                    uint16_t inactive_threshold,
                                    uint16_t active_threshold)
-    : edge_detector_(pubsub, inactive_threshold, active_threshold) {}
+    : pubsub_(pubsub),
+      edge_detector_(std::in_place, inactive_threshold, active_threshold),
+      calibrator_({.far = inactive_threshold, .near = active_threshold}) {
+  PW_CHECK(pubsub_.SubscribeTo<ProximitySample>(
+      [this](ProximitySample event) { HandleSample(event.sample); }));
+  PublishCalibration();
+}
+
+ProximityManager::ProximityManager(PubSub& pubsub,
+                                   ProximitySensor& sensor,
+                                   uint16_t inactive_threshold,
+                                   uint16_t active_threshold)
+    : pubsub_(pubsub),
+      calibrator_({.far = inactive_threshold, .near = active_threshold}) {
+  pw::Status status = sensor.EnableThresholdDetection(
+      inactive_threshold, active_threshold, [this](bool near) {
+        near_.store(near, std::memory_order_relaxed);
+        PW_CHECK(pubsub_.Publish(ProximityStateChange{.proximity = near}));
+      });
+  if (status.ok()) {
+    PW_LOG_INFO("Detecting proximity thresholds in the sensor");
+    sensor_ = &sensor;
+  } else {
+    if (!status.IsUnimplemented()) {
+      PW_LOG_WARN("Failed to enable sensor proximity thresholds: %s",
+                  status.str());
+    }
+    edge_detector_.emplace(inactive_threshold, active_threshold);
+  }
+  PW_CHECK(pubsub_.SubscribeTo<ProximitySample>(
+      [this](ProximitySample event) { HandleSample(event.sample); }));
+  PublishCalibration();
+}
+
+void ProximityManager::HandleSample(uint16_t sample) {
+  if (edge_detector_.has_value()) {
+    switch (edge_detector_->Update(sample)) {
+      case Edge::kNone:
+        break;
+      case Edge::kRising:
+        near_.store(true, std::memory_order_relaxed);
+        PW_CHECK(pubsub_.Publish(ProximityStateChange{.proximity = true}));
+        break;
+      case Edge::kFalling:
+        near_.store(false, std::memory_order_relaxed);
+        PW_CHECK(pubsub_.Publish(ProximityStateChange{.proximity = false}));
+        break;
+    }
+  }
+
+  const bool near = near_.load(std::memory_order_relaxed);
+  if (std::optional<ProximityCalibrator::Thresholds> thresholds =
+          calibrator_.Update(sample, near)) {
+    ApplyThresholds(*thresholds);
+  }
+  PublishCalibration();
+}
+
+void ProximityManager::ApplyThresholds(
+    const ProximityCalibrator::Thresholds& thresholds) {
+  PW_LOG_INFO("Proximity thresholds now far <= %u, near >= %u",
+              static_cast<unsigned>(thresholds.far),
+              static_cast<unsigned>(thresholds.near));
+  adjustments_.Increment();
+  if (sensor_ != nullptr) {
+    if (pw::Status status =
+            sensor_->SetThresholds(thresholds.far, thresholds.near);
+        !status.ok()) {
+      PW_LOG_WARN("Failed to update sensor proximity thresholds: %s",
+                  status.str());
+    }
+    return;
+  }
+
+  // Changing the thresholds forgets the state, so restore it with a sample
+  // on the matching side rather than publishing a spurious edge.
+  edge_detector_->set_low_and_high_thresholds(thresholds.far, thresholds.near);
+  std::ignore = edge_detector_->Update(
+      near_.load(std::memory_order_relaxed) ? thresholds.near : thresholds.far);
+}
+
+void ProximityManager::PublishCalibration() {
+  const ProximityCalibrator::Thresholds& thresholds = calibrator_.thresholds();
+  far_threshold_.Set(thresholds.far);
+  near_threshold_.Set(thresholds.near);
+  baseline_.Set(calibrator_.baseline().value_or(0));
+  noise_.Set(calibrator_.noise());
+}
 
 }  // namespace sense
@@ -13,8 +13,15 @@
 // the License.
 #pragma once
 
-#include "modules/edge_detector/pubsub.h"
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include "modules/edge_detector/hysteresis_edge_detector.h"
+#include "modules/proximity/calibrator.h"
+#include "modules/proximity/sensor.h"
 #include "modules/pubsub/pubsub_events.h"
+#include "pw_metric/metric.h"
 
 namespace sense {
 
@@ -23,24 +30,49 @@ class ProximityManager {
   /// Reports near/far proximity events through PubSub. Uses the provided
   /// thresholds, which are in unspecified units ranging from 0 (farthest) to
   /// 65535 (nearest).
+  ///
+  /// The thresholds are raised above the sensor's baseline and noise as they
+  /// are learned from far samples, but never go below the provided ones.
+  ProximityManager(PubSub& pubsub,
+                   uint16_t inactive_threshold,
+                   uint16_t active_threshold);
+
+  /// Like the above, but has `sensor` detect the thresholds itself when it
+  /// can. Transitions are then published from the sensor's callback and
+  /// proximity samples are only needed to calibrate the thresholds. Falls
+  /// back to detecting edges in published samples otherwise.
   ProximityManager(PubSub& pubsub,
+                   ProximitySensor& sensor,
                    uint16_t inactive_threshold,
                    uint16_t active_threshold);
 
+  /// Returns whether the sensor is detecting transitions in hardware.
+  bool uses_sensor_thresholds() const { return !edge_detector_.has_value(); }
+
+  /// The thresholds currently in use, together with the learned baseline and
+  /// noise, which are also served through the metric service.
+  pw::metric::Group& metrics() { return metrics_; }
+
  private:
-  struct ProxSamplerPubSub {
-    using PubSub = sense::PubSub;
-    using Sample = uint16_t;
-    using SampleEvent = ProximitySample;
+  void HandleSample(uint16_t sample);
+  void ApplyThresholds(const ProximityCalibrator::Thresholds& thresholds);
+  void PublishCalibration();
+
+  PubSub& pubsub_;
+  ProximitySensor* sensor_ = nullptr;
+  std::optional<HysteresisEdgeDetector<uint16_t>> edge_detector_;
 
-    static uint16_t GetSample(SampleEvent event) { return event.sample; }
+  // Written from the sensor's callback when detecting in hardware.
+  std::atomic<bool> near_ = false;
 
-    static ProximityStateChange GetEvent(Edge edge) {
-      return {edge == Edge::kRising};
-    }
-  };
+  ProximityCalibrator calibrator_;
 
-  PubSubHysteresisEdgeDetector<ProxSamplerPubSub> edge_detector_;
+  PW_METRIC_GROUP(metrics_, "proximity");
+  PW_METRIC(metrics_, far_threshold_, "far threshold", 0u);
+  PW_METRIC(metrics_, near_threshold_, "near threshold", 0u);
+  PW_METRIC(metrics_, baseline_, "baseline", 0u);
+  PW_METRIC(metrics_, noise_, "noise", 0u);
+  PW_METRIC(metrics_, adjustments_, "threshold adjustments", 0u);
 };
 
 }  // namespace sense
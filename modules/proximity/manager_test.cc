@@ -0,0 +1,108 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/proximity/manager.h"
+
+#include "modules/proximity/fake_sensor.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/worker/test_worker.h"
+#include "pw_containers/vector.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+constexpr uint16_t kInactiveThreshold = 1000;
+constexpr uint16_t kActiveThreshold = 2000;
+constexpr uint16_t kFar = 0;
+constexpr uint16_t kNear = 5000;
+
+class ProximityManagerTest : public ::testing::Test {
+ protected:
+  using TestPubSub = GenericPubSubBuffer<Event, 8, 4>;
+
+  ProximityManagerTest() : pubsub_(worker_) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(pubsub_.SubscribeTo<ProximityStateChange>(
+        [this](ProximityStateChange event) {
+          changes_.push_back(event.proximity);
+        }));
+  }
+
+  void TearDown() override { worker_.Stop(); }
+
+  // Waits for published events, and any events their subscribers publish, to
+  // be delivered.
+  void Flush() {
+    for (int i = 0; i < 2; ++i) {
+      pw::sync::ThreadNotification notification;
+      worker_.RunOnce([&notification]() { notification.release(); });
+      notification.acquire();
+    }
+  }
+
+  void PublishSample(uint16_t sample) {
+    ASSERT_TRUE(pubsub_.Publish(ProximitySample{.sample = sample}));
+    Flush();
+  }
+
+  TestWorker<> worker_;
+  TestPubSub pubsub_;
+  FakeProximitySensor sensor_;
+
+  // Only touched by subscribers on the worker, and read after a `Flush`.
+  pw::Vector<bool, 8> changes_;
+};
+
+TEST_F(ProximityManagerTest, FallsBackToSampleEdges) {
+  ProximityManager manager(
+      pubsub_, sensor_, kInactiveThreshold, kActiveThreshold);
+  EXPECT_FALSE(manager.uses_sensor_thresholds());
+
+  PublishSample(kFar);
+  PublishSample(kNear);
+  PublishSample(kNear);
+  PublishSample(kFar);
+
+  ASSERT_EQ(changes_.size(), 2u);
+  EXPECT_TRUE(changes_[0]);
+  EXPECT_FALSE(changes_[1]);
+}
+
+TEST_F(ProximityManagerTest, PublishesSensorTransitions) {
+  sensor_.set_detects_thresholds(true);
+  ProximityManager manager(
+      pubsub_, sensor_, kInactiveThreshold, kActiveThreshold);
+  EXPECT_TRUE(manager.uses_sensor_thresholds());
+  EXPECT_EQ(sensor_.inactive_threshold(), kInactiveThreshold);
+  EXPECT_EQ(sensor_.active_threshold(), kActiveThreshold);
+
+  // Samples only calibrate the thresholds; the sensor reports transitions.
+  PublishSample(kNear);
+  EXPECT_TRUE(changes_.empty());
+
+  sensor_.TriggerThreshold(true);
+  Flush();
+  sensor_.TriggerThreshold(false);
+  Flush();
+
+  ASSERT_EQ(changes_.size(), 2u);
+  EXPECT_TRUE(changes_[0]);
+  EXPECT_FALSE(changes_[1]);
+}
+
+}  // namespace
+}  // namespace sense
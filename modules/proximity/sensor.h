@@ -13,7 +13,12 @@
 // the License.
 #pragma once
 
+#include <cstdint>
+#include <utility>
+
+#include "pw_function/function.h"
 #include "pw_result/result.h"
+#include "pw_status/status.h"
 
 namespace sense {
 
@@ -36,6 +41,46 @@ class ProximitySensor {
   /// case to understand these values.
   virtual pw::Result<uint16_t> ReadSample() { return DoReadProxSample(); }
 
+  /// Called with whether an object is now near. Sensors call it from a thread,
+  /// never from interrupt context.
+  using ThresholdCallback = pw::Function<void(bool near)>;
+
+  /// Has the sensor detect proximity transitions itself, with the same
+  /// hysteresis as `HysteresisEdgeDetector`: an object becomes near when
+  /// samples rise above `active_threshold` and far when they fall to
+  /// `inactive_threshold` or below. Detection runs while the sensor is
+  /// enabled, and `ReadSample` continues to work.
+  ///
+  /// Sensors may finish configuring themselves asynchronously, so this may be
+  /// called before the scheduler starts.
+  ///
+  /// @returns
+  /// * @OK - Transitions will be reported through `callback`.
+  /// * @UNIMPLEMENTED - The sensor cannot detect thresholds in hardware.
+  pw::Status EnableThresholdDetection(uint16_t inactive_threshold,
+                                      uint16_t active_threshold,
+                                      ThresholdCallback&& callback) {
+    return DoEnableThresholdDetection(
+        inactive_threshold, active_threshold, std::move(callback));
+  }
+
+  /// Changes the thresholds of running threshold detection, without
+  /// resetting whether an object is near.
+  ///
+  /// @returns
+  /// * @OK - The new thresholds take effect shortly.
+  /// * @FAILED_PRECONDITION - Threshold detection is not enabled.
+  /// * @UNIMPLEMENTED - The sensor cannot detect thresholds in hardware.
+  pw::Status SetThresholds(uint16_t inactive_threshold,
+                           uint16_t active_threshold) {
+    return DoSetThresholds(inactive_threshold, active_threshold);
+  }
+
+  /// Stops reporting transitions.
+  pw::Status DisableThresholdDetection() {
+    return DoDisableThresholdDetection();
+  }
+
  protected:
   // Prohibit polymorphic destruction for now.
   ~ProximitySensor() = default;
@@ -44,6 +89,19 @@ class ProximitySensor {
   virtual pw::Status DoEnableProximitySensor() = 0;
   virtual pw::Status DoDisableProximitySensor() = 0;
   virtual pw::Result<uint16_t> DoReadProxSample() = 0;
+
+  virtual pw::Status DoEnableThresholdDetection(uint16_t, uint16_t,
+                                                ThresholdCallback&&) {
+    return pw::Status::Unimplemented();
+  }
+
+  virtual pw::Status DoSetThresholds(uint16_t, uint16_t) {
+    return pw::Status::Unimplemented();
+  }
+
+  virtual pw::Status DoDisableThresholdDetection() {
+    return pw::Status::Unimplemented();
+  }
 };
 
 }  // namespace sense
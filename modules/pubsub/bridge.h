@@ -0,0 +1,70 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "modules/pubsub/pubsub.h"
+
+namespace sense {
+
+/// Forwards events of `Types` from one PubSub bus to another.
+///
+/// Each bus keeps its own queue, subscriber table and worker, so a bridge lets
+/// a busy bus share only the events that the other bus's subscribers need.
+/// Events are republished from the source bus's worker, with their own
+/// payload reference; if the destination queue is full they are dropped and
+/// counted.
+///
+/// A type must only be bridged in one direction between two buses, or its
+/// events would circulate forever.
+template <typename Event, typename... Types>
+class PubSubBridge {
+ public:
+  static_assert(sizeof...(Types) > 0, "A bridge must forward some events");
+
+  constexpr PubSubBridge() = default;
+
+  PubSubBridge(const PubSubBridge&) = delete;
+  PubSubBridge& operator=(const PubSubBridge&) = delete;
+
+  /// Starts forwarding from `from` to `to`. Returns false if `from` has no
+  /// free subscriber slot.
+  [[nodiscard]] bool Init(GenericPubSub<Event>& from,
+                          GenericPubSub<Event>& to) {
+    to_ = &to;
+    return from
+        .template SubscribeToAny<Types...>(
+            [this](const Event& event) { Forward(event); })
+        .has_value();
+  }
+
+  /// Events that could not be forwarded because the destination was full.
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  void Forward(const Event& event) {
+    // The source bus releases its reference after this returns.
+    RetainPayload(event);
+    if (!to_->Publish(event)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  GenericPubSub<Event>* to_ = nullptr;
+  std::atomic<uint32_t> dropped_ = 0;
+};
+
+}  // namespace sense
@@ -0,0 +1,129 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "modules/pubsub/bridge.h"
+
+#include <variant>
+
+#include "modules/worker/test_worker.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+// Test fixtures.
+
+struct Sample {
+  int value;
+};
+
+struct Command {
+  int value;
+};
+
+struct Status {
+  int value;
+};
+
+using TestEvent = std::variant<Sample, Command, Status>;
+using TestPubSub = sense::GenericPubSubBuffer<TestEvent, 4, 4>;
+
+class PubSubBridgeTest : public ::testing::Test {
+ protected:
+  PubSubBridgeTest() : data_(data_worker_), control_(control_worker_) {}
+
+  void TearDown() override {
+    data_worker_.Stop();
+    control_worker_.Stop();
+  }
+
+  sense::TestWorker<> data_worker_;
+  sense::TestWorker<> control_worker_;
+  TestPubSub data_;
+  TestPubSub control_;
+  pw::sync::ThreadNotification notification_;
+};
+
+// Unit tests.
+
+TEST_F(PubSubBridgeTest, ForwardsOnlyBridgedTypes) {
+  sense::PubSubBridge<TestEvent, Sample, Status> bridge;
+  ASSERT_TRUE(bridge.Init(data_, control_));
+
+  int samples = 0;
+  int others = 0;
+  ASSERT_TRUE(control_.Subscribe([&](const TestEvent& event) {
+    if (const Sample* sample = std::get_if<Sample>(&event)) {
+      samples += sample->value;
+    } else if (std::holds_alternative<Status>(event)) {
+      notification_.release();
+    } else {
+      ++others;
+    }
+  }));
+
+  ASSERT_TRUE(data_.Publish(Sample{.value = 3}));
+  ASSERT_TRUE(data_.Publish(Command{.value = 100}));
+  ASSERT_TRUE(data_.Publish(Sample{.value = 4}));
+  ASSERT_TRUE(data_.Publish(Status{.value = 0}));
+  notification_.acquire();
+
+  EXPECT_EQ(samples, 7);
+  EXPECT_EQ(others, 0);
+  EXPECT_EQ(bridge.dropped(), 0u);
+}
+
+TEST_F(PubSubBridgeTest, BridgesInBothDirections) {
+  sense::PubSubBridge<TestEvent, Sample> up;
+  sense::PubSubBridge<TestEvent, Command> down;
+  ASSERT_TRUE(up.Init(data_, control_));
+  ASSERT_TRUE(down.Init(control_, data_));
+
+  int commands = 0;
+  ASSERT_TRUE(data_.SubscribeTo<Command>([&](const Command& command) {
+    commands += command.value;
+    notification_.release();
+  }));
+
+  ASSERT_TRUE(control_.Publish(Command{.value = 5}));
+  notification_.acquire();
+  EXPECT_EQ(commands, 5);
+}
+
+TEST_F(PubSubBridgeTest, CountsDroppedEvents) {
+  sense::PubSubBridge<TestEvent, Sample> bridge;
+  ASSERT_TRUE(bridge.Init(data_, control_));
+  ASSERT_TRUE(data_.SubscribeTo<Status>(
+      [this](const Status&) { notification_.release(); }));
+
+  // Hold the control bus so that its queue fills up.
+  pw::sync::ThreadNotification pause;
+  control_worker_.RunOnce([&pause]() { pause.acquire(); });
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(data_.Publish(Sample{.value = i}));
+  }
+  ASSERT_TRUE(data_.Publish(Status{.value = 0}));
+  notification_.acquire();
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(data_.Publish(Sample{.value = i}));
+  }
+  ASSERT_TRUE(data_.Publish(Status{.value = 0}));
+  notification_.acquire();
+  pause.release();
+
+  // The control queue holds four of the six samples.
+  EXPECT_EQ(bridge.dropped(), 2u);
+}
+
+}  // namespace
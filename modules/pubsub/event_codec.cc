@@ -0,0 +1,430 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/pubsub/event_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+
+namespace sense {
+namespace {
+
+// Each event type specializes `Codec` with its oneof tag and conversions in
+// both directions. `Event` alternatives without a specialization fail to
+// compile, so the two directions cannot drift apart.
+template <typename T>
+struct Codec;
+
+using EventUnion = decltype(pubsub_Event::type);
+
+int64_t ToMicroseconds(pw::chrono::SystemClock::time_point timestamp) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             timestamp.time_since_epoch())
+      .count();
+}
+
+pw::chrono::SystemClock::time_point FromMicroseconds(int64_t timestamp_us) {
+  return pw::chrono::SystemClock::time_point(
+      std::chrono::duration_cast<pw::chrono::SystemClock::duration>(
+          std::chrono::microseconds(timestamp_us)));
+}
+
+template <pb_size_t kTagValue, typename Button, bool EventUnion::*kField>
+struct ButtonCodec {
+  static constexpr pb_size_t kTag = kTagValue;
+  static void Encode(const Button& button, pubsub_Event& proto) {
+    proto.type.*kField = button.pressed();
+  }
+  static pw::Result<Button> Decode(const pubsub_Event& proto) {
+    return Button(proto.type.*kField);
+  }
+};
+
+template <>
+struct Codec<ButtonA>
+    : ButtonCodec<pubsub_Event_button_a_pressed_tag,
+                  ButtonA,
+                  &EventUnion::button_a_pressed> {};
+template <>
+struct Codec<ButtonB>
+    : ButtonCodec<pubsub_Event_button_b_pressed_tag,
+                  ButtonB,
+                  &EventUnion::button_b_pressed> {};
+template <>
+struct Codec<ButtonX>
+    : ButtonCodec<pubsub_Event_button_x_pressed_tag,
+                  ButtonX,
+                  &EventUnion::button_x_pressed> {};
+template <>
+struct Codec<ButtonY>
+    : ButtonCodec<pubsub_Event_button_y_pressed_tag,
+                  ButtonY,
+                  &EventUnion::button_y_pressed> {};
+
+template <>
+struct Codec<TimerRequest> {
+  static constexpr pb_size_t kTag = pubsub_Event_timer_request_tag;
+  static void Encode(const TimerRequest& request, pubsub_Event& proto) {
+    proto.type.timer_request.token = request.token;
+    proto.type.timer_request.timeout_ms = request.timeout_ms;
+    proto.type.timer_request.period_ms = request.period_ms;
+  }
+  static pw::Result<TimerRequest> Decode(const pubsub_Event& proto) {
+    return TimerRequest{
+        .token = proto.type.timer_request.token,
+        .timeout_ms = proto.type.timer_request.timeout_ms,
+        .period_ms = proto.type.timer_request.period_ms,
+    };
+  }
+};
+
+template <>
+struct Codec<TimerExpired> {
+  static constexpr pb_size_t kTag = pubsub_Event_timer_expired_tag;
+  static void Encode(const TimerExpired& expired, pubsub_Event& proto) {
+    proto.type.timer_expired.token = expired.token;
+  }
+  static pw::Result<TimerExpired> Decode(const pubsub_Event& proto) {
+    return TimerExpired{.token = proto.type.timer_expired.token};
+  }
+};
+
+template <>
+struct Codec<TimerCancel> {
+  static constexpr pb_size_t kTag = pubsub_Event_timer_cancel_tag;
+  static void Encode(const TimerCancel& cancel, pubsub_Event& proto) {
+    proto.type.timer_cancel.token = cancel.token;
+  }
+  static pw::Result<TimerCancel> Decode(const pubsub_Event& proto) {
+    return TimerCancel{.token = proto.type.timer_cancel.token};
+  }
+};
+
+template <>
+struct Codec<ButtonGesture> {
+  static constexpr pb_size_t kTag = pubsub_Event_button_gesture_tag;
+  static void Encode(const ButtonGesture& gesture, pubsub_Event& proto) {
+    auto& out = proto.type.button_gesture;
+    switch (gesture.kind) {
+      case ButtonGesture::kPress:
+        out.kind = pubsub_ButtonGesture_Kind_PRESS;
+        break;
+      case ButtonGesture::kLongPress:
+        out.kind = pubsub_ButtonGesture_Kind_LONG_PRESS;
+        break;
+      case ButtonGesture::kRepeat:
+        out.kind = pubsub_ButtonGesture_Kind_REPEAT;
+        break;
+      case ButtonGesture::kChord:
+        out.kind = pubsub_ButtonGesture_Kind_CHORD;
+        break;
+    }
+    out.buttons = gesture.buttons;
+    out.count = gesture.count;
+  }
+  static pw::Result<ButtonGesture> Decode(const pubsub_Event& proto) {
+    const auto& in = proto.type.button_gesture;
+    ButtonGesture::Kind kind;
+    switch (in.kind) {
+      case pubsub_ButtonGesture_Kind_PRESS:
+        kind = ButtonGesture::kPress;
+        break;
+      case pubsub_ButtonGesture_Kind_LONG_PRESS:
+        kind = ButtonGesture::kLongPress;
+        break;
+      case pubsub_ButtonGesture_Kind_REPEAT:
+        kind = ButtonGesture::kRepeat;
+        break;
+      case pubsub_ButtonGesture_Kind_CHORD:
+        kind = ButtonGesture::kChord;
+        break;
+      default:
+        return pw::Status::InvalidArgument();
+    }
+    if (in.buttons > 0xf || in.count > UINT8_MAX) {
+      return pw::Status::InvalidArgument();
+    }
+    return ButtonGesture{
+        .kind = kind,
+        .buttons = static_cast<uint8_t>(in.buttons),
+        .count = static_cast<uint8_t>(in.count),
+    };
+  }
+};
+
+template <>
+struct Codec<ProximityStateChange> {
+  static constexpr pb_size_t kTag = pubsub_Event_proximity_tag;
+  static void Encode(const ProximityStateChange& change, pubsub_Event& proto) {
+    proto.type.proximity = change.proximity;
+  }
+  static pw::Result<ProximityStateChange> Decode(const pubsub_Event& proto) {
+    return ProximityStateChange{.proximity = proto.type.proximity};
+  }
+};
+
+template <>
+struct Codec<ProximitySample> {
+  static constexpr pb_size_t kTag = pubsub_Event_proximity_level_tag;
+  static void Encode(const ProximitySample& sample, pubsub_Event& proto) {
+    proto.type.proximity_level = sample.sample;
+    proto.timestamp_us = ToMicroseconds(sample.timestamp);
+  }
+  static pw::Result<ProximitySample> Decode(const pubsub_Event& proto) {
+    return ProximitySample{
+        .sample = static_cast<uint16_t>(proto.type.proximity_level),
+        .timestamp = FromMicroseconds(proto.timestamp_us),
+    };
+  }
+};
+
+template <>
+struct Codec<AmbientLightSample> {
+  static constexpr pb_size_t kTag = pubsub_Event_ambient_light_lux_tag;
+  static void Encode(const AmbientLightSample& sample, pubsub_Event& proto) {
+    proto.type.ambient_light_lux = sample.sample_lux;
+    proto.timestamp_us = ToMicroseconds(sample.timestamp);
+  }
+  static pw::Result<AmbientLightSample> Decode(const pubsub_Event& proto) {
+    return AmbientLightSample{
+        .sample_lux = proto.type.ambient_light_lux,
+        .timestamp = FromMicroseconds(proto.timestamp_us),
+    };
+  }
+};
+
+static_assert(static_cast<int>(IaqAccuracy::kStabilizing) ==
+              pubsub_IaqEstimate_Accuracy_STABILIZING);
+static_assert(static_cast<int>(IaqAccuracy::kHigh) ==
+              pubsub_IaqEstimate_Accuracy_HIGH);
+
+template <>
+struct Codec<AirQuality> {
+  static constexpr pb_size_t kTag = pubsub_Event_air_quality_tag;
+  static void Encode(const AirQuality& air_quality, pubsub_Event& proto) {
+    proto.type.air_quality = air_quality.score;
+    proto.timestamp_us = ToMicroseconds(air_quality.timestamp);
+    proto.warming_up = air_quality.warming_up;
+    if (air_quality.iaq.has_value()) {
+      proto.has_iaq = true;
+      proto.iaq.index = air_quality.iaq->index;
+      proto.iaq.co2_ppm = air_quality.iaq->co2_ppm;
+      proto.iaq.accuracy =
+          static_cast<pubsub_IaqEstimate_Accuracy>(air_quality.iaq->accuracy);
+    }
+  }
+  static pw::Result<AirQuality> Decode(const pubsub_Event& proto) {
+    AirQuality air_quality{
+        .score = static_cast<uint16_t>(proto.type.air_quality),
+        .timestamp = FromMicroseconds(proto.timestamp_us),
+        .warming_up = proto.warming_up,
+    };
+    if (proto.has_iaq) {
+      if (proto.iaq.index > UINT16_MAX || proto.iaq.co2_ppm > UINT16_MAX ||
+          proto.iaq.accuracy < pubsub_IaqEstimate_Accuracy_STABILIZING ||
+          proto.iaq.accuracy > pubsub_IaqEstimate_Accuracy_HIGH) {
+        return pw::Status::InvalidArgument();
+      }
+      air_quality.iaq = IaqEstimate{
+          .index = static_cast<uint16_t>(proto.iaq.index),
+          .co2_ppm = static_cast<uint16_t>(proto.iaq.co2_ppm),
+          .accuracy = static_cast<IaqAccuracy>(proto.iaq.accuracy),
+      };
+    }
+    return air_quality;
+  }
+};
+
+template <>
+struct Codec<MorseEncodeRequest> {
+  static constexpr pb_size_t kTag = pubsub_Event_morse_encode_request_tag;
+  static void Encode(const MorseEncodeRequest& request, pubsub_Event& proto) {
+    auto& msg = proto.type.morse_encode_request.msg;
+    msg[request.payload.str().copy(msg, sizeof(msg) - 1)] = '\0';
+    proto.type.morse_encode_request.repeat = request.repeat;
+  }
+  static pw::Result<MorseEncodeRequest> Decode(const pubsub_Event&) {
+    // The message would need a payload pool to be copied into, and the codec
+    // does not own one.
+    return pw::Status::Unimplemented();
+  }
+};
+
+template <>
+struct Codec<MorseCodeValue> {
+  static constexpr pb_size_t kTag = pubsub_Event_morse_code_value_tag;
+  static void Encode(const MorseCodeValue& value, pubsub_Event& proto) {
+    proto.type.morse_code_value.turn_on = value.turn_on;
+    proto.type.morse_code_value.message_finished = value.message_finished;
+  }
+  static pw::Result<MorseCodeValue> Decode(const pubsub_Event& proto) {
+    return MorseCodeValue{
+        .turn_on = proto.type.morse_code_value.turn_on,
+        .message_finished = proto.type.morse_code_value.message_finished,
+    };
+  }
+};
+
+static_assert(static_cast<int>(AirQualityRating::kInvalid) ==
+              state_manager_AirQualityRating_AIR_QUALITY_RATING_INVALID);
+static_assert(static_cast<int>(AirQualityRating::kSuperb) ==
+              state_manager_AirQualityRating_AIR_QUALITY_RATING_SUPERB);
+
+template <>
+struct Codec<SenseState> {
+  static constexpr pb_size_t kTag = pubsub_Event_sense_state_tag;
+  static void Encode(const SenseState& state, pubsub_Event& proto) {
+    proto.type.sense_state.alarm_active = state.alarm;
+    proto.type.sense_state.alarm_threshold = state.alarm_threshold;
+    proto.type.sense_state.aq_score = state.air_quality;
+    proto.type.sense_state.aq_rating =
+        static_cast<state_manager_AirQualityRating>(state.air_quality_rating);
+  }
+  static pw::Result<SenseState> Decode(const pubsub_Event& proto) {
+    const auto rating = proto.type.sense_state.aq_rating;
+    if (rating < state_manager_AirQualityRating_AIR_QUALITY_RATING_INVALID ||
+        rating > state_manager_AirQualityRating_AIR_QUALITY_RATING_SUPERB) {
+      return pw::Status::InvalidArgument();
+    }
+    return SenseState{
+        .alarm = proto.type.sense_state.alarm_active,
+        .alarm_threshold =
+            static_cast<uint16_t>(proto.type.sense_state.alarm_threshold),
+        .air_quality = static_cast<uint16_t>(proto.type.sense_state.aq_score),
+        .air_quality_rating = static_cast<AirQualityRating>(rating),
+    };
+  }
+};
+
+template <>
+struct Codec<StateManagerControl> {
+  static constexpr pb_size_t kTag = pubsub_Event_state_manager_control_tag;
+  static void Encode(const StateManagerControl& control, pubsub_Event& proto) {
+    auto& action = proto.type.state_manager_control.action;
+    switch (control.action) {
+      case StateManagerControl::kDecrementThreshold:
+        action = pubsub_StateManagerControl_Action_DECREMENT_THRESHOLD;
+        break;
+      case StateManagerControl::kIncrementThreshold:
+        action = pubsub_StateManagerControl_Action_INCREMENT_THRESHOLD;
+        break;
+      case StateManagerControl::kSilenceAlarms:
+        action = pubsub_StateManagerControl_Action_SILENCE_ALARMS;
+        break;
+    }
+  }
+  static pw::Result<StateManagerControl> Decode(const pubsub_Event& proto) {
+    switch (proto.type.state_manager_control.action) {
+      case pubsub_StateManagerControl_Action_DECREMENT_THRESHOLD:
+        return StateManagerControl(StateManagerControl::kDecrementThreshold);
+      case pubsub_StateManagerControl_Action_INCREMENT_THRESHOLD:
+        return StateManagerControl(StateManagerControl::kIncrementThreshold);
+      case pubsub_StateManagerControl_Action_SILENCE_ALARMS:
+        return StateManagerControl(StateManagerControl::kSilenceAlarms);
+      case pubsub_StateManagerControl_Action_UNKNOWN:
+        break;
+    }
+    return pw::Status::InvalidArgument();
+  }
+};
+
+template <>
+struct Codec<AirMeasurement> {
+  static constexpr pb_size_t kTag = pubsub_Event_air_measurement_tag;
+  static void Encode(const AirMeasurement& measurement, pubsub_Event& proto) {
+    auto& out = proto.type.air_measurement;
+    out.temperature = measurement.temperature();
+    out.pressure = measurement.pressure;
+    out.humidity = measurement.humidity();
+    out.gas_resistance = measurement.gas_resistance;
+    out.score = measurement.score;
+    proto.timestamp_us = ToMicroseconds(measurement.timestamp);
+  }
+  static pw::Result<AirMeasurement> Decode(const pubsub_Event& proto) {
+    const auto& in = proto.type.air_measurement;
+    return AirMeasurement{
+        .temperature_centi_c =
+            static_cast<int16_t>(std::lround(in.temperature * 100.f)),
+        .humidity_centi_percent =
+            static_cast<uint16_t>(std::lround(in.humidity * 100.f)),
+        .score = static_cast<uint16_t>(in.score),
+        .pressure = in.pressure,
+        .gas_resistance = in.gas_resistance,
+        .timestamp = FromMicroseconds(proto.timestamp_us),
+    };
+  }
+};
+
+using Decoder = pw::Result<Event> (*)(const pubsub_Event&);
+
+template <typename T>
+pw::Result<Event> DecodeAs(const pubsub_Event& proto) {
+  pw::Result<T> result = Codec<T>::Decode(proto);
+  if (!result.ok()) {
+    return result.status();
+  }
+  return Event(*result);
+}
+
+// Decoders indexed by oneof tag. Tags without an event type are null.
+template <size_t... kIndices>
+constexpr auto MakeDecoders(std::index_sequence<kIndices...>) {
+  constexpr pb_size_t kMaxTag =
+      std::max({Codec<std::variant_alternative_t<kIndices, Event>>::kTag...});
+  std::array<Decoder, kMaxTag + 1> decoders{};
+  ((decoders[Codec<std::variant_alternative_t<kIndices, Event>>::kTag] =
+        &DecodeAs<std::variant_alternative_t<kIndices, Event>>),
+   ...);
+  return decoders;
+}
+
+constexpr auto kDecoders =
+    MakeDecoders(std::make_index_sequence<std::variant_size_v<Event>>());
+
+}  // namespace
+
+pb_size_t EventTag(const Event& event) {
+  return std::visit(
+      [](const auto& value) {
+        return Codec<std::decay_t<decltype(value)>>::kTag;
+      },
+      event);
+}
+
+pubsub_Event EventToProto(const Event& event) {
+  pubsub_Event proto = pubsub_Event_init_default;
+  std::visit(
+      [&proto](const auto& value) {
+        using EventCodec = Codec<std::decay_t<decltype(value)>>;
+        proto.which_type = EventCodec::kTag;
+        EventCodec::Encode(value, proto);
+      },
+      event);
+  return proto;
+}
+
+pw::Result<Event> ProtoToEvent(const pubsub_Event& proto) {
+  if (proto.which_type >= kDecoders.size() ||
+      kDecoders[proto.which_type] == nullptr) {
+    return pw::Status::Unimplemented();
+  }
+  return kDecoders[proto.which_type](proto);
+}
+
+}  // namespace sense
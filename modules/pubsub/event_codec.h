@@ -0,0 +1,34 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/pubsub/pubsub_pb/pubsub.pb.h"
+#include "pw_result/result.h"
+
+namespace sense {
+
+/// Returns the `pubsub.Event` oneof field number used for an event.
+pb_size_t EventTag(const Event& event);
+
+/// Converts an event to its protobuf representation.
+pubsub_Event EventToProto(const Event& event);
+
+/// Converts a protobuf event to an `Event`.
+///
+/// Returns INVALID_ARGUMENT for malformed events and UNIMPLEMENTED for event
+/// types that cannot be published remotely.
+pw::Result<Event> ProtoToEvent(const pubsub_Event& proto);
+
+}  // namespace sense
@@ -0,0 +1,190 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/pubsub/event_codec.h"
+
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+template <typename T>
+T RoundTrip(const T& value, pb_size_t expected_tag) {
+  pubsub_Event proto = sense::EventToProto(value);
+  EXPECT_EQ(proto.which_type, expected_tag);
+  pw::Result<sense::Event> event = sense::ProtoToEvent(proto);
+  EXPECT_EQ(event.status(), pw::OkStatus());
+  EXPECT_TRUE(std::holds_alternative<T>(*event));
+  return std::get<T>(*event);
+}
+
+TEST(EventCodecTest, Buttons) {
+  EXPECT_TRUE(RoundTrip(sense::ButtonA(true), pubsub_Event_button_a_pressed_tag)
+                  .pressed());
+  EXPECT_FALSE(
+      RoundTrip(sense::ButtonB(false), pubsub_Event_button_b_pressed_tag)
+          .pressed());
+  EXPECT_TRUE(RoundTrip(sense::ButtonX(true), pubsub_Event_button_x_pressed_tag)
+                  .pressed());
+  EXPECT_TRUE(RoundTrip(sense::ButtonY(true), pubsub_Event_button_y_pressed_tag)
+                  .pressed());
+}
+
+TEST(EventCodecTest, ButtonGesture) {
+  auto gesture =
+      RoundTrip(sense::ButtonGesture{.kind = sense::ButtonGesture::kPress,
+                                     .buttons = sense::ButtonGesture::kButtonA,
+                                     .count = 2},
+                pubsub_Event_button_gesture_tag);
+  EXPECT_EQ(gesture.kind, sense::ButtonGesture::kPress);
+  EXPECT_EQ(gesture.buttons, sense::ButtonGesture::kButtonA);
+  EXPECT_EQ(gesture.count, 2u);
+
+  pubsub_Event proto = sense::EventToProto(
+      sense::ButtonGesture{.kind = sense::ButtonGesture::kChord,
+                           .buttons = 0x3});
+  proto.type.button_gesture.buttons = 0x10;
+  EXPECT_EQ(sense::ProtoToEvent(proto).status(), pw::Status::InvalidArgument());
+}
+
+TEST(EventCodecTest, Samples) {
+  EXPECT_EQ(RoundTrip(sense::ProximitySample{.sample = 1234u},
+                      pubsub_Event_proximity_level_tag)
+                .sample,
+            1234u);
+  EXPECT_EQ(RoundTrip(sense::AmbientLightSample{.sample_lux = 42.5f},
+                      pubsub_Event_ambient_light_lux_tag)
+                .sample_lux,
+            42.5f);
+  EXPECT_EQ(RoundTrip(sense::AirQuality{.score = 768u},
+                      pubsub_Event_air_quality_tag)
+                .score,
+            768u);
+  EXPECT_TRUE(RoundTrip(sense::AirQuality{.score = 512u, .warming_up = true},
+                        pubsub_Event_air_quality_tag)
+                  .warming_up);
+  EXPECT_FALSE(RoundTrip(sense::AirQuality{.score = 512u},
+                         pubsub_Event_air_quality_tag)
+                   .iaq.has_value());
+}
+
+TEST(EventCodecTest, AirQualityWithIaq) {
+  auto air_quality =
+      RoundTrip(sense::AirQuality{.score = 900u,
+                                  .iaq = sense::IaqEstimate{
+                                      .index = 60u,
+                                      .co2_ppm = 880u,
+                                      .accuracy = sense::IaqAccuracy::kMedium,
+                                  }},
+                pubsub_Event_air_quality_tag);
+  ASSERT_TRUE(air_quality.iaq.has_value());
+  EXPECT_EQ(air_quality.iaq->index, 60u);
+  EXPECT_EQ(air_quality.iaq->co2_ppm, 880u);
+  EXPECT_EQ(air_quality.iaq->accuracy, sense::IaqAccuracy::kMedium);
+
+  pubsub_Event proto = sense::EventToProto(air_quality);
+  proto.iaq.accuracy = static_cast<pubsub_IaqEstimate_Accuracy>(4);
+  EXPECT_EQ(sense::ProtoToEvent(proto).status(), pw::Status::InvalidArgument());
+}
+
+TEST(EventCodecTest, AirMeasurement) {
+  const sense::AirMeasurement original = {
+      .temperature_centi_c = 2150,
+      .humidity_centi_percent = 4025,
+      .score = 700u,
+      .pressure = 101.3f,
+      .gas_resistance = 52000.f,
+  };
+  auto measurement = RoundTrip(original, pubsub_Event_air_measurement_tag);
+  EXPECT_EQ(measurement.temperature_centi_c, 2150);
+  EXPECT_EQ(measurement.humidity_centi_percent, 4025u);
+  EXPECT_EQ(measurement.score, 700u);
+  EXPECT_EQ(measurement.pressure, 101.3f);
+  EXPECT_EQ(measurement.gas_resistance, 52000.f);
+
+  pubsub_Event proto = sense::EventToProto(measurement);
+  EXPECT_FLOAT_EQ(proto.type.air_measurement.temperature, 21.5f);
+  EXPECT_FLOAT_EQ(proto.type.air_measurement.humidity, 40.25f);
+}
+
+TEST(EventCodecTest, SampleTimestamps) {
+  const auto timestamp = pw::chrono::SystemClock::time_point(
+      std::chrono::duration_cast<pw::chrono::SystemClock::duration>(
+          std::chrono::milliseconds(12345)));
+
+  pubsub_Event proto = sense::EventToProto(
+      sense::ProximitySample{.sample = 1u, .timestamp = timestamp});
+  EXPECT_EQ(proto.timestamp_us, 12'345'000);
+  EXPECT_EQ(RoundTrip(sense::AmbientLightSample{.sample_lux = 1.f,
+                                                .timestamp = timestamp},
+                      pubsub_Event_ambient_light_lux_tag)
+                .timestamp,
+            timestamp);
+  EXPECT_EQ(RoundTrip(sense::AirQuality{.score = 1u, .timestamp = timestamp},
+                      pubsub_Event_air_quality_tag)
+                .timestamp,
+            timestamp);
+}
+
+TEST(EventCodecTest, Timers) {
+  auto request = RoundTrip(
+      sense::TimerRequest{.token = 7u, .timeout_ms = 300u, .period_ms = 50u},
+      pubsub_Event_timer_request_tag);
+  EXPECT_EQ(request.token, 7u);
+  EXPECT_EQ(request.timeout_ms, 300u);
+  EXPECT_EQ(request.period_ms, 50u);
+  EXPECT_EQ(RoundTrip(sense::TimerExpired{.token = 9u},
+                      pubsub_Event_timer_expired_tag)
+                .token,
+            9u);
+  EXPECT_EQ(RoundTrip(sense::TimerCancel{.token = 11u},
+                      pubsub_Event_timer_cancel_tag)
+                .token,
+            11u);
+}
+
+TEST(EventCodecTest, StateManagerControl) {
+  auto control = RoundTrip(
+      sense::StateManagerControl(sense::StateManagerControl::kSilenceAlarms),
+      pubsub_Event_state_manager_control_tag);
+  EXPECT_EQ(control.action, sense::StateManagerControl::kSilenceAlarms);
+
+  pubsub_Event proto = pubsub_Event_init_default;
+  proto.which_type = pubsub_Event_state_manager_control_tag;
+  proto.type.state_manager_control.action =
+      pubsub_StateManagerControl_Action_UNKNOWN;
+  EXPECT_EQ(sense::ProtoToEvent(proto).status(), pw::Status::InvalidArgument());
+}
+
+TEST(EventCodecTest, MorseEncodeRequestIsEncodeOnly) {
+  sense::PayloadPoolBuffer<4, 1> pool;
+  pw::Result<sense::Payload> message = pool.Allocate("SOS");
+  ASSERT_EQ(message.status(), pw::OkStatus());
+  pubsub_Event proto = sense::EventToProto(
+      sense::MorseEncodeRequest{.payload = *message, .repeat = 2u});
+  message->Release();
+  ASSERT_EQ(proto.which_type, pubsub_Event_morse_encode_request_tag);
+  EXPECT_STREQ(proto.type.morse_encode_request.msg, "SOS");
+  EXPECT_EQ(proto.type.morse_encode_request.repeat, 2u);
+  EXPECT_EQ(sense::ProtoToEvent(proto).status(), pw::Status::Unimplemented());
+}
+
+TEST(EventCodecTest, UnknownTag) {
+  pubsub_Event proto = pubsub_Event_init_default;
+  proto.which_type = 0;
+  EXPECT_EQ(sense::ProtoToEvent(proto).status(), pw::Status::Unimplemented());
+}
+
+}  // namespace
@@ -0,0 +1,89 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+namespace sense {
+
+/// Bounded queue with one producer and one consumer that may run on different
+/// cores.
+///
+/// Unlike `MpscQueue`, this never uses atomic read-modify-write operations,
+/// only ordered loads and stores. Cores without exclusive-access instructions,
+/// such as the RP2040's Cortex-M0+, implement those by masking interrupts,
+/// which does not exclude the other core. `push` must only be called from the
+/// producer's context and `pop` from the consumer's.
+///
+/// The capacity must be a power of two.
+template <typename T, size_t kCapacity>
+class InterCoreQueue {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "InterCoreQueue elements must be trivially copyable");
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                "InterCoreQueue capacity must be a power of two");
+  static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                "InterCoreQueue needs lock-free 32-bit loads and stores");
+
+  constexpr InterCoreQueue() = default;
+
+  InterCoreQueue(const InterCoreQueue&) = delete;
+  InterCoreQueue& operator=(const InterCoreQueue&) = delete;
+
+  /// Adds a value to the back of the queue. Returns false if it is full.
+  [[nodiscard]] bool push(const T& value) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      return false;
+    }
+    slots_[tail & kMask] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Removes the value at the front of the queue, if there is one.
+  std::optional<T> pop() {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+    T value = slots_[head & kMask];
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  /// Returns whether the queue is empty. Only exact when called from the
+  /// consumer.
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return kCapacity; }
+
+ private:
+  static constexpr uint32_t kMask = kCapacity - 1;
+
+  std::array<T, kCapacity> slots_{};
+  std::atomic<uint32_t> head_ = 0;
+  std::atomic<uint32_t> tail_ = 0;
+};
+
+}  // namespace sense
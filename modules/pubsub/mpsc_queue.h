@@ -0,0 +1,142 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+#include "pw_assert/check.h"
+#include "pw_span/span.h"
+
+namespace sense {
+
+/// Bounded lock-free queue with any number of producers and a single consumer.
+///
+/// Producers never take a lock, so `push` may be called from interrupts as
+/// well as threads; it only fails when the queue is full. `pop` must only be
+/// called from one context at a time.
+///
+/// On cores without exclusive load/store, such as the RP2040's Cortex-M0+, the
+/// compiler lowers `compare_exchange_weak` to `__atomic_*` library calls. This
+/// module does not provide them; the toolchain or SDK runtime must, and for
+/// `push` to be interrupt-safe they must be too.
+///
+/// The capacity must be a power of two.
+template <typename T>
+class MpscQueue {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MpscQueue elements must be trivially copyable");
+
+  class Slot {
+   private:
+    friend class MpscQueue;
+
+    std::atomic<size_t> sequence_ = 0;
+    alignas(T) std::byte storage_[sizeof(T)];
+  };
+
+  explicit MpscQueue(pw::span<Slot> slots)
+      : slots_(slots), mask_(slots.size() - 1) {
+    PW_CHECK(!slots.empty() && (slots.size() & mask_) == 0,
+             "MpscQueue capacity must be a power of two");
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  /// Adds a value to the back of the queue. Returns false if it is full.
+  [[nodiscard]] bool push(const T& value) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[position & mask_];
+      size_t sequence = slot.sequence_.load(std::memory_order_acquire);
+      auto diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          new (slot.storage_) T(value);
+          slot.sequence_.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Removes the value at the front of the queue, if one is ready.
+  std::optional<T> pop() {
+    Slot& slot = slots_[head_ & mask_];
+    size_t sequence = slot.sequence_.load(std::memory_order_acquire);
+    if (sequence != head_ + 1) {
+      return std::nullopt;
+    }
+    T value = *std::launder(reinterpret_cast<T*>(slot.storage_));
+    slot.sequence_.store(head_ + slots_.size(), std::memory_order_release);
+    ++head_;
+    return value;
+  }
+
+  /// Returns whether the consumer has nothing ready to pop. Only meaningful
+  /// when called from the consumer.
+  bool empty() const {
+    const Slot& slot = slots_[head_ & mask_];
+    return slot.sequence_.load(std::memory_order_acquire) != head_ + 1;
+  }
+
+  constexpr size_t capacity() const { return slots_.size(); }
+
+ private:
+  pw::span<Slot> slots_;
+  const size_t mask_;
+  std::atomic<size_t> tail_ = 0;
+  size_t head_ = 0;
+};
+
+namespace internal {
+
+// Holds the slots of an `MpscQueueBuffer`. This is a base class so that the
+// slots are constructed before `MpscQueue` initializes their sequences.
+template <typename T, size_t kCapacity>
+struct MpscQueueStorage {
+  std::array<typename MpscQueue<T>::Slot, kCapacity> slots;
+};
+
+}  // namespace internal
+
+/// `MpscQueue` with its own storage.
+template <typename T, size_t kCapacity>
+class MpscQueueBuffer : private internal::MpscQueueStorage<T, kCapacity>,
+                        public MpscQueue<T> {
+ public:
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                "MpscQueue capacity must be a power of two");
+
+  MpscQueueBuffer()
+      : MpscQueue<T>(internal::MpscQueueStorage<T, kCapacity>::slots) {}
+};
+
+}  // namespace sense
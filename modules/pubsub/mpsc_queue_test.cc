@@ -0,0 +1,55 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/pubsub/mpsc_queue.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+TEST(MpscQueueTest, PushAndPopInOrder) {
+  sense::MpscQueueBuffer<uint32_t, 4> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.push(1u));
+  EXPECT_TRUE(queue.push(2u));
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(queue.pop(), 1u);
+  EXPECT_EQ(queue.pop(), 2u);
+  EXPECT_FALSE(queue.pop().has_value());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, PushFailsWhenFull) {
+  sense::MpscQueueBuffer<uint32_t, 2> queue;
+  EXPECT_TRUE(queue.push(1u));
+  EXPECT_TRUE(queue.push(2u));
+  EXPECT_FALSE(queue.push(3u));
+  EXPECT_EQ(queue.pop(), 1u);
+  EXPECT_TRUE(queue.push(3u));
+  EXPECT_EQ(queue.pop(), 2u);
+  EXPECT_EQ(queue.pop(), 3u);
+}
+
+TEST(MpscQueueTest, WrapsAround) {
+  sense::MpscQueueBuffer<uint32_t, 4> queue;
+  for (uint32_t i = 0; i < 64; ++i) {
+    ASSERT_TRUE(queue.push(i));
+    ASSERT_TRUE(queue.push(i + 100));
+    EXPECT_EQ(queue.pop(), i);
+    EXPECT_EQ(queue.pop(), i + 100);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
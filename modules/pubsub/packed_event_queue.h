@@ -0,0 +1,223 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <variant>
+
+#include "pw_assert/assert.h"
+#include "pw_bytes/span.h"
+
+namespace sense {
+namespace internal {
+
+template <typename Event>
+struct PackedEventTraits {
+  static constexpr size_t kTypes = 1;
+  static constexpr std::array<size_t, 1> kSizes = {sizeof(Event)};
+
+  static constexpr size_t Index(const Event&) { return 0; }
+
+  template <typename Function>
+  static void Visit(const Event& event, Function&& function) {
+    function(event);
+  }
+
+  template <typename Function>
+  static Event Make(size_t, Function&& read) {
+    return read.template operator()<Event>();
+  }
+};
+
+template <typename... Types>
+struct PackedEventTraits<std::variant<Types...>> {
+  using Event = std::variant<Types...>;
+
+  static_assert(sizeof...(Types) <= 256, "Event tags must fit in a byte");
+
+  static constexpr size_t kTypes = sizeof...(Types);
+  static constexpr std::array<size_t, kTypes> kSizes = {sizeof(Types)...};
+
+  static constexpr size_t Index(const Event& event) { return event.index(); }
+
+  template <typename Function>
+  static void Visit(const Event& event, Function&& function) {
+    std::visit(function, event);
+  }
+
+  template <typename Function>
+  static Event Make(size_t index, Function&& read) {
+    return MakeAt(index, read, std::index_sequence_for<Types...>());
+  }
+
+ private:
+  template <typename Function, size_t... kIndices>
+  static Event MakeAt(size_t index,
+                      Function& read,
+                      std::index_sequence<kIndices...>) {
+    using Maker = Event (*)(Function&);
+    static constexpr Maker kMakers[] = {[](Function& f) {
+      using T = std::variant_alternative_t<kIndices, Event>;
+      return Event(std::in_place_index<kIndices>, f.template operator()<T>());
+    }...};
+    return kMakers[index](read);
+  }
+};
+
+}  // namespace internal
+
+/// FIFO of events packed into a byte ring.
+///
+/// Each entry is a one-byte type tag followed by the bytes of that type only,
+/// rather than a whole `Event`, so a queue sized for a few of the largest
+/// events holds many more of the small ones that make up most traffic. Events
+/// must be trivially copyable.
+template <typename Event>
+class PackedEventQueue {
+ public:
+  using Traits = internal::PackedEventTraits<Event>;
+
+  /// Bytes taken by an entry of the largest event type.
+  static constexpr size_t kMaxEntrySize =
+      1 + *std::max_element(Traits::kSizes.begin(), Traits::kSizes.end());
+
+  /// Returns the bytes `event` takes in the queue.
+  static constexpr size_t EntrySize(const Event& event) {
+    return 1 + Traits::kSizes[Traits::Index(event)];
+  }
+
+  explicit constexpr PackedEventQueue(pw::ByteSpan storage)
+      : storage_(storage) {}
+
+  PackedEventQueue(const PackedEventQueue&) = delete;
+  PackedEventQueue& operator=(const PackedEventQueue&) = delete;
+
+  constexpr bool empty() const { return size_ == 0; }
+
+  /// Returns the number of queued events.
+  constexpr size_t size() const { return size_; }
+
+  /// Returns how many of the largest events fit in an empty queue.
+  constexpr size_t max_size() const {
+    return storage_.size() / kMaxEntrySize;
+  }
+
+  /// Returns the number of free bytes.
+  constexpr size_t available_bytes() const {
+    return storage_.size() - used_bytes_;
+  }
+
+  /// Appends `event`. Returns false if there is not room for it.
+  [[nodiscard]] bool push_back(const Event& event) {
+    const size_t entry_size = EntrySize(event);
+    if (entry_size > available_bytes()) {
+      return false;
+    }
+    const size_t offset = Wrap(head_ + used_bytes_);
+    storage_[offset] = std::byte(Traits::Index(event));
+    WriteValueAt(Wrap(offset + 1), event);
+    used_bytes_ += entry_size;
+    ++size_;
+    return true;
+  }
+
+  /// Returns a copy of the oldest event. The queue must not be empty.
+  Event front() const {
+    PW_ASSERT(!empty());
+    return ReadAt(head_);
+  }
+
+  /// Removes the oldest event. The queue must not be empty.
+  void pop_front() {
+    PW_ASSERT(!empty());
+    const size_t entry_size = 1 + Traits::kSizes[TagAt(head_)];
+    head_ = Wrap(head_ + entry_size);
+    used_bytes_ -= entry_size;
+    --size_;
+  }
+
+  /// Overwrites the oldest queued event of the same type as `event`, which
+  /// keeps its place in the queue. Returns the event that was replaced, if
+  /// there was one.
+  std::optional<Event> Replace(const Event& event) {
+    const size_t tag = Traits::Index(event);
+    size_t offset = head_;
+    for (size_t i = 0; i < size_; ++i) {
+      const size_t queued_tag = TagAt(offset);
+      if (queued_tag == tag) {
+        Event replaced = ReadAt(offset);
+        WriteValueAt(Wrap(offset + 1), event);
+        return replaced;
+      }
+      offset = Wrap(offset + 1 + Traits::kSizes[queued_tag]);
+    }
+    return std::nullopt;
+  }
+
+ private:
+  constexpr size_t Wrap(size_t offset) const {
+    return offset < storage_.size() ? offset : offset - storage_.size();
+  }
+
+  size_t TagAt(size_t offset) const {
+    return static_cast<size_t>(storage_[offset]);
+  }
+
+  void WriteValueAt(size_t offset, const Event& event) {
+    Traits::Visit(event, [this, offset](const auto& value) {
+      const auto bytes =
+          std::bit_cast<std::array<std::byte, sizeof(value)>>(value);
+      const size_t first = std::min(bytes.size(), storage_.size() - offset);
+      std::copy_n(bytes.begin(), first, storage_.begin() + offset);
+      std::copy(bytes.begin() + first, bytes.end(), storage_.begin());
+    });
+  }
+
+  Event ReadAt(size_t offset) const {
+    const size_t data = Wrap(offset + 1);
+    return Traits::Make(TagAt(offset), [this, data]<typename T>() {
+      // Entries may wrap around the end of the ring.
+      std::array<std::byte, sizeof(T)> bytes;
+      const size_t first = std::min(bytes.size(), storage_.size() - data);
+      std::copy_n(storage_.begin() + data, first, bytes.begin());
+      std::copy_n(
+          storage_.begin(), bytes.size() - first, bytes.begin() + first);
+      return std::bit_cast<T>(bytes);
+    });
+  }
+
+  pw::ByteSpan storage_;
+  size_t head_ = 0;
+  size_t used_bytes_ = 0;
+  size_t size_ = 0;
+};
+
+/// `PackedEventQueue` with room for at least `kMinEvents` events of any type.
+template <typename Event, size_t kMinEvents>
+class PackedEventQueueBuffer : public PackedEventQueue<Event> {
+ public:
+  constexpr PackedEventQueueBuffer() : PackedEventQueue<Event>(storage_) {}
+
+ private:
+  std::array<std::byte, kMinEvents * PackedEventQueue<Event>::kMaxEntrySize>
+      storage_;
+};
+
+}  // namespace sense
@@ -0,0 +1,100 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "modules/pubsub/packed_event_queue.h"
+
+#include <cstdint>
+#include <variant>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+struct Small {
+  uint8_t value;
+};
+
+struct Large {
+  uint32_t a;
+  uint32_t b;
+};
+
+using Event = std::variant<Small, Large>;
+using Queue = sense::PackedEventQueue<Event>;
+
+static_assert(Queue::kMaxEntrySize == 1 + sizeof(Large));
+
+TEST(PackedEventQueueTest, PushAndPopInOrder) {
+  sense::PackedEventQueueBuffer<Event, 2> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.push_back(Small{.value = 1}));
+  EXPECT_TRUE(queue.push_back(Large{.a = 2, .b = 3}));
+  EXPECT_EQ(queue.size(), 2u);
+
+  Event first = queue.front();
+  queue.pop_front();
+  ASSERT_TRUE(std::holds_alternative<Small>(first));
+  EXPECT_EQ(std::get<Small>(first).value, 1u);
+
+  Event second = queue.front();
+  queue.pop_front();
+  ASSERT_TRUE(std::holds_alternative<Large>(second));
+  EXPECT_EQ(std::get<Large>(second).a, 2u);
+  EXPECT_EQ(std::get<Large>(second).b, 3u);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(PackedEventQueueTest, SmallEventsArePacked) {
+  sense::PackedEventQueueBuffer<Event, 2> queue;
+  EXPECT_EQ(queue.max_size(), 2u);
+
+  // Each small entry takes 2 bytes of the 18.
+  for (uint8_t i = 0; i < 9; ++i) {
+    EXPECT_TRUE(queue.push_back(Small{.value = i}));
+  }
+  EXPECT_FALSE(queue.push_back(Small{.value = 9}));
+  EXPECT_EQ(queue.size(), 9u);
+  EXPECT_EQ(queue.available_bytes(), 0u);
+}
+
+TEST(PackedEventQueueTest, EntriesWrapAroundTheRing) {
+  sense::PackedEventQueueBuffer<Event, 2> queue;
+  for (uint32_t round = 0; round < 10; ++round) {
+    ASSERT_TRUE(queue.push_back(Small{.value = 7}));
+    ASSERT_TRUE(queue.push_back(Large{.a = round, .b = ~round}));
+    queue.pop_front();
+
+    Event event = queue.front();
+    queue.pop_front();
+    ASSERT_TRUE(std::holds_alternative<Large>(event));
+    EXPECT_EQ(std::get<Large>(event).a, round);
+    EXPECT_EQ(std::get<Large>(event).b, ~round);
+  }
+}
+
+TEST(PackedEventQueueTest, ReplaceKeepsPosition) {
+  sense::PackedEventQueueBuffer<Event, 2> queue;
+  ASSERT_TRUE(queue.push_back(Large{.a = 1, .b = 1}));
+  ASSERT_TRUE(queue.push_back(Small{.value = 2}));
+
+  std::optional<Event> replaced = queue.Replace(Small{.value = 3});
+  ASSERT_TRUE(replaced.has_value());
+  EXPECT_EQ(std::get<Small>(*replaced).value, 2u);
+  EXPECT_EQ(queue.size(), 2u);
+
+  queue.pop_front();
+  EXPECT_EQ(std::get<Small>(queue.front()).value, 3u);
+  EXPECT_FALSE(queue.Replace(Large{.a = 4, .b = 4}).has_value());
+}
+
+}  // namespace
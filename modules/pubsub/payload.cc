@@ -0,0 +1,72 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "modules/pubsub/payload.h"
+
+#include <algorithm>
+
+#include "pw_assert/check.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+pw::ConstByteSpan Payload::bytes() const {
+  if (pool_ == nullptr) {
+    return {};
+  }
+  return pool_->blocks_.subspan(index_ * pool_->block_size_, size_);
+}
+
+void Payload::Retain() const {
+  if (pool_ != nullptr) {
+    pool_->references_[index_].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Payload::Release() const {
+  if (pool_ != nullptr) {
+    const uint16_t previous =
+        pool_->references_[index_].fetch_sub(1, std::memory_order_acq_rel);
+    PW_CHECK_UINT_NE(previous, 0, "Payload released more often than retained");
+  }
+}
+
+bool Payload::unique() const {
+  return pool_ != nullptr &&
+         pool_->references_[index_].load(std::memory_order_acquire) == 1;
+}
+
+pw::Result<Payload> PayloadPool::Allocate(pw::ConstByteSpan data) {
+  if (data.size() > block_size_) {
+    return pw::Status::OutOfRange();
+  }
+  for (size_t i = 0; i < references_.size(); ++i) {
+    uint16_t expected = 0;
+    if (references_[i].compare_exchange_strong(
+            expected, 1, std::memory_order_acquire)) {
+      std::copy(data.begin(), data.end(), blocks_.begin() + i * block_size_);
+      return Payload(
+          *this, static_cast<uint16_t>(i), static_cast<uint16_t>(data.size()));
+    }
+  }
+  return pw::Status::ResourceExhausted();
+}
+
+size_t PayloadPool::available() const {
+  return static_cast<size_t>(
+      std::count_if(references_.begin(), references_.end(), [](auto& count) {
+        return count.load(std::memory_order_relaxed) == 0;
+      }));
+}
+
+}  // namespace sense
@@ -0,0 +1,174 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <variant>
+
+#include "pw_bytes/span.h"
+#include "pw_result/result.h"
+#include "pw_span/span.h"
+
+namespace sense {
+
+class PayloadPool;
+
+/// Handle to a reference-counted block of a `PayloadPool`.
+///
+/// Handles are trivially copyable so that events can carry them through
+/// PubSub. Copying a handle does not take a reference; `GenericPubSub` holds
+/// the one the publisher passes in and releases it after the last subscriber
+/// has run. Subscribers read the payload in place, and call `Retain` if they
+/// need it after their callback returns.
+class Payload {
+ public:
+  constexpr Payload() = default;
+
+  constexpr bool has_value() const { return pool_ != nullptr; }
+  constexpr size_t size() const { return size_; }
+
+  /// Returns the payload's contents, which are empty if there is none.
+  pw::ConstByteSpan bytes() const;
+
+  /// Returns the payload's contents as text.
+  std::string_view str() const {
+    pw::ConstByteSpan data = bytes();
+    return std::string_view(reinterpret_cast<const char*>(data.data()),
+                            data.size());
+  }
+
+  /// Takes another reference to the block. Does nothing if there is none.
+  void Retain() const;
+
+  /// Drops a reference, returning the block to its pool after the last one.
+  /// Does nothing if there is no block.
+  void Release() const;
+
+  /// Returns whether this is the only reference to the block, so that no
+  /// event in flight carries it. False if there is no block.
+  bool unique() const;
+
+ private:
+  friend class PayloadPool;
+
+  constexpr Payload(PayloadPool& pool, uint16_t index, uint16_t size)
+      : pool_(&pool), index_(index), size_(size) {}
+
+  PayloadPool* pool_ = nullptr;
+  uint16_t index_ = 0;
+  uint16_t size_ = 0;
+};
+
+/// Fixed-size blocks for the payloads of large events, such as batches of
+/// samples or text, which would otherwise have to be copied with every event.
+///
+/// Allocation and release are lock-free, so payloads may be published from
+/// interrupts.
+class PayloadPool {
+ public:
+  PayloadPool(const PayloadPool&) = delete;
+  PayloadPool& operator=(const PayloadPool&) = delete;
+
+  /// Copies `data` into a free block. The returned payload holds the only
+  /// reference to it.
+  ///
+  /// @returns  RESOURCE_EXHAUSTED if every block is in use, or OUT_OF_RANGE if
+  ///           `data` does not fit in a block.
+  pw::Result<Payload> Allocate(pw::ConstByteSpan data);
+
+  pw::Result<Payload> Allocate(std::string_view text) {
+    return Allocate(pw::as_bytes(pw::span(text)));
+  }
+
+  size_t block_size() const { return block_size_; }
+
+  /// Returns how many blocks are free.
+  size_t available() const;
+
+ protected:
+  PayloadPool(pw::ByteSpan blocks,
+              pw::span<std::atomic<uint16_t>> references,
+              size_t block_size)
+      : blocks_(blocks), references_(references), block_size_(block_size) {}
+
+ private:
+  friend class Payload;
+
+  pw::ByteSpan blocks_;
+  pw::span<std::atomic<uint16_t>> references_;
+  const size_t block_size_;
+};
+
+/// `PayloadPool` with its own storage.
+template <size_t kBlockSize, size_t kBlocks>
+class PayloadPoolBuffer : public PayloadPool {
+ public:
+  static_assert(kBlockSize > 0 && kBlockSize <= UINT16_MAX);
+  static_assert(kBlocks > 0 && kBlocks <= UINT16_MAX);
+
+  PayloadPoolBuffer() : PayloadPool(blocks_, references_, kBlockSize) {}
+
+ private:
+  std::array<std::byte, kBlockSize * kBlocks> blocks_;
+  std::array<std::atomic<uint16_t>, kBlocks> references_{};
+};
+
+/// Events that carry a payload hold it in a `Payload` member named `payload`.
+template <typename T>
+concept EventWithPayload = requires(const T& event) {
+  { event.payload } -> std::convertible_to<const Payload&>;
+};
+
+namespace internal {
+
+template <typename T, typename Function>
+void ForEventPayload(const T& event, Function&& function) {
+  if constexpr (EventWithPayload<T>) {
+    function(event.payload);
+  }
+}
+
+template <typename... Types, typename Function>
+void ForEventPayload(const std::variant<Types...>& event,
+                     Function&& function) {
+  // Buses whose events never carry payloads skip the visit entirely.
+  if constexpr ((EventWithPayload<Types> || ...)) {
+    std::visit(
+        [&function](const auto& value) { ForEventPayload(value, function); },
+        event);
+  }
+}
+
+}  // namespace internal
+
+/// Takes another reference to the payload that `event` carries, if any.
+template <typename Event>
+void RetainPayload(const Event& event) {
+  internal::ForEventPayload(event,
+                            [](const Payload& payload) { payload.Retain(); });
+}
+
+/// Releases the payload reference that `event` carries, if any.
+template <typename Event>
+void ReleasePayload(const Event& event) {
+  internal::ForEventPayload(event,
+                            [](const Payload& payload) { payload.Release(); });
+}
+
+}  // namespace sense
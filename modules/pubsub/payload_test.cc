@@ -0,0 +1,161 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "modules/pubsub/payload.h"
+
+#include "modules/pubsub/pubsub.h"
+#include "modules/worker/test_worker.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+// Test fixtures.
+
+struct Text {
+  sense::Payload payload;
+};
+
+struct Tick {
+  uint32_t count;
+};
+
+using TestEvent = std::variant<Text, Tick>;
+
+class PayloadTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kBlockSize = 8;
+  static constexpr size_t kBlocks = 2;
+
+  void TearDown() override { worker_.Stop(); }
+
+  sense::TestWorker<> worker_;
+  sense::PayloadPoolBuffer<kBlockSize, kBlocks> pool_;
+  pw::sync::ThreadNotification notification_;
+};
+
+// Unit tests.
+
+TEST_F(PayloadTest, Allocate_CopiesData) {
+  pw::Result<sense::Payload> payload = pool_.Allocate("hello");
+  ASSERT_EQ(payload.status(), pw::OkStatus());
+  EXPECT_EQ(payload->str(), "hello");
+  EXPECT_EQ(payload->size(), 5u);
+  EXPECT_EQ(pool_.available(), kBlocks - 1);
+
+  payload->Release();
+  EXPECT_EQ(pool_.available(), kBlocks);
+}
+
+TEST_F(PayloadTest, Allocate_FailsWhenFullOrTooLarge) {
+  EXPECT_EQ(pool_.Allocate("too long!").status(), pw::Status::OutOfRange());
+
+  pw::Result<sense::Payload> first = pool_.Allocate("a");
+  pw::Result<sense::Payload> second = pool_.Allocate("b");
+  ASSERT_EQ(first.status(), pw::OkStatus());
+  ASSERT_EQ(second.status(), pw::OkStatus());
+  EXPECT_EQ(pool_.Allocate("c").status(), pw::Status::ResourceExhausted());
+
+  second->Release();
+  pw::Result<sense::Payload> third = pool_.Allocate("c");
+  ASSERT_EQ(third.status(), pw::OkStatus());
+  EXPECT_EQ(first->str(), "a");
+  EXPECT_EQ(third->str(), "c");
+  first->Release();
+  third->Release();
+}
+
+TEST_F(PayloadTest, Retain_KeepsBlockUntilLastRelease) {
+  pw::Result<sense::Payload> payload = pool_.Allocate("x");
+  ASSERT_EQ(payload.status(), pw::OkStatus());
+  EXPECT_TRUE(payload->unique());
+  payload->Retain();
+  EXPECT_FALSE(payload->unique());
+  payload->Release();
+  EXPECT_TRUE(payload->unique());
+  EXPECT_EQ(pool_.available(), kBlocks - 1);
+  payload->Release();
+  EXPECT_EQ(pool_.available(), kBlocks);
+}
+
+TEST_F(PayloadTest, PubSub_ReleasesAfterLastSubscriber) {
+  sense::GenericPubSubBuffer<TestEvent, 4, 3> pubsub(worker_);
+  std::string_view first_seen;
+  sense::Payload kept;
+  ASSERT_TRUE(pubsub.SubscribeTo<Text>([&](const Text& text) {
+    first_seen = text.payload.str();
+    EXPECT_EQ(pool_.available(), kBlocks - 1);
+  }));
+  ASSERT_TRUE(pubsub.SubscribeTo<Text>([&](const Text& text) {
+    text.payload.Retain();
+    kept = text.payload;
+  }));
+  ASSERT_TRUE(pubsub.SubscribeTo<Tick>(
+      [this](const Tick&) { notification_.release(); }));
+
+  pw::Result<sense::Payload> payload = pool_.Allocate("SOS");
+  ASSERT_EQ(payload.status(), pw::OkStatus());
+  ASSERT_TRUE(pubsub.Publish(Text{.payload = *payload}));
+  ASSERT_TRUE(pubsub.Publish(Tick{.count = 1}));
+  notification_.acquire();
+
+  EXPECT_EQ(first_seen, "SOS");
+  EXPECT_EQ(pool_.available(), kBlocks - 1);
+  EXPECT_EQ(kept.str(), "SOS");
+  kept.Release();
+  EXPECT_EQ(pool_.available(), kBlocks);
+}
+
+TEST_F(PayloadTest, PubSub_ReleasesDroppedEvents) {
+  sense::GenericPubSubBuffer<TestEvent, 1, 1> pubsub(worker_);
+  ASSERT_TRUE(pubsub.SubscribeTo<Tick>(
+      [this](const Tick&) { notification_.release(); }));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub.Publish(Tick{.count = 1}));
+
+  pw::Result<sense::Payload> payload = pool_.Allocate("lost");
+  ASSERT_EQ(payload.status(), pw::OkStatus());
+  EXPECT_FALSE(pubsub.Publish(Text{.payload = *payload}));
+  EXPECT_EQ(pool_.available(), kBlocks);
+
+  pause.release();
+  notification_.acquire();
+}
+
+TEST_F(PayloadTest, PubSub_ReleasesReplacedConflatedEvents) {
+  using PubSub = sense::GenericPubSubBuffer<TestEvent, 2, 1>;
+  PubSub pubsub(worker_, 0, PubSub::EventMaskOf<Text>());
+  std::string_view seen;
+  ASSERT_TRUE(pubsub.SubscribeTo<Text>([&](const Text& text) {
+    seen = text.payload.str();
+    notification_.release();
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  pw::Result<sense::Payload> old_text = pool_.Allocate("old");
+  pw::Result<sense::Payload> new_text = pool_.Allocate("new");
+  ASSERT_EQ(old_text.status(), pw::OkStatus());
+  ASSERT_EQ(new_text.status(), pw::OkStatus());
+  ASSERT_TRUE(pubsub.Publish(Text{.payload = *old_text}));
+  ASSERT_TRUE(pubsub.Publish(Text{.payload = *new_text}));
+  EXPECT_EQ(pool_.available(), kBlocks - 1);
+
+  pause.release();
+  notification_.acquire();
+  EXPECT_EQ(seen, "new");
+}
+
+}  // namespace
@@ -14,16 +14,28 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <mutex>
 #include <optional>
 #include <type_traits>
 #include <variant>
 
+#include "modules/pubsub/mpsc_queue.h"
+#include "modules/pubsub/packed_event_queue.h"
+#include "modules/pubsub/payload.h"
+#include "modules/pubsub/pubsub_metrics.h"
+#include "modules/pubsub/pubsub_trace.h"
+#include "modules/profiling/gpio_markers.h"
+#include "modules/pubsub/static_subscribers.h"
 #include "modules/worker/worker.h"
-#include "pw_containers/inline_deque.h"
+#include "pw_assert/assert.h"
+#include "pw_chrono/system_clock.h"
 #include "pw_function/function.h"
 #include "pw_sync/interrupt_spin_lock.h"
 #include "pw_sync/lock_annotations.h"
+#include "pw_trace/trace.h"
 
 namespace sense {
 
@@ -31,19 +43,59 @@ template <typename EventType>
 class GenericPubSub {
  public:
   using Event = EventType;
-  using SubscribeCallback = pw::Function<void(Event)>;
+  /// Receives a reference to the queued event, which is only valid for the
+  /// duration of the call.
+  using SubscribeCallback = pw::Function<void(const Event&)>;
   using SubscribeToken = size_t;
+  using EventQueue = PackedEventQueue<Event>;
+
+  /// Bitmask of `std::variant` alternative indices a subscriber receives.
+  using EventMask = uint32_t;
+  static constexpr EventMask kAllEvents = ~EventMask(0);
 
   struct Subscriber {
     SubscribeToken token = kUnassignedSubscribeToken;
+    EventMask event_mask = kAllEvents;
     SubscribeCallback callback = nullptr;
+    // Dispatch sequence number when the slot was last unsubscribed. If odd, a
+    // dispatch that may still call `callback` was in flight.
+    uint32_t retired_at = 0;
   };
 
+  /// Most subscriber slots a bus can have.
+  static constexpr size_t kMaxSubscriberSlots = 32;
+
+  /// @param interrupt_queue Optional lock-free queue used by
+  /// `PublishFromInterrupt`. Without it, interrupt publishers contend for the
+  /// same lock as thread publishers and may fail spuriously.
+  /// @param priority_queue Optional queue for the event types in
+  /// `priority_events`. It is drained ahead of `event_queue`, so those events
+  /// do not wait behind bulk traffic.
+  /// @param conflated_events Event types for which only the latest value
+  /// matters. Publishing one while another of the same type is still queued
+  /// overwrites the queued event instead of taking a new slot.
+  /// @param critical_events Event types that must not be lost to bulk traffic.
+  /// @param reserved_slots Room at the end of each thread queue, in events of
+  /// the largest type, that only `critical_events` may take, so that a queue
+  /// filled by other events still accepts them. Must be smaller than every
+  /// queue's `max_size`.
   GenericPubSub(Worker& worker,
-                pw::InlineDeque<Event>& event_queue,
-                pw::span<Subscriber> subscribers)
+                EventQueue& event_queue,
+                pw::span<Subscriber> subscribers,
+                MpscQueue<Event>* interrupt_queue = nullptr,
+                EventQueue* priority_queue = nullptr,
+                EventMask priority_events = 0,
+                EventMask conflated_events = 0,
+                EventMask critical_events = 0,
+                size_t reserved_slots = 0)
       : worker_(&worker),
+        interrupt_queue_(interrupt_queue),
+        priority_events_(priority_queue != nullptr ? priority_events : 0),
+        conflated_events_(conflated_events),
+        critical_events_(critical_events),
+        reserved_slots_(reserved_slots),
         event_queue_(&event_queue),
+        priority_queue_(priority_queue),
         subscribers_(subscribers),
         subscriber_count_(0),
         // Begin tokens at 1 as `kUnassignedSubscribeToken` is 0.
@@ -51,12 +103,32 @@ class GenericPubSub {
 
   /// Attempts to push an event to the event queue, returning whether it was
   /// successfully published. This is both thread safe and interrupt safe.
+  ///
+  /// If an interrupt queue was provided, this never takes a lock and only
+  /// fails when that queue is full. Events published this way may be delivered
+  /// out of order relative to events from `Publish`.
+  ///
+  /// Like `Publish`, this takes over the event's payload reference.
   [[nodiscard]] bool PublishFromInterrupt(Event event) {
+    SENSE_GPIO_MARK(kPublish);
+    if (interrupt_queue_ != nullptr) {
+      if (!interrupt_queue_->push(event)) {
+        metrics_.RecordDrop(EventIndex(event));
+        trace_.Add(PubSubTrace::Kind::kDrop, EventIndex(event), 0);
+        ReleasePayload(event);
+        return false;
+      }
+      metrics_.RecordPublish(EventIndex(event), 0);
+      trace_.Add(PubSubTrace::Kind::kPublish, EventIndex(event), 0);
+      ScheduleDrain();
+      return true;
+    }
     if (event_lock_.try_lock()) {
       bool result = PublishLocked(event);
       event_lock_.unlock();
       return result;
     }
+    ReleasePayload(event);
     return false;
   }
 
@@ -64,7 +136,12 @@ class GenericPubSub {
   /// successfully published. Unlike `PublishFromInterrupt`, this method will
   /// block until it acquires the event queue lock. This is thread safe, but it
   /// is not interrupt safe.
+  ///
+  /// If the event carries a `Payload`, the bus takes over the reference the
+  /// publisher holds, and releases it once the event has been delivered to
+  /// every subscriber, replaced by a newer conflated event, or dropped.
   [[nodiscard]] bool Publish(Event event) {
+    SENSE_GPIO_MARK(kPublish);
     std::lock_guard lock(event_lock_);
     return PublishLocked(event);
   }
@@ -78,43 +155,56 @@ class GenericPubSub {
   /// operations to not starve other callbacks or work queue tasks.
   [[nodiscard]] std::optional<SubscribeToken> Subscribe(
       SubscribeCallback&& callback) {
-    std::lock_guard lock(subscribers_lock_);
-
-    auto subscriber =
-        std::find_if(subscribers_.begin(), subscribers_.end(), [](auto& s) {
-          return s.token == kUnassignedSubscribeToken;
-        });
-    if (subscriber == subscribers_.end()) {
-      return std::nullopt;
-    }
-
-    SubscribeToken token = GenerateToken();
+    return SubscribeWithMask(kAllEvents, std::move(callback));
+  }
 
-    *subscriber = {
-        .token = token,
-        .callback = std::move(callback),
-    };
-    subscriber_count_++;
-    return token;
+  /// Returns the routing mask for the given `std::variant` alternatives.
+  template <typename... Types>
+  static constexpr EventMask EventMaskOf() {
+    static_assert(
+        IsVariant<Event>(),
+        "EventMaskOf may only be called when the event type is a std::variant");
+    return ((EventMask(1) << VariantIndex<Types, Event>::value) | ...);
   }
 
   /// If the Event is a std::variant, subscribes to only events of one type.
   ///
-  /// This is currently equivalent to checking std::holds_alternative before
-  /// invoking the callback, buy may be optimized later.
+  /// The subscriber is recorded in a per-type routing mask, so it is skipped
+  /// entirely when other event types are dispatched. `function` may take the
+  /// event by value or by `const VariantType&`; the latter avoids any copy.
   template <typename VariantType, typename Function>
   [[nodiscard]] std::optional<SubscribeToken> SubscribeTo(Function&& function) {
     static_assert(
         IsVariant<Event>(),
         "SubscribeTo may only be called when the event type is a std::variant");
-    return Subscribe([f = std::forward<Function>(function)](Event event) {
-      if (std::holds_alternative<VariantType>(event)) {
-        f(std::get<VariantType>(event));
-      }
-    });
+    constexpr size_t kIndex = VariantIndex<VariantType, Event>::value;
+    return SubscribeWithMask(
+        EventMaskOf<VariantType>(),
+        [f = std::forward<Function>(function)](const Event& event) {
+          f(Alternative<kIndex>(event));
+        });
+  }
+
+  /// If the Event is a std::variant, subscribes to events of any of the given
+  /// types. The callback receives the whole event.
+  template <typename... Types>
+  [[nodiscard]] std::optional<SubscribeToken> SubscribeToAny(
+      SubscribeCallback&& callback) {
+    return SubscribeWithMask(EventMaskOf<Types...>(), std::move(callback));
+  }
+
+  /// Routes every event to a `StaticSubscribers` list, ahead of the runtime
+  /// subscribers. Must be called before the first event is published.
+  template <typename Subscribers>
+  void SetStaticSubscribers() {
+    static_dispatch_ = &Subscribers::template Dispatch<Event>;
   }
 
   /// Unregisters a previously registered subscriber.
+  ///
+  /// The callback is not called for events dispatched after this returns. If
+  /// an event is being dispatched, it may still be running, so its slot is
+  /// only reused once that dispatch has finished.
   bool Unsubscribe(SubscribeToken token) {
     std::lock_guard lock(subscribers_lock_);
 
@@ -126,8 +216,10 @@ class GenericPubSub {
       return false;
     }
 
+    const size_t slot = static_cast<size_t>(subscriber - subscribers_.begin());
+    active_slots_.fetch_and(~(SlotMask(1) << slot));
     subscriber->token = kUnassignedSubscribeToken;
-    subscriber->callback = nullptr;
+    subscriber->retired_at = dispatch_sequence_.load();
 
     subscriber_count_--;
     return true;
@@ -140,6 +232,18 @@ class GenericPubSub {
     return subscriber_count_;
   }
 
+  /// Returns how many events the thread event queue holds at once, at least.
+  /// Smaller events are packed, so more of them fit.
+  size_t queue_capacity() const PW_NO_LOCK_SAFETY_ANALYSIS {
+    return event_queue_->max_size();
+  }
+
+  /// Returns publish, drop and dispatch timing statistics.
+  PubSubMetrics& metrics() { return metrics_; }
+
+  /// Returns the trace of recent publishes and dispatches.
+  const PubSubTrace& trace() const { return trace_; }
+
  private:
   template <typename T>
   struct IsVariant : std::false_type {};
@@ -147,6 +251,85 @@ class GenericPubSub {
   template <typename... Types>
   struct IsVariant<std::variant<Types...>> : std::true_type {};
 
+  // Index of `T` within the variant `V`. `T` must appear exactly once.
+  template <typename T, typename V>
+  struct VariantIndex;
+
+  template <typename T, typename... Types>
+  struct VariantIndex<T, std::variant<Types...>> {
+    static constexpr size_t value = [] {
+      constexpr bool kMatches[] = {std::is_same_v<T, Types>...};
+      size_t index = sizeof...(Types);
+      for (size_t i = 0; i < sizeof...(Types); ++i) {
+        if (kMatches[i]) {
+          index = i;
+        }
+      }
+      return index;
+    }();
+    static_assert(value < sizeof...(Types), "Type is not part of the variant");
+  };
+
+  // Returns the alternative at `kIndex` of an event routed by its mask bit.
+  // Routing already checked the index, and dereferencing `get_if` lets the
+  // compiler assume it matches, so no second check is made per delivery.
+  template <size_t kIndex>
+  static const std::variant_alternative_t<kIndex, Event>& Alternative(
+      const Event& event) {
+    return *std::get_if<kIndex>(&event);
+  }
+
+  // Returns the variant index of an event, or 0 if `Event` is not a variant.
+  static constexpr size_t EventIndex(const Event& event) {
+    if constexpr (IsVariant<Event>()) {
+      return event.index();
+    } else {
+      static_cast<void>(event);
+      return 0;
+    }
+  }
+
+  // Returns the routing mask bit for an event.
+  static constexpr EventMask EventBit(const Event& event) {
+    if constexpr (IsVariant<Event>()) {
+      static_assert(std::variant_size_v<Event> <= sizeof(EventMask) * 8,
+                    "Variant has too many alternatives for EventMask");
+      return EventMask(1) << EventIndex(event);
+    } else {
+      static_cast<void>(event);
+      return kAllEvents;
+    }
+  }
+
+  std::optional<SubscribeToken> SubscribeWithMask(
+      EventMask event_mask, SubscribeCallback&& callback) {
+    std::lock_guard lock(subscribers_lock_);
+
+    // A slot freed during a dispatch that is still running may still have its
+    // callback called, so it cannot be overwritten yet.
+    const uint32_t sequence = dispatch_sequence_.load();
+    auto subscriber = std::find_if(
+        subscribers_.begin(), subscribers_.end(), [sequence](auto& s) {
+          return s.token == kUnassignedSubscribeToken &&
+                 (s.retired_at % 2 == 0 || s.retired_at != sequence);
+        });
+    if (subscriber == subscribers_.end()) {
+      return std::nullopt;
+    }
+
+    SubscribeToken token = GenerateToken();
+
+    *subscriber = {
+        .token = token,
+        .event_mask = event_mask,
+        .callback = std::move(callback),
+    };
+    const size_t slot = static_cast<size_t>(subscriber - subscribers_.begin());
+    active_slots_.fetch_or(SlotMask(1) << slot);
+    subscriber_count_++;
+    return token;
+  }
+
   // Events (or their variant elements) must be standard layout and trivially
   // copyable & destructible.
   template <typename T>
@@ -177,69 +360,250 @@ class GenericPubSub {
   }
 
   bool PublishLocked(Event event) PW_EXCLUSIVE_LOCKS_REQUIRED(event_lock_) {
-    if (event_queue_->full()) {
+    const EventMask event_bit = EventBit(event);
+    EventQueue& queue =
+        (event_bit & priority_events_) != 0 ? *priority_queue_ : *event_queue_;
+
+    // An undelivered event of a conflated type is replaced in place. A drain
+    // is already pending for it.
+    if ((event_bit & queued_conflated_events_) != 0) {
+      if (std::optional<Event> replaced = queue.Replace(event)) {
+        ReleasePayload(*replaced);
+        metrics_.RecordPublish(EventIndex(event), queue.size());
+        trace_.Add(
+            PubSubTrace::Kind::kPublish, EventIndex(event), queue.size());
+        return true;
+      }
+    }
+
+    // Other events are turned away once only the reserved room is left.
+    const size_t reserved = (event_bit & critical_events_) != 0
+                                ? 0
+                                : reserved_slots_ * EventQueue::kMaxEntrySize;
+    if (EventQueue::EntrySize(event) + reserved > queue.available_bytes()) {
+      metrics_.RecordDrop(EventIndex(event));
+      trace_.Add(PubSubTrace::Kind::kDrop, EventIndex(event), queue.size());
+      ReleasePayload(event);
       return false;
     }
 
-    event_queue_->push_back(event);
-    worker_->RunOnce([this]() { NotifySubscribers(); });
+    PW_ASSERT(queue.push_back(event));
+    queued_conflated_events_ |= event_bit & conflated_events_;
+    metrics_.RecordPublish(EventIndex(event), queue.size());
+    trace_.Add(PubSubTrace::Kind::kPublish, EventIndex(event), queue.size());
+    ScheduleDrain();
     return true;
   }
 
-  void NotifySubscribers() {
-    event_lock_.lock();
+  // Only one drain task is outstanding at a time. It empties the queues, so
+  // bursts of events cost a single work queue slot. If the worker drops the
+  // drain, the flag is cleared so the next publish tries again; the events
+  // stay queued until then.
+  void ScheduleDrain() {
+    if (!drain_pending_.exchange(true, std::memory_order_acq_rel)) {
+      drain_requested_at_ = pw::chrono::SystemClock::now();
+      if (!worker_->RunOnce([this]() { DrainEvents(); })) {
+        drain_pending_.store(false, std::memory_order_release);
+      }
+    }
+  }
 
-    if (event_queue_->empty()) {
-      event_lock_.unlock();
-      return;
+  void DrainEvents() {
+    // Latency from the publish that requested this drain to its start.
+    metrics_.RecordDispatchLatency(pw::chrono::SystemClock::now() -
+                                   drain_requested_at_);
+
+    while (true) {
+      while (std::optional<Event> event = PopEvent()) {
+        NotifySubscribers(*event);
+      }
+
+      // Events published after the queues were found empty but before the
+      // flag was cleared did not schedule a drain, so check once more.
+      drain_pending_.store(false, std::memory_order_release);
+      if (QueuesEmpty() ||
+          drain_pending_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+      }
+    }
+  }
+
+  std::optional<Event> PopEvent() {
+    if (interrupt_queue_ != nullptr) {
+      if (std::optional<Event> event = interrupt_queue_->pop()) {
+        return event;
+      }
+    }
+
+    // Copy the event out of the queue so that the lock does not have to be
+    // held while running subscriber callbacks.
+    std::lock_guard lock(event_lock_);
+    EventQueue* queue = event_queue_;
+    if (priority_queue_ != nullptr && !priority_queue_->empty()) {
+      queue = priority_queue_;
+    }
+    if (queue->empty()) {
+      return std::nullopt;
     }
+    Event event = queue->front();
+    queue->pop_front();
+    queued_conflated_events_ &= ~EventBit(event);
+    return event;
+  }
+
+  bool QueuesEmpty() {
+    if (interrupt_queue_ != nullptr && !interrupt_queue_->empty()) {
+      return false;
+    }
+    std::lock_guard lock(event_lock_);
+    return event_queue_->empty() &&
+           (priority_queue_ == nullptr || priority_queue_->empty());
+  }
 
-    // Copy the event out of the queue so that the lock does not have to be held
-    // while running subscriber callbacks.
-    Event event = event_queue_->front();
-    event_queue_->pop_front();
-    event_lock_.unlock();
+  void NotifySubscribers(const Event& event) {
+    PW_TRACE_SCOPE("NotifySubscribers", "pubsub");
+    SENSE_GPIO_MARK(kNotifySubscribers);
+    const auto dispatch_start = pw::chrono::SystemClock::now();
+    const EventMask event_bit = EventBit(event);
+    if (static_dispatch_ != nullptr) {
+      static_dispatch_(event);
+    }
 
-    for (size_t i = 0; i < max_subscribers(); ++i) {
-      subscribers_lock_.lock();
-      if (subscribers_[i].token == kUnassignedSubscribeToken) {
-        subscribers_lock_.unlock();
+    // The sequence is odd while this dispatch runs, which keeps slots that are
+    // unsubscribed meanwhile from being reused. The active slots are read
+    // after it changes, so slots unsubscribed before that are skipped.
+    dispatch_sequence_.fetch_add(1);
+    for (SlotMask active = active_slots_.load(); active != 0;
+         active &= active - 1) {
+      const size_t i = static_cast<size_t>(std::countr_zero(active));
+      Subscriber& subscriber = SubscriberAt(i);
+      if ((subscriber.event_mask & event_bit) == 0) {
         continue;
       }
 
-      // As long as `token` is assigned, this subscriber cannot be overriden, so
-      // it is safe to hold onto this reference without the lock.
-      Subscriber& subscriber = subscribers_[i];
-      subscribers_lock_.unlock();
-
+      const auto start = pw::chrono::SystemClock::now();
       subscriber.callback(event);
+      metrics_.RecordCallbackTime(i, pw::chrono::SystemClock::now() - start);
     }
+    dispatch_sequence_.fetch_add(1);
+
+    trace_.Add(PubSubTrace::Kind::kDispatch,
+               EventIndex(event),
+               0,
+               pw::chrono::SystemClock::now() - dispatch_start);
+    ReleasePayload(event);
   }
 
   Worker* worker_;
+  MpscQueue<Event>* interrupt_queue_;
+  const EventMask priority_events_;
+  const EventMask conflated_events_;
+  const EventMask critical_events_;
+  const size_t reserved_slots_;
+  std::atomic<bool> drain_pending_ = false;
+  // Written only by the publisher that sets `drain_pending_`.
+  pw::chrono::SystemClock::time_point drain_requested_at_;
+  PubSubMetrics metrics_;
+  PubSubTrace trace_;
+  // Set before events are published, and only read when dispatching.
+  void (*static_dispatch_)(const Event&) = nullptr;
 
   pw::sync::InterruptSpinLock event_lock_;
-  pw::InlineDeque<Event>* event_queue_ PW_GUARDED_BY(event_lock_);
+  EventQueue* event_queue_ PW_GUARDED_BY(event_lock_);
+  EventQueue* priority_queue_ PW_GUARDED_BY(event_lock_);
+  EventMask queued_conflated_events_ PW_GUARDED_BY(event_lock_) = 0;
+
+  // A slot's `event_mask` and `callback` are written while its bit is clear,
+  // so dispatch reads them without the lock.
+  Subscriber& SubscriberAt(size_t slot) PW_NO_LOCK_SAFETY_ANALYSIS {
+    return subscribers_[slot];
+  }
 
+  using SlotMask = uint32_t;
+  static_assert(sizeof(SlotMask) * 8 == kMaxSubscriberSlots);
+
+  // Slots with a subscriber, for dispatch to iterate without locking.
+  std::atomic<SlotMask> active_slots_ = 0;
+  std::atomic<uint32_t> dispatch_sequence_ = 0;
+
+  // Serializes subscriber changes. Dispatch does not take it.
   pw::sync::InterruptSpinLock subscribers_lock_;
   pw::span<Subscriber> subscribers_ PW_GUARDED_BY(subscribers_lock_);
   size_t subscriber_count_ PW_GUARDED_BY(subscribers_lock_);
   size_t next_token_ PW_GUARDED_BY(subscribers_lock_);
 };
 
-template <typename Event, size_t kMaxEvents, size_t kMaxSubscribers>
+/// `GenericPubSub` with its own storage.
+///
+/// The thread queue has room for `kMaxEvents` events of the largest type.
+/// Events are packed by size, so it holds more of the smaller ones.
+///
+/// If `kMaxInterruptEvents` is nonzero, `PublishFromInterrupt` uses a
+/// lock-free queue of that size, which must be a power of two.
+///
+/// If `kMaxPriorityEvents` is nonzero, events in the `priority_events` mask
+/// passed to the constructor are queued separately and delivered first, in a
+/// queue sized the same way.
+/// Events in the `conflated_events` mask keep at most one queued value each.
+/// Events outside the `critical_events` mask cannot take the last
+/// `reserved_slots` of either queue.
+template <typename Event,
+          size_t kMaxEvents,
+          size_t kMaxSubscribers,
+          size_t kMaxInterruptEvents = 0,
+          size_t kMaxPriorityEvents = 0>
 class GenericPubSubBuffer : public GenericPubSub<Event> {
  public:
   using Subscriber = typename GenericPubSub<Event>::Subscriber;
   using SubscribeCallback = typename GenericPubSub<Event>::SubscribeCallback;
   using SubscribeToken = typename GenericPubSub<Event>::SubscribeToken;
-
-  constexpr GenericPubSubBuffer(Worker& worker)
-      : GenericPubSub<Event>(worker, event_queue_, subscribers_) {}
+  using EventMask = typename GenericPubSub<Event>::EventMask;
+
+  static_assert(kMaxSubscribers <= GenericPubSub<Event>::kMaxSubscriberSlots,
+                "Too many subscriber slots");
+
+  constexpr GenericPubSubBuffer(Worker& worker,
+                                EventMask priority_events = 0,
+                                EventMask conflated_events = 0,
+                                EventMask critical_events = 0,
+                                size_t reserved_slots = 0)
+      : GenericPubSub<Event>(worker,
+                             event_queue_,
+                             subscribers_,
+                             InterruptQueue(),
+                             PriorityQueue(),
+                             priority_events,
+                             conflated_events,
+                             critical_events,
+                             reserved_slots) {}
 
  private:
-  pw::InlineDeque<Event, kMaxEvents> event_queue_;
+  constexpr PackedEventQueue<Event>* PriorityQueue() {
+    if constexpr (kMaxPriorityEvents > 0) {
+      return &priority_queue_;
+    } else {
+      return nullptr;
+    }
+  }
+
+  constexpr MpscQueue<Event>* InterruptQueue() {
+    if constexpr (kMaxInterruptEvents > 0) {
+      return &interrupt_queue_;
+    } else {
+      return nullptr;
+    }
+  }
+
+  PackedEventQueueBuffer<Event, kMaxEvents> event_queue_;
   std::array<Subscriber, kMaxSubscribers> subscribers_;
+  std::conditional_t<(kMaxInterruptEvents > 0),
+                     MpscQueueBuffer<Event, kMaxInterruptEvents>,
+                     std::monostate>
+      interrupt_queue_;
+  std::conditional_t<(kMaxPriorityEvents > 0),
+                     PackedEventQueueBuffer<Event, kMaxPriorityEvents>,
+                     std::monostate>
+      priority_queue_;
 };
 
 }  // namespace sense
@@ -0,0 +1,176 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Host-side PubSub throughput and latency benchmark.
+//
+// Each configuration publishes a fixed number of events from one or more
+// producer threads into a `GenericPubSubBuffer` drained by a threaded
+// `TestWorker`. Results are printed as one JSON object per line so they can be
+// collected and compared across commits.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "modules/pubsub/pubsub.h"
+#include "modules/worker/test_worker.h"
+#include "pw_assert/check.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+  int64_t published_ns;
+};
+
+struct Other {
+  int64_t published_ns;
+};
+
+using BenchEvent = std::variant<Sample, Other>;
+
+struct Config {
+  size_t subscribers;
+  size_t producers;
+  // Percentage of subscribers that use `SubscribeTo<Sample>` rather than
+  // receiving every event.
+  size_t filtered_percent;
+  // Percentage of published events that are `Other`, which filtered
+  // subscribers skip.
+  size_t other_percent;
+};
+
+constexpr size_t kEventsPerProducer = 20'000;
+constexpr size_t kMaxSubscribers = 16;
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+template <size_t kQueueDepth>
+void Run(const Config& config) {
+  sense::TestWorker<16> worker;
+  sense::GenericPubSubBuffer<BenchEvent, kQueueDepth, kMaxSubscribers> pubsub(
+      worker);
+
+  const size_t total = kEventsPerProducer * config.producers;
+  std::vector<int64_t> latencies(total);
+  std::atomic<size_t> received = 0;
+
+  // The first subscriber always receives every event and records latency.
+  PW_CHECK(pubsub.Subscribe([&latencies, &received](const BenchEvent& event) {
+    int64_t published =
+        std::visit([](const auto& e) { return e.published_ns; }, event);
+    latencies[received.fetch_add(1)] = NowNs() - published;
+  }));
+
+  const size_t filtered =
+      (config.subscribers - 1) * config.filtered_percent / 100;
+  for (size_t i = 1; i < config.subscribers; ++i) {
+    if (i <= filtered) {
+      PW_CHECK(pubsub.template SubscribeTo<Sample>([](const Sample&) {}));
+    } else {
+      PW_CHECK(pubsub.Subscribe([](const BenchEvent&) {}));
+    }
+  }
+
+  std::atomic<size_t> dropped = 0;
+  const auto start = Clock::now();
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < config.producers; ++p) {
+    producers.emplace_back([&pubsub, &dropped, &config] {
+      for (size_t i = 0; i < kEventsPerProducer; ++i) {
+        BenchEvent event = (i * 100 / kEventsPerProducer) < config.other_percent
+                               ? BenchEvent(Other{NowNs()})
+                               : BenchEvent(Sample{NowNs()});
+        if (!pubsub.Publish(event)) {
+          dropped.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  const size_t expected = total - dropped.load();
+  while (received.load() < expected) {
+    std::this_thread::yield();
+  }
+  const auto elapsed = Clock::now() - start;
+  worker.Stop();
+
+  latencies.resize(expected);
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](size_t p) -> int64_t {
+    if (latencies.empty()) {
+      return 0;
+    }
+    return latencies[std::min(latencies.size() - 1,
+                              latencies.size() * p / 100)];
+  };
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+
+  std::printf(
+      "{\"queue_depth\": %zu, \"subscribers\": %zu, \"producers\": %zu, "
+      "\"filtered_percent\": %zu, \"other_percent\": %zu, "
+      "\"events_per_second\": %.0f, \"p50_latency_ns\": %" PRId64
+      ", \"p99_latency_ns\": %" PRId64 ", \"drop_rate\": %.4f}\n",
+      kQueueDepth,
+      config.subscribers,
+      config.producers,
+      config.filtered_percent,
+      config.other_percent,
+      static_cast<double>(expected) / seconds,
+      percentile(50),
+      percentile(99),
+      static_cast<double>(dropped.load()) / static_cast<double>(total));
+}
+
+constexpr size_t kSubscriberCounts[] = {1, 4, 10};
+constexpr size_t kProducerCounts[] = {1, 4};
+constexpr size_t kFilteredPercents[] = {0, 50, 100};
+
+template <size_t kQueueDepth>
+void RunAll() {
+  for (size_t subscribers : kSubscriberCounts) {
+    for (size_t producers : kProducerCounts) {
+      for (size_t filtered_percent : kFilteredPercents) {
+        Run<kQueueDepth>({
+            .subscribers = subscribers,
+            .producers = producers,
+            .filtered_percent = filtered_percent,
+            .other_percent = 75,
+        });
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  RunAll<4>();
+  RunAll<20>();
+  RunAll<64>();
+  return 0;
+}
@@ -13,9 +13,13 @@
 // the License.
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <variant>
 
+#include "modules/morse_code/timeline.h"
 #include "modules/pubsub/pubsub.h"
+#include "pw_chrono/system_clock.h"
 #include "pw_preprocessor/arguments.h"
 
 namespace sense {
@@ -23,13 +27,18 @@ namespace sense {
 // Base for button state changes.
 class ButtonStateChange {
  public:
-  explicit constexpr ButtonStateChange(bool is_pressed)
-      : pressed_(is_pressed) {}
+  explicit constexpr ButtonStateChange(
+      bool is_pressed, pw::chrono::SystemClock::time_point timestamp = {})
+      : pressed_(is_pressed), timestamp_(timestamp) {}
 
   bool pressed() const { return pressed_; }
 
+  /// When the change was published, or `{}` if that is not known.
+  pw::chrono::SystemClock::time_point timestamp() const { return timestamp_; }
+
  private:
   bool pressed_;
+  pw::chrono::SystemClock::time_point timestamp_;
 };
 
 // Button state changes for specific buttons.
@@ -50,6 +59,38 @@ class ButtonY : public ButtonStateChange {
   using ButtonStateChange::ButtonStateChange;
 };
 
+/// Button input recognized as a gesture, published in place of the raw
+/// button state changes when `ButtonManager` gestures are enabled.
+struct ButtonGesture {
+  enum Kind : uint8_t {
+    /// Buttons were pressed, alone or as a double tap or more.
+    kPress,
+    /// A button has been held for the long-press time.
+    kLongPress,
+    /// A button is still held after a long press, at each repeat interval.
+    kRepeat,
+    /// Several buttons were pressed together.
+    kChord,
+  };
+
+  static constexpr uint8_t kButtonA = 1u << 0;
+  static constexpr uint8_t kButtonB = 1u << 1;
+  static constexpr uint8_t kButtonX = 1u << 2;
+  static constexpr uint8_t kButtonY = 1u << 3;
+
+  Kind kind;
+
+  /// The buttons involved, as a mask of `kButtonA` through `kButtonY`.
+  uint8_t buttons;
+
+  /// Taps in quick succession for `kPress`, e.g. 2 for a double tap, or
+  /// repeats so far for `kRepeat`. 1 otherwise.
+  uint8_t count = 1;
+
+  /// When the gesture was recognized.
+  pw::chrono::SystemClock::time_point timestamp = {};
+};
+
 /// Proximity sensor state change.
 struct ProximityStateChange {
   bool proximity;
@@ -60,17 +101,78 @@ struct ProximitySample {
   /// Unspecified proximity units where 0 is the minimum (farthest) and 65535 is
   /// the maximum (nearest) value reported by the sensor.
   uint16_t sample;
+
+  /// When the sample was captured.
+  pw::chrono::SystemClock::time_point timestamp = {};
 };
 
 /// New ambient light sample in lux.
 struct AmbientLightSample {
   float sample_lux;
+
+  /// When the sample was captured.
+  pw::chrono::SystemClock::time_point timestamp = {};
+};
+
+/// How settled an indoor air quality estimate is, on BSEC's scale of 0 to 3.
+enum class IaqAccuracy : uint8_t {
+  /// The sensor is still stabilizing, so the index is not meaningful yet.
+  kStabilizing = 0,
+  /// The clean air reference is still being learned.
+  kLow = 1,
+  kMedium = 2,
+  /// The reference has had long enough to settle.
+  kHigh = 3,
+};
+
+/// BSEC-style indoor air quality estimate.
+struct IaqEstimate {
+  /// Index from 0 (excellent) to 500 (extremely polluted).
+  uint16_t index;
+
+  /// Equivalent CO2 concentration in ppm, derived from the index.
+  uint16_t co2_ppm;
+
+  IaqAccuracy accuracy;
 };
 
 /// Air quality score that combines relative humidity and gas resistance values.
 struct AirQuality {
   /// 10 bit value ranging from 0 (very poor) to 1023 (excellent).
   uint16_t score;
+
+  /// When the measurement was started.
+  pw::chrono::SystemClock::time_point timestamp = {};
+
+  /// Whether the sensor is still warming up after boot, so that the score is
+  /// not yet reliable.
+  bool warming_up = false;
+
+  /// Set when the score is derived from an `IaqModel` estimate.
+  std::optional<IaqEstimate> iaq;
+};
+
+/// Readings of a complete air measurement.
+///
+/// Temperature and humidity are stored in hundredths to keep the event, and
+/// so every queued event, small.
+struct AirMeasurement {
+  int16_t temperature_centi_c;
+  uint16_t humidity_centi_percent;
+  /// Same as the `AirQuality` score of the measurement.
+  uint16_t score;
+  float pressure;
+  float gas_resistance;
+
+  /// When the measurement was started.
+  pw::chrono::SystemClock::time_point timestamp = {};
+
+  float temperature() const {
+    return static_cast<float>(temperature_centi_c) / 100.f;
+  }
+  float humidity() const {
+    return static_cast<float>(humidity_centi_percent) / 100.f;
+  }
 };
 
 class LedValue {
@@ -93,16 +195,30 @@ class LedValue {
 
 struct TimerRequest {
   uint32_t token;
-  uint16_t timeout_s;
+  uint32_t timeout_ms;
+
+  /// If nonzero, the timer restarts with this period after each expiration,
+  /// until it is cancelled or replaced by another request.
+  uint32_t period_ms = 0;
 };
 
 struct TimerExpired {
   uint32_t token;
 };
 
+/// Stops the pending timer for `token`, if there is one.
+struct TimerCancel {
+  uint32_t token;
+};
+
 struct MorseEncodeRequest {
-  std::string_view message;
+  /// Text of the message, which subscribers read in place.
+  Payload payload;
   uint32_t repeat;
+
+  /// Precompiled timeline for `message`. If set, it is emitted instead of
+  /// compiling the message again.
+  MorseRuns runs = {};
 };
 
 struct MorseCodeValue {
@@ -110,11 +226,25 @@ struct MorseCodeValue {
   bool message_finished;
 };
 
+/// Coarse rating of an air quality score. The values match the
+/// `state_manager.AirQualityRating` proto enum, so they can be sent as-is.
+enum class AirQualityRating : uint8_t {
+  kInvalid = 0,
+  kTerrible = 1,
+  kBad = 2,
+  kMediocre = 3,
+  kOkay = 4,
+  kGood = 5,
+  kVeryGood = 6,
+  kExcellent = 7,
+  kSuperb = 8,
+};
+
 struct SenseState {
   bool alarm;
   uint16_t alarm_threshold;
   uint16_t air_quality;
-  const char* air_quality_description;
+  AirQualityRating air_quality_rating;
 };
 
 struct StateManagerControl {
@@ -142,7 +272,10 @@ using Event = std::variant<ButtonA,
                            MorseEncodeRequest,
                            MorseCodeValue,
                            SenseState,
-                           StateManagerControl>;
+                           StateManagerControl,
+                           AirMeasurement,
+                           TimerCancel,
+                           ButtonGesture>;
 
 // Index versions of Event variants, to support finding the event
 enum EventType : size_t {
@@ -160,7 +293,10 @@ enum EventType : size_t {
   kMorseCodeValue,
   kSenseState,
   kStateManagerControl,
-  kLastEventType = kStateManagerControl,
+  kAirMeasurement,
+  kTimerCancel,
+  kButtonGesture,
+  kLastEventType = kButtonGesture,
 };
 
 static_assert(kLastEventType + 1 == std::variant_size_v<Event>,
@@ -169,4 +305,63 @@ static_assert(kLastEventType + 1 == std::variant_size_v<Event>,
 // PubSub using Sense events.
 using PubSub = GenericPubSub<Event>;
 
+// User input, timers and control requests, which are queued in the priority
+// lane so they are not delayed behind sensor samples.
+inline constexpr PubSub::EventMask kPriorityEvents =
+    PubSub::EventMaskOf<ButtonA,
+                        ButtonB,
+                        ButtonX,
+                        ButtonY,
+                        ButtonGesture,
+                        TimerExpired,
+                        StateManagerControl>();
+
+// Events whose publishers treat a full queue as fatal, which always get the
+// queue slots held back from other events.
+inline constexpr PubSub::EventMask kCriticalEvents =
+    PubSub::EventMaskOf<TimerRequest,
+                        TimerExpired,
+                        TimerCancel,
+                        ProximityStateChange>();
+
+// Periodic sensor samples, for which only the newest undelivered value is
+// kept.
+inline constexpr PubSub::EventMask kConflatedEvents =
+    PubSub::EventMaskOf<ProximitySample,
+                        AmbientLightSample,
+                        AirQuality,
+                        AirMeasurement>();
+
+/// `PubSub` sized and configured as the device's control bus: user input,
+/// timers, state changes, and the sensor readings that drive them.
+class ControlPubSubBuffer
+    : public GenericPubSubBuffer<Event,
+                                 /*kMaxEvents=*/20,
+                                 /*kMaxSubscribers=*/8,
+                                 /*kMaxInterruptEvents=*/0,
+                                 /*kMaxPriorityEvents=*/8> {
+ public:
+  // Slots of each queue that bulk events such as sensor samples and Morse
+  // code values cannot take.
+  static constexpr size_t kReservedSlots = 2;
+
+  explicit ControlPubSubBuffer(Worker& worker)
+      : GenericPubSubBuffer(worker,
+                            kPriorityEvents,
+                            kConflatedEvents,
+                            kCriticalEvents,
+                            kReservedSlots) {}
+};
+
+/// `PubSub` sized and configured as the device's sensor-data bus. Every sensor
+/// event is conflated, so the queue only needs room for one of each plus
+/// whatever is bridged in.
+class SensorPubSubBuffer : public GenericPubSubBuffer<Event,
+                                                      /*kMaxEvents=*/8,
+                                                      /*kMaxSubscribers=*/6> {
+ public:
+  explicit SensorPubSubBuffer(Worker& worker)
+      : GenericPubSubBuffer(worker, /*priority_events=*/0, kConflatedEvents) {}
+};
+
 }  // namespace sense
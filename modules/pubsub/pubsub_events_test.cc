@@ -100,4 +100,217 @@ TEST_F(PubSubEventsTest, SubscribeTo) {
   EXPECT_EQ(total_score_, 1024u);
 }
 
+TEST_F(PubSubEventsTest, SubscribeToByReference) {
+  ASSERT_TRUE(pubsub_.SubscribeTo<sense::AirMeasurement>(
+      [this](const sense::AirMeasurement& measurement) {
+        total_score_ += measurement.score;
+        EXPECT_FLOAT_EQ(measurement.temperature(), 21.5f);
+        if (++events_processed_ >= 2) {
+          notification_.release();
+        }
+      }));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub_.Publish(
+      sense::AirMeasurement{.temperature_centi_c = 2150, .score = 100u}));
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  ASSERT_TRUE(pubsub_.Publish(
+      sense::AirMeasurement{.temperature_centi_c = 2150, .score = 200u}));
+  pause.release();
+
+  notification_.acquire();
+  EXPECT_EQ(events_processed_, 2u);
+  EXPECT_EQ(total_score_, 300u);
+}
+
+TEST_F(PubSubEventsTest, SubscribeToRoutesEachType) {
+  size_t button_events = 0;
+  size_t all_events = 0;
+  ASSERT_TRUE(pubsub_.SubscribeTo<sense::ButtonA>(
+      [&button_events](sense::ButtonA) { ++button_events; }));
+  ASSERT_TRUE(
+      pubsub_.SubscribeTo<sense::AirQuality>([this](sense::AirQuality sample) {
+        total_score_ += sample.score;
+        ++events_processed_;
+      }));
+  ASSERT_TRUE(pubsub_.Subscribe([this, &all_events](sense::Event) {
+    if (++all_events >= 4) {
+      notification_.release();
+    }
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  ASSERT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 512u}));
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonB(true)));
+  ASSERT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 256u}));
+  pause.release();
+
+  notification_.acquire();
+  EXPECT_EQ(all_events, 4u);
+  EXPECT_EQ(button_events, 1u);
+  EXPECT_EQ(events_processed_, 2u);
+  EXPECT_EQ(total_score_, 768u);
+}
+
+TEST_F(PubSubEventsTest, SubscribeToAny) {
+  size_t button_events = 0;
+  ASSERT_TRUE(
+      (pubsub_.SubscribeToAny<sense::ButtonA, sense::AirQuality>(
+          [this, &button_events](sense::Event event) {
+            if (auto* quality = std::get_if<sense::AirQuality>(&event)) {
+              total_score_ += quality->score;
+            } else {
+              EXPECT_TRUE(std::holds_alternative<sense::ButtonA>(event));
+              ++button_events;
+            }
+            if (++events_processed_ >= 3) {
+              notification_.release();
+            }
+          })));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonB(true)));
+  ASSERT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 512u}));
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonA(false)));
+  pause.release();
+
+  notification_.acquire();
+  EXPECT_EQ(events_processed_, 3u) << "ButtonB events are not routed";
+  EXPECT_EQ(button_events, 2u);
+  EXPECT_EQ(total_score_, 512u);
+}
+
+// Build-time subscribers only reach the test through globals.
+uint16_t static_score = 0;
+size_t static_events = 0;
+
+void CountStaticEvent(const sense::Event&) { ++static_events; }
+void AddStaticScore(const sense::AirQuality& quality) {
+  static_score += quality.score;
+}
+
+TEST_F(PubSubEventsTest, StaticSubscribers) {
+  static_score = 0;
+  static_events = 0;
+  pubsub_.SetStaticSubscribers<sense::StaticSubscribers<
+      sense::StaticSubscriber<&CountStaticEvent>,
+      sense::StaticSubscriberTo<sense::AirQuality, &AddStaticScore>>>();
+  // Runtime subscribers run after the static ones.
+  ASSERT_TRUE(pubsub_.Subscribe([this](const sense::Event&) {
+    if (++events_processed_ >= 3) {
+      notification_.release();
+    }
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 100u}));
+  ASSERT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  ASSERT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 200u}));
+  pause.release();
+
+  notification_.acquire();
+  EXPECT_EQ(static_events, 3u);
+  EXPECT_EQ(static_score, 300u);
+  EXPECT_EQ(pubsub_.subscriber_count(), 1u);
+}
+
+TEST_F(PubSubEventsTest, PriorityEventsDeliveredFirst) {
+  sense::TestWorker<> worker;
+  sense::GenericPubSubBuffer<sense::Event, 4, 1, 0, 2> pubsub(
+      worker, sense::kPriorityEvents);
+  struct {
+    std::array<size_t, 4> order{};
+    size_t count = 0;
+  } received;
+  ASSERT_TRUE(pubsub.Subscribe([this, &received](sense::Event event) {
+    received.order[received.count++] = event.index();
+    if (received.count == received.order.size()) {
+      notification_.release();
+    }
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub.Publish(sense::ProximitySample{.sample = 1u}));
+  ASSERT_TRUE(pubsub.Publish(sense::AirQuality{.score = 2u}));
+  ASSERT_TRUE(pubsub.Publish(sense::ButtonA(true)));
+  ASSERT_TRUE(pubsub.Publish(sense::TimerExpired{.token = 3u}));
+  pause.release();
+
+  notification_.acquire();
+  worker.Stop();
+  EXPECT_EQ(received.order[0], sense::kButtonA);
+  EXPECT_EQ(received.order[1], sense::kTimerExpired);
+  EXPECT_EQ(received.order[2], sense::kProximitySample);
+  EXPECT_EQ(received.order[3], sense::kAirQuality);
+}
+
+TEST_F(PubSubEventsTest, ConflatedEventsKeepLatestValue) {
+  sense::TestWorker<> worker;
+  sense::GenericPubSubBuffer<sense::Event, 4, 1> pubsub(
+      worker, 0, sense::kConflatedEvents);
+  ASSERT_TRUE(pubsub.Subscribe([this](sense::Event event) {
+    if (std::holds_alternative<sense::AirQuality>(event)) {
+      total_score_ += std::get<sense::AirQuality>(event).score;
+    }
+    if (++events_processed_ == 2) {
+      notification_.release();
+    }
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker.RunOnce([&pause]() { pause.acquire(); });
+  ASSERT_TRUE(pubsub.Publish(sense::AirQuality{.score = 100u}));
+  ASSERT_TRUE(pubsub.Publish(sense::ButtonA(true)));
+  for (uint16_t score = 101; score <= 110; ++score) {
+    ASSERT_TRUE(pubsub.Publish(sense::AirQuality{.score = score}));
+  }
+  pause.release();
+
+  notification_.acquire();
+  worker.Stop();
+  EXPECT_EQ(events_processed_, 2u);
+  EXPECT_EQ(total_score_, 110u);
+}
+
+TEST_F(PubSubEventsTest, ReservedSlotsOnlyTakeCriticalEvents) {
+  using Queue = sense::PubSub::EventQueue;
+  sense::TestWorker<> worker;
+  sense::GenericPubSubBuffer<sense::Event, 4, 1> pubsub(
+      worker, 0, 0, sense::kCriticalEvents, 2);
+
+  // Bulk events may fill all but room for two of the largest events.
+  const size_t bulk_events =
+      2 * Queue::kMaxEntrySize / Queue::EntrySize(sense::MorseCodeValue{});
+  ASSERT_TRUE(pubsub.Subscribe([this, bulk_events](sense::Event event) {
+    if (std::holds_alternative<sense::TimerExpired>(event)) {
+      total_score_ += std::get<sense::TimerExpired>(event).token;
+    }
+    if (++events_processed_ == bulk_events + 2) {
+      notification_.release();
+    }
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker.RunOnce([&pause]() { pause.acquire(); });
+  for (size_t i = 0; i < bulk_events; ++i) {
+    ASSERT_TRUE(pubsub.Publish(sense::MorseCodeValue{}));
+  }
+  EXPECT_FALSE(pubsub.Publish(sense::MorseCodeValue{}));
+  ASSERT_TRUE(pubsub.Publish(sense::TimerExpired{.token = 1}));
+  ASSERT_TRUE(pubsub.Publish(sense::TimerExpired{.token = 2}));
+  pause.release();
+
+  notification_.acquire();
+  worker.Stop();
+  EXPECT_EQ(events_processed_, bulk_events + 2);
+  EXPECT_EQ(total_score_, 3u);
+}
+
 }  // namespace
@@ -0,0 +1,70 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/pubsub/pubsub_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace sense {
+
+void PubSubMetrics::RecordPublish(size_t event_type, size_t queue_depth) {
+  published_.Increment();
+  if (event_type < kMaxEventTypes) {
+    published_by_type_[event_type].fetch_add(1, std::memory_order_relaxed);
+  }
+  if (queue_depth > queue_high_water_mark_.value()) {
+    queue_high_water_mark_.Set(static_cast<uint32_t>(queue_depth));
+  }
+}
+
+void PubSubMetrics::RecordDrop(size_t event_type) {
+  dropped_.Increment();
+  if (event_type < kMaxEventTypes) {
+    dropped_by_type_[event_type].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void PubSubMetrics::RecordDispatchLatency(
+    pw::chrono::SystemClock::duration latency) {
+  const uint32_t latency_us = ToMicroseconds(latency);
+  max_latency_us_.Set(std::max(max_latency_us_.value(), latency_us));
+
+  size_t bucket = 0;
+  while (bucket < kLatencyBucketLimitsUs.size() &&
+         latency_us >= kLatencyBucketLimitsUs[bucket]) {
+    ++bucket;
+  }
+  latency_histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PubSubMetrics::RecordCallbackTime(
+    size_t subscriber, pw::chrono::SystemClock::duration duration) {
+  const uint32_t duration_us = ToMicroseconds(duration);
+  max_callback_us_.Set(std::max(max_callback_us_.value(), duration_us));
+  if (subscriber < kMaxSubscribers) {
+    auto& max = max_callback_us_by_subscriber_[subscriber];
+    if (duration_us > max.load(std::memory_order_relaxed)) {
+      max.store(duration_us, std::memory_order_relaxed);
+    }
+  }
+}
+
+uint32_t PubSubMetrics::ToMicroseconds(
+    pw::chrono::SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+}  // namespace sense
@@ -0,0 +1,91 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_metric/metric.h"
+
+namespace sense {
+
+/// Instrumentation for `GenericPubSub`.
+///
+/// Per-type and per-subscriber values are indexed by the event's variant index
+/// and the subscriber's slot, respectively.
+class PubSubMetrics {
+ public:
+  static constexpr size_t kMaxEventTypes = 32;
+  static constexpr size_t kMaxSubscribers = 16;
+
+  /// Upper bounds, in microseconds, of the dispatch latency histogram buckets.
+  /// A final bucket counts everything slower.
+  static constexpr std::array<uint32_t, 4> kLatencyBucketLimitsUs = {
+      100, 1'000, 10'000, 100'000};
+  static constexpr size_t kLatencyBuckets = kLatencyBucketLimitsUs.size() + 1;
+
+  void RecordPublish(size_t event_type, size_t queue_depth);
+  void RecordDrop(size_t event_type);
+  void RecordDispatchLatency(pw::chrono::SystemClock::duration latency);
+  void RecordCallbackTime(size_t subscriber,
+                          pw::chrono::SystemClock::duration duration);
+
+  uint32_t published(size_t event_type) const {
+    return Load(published_by_type_, event_type);
+  }
+  uint32_t dropped(size_t event_type) const {
+    return Load(dropped_by_type_, event_type);
+  }
+  uint32_t queue_high_water_mark() const {
+    return queue_high_water_mark_.value();
+  }
+  uint32_t dispatch_latency_bucket(size_t bucket) const {
+    return Load(latency_histogram_, bucket);
+  }
+  uint32_t max_callback_us(size_t subscriber) const {
+    return Load(max_callback_us_by_subscriber_, subscriber);
+  }
+
+  pw::metric::Group& group() { return metrics_; }
+
+  /// Writes the metrics to logs.
+  void Dump() { metrics_.Dump(); }
+
+ private:
+  template <size_t kSize>
+  static uint32_t Load(const std::array<std::atomic<uint32_t>, kSize>& values,
+                       size_t index) {
+    return index < kSize ? values[index].load(std::memory_order_relaxed) : 0;
+  }
+
+  static uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration);
+
+  PW_METRIC_GROUP(metrics_, "pubsub");
+  PW_METRIC(metrics_, published_, "published", 0u);
+  PW_METRIC(metrics_, dropped_, "dropped", 0u);
+  PW_METRIC(metrics_, queue_high_water_mark_, "queue high water mark", 0u);
+  PW_METRIC(metrics_, max_latency_us_, "max dispatch latency us", 0u);
+  PW_METRIC(metrics_, max_callback_us_, "max callback us", 0u);
+
+  std::array<std::atomic<uint32_t>, kMaxEventTypes> published_by_type_{};
+  std::array<std::atomic<uint32_t>, kMaxEventTypes> dropped_by_type_{};
+  std::array<std::atomic<uint32_t>, kLatencyBuckets> latency_histogram_{};
+  std::array<std::atomic<uint32_t>, kMaxSubscribers>
+      max_callback_us_by_subscriber_{};
+};
+
+}  // namespace sense
@@ -160,6 +160,110 @@ TEST_F(PubSubTest, Publish_MultipleEvents_QueueFull) {
   EXPECT_EQ(response.BlockAndGetValue(), 46u);
 }
 
+TEST_F(PubSubTest, Publish_BurstUsesSingleWorkItem) {
+  // A worker with room for only the pause task and one more item.
+  sense::TestWorker<2> worker;
+  sense::GenericPubSubBuffer<EchoRequest, 8, 1> pubsub(worker);
+  EchoResponse response;
+
+  pw::sync::ThreadNotification pause;
+  worker.RunOnce([&pause]() { pause.acquire(); });
+
+  ASSERT_TRUE(pubsub.Subscribe([&response](EchoRequest request) {
+    response.AddValueAndUnblock(request.value);
+  }));
+  response.SetNotifyAfter(8);
+  for (uint32_t i = 1; i <= 8; ++i) {
+    ASSERT_TRUE(pubsub.Publish({.value = i}));
+  }
+  pause.release();
+
+  EXPECT_EQ(response.BlockAndGetValue(), 36u);
+  worker.Stop();
+}
+
+TEST_F(PubSubTest, Publish_DroppedDrainIsRetried) {
+  sense::TestWorker<1> worker;
+  sense::GenericPubSubBuffer<EchoRequest, 4, 1> pubsub(worker);
+  EchoResponse response;
+  ASSERT_TRUE(pubsub.Subscribe([&response](EchoRequest request) {
+    response.AddValueAndUnblock(request.value);
+  }));
+
+  // Block the worker, then fill its only queue slot.
+  pw::sync::ThreadNotification started;
+  pw::sync::ThreadNotification pause;
+  pw::sync::ThreadNotification filler_done;
+  ASSERT_TRUE(worker.RunOnce([&started, &pause]() {
+    started.release();
+    pause.acquire();
+  }));
+  started.acquire();
+  ASSERT_TRUE(worker.RunOnce([&filler_done]() { filler_done.release(); }));
+
+  // The drain cannot be queued, but the event is kept.
+  response.SetNotifyAfter(2);
+  ASSERT_TRUE(pubsub.Publish({.value = 1}));
+  pause.release();
+  filler_done.acquire();
+
+  // The next publish schedules a drain which delivers both events.
+  ASSERT_TRUE(pubsub.Publish({.value = 2}));
+  EXPECT_EQ(response.BlockAndGetValue(), 3u);
+  worker.Stop();
+}
+
+TEST_F(PubSubTest, PublishFromInterrupt_LockFreeQueue) {
+  sense::TestWorker<> worker;
+  sense::GenericPubSubBuffer<EchoRequest, 4, 1, 4> pubsub(worker);
+  EchoResponse response;
+  ASSERT_TRUE(pubsub.Subscribe([&response](EchoRequest request) {
+    response.AddValueAndUnblock(request.value);
+  }));
+
+  pw::sync::ThreadNotification pause;
+  worker.RunOnce([&pause]() { pause.acquire(); });
+
+  response.SetNotifyAfter(6);
+  ASSERT_TRUE(pubsub.PublishFromInterrupt({.value = 1}));
+  ASSERT_TRUE(pubsub.Publish({.value = 2}));
+  ASSERT_TRUE(pubsub.PublishFromInterrupt({.value = 3}));
+  ASSERT_TRUE(pubsub.PublishFromInterrupt({.value = 4}));
+  ASSERT_TRUE(pubsub.PublishFromInterrupt({.value = 5}));
+  EXPECT_FALSE(pubsub.PublishFromInterrupt({.value = 6}));
+  ASSERT_TRUE(pubsub.Publish({.value = 7}));
+  pause.release();
+
+  EXPECT_EQ(response.BlockAndGetValue(), 22u);
+  worker.Stop();
+}
+
+TEST_F(PubSubTest, Trace_RecordsPublishAndDispatch) {
+  if constexpr (!sense::PubSubTrace::kEnabled) {
+    GTEST_SKIP();
+  }
+  EchoResponse& response = responses_[0];
+  ASSERT_TRUE(pubsub_.Subscribe([&response](EchoRequest request) {
+    response.AddValueAndUnblock(request.value);
+  }));
+  ASSERT_TRUE(pubsub_.Publish({.value = 1}));
+  EXPECT_EQ(response.BlockAndGetValue(), 1u);
+
+  std::array<sense::PubSubTrace::Record, 4> records;
+  uint32_t next = 0;
+  // The dispatch record is written after the callback returns.
+  size_t count = 0;
+  while (count < 2) {
+    next = 0;
+    count = pubsub_.trace().Read(records, next);
+  }
+  EXPECT_EQ(count, 2u);
+  EXPECT_EQ(next, 2u);
+  EXPECT_EQ(records[0].kind, sense::PubSubTrace::Kind::kPublish);
+  EXPECT_EQ(records[0].queue_depth, 1u);
+  EXPECT_EQ(records[1].kind, sense::PubSubTrace::Kind::kDispatch);
+}
+
 TEST_F(PubSubTest, Subscribe_Full) {
   for (auto& response : responses_) {
     ASSERT_TRUE(pubsub_.Subscribe([&response](EchoRequest request) {
@@ -215,4 +319,33 @@ TEST_F(PubSubTest, Subscribe_Unsubscribe) {
   EXPECT_FALSE(pubsub_.Unsubscribe(tokens[1]));
 }
 
+TEST_F(PubSubTest, Unsubscribe_SlotNotReusedDuringDispatch) {
+  sense::GenericPubSubBuffer<EchoRequest, kMaxEvents, 1> pubsub(worker_);
+  EchoResponse& response = responses_[0];
+  std::optional<PubSub::SubscribeToken> token;
+  bool resubscribed = true;
+  token = pubsub.Subscribe([&](EchoRequest request) {
+    ASSERT_TRUE(pubsub.Unsubscribe(*token));
+    // The slot is still in use by this call.
+    resubscribed = pubsub.Subscribe([](EchoRequest) {}).has_value();
+    response.AddValueAndUnblock(request.value);
+  });
+  ASSERT_TRUE(token.has_value());
+
+  ASSERT_TRUE(pubsub.Publish({.value = 7u}));
+  EXPECT_EQ(response.BlockAndGetValue(), 7u);
+  EXPECT_FALSE(resubscribed);
+
+  // After the dispatch returns, the slot can be reused.
+  EchoResponse& next = responses_[1];
+  pw::sync::ThreadNotification done;
+  worker_.RunOnce([&done]() { done.release(); });
+  done.acquire();
+  ASSERT_TRUE(pubsub.Subscribe([&next](EchoRequest request) {
+    next.AddValueAndUnblock(request.value);
+  }));
+  ASSERT_TRUE(pubsub.Publish({.value = 8u}));
+  EXPECT_EQ(next.BlockAndGetValue(), 8u);
+}
+
 }  // namespace
@@ -0,0 +1,80 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/pubsub/pubsub_trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace sense {
+#if SENSE_PUBSUB_TRACE_CAPACITY > 0
+namespace {
+
+uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration) {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+uint8_t Saturate(size_t value) {
+  return static_cast<uint8_t>(std::min<size_t>(value, UINT8_MAX));
+}
+
+}  // namespace
+#endif  // SENSE_PUBSUB_TRACE_CAPACITY > 0
+
+void PubSubTrace::AddRecord(Kind kind,
+                            size_t event_type,
+                            size_t queue_depth,
+                            pw::chrono::SystemClock::duration duration) {
+#if SENSE_PUBSUB_TRACE_CAPACITY > 0
+  const Record record = {
+      .timestamp_us = ToMicroseconds(
+          pw::chrono::SystemClock::now().time_since_epoch()),
+      .kind = kind,
+      .event_type = Saturate(event_type),
+      .queue_depth = Saturate(queue_depth),
+      .reserved = 0,
+      .duration_us = ToMicroseconds(duration),
+  };
+
+  std::lock_guard lock(lock_);
+  records_[total_ % kCapacity] = record;
+  ++total_;
+#else
+  static_cast<void>(kind);
+  static_cast<void>(event_type);
+  static_cast<void>(queue_depth);
+  static_cast<void>(duration);
+#endif  // SENSE_PUBSUB_TRACE_CAPACITY > 0
+}
+
+size_t PubSubTrace::Read(pw::span<Record> out, uint32_t& first) const {
+#if SENSE_PUBSUB_TRACE_CAPACITY > 0
+  std::lock_guard lock(lock_);
+  const uint32_t oldest = total_ > kCapacity ? total_ - kCapacity : 0;
+  first = std::max(first, oldest);
+
+  size_t copied = 0;
+  for (; copied < out.size() && first < total_; ++copied, ++first) {
+    out[copied] = records_[first % kCapacity];
+  }
+  return copied;
+#else
+  static_cast<void>(out);
+  static_cast<void>(first);
+  return 0;
+#endif  // SENSE_PUBSUB_TRACE_CAPACITY > 0
+}
+
+}  // namespace sense
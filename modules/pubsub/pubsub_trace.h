@@ -0,0 +1,100 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_span/span.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+
+/// Number of records kept in each PubSub trace ring. Setting this to 0
+/// compiles tracing out entirely.
+#ifndef SENSE_PUBSUB_TRACE_CAPACITY
+#define SENSE_PUBSUB_TRACE_CAPACITY 64
+#endif  // SENSE_PUBSUB_TRACE_CAPACITY
+
+namespace sense {
+
+/// Fixed-size ring of compact records describing PubSub traffic.
+///
+/// Recording does not format or allocate; it copies 12 bytes into the ring
+/// under a spin lock. This is cheap enough to leave enabled in production.
+class PubSubTrace {
+ public:
+  static constexpr size_t kCapacity = SENSE_PUBSUB_TRACE_CAPACITY;
+  static constexpr bool kEnabled = kCapacity > 0;
+
+  enum class Kind : uint8_t {
+    kPublish,
+    kDrop,
+    kDispatch,
+  };
+
+  struct Record {
+    /// Low 32 bits of the system clock, in microseconds.
+    uint32_t timestamp_us;
+    Kind kind;
+    /// Variant index of the event.
+    uint8_t event_type;
+    /// Number of queued events after a publish.
+    uint8_t queue_depth;
+    uint8_t reserved;
+    /// Time spent running subscriber callbacks for a dispatch.
+    uint32_t duration_us;
+  };
+  static_assert(sizeof(Record) == 12);
+
+  void Add(Kind kind,
+           size_t event_type,
+           size_t queue_depth,
+           pw::chrono::SystemClock::duration duration = {})
+      PW_LOCKS_EXCLUDED(lock_) {
+    if constexpr (kEnabled) {
+      AddRecord(kind, event_type, queue_depth, duration);
+    }
+  }
+
+  /// Copies up to `out.size()` records, oldest first, starting from record
+  /// number `first`. Records that have already been overwritten are skipped.
+  ///
+  /// @param first Sequence number of the first record to copy. Updated to the
+  /// sequence number following the last record copied.
+  /// @returns The number of records copied.
+  size_t Read(pw::span<Record> out, uint32_t& first) const
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Total number of records ever added.
+  uint32_t total() const PW_LOCKS_EXCLUDED(lock_) {
+    std::lock_guard lock(lock_);
+    return total_;
+  }
+
+ private:
+  void AddRecord(Kind kind,
+                 size_t event_type,
+                 size_t queue_depth,
+                 pw::chrono::SystemClock::duration duration)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  mutable pw::sync::InterruptSpinLock lock_;
+  std::array<Record, kCapacity> records_ PW_GUARDED_BY(lock_);
+  uint32_t total_ PW_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace sense
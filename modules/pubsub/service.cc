@@ -15,168 +15,53 @@
 
 #include "modules/pubsub/service.h"
 
-#include "modules/state_manager/state_manager.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+
+#include "modules/log_policy/rate_limiter.h"
+#include "modules/pubsub/event_codec.h"
+#include "modules/pubsub/payload.h"
 #include "pw_assert/check.h"
 #include "pw_log/log.h"
-#include "pw_string/util.h"
 
 namespace sense {
-namespace {
-
-pubsub_Event EventToProto(const Event& event) {
-  pubsub_Event proto = pubsub_Event_init_default;
-
-  if (std::holds_alternative<ButtonA>(event)) {
-    proto.which_type = pubsub_Event_button_a_pressed_tag;
-    proto.type.button_a_pressed = std::get<ButtonA>(event).pressed();
-  } else if (std::holds_alternative<ButtonB>(event)) {
-    proto.which_type = pubsub_Event_button_b_pressed_tag;
-    proto.type.button_b_pressed = std::get<ButtonB>(event).pressed();
-  } else if (std::holds_alternative<ButtonX>(event)) {
-    proto.which_type = pubsub_Event_button_x_pressed_tag;
-    proto.type.button_x_pressed = std::get<ButtonX>(event).pressed();
-  } else if (std::holds_alternative<ButtonY>(event)) {
-    proto.which_type = pubsub_Event_button_y_pressed_tag;
-    proto.type.button_y_pressed = std::get<ButtonY>(event).pressed();
-  } else if (std::holds_alternative<TimerRequest>(event)) {
-    proto.which_type = pubsub_Event_timer_request_tag;
-    auto& timer_request = std::get<TimerRequest>(event);
-    proto.type.timer_request.token = timer_request.token;
-    proto.type.timer_request.timeout_s = timer_request.timeout_s;
-  } else if (std::holds_alternative<TimerExpired>(event)) {
-    proto.which_type = pubsub_Event_timer_expired_tag;
-    auto& timer_expired = std::get<TimerExpired>(event);
-    proto.type.timer_expired.token = timer_expired.token;
-  } else if (std::holds_alternative<ProximityStateChange>(event)) {
-    proto.which_type = pubsub_Event_proximity_tag;
-    proto.type.proximity = std::get<ProximityStateChange>(event).proximity;
-  } else if (std::holds_alternative<ProximitySample>(event)) {
-    proto.which_type = pubsub_Event_proximity_level_tag;
-    proto.type.proximity_level = std::get<ProximitySample>(event).sample;
-  } else if (std::holds_alternative<AmbientLightSample>(event)) {
-    proto.which_type = pubsub_Event_ambient_light_lux_tag;
-    proto.type.ambient_light_lux =
-        std::get<AmbientLightSample>(event).sample_lux;
-  } else if (std::holds_alternative<AirQuality>(event)) {
-    proto.which_type = pubsub_Event_air_quality_tag;
-    proto.type.air_quality = std::get<AirQuality>(event).score;
-  } else if (std::holds_alternative<MorseEncodeRequest>(event)) {
-    proto.which_type = pubsub_Event_morse_encode_request_tag;
-    const auto& morse = std::get<MorseEncodeRequest>(event);
-    auto& msg = proto.type.morse_encode_request.msg;
-    msg[morse.message.copy(proto.type.morse_encode_request.msg,
-                           sizeof(msg) - 1)] = '\0';
-    proto.type.morse_encode_request.repeat = morse.repeat;
-  } else if (std::holds_alternative<MorseCodeValue>(event)) {
-    proto.which_type = pubsub_Event_morse_code_value_tag;
-    const auto& morse = std::get<MorseCodeValue>(event);
-    proto.type.morse_code_value.turn_on = morse.turn_on;
-    proto.type.morse_code_value.message_finished = morse.message_finished;
-  } else if (std::holds_alternative<SenseState>(event)) {
-    proto.which_type = pubsub_Event_sense_state_tag;
-    const auto& state = std::get<SenseState>(event);
-    proto.type.sense_state.alarm_active = state.alarm;
-    proto.type.sense_state.alarm_threshold = state.alarm_threshold;
-    proto.type.sense_state.aq_score = state.air_quality;
-    if (const auto status =
-            pw::string::Copy(state.air_quality_description,
-                             proto.type.sense_state.aq_description);
-        !status.ok()) {
-      PW_LOG_ERROR("Description truncated to %zu characters: %s",
-                   status.size(),
-                   status.status().str());
-    }
-  } else if (std::holds_alternative<StateManagerControl>(event)) {
-    proto.which_type = pubsub_Event_state_manager_control_tag;
-    const auto& control = std::get<StateManagerControl>(event);
-    switch (control.action) {
-      case StateManagerControl::kDecrementThreshold:
-        proto.type.state_manager_control.action =
-            pubsub_StateManagerControl_Action_DECREMENT_THRESHOLD;
-        break;
-      case StateManagerControl::kIncrementThreshold:
-        proto.type.state_manager_control.action =
-            pubsub_StateManagerControl_Action_INCREMENT_THRESHOLD;
-        break;
-      case StateManagerControl::kSilenceAlarms:
-        proto.type.state_manager_control.action =
-            pubsub_StateManagerControl_Action_SILENCE_ALARMS;
-        break;
-    }
-  } else {
-    PW_LOG_WARN("Unimplemented pubsub service event");
-  }
-  return proto;
-}
-
-pw::Result<Event> ProtoToEvent(const pubsub_Event& proto) {
-  switch (proto.which_type) {
-    case pubsub_Event_button_a_pressed_tag:
-      return ButtonA(proto.type.button_a_pressed);
-    case pubsub_Event_button_b_pressed_tag:
-      return ButtonB(proto.type.button_b_pressed);
-    case pubsub_Event_button_x_pressed_tag:
-      return ButtonX(proto.type.button_x_pressed);
-    case pubsub_Event_button_y_pressed_tag:
-      return ButtonY(proto.type.button_y_pressed);
-    case pubsub_Event_timer_request_tag:
-      return TimerRequest{
-          .token = proto.type.timer_request.token,
-          .timeout_s =
-              static_cast<uint16_t>(proto.type.timer_request.timeout_s),
-      };
-    case pubsub_Event_timer_expired_tag:
-      return TimerExpired{
-          .token = proto.type.timer_expired.token,
-      };
-    case pubsub_Event_morse_code_value_tag:
-      return MorseCodeValue{
-          .turn_on = proto.type.morse_code_value.turn_on,
-          .message_finished = proto.type.morse_code_value.message_finished,
-      };
-    case pubsub_Event_proximity_tag:
-      return ProximityStateChange{.proximity = proto.type.proximity};
-    case pubsub_Event_air_quality_tag:
-      return AirQuality{.score = static_cast<uint16_t>(proto.type.air_quality)};
-    case pubsub_Event_sense_state_tag:
-      return SenseState{
-          .alarm = proto.type.sense_state.alarm_active,
-          .alarm_threshold =
-              static_cast<uint16_t>(proto.type.sense_state.alarm_threshold),
-          .air_quality = static_cast<uint16_t>(proto.type.sense_state.aq_score),
-          .air_quality_description = StateManager::AirQualityDescription(
-              proto.type.sense_state.aq_score),
-      };
-    case pubsub_Event_state_manager_control_tag:
-      StateManagerControl::Action action;
-      switch (proto.type.state_manager_control.action) {
-        case pubsub_StateManagerControl_Action_DECREMENT_THRESHOLD:
-          action = StateManagerControl::kDecrementThreshold;
-          break;
-        case pubsub_StateManagerControl_Action_INCREMENT_THRESHOLD:
-          action = StateManagerControl::kIncrementThreshold;
-          break;
-        case pubsub_StateManagerControl_Action_SILENCE_ALARMS:
-          action = StateManagerControl::kSilenceAlarms;
-          break;
-        case pubsub_StateManagerControl_Action_UNKNOWN:
-          return pw::Status::InvalidArgument();
-      }
-      return StateManagerControl(action);
-    default:
-      return pw::Status::Unimplemented();
-  }
-}
-
-}  // namespace
 
-void PubSubService::Init(PubSub& pubsub) {
+void PubSubService::Init(Worker& worker, PubSub& pubsub) {
+  worker_ = &worker;
   pubsub_ = &pubsub;
 
-  PW_CHECK(pubsub_->Subscribe([this](Event event) {
-    // Writing to an unopened stream is okay here, so we IgnoreError.
-    stream_.Write(EventToProto(event)).IgnoreError();
-  }));
+  PW_CHECK(pubsub_->Subscribe(
+      [this](const Event& event) { HandleEvent(event); }));
+}
+
+void PubSubService::HandleEvent(const Event& event) {
+  const pb_size_t tag = EventTag(event);
+  std::lock_guard lock(lock_);
+
+  // Filter before converting so that unwanted events cost nothing, and
+  // convert at most once for all interested streams.
+  std::optional<pubsub_Event> proto;
+  const int64_t dispatch_time_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          pw::chrono::SystemClock::now().time_since_epoch())
+          .count();
+  for (Stream& stream : streams_) {
+    if (stream.active() && stream.filter().Accept(tag)) {
+      if (!proto.has_value()) {
+        proto = EventToProto(event);
+      }
+      stream.Send(event, *proto, dispatch_time_us);
+    }
+  }
+  if (batch_stream_.active() && batch_filter_.Accept(tag)) {
+    if (!proto.has_value()) {
+      proto = EventToProto(event);
+    }
+    AddToBatch(*proto);
+  }
 }
 
 pw::Status PubSubService::Publish(const pubsub_Event& request,
@@ -188,18 +73,297 @@ pw::Status PubSubService::Publish(const pubsub_Event& request,
 
   if (pubsub_ != nullptr) {
     bool published = pubsub_->Publish(*maybe_event);
-    PW_LOG_INFO("%s event to pubsub system",
-                published ? "Published" : "Failed to publish");
+    // Scripts may publish in bursts, so summarize rather than log each one.
+    SENSE_LOG_EVERY(PW_LOG_INFO,
+                    std::chrono::seconds(1),
+                    "%s event to pubsub system",
+                    published ? "Published" : "Failed to publish");
   }
 
   return pw::OkStatus();
 }
 
-void PubSubService::Subscribe(const pw_protobuf_Empty&,
+void PubSubService::Subscribe(const pubsub_SubscribeRequest& request,
                               ServerWriter<pubsub_Event>& writer) {
+  std::lock_guard lock(lock_);
+  auto stream = std::find_if(streams_.begin(), streams_.end(), [](auto& s) {
+    return !s.active();
+  });
+  if (stream == streams_.end()) {
+    PW_LOG_WARN("No free pubsub stream for RPC channel %u",
+                writer.channel_id());
+    writer.Finish(pw::Status::ResourceExhausted()).IgnoreError();
+    return;
+  }
+
   PW_LOG_INFO("Streaming pubsub events over RPC channel %u",
               writer.channel_id());
-  stream_ = std::move(writer);
+  stream->Open(request, std::move(writer));
+}
+
+void PubSubService::SubscribeBatched(
+    const pubsub_SubscribeBatchedRequest& request,
+    ServerWriter<pubsub_EventBatch>& writer) {
+  PW_LOG_INFO("Streaming batched pubsub events over RPC channel %u",
+              writer.channel_id());
+  std::lock_guard lock(lock_);
+  FlushBatch();
+  batch_filter_.Configure(request.filter);
+  max_batch_events_ = request.max_events == 0
+                          ? kMaxBatchEvents
+                          : std::min<size_t>(request.max_events,
+                                             kMaxBatchEvents);
+  max_batch_delay_ = pw::chrono::SystemClock::for_at_least(
+      request.max_delay_ms == 0
+          ? kDefaultBatchDelay
+          : std::chrono::milliseconds(request.max_delay_ms));
+  batch_stream_ = std::move(writer);
+}
+
+void PubSubService::AddToBatch(const pubsub_Event& event) {
+  // A Morse request may carry a long message, so it is flushed by itself to
+  // keep batches within a single packet.
+  const bool large = event.which_type == pubsub_Event_morse_encode_request_tag;
+  if (large) {
+    FlushBatch();
+  }
+
+  if (batch_.events_count == 0) {
+    flush_timer_.InvokeAfter(max_batch_delay_);
+  }
+  batch_.events[batch_.events_count++] = event;
+
+  if (large || batch_.events_count >= max_batch_events_) {
+    FlushBatch();
+  }
+}
+
+void PubSubService::FlushBatch() {
+  if (batch_.events_count == 0) {
+    return;
+  }
+  flush_timer_.Cancel();
+  if (batch_stream_.Write(batch_).ok()) {
+    batch_.dropped = 0;
+  } else {
+    // The channel is backed up or the stream closed. Either way the events
+    // are lost; report them with the next batch.
+    batch_.dropped += batch_.events_count;
+  }
+  batch_.events_count = 0;
+}
+
+void PubSubService::FlushCallback(pw::chrono::SystemClock::time_point) {
+  worker_->RunOnce([this]() {
+    std::lock_guard lock(lock_);
+    FlushBatch();
+  });
+}
+
+void PubSubService::Stream::Open(const pubsub_SubscribeRequest& request,
+                                 ServerWriter<pubsub_Event>&& writer) {
+  filter_.Configure(request);
+  backpressure_ = request.backpressure;
+  capture_ = request.capture;
+  ClearPending();
+  dropped_ = 0;
+  writer_ = std::move(writer);
+}
+
+void PubSubService::Stream::Send(const Event& event,
+                                 const pubsub_Event& proto,
+                                 int64_t dispatch_time_us) {
+  // Held events go first so that the stream stays in order.
+  if (SendPending() && Write(proto, dispatch_time_us)) {
+    return;
+  }
+  if (!writer_.active()) {
+    ClearPending();
+    return;
+  }
+  Hold(event, dispatch_time_us);
+}
+
+bool PubSubService::Stream::Write(const pubsub_Event& proto,
+                                  int64_t dispatch_time_us) {
+  pw::Status status;
+  if (dropped_ == 0 && !capture_) {
+    status = writer_.Write(proto);
+  } else {
+    pubsub_Event annotated = proto;
+    annotated.dropped = dropped_;
+    if (capture_) {
+      annotated.dispatch_time_us = dispatch_time_us;
+    }
+    status = writer_.Write(annotated);
+  }
+  if (!status.ok()) {
+    return false;
+  }
+  dropped_ = 0;
+  return true;
+}
+
+bool PubSubService::Stream::SendPending() {
+  while (!pending_.empty()) {
+    const PendingEvent& pending = pending_.front();
+    if (!Write(EventToProto(pending.event), pending.dispatch_time_us)) {
+      return false;
+    }
+    PopPending();
+  }
+  return true;
+}
+
+void PubSubService::Stream::PopPending() {
+  ReleasePayload(pending_.front().event);
+  pending_.pop_front();
+}
+
+void PubSubService::Stream::ClearPending() {
+  while (!pending_.empty()) {
+    PopPending();
+  }
+}
+
+void PubSubService::Stream::Hold(const Event& event,
+                                 int64_t dispatch_time_us) {
+  const PendingEvent pending = {.event = event,
+                                .dispatch_time_us = dispatch_time_us};
+  switch (backpressure_) {
+    case pubsub_SubscribeRequest_Backpressure_CONFLATE:
+      for (PendingEvent& held : pending_) {
+        if (held.event.index() == event.index()) {
+          ReleasePayload(held.event);
+          RetainPayload(event);
+          held = pending;
+          ++dropped_;
+          return;
+        }
+      }
+      [[fallthrough]];
+    case pubsub_SubscribeRequest_Backpressure_DROP_OLDEST:
+      if (pending_.full()) {
+        PopPending();
+        ++dropped_;
+      }
+      RetainPayload(event);
+      pending_.push_back(pending);
+      return;
+    case pubsub_SubscribeRequest_Backpressure_DROP_NEWEST:
+    default:
+      if (pending_.full()) {
+        ++dropped_;
+        return;
+      }
+      RetainPayload(event);
+      pending_.push_back(pending);
+      return;
+  }
+}
+
+void PubSubService::EventFilter::Configure(
+    const pubsub_SubscribeRequest& request) {
+  event_mask_ = request.event_mask == 0 ? ~uint32_t(0) : request.event_mask;
+  keep_every_.fill(0);
+  skipped_.fill(0);
+  for (pb_size_t i = 0; i < request.decimation_count; ++i) {
+    const auto& decimation = request.decimation[i];
+    if (decimation.field < kMaxTags) {
+      keep_every_[decimation.field] = static_cast<uint16_t>(
+          std::min<uint32_t>(decimation.keep_every, UINT16_MAX));
+    }
+  }
+}
+
+bool PubSubService::EventFilter::Accept(pb_size_t tag) {
+  if (tag >= kMaxTags || (event_mask_ & (uint32_t(1) << tag)) == 0) {
+    return false;
+  }
+  if (keep_every_[tag] <= 1) {
+    return true;
+  }
+  if (skipped_[tag] + 1u >= keep_every_[tag]) {
+    skipped_[tag] = 0;
+    return true;
+  }
+  ++skipped_[tag];
+  return false;
+}
+
+pw::Status PubSubService::GetStats(const pw_protobuf_Empty&,
+                                   pubsub_Stats& response) {
+  if (pubsub_ == nullptr) {
+    return pw::Status::FailedPrecondition();
+  }
+  PubSubMetrics& metrics = pubsub_->metrics();
+
+  response.published_count = std::variant_size_v<Event>;
+  response.dropped_count = std::variant_size_v<Event>;
+  for (size_t i = 0; i < std::variant_size_v<Event>; ++i) {
+    response.published[i] = metrics.published(i);
+    response.dropped[i] = metrics.dropped(i);
+  }
+  response.queue_high_water_mark = metrics.queue_high_water_mark();
+
+  response.dispatch_latency_histogram_count = PubSubMetrics::kLatencyBuckets;
+  for (size_t i = 0; i < PubSubMetrics::kLatencyBuckets; ++i) {
+    response.dispatch_latency_histogram[i] = metrics.dispatch_latency_bucket(i);
+  }
+
+  const size_t subscribers =
+      std::min(pubsub_->max_subscribers(), PubSubMetrics::kMaxSubscribers);
+  response.max_callback_us_count = subscribers;
+  for (size_t i = 0; i < subscribers; ++i) {
+    response.max_callback_us[i] = metrics.max_callback_us(i);
+  }
+  return pw::OkStatus();
+}
+
+void PubSubService::DumpTrace(const pw_protobuf_Empty&,
+                              ServerWriter<pubsub_TraceChunk>& writer) {
+  if (pubsub_ == nullptr) {
+    writer.Finish(pw::Status::FailedPrecondition()).IgnoreError();
+    return;
+  }
+  const PubSubTrace& trace = pubsub_->trace();
+
+  // Only dump what was recorded before the call, so that a busy bus cannot
+  // keep the stream open indefinitely.
+  const uint32_t end = trace.total();
+  uint32_t next = end > PubSubTrace::kCapacity ? end - PubSubTrace::kCapacity
+                                               : 0;
+  std::array<PubSubTrace::Record, sizeof(pubsub_TraceChunk::records) /
+                                      sizeof(pubsub_TraceRecord)>
+      records;
+
+  while (next < end) {
+    pubsub_TraceChunk chunk = pubsub_TraceChunk_init_default;
+    const uint32_t requested = next;
+    const size_t count = trace.Read(
+        pw::span(records).first(std::min<size_t>(records.size(), end - next)),
+        next);
+    if (count == 0) {
+      break;
+    }
+    chunk.first = next - count;
+    chunk.lost = chunk.first - requested;
+    chunk.records_count = count;
+    for (size_t i = 0; i < count; ++i) {
+      const PubSubTrace::Record& record = records[i];
+      chunk.records[i] = {
+          .timestamp_us = record.timestamp_us,
+          .kind = static_cast<pubsub_TraceRecord_Kind>(record.kind),
+          .event_type = record.event_type,
+          .queue_depth = record.queue_depth,
+          .duration_us = record.duration_us,
+      };
+    }
+    if (!writer.Write(chunk).ok()) {
+      return;
+    }
+  }
+  writer.Finish().IgnoreError();
 }
 
 }  // namespace sense
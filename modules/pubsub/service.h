@@ -13,22 +13,133 @@
 // the License.
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 #include "modules/pubsub/pubsub_events.h"
 #include "modules/pubsub/pubsub_pb/pubsub.rpc.pb.h"
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_containers/inline_deque.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_function/function.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
 
 namespace sense {
 
 class PubSubService final
     : public ::pubsub::pw_rpc::nanopb::PubSub::Service<PubSubService> {
  public:
-  void Init(PubSub& pubsub);
+  /// Number of `Subscribe` streams that may be open at once.
+  static constexpr size_t kMaxStreams = 3;
+
+  /// Number of events a `Subscribe` stream holds while its channel is backed
+  /// up, before its backpressure policy drops any.
+  static constexpr size_t kMaxPendingEvents = 4;
+
+  PubSubService()
+      : flush_timer_(pw::bind_member<&PubSubService::FlushCallback>(this)) {}
+
+  void Init(Worker& worker, PubSub& pubsub);
 
   pw::Status Publish(const pubsub_Event& request, pw_protobuf_Empty&);
-  void Subscribe(const pw_protobuf_Empty&, ServerWriter<pubsub_Event>& writer);
+  void Subscribe(const pubsub_SubscribeRequest& request,
+                 ServerWriter<pubsub_Event>& writer);
+
+  /// Streams events in `EventBatch` messages. Events are converted into the
+  /// pending batch as they arrive, and the writer encodes the batch straight
+  /// into the channel's payload buffer. This is not zero-copy: each event is
+  /// copied once into the batch, since nanopb needs the whole message in a
+  /// struct to encode it.
+  void SubscribeBatched(const pubsub_SubscribeBatchedRequest& request,
+                        ServerWriter<pubsub_EventBatch>& writer);
+
+  pw::Status GetStats(const pw_protobuf_Empty&, pubsub_Stats& response);
+
+  void DumpTrace(const pw_protobuf_Empty&,
+                 ServerWriter<pubsub_TraceChunk>& writer);
 
  private:
+  static constexpr size_t kMaxBatchEvents =
+      sizeof(pubsub_EventBatch::events) / sizeof(pubsub_Event);
+  static constexpr auto kDefaultBatchDelay = std::chrono::milliseconds(100);
+
+  /// Selects which events a stream receives, by oneof field number.
+  class EventFilter {
+   public:
+    void Configure(const pubsub_SubscribeRequest& request);
+
+    /// Returns whether an event with the given field number should be
+    /// streamed. Updates decimation state, so call once per event.
+    bool Accept(pb_size_t tag);
+
+   private:
+    static constexpr size_t kMaxTags = 32;
+
+    uint32_t event_mask_ = ~uint32_t(0);
+    std::array<uint16_t, kMaxTags> keep_every_{};
+    std::array<uint16_t, kMaxTags> skipped_{};
+  };
+
+  void HandleEvent(const Event& event) PW_LOCKS_EXCLUDED(lock_);
+  void AddToBatch(const pubsub_Event& event) PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void FlushBatch() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void FlushCallback(pw::chrono::SystemClock::time_point);
+
+  Worker* worker_ = nullptr;
   PubSub* pubsub_ = nullptr;
-  ServerWriter<pubsub_Event> stream_;
+
+  /// A `Subscribe` stream and the events it could not send yet.
+  class Stream {
+   public:
+    void Open(const pubsub_SubscribeRequest& request,
+              ServerWriter<pubsub_Event>&& writer);
+
+    bool active() const { return writer_.active(); }
+    EventFilter& filter() { return filter_; }
+
+    /// Sends an event, or holds it according to the backpressure policy if
+    /// the channel does not accept it. `dispatch_time_us` is sent with the
+    /// event if the stream captures.
+    void Send(const Event& event,
+              const pubsub_Event& proto,
+              int64_t dispatch_time_us);
+
+   private:
+    /// A held event. Holds its own reference to the event's payload, if
+    /// any, since the bus releases its reference once dispatch returns.
+    struct PendingEvent {
+      Event event;
+      int64_t dispatch_time_us;
+    };
+
+    bool Write(const pubsub_Event& proto, int64_t dispatch_time_us);
+    bool SendPending();
+    void Hold(const Event& event, int64_t dispatch_time_us);
+    void PopPending();
+    void ClearPending();
+
+    ServerWriter<pubsub_Event> writer_;
+    EventFilter filter_;
+    pubsub_SubscribeRequest_Backpressure backpressure_ =
+        pubsub_SubscribeRequest_Backpressure_DROP_NEWEST;
+    pw::InlineDeque<PendingEvent, kMaxPendingEvents> pending_;
+    uint32_t dropped_ = 0;
+    bool capture_ = false;
+  };
+
+  pw::sync::Mutex lock_;
+  std::array<Stream, kMaxStreams> streams_ PW_GUARDED_BY(lock_);
+
+  ServerWriter<pubsub_EventBatch> batch_stream_ PW_GUARDED_BY(lock_);
+  EventFilter batch_filter_ PW_GUARDED_BY(lock_);
+  pubsub_EventBatch batch_ PW_GUARDED_BY(lock_) =
+      pubsub_EventBatch_init_default;
+  size_t max_batch_events_ PW_GUARDED_BY(lock_) = kMaxBatchEvents;
+  pw::chrono::SystemClock::duration max_batch_delay_ PW_GUARDED_BY(lock_) =
+      pw::chrono::SystemClock::for_at_least(kDefaultBatchDelay);
+  pw::chrono::SystemTimer flush_timer_;
 };
 
 }  // namespace sense
@@ -14,8 +14,12 @@
 
 #include "modules/pubsub/service.h"
 
+#include <chrono>
+
+#include "modules/pubsub/payload.h"
 #include "modules/pubsub/pubsub_events.h"
 #include "modules/worker/test_worker.h"
+#include "pw_chrono/system_clock.h"
 #include "pw_rpc/nanopb/test_method_context.h"
 #include "pw_rpc/test_helpers.h"
 #include "pw_sync/timed_thread_notification.h"
@@ -36,6 +40,13 @@ class PubSubServiceTest : public ::testing::Test {
 
   void TearDown() override { worker_.Stop(); }
 
+  // Waits for the events published so far to be dispatched.
+  void Flush() {
+    pw::sync::ThreadNotification flushed;
+    worker_.RunOnce([&flushed]() { flushed.release(); });
+    flushed.acquire();
+  }
+
   sense::TestWorker<> worker_;
   PubSub pubsub_;
 
@@ -47,7 +58,7 @@ class PubSubServiceTest : public ::testing::Test {
 
 TEST_F(PubSubServiceTest, Subscribe) {
   PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
-  ctx.service().Init(pubsub_);
+  ctx.service().Init(worker_, pubsub_);
   ctx.call({});
 
   pw::rpc::test::WaitForPackets(ctx.output(), 3, [this] {
@@ -63,11 +74,252 @@ TEST_F(PubSubServiceTest, Subscribe) {
   EXPECT_EQ(ctx.responses()[1].type.button_b_pressed, false);
   ASSERT_EQ(ctx.responses()[2].which_type, pubsub_Event_button_y_pressed_tag);
   EXPECT_EQ(ctx.responses()[2].type.button_y_pressed, true);
+  EXPECT_EQ(ctx.responses()[0].dispatch_time_us, 0);
+}
+
+TEST_F(PubSubServiceTest, Subscribe_Capture) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.capture = true;
+  ctx.call(request);
+
+  const int64_t start_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          pw::chrono::SystemClock::now().time_since_epoch())
+          .count();
+  pw::rpc::test::WaitForPackets(ctx.output(), 2, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonA(false)));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), 2u);
+  EXPECT_GE(ctx.responses()[0].dispatch_time_us, start_us);
+  EXPECT_GE(ctx.responses()[1].dispatch_time_us,
+            ctx.responses()[0].dispatch_time_us);
+}
+
+TEST_F(PubSubServiceTest, Subscribe_HeldPayloadIsRetained) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  ctx.call({});
+  sense::PayloadPoolBuffer<16, 1> pool;
+
+  // The channel is backed up, so the stream holds the Morse request.
+  ctx.output().set_send_status(pw::Status::Unavailable());
+  pw::Result<sense::Payload> payload = pool.Allocate("SOS");
+  ASSERT_EQ(payload.status(), pw::OkStatus());
+  EXPECT_TRUE(pubsub_.Publish(
+      sense::MorseEncodeRequest{.payload = *payload, .repeat = 1}));
+  Flush();
+
+  // The bus has released its reference, but the held event keeps the text.
+  EXPECT_EQ(pool.available(), 0u);
+  EXPECT_EQ(pool.Allocate("XXX").status(), pw::Status::ResourceExhausted());
+
+  ctx.output().set_send_status(pw::OkStatus());
+  pw::rpc::test::WaitForPackets(ctx.output(), 2, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  });
+  ASSERT_EQ(ctx.responses().size(), 2u);
+  ASSERT_EQ(ctx.responses()[0].which_type,
+            pubsub_Event_morse_encode_request_tag);
+  EXPECT_STREQ(ctx.responses()[0].type.morse_encode_request.msg, "SOS");
+  EXPECT_EQ(pool.available(), 1u);
+}
+
+TEST_F(PubSubServiceTest, Subscribe_ConcurrentStreams) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) other;
+  ctx.service().Init(worker_, pubsub_);
+  ctx.call({});
+
+  // The second stream only wants air quality, on a call of its own.
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.event_mask = 1u << pubsub_Event_air_quality_tag;
+  auto writer = other.writer();
+  ctx.service().Subscribe(request, writer);
+
+  pw::rpc::test::WaitForPackets(other.output(), 1, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+    EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 256u}));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), 2u);
+  EXPECT_EQ(ctx.responses()[0].which_type, pubsub_Event_button_a_pressed_tag);
+  EXPECT_EQ(ctx.responses()[1].which_type, pubsub_Event_air_quality_tag);
+  ASSERT_EQ(other.responses().size(), 1u);
+  ASSERT_EQ(other.responses()[0].which_type, pubsub_Event_air_quality_tag);
+  EXPECT_EQ(other.responses()[0].type.air_quality, 256u);
+}
+
+TEST_F(PubSubServiceTest, Subscribe_RejectsStreamWhenAllAreInUse) {
+  static_assert(sense::PubSubService::kMaxStreams == 3);
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) first;
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) second;
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) third;
+  ctx.service().Init(worker_, pubsub_);
+  auto first_writer = first.writer();
+  auto second_writer = second.writer();
+  auto third_writer = third.writer();
+  ctx.service().Subscribe({}, first_writer);
+  ctx.service().Subscribe({}, second_writer);
+  ctx.service().Subscribe({}, third_writer);
+
+  ctx.call({});
+  ASSERT_TRUE(ctx.done());
+  EXPECT_EQ(ctx.status(), pw::Status::ResourceExhausted());
+
+  // The streams already open keep receiving events.
+  pw::rpc::test::WaitForPackets(third.output(), 1, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonB(true)));
+  });
+  EXPECT_EQ(first.responses().size(), 1u);
+  EXPECT_EQ(second.responses().size(), 1u);
+  EXPECT_TRUE(ctx.responses().empty());
+}
+
+class PubSubServiceBackpressureTest : public PubSubServiceTest {
+ protected:
+  static constexpr size_t kMaxPending =
+      sense::PubSubService::kMaxPendingEvents;
+
+  // Publishes proximity samples 1 through `count` while the channel is
+  // backed up, one at a time so that the bus itself never drops any.
+  template <typename Context>
+  void PublishWhileBackedUp(Context& ctx, size_t count) {
+    ctx.output().set_send_status(pw::Status::Unavailable());
+    for (size_t i = 1; i <= count; ++i) {
+      EXPECT_TRUE(pubsub_.Publish(
+          sense::ProximitySample{.sample = static_cast<uint16_t>(i)}));
+      Flush();
+    }
+    ctx.output().set_send_status(pw::OkStatus());
+  }
+};
+
+TEST_F(PubSubServiceBackpressureTest, DropNewestKeepsHeldEvents) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.backpressure = pubsub_SubscribeRequest_Backpressure_DROP_NEWEST;
+  ctx.call(request);
+
+  PublishWhileBackedUp(ctx, kMaxPending + 2);
+  pw::rpc::test::WaitForPackets(ctx.output(), kMaxPending + 1, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ProximitySample{.sample = 100}));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), kMaxPending + 1);
+  for (size_t i = 0; i < kMaxPending; ++i) {
+    EXPECT_EQ(ctx.responses()[i].type.proximity_level, i + 1);
+  }
+  EXPECT_EQ(ctx.responses()[kMaxPending].type.proximity_level, 100u);
+  // The first event delivered reports the two that did not fit.
+  EXPECT_EQ(ctx.responses()[0].dropped, 2u);
+  EXPECT_EQ(ctx.responses()[1].dropped, 0u);
+  EXPECT_EQ(ctx.responses()[kMaxPending].dropped, 0u);
+}
+
+TEST_F(PubSubServiceBackpressureTest, DropOldestKeepsLatestEvents) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.backpressure = pubsub_SubscribeRequest_Backpressure_DROP_OLDEST;
+  ctx.call(request);
+
+  PublishWhileBackedUp(ctx, kMaxPending + 2);
+  pw::rpc::test::WaitForPackets(ctx.output(), kMaxPending + 1, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ProximitySample{.sample = 100}));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), kMaxPending + 1);
+  for (size_t i = 0; i < kMaxPending; ++i) {
+    EXPECT_EQ(ctx.responses()[i].type.proximity_level, i + 3);
+  }
+  EXPECT_EQ(ctx.responses()[kMaxPending].type.proximity_level, 100u);
+  EXPECT_EQ(ctx.responses()[0].dropped, 2u);
+  EXPECT_EQ(ctx.responses()[1].dropped, 0u);
+}
+
+TEST_F(PubSubServiceBackpressureTest, ConflateKeepsLatestOfEachType) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.backpressure = pubsub_SubscribeRequest_Backpressure_CONFLATE;
+  ctx.call(request);
+
+  ctx.output().set_send_status(pw::Status::Unavailable());
+  EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 1u}));
+  EXPECT_TRUE(pubsub_.Publish(sense::ButtonA(true)));
+  Flush();
+  EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 2u}));
+  EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 3u}));
+  Flush();
+  ctx.output().set_send_status(pw::OkStatus());
+
+  pw::rpc::test::WaitForPackets(ctx.output(), 3, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonB(false)));
+  });
+
+  // The newer scores replace the held one in place, so order is preserved.
+  ASSERT_EQ(ctx.responses().size(), 3u);
+  ASSERT_EQ(ctx.responses()[0].which_type, pubsub_Event_air_quality_tag);
+  EXPECT_EQ(ctx.responses()[0].type.air_quality, 3u);
+  EXPECT_EQ(ctx.responses()[0].dropped, 2u);
+  EXPECT_EQ(ctx.responses()[1].which_type, pubsub_Event_button_a_pressed_tag);
+  EXPECT_EQ(ctx.responses()[2].which_type, pubsub_Event_button_b_pressed_tag);
+  EXPECT_EQ(ctx.responses()[2].dropped, 0u);
+}
+
+TEST_F(PubSubServiceTest, Subscribe_Filtered) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Subscribe) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  pubsub_SubscribeRequest request = pubsub_SubscribeRequest_init_default;
+  request.event_mask = (1u << pubsub_Event_air_quality_tag) |
+                       (1u << pubsub_Event_proximity_level_tag);
+  request.decimation_count = 1;
+  request.decimation[0] = {.field = pubsub_Event_proximity_level_tag,
+                           .keep_every = 2};
+  ctx.call(request);
+
+  pw::rpc::test::WaitForPackets(ctx.output(), 2, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::ProximitySample{.sample = 1u}));
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonB(false)));
+    EXPECT_TRUE(pubsub_.Publish(sense::ProximitySample{.sample = 2u}));
+    EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 256u}));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), 2u);
+  ASSERT_EQ(ctx.responses()[0].which_type, pubsub_Event_proximity_level_tag);
+  EXPECT_EQ(ctx.responses()[0].type.proximity_level, 2u);
+  ASSERT_EQ(ctx.responses()[1].which_type, pubsub_Event_air_quality_tag);
+  EXPECT_EQ(ctx.responses()[1].type.air_quality, 256u);
+}
+
+TEST_F(PubSubServiceTest, SubscribeBatched) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, SubscribeBatched) ctx;
+  ctx.service().Init(worker_, pubsub_);
+  ctx.call({.max_events = 3, .max_delay_ms = 60'000});
+
+  pw::rpc::test::WaitForPackets(ctx.output(), 1, [this] {
+    EXPECT_TRUE(pubsub_.Publish(sense::AirQuality{.score = 256u}));
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonB(false)));
+    EXPECT_TRUE(pubsub_.Publish(sense::ButtonY(true)));
+  });
+
+  ASSERT_EQ(ctx.responses().size(), 1u);
+  const pubsub_EventBatch& batch = ctx.responses()[0];
+  ASSERT_EQ(batch.events_count, 3u);
+  EXPECT_EQ(batch.events[0].which_type, pubsub_Event_air_quality_tag);
+  EXPECT_EQ(batch.events[1].which_type, pubsub_Event_button_b_pressed_tag);
+  EXPECT_EQ(batch.events[2].which_type, pubsub_Event_button_y_pressed_tag);
 }
 
 TEST_F(PubSubServiceTest, Publish) {
   PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, Publish) ctx;
-  ctx.service().Init(pubsub_);
+  ctx.service().Init(worker_, pubsub_);
 
   ASSERT_TRUE(pubsub_.Subscribe([this](sense::Event event) {
     events_processed_++;
@@ -126,4 +378,30 @@ TEST_F(PubSubServiceTest, Publish) {
   EXPECT_EQ(button_presses_, 2u);
 }
 
+TEST_F(PubSubServiceTest, GetStats) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(sense::PubSubService, GetStats) ctx;
+  ctx.service().Init(worker_, pubsub_);
+
+  pw::sync::ThreadNotification pause;
+  worker_.RunOnce([&pause]() { pause.acquire(); });
+  // Small events are packed, so fill the queue until one is dropped.
+  uint32_t queued = 0;
+  while (pubsub_.Publish(sense::ButtonA(true))) {
+    ++queued;
+  }
+  EXPECT_GE(queued, kMaxEvents);
+  EXPECT_FALSE(pubsub_.Publish(sense::AirQuality{.score = 256u}));
+
+  ASSERT_EQ(ctx.call({}), pw::OkStatus());
+  pause.release();
+
+  const pubsub_Stats& stats = ctx.response();
+  ASSERT_EQ(stats.published_count, std::variant_size_v<sense::Event>);
+  EXPECT_EQ(stats.published[sense::kButtonA], queued);
+  EXPECT_EQ(stats.published[sense::kAirQuality], 0u);
+  EXPECT_EQ(stats.dropped[sense::kAirQuality], 1u);
+  EXPECT_EQ(stats.queue_high_water_mark, queued);
+  EXPECT_EQ(stats.max_callback_us_count, kMaxSubscribers);
+}
+
 }  // namespace
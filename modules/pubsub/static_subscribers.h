@@ -0,0 +1,62 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <variant>
+
+namespace sense {
+
+/// Passed to the constructors of objects that a `StaticSubscribers` list
+/// routes events to, so that they do not also subscribe at runtime.
+struct StaticallySubscribed {
+  explicit constexpr StaticallySubscribed() = default;
+};
+inline constexpr StaticallySubscribed kStaticallySubscribed{};
+
+/// A build-time subscriber that calls `kHandler` with every event.
+template <auto kHandler>
+struct StaticSubscriber {
+  template <typename Event>
+  static void Dispatch(const Event& event) {
+    kHandler(event);
+  }
+};
+
+/// A build-time subscriber that calls `kHandler` with events of type `T`,
+/// unpacked from the event variant.
+template <typename T, auto kHandler>
+struct StaticSubscriberTo {
+  template <typename Event>
+  static void Dispatch(const Event& event) {
+    if (const T* value = std::get_if<T>(&event)) {
+      kHandler(*value);
+    }
+  }
+};
+
+/// A subscriber list fixed at build time, for `GenericPubSub`'s
+/// `SetStaticSubscribers`.
+///
+/// The handlers are called directly, in order, so the compiler sees every
+/// call: dispatch becomes a branch on the variant index with the handlers
+/// inlined, and no `pw::Function` is stored for them.
+template <typename... Subscribers>
+struct StaticSubscribers {
+  template <typename Event>
+  static void Dispatch(const Event& event) {
+    (Subscribers::template Dispatch<Event>(event), ...);
+  }
+};
+
+}  // namespace sense
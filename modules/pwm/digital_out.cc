@@ -14,6 +14,8 @@
 
 #include "modules/pwm/digital_out.h"
 
+#include <algorithm>
+
 #include "pw_assert/check.h"
 
 namespace sense {
@@ -28,6 +30,29 @@ void PwmDigitalOut::SetCallback(Callback&& callback,
                     std::chrono::milliseconds(interval_ms)));
 };
 
+void PwmDigitalOut::SetLevels(pw::span<const LevelUpdate> updates) {
+  if (updates.empty()) {
+    return;
+  }
+  const void* batch_id = updates.front().output->batch_id_;
+  if (batch_id != nullptr &&
+      std::all_of(updates.begin(), updates.end(), [batch_id](auto& update) {
+        return update.output->batch_id_ == batch_id;
+      })) {
+    updates.front().output->DoSetLevels(updates);
+    return;
+  }
+  for (const LevelUpdate& update : updates) {
+    update.output->DoSetLevel(update.level);
+  }
+}
+
+void PwmDigitalOut::DoSetLevels(pw::span<const LevelUpdate> updates) {
+  for (const LevelUpdate& update : updates) {
+    update.output->DoSetLevel(update.level);
+  }
+}
+
 void PwmDigitalOut::ClearCallback() {
   DoClearCallback();
   // Clear callback_ after running the implementation's ClearCallback so that
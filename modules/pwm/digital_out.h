@@ -17,6 +17,7 @@
 
 #include "pw_chrono/system_clock.h"
 #include "pw_function/function.h"
+#include "pw_span/span.h"
 
 namespace sense {
 
@@ -25,6 +26,12 @@ class PwmDigitalOut {
  public:
   using Callback = ::pw::Function<void()>;
 
+  /// New level for one of several outputs set by `SetLevels`.
+  struct LevelUpdate {
+    PwmDigitalOut* output;
+    uint16_t level;
+  };
+
   virtual ~PwmDigitalOut() = default;
 
   /// Sets the output to be driven by the PWM block.
@@ -38,6 +45,13 @@ class PwmDigitalOut {
   /// 0 is off, std::limits::max<uint16_t> is full on.
   void SetLevel(uint16_t level) { DoSetLevel(level); }
 
+  /// Sets the levels of several outputs together.
+  ///
+  /// If every output has the same implementation, it may write the levels in
+  /// fewer register accesses, e.g. so that channels sharing hardware change
+  /// in the same PWM period. Otherwise, the levels are set one at a time.
+  static void SetLevels(pw::span<const LevelUpdate> updates);
+
   /// Sets a callback to invoke periodically. Only one callback may be set at a
   /// time across all `PwmDigitalOut` instances.
   ///
@@ -59,11 +73,18 @@ class PwmDigitalOut {
  protected:
   PwmDigitalOut() = default;
 
+  /// Constructs an output that overrides `DoSetLevels`. Outputs constructed
+  /// with the same non-null `batch_id` are passed to `DoSetLevels` together.
+  explicit PwmDigitalOut(const void* batch_id) : batch_id_(batch_id) {}
+
   // Invokes the callback, which MUST be set!
   void InvokeCallback() const { callback_(); }
 
   void ClearCallbackFunction() { callback_ = nullptr; }
 
+  /// Sets the levels of outputs whose batch ID matches this one's.
+  virtual void DoSetLevels(pw::span<const LevelUpdate> updates);
+
  private:
   virtual void DoEnable() = 0;
 
@@ -77,6 +98,9 @@ class PwmDigitalOut {
   virtual void DoClearCallback() = 0;
 
   Callback callback_;
+
+  // Not virtual, so that `SetLevels` can check a whole batch cheaply.
+  const void* batch_id_ = nullptr;
 };
 
 }  // namespace sense
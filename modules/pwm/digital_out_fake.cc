@@ -63,8 +63,10 @@ void PwmDigitalOutFake::DoSetLevel(uint16_t level) {
 }
 
 void PwmDigitalOutFake::DoSetCallback(uint16_t,
-                                      pw::chrono::SystemClock::duration) {}
+                                      pw::chrono::SystemClock::duration) {
+  has_callback_ = true;
+}
 
-void PwmDigitalOutFake::DoClearCallback() {}
+void PwmDigitalOutFake::DoClearCallback() { has_callback_ = false; }
 
 }  // namespace sense
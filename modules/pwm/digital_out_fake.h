@@ -48,6 +48,16 @@ class PwmDigitalOutFake : public PwmDigitalOut {
   /// Returns whether `SetLevel` is called before the given expiration.
   bool TryAwaitUntil(pw::chrono::SystemClock::time_point expiration);
 
+  /// Returns whether a periodic callback is set.
+  bool has_callback() const { return has_callback_; }
+
+  /// Invokes the periodic callback, as the PWM interrupt would.
+  void Tick() {
+    if (has_callback_) {
+      InvokeCallback();
+    }
+  }
+
  private:
   void DoEnable() override;
 
@@ -61,6 +71,7 @@ class PwmDigitalOutFake : public PwmDigitalOut {
   void DoClearCallback() override;
 
   bool enabled_ = false;
+  bool has_callback_ = false;
   uint16_t level_ = 0;
   bool sync_ = false;
   pw::sync::TimedThreadNotification notify_;
@@ -0,0 +1,132 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/rpc_mux/rpc_multiplexer.h"
+
+#include "pw_rpc/internal/packet.h"
+#include "pw_status/status.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+using ::pw::rpc::internal::Packet;
+using ::pw::rpc::internal::pwpb::PacketType;
+
+namespace {
+
+// Whether the server sends nothing more for a call after this packet.
+bool EndsCall(PacketType type) {
+  return type == PacketType::RESPONSE || type == PacketType::SERVER_ERROR;
+}
+
+}  // namespace
+
+pw::Result<pw::ConstByteSpan> RpcMultiplexer::FromClient(
+    ClientId client, pw::ConstByteSpan packet, pw::ByteSpan buffer) {
+  pw::Result<Packet> decoded = Packet::FromBuffer(packet);
+  if (!decoded.ok()) {
+    return pw::Status::DataLoss();
+  }
+  const ClientCall call{
+      .client = client,
+      .channel_id = decoded->channel_id(),
+      .service_id = decoded->service_id(),
+      .method_id = decoded->method_id(),
+      .call_id = decoded->call_id(),
+  };
+
+  auto found = server_call_ids_.find(call);
+  const bool new_call = found == server_call_ids_.end();
+  if (new_call) {
+    if (decoded->type() != PacketType::REQUEST) {
+      return pw::Status::NotFound();
+    }
+    const uint32_t server_call_id = AllocateCallId();
+    found = server_call_ids_.emplace(call, server_call_id).first;
+    calls_.emplace(server_call_id, call);
+  }
+
+  const uint32_t server_call_id = found->second;
+  decoded->set_call_id(server_call_id);
+  pw::Result<pw::ConstByteSpan> encoded = decoded->Encode(buffer);
+
+  if ((new_call && !encoded.ok()) ||
+      decoded->type() == PacketType::CLIENT_ERROR) {
+    server_call_ids_.erase(found);
+    calls_.erase(server_call_id);
+  }
+  return encoded;
+}
+
+pw::Result<RpcMultiplexer::Routed> RpcMultiplexer::FromServer(
+    pw::ConstByteSpan packet, pw::ByteSpan buffer) {
+  pw::Result<Packet> decoded = Packet::FromBuffer(packet);
+  if (!decoded.ok()) {
+    return pw::Status::DataLoss();
+  }
+
+  auto found = calls_.find(decoded->call_id());
+  if (found == calls_.end()) {
+    return Routed{.client = kAllClients, .packet = packet};
+  }
+
+  const ClientCall call = found->second;
+  decoded->set_call_id(call.call_id);
+  PW_TRY_ASSIGN(pw::ConstByteSpan encoded, decoded->Encode(buffer));
+
+  if (EndsCall(decoded->type())) {
+    server_call_ids_.erase(call);
+    calls_.erase(found);
+  }
+  return Routed{.client = call.client, .packet = encoded};
+}
+
+void RpcMultiplexer::RemoveClient(
+    ClientId client,
+    pw::ByteSpan buffer,
+    const pw::Function<void(pw::ConstByteSpan)>& send_to_server) {
+  for (auto it = calls_.begin(); it != calls_.end();) {
+    const ClientCall& call = it->second;
+    if (call.client != client) {
+      ++it;
+      continue;
+    }
+    const Packet cancel(PacketType::CLIENT_ERROR,
+                        call.channel_id,
+                        call.service_id,
+                        call.method_id,
+                        it->first,
+                        {},
+                        pw::Status::Cancelled());
+    if (pw::Result<pw::ConstByteSpan> encoded = cancel.Encode(buffer);
+        encoded.ok()) {
+      send_to_server(*encoded);
+    }
+    server_call_ids_.erase(call);
+    it = calls_.erase(it);
+  }
+}
+
+uint32_t RpcMultiplexer::AllocateCallId() {
+  // Zero means "unassigned" and the maximum is reserved for open calls, so
+  // neither is handed out. Skip IDs still in use after wrapping.
+  while (next_call_id_ == 0 ||
+         next_call_id_ == std::numeric_limits<uint32_t>::max() ||
+         calls_.count(next_call_id_) != 0) {
+    ++next_call_id_;
+  }
+  return next_call_id_++;
+}
+
+}  // namespace sense
@@ -0,0 +1,97 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <tuple>
+
+#include "pw_bytes/span.h"
+#include "pw_function/function.h"
+#include "pw_result/result.h"
+
+namespace sense {
+
+/// Shares one RPC channel between many clients.
+///
+/// Clients number their calls independently, so the same call ID arrives from
+/// several of them at once and the server would treat those calls as one. The
+/// multiplexer gives each client call a server call ID that is unique across
+/// all clients, rewrites packets to the server with it, and restores the
+/// client's own ID on packets coming back.
+///
+/// Packets are `pw.rpc.internal.RpcPacket` messages, without HDLC framing.
+class RpcMultiplexer {
+ public:
+  using ClientId = uint32_t;
+
+  /// Destination of server packets that belong to no call of a known client.
+  static constexpr ClientId kAllClients = std::numeric_limits<ClientId>::max();
+
+  struct Routed {
+    ClientId client;
+    pw::ConstByteSpan packet;
+  };
+
+  /// Rewrites a packet from `client` for the server, encoding it into
+  /// `buffer`.
+  ///
+  /// @returns DataLoss if the packet does not decode, NotFound if it refers to
+  /// a call that is not open, and ResourceExhausted if `buffer` is too small.
+  pw::Result<pw::ConstByteSpan> FromClient(ClientId client,
+                                           pw::ConstByteSpan packet,
+                                           pw::ByteSpan buffer);
+
+  /// Finds the client a packet from the server is for and restores that
+  /// client's call ID, encoding the packet into `buffer`. Packets for unknown
+  /// calls are passed through unchanged to `kAllClients`.
+  pw::Result<Routed> FromServer(pw::ConstByteSpan packet, pw::ByteSpan buffer);
+
+  /// Forgets a client that disconnected. Calls it left open are cancelled by
+  /// passing a client error packet for each to `send_to_server`.
+  void RemoveClient(
+      ClientId client,
+      pw::ByteSpan buffer,
+      const pw::Function<void(pw::ConstByteSpan)>& send_to_server);
+
+  /// Number of calls open across all clients.
+  size_t open_calls() const { return calls_.size(); }
+
+ private:
+  struct ClientCall {
+    ClientId client;
+    uint32_t channel_id;
+    uint32_t service_id;
+    uint32_t method_id;
+    uint32_t call_id;
+
+    bool operator<(const ClientCall& other) const {
+      return std::tie(client, channel_id, service_id, method_id, call_id) <
+             std::tie(other.client,
+                      other.channel_id,
+                      other.service_id,
+                      other.method_id,
+                      other.call_id);
+    }
+  };
+
+  uint32_t AllocateCallId();
+
+  std::map<ClientCall, uint32_t> server_call_ids_;
+  std::map<uint32_t, ClientCall> calls_;
+  uint32_t next_call_id_ = 1;
+};
+
+}  // namespace sense
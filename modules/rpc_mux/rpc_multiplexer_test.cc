@@ -0,0 +1,140 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/rpc_mux/rpc_multiplexer.h"
+
+#include <array>
+#include <cstddef>
+
+#include "pw_assert/check.h"
+#include "pw_containers/vector.h"
+#include "pw_rpc/internal/packet.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using ::pw::rpc::internal::Packet;
+using ::pw::rpc::internal::pwpb::PacketType;
+
+constexpr uint32_t kChannelId = 1;
+constexpr uint32_t kServiceId = 0x5e45;
+constexpr uint32_t kMethodId = 0x0bad;
+
+class RpcMultiplexerTest : public ::testing::Test {
+ protected:
+  pw::ConstByteSpan Encode(PacketType type, uint32_t call_id) {
+    const Packet packet(type, kChannelId, kServiceId, kMethodId, call_id);
+    pw::Result<pw::ConstByteSpan> encoded = packet.Encode(input_);
+    PW_CHECK_OK(encoded.status());
+    return *encoded;
+  }
+
+  static Packet Decode(pw::ConstByteSpan bytes) {
+    pw::Result<Packet> packet = Packet::FromBuffer(bytes);
+    PW_CHECK_OK(packet.status());
+    return *packet;
+  }
+
+  uint32_t SendFromClient(RpcMultiplexer::ClientId client,
+                          PacketType type,
+                          uint32_t call_id) {
+    pw::Result<pw::ConstByteSpan> packet =
+        mux_.FromClient(client, Encode(type, call_id), output_);
+    PW_CHECK_OK(packet.status());
+    return Decode(*packet).call_id();
+  }
+
+  RpcMultiplexer mux_;
+  std::array<std::byte, 64> input_;
+  std::array<std::byte, 64> output_;
+};
+
+TEST_F(RpcMultiplexerTest, GivesClientsDistinctServerCallIds) {
+  const uint32_t first = SendFromClient(1, PacketType::REQUEST, 1);
+  const uint32_t second = SendFromClient(2, PacketType::REQUEST, 1);
+  EXPECT_NE(first, 0u);
+  EXPECT_NE(second, 0u);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(mux_.open_calls(), 2u);
+
+  // Later packets on the same call reuse its server call ID.
+  EXPECT_EQ(SendFromClient(1, PacketType::CLIENT_STREAM, 1), first);
+}
+
+TEST_F(RpcMultiplexerTest, RoutesServerPacketsBackToTheirClient) {
+  SendFromClient(1, PacketType::REQUEST, 7);
+  const uint32_t server_call = SendFromClient(2, PacketType::REQUEST, 7);
+
+  pw::Result<RpcMultiplexer::Routed> routed =
+      mux_.FromServer(Encode(PacketType::SERVER_STREAM, server_call), output_);
+  ASSERT_EQ(routed.status(), pw::OkStatus());
+  EXPECT_EQ(routed->client, 2u);
+  EXPECT_EQ(Decode(routed->packet).call_id(), 7u);
+  EXPECT_EQ(mux_.open_calls(), 2u);
+
+  routed = mux_.FromServer(Encode(PacketType::RESPONSE, server_call), output_);
+  ASSERT_EQ(routed.status(), pw::OkStatus());
+  EXPECT_EQ(routed->client, 2u);
+  EXPECT_EQ(Decode(routed->packet).type(), PacketType::RESPONSE);
+  EXPECT_EQ(mux_.open_calls(), 1u);
+}
+
+TEST_F(RpcMultiplexerTest, DropsClientPacketsForCallsThatAreNotOpen) {
+  EXPECT_EQ(
+      mux_.FromClient(1, Encode(PacketType::CLIENT_STREAM, 3), output_)
+          .status(),
+      pw::Status::NotFound());
+
+  SendFromClient(1, PacketType::REQUEST, 3);
+  SendFromClient(1, PacketType::CLIENT_ERROR, 3);
+  EXPECT_EQ(mux_.open_calls(), 0u);
+}
+
+TEST_F(RpcMultiplexerTest, BroadcastsServerPacketsForUnknownCalls) {
+  pw::Result<RpcMultiplexer::Routed> routed =
+      mux_.FromServer(Encode(PacketType::SERVER_STREAM, 42), output_);
+  ASSERT_EQ(routed.status(), pw::OkStatus());
+  EXPECT_EQ(routed->client, RpcMultiplexer::kAllClients);
+  EXPECT_EQ(Decode(routed->packet).call_id(), 42u);
+}
+
+TEST_F(RpcMultiplexerTest, RejectsMalformedPackets) {
+  constexpr std::array<std::byte, 3> kGarbage = {
+      std::byte{0xff}, std::byte{0xff}, std::byte{0xff}};
+  EXPECT_EQ(mux_.FromClient(1, kGarbage, output_).status(),
+            pw::Status::DataLoss());
+  EXPECT_EQ(mux_.FromServer(kGarbage, output_).status(),
+            pw::Status::DataLoss());
+}
+
+TEST_F(RpcMultiplexerTest, CancelsCallsOfRemovedClient) {
+  const uint32_t removed_call = SendFromClient(1, PacketType::REQUEST, 1);
+  SendFromClient(2, PacketType::REQUEST, 1);
+
+  pw::Vector<uint32_t, 4> cancelled;
+  mux_.RemoveClient(1, input_, [&cancelled](pw::ConstByteSpan bytes) {
+    const Packet packet = Decode(bytes);
+    EXPECT_EQ(packet.type(), PacketType::CLIENT_ERROR);
+    EXPECT_EQ(packet.status(), pw::Status::Cancelled());
+    cancelled.push_back(packet.call_id());
+  });
+
+  ASSERT_EQ(cancelled.size(), 1u);
+  EXPECT_EQ(cancelled[0], removed_call);
+  EXPECT_EQ(mux_.open_calls(), 1u);
+}
+
+}  // namespace
+}  // namespace sense
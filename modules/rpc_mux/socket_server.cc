@@ -0,0 +1,411 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "RPC_MUX"
+
+#include "modules/rpc_mux/socket_server.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "pw_hdlc/default_addresses.h"
+#include "pw_hdlc/encoder.h"
+#include "pw_log/log.h"
+#include "pw_status/try.h"
+#include "pw_stream/memory_stream.h"
+#include "pw_thread/thread.h"
+#include "pw_thread_stl/options.h"
+
+namespace sense {
+namespace {
+
+// Frames grow when bytes are escaped, so leave room for the worst case.
+constexpr size_t kMaxEncodedFrameSize = 2 * SocketServer::kMaxFrameSize + 16;
+
+// How long a send waits for a client to make room before giving up on it.
+constexpr int kSendTimeoutMs = 500;
+
+constexpr int kMaxEvents = 32;
+
+}  // namespace
+
+struct SocketServer::Client {
+  Client(int client_fd, RpcMultiplexer::ClientId client_id)
+      : fd(client_fd), id(client_id) {}
+
+  const int fd;
+  const RpcMultiplexer::ClientId id;
+  /// Set once a send fails. The client is dropped when the I/O thread sees
+  /// the socket close.
+  bool closing = false;
+  uint64_t frames_in = 0;
+  uint64_t frames_out = 0;
+  /// Only used from the I/O thread.
+  pw::hdlc::DecoderBuffer<kMaxFrameSize> decoder;
+};
+
+SocketServer::SocketServer() : reader_(*this), writer_(*this) {}
+
+SocketServer::~SocketServer() {
+  for (int fd : {epoll_fd_, tcp_fd_, unix_fd_}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+pw::Status SocketServer::Start(const Options& options) {
+  if (epoll_fd_ >= 0) {
+    return pw::Status::FailedPrecondition();
+  }
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    PW_LOG_ERROR("Failed to create epoll instance: %s", std::strerror(errno));
+    return pw::Status::Unavailable();
+  }
+
+  tcp_fd_ = socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (tcp_fd_ >= 0) {
+    // Allow the simulator to restart while old connections time out.
+    const int enable = 1;
+    setsockopt(tcp_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  }
+  sockaddr_in6 tcp_address = {};
+  tcp_address.sin6_family = AF_INET6;
+  tcp_address.sin6_addr = in6addr_any;
+  tcp_address.sin6_port = htons(options.tcp_port);
+  if (tcp_fd_ < 0 ||
+      bind(tcp_fd_,
+           reinterpret_cast<const sockaddr*>(&tcp_address),
+           sizeof(tcp_address)) != 0) {
+    PW_LOG_ERROR("Failed to bind TCP port %u: %s",
+                 options.tcp_port,
+                 std::strerror(errno));
+    return pw::Status::Unavailable();
+  }
+  PW_TRY(Listen(tcp_fd_));
+
+  if (options.unix_socket_path != nullptr) {
+    sockaddr_un unix_address = {};
+    unix_address.sun_family = AF_UNIX;
+    if (std::strlen(options.unix_socket_path) >=
+        sizeof(unix_address.sun_path)) {
+      PW_LOG_ERROR("Unix socket path is too long");
+      return pw::Status::Unavailable();
+    }
+    std::strcpy(unix_address.sun_path, options.unix_socket_path);
+    unlink(options.unix_socket_path);
+    unix_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unix_fd_ < 0 ||
+        bind(unix_fd_,
+             reinterpret_cast<const sockaddr*>(&unix_address),
+             sizeof(unix_address)) != 0) {
+      PW_LOG_ERROR("Failed to bind %s: %s",
+                   options.unix_socket_path,
+                   std::strerror(errno));
+      return pw::Status::Unavailable();
+    }
+    PW_TRY(Listen(unix_fd_));
+  }
+
+  pw::thread::Thread(pw::thread::stl::Options(), [this] { Run(); }).detach();
+  PW_LOG_INFO("Accepting RPC clients on port %u", options.tcp_port);
+  return pw::OkStatus();
+}
+
+pw::Status SocketServer::Listen(int fd) {
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  if (listen(fd, SOMAXCONN) != 0 ||
+      epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    PW_LOG_ERROR("Failed to listen for clients: %s", std::strerror(errno));
+    return pw::Status::Unavailable();
+  }
+  return pw::OkStatus();
+}
+
+SocketServer::Stats SocketServer::stats() const {
+  std::lock_guard lock(mutex_);
+  Stats stats = stats_;
+  stats.clients = static_cast<uint32_t>(clients_.size());
+  return stats;
+}
+
+void SocketServer::Run() {
+  std::array<epoll_event, kMaxEvents> events;
+  while (true) {
+    const int count = epoll_wait(epoll_fd_, events.data(), kMaxEvents, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      PW_LOG_ERROR("epoll_wait failed: %s", std::strerror(errno));
+      return;
+    }
+    for (int i = 0; i < count; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == tcp_fd_ || fd == unix_fd_) {
+        Accept(fd);
+      } else {
+        ReadFromClient(fd);
+      }
+    }
+  }
+}
+
+void SocketServer::Accept(int listener) {
+  const int fd =
+      accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) {
+    PW_LOG_WARN("Failed to accept client: %s", std::strerror(errno));
+    return;
+  }
+  if (listener == tcp_fd_) {
+    // RPC packets are small, so send them as soon as they are written.
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    PW_LOG_WARN("Failed to watch client: %s", std::strerror(errno));
+    close(fd);
+    return;
+  }
+
+  RpcMultiplexer::ClientId id;
+  size_t connected;
+  {
+    std::lock_guard lock(mutex_);
+    id = next_client_id_++;
+    clients_.emplace(fd, std::make_unique<Client>(fd, id));
+    stats_.total_clients += 1;
+    connected = clients_.size();
+  }
+  PW_LOG_INFO("Client %u connected; %u connected",
+              static_cast<unsigned>(id),
+              static_cast<unsigned>(connected));
+}
+
+void SocketServer::ReadFromClient(int fd) {
+  Client* client;
+  {
+    std::lock_guard lock(mutex_);
+    auto found = clients_.find(fd);
+    if (found == clients_.end()) {
+      return;
+    }
+    client = found->second.get();
+  }
+
+  // Only this thread removes clients, so `client` stays valid.
+  std::array<std::byte, 4096> buffer;
+  while (true) {
+    const ssize_t received = recv(fd, buffer.data(), buffer.size(), 0);
+    if (received == 0) {
+      Disconnect(fd);
+      return;
+    }
+    if (received < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      Disconnect(fd);
+      return;
+    }
+    for (ssize_t i = 0; i < received; ++i) {
+      pw::Result<pw::hdlc::Frame> frame = client->decoder.Process(buffer[i]);
+      if (frame.ok()) {
+        HandleClientFrame(*client, frame->address(), frame->data());
+      } else if (frame.status() != pw::Status::Unavailable()) {
+        std::lock_guard lock(mutex_);
+        stats_.dropped_frames += 1;
+      }
+    }
+  }
+}
+
+void SocketServer::Disconnect(int fd) {
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+
+  std::unique_ptr<Client> client;
+  {
+    std::lock_guard lock(mutex_);
+    auto found = clients_.find(fd);
+    if (found == clients_.end()) {
+      return;
+    }
+    client = std::move(found->second);
+    clients_.erase(found);
+    std::array<std::byte, kMaxFrameSize> buffer;
+    multiplexer_.RemoveClient(
+        client->id, buffer, [this](pw::ConstByteSpan packet) {
+          QueueForServer(pw::hdlc::kDefaultRpcAddress, packet);
+        });
+  }
+  PW_LOG_INFO("Client %u disconnected after %u frames in, %u out",
+              static_cast<unsigned>(client->id),
+              static_cast<unsigned>(client->frames_in),
+              static_cast<unsigned>(client->frames_out));
+}
+
+void SocketServer::HandleClientFrame(Client& client,
+                                     uint64_t address,
+                                     pw::ConstByteSpan payload) {
+  std::lock_guard lock(mutex_);
+  client.frames_in += 1;
+  if (address != pw::hdlc::kDefaultRpcAddress) {
+    QueueForServer(address, payload);
+    return;
+  }
+  std::array<std::byte, kMaxFrameSize> buffer;
+  pw::Result<pw::ConstByteSpan> packet =
+      multiplexer_.FromClient(client.id, payload, buffer);
+  if (!packet.ok()) {
+    stats_.dropped_frames += 1;
+    return;
+  }
+  QueueForServer(address, *packet);
+}
+
+void SocketServer::QueueForServer(uint64_t address,
+                                  pw::ConstByteSpan payload) {
+  pw::stream::MemoryWriterBuffer<kMaxEncodedFrameSize> frame;
+  if (!pw::hdlc::WriteUIFrame(address, payload, frame).ok()) {
+    stats_.dropped_frames += 1;
+    return;
+  }
+  to_server_.insert(
+      to_server_.end(), frame.WrittenData().begin(), frame.WrittenData().end());
+  stats_.frames_to_server += 1;
+  stats_.bytes_to_server += frame.WrittenData().size();
+  frames_ready_.notify_one();
+}
+
+pw::StatusWithSize SocketServer::ServerReader::DoRead(
+    pw::ByteSpan destination) {
+  std::unique_lock lock(server_.mutex_);
+  server_.frames_ready_.wait(lock, [this] {
+    return !server_.to_server_.empty();
+  });
+  const size_t count = std::min(destination.size(), server_.to_server_.size());
+  std::copy_n(server_.to_server_.begin(), count, destination.begin());
+  server_.to_server_.erase(server_.to_server_.begin(),
+                           server_.to_server_.begin() + count);
+  return pw::StatusWithSize(count);
+}
+
+pw::Status SocketServer::ServerWriter::DoWrite(pw::ConstByteSpan data) {
+  for (std::byte byte : data) {
+    pw::Result<pw::hdlc::Frame> frame = server_.server_decoder_.Process(byte);
+    if (frame.ok()) {
+      server_.HandleServerFrame(frame->address(), frame->data());
+    }
+  }
+  return pw::OkStatus();
+}
+
+void SocketServer::HandleServerFrame(uint64_t address,
+                                     pw::ConstByteSpan payload) {
+  size_t dropped_clients = 0;
+  {
+    std::lock_guard lock(mutex_);
+    RpcMultiplexer::Routed routed{.client = RpcMultiplexer::kAllClients,
+                                  .packet = payload};
+    std::array<std::byte, kMaxFrameSize> buffer;
+    if (address == pw::hdlc::kDefaultRpcAddress) {
+      pw::Result<RpcMultiplexer::Routed> result =
+          multiplexer_.FromServer(payload, buffer);
+      if (!result.ok()) {
+        stats_.dropped_frames += 1;
+        return;
+      }
+      routed = *result;
+    }
+
+    for (auto& [fd, client] : clients_) {
+      if ((routed.client == RpcMultiplexer::kAllClients ||
+           routed.client == client->id) &&
+          !SendToClient(*client, address, routed.packet)) {
+        dropped_clients += 1;
+      }
+    }
+  }
+  // Logs may be written back through this stream, so never log while holding
+  // the lock.
+  if (dropped_clients > 0) {
+    PW_LOG_WARN("Dropped %u clients that stopped reading",
+                static_cast<unsigned>(dropped_clients));
+  }
+}
+
+bool SocketServer::SendToClient(Client& client,
+                                uint64_t address,
+                                pw::ConstByteSpan payload) {
+  if (client.closing) {
+    return true;
+  }
+  pw::stream::MemoryWriterBuffer<kMaxEncodedFrameSize> frame;
+  if (!pw::hdlc::WriteUIFrame(address, payload, frame).ok()) {
+    stats_.dropped_frames += 1;
+    return true;
+  }
+
+  pw::ConstByteSpan remaining = frame.WrittenData();
+  while (!remaining.empty()) {
+    const ssize_t sent =
+        send(client.fd, remaining.data(), remaining.size(), MSG_NOSIGNAL);
+    if (sent > 0) {
+      remaining = remaining.subspan(static_cast<size_t>(sent));
+      continue;
+    }
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    pollfd writable = {.fd = client.fd, .events = POLLOUT, .revents = 0};
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        poll(&writable, 1, kSendTimeoutMs) > 0) {
+      continue;
+    }
+    // The I/O thread disconnects the client once it sees the socket close.
+    client.closing = true;
+    shutdown(client.fd, SHUT_RDWR);
+    stats_.dropped_frames += 1;
+    return false;
+  }
+  client.frames_out += 1;
+  stats_.frames_from_server += 1;
+  stats_.bytes_from_server += frame.WrittenData().size();
+  return true;
+}
+
+}  // namespace sense
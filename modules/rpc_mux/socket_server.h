@@ -0,0 +1,149 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "modules/rpc_mux/rpc_multiplexer.h"
+#include "pw_bytes/span.h"
+#include "pw_hdlc/decoder.h"
+#include "pw_status/status.h"
+#include "pw_status/status_with_size.h"
+#include "pw_stream/stream.h"
+
+namespace sense {
+
+/// Serves the host simulator's RPC channel to any number of socket clients.
+///
+/// Listens on a TCP port and, optionally, a Unix socket. One epoll thread
+/// accepts clients and splits what they send into HDLC frames. RPC frames pass
+/// through an `RpcMultiplexer`, so each client keeps its own call IDs, and are
+/// queued for the server's `reader()`. Frames the server writes to `writer()`
+/// are routed back to the client whose call they answer; frames that belong
+/// to no client's call are sent to every client.
+///
+/// A client that stops reading for too long is disconnected rather than
+/// allowed to stall the server.
+class SocketServer {
+ public:
+  struct Options {
+    uint16_t tcp_port = 33000;
+    /// Unix socket to listen on as well, unless null.
+    const char* unix_socket_path = nullptr;
+  };
+
+  /// Traffic since the server started.
+  struct Stats {
+    uint32_t clients;
+    uint32_t total_clients;
+    uint64_t frames_to_server;
+    uint64_t bytes_to_server;
+    uint64_t frames_from_server;
+    uint64_t bytes_from_server;
+    /// Frames that did not decode or could not be routed.
+    uint64_t dropped_frames;
+  };
+
+  /// Largest HDLC frame payload passed in either direction.
+  static constexpr size_t kMaxFrameSize = 2048;
+
+  SocketServer();
+  ~SocketServer();
+
+  SocketServer(const SocketServer&) = delete;
+  SocketServer& operator=(const SocketServer&) = delete;
+
+  /// Opens the listening sockets and starts the I/O thread.
+  ///
+  /// @returns Unavailable if a socket cannot be opened, and
+  /// FailedPrecondition if the server is already started.
+  pw::Status Start(const Options& options);
+
+  /// Stream of frames from all clients, for the RPC server to read.
+  pw::stream::Reader& reader() { return reader_; }
+
+  /// Stream the RPC server writes its frames to.
+  pw::stream::Writer& writer() { return writer_; }
+
+  Stats stats() const;
+
+ private:
+  struct Client;
+
+  class ServerReader final : public pw::stream::NonSeekableReader {
+   public:
+    explicit ServerReader(SocketServer& server) : server_(server) {}
+
+   private:
+    pw::StatusWithSize DoRead(pw::ByteSpan destination) override;
+
+    SocketServer& server_;
+  };
+
+  class ServerWriter final : public pw::stream::NonSeekableWriter {
+   public:
+    explicit ServerWriter(SocketServer& server) : server_(server) {}
+
+   private:
+    pw::Status DoWrite(pw::ConstByteSpan data) override;
+
+    SocketServer& server_;
+  };
+
+  pw::Status Listen(int fd);
+  void Run();
+  void Accept(int listener);
+  void ReadFromClient(int fd);
+  void Disconnect(int fd);
+
+  void HandleClientFrame(Client& client,
+                         uint64_t address,
+                         pw::ConstByteSpan payload);
+  void HandleServerFrame(uint64_t address, pw::ConstByteSpan payload);
+
+  /// Frames a payload and queues it for the server. Requires `mutex_`.
+  void QueueForServer(uint64_t address, pw::ConstByteSpan payload);
+
+  /// Frames a payload and sends it to a client. Returns false if the client
+  /// stopped reading and is being dropped. Requires `mutex_`.
+  bool SendToClient(Client& client,
+                    uint64_t address,
+                    pw::ConstByteSpan payload);
+
+  ServerReader reader_;
+  ServerWriter writer_;
+
+  int epoll_fd_ = -1;
+  int tcp_fd_ = -1;
+  int unix_fd_ = -1;
+
+  /// Only used from the thread writing to `writer()`.
+  pw::hdlc::DecoderBuffer<kMaxFrameSize> server_decoder_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable frames_ready_;
+  std::deque<std::byte> to_server_;
+  std::map<int, std::unique_ptr<Client>> clients_;
+  RpcMultiplexer multiplexer_;
+  RpcMultiplexer::ClientId next_client_id_ = 1;
+  Stats stats_ = {};
+};
+
+}  // namespace sense
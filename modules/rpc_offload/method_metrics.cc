@@ -0,0 +1,43 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/rpc_offload/method_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace sense {
+namespace {
+
+uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+}  // namespace
+
+void MethodMetrics::RecordCall(pw::chrono::SystemClock::duration queued,
+                               pw::chrono::SystemClock::duration handled,
+                               pw::Status status) {
+  calls_.Increment();
+  if (!status.ok()) {
+    errors_.Increment();
+  }
+  const uint32_t handled_us = ToMicroseconds(handled);
+  last_us_.Set(handled_us);
+  max_us_.Set(std::max(max_us_.value(), handled_us));
+  max_queued_us_.Set(std::max(max_queued_us_.value(), ToMicroseconds(queued)));
+}
+
+}  // namespace sense
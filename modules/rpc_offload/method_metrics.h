@@ -0,0 +1,66 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_metric/metric.h"
+#include "pw_status/status.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Invocation counts and latencies of one RPC method.
+///
+/// Latency is split into the time a call waited to be handled and the time
+/// its handler ran, so that a slow handler can be told apart from one that
+/// is queued behind others.
+class MethodMetrics {
+ public:
+  /// Creates metrics whose group is named by `name`, e.g.
+  /// `PW_METRIC_TOKEN("SampleLtr559Prox")`.
+  explicit MethodMetrics(pw::tokenizer::Token name) : metrics_(name) {}
+
+  MethodMetrics(const MethodMetrics&) = delete;
+  MethodMetrics& operator=(const MethodMetrics&) = delete;
+
+  /// Records a handled call and the status it finished with.
+  void RecordCall(pw::chrono::SystemClock::duration queued,
+                  pw::chrono::SystemClock::duration handled,
+                  pw::Status status);
+
+  /// Records a call that was refused because too many were waiting.
+  void RecordRejected() { rejected_.Increment(); }
+
+  uint32_t calls() const { return calls_.value(); }
+  uint32_t errors() const { return errors_.value(); }
+  uint32_t rejected() const { return rejected_.value(); }
+  uint32_t last_us() const { return last_us_.value(); }
+  uint32_t max_us() const { return max_us_.value(); }
+  uint32_t max_queued_us() const { return max_queued_us_.value(); }
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+ private:
+  PW_METRIC_GROUP(metrics_, "method");
+  PW_METRIC(metrics_, calls_, "calls", 0u);
+  PW_METRIC(metrics_, errors_, "errors", 0u);
+  PW_METRIC(metrics_, rejected_, "rejected", 0u);
+  PW_METRIC(metrics_, last_us_, "last us", 0u);
+  PW_METRIC(metrics_, max_us_, "max us", 0u);
+  PW_METRIC(metrics_, max_queued_us_, "max queued us", 0u);
+};
+
+}  // namespace sense
@@ -0,0 +1,158 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "modules/rpc_offload/method_metrics.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_assert/check.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_containers/inline_deque.h"
+#include "pw_function/function.h"
+#include "pw_log/log.h"
+#include "pw_rpc/nanopb/server_reader_writer.h"
+#include "pw_status/status.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Runs the handler of a unary RPC method on a worker instead of the RPC
+/// thread, so that a handler that blocks, e.g. on a sensor, does not delay
+/// the other services.
+///
+/// The service declares the method as an asynchronous unary handler and
+/// forwards the call:
+///
+///   void SampleLtr559Prox(const pw_protobuf_Empty& request,
+///                         SampleProxMethod::Responder& responder) {
+///     sample_prox_.Call(request, responder);
+///   }
+///
+/// Calls are handled in order. Up to `kMaxPending` may wait for the worker;
+/// further calls finish with RESOURCE_EXHAUSTED, and calls the worker does not
+/// accept finish with UNAVAILABLE. Every call is recorded in the method's
+/// `MethodMetrics`.
+template <typename Request,
+          typename Response,
+          size_t kMaxPending = 2,
+          typename ResponderType = pw::rpc::NanopbUnaryResponder<Response>>
+class OffloadedUnaryMethod {
+ public:
+  using Responder = ResponderType;
+  using Handler = pw::Function<pw::Status(const Request&, Response&)>;
+
+  /// Creates a method whose metrics are named by `name`.
+  OffloadedUnaryMethod(pw::tokenizer::Token name, Handler&& handler)
+      : metrics_(name),
+        handler_(std::move(handler)),
+        work_([this] { RunPending(); }) {}
+
+  OffloadedUnaryMethod(const OffloadedUnaryMethod&) = delete;
+  OffloadedUnaryMethod& operator=(const OffloadedUnaryMethod&) = delete;
+
+  /// Sets the worker that runs the handler. Must be called before `Call`.
+  void Init(Worker& worker) { worker_ = &worker; }
+
+  /// Queues a call for the worker, taking over its responder.
+  void Call(const Request& request, Responder& responder)
+      PW_LOCKS_EXCLUDED(lock_) {
+    PW_CHECK_NOTNULL(worker_);
+    {
+      std::lock_guard lock(lock_);
+      if (pending_.full()) {
+        metrics_.RecordRejected();
+        Finish(responder, {}, pw::Status::ResourceExhausted());
+        return;
+      }
+      pending_.push_back({.request = request,
+                          .responder = std::move(responder),
+                          .queued = pw::chrono::SystemClock::now()});
+      if (scheduled_) {
+        return;
+      }
+      scheduled_ = true;
+    }
+    // `scheduled_` keeps the item from being posted while it is pending, so
+    // a failure here means the worker dropped it.
+    if (!work_.Post(*worker_)) {
+      std::lock_guard lock(lock_);
+      scheduled_ = false;
+      // Nothing will run the calls queued since the last run, so none of
+      // them would ever finish.
+      while (!pending_.empty()) {
+        metrics_.RecordRejected();
+        Finish(pending_.front().responder, {}, pw::Status::Unavailable());
+        pending_.pop_front();
+      }
+    }
+  }
+
+  MethodMetrics& metrics() { return metrics_; }
+
+ private:
+  struct PendingCall {
+    Request request;
+    Responder responder;
+    pw::chrono::SystemClock::time_point queued;
+  };
+
+  void RunPending() PW_LOCKS_EXCLUDED(lock_) {
+    while (true) {
+      std::optional<PendingCall> call;
+      {
+        std::lock_guard lock(lock_);
+        if (pending_.empty()) {
+          scheduled_ = false;
+          return;
+        }
+        call.emplace(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+
+      const auto start = pw::chrono::SystemClock::now();
+      Response response{};
+      const pw::Status status = handler_(call->request, response);
+      metrics_.RecordCall(
+          start - call->queued, pw::chrono::SystemClock::now() - start, status);
+      Finish(call->responder, status.ok() ? response : Response{}, status);
+    }
+  }
+
+  static void Finish(Responder& responder,
+                     const Response& response,
+                     pw::Status status) {
+    if (const auto write_status = responder.Finish(response, status);
+        !write_status.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", write_status.str());
+    }
+  }
+
+  Worker* worker_ = nullptr;
+  MethodMetrics metrics_;
+  Handler handler_;
+  WorkItem work_;
+
+  pw::sync::Mutex lock_;
+  pw::InlineDeque<PendingCall, kMaxPending> pending_ PW_GUARDED_BY(lock_);
+  bool scheduled_ PW_GUARDED_BY(lock_) = false;
+};
+
+}  // namespace sense
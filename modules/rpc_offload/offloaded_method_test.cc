@@ -0,0 +1,176 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/rpc_offload/offloaded_method.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "pw_containers/vector.h"
+#include "pw_function/function.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+struct Request {
+  uint32_t value;
+};
+
+struct Response {
+  uint32_t value;
+};
+
+struct Finished {
+  uint32_t value;
+  pw::Status status;
+};
+
+// Records how calls finish, in place of an RPC server.
+class FakeResponder {
+ public:
+  FakeResponder() = default;
+  explicit FakeResponder(pw::Vector<Finished>& finished)
+      : finished_(&finished) {}
+
+  FakeResponder(FakeResponder&& other)
+      : finished_(std::exchange(other.finished_, nullptr)) {}
+  FakeResponder& operator=(FakeResponder&& other) {
+    finished_ = std::exchange(other.finished_, nullptr);
+    return *this;
+  }
+
+  bool active() const { return finished_ != nullptr; }
+
+  pw::Status Finish(const Response& response, pw::Status status) {
+    if (finished_ == nullptr) {
+      return pw::Status::FailedPrecondition();
+    }
+    finished_->push_back({.value = response.value, .status = status});
+    finished_ = nullptr;
+    return pw::OkStatus();
+  }
+
+ private:
+  pw::Vector<Finished>* finished_ = nullptr;
+};
+
+// Holds work until the test runs it, or rejects it like a full queue.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (rejecting_) {
+      return false;
+    }
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void set_rejecting(bool rejecting) { rejecting_ = rejecting; }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 8> work_;
+  bool rejecting_ = false;
+};
+
+using DoublingMethod =
+    OffloadedUnaryMethod<Request, Response, 2, FakeResponder>;
+
+class OffloadedUnaryMethodTest : public ::testing::Test {
+ protected:
+  OffloadedUnaryMethodTest()
+      : method_(PW_TOKENIZE_STRING("double"),
+                [](const Request& request, Response& response) {
+                  if (request.value == 0) {
+                    return pw::Status::InvalidArgument();
+                  }
+                  response.value = request.value * 2;
+                  return pw::OkStatus();
+                }) {
+    method_.Init(worker_);
+  }
+
+  void Call(uint32_t value) {
+    FakeResponder responder(finished_);
+    method_.Call({.value = value}, responder);
+  }
+
+  ManualWorker worker_;
+  DoublingMethod method_;
+  pw::Vector<Finished, 8> finished_;
+};
+
+TEST_F(OffloadedUnaryMethodTest, HandlesCallsOnWorker) {
+  Call(3);
+  Call(5);
+  EXPECT_TRUE(finished_.empty());
+
+  worker_.RunAll();
+  ASSERT_EQ(finished_.size(), 2u);
+  EXPECT_EQ(finished_[0].value, 6u);
+  EXPECT_EQ(finished_[0].status, pw::OkStatus());
+  EXPECT_EQ(finished_[1].value, 10u);
+  EXPECT_EQ(method_.metrics().calls(), 2u);
+  EXPECT_EQ(method_.metrics().errors(), 0u);
+}
+
+TEST_F(OffloadedUnaryMethodTest, ReportsHandlerErrors) {
+  Call(0);
+  worker_.RunAll();
+  ASSERT_EQ(finished_.size(), 1u);
+  EXPECT_EQ(finished_[0].status, pw::Status::InvalidArgument());
+  EXPECT_EQ(finished_[0].value, 0u);
+  EXPECT_EQ(method_.metrics().errors(), 1u);
+}
+
+TEST_F(OffloadedUnaryMethodTest, RejectsCallsBeyondCapacity) {
+  Call(1);
+  Call(2);
+  Call(3);
+  ASSERT_EQ(finished_.size(), 1u);
+  EXPECT_EQ(finished_[0].status, pw::Status::ResourceExhausted());
+  EXPECT_EQ(method_.metrics().rejected(), 1u);
+
+  worker_.RunAll();
+  ASSERT_EQ(finished_.size(), 3u);
+  EXPECT_EQ(finished_[1].value, 2u);
+  EXPECT_EQ(finished_[2].value, 4u);
+}
+
+TEST_F(OffloadedUnaryMethodTest, FinishesCallsTheWorkerRejects) {
+  worker_.set_rejecting(true);
+  Call(1);
+  ASSERT_EQ(finished_.size(), 1u);
+  EXPECT_EQ(finished_[0].status, pw::Status::Unavailable());
+  EXPECT_EQ(method_.metrics().rejected(), 1u);
+
+  // The rejected call does not hold a slot or block later calls.
+  worker_.set_rejecting(false);
+  Call(2);
+  Call(3);
+  worker_.RunAll();
+  ASSERT_EQ(finished_.size(), 3u);
+  EXPECT_EQ(finished_[1].value, 4u);
+  EXPECT_EQ(finished_[2].value, 6u);
+}
+
+}  // namespace
+}  // namespace sense
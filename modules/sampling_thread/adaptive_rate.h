@@ -0,0 +1,95 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+
+namespace sense {
+
+/// Chooses a sensor's sampling period from how much its readings change.
+///
+/// While readings stay within a threshold of the last significant reading, the
+/// period doubles every `stable_samples` samples, up to a maximum. A reading
+/// outside the threshold, or a call to `Reset`, snaps the period back to the
+/// minimum.
+class AdaptiveRate {
+ public:
+  using Duration = pw::chrono::SystemClock::duration;
+
+  struct Config {
+    /// A change larger than `absolute_threshold + relative_threshold * |ref|`
+    /// from the reference reading is significant.
+    float absolute_threshold = 0.f;
+    float relative_threshold = 0.f;
+
+    /// Consecutive stable readings required before each back-off step.
+    uint16_t stable_samples = 4;
+  };
+
+  constexpr explicit AdaptiveRate(const Config& config) : config_(config) {}
+
+  /// Sets the range of periods and resets to the minimum. A maximum not
+  /// longer than the minimum disables backing off.
+  void SetRange(Duration min_period, Duration max_period) {
+    min_period_ = min_period;
+    max_period_ = std::max(min_period, max_period);
+    Reset();
+  }
+
+  /// Returns to the minimum period until readings are stable again.
+  void Reset() {
+    period_ = min_period_;
+    stable_count_ = 0;
+    has_reference_ = false;
+  }
+
+  /// Records a reading and returns the period until the next one.
+  Duration Update(float value) {
+    if (!has_reference_ || IsSignificant(value)) {
+      reference_ = value;
+      has_reference_ = true;
+      period_ = min_period_;
+      stable_count_ = 0;
+      return period_;
+    }
+    if (++stable_count_ >= config_.stable_samples) {
+      stable_count_ = 0;
+      period_ = period_ > max_period_ / 2 ? max_period_ : period_ * 2;
+    }
+    return period_;
+  }
+
+  Duration period() const { return period_; }
+
+ private:
+  bool IsSignificant(float value) const {
+    const float threshold = config_.absolute_threshold +
+                            config_.relative_threshold * std::fabs(reference_);
+    return std::fabs(value - reference_) > threshold;
+  }
+
+  Config config_;
+  Duration min_period_ = Duration::zero();
+  Duration max_period_ = Duration::zero();
+  Duration period_ = Duration::zero();
+  float reference_ = 0.f;
+  uint16_t stable_count_ = 0;
+  bool has_reference_ = false;
+};
+
+}  // namespace sense
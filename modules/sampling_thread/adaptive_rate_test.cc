@@ -0,0 +1,99 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/sampling_thread/adaptive_rate.h"
+
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr AdaptiveRate::Config kConfig = {
+    .absolute_threshold = 10.f,
+    .relative_threshold = 0.f,
+    .stable_samples = 2,
+};
+
+TEST(AdaptiveRateTest, BacksOffWhileStable) {
+  AdaptiveRate rate(kConfig);
+  rate.SetRange(100ms, 1000ms);
+
+  EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(100ms));
+  EXPECT_EQ(rate.Update(505.f), AdaptiveRate::Duration(100ms));
+  EXPECT_EQ(rate.Update(495.f), AdaptiveRate::Duration(200ms));
+  rate.Update(500.f);
+  EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(400ms));
+  rate.Update(500.f);
+  EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(800ms));
+  rate.Update(500.f);
+  EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(1000ms));
+  rate.Update(500.f);
+  EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(1000ms));
+}
+
+TEST(AdaptiveRateTest, SnapsBackOnSignificantChange) {
+  AdaptiveRate rate(kConfig);
+  rate.SetRange(100ms, 1000ms);
+  for (int i = 0; i < 8; ++i) {
+    rate.Update(500.f);
+  }
+  EXPECT_GT(rate.period(), AdaptiveRate::Duration(100ms));
+
+  EXPECT_EQ(rate.Update(520.f), AdaptiveRate::Duration(100ms));
+}
+
+TEST(AdaptiveRateTest, SlowDriftIsMeasuredFromReference) {
+  AdaptiveRate rate(kConfig);
+  rate.SetRange(100ms, 1000ms);
+  rate.Update(500.f);
+  for (float value = 502.f; value <= 510.f; value += 2.f) {
+    rate.Update(value);
+  }
+  EXPECT_GT(rate.period(), AdaptiveRate::Duration(100ms));
+
+  EXPECT_EQ(rate.Update(512.f), AdaptiveRate::Duration(100ms));
+}
+
+TEST(AdaptiveRateTest, ResetReturnsToMinimum) {
+  AdaptiveRate rate(kConfig);
+  rate.SetRange(100ms, 1000ms);
+  for (int i = 0; i < 8; ++i) {
+    rate.Update(500.f);
+  }
+  rate.Reset();
+  EXPECT_EQ(rate.period(), AdaptiveRate::Duration(100ms));
+}
+
+TEST(AdaptiveRateTest, RelativeThreshold) {
+  AdaptiveRate rate({.relative_threshold = 0.1f, .stable_samples = 1});
+  rate.SetRange(100ms, 1000ms);
+  rate.Update(1000.f);
+  EXPECT_EQ(rate.Update(1090.f), AdaptiveRate::Duration(200ms));
+  EXPECT_EQ(rate.Update(1110.f), AdaptiveRate::Duration(100ms));
+}
+
+TEST(AdaptiveRateTest, DisabledWhenMaxNotAboveMin) {
+  AdaptiveRate rate(kConfig);
+  rate.SetRange(100ms, 0ms);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(rate.Update(500.f), AdaptiveRate::Duration(100ms));
+  }
+}
+
+}  // namespace
+}  // namespace sense
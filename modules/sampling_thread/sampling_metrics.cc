@@ -0,0 +1,65 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/sampling_thread/sampling_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace sense {
+
+void SamplingMetrics::RecordSchedule(pw::chrono::SystemClock::duration lateness,
+                                     uint32_t skipped) {
+  samples_.Increment();
+  if (skipped != 0) {
+    overruns_.Increment();
+    skipped_periods_.Increment(skipped);
+  }
+  const uint32_t lateness_us = ToMicroseconds(lateness);
+  last_lateness_us_.Set(lateness_us);
+  SetMax(max_lateness_us_, lateness_us);
+}
+
+void SamplingMetrics::RecordProximityRead(
+    pw::chrono::SystemClock::duration duration) {
+  proximity_read_us_.Set(ToMicroseconds(duration));
+  SetMax(max_proximity_read_us_, proximity_read_us_.value());
+}
+
+void SamplingMetrics::RecordAmbientLightRead(
+    pw::chrono::SystemClock::duration duration) {
+  light_read_us_.Set(ToMicroseconds(duration));
+  SetMax(max_light_read_us_, light_read_us_.value());
+}
+
+void SamplingMetrics::RecordAirMeasurement(
+    pw::chrono::SystemClock::duration duration) {
+  air_measure_us_.Set(ToMicroseconds(duration));
+  SetMax(max_air_measure_us_, air_measure_us_.value());
+}
+
+uint32_t SamplingMetrics::ToMicroseconds(
+    pw::chrono::SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+void SamplingMetrics::SetMax(pw::metric::TypedMetric<uint32_t>& metric,
+                             uint32_t value) {
+  if (value > metric.value()) {
+    metric.Set(value);
+  }
+}
+
+}  // namespace sense
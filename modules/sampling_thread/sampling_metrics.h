@@ -0,0 +1,67 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_metric/metric.h"
+
+namespace sense {
+
+/// Timing instrumentation for `Sampler`.
+class SamplingMetrics {
+ public:
+  /// Records that a sample started `lateness` after it was scheduled, having
+  /// skipped `skipped` whole periods since the previous one.
+  void RecordSchedule(pw::chrono::SystemClock::duration lateness,
+                      uint32_t skipped);
+
+  /// Records how long reading a proximity or light sample took.
+  void RecordProximityRead(pw::chrono::SystemClock::duration duration);
+  void RecordAmbientLightRead(pw::chrono::SystemClock::duration duration);
+
+  /// Records how long an air measurement took from start to completion.
+  void RecordAirMeasurement(pw::chrono::SystemClock::duration duration);
+
+  uint32_t overruns() const { return overruns_.value(); }
+  uint32_t max_lateness_us() const { return max_lateness_us_.value(); }
+
+  pw::metric::Group& group() { return metrics_; }
+
+  /// Writes the metrics to logs.
+  void Dump() { metrics_.Dump(); }
+
+ private:
+  static uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration);
+
+  static void SetMax(pw::metric::TypedMetric<uint32_t>& metric,
+                     uint32_t value);
+
+  PW_METRIC_GROUP(metrics_, "sampling");
+  PW_METRIC(metrics_, samples_, "samples", 0u);
+  PW_METRIC(metrics_, overruns_, "overruns", 0u);
+  PW_METRIC(metrics_, skipped_periods_, "skipped periods", 0u);
+  PW_METRIC(metrics_, last_lateness_us_, "last lateness us", 0u);
+  PW_METRIC(metrics_, max_lateness_us_, "max lateness us", 0u);
+  PW_METRIC(metrics_, proximity_read_us_, "proximity read us", 0u);
+  PW_METRIC(metrics_, max_proximity_read_us_, "max proximity read us", 0u);
+  PW_METRIC(metrics_, light_read_us_, "light read us", 0u);
+  PW_METRIC(metrics_, max_light_read_us_, "max light read us", 0u);
+  PW_METRIC(metrics_, air_measure_us_, "air measure us", 0u);
+  PW_METRIC(metrics_, max_air_measure_us_, "max air measure us", 0u);
+};
+
+}  // namespace sense
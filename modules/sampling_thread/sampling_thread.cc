@@ -14,54 +14,108 @@
 
 #include "modules/sampling_thread/sampling_thread.h"
 
-#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <utility>
 
 #include "pw_assert/check.h"
-#include "pw_chrono/system_clock.h"
 #include "pw_log/log.h"
-#include "pw_thread/sleep.h"
 #include "system/pubsub.h"
 #include "system/system.h"
 
 namespace sense {
 namespace {
 
-using pw::chrono::SystemClock;
+using ::pw::Status;
+using ::pw::async2::Coro;
+using ::pw::async2::CoroContext;
+using ::pw::chrono::SystemClock;
 
-constexpr SystemClock::duration kPeriod = std::chrono::milliseconds(250);
-
-void ReadProximity() {
+std::optional<uint16_t> ReadProximity(SamplingMetrics& metrics,
+                                      Sampler::ProximityFilter& filter,
+                                      SystemClock::time_point timestamp) {
   pw::Result<uint16_t> sample = system::ProximitySensor().ReadSample();
+  metrics.RecordProximityRead(SystemClock::now() - timestamp);
   if (!sample.ok()) {
     PW_LOG_WARN("Failed to read proximity sensor sample: %s",
                 sample.status().str());
-    return;
+    return std::nullopt;
+  }
+  std::optional<uint16_t> filtered = filter.Update(*sample);
+  if (filtered.has_value()) {
+    std::ignore = system::SensorPubSub().Publish(
+        ProximitySample{.sample = *filtered, .timestamp = timestamp});
   }
-  std::ignore = system::PubSub().Publish(ProximitySample{*sample});
+  return filtered;
 }
 
-void ReadAmbientLight() {
+std::optional<float> ReadAmbientLight(SamplingMetrics& metrics,
+                                      SystemClock::time_point timestamp) {
   pw::Result<float> sample = system::AmbientLightSensor().ReadSampleLux();
+  metrics.RecordAmbientLightRead(SystemClock::now() - timestamp);
   if (!sample.ok()) {
     PW_LOG_WARN("Failed to read ambient light sensor sample: %s",
                 sample.status().str());
-    return;
+    return std::nullopt;
   }
-  std::ignore = system::PubSub().Publish(AmbientLightSample{*sample});
+  std::ignore = system::SensorPubSub().Publish(
+      AmbientLightSample{.sample_lux = *sample, .timestamp = timestamp});
+  return *sample;
 }
 
-void ReadAirSensor() {
-  auto& air_sensor = system::AirSensor();
+// Reads light and proximity in one transfer and publishes both. The light
+// read time covers the combined transfer.
+std::optional<LightAndProximitySensor::Samples> ReadLightAndProximity(
+    SamplingMetrics& metrics,
+    Sampler::ProximityFilter& filter,
+    SystemClock::time_point timestamp) {
+  pw::Result<LightAndProximitySensor::Samples> samples =
+      system::LightAndProximitySensor().ReadSamples();
+  metrics.RecordAmbientLightRead(SystemClock::now() - timestamp);
+  if (!samples.ok()) {
+    PW_LOG_WARN("Failed to read light and proximity samples: %s",
+                samples.status().str());
+    return std::nullopt;
+  }
+  std::ignore = system::SensorPubSub().Publish(AmbientLightSample{
+      .sample_lux = samples->light_lux, .timestamp = timestamp});
+  if (std::optional<uint16_t> proximity = filter.Update(samples->proximity)) {
+    samples->proximity = *proximity;
+    std::ignore = system::SensorPubSub().Publish(
+        ProximitySample{.sample = *proximity, .timestamp = timestamp});
+  }
+  return *samples;
+}
+
+// Waits for the timer or, if one is pending, for the air measurement to
+// finish, whichever comes first. Resolves to the air measurement's result if
+// it finished.
+class SampleWait {
+ public:
+  SampleWait(TimerFuture timer,
+             std::optional<AirSensor::MeasureFuture>& air_measurement)
+      : timer_(timer), air_measurement_(air_measurement) {}
 
-  // Read the sensor synchronously to avoid conflicting with other I2C sensors.
-  pw::Result<uint16_t> score = air_sensor.MeasureSync();
-  if (!score.ok()) {
-    PW_LOG_WARN("Failed to read air sensor score: %s", score.status().str());
-    return;
+  pw::async2::Poll<std::optional<pw::Result<uint16_t>>> Pend(
+      pw::async2::Context& cx) {
+    if (air_measurement_.has_value()) {
+      pw::async2::Poll<pw::Result<uint16_t>> air = air_measurement_->Pend(cx);
+      if (air.IsReady()) {
+        air_measurement_.reset();
+        return pw::async2::Ready(std::optional(*air));
+      }
+    }
+    if (timer_.Pend(cx).IsPending()) {
+      return pw::async2::Pending();
+    }
+    return pw::async2::Ready(std::nullopt);
   }
 
-  std::ignore = system::PubSub().Publish(AirQuality{*score});
-}
+ private:
+  TimerFuture timer_;
+  std::optional<AirSensor::MeasureFuture>& air_measurement_;
+};
 
 [[nodiscard]] bool LogInit(const char* type, pw::Status init_result) {
   if (!init_result.ok()) {
@@ -70,30 +124,253 @@ void ReadAirSensor() {
   return init_result.ok();
 }
 
+// Changes smaller than these are treated as noise when backing off.
+constexpr AdaptiveRate::Config kProximityRateConfig = {};
+constexpr AdaptiveRate::Config kAmbientLightRateConfig = {
+    .absolute_threshold = 5.f,
+    .relative_threshold = 0.1f,
+};
+// Scores are already normalized by the live variance, 256 per running
+// standard deviation, so a fixed 64 is always a quarter of one. Scores from
+// an `IaqModel` follow the IAQ index instead, where 64 is ~6% of the range.
+constexpr AdaptiveRate::Config kAirRateConfig = {
+    .absolute_threshold = 64.f,
+};
+
+// Returns whether a sample is due, and if so advances `next` past `now`.
+// Periods that were missed entirely are skipped rather than sampled late.
+bool IsDue(SystemClock::duration period,
+           SystemClock::time_point& next,
+           SystemClock::time_point now,
+           SamplingMetrics& metrics) {
+  if (period == SystemClock::duration::zero() || next > now) {
+    return false;
+  }
+  const auto missed = (now - next) / period;
+  metrics.RecordSchedule(now - next, static_cast<uint32_t>(missed));
+  next += (missed + 1) * period;
+  return true;
+}
+
 }  // namespace
 
-// Reads sensor samples in a loop and publishes PubSub events for them.
-void SamplingLoop() {
-  const bool ambient_light_enabled =
+Sampler::Sampler()
+    : schedules_{kDefaultProximitySchedule,
+                 kDefaultAmbientLightSchedule,
+                 kDefaultAirSchedule},
+      rates_{AdaptiveRate(kProximityRateConfig),
+             AdaptiveRate(kAmbientLightRateConfig),
+             AdaptiveRate(kAirRateConfig)},
+      task_(Coro<Status>::Empty(), [](Status) {
+        PW_LOG_ERROR("Failed to allocate sampling coroutine.");
+      }) {}
+
+void Sampler::Init(pw::async2::Dispatcher& dispatcher,
+                   pw::Allocator& allocator,
+                   Worker& worker) {
+  CoroContext coro_cx(allocator);
+  task_.SetCoro(SamplingLoop(coro_cx));
+  dispatcher.Post(task_);
+
+  // Runs at boot, when the worker's queue has room. If it is dropped anyway,
+  // the air sensor would silently never start.
+  PW_CHECK(worker.RunOnce([this] {
+    const Status status = system::AirSensor().Init();
+    {
+      std::lock_guard lock(lock_);
+      air_init_result_ = status;
+    }
+    timer_.Wake();
+  }));
+}
+
+Sampler::Schedule Sampler::GetSchedule(Sensor sensor) const {
+  std::lock_guard lock(lock_);
+  return schedules_[static_cast<size_t>(sensor)];
+}
+
+void Sampler::SetSchedule(Sensor sensor, const Schedule& schedule) {
+  {
+    std::lock_guard lock(lock_);
+    schedules_[static_cast<size_t>(sensor)] = schedule;
+    schedules_changed_ = true;
+  }
+  timer_.Wake();
+}
+
+void Sampler::RequestFastSampling() {
+  {
+    std::lock_guard lock(lock_);
+    fast_sampling_requested_ = true;
+  }
+  timer_.Wake();
+}
+
+void Sampler::SetMaxPeriod(Sensor sensor, SystemClock::duration period) {
+  {
+    std::lock_guard lock(lock_);
+    max_periods_[static_cast<size_t>(sensor)] = period;
+    max_periods_changed_ = true;
+  }
+  timer_.Wake();
+}
+
+std::optional<Status> Sampler::TakeAirInitResult() {
+  std::lock_guard lock(lock_);
+  return std::exchange(air_init_result_, std::nullopt);
+}
+
+bool Sampler::TakeMaxPeriods(
+    std::array<SystemClock::duration, kNumSensors>& periods) {
+  std::lock_guard lock(lock_);
+  if (!max_periods_changed_) {
+    return false;
+  }
+  periods = max_periods_;
+  max_periods_changed_ = false;
+  return true;
+}
+
+bool Sampler::TakeFastSamplingRequest() {
+  std::lock_guard lock(lock_);
+  return std::exchange(fast_sampling_requested_, false);
+}
+
+bool Sampler::TakeSchedules(std::array<Schedule, kNumSensors>& schedules) {
+  std::lock_guard lock(lock_);
+  if (!schedules_changed_) {
+    return false;
+  }
+  schedules = schedules_;
+  schedules_changed_ = false;
+  return true;
+}
+
+Coro<Status> Sampler::SamplingLoop(CoroContext&) {
+  constexpr auto kProximity = static_cast<size_t>(Sensor::kProximity);
+  constexpr auto kAmbientLight = static_cast<size_t>(Sensor::kAmbientLight);
+  constexpr auto kAir = static_cast<size_t>(Sensor::kAir);
+
+  std::array<bool, kNumSensors> enabled;
+  enabled[kProximity] = LogInit("Proximity", system::ProximitySensor().Enable());
+  enabled[kAmbientLight] =
       LogInit("Ambient light", system::AmbientLightSensor().Enable());
-  const bool prox_enabled =
-      LogInit("Proximity", system::ProximitySensor().Enable());
-  const bool air_enabled = LogInit("Air", system::AirSensor().Init());
+  enabled[kAir] = false;
+
+  std::array<Schedule, kNumSensors> schedules;
+  std::array<SystemClock::duration, kNumSensors> max_periods{};
+  std::array<SystemClock::time_point, kNumSensors> next;
+  std::array<SystemClock::time_point, kNumSensors> last;
+  std::optional<AirSensor::MeasureFuture> air_measurement;
+
+  // Applies a consumer's maximum period to a sensor's scheduled period.
+  auto limit = [&](size_t sensor, SystemClock::duration period) {
+    const SystemClock::duration max_period = max_periods[sensor];
+    if (max_period == SystemClock::duration::zero()) {
+      return period;
+    }
+    return period == SystemClock::duration::zero()
+               ? max_period
+               : std::min(period, max_period);
+  };
+  auto period = [&](size_t sensor) {
+    return limit(sensor, rates_[sensor].period());
+  };
 
-  SystemClock::time_point deadline = SystemClock::now();
+  // Reschedules a sensor's next sample using the period its latest reading
+  // calls for.
+  auto adapt = [&](size_t sensor, float value) {
+    next[sensor] = last[sensor] + limit(sensor, rates_[sensor].Update(value));
+  };
 
   while (true) {
-    deadline += kPeriod;
-    pw::this_thread::sleep_until(deadline);
+    SystemClock::time_point now = SystemClock::now();
+    if (TakeSchedules(schedules)) {
+      for (size_t i = 0; i < kNumSensors; ++i) {
+        rates_[i].SetRange(schedules[i].period, schedules[i].max_period);
+        next[i] = now + schedules[i].offset;
+      }
+    }
+    if (TakeFastSamplingRequest()) {
+      for (size_t i = 0; i < kNumSensors; ++i) {
+        rates_[i].Reset();
+        next[i] = std::min(next[i], now + period(i));
+      }
+    }
+    if (std::optional<Status> air_init = TakeAirInitResult()) {
+      enabled[kAir] = LogInit("Air", *air_init);
+      if (enabled[kAir]) {
+        PW_LOG_INFO("Air sensor ready %u ms after boot",
+                    static_cast<unsigned>(
+                        std::chrono::ceil<std::chrono::milliseconds>(
+                            now.time_since_epoch())
+                            .count()));
+        next[kAir] = now;
+      }
+    }
+    if (TakeMaxPeriods(max_periods)) {
+      for (size_t i = 0; i < kNumSensors; ++i) {
+        if (max_periods[i] != SystemClock::duration::zero()) {
+          next[i] = std::min(next[i], now + max_periods[i]);
+        }
+      }
+    }
+
+    SystemClock::time_point wake = now + kMaxIdle;
+    for (size_t i = 0; i < kNumSensors; ++i) {
+      if (enabled[i] && period(i) != SystemClock::duration::zero()) {
+        wake = std::min(wake, next[i]);
+      }
+    }
+    const std::optional<pw::Result<uint16_t>> air_result =
+        co_await SampleWait(timer_.WaitUntil(wake), air_measurement);
+    now = SystemClock::now();
+
+    if (air_result.has_value() && !air_result->ok()) {
+      PW_LOG_WARN("Failed to start air sensor measurement: %s",
+                  air_result->status().str());
+    } else if (air_result.has_value()) {
+      metrics_.RecordAirMeasurement(now - last[kAir]);
+      const AirSensor::Readings readings = system::AirSensor().Snapshot();
+      std::ignore = system::SensorPubSub().Publish(
+          AirQuality{.score = readings.score,
+                     .timestamp = last[kAir],
+                     .warming_up = readings.warming_up,
+                     .iaq = readings.iaq});
+      std::ignore =
+          system::SensorPubSub().Publish(readings.ToEvent(last[kAir]));
+      adapt(kAir, readings.score);
+    }
 
-    if (ambient_light_enabled) {
-      ReadAmbientLight();
+    // Start the air measurement first. Its heater phase takes ~100 ms, during
+    // which the I2C bus is idle and the light sensor can be read.
+    if (enabled[kAir] && !air_measurement.has_value() &&
+        IsDue(period(kAir), next[kAir], now, metrics_)) {
+      last[kAir] = now;
+      air_measurement = system::AirSensor().MeasureAsync();
     }
-    if (prox_enabled) {
-      ReadProximity();
+    if (enabled[kAmbientLight] &&
+        IsDue(period(kAmbientLight), next[kAmbientLight], now, metrics_)) {
+      last[kAmbientLight] = SystemClock::now();
+      if (!enabled[kProximity]) {
+        if (auto lux = ReadAmbientLight(metrics_, last[kAmbientLight])) {
+          adapt(kAmbientLight, *lux);
+        }
+      } else if (auto samples = ReadLightAndProximity(
+                     metrics_, proximity_filter_, last[kAmbientLight])) {
+        // The burst also counts as this period's proximity sample.
+        adapt(kAmbientLight, samples->light_lux);
+        last[kProximity] = last[kAmbientLight];
+        adapt(kProximity, samples->proximity);
+      }
     }
-    if (air_enabled) {
-      ReadAirSensor();
+    if (enabled[kProximity] &&
+        IsDue(period(kProximity), next[kProximity], now, metrics_)) {
+      last[kProximity] = SystemClock::now();
+      if (auto sample =
+              ReadProximity(metrics_, proximity_filter_, last[kProximity])) {
+        adapt(kProximity, *sample);
+      }
     }
   }
 }
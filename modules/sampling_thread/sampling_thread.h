@@ -11,9 +11,152 @@
 // WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
 // License for the specific language governing permissions and limitations under
 // the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include "modules/filters/filters.h"
+#include "modules/sampling_thread/adaptive_rate.h"
+#include "modules/sampling_thread/sampling_metrics.h"
+#include "modules/timer_future/timer_future.h"
+#include "modules/worker/worker.h"
+#include "pw_allocator/allocator.h"
+#include "pw_async2/coro.h"
+#include "pw_async2/coro_or_else_task.h"
+#include "pw_async2/dispatcher.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_status/status.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+
 namespace sense {
 
-// Reads sensor samples in a loop and publishes PubSub events for them.
-[[noreturn]] void SamplingLoop();
+/// Periodically samples the system's sensors and publishes the results.
+///
+/// Each sensor is sampled on its own schedule, so fast sensors like proximity
+/// are not held to the pace of the air sensor. Sensors whose readings stay
+/// stable are sampled progressively less often, down to their schedule's
+/// `max_period`, and return to their base period when readings change or
+/// proximity is detected.
+class Sampler final {
+ public:
+  enum class Sensor : size_t {
+    kProximity = 0,
+    kAmbientLight,
+    kAir,
+  };
+  static constexpr size_t kNumSensors = 3;
+
+  /// Applied to proximity samples before they are published. The median of
+  /// three removes single-sample spikes, e.g. from reflections.
+  using ProximityFilter = FilterChain<uint16_t, MovingMedian<uint16_t, 3>>;
+
+  struct Schedule {
+    /// Time between samples. Zero disables sampling the sensor.
+    pw::chrono::SystemClock::duration period;
+
+    /// Delay from when the schedule is set to the first sample. Offsetting
+    /// sensors keeps their reads from landing on the same tick.
+    pw::chrono::SystemClock::duration offset;
+
+    /// Longest time between samples while readings are stable. A value not
+    /// longer than `period` disables backing off.
+    pw::chrono::SystemClock::duration max_period;
+  };
+
+  static constexpr Schedule kDefaultProximitySchedule = {
+      .period = std::chrono::milliseconds(50),
+      .offset = std::chrono::milliseconds(0),
+      .max_period = std::chrono::milliseconds(0),
+  };
+  static constexpr Schedule kDefaultAmbientLightSchedule = {
+      .period = std::chrono::milliseconds(500),
+      .offset = std::chrono::milliseconds(10),
+      .max_period = std::chrono::milliseconds(5000),
+  };
+  static constexpr Schedule kDefaultAirSchedule = {
+      .period = std::chrono::milliseconds(3000),
+      .offset = std::chrono::milliseconds(20),
+      .max_period = std::chrono::milliseconds(60000),
+  };
+
+  Sampler();
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  ~Sampler() { task_.Deregister(); }
+
+  /// Injects this object's dependencies and starts sampling.
+  ///
+  /// Sampling runs as a task on `dispatcher`, with its coroutine frame
+  /// allocated from `allocator`. The air sensor is slow to initialize, so it
+  /// is brought up on `worker` and sampled once it is ready; the other sensors
+  /// are sampled in the meantime.
+  void Init(pw::async2::Dispatcher& dispatcher,
+            pw::Allocator& allocator,
+            Worker& worker);
+
+  /// Returns the schedule for the given sensor.
+  Schedule GetSchedule(Sensor sensor) const PW_LOCKS_EXCLUDED(lock_);
+
+  /// Replaces the schedule for the given sensor.
+  void SetSchedule(Sensor sensor, const Schedule& schedule)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Returns every sensor to its base period, e.g. when someone approaches.
+  void RequestFastSampling() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Samples the given sensor at least once per `period`, regardless of its
+  /// schedule, e.g. while a client streams its readings. A zero period
+  /// removes the limit.
+  void SetMaxPeriod(Sensor sensor, pw::chrono::SystemClock::duration period)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  pw::metric::Group& metrics() { return metrics_.group(); }
+
+ private:
+  /// Longest the sampling task sleeps when no sensor is due. Requests wake it
+  /// directly, so this only bounds how long it goes without running.
+  static constexpr pw::chrono::SystemClock::duration kMaxIdle =
+      std::chrono::seconds(10);
+
+  pw::async2::Coro<pw::Status> SamplingLoop(pw::async2::CoroContext&);
+
+  /// Copies the schedules if they have changed since the last call.
+  bool TakeSchedules(std::array<Schedule, kNumSensors>& schedules)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Returns whether fast sampling was requested since the last call.
+  bool TakeFastSamplingRequest() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Returns the air sensor's init result once, after it finishes.
+  std::optional<pw::Status> TakeAirInitResult() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Copies the maximum periods if they have changed since the last call.
+  bool TakeMaxPeriods(
+      std::array<pw::chrono::SystemClock::duration, kNumSensors>& periods)
+      PW_LOCKS_EXCLUDED(lock_);
+
+  mutable pw::sync::InterruptSpinLock lock_;
+  std::array<Schedule, kNumSensors> schedules_ PW_GUARDED_BY(lock_);
+  bool schedules_changed_ PW_GUARDED_BY(lock_) = true;
+  bool fast_sampling_requested_ PW_GUARDED_BY(lock_) = false;
+  std::array<pw::chrono::SystemClock::duration, kNumSensors> max_periods_
+      PW_GUARDED_BY(lock_) = {};
+  bool max_periods_changed_ PW_GUARDED_BY(lock_) = false;
+  std::optional<pw::Status> air_init_result_ PW_GUARDED_BY(lock_);
+
+  // Only accessed by the sampling task.
+  std::array<AdaptiveRate, kNumSensors> rates_;
+  ProximityFilter proximity_filter_;
+  SamplingMetrics metrics_;
+
+  AsyncTimer timer_;
+  pw::async2::CoroOrElseTask task_;
+};
 
 }  // namespace sense
@@ -0,0 +1,107 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/sampling_thread/service.h"
+
+#include <chrono>
+#include <utility>
+
+namespace sense {
+namespace {
+
+using ::pw::chrono::SystemClock;
+
+// Longest period or offset accepted over RPC.
+constexpr uint32_t kMaxScheduleMs = 24 * 60 * 60 * 1000;
+
+uint32_t ToMilliseconds(SystemClock::duration duration) {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+}
+
+sampling_SensorSchedule ToProto(const Sampler::Schedule& schedule) {
+  return {
+      .period_ms = ToMilliseconds(schedule.period),
+      .offset_ms = ToMilliseconds(schedule.offset),
+      .max_period_ms = ToMilliseconds(schedule.max_period),
+  };
+}
+
+Sampler::Schedule FromProto(const sampling_SensorSchedule& schedule) {
+  return {
+      .period = SystemClock::for_at_least(
+          std::chrono::milliseconds(schedule.period_ms)),
+      .offset = SystemClock::for_at_least(
+          std::chrono::milliseconds(schedule.offset_ms)),
+      .max_period = SystemClock::for_at_least(
+          std::chrono::milliseconds(schedule.max_period_ms)),
+  };
+}
+
+bool IsValid(const sampling_SensorSchedule& schedule) {
+  return schedule.period_ms <= kMaxScheduleMs &&
+         schedule.offset_ms <= kMaxScheduleMs &&
+         schedule.max_period_ms <= kMaxScheduleMs;
+}
+
+}  // namespace
+
+void SamplingService::Init(Sampler& sampler,
+                           ScheduleChangedCallback&& on_change) {
+  sampler_ = &sampler;
+  on_change_ = std::move(on_change);
+}
+
+pw::Status SamplingService::GetSchedules(const pw_protobuf_Empty&,
+                                         sampling_Schedules& response) {
+  response.has_proximity = true;
+  response.proximity =
+      ToProto(sampler_->GetSchedule(Sampler::Sensor::kProximity));
+  response.has_ambient_light = true;
+  response.ambient_light =
+      ToProto(sampler_->GetSchedule(Sampler::Sensor::kAmbientLight));
+  response.has_air = true;
+  response.air = ToProto(sampler_->GetSchedule(Sampler::Sensor::kAir));
+  return pw::OkStatus();
+}
+
+pw::Status SamplingService::SetSchedules(const sampling_Schedules& request,
+                                         sampling_Schedules& response) {
+  if ((request.has_proximity && !IsValid(request.proximity)) ||
+      (request.has_ambient_light && !IsValid(request.ambient_light)) ||
+      (request.has_air && !IsValid(request.air))) {
+    return pw::Status::InvalidArgument();
+  }
+  if (request.has_proximity) {
+    SetSchedule(Sampler::Sensor::kProximity, request.proximity);
+  }
+  if (request.has_ambient_light) {
+    SetSchedule(Sampler::Sensor::kAmbientLight, request.ambient_light);
+  }
+  if (request.has_air) {
+    SetSchedule(Sampler::Sensor::kAir, request.air);
+  }
+  return GetSchedules({}, response);
+}
+
+void SamplingService::SetSchedule(Sampler::Sensor sensor,
+                                  const sampling_SensorSchedule& schedule) {
+  const Sampler::Schedule converted = FromProto(schedule);
+  sampler_->SetSchedule(sensor, converted);
+  if (on_change_ != nullptr) {
+    on_change_(sensor, converted);
+  }
+}
+
+}  // namespace sense
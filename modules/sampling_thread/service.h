@@ -0,0 +1,47 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/sampling_thread/sampling.rpc.pb.h"
+#include "modules/sampling_thread/sampling_thread.h"
+#include "pw_function/function.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+class SamplingService final
+    : public ::sampling::pw_rpc::nanopb::Sampling::Service<SamplingService> {
+ public:
+  /// Called with each schedule that `SetSchedules` changes, such as to save
+  /// it across reboots.
+  using ScheduleChangedCallback =
+      pw::Function<void(Sampler::Sensor, const Sampler::Schedule&)>;
+
+  void Init(Sampler& sampler, ScheduleChangedCallback&& on_change = nullptr);
+
+  pw::Status GetSchedules(const pw_protobuf_Empty&,
+                          sampling_Schedules& response);
+
+  pw::Status SetSchedules(const sampling_Schedules& request,
+                          sampling_Schedules& response);
+
+ private:
+  void SetSchedule(Sampler::Sensor sensor,
+                   const sampling_SensorSchedule& schedule);
+
+  Sampler* sampler_ = nullptr;
+  ScheduleChangedCallback on_change_;
+};
+
+}  // namespace sense
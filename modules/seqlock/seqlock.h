@@ -0,0 +1,97 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sense {
+
+/// Value that is written by one context at a time and read without locks.
+///
+/// The value is kept twice. A write updates one copy while readers use the
+/// other, then updates the second, and a sequence number tells readers which
+/// copy is stable. Readers never wait for a writer: an interrupt that
+/// preempts `Store` reads the previous value. A reader only retries if a
+/// whole write completes while it is copying.
+///
+/// Calls to `Store` must be serialized by the caller.
+template <typename T>
+class SeqLock {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SeqLock values must be trivially copyable");
+
+  explicit SeqLock(const T& value = T()) {
+    Write(copies_[0], value);
+    Write(copies_[1], value);
+  }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  /// Replaces the value.
+  void Store(const T& value) {
+    sequence_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Write(copies_[0], value);
+    std::atomic_thread_fence(std::memory_order_release);
+    sequence_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Write(copies_[1], value);
+  }
+
+  /// Returns the most recently stored value, never a mix of two.
+  T Load() const {
+    T value;
+    uint32_t sequence;
+    do {
+      sequence = sequence_.load(std::memory_order_acquire);
+      Read(copies_[sequence & 1], value);
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while (sequence_.load(std::memory_order_relaxed) != sequence);
+    return value;
+  }
+
+ private:
+  // Words are accessed atomically so that concurrent reads and writes are
+  // well defined; the sequence number detects when they are inconsistent.
+  static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+  using Copy = std::array<std::atomic<uint32_t>, kWords>;
+
+  static void Write(Copy& copy, const T& value) {
+    std::array<uint32_t, kWords> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    for (size_t i = 0; i < kWords; ++i) {
+      copy[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  static void Read(const Copy& copy, T& value) {
+    std::array<uint32_t, kWords> words;
+    for (size_t i = 0; i < kWords; ++i) {
+      words[i] = copy[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&value, words.data(), sizeof(T));
+  }
+
+  std::atomic<uint32_t> sequence_ = 0;
+  std::array<Copy, 2> copies_;
+};
+
+}  // namespace sense
@@ -0,0 +1,79 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/seqlock/seqlock.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "pw_thread/test_thread_context.h"
+#include "pw_thread/thread.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+struct Readings {
+  float a;
+  float b;
+  uint16_t c;
+};
+
+TEST(SeqLockTest, LoadsInitialValue) {
+  SeqLock<Readings> lock({.a = 1.f, .b = 2.f, .c = 3});
+  Readings value = lock.Load();
+  EXPECT_EQ(value.a, 1.f);
+  EXPECT_EQ(value.b, 2.f);
+  EXPECT_EQ(value.c, 3u);
+}
+
+TEST(SeqLockTest, LoadsLatestStore) {
+  SeqLock<Readings> lock;
+  lock.Store({.a = 4.f, .b = 5.f, .c = 6});
+  lock.Store({.a = 7.f, .b = 8.f, .c = 9});
+  Readings value = lock.Load();
+  EXPECT_EQ(value.a, 7.f);
+  EXPECT_EQ(value.b, 8.f);
+  EXPECT_EQ(value.c, 9u);
+}
+
+TEST(SeqLockTest, ConcurrentLoadsAreNeverTorn) {
+  struct Pair {
+    uint32_t first;
+    uint32_t second;
+  };
+  SeqLock<Pair> lock({.first = 0, .second = 0});
+  std::atomic<bool> done = false;
+
+  pw::thread::test::TestThreadContext context;
+  pw::thread::Thread writer(context.options(), [&lock, &done]() {
+    for (uint32_t i = 1; i <= 10000; ++i) {
+      lock.Store({.first = i, .second = ~i});
+    }
+    done = true;
+  });
+
+  uint32_t last = 0;
+  while (!done) {
+    Pair value = lock.Load();
+    ASSERT_EQ(value.second, ~value.first);
+    ASSERT_GE(value.first, last);
+    last = value.first;
+  }
+  writer.join();
+  EXPECT_EQ(lock.Load().first, 10000u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,156 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Runs many simulated Sense devices in one process, to load test the services
+// that talk to a fleet, e.g.
+//
+//   bazelisk run //modules/simulation:fleet --
+//       --devices=500 --threads=8 --seconds=10 --rate_hz=2
+//
+// Each device has its own buses, workers and fake sensors, and all of them
+// share one thread pool. Every device is sampled at the given rate with inputs
+// that drift through near and far readings and poor and good air, so that each
+// one runs through proximity and alarm transitions at its own pace. A summary
+// of the run is printed as one JSON object.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string_view>
+#include <thread>
+
+#include "modules/simulation/simulated_device.h"
+#include "modules/simulation/worker_pool.h"
+#include "pw_assert/check.h"
+
+namespace {
+
+using ::sense::SimulatedDevice;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  uint32_t devices = 100;
+  uint32_t threads = 0;
+  uint32_t seconds = 10;
+  uint32_t rate_hz = 1;
+};
+
+int Usage(const char* program) {
+  std::fprintf(stderr,
+               "usage: %s [--devices=N] [--threads=N] [--seconds=N] "
+               "[--rate_hz=N]\n",
+               program);
+  return EXIT_FAILURE;
+}
+
+bool ParseFlag(std::string_view arg, std::string_view name, uint32_t& value) {
+  if (arg.substr(0, name.size()) != name || arg.size() == name.size()) {
+    return false;
+  }
+  char* end = nullptr;
+  const char* digits = arg.data() + name.size();
+  value = static_cast<uint32_t>(std::strtoul(digits, &end, 10));
+  return *end == '\0';
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (!ParseFlag(arg, "--devices=", options.devices) &&
+        !ParseFlag(arg, "--threads=", options.threads) &&
+        !ParseFlag(arg, "--seconds=", options.seconds) &&
+        !ParseFlag(arg, "--rate_hz=", options.rate_hz)) {
+      return false;
+    }
+  }
+  return options.devices > 0 && options.rate_hz > 0;
+}
+
+// Inputs for a device's `tick`th sample. Devices are staggered by id so that
+// their transitions do not all land on the same tick.
+SimulatedDevice::Inputs InputsFor(uint32_t id, uint32_t tick) {
+  const uint32_t phase = tick + id * 7;
+  return {
+      .proximity = static_cast<uint16_t>(phase % 20 < 5 ? 30000 : 100),
+      .light_lux = static_cast<float>(phase % 100) * 10.f,
+      .gas_resistance = phase % 60 < 10 ? 20e3f : 120e3f,
+  };
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return Usage(argv[0]);
+  }
+
+  sense::WorkerPool pool(options.threads);
+  std::deque<SimulatedDevice> devices;
+  for (uint32_t id = 0; id < options.devices; ++id) {
+    PW_CHECK_OK(devices.emplace_back(pool, id).Init());
+  }
+  pool.WaitUntilIdle();
+
+  const Clock::duration period =
+      Clock::duration(std::chrono::seconds(1)) / options.rate_hz;
+  const uint32_t ticks = options.seconds * options.rate_hz;
+  const Clock::time_point start = Clock::now();
+  Clock::duration max_lag{0};
+  for (uint32_t tick = 0; tick < ticks; ++tick) {
+    const Clock::time_point due = start + tick * period;
+    std::this_thread::sleep_until(due);
+    max_lag = std::max(max_lag, Clock::now() - due);
+    for (SimulatedDevice& device : devices) {
+      device.Sample(InputsFor(device.id(), tick));
+    }
+  }
+  pool.WaitUntilIdle();
+  const double wall_seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  SimulatedDevice::Stats total;
+  for (const SimulatedDevice& device : devices) {
+    const SimulatedDevice::Stats stats = device.stats();
+    total.samples += stats.samples;
+    total.events += stats.events;
+    total.alarm_transitions += stats.alarm_transitions;
+    total.dropped_events += stats.dropped_events;
+  }
+  std::printf(
+      "{\"devices\": %" PRIu32 ", \"threads\": %zu, \"samples\": %" PRIu32
+      ", \"events\": %" PRIu32 ", \"alarm_transitions\": %" PRIu32
+      ", \"dropped_events\": %" PRIu32
+      ", \"max_tick_lag_us\": %" PRId64 ", \"wall_s\": %.3f"
+      ", \"events_per_second\": %.0f}\n",
+      options.devices,
+      pool.threads(),
+      total.samples,
+      total.events,
+      total.alarm_transitions,
+      total.dropped_events,
+      static_cast<int64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(max_lag)
+              .count()),
+      wall_seconds,
+      wall_seconds > 0 ? total.events / wall_seconds : 0.);
+
+  // The devices' timers may still be armed; skip tearing them down.
+  std::fflush(stdout);
+  std::_Exit(EXIT_SUCCESS);
+}
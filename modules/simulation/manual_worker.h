@@ -0,0 +1,52 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include "modules/worker/worker.h"
+#include "pw_function/function.h"
+
+namespace sense {
+
+/// Worker that queues work until it is explicitly run, so that a simulation
+/// can process everything an input triggers before advancing time.
+///
+/// Host only. Not thread safe: work must be queued and run from one thread.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  /// Runs queued work, including any work it queues, until none is left.
+  /// Returns the number of work items run.
+  size_t RunUntilIdle() {
+    size_t count = 0;
+    while (!work_.empty()) {
+      pw::Function<void()> work = std::move(work_.front());
+      work_.pop_front();
+      work();
+      ++count;
+    }
+    return count;
+  }
+
+ private:
+  std::deque<pw::Function<void()>> work_;
+};
+
+}  // namespace sense
@@ -0,0 +1,113 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/recording.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "modules/pubsub/event_codec.h"
+#include "modules/pubsub/pubsub_pb/pubsub.pb.h"
+#include "pb_decode.h"
+
+namespace sense {
+namespace {
+
+constexpr size_t kHeaderSize = RecordingReader::kMagic.size() + 1;
+
+// Whether an event comes from outside the replayed components. Everything
+// else is regenerated during the replay, so replaying the recorded copy
+// would deliver it twice.
+bool IsInput(const Event& event) {
+  switch (static_cast<EventType>(event.index())) {
+    case kButtonA:
+    case kButtonB:
+    case kButtonX:
+    case kButtonY:
+    case kProximityStateChange:
+    case kProximitySample:
+    case kAmbientLightSample:
+    case kAirQuality:
+    case kStateManagerControl:
+    case kAirMeasurement:
+    case kButtonGesture:
+      return true;
+    case kTimerRequest:
+    case kTimerExpired:
+    case kTimerCancel:
+    case kMorseEncodeRequest:
+    case kMorseCodeValue:
+    case kSenseState:
+      break;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool RecordingReader::IsRecording(pw::ConstByteSpan data) {
+  return data.size() >= kMagic.size() &&
+         std::memcmp(data.data(), kMagic.data(), kMagic.size()) == 0;
+}
+
+pw::Status RecordingReader::Init(pw::ConstByteSpan data) {
+  if (!IsRecording(data) || data.size() < kHeaderSize) {
+    return pw::Status::DataLoss();
+  }
+  if (data[kMagic.size()] != kVersion) {
+    return pw::Status::Unimplemented();
+  }
+  remaining_ = data.subspan(kHeaderSize);
+  started_ = false;
+  last_time_ = std::chrono::milliseconds(0);
+  skipped_ = 0;
+  dropped_ = 0;
+  return pw::OkStatus();
+}
+
+pw::Result<ScriptStep> RecordingReader::Next() {
+  while (!remaining_.empty()) {
+    pb_istream_t stream = pb_istream_from_buffer(
+        reinterpret_cast<const pb_byte_t*>(remaining_.data()),
+        remaining_.size());
+    pubsub_Event proto = pubsub_Event_init_default;
+    if (!pb_decode_ex(
+            &stream, pubsub_Event_fields, &proto, PB_DECODE_DELIMITED)) {
+      remaining_ = {};
+      return pw::Status::DataLoss();
+    }
+    remaining_ = remaining_.subspan(remaining_.size() - stream.bytes_left);
+    dropped_ += proto.dropped;
+
+    if (!started_) {
+      started_ = true;
+      start_us_ = proto.dispatch_time_us;
+    }
+    // The runner rejects steps out of order, so never step back in time.
+    last_time_ = std::max(
+        last_time_,
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::microseconds(proto.dispatch_time_us - start_us_)));
+
+    pw::Result<Event> event = ProtoToEvent(proto);
+    if (!event.ok() || !IsInput(*event)) {
+      ++skipped_;
+      continue;
+    }
+    return ScriptStep{.time = last_time_, .event = *event};
+  }
+  return pw::Status::OutOfRange();
+}
+
+}  // namespace sense
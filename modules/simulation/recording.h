@@ -0,0 +1,69 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "modules/simulation/script.h"
+#include "pw_bytes/span.h"
+#include "pw_result/result.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Reads the PubSub recordings made by `tools/sense/record_events.py`.
+///
+/// A recording is the magic `SNSREC` and a version byte, followed by
+/// length-delimited `pubsub.Event` messages stamped with `dispatch_time_us`.
+/// Only inputs are replayed: timers, states, Morse code, and other events
+/// that the replayed components publish themselves are skipped.
+class RecordingReader {
+ public:
+  static constexpr std::string_view kMagic = "SNSREC";
+  static constexpr std::byte kVersion{1};
+
+  /// Returns whether `data` starts with a recording header.
+  static bool IsRecording(pw::ConstByteSpan data);
+
+  /// Starts reading a recording.
+  ///
+  /// @returns DataLoss if `data` is not a recording, and Unimplemented if it
+  /// is a version this reader does not support.
+  pw::Status Init(pw::ConstByteSpan data);
+
+  /// Returns the next recorded input, timed relative to the first recorded
+  /// event.
+  ///
+  /// @returns OutOfRange at the end of the recording, and DataLoss if it is
+  /// truncated or corrupt.
+  pw::Result<ScriptStep> Next();
+
+  /// Number of recorded events that were not replayed.
+  uint32_t skipped() const { return skipped_; }
+
+  /// Number of events the device reported dropping from the stream.
+  uint32_t dropped() const { return dropped_; }
+
+ private:
+  pw::ConstByteSpan remaining_;
+  bool started_ = false;
+  int64_t start_us_ = 0;
+  std::chrono::milliseconds last_time_{0};
+  uint32_t skipped_ = 0;
+  uint32_t dropped_ = 0;
+};
+
+}  // namespace sense
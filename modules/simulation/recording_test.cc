@@ -0,0 +1,124 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/recording.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <variant>
+
+#include "modules/pubsub/event_codec.h"
+#include "pb_encode.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using std::chrono::milliseconds;
+
+// Builds a recording in memory the way the recording tool writes it.
+class RecordingBuilder {
+ public:
+  RecordingBuilder() {
+    std::memcpy(buffer_.data(),
+                RecordingReader::kMagic.data(),
+                RecordingReader::kMagic.size());
+    buffer_[RecordingReader::kMagic.size()] = RecordingReader::kVersion;
+    size_ = RecordingReader::kMagic.size() + 1;
+  }
+
+  RecordingBuilder& Add(const Event& event, int64_t dispatch_time_us) {
+    pubsub_Event proto = EventToProto(event);
+    proto.dispatch_time_us = dispatch_time_us;
+    pb_ostream_t stream = pb_ostream_from_buffer(
+        reinterpret_cast<pb_byte_t*>(buffer_.data() + size_),
+        buffer_.size() - size_);
+    EXPECT_TRUE(pb_encode_ex(
+        &stream, pubsub_Event_fields, &proto, PB_ENCODE_DELIMITED));
+    size_ += stream.bytes_written;
+    return *this;
+  }
+
+  pw::ConstByteSpan data() const {
+    return pw::ConstByteSpan(buffer_.data(), size_);
+  }
+
+ private:
+  std::array<std::byte, 256> buffer_{};
+  size_t size_ = 0;
+};
+
+TEST(RecordingReaderTest, ReplaysInputsRelativeToFirstEvent) {
+  RecordingBuilder recording;
+  recording.Add(AirQuality{.score = 700}, 5'000'000)
+      .Add(TimerRequest{.token = 1, .timeout_ms = 100, .period_ms = 0},
+           5'001'000)
+      .Add(ButtonX(true), 5'250'000)
+      .Add(MorseCodeValue{.turn_on = true, .message_finished = false},
+           5'260'000)
+      .Add(ButtonX(false), 5'400'500);
+
+  RecordingReader reader;
+  ASSERT_EQ(reader.Init(recording.data()), pw::OkStatus());
+
+  pw::Result<ScriptStep> air = reader.Next();
+  ASSERT_EQ(air.status(), pw::OkStatus());
+  EXPECT_EQ(air->time, milliseconds(0));
+  ASSERT_TRUE(std::holds_alternative<AirQuality>(air->event));
+  EXPECT_EQ(std::get<AirQuality>(air->event).score, 700u);
+
+  pw::Result<ScriptStep> press = reader.Next();
+  ASSERT_EQ(press.status(), pw::OkStatus());
+  EXPECT_EQ(press->time, milliseconds(250));
+  ASSERT_TRUE(std::holds_alternative<ButtonX>(press->event));
+  EXPECT_TRUE(std::get<ButtonX>(press->event).pressed());
+
+  pw::Result<ScriptStep> release = reader.Next();
+  ASSERT_EQ(release.status(), pw::OkStatus());
+  EXPECT_EQ(release->time, milliseconds(400));
+  ASSERT_TRUE(std::holds_alternative<ButtonX>(release->event));
+
+  EXPECT_EQ(reader.Next().status(), pw::Status::OutOfRange());
+  EXPECT_EQ(reader.skipped(), 2u);
+}
+
+TEST(RecordingReaderTest, RejectsOtherFiles) {
+  constexpr std::array<std::byte, 4> kScript = {
+      std::byte{'0'}, std::byte{' '}, std::byte{'a'}, std::byte{'i'}};
+  RecordingReader reader;
+  EXPECT_FALSE(RecordingReader::IsRecording(kScript));
+  EXPECT_EQ(reader.Init(kScript), pw::Status::DataLoss());
+
+  std::array<std::byte, 8> future{};
+  std::memcpy(future.data(),
+              RecordingReader::kMagic.data(),
+              RecordingReader::kMagic.size());
+  future[RecordingReader::kMagic.size()] = std::byte{2};
+  EXPECT_EQ(reader.Init(future), pw::Status::Unimplemented());
+}
+
+TEST(RecordingReaderTest, TruncatedRecordingIsDataLoss) {
+  RecordingBuilder recording;
+  recording.Add(ButtonA(true), 0);
+  pw::ConstByteSpan data = recording.data();
+
+  RecordingReader reader;
+  ASSERT_EQ(reader.Init(data.first(data.size() - 1)), pw::OkStatus());
+  EXPECT_EQ(reader.Next().status(), pw::Status::DataLoss());
+  EXPECT_EQ(reader.Next().status(), pw::Status::OutOfRange());
+}
+
+}  // namespace
+}  // namespace sense
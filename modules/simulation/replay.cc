@@ -0,0 +1,193 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Replays a simulation script through the state manager and proximity
+// detection in virtual time, e.g.
+//
+//   bazelisk run //modules/simulation:replay --
+//       $PWD/modules/simulation/alarm_scenario.txt --speedup=0
+//
+// Recordings made with `//tools:record_events` are replayed the same way.
+// They already contain the proximity state changes the device detected, so
+// proximity detection is not rerun for them.
+//
+// Alarm transitions are printed as they happen, followed by a summary of the
+// run, each as one JSON object per line so that runs can be compared across
+// commits.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "modules/led/polychrome_led_fake.h"
+#include "modules/proximity/manager.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/simulation/manual_worker.h"
+#include "modules/simulation/recording.h"
+#include "modules/simulation/script.h"
+#include "modules/simulation/virtual_time_runner.h"
+#include "modules/state_manager/state_manager.h"
+#include "pw_assert/check.h"
+#include "pw_bytes/span.h"
+
+namespace {
+
+using ::sense::VirtualTimeRunner;
+
+// Same thresholds and queue sizes as the production app.
+constexpr uint16_t kFarThreshold = 512;
+constexpr uint16_t kNearThreshold = 16384;
+
+int64_t Microseconds(VirtualTimeRunner::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+int Usage(const char* program) {
+  std::fprintf(
+      stderr, "usage: %s <script|recording> [--speedup=N]\n", program);
+  return EXIT_FAILURE;
+}
+
+bool ReplayScript(const char* path,
+                  const std::string& contents,
+                  VirtualTimeRunner& runner) {
+  std::istringstream script(contents);
+  std::string line;
+  for (size_t line_number = 1; std::getline(script, line); ++line_number) {
+    pw::Result<sense::ScriptStep> step = sense::ParseScriptLine(line);
+    if (step.status().IsNotFound()) {
+      continue;
+    }
+    if (!step.ok() || !runner.Apply(*step).ok()) {
+      std::fprintf(stderr,
+                   "%s:%zu: invalid or out of order step: %s\n",
+                   path,
+                   line_number,
+                   line.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReplayRecording(const char* path,
+                     sense::RecordingReader& recording,
+                     VirtualTimeRunner& runner) {
+  while (true) {
+    pw::Result<sense::ScriptStep> step = recording.Next();
+    if (step.status().IsOutOfRange()) {
+      return true;
+    }
+    if (!step.ok() || !runner.Apply(*step).ok()) {
+      std::fprintf(stderr, "%s: corrupt recording\n", path);
+      return false;
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    return Usage(argv[0]);
+  }
+  double speedup = 0;
+  if (argc == 3) {
+    constexpr std::string_view kSpeedup = "--speedup=";
+    const std::string_view arg = argv[2];
+    if (arg.substr(0, kSpeedup.size()) != kSpeedup) {
+      return Usage(argv[0]);
+    }
+    speedup = std::strtod(argv[2] + kSpeedup.size(), nullptr);
+  }
+
+  std::ifstream file(argv[1], std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  const std::string contents(std::istreambuf_iterator<char>(file), {});
+  const pw::ConstByteSpan data = pw::as_bytes(pw::span(contents));
+  sense::RecordingReader recording;
+  const bool is_recording = sense::RecordingReader::IsRecording(data);
+  if (is_recording && !recording.Init(data).ok()) {
+    std::fprintf(stderr, "%s: unsupported recording\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  sense::ManualWorker worker;
+  sense::GenericPubSubBuffer<sense::Event, 20, 11, 0, 8> pubsub(
+      worker, sense::kPriorityEvents, sense::kConflatedEvents);
+  sense::PolychromeLedFake led;
+  sense::StateManager state_manager(pubsub,
+                                    led,
+                                    sense::StateManager::kDefaultScoreDeadband,
+                                    /*color_fade_ms=*/0);
+  std::optional<sense::ProximityManager> proximity;
+  if (!is_recording) {
+    proximity.emplace(pubsub, kFarThreshold, kNearThreshold);
+  }
+
+  VirtualTimeRunner runner(pubsub, worker, speedup);
+  PW_CHECK_OK(runner.Init());
+  runner.set_transition_callback(
+      [](std::chrono::milliseconds time, const sense::SenseState& state) {
+        std::printf(
+            "{\"virtual_ms\": %" PRId64
+            ", \"alarm\": %s, \"air_quality\": %u, \"threshold\": %u}\n",
+            static_cast<int64_t>(time.count()),
+            state.alarm ? "true" : "false",
+            static_cast<unsigned>(state.air_quality),
+            static_cast<unsigned>(state.alarm_threshold));
+      });
+
+  const bool replayed = is_recording
+                            ? ReplayRecording(argv[1], recording, runner)
+                            : ReplayScript(argv[1], contents, runner);
+  if (!replayed) {
+    return EXIT_FAILURE;
+  }
+
+  const VirtualTimeRunner::Report report = runner.report();
+  const double wall_seconds =
+      std::chrono::duration<double>(report.wall_time).count();
+  std::printf(
+      "{\"steps\": %" PRIu32 ", \"events\": %" PRIu32
+      ", \"dropped_events\": %" PRIu32 ", \"timers_fired\": %" PRIu32
+      ", \"alarm_transitions\": %" PRIu32 ", \"skipped_events\": %" PRIu32
+      ", \"device_dropped_events\": %" PRIu32 ", \"virtual_ms\": %" PRId64
+      ", \"wall_us\": %" PRId64 ", \"max_step_wall_us\": %" PRId64
+      ", \"events_per_second\": %.0f}\n",
+      report.steps,
+      report.events,
+      report.dropped_events,
+      report.timers_fired,
+      report.alarm_transitions,
+      recording.skipped(),
+      recording.dropped(),
+      static_cast<int64_t>(report.virtual_time.count()),
+      Microseconds(report.wall_time),
+      Microseconds(report.max_step_wall_time),
+      wall_seconds > 0 ? report.events / wall_seconds : 0.);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/script.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "pw_span/span.h"
+
+namespace sense {
+namespace {
+
+using ::pw::chrono::SystemClock;
+
+constexpr std::string_view kWhitespace = " \t\r\n";
+
+// Splits `line` into whitespace-separated words. Returns the number of words,
+// or nullopt if there are more than `words` holds.
+template <size_t kMaxWords>
+std::optional<size_t> Split(std::string_view line,
+                            std::array<std::string_view, kMaxWords>& words) {
+  size_t count = 0;
+  while (true) {
+    const size_t start = line.find_first_not_of(kWhitespace);
+    if (start == std::string_view::npos) {
+      return count;
+    }
+    if (count == kMaxWords) {
+      return std::nullopt;
+    }
+    line.remove_prefix(start);
+    const size_t end = std::min(line.find_first_of(kWhitespace), line.size());
+    words[count++] = line.substr(0, end);
+    line.remove_prefix(end);
+  }
+}
+
+template <typename T>
+std::optional<T> ParseNumber(std::string_view word) {
+  T value;
+  const auto [end, error] =
+      std::from_chars(word.data(), word.data() + word.size(), value);
+  if (error != std::errc() || end != word.data() + word.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<Event> ParseButton(std::string_view name,
+                                 std::string_view action) {
+  bool pressed;
+  if (action == "press") {
+    pressed = true;
+  } else if (action == "release") {
+    pressed = false;
+  } else {
+    return std::nullopt;
+  }
+  if (name == "a") {
+    return ButtonA(pressed);
+  }
+  if (name == "b") {
+    return ButtonB(pressed);
+  }
+  if (name == "x") {
+    return ButtonX(pressed);
+  }
+  if (name == "y") {
+    return ButtonY(pressed);
+  }
+  return std::nullopt;
+}
+
+std::optional<Event> ParseEvent(pw::span<const std::string_view> args,
+                                SystemClock::time_point timestamp) {
+  if (args.size() == 3 && args[0] == "button") {
+    return ParseButton(args[1], args[2]);
+  }
+  if (args.size() != 2) {
+    return std::nullopt;
+  }
+  if (args[0] == "air") {
+    if (auto score = ParseNumber<uint16_t>(args[1])) {
+      return AirQuality{.score = *score, .timestamp = timestamp};
+    }
+  } else if (args[0] == "light") {
+    if (auto lux = ParseNumber<float>(args[1])) {
+      return AmbientLightSample{.sample_lux = *lux, .timestamp = timestamp};
+    }
+  } else if (args[0] == "proximity") {
+    if (auto sample = ParseNumber<uint16_t>(args[1])) {
+      return ProximitySample{.sample = *sample, .timestamp = timestamp};
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+pw::Result<ScriptStep> ParseScriptLine(std::string_view line) {
+  line = line.substr(0, line.find('#'));
+  std::array<std::string_view, 4> words;
+  const std::optional<size_t> count = Split(line, words);
+  if (count == 0) {
+    return pw::Status::NotFound();
+  }
+  if (!count.has_value() || *count < 2) {
+    return pw::Status::InvalidArgument();
+  }
+
+  const std::optional<uint32_t> time_ms = ParseNumber<uint32_t>(words[0]);
+  if (!time_ms.has_value()) {
+    return pw::Status::InvalidArgument();
+  }
+  const std::chrono::milliseconds time(*time_ms);
+  std::optional<Event> event =
+      ParseEvent(pw::span(words).subspan(1, *count - 1),
+                 SystemClock::time_point(
+                     std::chrono::duration_cast<SystemClock::duration>(time)));
+  if (!event.has_value()) {
+    return pw::Status::InvalidArgument();
+  }
+  return ScriptStep{.time = time, .event = *event};
+}
+
+}  // namespace sense
@@ -0,0 +1,44 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <string_view>
+
+#include "modules/pubsub/pubsub_events.h"
+#include "pw_result/result.h"
+
+namespace sense {
+
+/// One scripted input, applied `time` after the simulation starts.
+struct ScriptStep {
+  std::chrono::milliseconds time;
+  Event event;
+};
+
+/// Parses one line of a simulation script. Lines have one of the forms
+///
+///   <time_ms> air <score>
+///   <time_ms> light <lux>
+///   <time_ms> proximity <sample>
+///   <time_ms> button <a|b|x|y> <press|release>
+///
+/// Sensor events are timestamped with their virtual time. Anything after a
+/// `#` is a comment.
+///
+/// @returns NotFound for lines with only whitespace and comments, and
+/// InvalidArgument for lines that do not parse.
+pw::Result<ScriptStep> ParseScriptLine(std::string_view line);
+
+}  // namespace sense
@@ -0,0 +1,85 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/script.h"
+
+#include <chrono>
+#include <variant>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using std::chrono::milliseconds;
+
+TEST(ParseScriptLineTest, SensorSamples) {
+  pw::Result<ScriptStep> air = ParseScriptLine("1500 air 620");
+  ASSERT_EQ(air.status(), pw::OkStatus());
+  EXPECT_EQ(air->time, milliseconds(1500));
+  ASSERT_TRUE(std::holds_alternative<AirQuality>(air->event));
+  EXPECT_EQ(std::get<AirQuality>(air->event).score, 620u);
+  EXPECT_EQ(std::get<AirQuality>(air->event).timestamp.time_since_epoch(),
+            milliseconds(1500));
+
+  pw::Result<ScriptStep> light = ParseScriptLine("  20\tlight 12.5 ");
+  ASSERT_EQ(light.status(), pw::OkStatus());
+  ASSERT_TRUE(std::holds_alternative<AmbientLightSample>(light->event));
+  EXPECT_EQ(std::get<AmbientLightSample>(light->event).sample_lux, 12.5f);
+
+  pw::Result<ScriptStep> proximity = ParseScriptLine("0 proximity 20000");
+  ASSERT_EQ(proximity.status(), pw::OkStatus());
+  ASSERT_TRUE(std::holds_alternative<ProximitySample>(proximity->event));
+  EXPECT_EQ(std::get<ProximitySample>(proximity->event).sample, 20000u);
+}
+
+TEST(ParseScriptLineTest, Buttons) {
+  pw::Result<ScriptStep> press = ParseScriptLine("10 button y press");
+  ASSERT_EQ(press.status(), pw::OkStatus());
+  ASSERT_TRUE(std::holds_alternative<ButtonY>(press->event));
+  EXPECT_TRUE(std::get<ButtonY>(press->event).pressed());
+
+  pw::Result<ScriptStep> release = ParseScriptLine("20 button a release");
+  ASSERT_EQ(release.status(), pw::OkStatus());
+  ASSERT_TRUE(std::holds_alternative<ButtonA>(release->event));
+  EXPECT_FALSE(std::get<ButtonA>(release->event).pressed());
+}
+
+TEST(ParseScriptLineTest, BlankAndCommentLines) {
+  EXPECT_EQ(ParseScriptLine("").status(), pw::Status::NotFound());
+  EXPECT_EQ(ParseScriptLine("   ").status(), pw::Status::NotFound());
+  EXPECT_EQ(ParseScriptLine("# a comment with many words in it").status(),
+            pw::Status::NotFound());
+  EXPECT_EQ(ParseScriptLine("5 air 100  # trailing").status(),
+            pw::OkStatus());
+}
+
+TEST(ParseScriptLineTest, InvalidLines) {
+  EXPECT_EQ(ParseScriptLine("air 100").status(),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("-5 air 100").status(),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("5 air").status(), pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("5 air 70000").status(),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("5 smoke 1").status(),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("5 button z press").status(),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(ParseScriptLine("5 button a hold").status(),
+            pw::Status::InvalidArgument());
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,122 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/simulated_device.h"
+
+#include <utility>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+using ::pw::chrono::SystemClock;
+
+SimulatedDevice::SimulatedDevice(WorkerPool& pool, uint32_t id)
+    : id_(id),
+      worker_(pool),
+      blocking_worker_(pool),
+      pubsub_(worker_),
+      sensor_pubsub_(worker_),
+      state_manager_(pubsub_, polychrome_led_),
+      proximity_manager_(pubsub_, kFarThreshold, kNearThreshold),
+      event_timers_(pubsub_) {}
+
+pw::Status SimulatedDevice::Init() {
+  if (!sensor_to_control_.Init(sensor_pubsub_, pubsub_) ||
+      !control_to_sensor_.Init(pubsub_, sensor_pubsub_) ||
+      !pubsub_.Subscribe([this](const Event& event) { OnEvent(event); })) {
+    return pw::Status::ResourceExhausted();
+  }
+  PW_TRY(event_timers_.AddEventTimer(StateManager::kRepeatAlarmToken));
+  PW_TRY(event_timers_.AddEventTimer(StateManager::kSilenceAlarmToken));
+  PW_TRY(event_timers_.AddEventTimer(StateManager::kThresholdModeToken));
+  PW_TRY(proximity_sensor_.Enable());
+  PW_TRY(ambient_light_sensor_.Enable());
+  return air_sensor_.Init();
+}
+
+void SimulatedDevice::Sample(const Inputs& inputs) {
+  blocking_worker_.RunOnce([this, inputs] {
+    proximity_sensor_.set_sample(inputs.proximity);
+    ambient_light_sensor_.set_sample(inputs.light_lux);
+    air_sensor_.set_gas_resistance(inputs.gas_resistance);
+    ReadSensors();
+  });
+}
+
+void SimulatedDevice::ReadSensors() {
+  const SystemClock::time_point timestamp = SystemClock::now();
+  uint32_t dropped = 0;
+  if (pw::Result<uint16_t> sample = proximity_sensor_.ReadSample();
+      sample.ok() && !sensor_pubsub_.Publish(ProximitySample{
+                         .sample = *sample, .timestamp = timestamp})) {
+    ++dropped;
+  }
+  if (pw::Result<float> sample = ambient_light_sensor_.ReadSampleLux();
+      sample.ok() && !sensor_pubsub_.Publish(AmbientLightSample{
+                         .sample_lux = *sample, .timestamp = timestamp})) {
+    ++dropped;
+  }
+  if (air_sensor_.MeasureSync().ok()) {
+    const AirSensor::Readings readings = air_sensor_.Snapshot();
+    const AirQuality air_quality = {.score = readings.score,
+                                    .timestamp = timestamp,
+                                    .warming_up = readings.warming_up};
+    if (!sensor_pubsub_.Publish(air_quality)) {
+      ++dropped;
+    }
+    if (!sensor_pubsub_.Publish(readings.ToEvent(timestamp))) {
+      ++dropped;
+    }
+  }
+  samples_.fetch_add(1, std::memory_order_relaxed);
+  dropped_.fetch_add(dropped, std::memory_order_relaxed);
+}
+
+bool SimulatedDevice::Publish(const Event& event) {
+  if (pubsub_.Publish(event)) {
+    return true;
+  }
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void SimulatedDevice::OnEvent(const Event& event) {
+  events_.fetch_add(1, std::memory_order_relaxed);
+  if (!std::holds_alternative<SenseState>(event)) {
+    return;
+  }
+  const auto& state = std::get<SenseState>(event);
+  if (state.alarm != alarm_) {
+    alarm_ = state.alarm;
+    alarm_transitions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (on_state_ != nullptr) {
+    on_state_(*this, state);
+  }
+}
+
+SimulatedDevice::Stats SimulatedDevice::stats() const {
+  return {
+      .samples = samples_.load(std::memory_order_relaxed),
+      .events = events_.load(std::memory_order_relaxed),
+      .alarm_transitions = alarm_transitions_.load(std::memory_order_relaxed),
+      .dropped_events = dropped_.load(std::memory_order_relaxed) +
+                        sensor_to_control_.dropped() +
+                        control_to_sensor_.dropped(),
+  };
+}
+
+}  // namespace sense
@@ -0,0 +1,150 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "modules/air_sensor/air_sensor_fake.h"
+#include "modules/board/board_fake.h"
+#include "modules/event_timers/event_timers.h"
+#include "modules/led/polychrome_led_fake.h"
+#include "modules/light/fake_sensor.h"
+#include "modules/proximity/fake_sensor.h"
+#include "modules/proximity/manager.h"
+#include "modules/pubsub/bridge.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/simulation/worker_pool.h"
+#include "modules/state_manager/state_manager.h"
+#include "pw_function/function.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// One Sense device, with its own buses, workers, fake sensors and control
+/// components, so that a host process can run many of them side by side.
+///
+/// This is the host counterpart of the `system::` accessors: everything
+/// firmware reaches through a function-local static is a member here. The
+/// device's work runs on strands of a shared `WorkerPool`, so its components
+/// are never run concurrently with each other, as on hardware.
+///
+/// Host only.
+class SimulatedDevice {
+ public:
+  /// Sensor readings for one sampling pass.
+  struct Inputs {
+    uint16_t proximity = 0;
+    float light_lux = 0.f;
+    float gas_resistance = AirSensor::kDefaultGasResistance;
+  };
+
+  struct Stats {
+    uint32_t samples = 0;
+    uint32_t events = 0;
+    uint32_t alarm_transitions = 0;
+    /// Events either bus could not queue, including bridged ones.
+    uint32_t dropped_events = 0;
+  };
+
+  /// Called from the device's worker with every new `SenseState`.
+  using StateCallback = pw::Function<void(SimulatedDevice&, const SenseState&)>;
+
+  SimulatedDevice(WorkerPool& pool, uint32_t id);
+
+  /// The pool must be idle, e.g. after `WorkerPool::WaitUntilIdle`.
+  ~SimulatedDevice() = default;
+
+  SimulatedDevice(const SimulatedDevice&) = delete;
+  SimulatedDevice& operator=(const SimulatedDevice&) = delete;
+
+  /// Subscribes the device's components and initializes its sensors. Must be
+  /// called once, before the first sample.
+  pw::Status Init();
+
+  /// Sets the callback for state changes. Must be called before `Init`.
+  void set_state_callback(StateCallback&& callback) {
+    on_state_ = std::move(callback);
+  }
+
+  /// Feeds `inputs` to the fake sensors and, from the device's blocking
+  /// worker, reads and publishes a sample of each as the sampling thread does.
+  void Sample(const Inputs& inputs);
+
+  /// Publishes an event on the control bus, e.g. a button press. Returns
+  /// false if the queue was full.
+  bool Publish(const Event& event);
+
+  uint32_t id() const { return id_; }
+
+  Stats stats() const;
+
+  // Accessors named after their `system::` equivalents.
+  PubSub& pubsub() { return pubsub_; }
+  PubSub& sensor_pubsub() { return sensor_pubsub_; }
+  Worker& worker() { return worker_; }
+  Worker& blocking_worker() { return blocking_worker_; }
+  AirSensorFake& air_sensor() { return air_sensor_; }
+  FakeProximitySensor& proximity_sensor() { return proximity_sensor_; }
+  FakeAmbientLightSensor& ambient_light_sensor() {
+    return ambient_light_sensor_;
+  }
+  BoardFake& board() { return board_; }
+  PolychromeLedFake& polychrome_led() { return polychrome_led_; }
+  StateManager& state_manager() { return state_manager_; }
+
+ private:
+  // Same thresholds as the production app.
+  static constexpr uint16_t kFarThreshold = 512;
+  static constexpr uint16_t kNearThreshold = 16384;
+
+  void OnEvent(const Event& event);
+  void ReadSensors();
+
+  const uint32_t id_;
+
+  WorkerPool::Strand worker_;
+  WorkerPool::Strand blocking_worker_;
+  ControlPubSubBuffer pubsub_;
+  SensorPubSubBuffer sensor_pubsub_;
+
+  AirSensorFake air_sensor_;
+  FakeProximitySensor proximity_sensor_;
+  FakeAmbientLightSensor ambient_light_sensor_;
+  BoardFake board_;
+  PolychromeLedFake polychrome_led_;
+
+  PubSubBridge<Event,
+               ProximitySample,
+               AmbientLightSample,
+               AirQuality,
+               AirMeasurement>
+      sensor_to_control_;
+  PubSubBridge<Event, SenseState> control_to_sensor_;
+  StateManager state_manager_;
+  ProximityManager proximity_manager_;
+  EventTimers<3> event_timers_;
+
+  StateCallback on_state_;
+  bool alarm_ = false;
+
+  // Written from the device's workers, read from anywhere.
+  std::atomic<uint32_t> samples_ = 0;
+  std::atomic<uint32_t> events_ = 0;
+  std::atomic<uint32_t> alarm_transitions_ = 0;
+  std::atomic<uint32_t> dropped_ = 0;
+};
+
+}  // namespace sense
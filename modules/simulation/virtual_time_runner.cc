@@ -0,0 +1,127 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/virtual_time_runner.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace sense {
+
+using std::chrono::milliseconds;
+
+VirtualTimeRunner::VirtualTimeRunner(PubSub& pubsub,
+                                     ManualWorker& worker,
+                                     double speedup)
+    : pubsub_(pubsub), worker_(worker), speedup_(speedup) {}
+
+pw::Status VirtualTimeRunner::Init() {
+  if (!pubsub_.Subscribe([this](const Event& event) { OnEvent(event); })) {
+    return pw::Status::ResourceExhausted();
+  }
+  wall_start_ = Clock::now();
+  return pw::OkStatus();
+}
+
+void VirtualTimeRunner::OnEvent(const Event& event) {
+  ++report_.events;
+  switch (static_cast<EventType>(event.index())) {
+    case kTimerRequest: {
+      const auto& request = std::get<TimerRequest>(event);
+      timers_[request.token] = {
+          .deadline = now_ + milliseconds(request.timeout_ms),
+          .period = milliseconds(request.period_ms),
+      };
+      break;
+    }
+    case kTimerCancel:
+      timers_.erase(std::get<TimerCancel>(event).token);
+      break;
+    case kSenseState: {
+      const auto& state = std::get<SenseState>(event);
+      if (state.alarm != alarm_) {
+        alarm_ = state.alarm;
+        ++report_.alarm_transitions;
+        if (on_transition_ != nullptr) {
+          on_transition_(now_, state);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+pw::Status VirtualTimeRunner::Apply(const ScriptStep& step) {
+  if (step.time < now_) {
+    return pw::Status::InvalidArgument();
+  }
+  AdvanceTo(step.time);
+  ++report_.steps;
+  PublishAndRun(step.event);
+  return pw::OkStatus();
+}
+
+void VirtualTimeRunner::AdvanceTo(milliseconds time) {
+  while (true) {
+    auto next = std::min_element(
+        timers_.begin(), timers_.end(), [](const auto& a, const auto& b) {
+          return a.second.deadline < b.second.deadline;
+        });
+    if (next == timers_.end() || next->second.deadline > time) {
+      break;
+    }
+    const uint32_t token = next->first;
+    now_ = next->second.deadline;
+    if (next->second.period > milliseconds::zero()) {
+      next->second.deadline += next->second.period;
+    } else {
+      timers_.erase(next);
+    }
+    Pace(now_);
+    ++report_.timers_fired;
+    PublishAndRun(TimerExpired{.token = token});
+  }
+  now_ = time;
+  report_.virtual_time = now_;
+  Pace(now_);
+}
+
+void VirtualTimeRunner::Pace(milliseconds time) {
+  if (speedup_ > 0) {
+    std::this_thread::sleep_until(
+        wall_start_ + std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double, std::milli>(
+                              static_cast<double>(time.count()) / speedup_)));
+  }
+}
+
+void VirtualTimeRunner::PublishAndRun(const Event& event) {
+  const Clock::time_point start = Clock::now();
+  if (!pubsub_.Publish(event)) {
+    ++report_.dropped_events;
+  }
+  worker_.RunUntilIdle();
+  report_.max_step_wall_time =
+      std::max(report_.max_step_wall_time, Clock::now() - start);
+}
+
+VirtualTimeRunner::Report VirtualTimeRunner::report() const {
+  Report report = report_;
+  report.wall_time = Clock::now() - wall_start_;
+  return report;
+}
+
+}  // namespace sense
@@ -0,0 +1,102 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/simulation/manual_worker.h"
+#include "modules/simulation/script.h"
+#include "pw_function/function.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Runs the event pipeline against scripted inputs in virtual time.
+///
+/// Each step is published once virtual time reaches it, and everything it
+/// triggers is processed before time advances, so runs are deterministic.
+/// `TimerRequest`s are served in virtual time in place of `EventTimers`.
+class VirtualTimeRunner {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Report {
+    uint32_t steps = 0;
+    uint32_t events = 0;
+    uint32_t dropped_events = 0;
+    uint32_t timers_fired = 0;
+    uint32_t alarm_transitions = 0;
+    std::chrono::milliseconds virtual_time{0};
+    Clock::duration wall_time{0};
+    /// Longest wall time spent processing one step or timer expiration.
+    Clock::duration max_step_wall_time{0};
+  };
+
+  /// Called with the virtual time of every `SenseState` whose alarm differs
+  /// from the previous one.
+  using TransitionCallback =
+      pw::Function<void(std::chrono::milliseconds, const SenseState&)>;
+
+  /// Runs with `pubsub`, which must dispatch on `worker`. A nonzero `speedup`
+  /// paces the run at that many virtual seconds per wall second; zero runs as
+  /// fast as possible.
+  VirtualTimeRunner(PubSub& pubsub, ManualWorker& worker, double speedup = 0);
+
+  /// Subscribes to `pubsub`. Must be called before the first step.
+  pw::Status Init();
+
+  void set_transition_callback(TransitionCallback&& callback) {
+    on_transition_ = std::move(callback);
+  }
+
+  /// Fires the timers due up to the step's time, then publishes its event.
+  ///
+  /// @returns InvalidArgument if the step is earlier than the previous one.
+  pw::Status Apply(const ScriptStep& step);
+
+  /// Fires the timers due up to `time` and advances virtual time to it.
+  void AdvanceTo(std::chrono::milliseconds time);
+
+  /// Returns the statistics of the run so far.
+  Report report() const;
+
+ private:
+  struct Timer {
+    std::chrono::milliseconds deadline;
+    std::chrono::milliseconds period;
+  };
+
+  void OnEvent(const Event& event);
+
+  /// Waits until the wall clock catches up with `time`, if pacing.
+  void Pace(std::chrono::milliseconds time);
+
+  /// Publishes `event` and processes everything it triggers.
+  void PublishAndRun(const Event& event);
+
+  PubSub& pubsub_;
+  ManualWorker& worker_;
+  const double speedup_;
+  std::chrono::milliseconds now_{0};
+  Clock::time_point wall_start_;
+  std::map<uint32_t, Timer> timers_;
+  bool alarm_ = false;
+  TransitionCallback on_transition_;
+  Report report_;
+};
+
+}  // namespace sense
@@ -0,0 +1,113 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/virtual_time_runner.h"
+
+#include <chrono>
+#include <vector>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using std::chrono::milliseconds;
+
+SenseState StateWithAlarm(bool alarm) {
+  return {.alarm = alarm,
+          .alarm_threshold = 0,
+          .air_quality = 0,
+          .air_quality_rating = AirQualityRating::kInvalid};
+}
+
+class VirtualTimeRunnerTest : public ::testing::Test {
+ protected:
+  VirtualTimeRunnerTest() : pubsub_(worker_), runner_(pubsub_, worker_) {}
+
+  void SetUp() override {
+    ASSERT_EQ(runner_.Init(), pw::OkStatus());
+    ASSERT_TRUE(pubsub_.SubscribeTo<TimerExpired>(
+        [this](TimerExpired timer) { expired_.push_back(timer.token); }));
+  }
+
+  ManualWorker worker_;
+  GenericPubSubBuffer<Event, 4, 4> pubsub_;
+  VirtualTimeRunner runner_;
+  std::vector<uint32_t> expired_;
+};
+
+TEST_F(VirtualTimeRunnerTest, StepsAreProcessedBeforeTimeAdvances) {
+  int presses = 0;
+  ASSERT_TRUE(pubsub_.SubscribeTo<ButtonA>([&presses](ButtonA) { ++presses; }));
+
+  ASSERT_EQ(runner_.Apply({.time = milliseconds(5), .event = ButtonA(true)}),
+            pw::OkStatus());
+  EXPECT_EQ(presses, 1);
+  EXPECT_EQ(runner_.Apply({.time = milliseconds(4), .event = ButtonA(true)}),
+            pw::Status::InvalidArgument());
+  EXPECT_EQ(runner_.report().steps, 1u);
+}
+
+TEST_F(VirtualTimeRunnerTest, TimersFireInVirtualTime) {
+  ASSERT_TRUE(pubsub_.Publish(TimerRequest{.token = 1, .timeout_ms = 1000}));
+  worker_.RunUntilIdle();
+
+  runner_.AdvanceTo(milliseconds(999));
+  EXPECT_TRUE(expired_.empty());
+  runner_.AdvanceTo(milliseconds(1000));
+  EXPECT_EQ(expired_, std::vector<uint32_t>{1});
+  runner_.AdvanceTo(milliseconds(60'000));
+  EXPECT_EQ(expired_.size(), 1u);
+  EXPECT_EQ(runner_.report().timers_fired, 1u);
+}
+
+TEST_F(VirtualTimeRunnerTest, PeriodicAndCancelledTimers) {
+  ASSERT_TRUE(pubsub_.Publish(
+      TimerRequest{.token = 2, .timeout_ms = 100, .period_ms = 100}));
+  ASSERT_TRUE(pubsub_.Publish(TimerRequest{.token = 3, .timeout_ms = 250}));
+  worker_.RunUntilIdle();
+
+  runner_.AdvanceTo(milliseconds(300));
+  EXPECT_EQ(expired_, (std::vector<uint32_t>{2, 2, 3, 2}));
+
+  ASSERT_TRUE(pubsub_.Publish(TimerCancel{.token = 2}));
+  worker_.RunUntilIdle();
+  runner_.AdvanceTo(milliseconds(1000));
+  EXPECT_EQ(expired_.size(), 4u);
+}
+
+TEST_F(VirtualTimeRunnerTest, ReportsAlarmTransitions) {
+  std::vector<milliseconds> transitions;
+  runner_.set_transition_callback(
+      [&transitions](milliseconds time, const SenseState&) {
+        transitions.push_back(time);
+      });
+
+  runner_.AdvanceTo(milliseconds(10));
+  ASSERT_TRUE(pubsub_.Publish(StateWithAlarm(true)));
+  worker_.RunUntilIdle();
+  ASSERT_TRUE(pubsub_.Publish(StateWithAlarm(true)));
+  worker_.RunUntilIdle();
+  runner_.AdvanceTo(milliseconds(20));
+  ASSERT_TRUE(pubsub_.Publish(StateWithAlarm(false)));
+  worker_.RunUntilIdle();
+
+  EXPECT_EQ(transitions,
+            (std::vector<milliseconds>{milliseconds(10), milliseconds(20)}));
+  EXPECT_EQ(runner_.report().alarm_transitions, 2u);
+  EXPECT_EQ(runner_.report().virtual_time, milliseconds(20));
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,120 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/worker_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace sense {
+
+WorkerPool::WorkerPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this] { Run(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  WaitUntilIdle();
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::WaitUntilIdle() {
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return ready_.empty() && busy_strands_ == 0; });
+}
+
+void WorkerPool::Schedule(Strand& strand) {
+  {
+    std::lock_guard lock(mutex_);
+    ready_.push_back(&strand);
+  }
+  work_available_.notify_one();
+}
+
+void WorkerPool::Run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    work_available_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+    if (ready_.empty()) {
+      return;
+    }
+    Strand& strand = *ready_.front();
+    ready_.pop_front();
+    ++busy_strands_;
+    lock.unlock();
+
+    const bool more = strand.RunSome(kMaxItemsPerTurn);
+
+    lock.lock();
+    --busy_strands_;
+    if (more) {
+      // Back of the line, behind the strands that were waiting.
+      ready_.push_back(&strand);
+    } else if (ready_.empty() && busy_strands_ == 0) {
+      idle_.notify_all();
+    }
+  }
+}
+
+bool WorkerPool::Strand::RunOnce(pw::Function<void()>&& work) {
+  bool schedule;
+  {
+    std::lock_guard lock(mutex_);
+    work_.push_back(std::move(work));
+    schedule = !std::exchange(scheduled_, true);
+  }
+  if (schedule) {
+    pool_.Schedule(*this);
+  }
+  return true;
+}
+
+size_t WorkerPool::Strand::items_run() const {
+  std::lock_guard lock(mutex_);
+  return items_run_;
+}
+
+bool WorkerPool::Strand::RunSome(size_t max_items) {
+  for (size_t i = 0; i < max_items; ++i) {
+    pw::Function<void()> work;
+    {
+      std::lock_guard lock(mutex_);
+      if (work_.empty()) {
+        scheduled_ = false;
+        return false;
+      }
+      work = std::move(work_.front());
+      work_.pop_front();
+      ++items_run_;
+    }
+    work();
+  }
+  std::lock_guard lock(mutex_);
+  scheduled_ = !work_.empty();
+  return scheduled_;
+}
+
+}  // namespace sense
@@ -0,0 +1,102 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "modules/worker/worker.h"
+#include "pw_function/function.h"
+
+namespace sense {
+
+/// Fixed set of threads shared by many simulated devices.
+///
+/// Work is queued on a `Strand`, which runs its work in order and never on
+/// two threads at once, so each device's components see the same
+/// single-threaded dispatch they do on hardware while the pool spreads
+/// devices across cores.
+///
+/// Host only.
+class WorkerPool {
+ public:
+  class Strand;
+
+  /// Starts `threads` threads, or one per core if zero.
+  explicit WorkerPool(size_t threads = 0);
+
+  /// Stops the threads once every strand's queued work has run. Strands must
+  /// not be given more work once this starts.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t threads() const { return threads_.size(); }
+
+  /// Blocks until no strand has work queued or running.
+  void WaitUntilIdle();
+
+ private:
+  // Strands run at most this many items before yielding their thread, so that
+  // a busy device cannot starve the others.
+  static constexpr size_t kMaxItemsPerTurn = 16;
+
+  void Schedule(Strand& strand);
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable idle_;
+  std::deque<Strand*> ready_;
+  size_t busy_strands_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+/// Worker whose work runs in order on a `WorkerPool`, one item at a time.
+class WorkerPool::Strand final : public Worker {
+ public:
+  explicit Strand(WorkerPool& pool) : pool_(pool) {}
+
+  /// The strand must be idle, e.g. after `WorkerPool::WaitUntilIdle`.
+  ~Strand() = default;
+
+  Strand(const Strand&) = delete;
+  Strand& operator=(const Strand&) = delete;
+
+  bool RunOnce(pw::Function<void()>&& work) override;
+
+  /// Total number of work items this strand has run.
+  size_t items_run() const;
+
+ private:
+  friend class WorkerPool;
+
+  // Runs up to `max_items` queued items. Returns whether more are queued, in
+  // which case the strand stays scheduled.
+  bool RunSome(size_t max_items);
+
+  WorkerPool& pool_;
+  mutable std::mutex mutex_;
+  std::deque<pw::Function<void()>> work_;
+  bool scheduled_ = false;
+  size_t items_run_ = 0;
+};
+
+}  // namespace sense
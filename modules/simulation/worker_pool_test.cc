@@ -0,0 +1,82 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/simulation/worker_pool.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+TEST(WorkerPoolTest, StrandRunsWorkInOrder) {
+  WorkerPool pool(4);
+  WorkerPool::Strand strand(pool);
+  std::vector<int> order;
+  for (int i = 0; i < 100; ++i) {
+    strand.RunOnce([&order, i] { order.push_back(i); });
+  }
+  pool.WaitUntilIdle();
+
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+  EXPECT_EQ(strand.items_run(), 100u);
+}
+
+TEST(WorkerPoolTest, StrandNeverRunsConcurrently) {
+  WorkerPool pool(4);
+  std::deque<WorkerPool::Strand> strands;
+  std::vector<std::atomic<int>> running(8);
+  std::atomic<bool> overlapped = false;
+  for (size_t s = 0; s < running.size(); ++s) {
+    strands.emplace_back(pool);
+  }
+  for (int i = 0; i < 200; ++i) {
+    for (size_t s = 0; s < strands.size(); ++s) {
+      strands[s].RunOnce([&running, &overlapped, s] {
+        if (running[s].fetch_add(1) != 0) {
+          overlapped = true;
+        }
+        running[s].fetch_sub(1);
+      });
+    }
+  }
+  pool.WaitUntilIdle();
+
+  EXPECT_FALSE(overlapped);
+  for (const WorkerPool::Strand& strand : strands) {
+    EXPECT_EQ(strand.items_run(), 200u);
+  }
+}
+
+TEST(WorkerPoolTest, WaitUntilIdleIncludesWorkQueuedByWork) {
+  WorkerPool pool(2);
+  WorkerPool::Strand first(pool);
+  WorkerPool::Strand second(pool);
+  int ran = 0;
+  first.RunOnce([&] {
+    second.RunOnce([&] { first.RunOnce([&] { ++ran; }); });
+  });
+  pool.WaitUntilIdle();
+
+  EXPECT_EQ(ran, 1);
+}
+
+}  // namespace
+}  // namespace sense
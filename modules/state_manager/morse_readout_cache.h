@@ -0,0 +1,118 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "modules/morse_code/timeline.h"
+#include "modules/pubsub/payload.h"
+#include "pw_result/result.h"
+#include "pw_status/try.h"
+#include "pw_string/string.h"
+
+namespace sense {
+
+/// Most recently used Morse readouts, each with its text and compiled
+/// timeline, keyed by the value the readout describes.
+///
+/// Entries keep a reference to their text in a `PayloadPool`, so a hit is
+/// republished without formatting, allocating or compiling anything. An entry
+/// is only replaced while no event carries its text, since its timeline must
+/// outlive any request that points at it. The pool needs a block per entry
+/// plus one per readout that may be in flight after its entry is replaced.
+///
+/// Not thread safe.
+template <size_t kMaxLen, size_t kEntries>
+class MorseReadoutCache {
+ public:
+  using Text = pw::InlineString<kMaxLen>;
+
+  struct Readout {
+    /// A new reference to the text, for the caller to publish or release.
+    Payload text;
+
+    /// The compiled text, or empty if every entry was in flight and it could
+    /// not be cached.
+    MorseRuns runs;
+  };
+
+  MorseReadoutCache() = default;
+
+  MorseReadoutCache(const MorseReadoutCache&) = delete;
+  MorseReadoutCache& operator=(const MorseReadoutCache&) = delete;
+
+  ~MorseReadoutCache() {
+    for (Entry& entry : entries_) {
+      entry.text.Release();
+    }
+  }
+
+  /// Returns the readout for `key`. On a miss, `format` is called with a
+  /// `Text` to write the readout into, which is then copied into `pool`.
+  template <typename Format>
+  pw::Result<Readout> Get(uint16_t key, PayloadPool& pool, Format&& format) {
+    Entry* victim = nullptr;
+    for (Entry& entry : entries_) {
+      if (entry.text.has_value() && entry.key == key) {
+        ++hits_;
+        return Use(entry);
+      }
+      const bool replaceable = !entry.text.has_value() || entry.text.unique();
+      if (replaceable &&
+          (victim == nullptr || entry.last_used < victim->last_used)) {
+        victim = &entry;
+      }
+    }
+
+    ++misses_;
+    Text text;
+    format(text);
+    PW_TRY_ASSIGN(Payload payload, pool.Allocate(std::string_view(text)));
+    if (victim == nullptr) {
+      return Readout{.text = payload, .runs = {}};
+    }
+    victim->text.Release();
+    victim->key = key;
+    victim->text = payload;
+    victim->timeline.Compile(text);
+    return Use(*victim);
+  }
+
+  uint32_t hits() const { return hits_; }
+  uint32_t misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    uint16_t key = 0;
+    Payload text;
+    MorseTimeline<MaxMorseRuns(kMaxLen)> timeline;
+    uint32_t last_used = 0;
+  };
+
+  Readout Use(Entry& entry) {
+    entry.last_used = ++uses_;
+    entry.text.Retain();
+    return {.text = entry.text, .runs = entry.timeline.runs()};
+  }
+
+  std::array<Entry, kEntries> entries_;
+  uint32_t uses_ = 0;
+  uint32_t hits_ = 0;
+  uint32_t misses_ = 0;
+};
+
+}  // namespace sense
@@ -0,0 +1,117 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/state_manager/morse_readout_cache.h"
+
+#include <string_view>
+
+#include "pw_assert/assert.h"
+#include "pw_string/format.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+constexpr size_t kMaxLen = 8;
+using Cache = MorseReadoutCache<kMaxLen, 2>;
+
+// Formats the key itself as the readout.
+auto FormatKey(uint16_t key) {
+  return [key](Cache::Text& text) {
+    PW_ASSERT(pw::string::FormatOverwrite(text, "%hu", key).ok());
+  };
+}
+
+void FailIfFormatted(Cache::Text&) { ADD_FAILURE() << "Readout formatted"; }
+
+class MorseReadoutCacheTest : public ::testing::Test {
+ protected:
+  // Returns the text of the readout for `key`, releasing its reference.
+  std::string_view GetText(Cache& cache, uint16_t key) {
+    pw::Result<Cache::Readout> readout = cache.Get(key, pool_, FormatKey(key));
+    EXPECT_EQ(readout.status(), pw::OkStatus());
+    if (!readout.ok()) {
+      return {};
+    }
+    readout->text.Release();
+    return readout->text.str();
+  }
+
+  PayloadPoolBuffer<kMaxLen, 3> pool_;
+};
+
+TEST_F(MorseReadoutCacheTest, HitReplaysWithoutFormatting) {
+  Cache cache;
+  pw::Result<Cache::Readout> first = cache.Get(42, pool_, FormatKey(42));
+  ASSERT_EQ(first.status(), pw::OkStatus());
+  EXPECT_EQ(first->text.str(), "42");
+  EXPECT_EQ(first->runs.dits(), CompileMorse("42").runs().dits());
+  first->text.Release();
+
+  pw::Result<Cache::Readout> second = cache.Get(42, pool_, FailIfFormatted);
+  ASSERT_EQ(second.status(), pw::OkStatus());
+  EXPECT_EQ(second->text.str(), "42");
+  EXPECT_EQ(second->runs.dits(), first->runs.dits());
+  second->text.Release();
+
+  EXPECT_EQ(cache.hits(), 1u);
+  EXPECT_EQ(cache.misses(), 1u);
+}
+
+TEST_F(MorseReadoutCacheTest, ReplacesLeastRecentlyUsed) {
+  Cache cache;
+  EXPECT_EQ(GetText(cache, 1), "1");
+  EXPECT_EQ(GetText(cache, 2), "2");
+  EXPECT_EQ(GetText(cache, 1), "1");
+  EXPECT_EQ(GetText(cache, 3), "3");
+  EXPECT_EQ(cache.misses(), 3u);
+
+  EXPECT_EQ(GetText(cache, 1), "1");
+  EXPECT_EQ(cache.misses(), 3u);
+  EXPECT_EQ(GetText(cache, 2), "2");
+  EXPECT_EQ(cache.misses(), 4u);
+}
+
+TEST_F(MorseReadoutCacheTest, KeepsEntriesInFlight) {
+  MorseReadoutCache<kMaxLen, 1> cache;
+  pw::Result<MorseReadoutCache<kMaxLen, 1>::Readout> in_flight =
+      cache.Get(1, pool_, FormatKey(1));
+  ASSERT_EQ(in_flight.status(), pw::OkStatus());
+
+  // The only entry is in flight, so the next readout is not cached.
+  pw::Result<MorseReadoutCache<kMaxLen, 1>::Readout> uncached =
+      cache.Get(2, pool_, FormatKey(2));
+  ASSERT_EQ(uncached.status(), pw::OkStatus());
+  EXPECT_EQ(uncached->text.str(), "2");
+  EXPECT_TRUE(uncached->runs.empty());
+  uncached->text.Release();
+
+  EXPECT_EQ(in_flight->text.str(), "1");
+  EXPECT_FALSE(in_flight->runs.empty());
+  in_flight->text.Release();
+  EXPECT_EQ(cache.hits(), 0u);
+}
+
+TEST_F(MorseReadoutCacheTest, ReleasesTextWhenDestroyed) {
+  {
+    Cache cache;
+    GetText(cache, 1);
+    GetText(cache, 2);
+    EXPECT_EQ(pool_.available(), 1u);
+  }
+  EXPECT_EQ(pool_.available(), 3u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -14,18 +14,24 @@
 
 #include "modules/state_manager/service.h"
 
+#include <array>
+#include <chrono>
 #include <mutex>
 
 #include "pw_assert/check.h"
-#include "pw_string/util.h"
 
 namespace sense {
 
-StateManagerService::StateManagerService(PubSub& pubsub) : pubsub_(&pubsub) {
-  PW_CHECK(pubsub_->SubscribeTo<SenseState>([this](SenseState event) {
-    std::lock_guard lock(current_state_lock_);
-    current_state_ = event;
-  }));
+StateManagerService::StateManagerService(
+    PubSub& pubsub, const TransitionMetrics* transition_metrics)
+    : pubsub_(&pubsub), transition_metrics_(transition_metrics) {
+  PW_CHECK(pubsub_->SubscribeTo<SenseState>(
+      [this](const SenseState& state) { Update(state); }));
+}
+
+void StateManagerService::Update(const SenseState& state) {
+  std::lock_guard lock(current_state_lock_);
+  current_state_ = state;
 }
 
 pw::Status StateManagerService::ChangeThreshold(
@@ -62,9 +68,57 @@ pw::Status StateManagerService::GetState(const pw_protobuf_Empty&,
   response.alarm_active = current_state.alarm;
   response.alarm_threshold = current_state.alarm_threshold;
   response.aq_score = current_state.air_quality;
-  return pw::string::Copy(current_state.air_quality_description,
-                          response.aq_description)
-      .status();
+  response.aq_rating = static_cast<state_manager_AirQualityRating>(
+      current_state.air_quality_rating);
+  return pw::OkStatus();
+}
+
+pw::Status StateManagerService::GetTransitionStats(
+    const pw_protobuf_Empty&, state_manager_TransitionStats& response) {
+  if (transition_metrics_ == nullptr) {
+    return pw::Status::Unimplemented();
+  }
+  const TransitionMetrics& metrics = *transition_metrics_;
+  const auto now = TransitionMetrics::Clock::now();
+
+  response.current_mode =
+      static_cast<state_manager_Mode>(metrics.current_state());
+
+  constexpr size_t kModes = std::size(response.modes);
+  static_assert(kModes <= TransitionMetrics::kMaxStates);
+  response.modes_count = static_cast<pb_size_t>(kModes);
+  for (size_t i = 0; i < kModes; ++i) {
+    const auto stats = metrics.state(i, now);
+    response.modes[i] = {
+        .mode = static_cast<state_manager_Mode>(i),
+        .entries = stats.entries,
+        .dwell_ms = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                stats.dwell_time)
+                .count()),
+    };
+  }
+
+  std::array<TransitionMetrics::Record, std::size(response.recent)> records;
+  uint32_t first = 0;
+  const size_t count = metrics.Read(records, first);
+  response.recent_count = static_cast<pb_size_t>(count);
+  for (size_t i = 0; i < count; ++i) {
+    const auto& record = records[i];
+    response.recent[i] = {
+        .from_mode = static_cast<state_manager_Mode>(record.from),
+        .to_mode = static_cast<state_manager_Mode>(record.to),
+        .timestamp_us = record.timestamp_us,
+        .has_latency_us =
+            record.latency_us != TransitionMetrics::kUnknownLatency,
+        .latency_us = record.latency_us,
+    };
+  }
+
+  response.latency_samples = metrics.latency_samples();
+  response.mean_latency_us = metrics.mean_latency_us();
+  response.max_latency_us = metrics.max_latency_us();
+  return pw::OkStatus();
 }
 
 }  // namespace sense
@@ -17,6 +17,7 @@
 
 #include "modules/pubsub/pubsub_events.h"
 #include "modules/state_manager/state_manager.rpc.pb.h"
+#include "modules/state_manager/transition_metrics.h"
 #include "pw_sync/interrupt_spin_lock.h"
 #include "pw_sync/lock_annotations.h"
 
@@ -26,16 +27,31 @@ class StateManagerService final
     : public ::state_manager::pw_rpc::nanopb::StateManager::Service<
           StateManagerService> {
  public:
-  StateManagerService(PubSub& pubsub);
+  /// Reports transitions from `transition_metrics`, if provided.
+  StateManagerService(PubSub& pubsub,
+                      const TransitionMetrics* transition_metrics = nullptr);
+
+  /// Does not subscribe to `pubsub`; a static subscriber list must call
+  /// `Update` with every `SenseState` instead.
+  StateManagerService(PubSub& pubsub,
+                      StaticallySubscribed,
+                      const TransitionMetrics* transition_metrics = nullptr)
+      : pubsub_(&pubsub), transition_metrics_(transition_metrics) {}
+
+  /// Records the latest state.
+  void Update(const SenseState& state) PW_LOCKS_EXCLUDED(current_state_lock_);
 
   pw::Status ChangeThreshold(
       const state_manager_ChangeThresholdRequest& request,
       pw_protobuf_Empty& response);
   pw::Status SilenceAlarm(const pw_protobuf_Empty&, pw_protobuf_Empty&);
   pw::Status GetState(const pw_protobuf_Empty&, state_manager_State& response);
+  pw::Status GetTransitionStats(const pw_protobuf_Empty&,
+                                state_manager_TransitionStats& response);
 
  private:
   PubSub* pubsub_;
+  const TransitionMetrics* transition_metrics_;
   pw::sync::InterruptSpinLock current_state_lock_;
   std::optional<SenseState> current_state_ PW_GUARDED_BY(current_state_lock_);
 };
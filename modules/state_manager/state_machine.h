@@ -0,0 +1,101 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace sense {
+namespace internal {
+
+template <typename State, typename Event, typename = void>
+struct Handles : std::false_type {};
+
+template <typename State, typename Event>
+struct Handles<State,
+               Event,
+               std::void_t<decltype(std::declval<State&>().Handle(
+                   std::declval<const Event&>()))>> : std::true_type {};
+
+}  // namespace internal
+
+/// State machine whose states are the alternatives of a `std::variant`.
+///
+/// `Dispatch` passes an event to the current state's `Handle` overload through
+/// `std::visit`, so each (state, event) pair resolves at compile time to a
+/// direct call that can be inlined. Dispatching an event that some state does
+/// not handle fails to compile rather than being ignored at run time.
+///
+/// Each state must provide `void OnEnter()`, which is called once the state is
+/// current. States may transition from `OnEnter` or from their handlers, but
+/// must not touch their own members afterwards, since they have been
+/// destroyed.
+template <typename... States>
+class StateMachine {
+ public:
+  template <typename Initial, typename... Args>
+  explicit StateMachine(std::in_place_type_t<Initial> initial, Args&&... args)
+      : state_(initial, std::forward<Args>(args)...) {}
+
+  StateMachine(const StateMachine&) = delete;
+  StateMachine& operator=(const StateMachine&) = delete;
+
+  /// Destroys the current state and enters a new one.
+  template <typename State, typename... Args>
+  void Transition(Args&&... args) {
+    state_.template emplace<State>(std::forward<Args>(args)...).OnEnter();
+  }
+
+  /// Passes an event to the current state.
+  template <typename Event>
+  void Dispatch(const Event& event) {
+    static_assert((internal::Handles<States, Event>::value && ...),
+                  "Every state must have a Handle overload for the event");
+    std::visit([&event](auto& state) { state.Handle(event); }, state_);
+  }
+
+  /// Calls `function` with the current state.
+  template <typename Function>
+  decltype(auto) Visit(Function&& function) const {
+    return std::visit(std::forward<Function>(function), state_);
+  }
+
+  /// Returns the position of `State` in the state list.
+  template <typename State>
+  static constexpr size_t IndexOf() {
+    constexpr bool kMatches[] = {std::is_same_v<State, States>...};
+    for (size_t i = 0; i < sizeof...(States); ++i) {
+      if (kMatches[i]) {
+        return i;
+      }
+    }
+    return sizeof...(States);
+  }
+
+  /// Returns the position of the current state in the state list.
+  size_t index() const { return state_.index(); }
+
+  /// Returns whether `State` is the current state.
+  template <typename State>
+  bool is() const {
+    return std::holds_alternative<State>(state_);
+  }
+
+ private:
+  std::variant<States...> state_;
+};
+
+}  // namespace sense
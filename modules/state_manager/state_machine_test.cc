@@ -0,0 +1,98 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/state_manager/state_machine.h"
+
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+struct Start {};
+struct Stop {};
+
+struct Log {
+  int entered = 0;
+  int started = 0;
+  int stopped = 0;
+};
+
+struct Idle {
+  explicit Idle(Log& log) : log(log) {}
+  void OnEnter() { ++log.entered; }
+  void Handle(const Start&) { ++log.started; }
+  void Handle(const Stop&) {}
+  Log& log;
+};
+
+struct Running {
+  explicit Running(Log& log) : log(log) {}
+  void OnEnter() { ++log.entered; }
+  void Handle(const Start&) {}
+  void Handle(const Stop&) { ++log.stopped; }
+  Log& log;
+};
+
+TEST(StateMachineTest, StartsInInitialStateWithoutEntering) {
+  Log log;
+  StateMachine<Idle, Running> machine(std::in_place_type<Idle>, log);
+  EXPECT_TRUE(machine.is<Idle>());
+  EXPECT_EQ(log.entered, 0);
+}
+
+TEST(StateMachineTest, TransitionEntersNewState) {
+  Log log;
+  StateMachine<Idle, Running> machine(std::in_place_type<Idle>, log);
+  machine.Transition<Running>(log);
+  EXPECT_TRUE(machine.is<Running>());
+  EXPECT_EQ(log.entered, 1);
+}
+
+TEST(StateMachineTest, DispatchesToCurrentState) {
+  Log log;
+  StateMachine<Idle, Running> machine(std::in_place_type<Idle>, log);
+  machine.Dispatch(Start{});
+  machine.Dispatch(Stop{});
+  EXPECT_EQ(log.started, 1);
+  EXPECT_EQ(log.stopped, 0);
+
+  machine.Transition<Running>(log);
+  machine.Dispatch(Start{});
+  machine.Dispatch(Stop{});
+  EXPECT_EQ(log.started, 1);
+  EXPECT_EQ(log.stopped, 1);
+}
+
+TEST(StateMachineTest, VisitsCurrentState) {
+  Log log;
+  StateMachine<Idle, Running> machine(std::in_place_type<Running>, log);
+  const Log* visited =
+      machine.Visit([](const auto& state) -> const Log* { return &state.log; });
+  EXPECT_EQ(visited, &log);
+}
+
+TEST(StateMachineTest, IndexesStatesInListOrder) {
+  using Machine = StateMachine<Idle, Running>;
+  static_assert(Machine::IndexOf<Idle>() == 0);
+  static_assert(Machine::IndexOf<Running>() == 1);
+
+  Log log;
+  Machine machine(std::in_place_type<Idle>, log);
+  EXPECT_EQ(machine.index(), 0u);
+  machine.Transition<Running>(log);
+  EXPECT_EQ(machine.index(), 1u);
+}
+
+}  // namespace
+}  // namespace sense
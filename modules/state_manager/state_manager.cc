@@ -17,15 +17,17 @@
 
 #include "modules/state_manager/state_manager.h"
 
+#include <algorithm>
 #include <chrono>
-#include <cmath>
 #include <variant>
 
+#include "modules/profiling/gpio_markers.h"
 #include "pw_assert/check.h"
 #include "pw_chrono/system_clock.h"
 #include "pw_log/log.h"
 #include "pw_string/format.h"
 #include "pw_thread/sleep.h"
+#include "pw_trace/trace.h"
 
 namespace sense {
 
@@ -40,39 +42,62 @@ static void AddAndSmoothExponentially(std::optional<T>& aggregate,
   }
 }
 
-StateManager::StateManager(PubSub& pubsub, PolychromeLed& led)
-    : edge_detector_(0, 0), pubsub_(pubsub), led_(led), state_(*this) {
+StateManager::StateManager(PubSub& pubsub,
+                           PolychromeLed& led,
+                           uint16_t score_deadband,
+                           uint32_t color_fade_ms)
+    : StateManager(
+          pubsub, led, kStaticallySubscribed, score_deadband, color_fade_ms) {
+  PW_CHECK(pubsub_.Subscribe([this](const Event& event) { Update(event); }));
+}
+
+StateManager::StateManager(PubSub& pubsub,
+                           PolychromeLed& led,
+                           StaticallySubscribed,
+                           uint16_t score_deadband,
+                           uint32_t color_fade_ms)
+    : score_deadband_(score_deadband),
+      edge_detector_(0, 0),
+      pubsub_(pubsub),
+      led_(led, color_fade_ms),
+      transition_metrics_(Modes::IndexOf<MonitorMode>(),
+                          pw::chrono::SystemClock::now()),
+      state_(std::in_place_type<MonitorMode>, *this) {
+  static_assert(Modes::IndexOf<MonitorMode>() ==
+                static_cast<size_t>(Mode::kMonitor));
+  static_assert(Modes::IndexOf<ThresholdMode>() ==
+                static_cast<size_t>(Mode::kThreshold));
+  static_assert(Modes::IndexOf<AlarmMode>() ==
+                static_cast<size_t>(Mode::kAlarm));
+  static_assert(Modes::IndexOf<MorseReadoutMode>() ==
+                static_cast<size_t>(Mode::kMorseReadout));
   SetAlarmThreshold(alarm_threshold_);
-  PW_CHECK(pubsub_.Subscribe([this](Event event) { Update(event); }));
 }
 
-void StateManager::Update(Event event) {
+void StateManager::Update(const Event& event) {
+  PW_TRACE_SCOPE("StateManager::Update", "state");
+  SENSE_GPIO_MARK(kStateManagerUpdate);
   switch (static_cast<EventType>(event.index())) {
     case kButtonA:
-      if (std::get<ButtonA>(event).pressed()) {
-        state_.get().ButtonAPressed();
-      }
+      DispatchPress(std::get<ButtonA>(event));
       break;
     case kButtonB:
-      if (std::get<ButtonB>(event).pressed()) {
-        state_.get().ButtonBPressed();
-      }
+      DispatchPress(std::get<ButtonB>(event));
       break;
     case kButtonX:
-      if (std::get<ButtonX>(event).pressed()) {
-        state_.get().ButtonXPressed();
-      }
+      DispatchPress(std::get<ButtonX>(event));
       break;
     case kButtonY:
-      if (std::get<ButtonY>(event).pressed()) {
-        state_.get().ButtonYPressed();
-      }
+      DispatchPress(std::get<ButtonY>(event));
+      break;
+    case kButtonGesture:
+      DispatchGesture(std::get<ButtonGesture>(event));
       break;
     case kTimerExpired:
-      state_.get().OnTimerExpired(std::get<TimerExpired>(event));
+      state_.Dispatch(std::get<TimerExpired>(event));
       break;
     case kMorseCodeValue:
-      state_.get().OnMorseCodeValue(std::get<MorseCodeValue>(event));
+      state_.Dispatch(std::get<MorseCodeValue>(event));
       break;
     case kAmbientLightSample:
       led_.UpdateBrightnessFromAmbientLight(
@@ -82,9 +107,12 @@ void StateManager::Update(Event event) {
       HandleControlEvent(std::get<StateManagerControl>(event));
       break;
     case kAirQuality:
-      UpdateAirQuality(std::get<AirQuality>(event).score);
+      UpdateAirQuality(std::get<AirQuality>(event).score,
+                       std::get<AirQuality>(event).warming_up);
       break;
+    case kAirMeasurement:
     case kTimerRequest:
+    case kTimerCancel:
     case kMorseEncodeRequest:
     case kProximitySample:
     case kProximityStateChange:
@@ -93,11 +121,39 @@ void StateManager::Update(Event event) {
   }
 }
 
+void StateManager::DispatchGesture(const ButtonGesture& gesture) {
+  constexpr uint8_t kSteppingButtons =
+      ButtonGesture::kButtonA | ButtonGesture::kButtonB;
+  const bool is_press = gesture.kind == ButtonGesture::kPress;
+  const bool is_step = gesture.kind == ButtonGesture::kRepeat &&
+                       (gesture.buttons & kSteppingButtons) != 0;
+  if (!is_press && !is_step) {
+    return;
+  }
+  switch (gesture.buttons) {
+    case ButtonGesture::kButtonA:
+      DispatchPress(ButtonA(true, gesture.timestamp));
+      break;
+    case ButtonGesture::kButtonB:
+      DispatchPress(ButtonB(true, gesture.timestamp));
+      break;
+    case ButtonGesture::kButtonX:
+      DispatchPress(ButtonX(true, gesture.timestamp));
+      break;
+    case ButtonGesture::kButtonY:
+      DispatchPress(ButtonY(true, gesture.timestamp));
+      break;
+    default:
+      break;  // only single buttons map onto presses
+  }
+}
+
 void StateManager::DisplayThreshold() {
+  displayed_air_quality_.reset();
   led_.SetColor(AirSensor::GetLedValue(alarm_threshold_));
   PW_CHECK(pubsub_.Publish(TimerRequest{
       .token = kThresholdModeToken,
-      .timeout_s = kThresholdModeTimeout,
+      .timeout_ms = kThresholdModeTimeoutMs,
   }));
 }
 
@@ -115,6 +171,11 @@ void StateManager::DecrementThreshold() {
   DisplayThreshold();
 }
 
+void StateManager::RestoreAlarmThreshold(uint16_t alarm_threshold) {
+  alarm_threshold = std::min(alarm_threshold, kMaxThreshold);
+  SetAlarmThreshold(alarm_threshold - alarm_threshold % kThresholdIncrement);
+}
+
 void StateManager::SetAlarmThreshold(uint16_t alarm_threshold) {
   alarm_ = false;  // Reset the alarm whenever the threshold changes.
 
@@ -134,11 +195,14 @@ void StateManager::SetAlarmThreshold(uint16_t alarm_threshold) {
   BroadcastState();
 }
 
-void StateManager::UpdateAirQuality(uint16_t score) {
+void StateManager::UpdateAirQuality(uint16_t score, bool warming_up) {
   AddAndSmoothExponentially(air_quality_, score);
-  state_.get().OnLedValue(AirSensor::GetLedValue(*air_quality_));
-  if (alarm_silenced_) {
-    BroadcastState();
+  if (!IsWithinDeadband(displayed_air_quality_, *air_quality_)) {
+    displayed_air_quality_ = *air_quality_;
+    state_.Dispatch(AirSensor::GetLedValue(*air_quality_));
+  }
+  if (alarm_silenced_ || warming_up) {
+    BroadcastStateIfChanged();
     return;
   }
   switch (edge_detector_.Update(*air_quality_)) {
@@ -149,17 +213,17 @@ void StateManager::UpdateAirQuality(uint16_t score) {
       alarm_ = false;
       break;
     case Edge::kNone:
-      BroadcastState();
+      BroadcastStateIfChanged();
       return;
   }
   ResetMode();
-  BroadcastState();
+  BroadcastStateIfChanged();
 }
 
 void StateManager::RepeatAlarm() {
   PW_CHECK(pubsub_.Publish(TimerRequest{
       .token = kRepeatAlarmToken,
-      .timeout_s = kRepeatAlarmTimeout,
+      .timeout_ms = kRepeatAlarmTimeoutMs,
   }));
 }
 
@@ -169,7 +233,7 @@ void StateManager::SilenceAlarms() {
   std::ignore = edge_detector_.Update(AirSensor::kMaxScore);
   PW_CHECK(pubsub_.Publish(TimerRequest{
       .token = kSilenceAlarmToken,
-      .timeout_s = kSilenceAlarmTimeout,
+      .timeout_ms = kSilenceAlarmTimeoutMs,
   }));
   ResetMode();
   BroadcastState();
@@ -183,50 +247,103 @@ void StateManager::ResetMode() {
   }
 }
 
-void StateManager::StartMorseReadout(std::string_view msg) {
-  if (!pubsub_.Publish(MorseEncodeRequest{.message = msg, .repeat = 1u})) {
+void StateManager::StartMorseReadout(std::string_view msg, MorseRuns runs) {
+  pw::Result<Payload> text = morse_text_.Allocate(msg);
+  if (!text.ok() ||
+      !pubsub_.Publish(MorseEncodeRequest{
+          .payload = *text, .repeat = 1u, .runs = runs})) {
+    ResetMode();
+  }
+}
+
+void StateManager::StartMorseReadout() {
+  pw::Result<AirQualityReadouts::Readout> readout = air_quality_readouts_.Get(
+      air_quality(), morse_text_, [this](MorseCodeString& msg) {
+        FormatAirQuality(msg);
+      });
+  if (!readout.ok() ||
+      !pubsub_.Publish(MorseEncodeRequest{
+          .payload = readout->text, .repeat = 1u, .runs = readout->runs})) {
     ResetMode();
   }
 }
 
-const char* StateManager::AirQualityDescription(uint16_t score) {
+AirQualityRating StateManager::RateAirQuality(uint16_t score) {
   if (score > AirSensor::kMaxScore) {
-    return "INVALID";
+    return AirQualityRating::kInvalid;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kOrange)) {
-    return "TERRIBLE";
+    return AirQualityRating::kTerrible;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kYellow)) {
-    return "BAD";
+    return AirQualityRating::kBad;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kLightGreen)) {
-    return "MEDIOCRE";
+    return AirQualityRating::kMediocre;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kGreen)) {
-    return "OKAY";
+    return AirQualityRating::kOkay;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kBlueGreen)) {
-    return "GOOD";
+    return AirQualityRating::kGood;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kCyan)) {
-    return "VERY GOOD";
+    return AirQualityRating::kVeryGood;
   }
   if (score < static_cast<uint16_t>(AirSensor::Score::kLightBlue)) {
-    return "EXCELLENT";
+    return AirQualityRating::kExcellent;
   }
-  return "SUPERB";
+  return AirQualityRating::kSuperb;
+}
+
+const char* StateManager::AirQualityDescription(AirQualityRating rating) {
+  switch (rating) {
+    case AirQualityRating::kInvalid:
+      return "INVALID";
+    case AirQualityRating::kTerrible:
+      return "TERRIBLE";
+    case AirQualityRating::kBad:
+      return "BAD";
+    case AirQualityRating::kMediocre:
+      return "MEDIOCRE";
+    case AirQualityRating::kOkay:
+      return "OKAY";
+    case AirQualityRating::kGood:
+      return "GOOD";
+    case AirQualityRating::kVeryGood:
+      return "VERY GOOD";
+    case AirQualityRating::kExcellent:
+      return "EXCELLENT";
+    case AirQualityRating::kSuperb:
+      return "SUPERB";
+  }
+  return "INVALID";
 }
 
 void StateManager::FormatAirQuality(MorseCodeString& msg) {
   uint16_t score = air_quality();
   pw::Status status = pw::string::FormatOverwrite(
-      msg, "AQ %s %hu", AirQualityDescription(score), score);
+      msg,
+      "AQ %s %hu",
+      AirQualityDescription(RateAirQuality(score)),
+      score);
   PW_LOG_INFO("%s", msg.data());
   PW_CHECK_OK(status);
 }
 
-AmbientLightAdjustedLed::AmbientLightAdjustedLed(PolychromeLed& led)
-    : led_(led) {
+namespace {
+
+constexpr BrightnessCurve<AmbientLightAdjustedLed::kBrightnessLevels>
+    kBrightnessCurve(/*min_lux=*/40.f,
+                     /*max_lux=*/3000.f,
+                     AmbientLightAdjustedLed::kMinBrightness,
+                     AmbientLightAdjustedLed::kMaxBrightness);
+
+}  // namespace
+
+AmbientLightAdjustedLed::AmbientLightAdjustedLed(PolychromeLed& led,
+                                                 uint32_t fade_ms)
+    : led_(led), fade_ms_(fade_ms), ambient_brightness_(kBrightnessCurve) {
   led_.SetColor(0);
   led_.SetBrightness(kDefaultBrightness);
   led_.Enable();
@@ -235,43 +352,52 @@ AmbientLightAdjustedLed::AmbientLightAdjustedLed(PolychromeLed& led)
 
 void AmbientLightAdjustedLed::UpdateBrightnessFromAmbientLight(
     float ambient_light_sample_lux) {
-  AddAndSmoothExponentially(ambient_light_lux_, ambient_light_sample_lux);
+  const float lux = ambient_light_filter_.Update(ambient_light_sample_lux);
 
-  static constexpr float kMinLux = 40.f;
-  static constexpr float kMaxLux = 3000.f;
-  if (!ambient_light_lux_.has_value()) {
-    return;
+  // Setting the brightness ends any color fade, so only do so when the light
+  // has changed by a visible level.
+  if (std::optional<uint8_t> brightness = ambient_brightness_.Update(lux)) {
+    PW_LOG_DEBUG("Ambient light: mean_lux=%.1f, brightness=%hhu",
+                 lux,
+                 *brightness);
+    led_.SetBrightness(*brightness);
   }
-  uint8_t brightness;
-  if (*ambient_light_lux_ < kMinLux) {
-    brightness = kMinBrightness;
-  } else if (*ambient_light_lux_ > kMaxLux) {
-    brightness = kMaxBrightness;
-  } else {
-    constexpr float kBrightnessRange = kMaxBrightness - kMinBrightness;
-    brightness = static_cast<uint8_t>(
-        std::lround((*ambient_light_lux_ - kMinLux) / (kMaxLux - kMinLux) *
-                    kBrightnessRange) +
-        kMinBrightness);
-  }
-
-  PW_LOG_DEBUG("Ambient light: mean_lux=%.1f, brightness=%hhu",
-               *ambient_light_lux_,
-               brightness);
-  led_.SetBrightness(brightness);
 }
 
 void StateManager::LogStateChange(const char* old_state) const {
-  PW_LOG_INFO("StateManager: %s -> %s", old_state, state_.get().name());
+  PW_LOG_INFO("StateManager: %s -> %s", old_state, state_name());
 }
 
-void StateManager::BroadcastState() const {
-  std::ignore = pubsub_.Publish(SenseState{
+bool StateManager::IsWithinDeadband(std::optional<uint16_t> previous,
+                                    uint16_t current) const {
+  if (!previous.has_value()) {
+    return false;
+  }
+  const auto change = static_cast<uint16_t>(
+      *previous > current ? *previous - current : current - *previous);
+  return change <= score_deadband_;
+}
+
+void StateManager::BroadcastState() {
+  const SenseState state{
       .alarm = alarm_,
       .alarm_threshold = alarm_threshold_,
       .air_quality = air_quality(),
-      .air_quality_description = AirQualityDescription(air_quality()),
-  });
+      .air_quality_rating = RateAirQuality(air_quality()),
+  };
+  if (pubsub_.Publish(state)) {
+    broadcast_state_ = state;
+  }
+}
+
+void StateManager::BroadcastStateIfChanged() {
+  if (broadcast_state_.has_value() && broadcast_state_->alarm == alarm_ &&
+      broadcast_state_->alarm_threshold == alarm_threshold_ &&
+      broadcast_state_->air_quality_rating == RateAirQuality(air_quality()) &&
+      IsWithinDeadband(broadcast_state_->air_quality, air_quality())) {
+    return;
+  }
+  BroadcastState();
 }
 
 void StateManager::HandleControlEvent(StateManagerControl& event) {
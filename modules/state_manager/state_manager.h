@@ -19,10 +19,14 @@
 
 #include "modules/air_sensor/air_sensor.h"
 #include "modules/edge_detector/hysteresis_edge_detector.h"
+#include "modules/filters/filters.h"
+#include "modules/led/brightness_curve.h"
 #include "modules/led/polychrome_led.h"
 #include "modules/morse_code/encoder.h"
 #include "modules/pubsub/pubsub_events.h"
-#include "modules/state_manager/common_base_union.h"
+#include "modules/state_manager/morse_readout_cache.h"
+#include "modules/state_manager/state_machine.h"
+#include "modules/state_manager/transition_metrics.h"
 #include "pw_string/string.h"
 
 namespace sense {
@@ -34,10 +38,15 @@ class AmbientLightAdjustedLed {
   static constexpr uint8_t kDefaultBrightness = 160;
   static constexpr uint8_t kMaxBrightness = 255;
 
-  AmbientLightAdjustedLed(PolychromeLed& led);
+  /// Visibly distinct brightnesses between the minimum and maximum.
+  static constexpr size_t kBrightnessLevels = 16;
+
+  /// Color changes fade over `fade_ms`.
+  AmbientLightAdjustedLed(PolychromeLed& led, uint32_t fade_ms);
 
   void SetColor(const LedValue& color) {
-    led_.SetColor(color.r(), color.g(), color.b());
+    led_.FadeTo(PolychromeLed::ColorToHex(color.r(), color.g(), color.b()),
+                fade_ms_);
   }
 
   void SetOnOff(bool turn_on) { led_.SetOnOff(turn_on); }
@@ -46,10 +55,10 @@ class AmbientLightAdjustedLed {
   void UpdateBrightnessFromAmbientLight(float ambient_light_sample_lux);
 
  private:
-  void UpdateAverageAmbientLight(float ambient_light_sample_lux);
-
   PolychromeLed& led_;
-  std::optional<float> ambient_light_lux_;
+  const uint32_t fade_ms_;
+  OnePoleLowPass<float, 2> ambient_light_filter_;
+  AmbientBrightness<kBrightnessLevels> ambient_brightness_;
 };
 
 // Manages state for the "production" Sense app.
@@ -62,15 +71,15 @@ class StateManager {
 
   static constexpr TimerToken kRepeatAlarmToken =
       PW_TOKENIZE_STRING("repeat alarm");
-  static constexpr uint16_t kRepeatAlarmTimeout = 1;
+  static constexpr uint32_t kRepeatAlarmTimeoutMs = 1000;
 
   static constexpr TimerToken kSilenceAlarmToken =
       PW_TOKENIZE_STRING("re-enable alarm");
-  static constexpr uint16_t kSilenceAlarmTimeout = 60;
+  static constexpr uint32_t kSilenceAlarmTimeoutMs = 60'000;
 
   static constexpr TimerToken kThresholdModeToken =
       PW_TOKENIZE_STRING("exit threshold mode");
-  static constexpr uint16_t kThresholdModeTimeout = 3;
+  static constexpr uint32_t kThresholdModeTimeoutMs = 3000;
 
   static constexpr uint16_t kDefaultThreshold =
       static_cast<uint16_t>(AirSensor::Score::kYellow);
@@ -80,52 +89,112 @@ class StateManager {
   static constexpr uint16_t kMaxThreshold =
       static_cast<uint16_t>(AirSensor::Score::kCyan);
 
-  StateManager(PubSub& pubsub, PolychromeLed& led);
+  /// Largest change in the smoothed air quality score that is not shown on
+  /// the LED or broadcast as a new `SenseState`.
+  static constexpr uint16_t kDefaultScoreDeadband = 2;
+
+  /// How long the LED takes to fade to a new color, in milliseconds.
+  static constexpr uint32_t kDefaultColorFadeMs = 500;
+
+  /// Modes of the state machine.
+  enum class Mode : uint8_t {
+    kMonitor = 0,
+    kThreshold = 1,
+    kAlarm = 2,
+    kMorseReadout = 3,
+  };
+
+  StateManager(PubSub& pubsub,
+               PolychromeLed& led,
+               uint16_t score_deadband = kDefaultScoreDeadband,
+               uint32_t color_fade_ms = kDefaultColorFadeMs);
+
+  /// Does not subscribe to `pubsub`; a static subscriber list must call
+  /// `Update` with every event instead.
+  StateManager(PubSub& pubsub,
+               PolychromeLed& led,
+               StaticallySubscribed,
+               uint16_t score_deadband = kDefaultScoreDeadband,
+               uint32_t color_fade_ms = kDefaultColorFadeMs);
 
   StateManager(const StateManager&) = delete;
   StateManager& operator=(const StateManager&) = delete;
 
-  static const char* AirQualityDescription(uint16_t score);
+  static AirQualityRating RateAirQuality(uint16_t score);
+
+  /// Returns the text shown on the device for a rating.
+  static const char* AirQualityDescription(AirQualityRating rating);
+
+  /// Responds to a PubSub event.
+  void Update(const Event& event);
+
+  /// Replaces the alarm threshold, such as with one saved before a reboot.
+  /// Values are clamped to the thresholds the buttons can select. Must be
+  /// called before events are dispatched or from the PubSub thread.
+  void RestoreAlarmThreshold(uint16_t alarm_threshold);
+
+  /// Transitions between modes, which are identified by their `Mode` value.
+  const TransitionMetrics& transition_metrics() const {
+    return transition_metrics_;
+  }
 
  private:
   static constexpr size_t kMaxMorseCodeStringLen = 16;
   static_assert(kMaxMorseCodeStringLen <= Encoder::kMaxMsgLen);
   using MorseCodeString = ::pw::InlineString<kMaxMorseCodeStringLen>;
 
-  // Represents a state in the Sense app state machine.
+  /// Readouts whose text may be in flight at once.
+  static constexpr size_t kMaxPendingMorseReadouts = 2;
+
+  /// Air quality readouts kept compiled, keyed by score. Alarms repeat the
+  /// readout while the score is steady, so these are usually replayed.
+  static constexpr size_t kMorseReadoutCacheSize = 4;
+  using AirQualityReadouts =
+      MorseReadoutCache<kMaxMorseCodeStringLen, kMorseReadoutCacheSize>;
+
+  /// Blinked when threshold mode times out. Compiled at build time.
+  static constexpr char kThresholdTimeoutMsg[] = "TTT";
+  static constexpr auto kThresholdTimeoutMorse =
+      CompileMorse(kThresholdTimeoutMsg);
+
+  // Default behavior shared by the states of the Sense app state machine.
+  //
+  // States are resolved at compile time by the `StateMachine`, so none of
+  // these are virtual. A state that handles an event differently declares its
+  // own `Handle` overload, along with `using State::Handle` to keep the
+  // defaults for other events.
   class State {
    public:
     State(StateManager& manager, const char* name)
         : manager_(manager), name_(name) {}
 
-    virtual ~State() = default;
-
     // Name of the state for logging.
     const char* name() const { return name_; }
 
+    /// Called once the state has become current.
+    void OnEnter() {}
+
     /// Button A enters `ThresholdMode` by default.
-    virtual void ButtonAPressed() { manager_.SetState<ThresholdMode>(); }
+    void Handle(const ButtonA&) { manager_.SetState<ThresholdMode>(); }
 
     /// Button B enters `ThresholdMode` by default.
-    virtual void ButtonBPressed() { manager_.SetState<ThresholdMode>(); }
+    void Handle(const ButtonB&) { manager_.SetState<ThresholdMode>(); }
 
     /// Button X enters resets the mode to either `MonitorMode` or `AlarmMode`
     /// by default, depending on the current air quality..
-    virtual void ButtonXPressed() { manager_.ResetMode(); }
+    void Handle(const ButtonX&) { manager_.ResetMode(); }
 
     /// Button Y enters `MorseReadoutMode` by default.
-    virtual void ButtonYPressed() { manager().SetState<MorseReadoutMode>(); }
+    void Handle(const ButtonY&) { manager().SetState<MorseReadoutMode>(); }
 
     // Update the LED color by default.
-    virtual void OnLedValue(const LedValue& value) {
-      manager().led_.SetColor(value);
-    }
+    void Handle(const LedValue& value) { manager().led_.SetColor(value); }
 
     // Ignore Morse code edges by default.
-    virtual void OnMorseCodeValue(const MorseCodeValue&) {}
+    void Handle(const MorseCodeValue&) {}
 
     // Handles re-enabling alarms that were previously silenced.
-    virtual void OnTimerExpired(const TimerExpired& timer) {
+    void Handle(const TimerExpired& timer) {
       if (timer.token == kSilenceAlarmToken) {
         manager().alarm_silenced_ = false;
       }
@@ -157,26 +226,29 @@ class StateManager {
   /// button being pressed.
   class ThresholdMode final : public State {
    public:
-    ThresholdMode(StateManager& manager) : State(manager, "ThresholdMode") {
-      manager.DisplayThreshold();
-    }
+    ThresholdMode(StateManager& manager) : State(manager, "ThresholdMode") {}
+
+    void OnEnter() { manager().DisplayThreshold(); }
 
-    void ButtonAPressed() override { manager().IncrementThreshold(); }
+    using State::Handle;
 
-    void ButtonBPressed() override { manager().DecrementThreshold(); }
+    void Handle(const ButtonA&) { manager().IncrementThreshold(); }
 
-    void ButtonXPressed() override { manager().ResetMode(); }
+    void Handle(const ButtonB&) { manager().DecrementThreshold(); }
 
-    void ButtonYPressed() override { manager().ResetMode(); }
+    void Handle(const ButtonX&) { manager().ResetMode(); }
 
-    void OnLedValue(const LedValue&) override {}
+    void Handle(const ButtonY&) { manager().ResetMode(); }
 
-    void OnTimerExpired(const TimerExpired& timer) override {
+    void Handle(const LedValue&) {}
+
+    void Handle(const TimerExpired& timer) {
       if (timer.token == kThresholdModeToken) {
         // Blink three times before returning to the default mode.
-        manager().SetState<MorseReadoutMode>("TTT");
+        manager().SetState<MorseReadoutMode>(kThresholdTimeoutMsg,
+                                             kThresholdTimeoutMorse.runs());
       } else {
-        State::OnTimerExpired(timer);
+        State::Handle(timer);
       }
     }
   };
@@ -188,36 +260,33 @@ class StateManager {
   ///  * Button Y does nothing.
   class AlarmMode final : public State {
    public:
-    AlarmMode(StateManager& manager) : State(manager, "AlarmMode") {
-      manager.FormatAirQuality(msg_);
-      manager.StartMorseReadout(msg_);
-    }
+    AlarmMode(StateManager& manager) : State(manager, "AlarmMode") {}
 
     // Since morse code leaves the LED off, turn it back on.
     ~AlarmMode() { manager().led_.SetOnOff(true); }
 
-    void ButtonXPressed() override { manager().SilenceAlarms(); }
+    void OnEnter() { manager().StartMorseReadout(); }
+
+    using State::Handle;
 
-    void ButtonYPressed() override {}
+    void Handle(const ButtonX&) { manager().SilenceAlarms(); }
 
-    void OnMorseCodeValue(const MorseCodeValue& value) override {
+    void Handle(const ButtonY&) {}
+
+    void Handle(const MorseCodeValue& value) {
       manager().led_.SetOnOff(value.turn_on);
       if (value.message_finished) {
         manager().RepeatAlarm();
       }
     }
 
-    void OnTimerExpired(const TimerExpired& timer) override {
+    void Handle(const TimerExpired& timer) {
       if (timer.token == kRepeatAlarmToken) {
-        manager().FormatAirQuality(msg_);
-        manager().StartMorseReadout(msg_);
+        manager().StartMorseReadout();
       } else {
-        State::OnTimerExpired(timer);
+        State::Handle(timer);
       }
     }
-
-   private:
-    MorseCodeString msg_;
   };
 
   /// Mode that displays the current air quality in Morse code.
@@ -226,24 +295,32 @@ class StateManager {
   ///  * Button Y restarts the air quality display.
   class MorseReadoutMode final : public State {
    public:
+    /// Reads out the current air quality.
     MorseReadoutMode(StateManager& manager)
-        : State(manager, "MorseReadoutMode") {
-      manager.FormatAirQuality(msg_);
-      manager.StartMorseReadout(msg_);
-    }
+        : State(manager, "MorseReadoutMode") {}
 
-    MorseReadoutMode(StateManager& manager, std::string_view msg)
-        : State(manager, "MorseReadoutMode"), msg_(msg) {
-      manager.StartMorseReadout(msg_);
-    }
+    MorseReadoutMode(StateManager& manager,
+                     std::string_view msg,
+                     MorseRuns runs = {})
+        : State(manager, "MorseReadoutMode"), msg_(msg), runs_(runs) {}
 
     // Since morse code leaves the LED off, turn it back on.
     ~MorseReadoutMode() { manager().led_.SetOnOff(true); }
 
+    void OnEnter() {
+      if (msg_.empty()) {
+        manager().StartMorseReadout();
+      } else {
+        manager().StartMorseReadout(msg_, runs_);
+      }
+    }
+
+    using State::Handle;
+
     // Keep the current color.
-    void OnLedValue(const LedValue&) override {}
+    void Handle(const LedValue&) {}
 
-    void OnMorseCodeValue(const MorseCodeValue& value) override {
+    void Handle(const MorseCodeValue& value) {
       manager().led_.SetOnOff(value.turn_on);
       if (value.message_finished) {
         manager().ResetMode();
@@ -252,19 +329,45 @@ class StateManager {
 
    private:
     MorseCodeString msg_;
+    MorseRuns runs_;
   };
 
-  /// Responds to a PubSub event.
-  void Update(Event event);
+  using Modes =
+      StateMachine<MonitorMode, ThresholdMode, AlarmMode, MorseReadoutMode>;
 
   template <typename StateType, typename... Args>
   void SetState(Args&&... args) {
-    const char* old_state = state_.get().name();
-    state_.emplace<StateType>(*this, std::forward<Args>(args)...);
+    const char* old_state = state_name();
+    displayed_air_quality_.reset();
+    // Recorded before entering the state, which may itself transition.
+    transition_metrics_.RecordTransition(
+        Modes::IndexOf<StateType>(),
+        pw::chrono::SystemClock::now(),
+        dispatched_event_published_at_);
+    state_.Transition<StateType>(*this, std::forward<Args>(args)...);
     BroadcastState();
     LogStateChange(old_state);
   }
 
+  const char* state_name() const {
+    return state_.Visit([](const State& state) { return state.name(); });
+  }
+
+  /// Passes a button press to the current state.
+  template <typename Button>
+  void DispatchPress(const Button& button) {
+    if (button.pressed()) {
+      dispatched_event_published_at_ = button.timestamp();
+      state_.Dispatch(button);
+      dispatched_event_published_at_ = {};
+    }
+  }
+
+  /// Passes a gesture to the current state as a press of its button. Repeats
+  /// of A and B act as further presses, so holding them steps the threshold.
+  /// Long presses and chords are not used yet.
+  void DispatchGesture(const ButtonGesture& gesture);
+
   /// Sets the state to `MonitorMode` or `AlarmMode`, depending on the current
   /// air quality.
   void ResetMode();
@@ -285,18 +388,20 @@ class StateManager {
   void SetAlarmThreshold(uint16_t alarm_threshold);
 
   /// Incorporates a new air quality reading from the air sensor, changing the
-  /// LED color and triggering alarms as appropriate.
-  void UpdateAirQuality(uint16_t score);
+  /// LED color and triggering alarms as appropriate. Readings taken while the
+  /// sensor warms up only change the LED color.
+  void UpdateAirQuality(uint16_t score, bool warming_up);
 
   /// Send a timer request to repeat an alarm.
   void RepeatAlarm();
 
   /// Sends a request to the Morse encoder to send `OnMorseCodeValue` events for
-  /// the given message.
-  void StartMorseReadout(std::string_view msg);
+  /// the given message, using its precompiled `runs` if provided.
+  void StartMorseReadout(std::string_view msg, MorseRuns runs = {});
 
   /// Sends a request to the Morse encoder to send `OnMorseCodeValue` events for
-  /// a description of the current air quality.
+  /// a description of the current air quality, replaying a cached readout of
+  /// the same score if there is one.
   void StartMorseReadout();
 
   /// Sets the given string to a  representation of the current air quality.
@@ -304,7 +409,16 @@ class StateManager {
 
   void LogStateChange(const char* old_state) const;
 
-  void BroadcastState() const;
+  /// Returns whether `current` is within the score deadband of `previous`.
+  bool IsWithinDeadband(std::optional<uint16_t> previous,
+                        uint16_t current) const;
+
+  void BroadcastState();
+
+  /// Broadcasts the state unless it only differs from the last broadcast by a
+  /// score change within the deadband.
+  void BroadcastStateIfChanged();
+
   void HandleControlEvent(StateManagerControl& event);
 
   constexpr uint16_t air_quality() const {
@@ -312,6 +426,12 @@ class StateManager {
   }
 
   std::optional<uint16_t> air_quality_;
+  const uint16_t score_deadband_;
+
+  // Score the LED color reflects, if it reflects one. Cleared when anything
+  // else changes the color, so that the next reading is shown.
+  std::optional<uint16_t> displayed_air_quality_;
+  std::optional<SenseState> broadcast_state_;
 
   bool alarm_ = false;
   bool alarm_silenced_ = false;
@@ -321,12 +441,18 @@ class StateManager {
   PubSub& pubsub_;
   AmbientLightAdjustedLed led_;
 
-  CommonBaseUnion<State,
-                  MonitorMode,
-                  ThresholdMode,
-                  AlarmMode,
-                  MorseReadoutMode>
-      state_;
+  // Readout text is copied here, since the state that formatted it may be gone
+  // by the time the request is delivered. Cached readouts hold a block each.
+  PayloadPoolBuffer<kMaxMorseCodeStringLen,
+                    kMorseReadoutCacheSize + kMaxPendingMorseReadouts>
+      morse_text_;
+  AirQualityReadouts air_quality_readouts_;
+
+  // When the event being dispatched was published, if it says.
+  pw::chrono::SystemClock::time_point dispatched_event_published_at_;
+  TransitionMetrics transition_metrics_;
+
+  Modes state_;
 };
 
 }  // namespace sense
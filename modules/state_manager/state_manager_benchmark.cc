@@ -0,0 +1,249 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Host-side StateManager and Morse Encoder microbenchmarks.
+//
+// The StateManager cases feed long synthetic event streams through a
+// `GenericPubSubBuffer` drained by a threaded `TestWorker`, and report the
+// cost per event along with heap allocations. The LED and Encoder cases time
+// the work those events trigger. Results are printed as one JSON object per
+// line so they can be collected and compared across commits.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "modules/led/polychrome_led_fake.h"
+#include "modules/morse_code/encoder.h"
+#include "modules/morse_code/timeline.h"
+#include "modules/pubsub/pubsub.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/state_manager/state_manager.h"
+#include "modules/worker/test_worker.h"
+#include "pw_assert/check.h"
+
+namespace {
+
+std::atomic<size_t> allocations = 0;
+
+}  // namespace
+
+// Counts heap allocations made anywhere in the benchmark.
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  PW_CHECK_NOTNULL(ptr);
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace sense {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kEvents = 20'000;
+constexpr size_t kIterations = 20'000;
+
+double NsPer(Clock::duration elapsed, size_t count) {
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                 .count()) /
+         static_cast<double>(count);
+}
+
+void Print(const char* benchmark,
+           const char* name,
+           size_t count,
+           Clock::duration elapsed,
+           size_t allocated) {
+  std::printf(
+      "{\"benchmark\": \"%s\", \"case\": \"%s\", \"count\": %zu, "
+      "\"ns_per_op\": %.1f, \"allocations_per_op\": %.3f}\n",
+      benchmark,
+      name,
+      count,
+      NsPer(elapsed, count),
+      static_cast<double>(allocated) / static_cast<double>(count));
+}
+
+// Event `i` of each synthetic stream.
+using Stream = Event (*)(size_t i);
+
+Event AirQualityStream(size_t i) {
+  // Sweeps the score across every color and through the alarm threshold.
+  return AirQuality{.score = static_cast<uint16_t>((i * 37) % 1024)};
+}
+
+Event ButtonStream(size_t i) {
+  const bool pressed = i % 2 == 0;
+  switch ((i / 2) % 4) {
+    case 0:
+      return ButtonA(pressed, pw::chrono::SystemClock::now());
+    case 1:
+      return ButtonB(pressed, pw::chrono::SystemClock::now());
+    case 2:
+      return ButtonX(pressed, pw::chrono::SystemClock::now());
+    default:
+      return ButtonY(pressed, pw::chrono::SystemClock::now());
+  }
+}
+
+Event MorseCodeStream(size_t i) {
+  return MorseCodeValue{.turn_on = i % 2 == 0,
+                        .message_finished = i % 16 == 15};
+}
+
+Event MixedStream(size_t i) {
+  switch (i % 4) {
+    case 0:
+      return AirQualityStream(i / 4);
+    case 1:
+      return ButtonStream(i / 4);
+    default:
+      return MorseCodeStream(i / 2);
+  }
+}
+
+void RunStateManager(const char* name, Stream stream) {
+  TestWorker<> worker;
+  GenericPubSubBuffer<Event, 20, 4> pubsub(worker);
+  PolychromeLedFake led;
+  StateManager state_manager(
+      pubsub, led, StateManager::kDefaultScoreDeadband, /*color_fade_ms=*/0);
+
+  // Subscribed after the StateManager, so it sees each input last.
+  std::atomic<size_t> handled = 0;
+  PW_CHECK((pubsub.SubscribeToAny<AirQuality,
+                                  ButtonA,
+                                  ButtonB,
+                                  ButtonX,
+                                  ButtonY,
+                                  MorseCodeValue>(
+      [&handled](const Event&) { handled.fetch_add(1); })));
+
+  const size_t allocated_before = allocations.load();
+  const auto start = Clock::now();
+  for (size_t i = 0; i < kEvents; ++i) {
+    const Event event = stream(i);
+    while (!pubsub.Publish(event)) {
+      std::this_thread::yield();
+    }
+  }
+  while (handled.load() < kEvents) {
+    std::this_thread::yield();
+  }
+  const auto elapsed = Clock::now() - start;
+  const size_t allocated = allocations.load() - allocated_before;
+  worker.Stop();
+
+  Print("state_manager", name, kEvents, elapsed, allocated);
+}
+
+void RunFakeLed() {
+  PolychromeLedFake led;
+  led.Enable();
+  led.TurnOn();
+
+  const size_t allocated_before = allocations.load();
+  const auto start = Clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    led.SetColor(static_cast<uint32_t>(i * 0x010203) & 0xFFFFFF);
+    led.SetBrightness(static_cast<uint8_t>(i));
+  }
+  const auto elapsed = Clock::now() - start;
+  Print("fake_led",
+        "set_color_and_brightness",
+        kIterations,
+        elapsed,
+        allocations.load() - allocated_before);
+}
+
+std::string Message(size_t length) {
+  constexpr std::string_view kText = "SOS AQ GOOD 812 ";
+  std::string msg;
+  while (msg.size() < length) {
+    msg += kText;
+  }
+  msg.resize(length);
+  return msg;
+}
+
+void RunTimeline(size_t length) {
+  const std::string msg = Message(length);
+  MorseTimeline<MaxMorseRuns(Encoder::kMaxMsgLen)> timeline;
+
+  const size_t allocated_before = allocations.load();
+  const auto start = Clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    timeline.Compile(msg);
+  }
+  const auto elapsed = Clock::now() - start;
+
+  std::array<char, 32> name;
+  std::snprintf(name.data(), name.size(), "compile_%zu_chars", length);
+  Print("morse_timeline",
+        name.data(),
+        kIterations,
+        elapsed,
+        allocations.load() - allocated_before);
+}
+
+void RunEncoder(size_t length) {
+  const std::string msg = Message(length);
+  Encoder encoder;
+  encoder.Init([](bool, const Encoder::State&) {});
+
+  // Each call compiles the message and arms the first toggle. The interval is
+  // long enough that no toggle fires while the benchmark runs.
+  const size_t allocated_before = allocations.load();
+  const auto start = Clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    PW_CHECK_OK(encoder.Encode(msg, 1, /*interval_ms=*/60'000));
+  }
+  const auto elapsed = Clock::now() - start;
+
+  std::array<char, 32> name;
+  std::snprintf(name.data(), name.size(), "encode_%zu_chars", length);
+  Print("encoder",
+        name.data(),
+        kIterations,
+        elapsed,
+        allocations.load() - allocated_before);
+}
+
+constexpr size_t kMessageLengths[] = {8, 64, Encoder::kMaxMsgLen - 1};
+
+}  // namespace
+}  // namespace sense
+
+int main() {
+  sense::RunStateManager("air_quality", sense::AirQualityStream);
+  sense::RunStateManager("buttons", sense::ButtonStream);
+  sense::RunStateManager("morse_code", sense::MorseCodeStream);
+  sense::RunStateManager("mixed", sense::MixedStream);
+  sense::RunFakeLed();
+  for (size_t length : sense::kMessageLengths) {
+    sense::RunTimeline(length);
+    sense::RunEncoder(length);
+  }
+  return 0;
+}
@@ -15,6 +15,7 @@
 #include "modules/state_manager/state_manager.h"
 
 #include <array>
+#include <string>
 
 #include "modules/led/polychrome_led_fake.h"
 #include "modules/pubsub/pubsub.h"
@@ -33,7 +34,11 @@ class StateManagerTest : public ::testing::Test {
   StateManagerTest()
       : ::testing::Test(),
         pubsub_(worker_),
-        state_manager_(pubsub_, led_),
+        // The fake PWM never invokes callbacks, so change colors instantly.
+        state_manager_(pubsub_,
+                       led_,
+                       StateManager::kDefaultScoreDeadband,
+                       /*color_fade_ms=*/0),
         event_(TimerExpired{.token = 0}) {}
 
   void SetUp() override {
@@ -83,6 +88,28 @@ TEST_F(StateManagerTest, UpdateAirQuality) {
   EXPECT_EQ(led_.blue(), GetExpectedBlue());
 }
 
+TEST_F(StateManagerTest, SmallScoreChangesAreNotShown) {
+  ASSERT_TRUE(pubsub_.SubscribeTo<SenseState>(
+      [this](SenseState) { state_update_notification_.release(); }));
+
+  ASSERT_TRUE(pubsub_.Publish(AirQuality{.score = 800}));
+  led_.Await();
+  state_update_notification_.acquire();
+
+  // The smoothed score only moves by 1, which is within the deadband.
+  ASSERT_TRUE(pubsub_.Publish(AirQuality{.score = 804}));
+  EXPECT_FALSE(led_.TryAwaitFor(100ms));
+  EXPECT_FALSE(state_update_notification_.try_acquire());
+
+  ASSERT_TRUE(pubsub_.Publish(AirQuality{.score = 900}));
+  led_.Await();
+  state_update_notification_.acquire();
+  SetExpectedColor(825);
+  EXPECT_EQ(led_.red(), GetExpectedRed());
+  EXPECT_EQ(led_.green(), GetExpectedGreen());
+  EXPECT_EQ(led_.blue(), GetExpectedBlue());
+}
+
 TEST_F(StateManagerTest, MorseReadout) {
   ASSERT_TRUE(pubsub_.SubscribeTo<SenseState>(
       [this](SenseState) { state_update_notification_.release(); }));
@@ -128,6 +155,61 @@ TEST_F(StateManagerTest, UpdateAirQualityAndTriggerAlarm) {
   EXPECT_FALSE(led_.is_on());
 }
 
+TEST_F(StateManagerTest, RepeatedAlarmReplaysCompiledReadout) {
+  std::array<std::string, 2> texts;
+  std::array<size_t, 2> runs = {};
+  size_t requests = 0;
+  ASSERT_TRUE(pubsub_.SubscribeTo<MorseEncodeRequest>(
+      [&](const MorseEncodeRequest& request) {
+        if (requests < texts.size()) {
+          texts[requests] = request.payload.str();
+          runs[requests] = request.runs.size();
+          ++requests;
+        }
+        morse_encode_request_.release();
+      }));
+
+  ASSERT_TRUE(pubsub_.Publish(AirQuality{.score = 100}));
+  morse_encode_request_.acquire();
+  ASSERT_TRUE(pubsub_.Publish(
+      TimerExpired{.token = StateManager::kRepeatAlarmToken}));
+  morse_encode_request_.acquire();
+
+  ASSERT_EQ(requests, 2u);
+  EXPECT_EQ(texts[0], "AQ TERRIBLE 100");
+  EXPECT_EQ(texts[1], texts[0]);
+  EXPECT_GT(runs[0], 0u);
+  EXPECT_EQ(runs[1], runs[0]);
+}
+
+TEST_F(StateManagerTest, UpdateAirQualityWhileWarmingUpDoesNotAlarm) {
+  ASSERT_TRUE(pubsub_.SubscribeTo<MorseEncodeRequest>(
+      [this](MorseEncodeRequest) { morse_encode_request_.release(); }));
+  ASSERT_TRUE(pubsub_.SubscribeTo<SenseState>(
+      [this](SenseState) { state_update_notification_.release(); }));
+
+  uint16_t air_quality = 100;
+  ASSERT_TRUE(pubsub_.Publish(
+      AirQuality{.score = air_quality, .warming_up = true}));
+  led_.Await();
+  state_update_notification_.acquire();
+
+  // The LED shows the reading, but no alarm is raised.
+  SetExpectedColor(air_quality);
+  EXPECT_EQ(led_.red(), GetExpectedRed());
+  EXPECT_EQ(led_.green(), GetExpectedGreen());
+  EXPECT_EQ(led_.blue(), GetExpectedBlue());
+  EXPECT_FALSE(morse_encode_request_.try_acquire());
+
+  // Once warmed up, the same reading triggers the alarm.
+  ASSERT_TRUE(pubsub_.Publish(AirQuality{.score = air_quality}));
+  morse_encode_request_.acquire();
+  ASSERT_TRUE(pubsub_.Publish(
+      MorseCodeValue{.turn_on = false, .message_finished = false}));
+  led_.Await();
+  EXPECT_FALSE(led_.is_on());
+}
+
 TEST_F(StateManagerTest, UpdateAirQualityAndDisableAlarm) {
   ASSERT_TRUE(pubsub_.SubscribeTo<MorseEncodeRequest>(
       [this](MorseEncodeRequest) { morse_encode_request_.release(); }));
@@ -198,6 +280,50 @@ TEST_F(StateManagerTest, SilenceAlarm) {
   EXPECT_TRUE(led_.is_on());
 }
 
+TEST_F(StateManagerTest, RecordsTransitionLatencyOfButtonPresses) {
+  ASSERT_TRUE(pubsub_.SubscribeTo<SenseState>(
+      [this](SenseState) { state_update_notification_.release(); }));
+
+  ASSERT_TRUE(pubsub_.Publish(ButtonB(true, pw::chrono::SystemClock::now())));
+  state_update_notification_.acquire();
+
+  const TransitionMetrics& metrics = state_manager_.transition_metrics();
+  EXPECT_EQ(metrics.current_state(),
+            static_cast<size_t>(StateManager::Mode::kThreshold));
+  EXPECT_EQ(metrics.latency_samples(), 1u);
+
+  std::array<TransitionMetrics::Record, 2> records;
+  uint32_t first = 0;
+  ASSERT_EQ(metrics.Read(records, first), 1u);
+  EXPECT_EQ(records[0].from,
+            static_cast<uint8_t>(StateManager::Mode::kMonitor));
+  EXPECT_EQ(records[0].to,
+            static_cast<uint8_t>(StateManager::Mode::kThreshold));
+  EXPECT_NE(records[0].latency_us, TransitionMetrics::kUnknownLatency);
+}
+
+TEST_F(StateManagerTest, RestoreAlarmThreshold) {
+  uint16_t threshold = 0;
+  ASSERT_TRUE(pubsub_.SubscribeTo<SenseState>([&](SenseState state) {
+    threshold = state.alarm_threshold;
+    state_update_notification_.release();
+  }));
+
+  state_manager_.RestoreAlarmThreshold(
+      static_cast<uint16_t>(AirSensor::Score::kGreen));
+  state_update_notification_.acquire();
+  EXPECT_EQ(threshold, static_cast<uint16_t>(AirSensor::Score::kGreen));
+
+  // Rounded down to a threshold the buttons can select.
+  state_manager_.RestoreAlarmThreshold(600);
+  state_update_notification_.acquire();
+  EXPECT_EQ(threshold, static_cast<uint16_t>(AirSensor::Score::kGreen));
+
+  state_manager_.RestoreAlarmThreshold(AirSensor::kMaxScore);
+  state_update_notification_.acquire();
+  EXPECT_EQ(threshold, StateManager::kMaxThreshold);
+}
+
 TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   ASSERT_TRUE(pubsub_.SubscribeTo<TimerRequest>([this](TimerRequest request) {
     event_ = request;
@@ -218,7 +344,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   TimerRequest request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonA(true)));
   led_.Await();
@@ -229,7 +355,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonA(true)));
   led_.Await();
@@ -240,7 +366,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonA(true)));
   led_.Await();
@@ -251,7 +377,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonA(true)));
   led_.Await();
@@ -262,7 +388,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   // At max threshold; cannot increase further.
   ASSERT_TRUE(pubsub_.Publish(ButtonA(true)));
@@ -273,7 +399,7 @@ TEST_F(StateManagerTest, IncrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   // Now time out of the threshold mode.
   ASSERT_TRUE(pubsub_.Publish(
@@ -301,7 +427,7 @@ TEST_F(StateManagerTest, DecrementThresholdAndTimeout) {
   timer_request_.acquire();
   TimerRequest request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonB(true)));
   led_.Await();
@@ -312,7 +438,7 @@ TEST_F(StateManagerTest, DecrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   ASSERT_TRUE(pubsub_.Publish(ButtonB(true)));
   led_.Await();
@@ -323,7 +449,7 @@ TEST_F(StateManagerTest, DecrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   // At min threshold; cannot decrease further.
   ASSERT_TRUE(pubsub_.Publish(ButtonB(true)));
@@ -334,7 +460,7 @@ TEST_F(StateManagerTest, DecrementThresholdAndTimeout) {
   timer_request_.acquire();
   request = std::get<TimerRequest>(event_);
   EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
-  EXPECT_EQ(request.timeout_s, StateManager::kThresholdModeTimeout);
+  EXPECT_EQ(request.timeout_ms, StateManager::kThresholdModeTimeoutMs);
 
   // Now time out of the threshold mode.
   ASSERT_TRUE(pubsub_.Publish(
@@ -343,6 +469,46 @@ TEST_F(StateManagerTest, DecrementThresholdAndTimeout) {
   state_update_notification_.acquire();
 }
 
+TEST_F(StateManagerTest, GesturesStepThreshold) {
+  ASSERT_TRUE(pubsub_.SubscribeTo<TimerRequest>([this](TimerRequest request) {
+    event_ = request;
+    timer_request_.release();
+  }));
+
+  ASSERT_TRUE(pubsub_.Publish(ButtonGesture{
+      .kind = ButtonGesture::kPress,
+      .buttons = ButtonGesture::kButtonA,
+  }));
+  led_.Await();
+  SetExpectedColor(AirSensor::Score::kYellow);
+  EXPECT_EQ(led_.red(), GetExpectedRed());
+  EXPECT_EQ(led_.green(), GetExpectedGreen());
+  EXPECT_EQ(led_.blue(), GetExpectedBlue());
+  timer_request_.acquire();
+
+  // Long presses and chords do not step the threshold; repeats do.
+  ASSERT_TRUE(pubsub_.Publish(ButtonGesture{
+      .kind = ButtonGesture::kLongPress,
+      .buttons = ButtonGesture::kButtonA,
+  }));
+  ASSERT_TRUE(pubsub_.Publish(ButtonGesture{
+      .kind = ButtonGesture::kChord,
+      .buttons = ButtonGesture::kButtonA | ButtonGesture::kButtonB,
+  }));
+  ASSERT_TRUE(pubsub_.Publish(ButtonGesture{
+      .kind = ButtonGesture::kRepeat,
+      .buttons = ButtonGesture::kButtonA,
+  }));
+  led_.Await();
+  SetExpectedColor(AirSensor::Score::kLightGreen);
+  EXPECT_EQ(led_.red(), GetExpectedRed());
+  EXPECT_EQ(led_.green(), GetExpectedGreen());
+  EXPECT_EQ(led_.blue(), GetExpectedBlue());
+  timer_request_.acquire();
+  TimerRequest request = std::get<TimerRequest>(event_);
+  EXPECT_EQ(request.token, StateManager::kThresholdModeToken);
+}
+
 TEST_F(StateManagerTest, AdjustBrightness) {
   ASSERT_TRUE(pubsub_.Publish(AmbientLightSample{.sample_lux = 2000.f}));
   led_.Await();
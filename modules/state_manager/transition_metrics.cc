@@ -0,0 +1,105 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/state_manager/transition_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "pw_assert/check.h"
+
+namespace sense {
+namespace {
+
+uint32_t ToMicroseconds(TransitionMetrics::Clock::duration duration) {
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  return static_cast<uint32_t>(
+      std::clamp<int64_t>(us, 0, TransitionMetrics::kUnknownLatency - 1));
+}
+
+}  // namespace
+
+TransitionMetrics::TransitionMetrics(size_t initial_state,
+                                     Clock::time_point now)
+    : current_state_(initial_state), entered_at_(now) {
+  PW_CHECK_UINT_LT(initial_state, kMaxStates);
+  states_[initial_state].entries = 1;
+}
+
+void TransitionMetrics::RecordTransition(size_t to,
+                                         Clock::time_point now,
+                                         Clock::time_point published_at) {
+  PW_CHECK_UINT_LT(to, kMaxStates);
+  const uint32_t latency_us = published_at == Clock::time_point{}
+                                  ? kUnknownLatency
+                                  : ToMicroseconds(now - published_at);
+
+  std::lock_guard lock(lock_);
+  states_[current_state_].dwell_time += now - entered_at_;
+  states_[to].entries += 1;
+
+  records_[total_ % kCapacity] = Record{
+      .timestamp_us = ToMicroseconds(now.time_since_epoch()),
+      .from = static_cast<uint8_t>(current_state_),
+      .to = static_cast<uint8_t>(to),
+      .reserved = 0,
+      .latency_us = latency_us,
+  };
+  ++total_;
+
+  current_state_ = to;
+  entered_at_ = now;
+
+  if (latency_us != kUnknownLatency) {
+    ++latency_samples_;
+    total_latency_us_ += latency_us;
+    max_latency_us_ = std::max(max_latency_us_, latency_us);
+  }
+}
+
+TransitionMetrics::StateStats TransitionMetrics::state(
+    size_t state, Clock::time_point now) const {
+  if (state >= kMaxStates) {
+    return {};
+  }
+  std::lock_guard lock(lock_);
+  StateStats stats = states_[state];
+  if (state == current_state_) {
+    stats.dwell_time += now - entered_at_;
+  }
+  return stats;
+}
+
+uint32_t TransitionMetrics::mean_latency_us() const {
+  std::lock_guard lock(lock_);
+  if (latency_samples_ == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(total_latency_us_ / latency_samples_);
+}
+
+size_t TransitionMetrics::Read(pw::span<Record> out, uint32_t& first) const {
+  std::lock_guard lock(lock_);
+  const uint32_t oldest = total_ > kCapacity ? total_ - kCapacity : 0;
+  first = std::max(first, oldest);
+
+  size_t copied = 0;
+  for (; copied < out.size() && first < total_; ++copied, ++first) {
+    out[copied] = records_[first % kCapacity];
+  }
+  return copied;
+}
+
+}  // namespace sense
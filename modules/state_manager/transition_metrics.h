@@ -0,0 +1,124 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "pw_chrono/system_clock.h"
+#include "pw_span/span.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+
+namespace sense {
+
+/// Counts, dwell times and latencies of state machine transitions, along with
+/// a ring of the most recent transitions.
+///
+/// States are identified by index. Transitions are recorded from one thread,
+/// and the metrics may be read from any other.
+class TransitionMetrics {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  static constexpr size_t kMaxStates = 8;
+  static constexpr size_t kCapacity = 16;
+
+  /// `Record::latency_us` of a transition whose cause has no timestamp.
+  static constexpr uint32_t kUnknownLatency = UINT32_MAX;
+
+  struct Record {
+    /// Low 32 bits of the system clock, in microseconds.
+    uint32_t timestamp_us;
+    uint8_t from;
+    uint8_t to;
+    uint16_t reserved;
+    /// Time from publishing the event that caused the transition, or
+    /// `kUnknownLatency`.
+    uint32_t latency_us;
+  };
+  static_assert(sizeof(Record) == 12);
+
+  struct StateStats {
+    /// Number of times the state was entered.
+    uint32_t entries;
+    /// Total time spent in the state, including the current visit.
+    Clock::duration dwell_time;
+  };
+
+  TransitionMetrics(size_t initial_state, Clock::time_point now);
+
+  /// Records a transition from the current state to `to`.
+  ///
+  /// @param published_at When the event that caused the transition was
+  /// published, or `{}` if that is not known.
+  void RecordTransition(size_t to,
+                        Clock::time_point now,
+                        Clock::time_point published_at = {})
+      PW_LOCKS_EXCLUDED(lock_);
+
+  size_t current_state() const PW_LOCKS_EXCLUDED(lock_) {
+    std::lock_guard lock(lock_);
+    return current_state_;
+  }
+
+  /// Returns the statistics for a state, as of `now`.
+  StateStats state(size_t state, Clock::time_point now) const
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Number of transitions whose latency is known.
+  uint32_t latency_samples() const PW_LOCKS_EXCLUDED(lock_) {
+    std::lock_guard lock(lock_);
+    return latency_samples_;
+  }
+
+  uint32_t mean_latency_us() const PW_LOCKS_EXCLUDED(lock_);
+
+  uint32_t max_latency_us() const PW_LOCKS_EXCLUDED(lock_) {
+    std::lock_guard lock(lock_);
+    return max_latency_us_;
+  }
+
+  /// Copies up to `out.size()` records, oldest first, starting from record
+  /// number `first`. Records that have already been overwritten are skipped.
+  ///
+  /// @param first Sequence number of the first record to copy. Updated to the
+  /// sequence number following the last record copied.
+  /// @returns The number of records copied.
+  size_t Read(pw::span<Record> out, uint32_t& first) const
+      PW_LOCKS_EXCLUDED(lock_);
+
+  /// Total number of transitions ever recorded.
+  uint32_t total() const PW_LOCKS_EXCLUDED(lock_) {
+    std::lock_guard lock(lock_);
+    return total_;
+  }
+
+ private:
+  mutable pw::sync::InterruptSpinLock lock_;
+  std::array<StateStats, kMaxStates> states_ PW_GUARDED_BY(lock_) = {};
+  size_t current_state_ PW_GUARDED_BY(lock_);
+  Clock::time_point entered_at_ PW_GUARDED_BY(lock_);
+
+  uint32_t latency_samples_ PW_GUARDED_BY(lock_) = 0;
+  uint64_t total_latency_us_ PW_GUARDED_BY(lock_) = 0;
+  uint32_t max_latency_us_ PW_GUARDED_BY(lock_) = 0;
+
+  std::array<Record, kCapacity> records_ PW_GUARDED_BY(lock_);
+  uint32_t total_ PW_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace sense
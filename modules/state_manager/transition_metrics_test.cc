@@ -0,0 +1,94 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/state_manager/transition_metrics.h"
+
+#include <array>
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+using sense::TransitionMetrics;
+using Clock = TransitionMetrics::Clock;
+
+constexpr Clock::time_point kStart(Clock::duration(1'000'000));
+
+TEST(TransitionMetricsTest, AccumulatesDwellTime) {
+  TransitionMetrics metrics(0, kStart);
+  metrics.RecordTransition(1, kStart + 10ms);
+  metrics.RecordTransition(0, kStart + 30ms);
+
+  EXPECT_EQ(metrics.current_state(), 0u);
+  EXPECT_EQ(metrics.total(), 2u);
+
+  const auto first = metrics.state(0, kStart + 35ms);
+  EXPECT_EQ(first.entries, 2u);
+  EXPECT_EQ(first.dwell_time, Clock::duration(15ms));
+
+  const auto second = metrics.state(1, kStart + 35ms);
+  EXPECT_EQ(second.entries, 1u);
+  EXPECT_EQ(second.dwell_time, Clock::duration(20ms));
+}
+
+TEST(TransitionMetricsTest, TracksLatencyOfTimestampedCauses) {
+  TransitionMetrics metrics(0, kStart);
+  metrics.RecordTransition(1, kStart + 10ms, kStart + 8ms);
+  metrics.RecordTransition(2, kStart + 20ms);
+  metrics.RecordTransition(0, kStart + 30ms, kStart + 26ms);
+
+  EXPECT_EQ(metrics.latency_samples(), 2u);
+  EXPECT_EQ(metrics.mean_latency_us(), 3'000u);
+  EXPECT_EQ(metrics.max_latency_us(), 4'000u);
+}
+
+TEST(TransitionMetricsTest, ReadsRecentTransitions) {
+  TransitionMetrics metrics(0, kStart);
+  metrics.RecordTransition(1, kStart + 1ms, kStart);
+  metrics.RecordTransition(2, kStart + 2ms);
+
+  std::array<TransitionMetrics::Record, 4> records;
+  uint32_t first = 0;
+  ASSERT_EQ(metrics.Read(records, first), 2u);
+  EXPECT_EQ(first, 2u);
+  EXPECT_EQ(records[0].from, 0u);
+  EXPECT_EQ(records[0].to, 1u);
+  EXPECT_EQ(records[0].latency_us, 1'000u);
+  EXPECT_EQ(records[1].from, 1u);
+  EXPECT_EQ(records[1].to, 2u);
+  EXPECT_EQ(records[1].latency_us, TransitionMetrics::kUnknownLatency);
+  EXPECT_EQ(metrics.Read(records, first), 0u);
+}
+
+TEST(TransitionMetricsTest, RingKeepsNewestTransitions) {
+  TransitionMetrics metrics(0, kStart);
+  const uint32_t count = TransitionMetrics::kCapacity + 3;
+  for (uint32_t i = 0; i < count; ++i) {
+    metrics.RecordTransition(i % 2 == 0 ? 1 : 0, kStart + i * 1ms);
+  }
+
+  std::array<TransitionMetrics::Record, TransitionMetrics::kCapacity + 1>
+      records;
+  uint32_t first = 0;
+  EXPECT_EQ(metrics.Read(records, first), TransitionMetrics::kCapacity);
+  EXPECT_EQ(first, count);
+  EXPECT_EQ(records[0].timestamp_us,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                (kStart + 3ms).time_since_epoch())
+                .count());
+}
+
+}  // namespace
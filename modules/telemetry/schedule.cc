@@ -0,0 +1,59 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/telemetry/schedule.h"
+
+namespace sense {
+
+void TelemetrySchedule::Configure(Channel channel,
+                                  Clock::duration interval,
+                                  Clock::time_point now) {
+  channels_[channel] = {.interval = interval, .deadline = now};
+}
+
+void TelemetrySchedule::Clear() { channels_ = {}; }
+
+TelemetrySchedule::ChannelMask TelemetrySchedule::TakeDue(
+    Clock::time_point now) {
+  ChannelMask due = 0;
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    ChannelState& channel = channels_[i];
+    if (channel.interval == Clock::duration::zero() ||
+        channel.deadline - now > channel.interval / 4) {
+      continue;
+    }
+    due |= ChannelMask(1) << i;
+    // Keep to the original cadence, but skip samples that were missed rather
+    // than sending them in a burst.
+    channel.deadline += channel.interval;
+    if (channel.deadline <= now) {
+      channel.deadline = now + channel.interval;
+    }
+  }
+  return due;
+}
+
+std::optional<TelemetrySchedule::Clock::time_point>
+TelemetrySchedule::next_deadline() const {
+  std::optional<Clock::time_point> next;
+  for (const ChannelState& channel : channels_) {
+    if (channel.interval != Clock::duration::zero() &&
+        (!next.has_value() || channel.deadline < *next)) {
+      next = channel.deadline;
+    }
+  }
+  return next;
+}
+
+}  // namespace sense
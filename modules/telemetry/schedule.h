@@ -0,0 +1,76 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "pw_chrono/system_clock.h"
+
+namespace sense {
+
+/// When each telemetry channel of one stream is next due.
+///
+/// Channels are sampled at independent intervals but sent together: a tick
+/// takes every channel that is due, plus any that would become due within a
+/// quarter of its interval, so that channels with similar rates share
+/// packets and timer wakeups instead of drifting apart.
+class TelemetrySchedule {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  enum Channel : uint8_t {
+    kBoardTemperature = 0,
+    kAir,
+    kLight,
+    kProximity,
+    kState,
+  };
+  static constexpr size_t kNumChannels = 5;
+
+  /// Bit mask of channels, with bit `n` set for channel `n`.
+  using ChannelMask = uint8_t;
+
+  /// Samples `channel` every `interval`, starting at `now`. A zero interval
+  /// stops sampling it.
+  void Configure(Channel channel,
+                 Clock::duration interval,
+                 Clock::time_point now);
+
+  /// Stops sampling every channel.
+  void Clear();
+
+  /// Returns the channels to send at `now` and schedules their next samples.
+  ChannelMask TakeDue(Clock::time_point now);
+
+  /// Returns when the next channel is due, or nothing if none is sampled.
+  std::optional<Clock::time_point> next_deadline() const;
+
+  /// Returns the channel's interval, or zero if it is not sampled.
+  Clock::duration interval(Channel channel) const {
+    return channels_[channel].interval;
+  }
+
+ private:
+  struct ChannelState {
+    Clock::duration interval = Clock::duration::zero();
+    Clock::time_point deadline;
+  };
+
+  std::array<ChannelState, kNumChannels> channels_;
+};
+
+}  // namespace sense
@@ -0,0 +1,85 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/telemetry/schedule.h"
+
+#include <chrono>
+
+#include "pw_unit_test/framework.h"
+
+namespace {
+
+using sense::TelemetrySchedule;
+using std::chrono::milliseconds;
+using Clock = TelemetrySchedule::Clock;
+
+constexpr TelemetrySchedule::ChannelMask Mask(TelemetrySchedule::Channel c) {
+  return TelemetrySchedule::ChannelMask(1) << c;
+}
+
+class TelemetryScheduleTest : public ::testing::Test {
+ protected:
+  Clock::time_point At(int64_t ms) const {
+    return start_ + Clock::for_at_least(milliseconds(ms));
+  }
+
+  const Clock::time_point start_ = Clock::time_point(std::chrono::seconds(10));
+  TelemetrySchedule schedule_;
+};
+
+TEST_F(TelemetryScheduleTest, NothingScheduled) {
+  EXPECT_FALSE(schedule_.next_deadline().has_value());
+  EXPECT_EQ(schedule_.TakeDue(At(0)), 0u);
+}
+
+TEST_F(TelemetryScheduleTest, SendsEachChannelAtItsInterval) {
+  schedule_.Configure(TelemetrySchedule::kAir, milliseconds(1000), At(0));
+  schedule_.Configure(TelemetrySchedule::kLight, milliseconds(300), At(0));
+
+  EXPECT_EQ(schedule_.TakeDue(At(0)),
+            Mask(TelemetrySchedule::kAir) | Mask(TelemetrySchedule::kLight));
+  EXPECT_EQ(schedule_.next_deadline(), At(300));
+  EXPECT_EQ(schedule_.TakeDue(At(300)), Mask(TelemetrySchedule::kLight));
+  EXPECT_EQ(schedule_.TakeDue(At(600)), Mask(TelemetrySchedule::kLight));
+  EXPECT_EQ(schedule_.next_deadline(), At(900));
+}
+
+TEST_F(TelemetryScheduleTest, CoalescesChannelsThatAreNearlyDue) {
+  schedule_.Configure(TelemetrySchedule::kAir, milliseconds(1000), At(0));
+  schedule_.Configure(TelemetrySchedule::kLight, milliseconds(300), At(0));
+  schedule_.TakeDue(At(0));
+  schedule_.TakeDue(At(300));
+  schedule_.TakeDue(At(600));
+
+  // Air is due at 1000, within a quarter interval of light's tick at 900.
+  EXPECT_EQ(schedule_.TakeDue(At(900)),
+            Mask(TelemetrySchedule::kAir) | Mask(TelemetrySchedule::kLight));
+  EXPECT_EQ(schedule_.next_deadline(), At(1200));
+}
+
+TEST_F(TelemetryScheduleTest, SkipsMissedSamples) {
+  schedule_.Configure(TelemetrySchedule::kState, milliseconds(100), At(0));
+  schedule_.TakeDue(At(0));
+  EXPECT_EQ(schedule_.TakeDue(At(550)), Mask(TelemetrySchedule::kState));
+  EXPECT_EQ(schedule_.next_deadline(), At(650));
+}
+
+TEST_F(TelemetryScheduleTest, ZeroIntervalStopsChannel) {
+  schedule_.Configure(TelemetrySchedule::kProximity, milliseconds(100), At(0));
+  schedule_.Configure(TelemetrySchedule::kProximity, Clock::duration(0), At(0));
+  EXPECT_EQ(schedule_.TakeDue(At(0)), 0u);
+  EXPECT_FALSE(schedule_.next_deadline().has_value());
+}
+
+}  // namespace
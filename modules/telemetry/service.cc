@@ -0,0 +1,250 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/telemetry/service.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "pw_assert/check.h"
+#include "pw_log/log.h"
+#include "pw_status/status.h"
+
+namespace sense {
+namespace {
+
+using Channel = TelemetrySchedule::Channel;
+using Clock = pw::chrono::SystemClock;
+
+constexpr TelemetrySchedule::ChannelMask Bit(Channel channel) {
+  return static_cast<TelemetrySchedule::ChannelMask>(1u << channel);
+}
+
+}  // namespace
+
+TelemetryService::TelemetryService()
+    : timer_([this](Clock::time_point) { tick_.Post(*worker_); }),
+      tick_([this]() { Tick(); }) {}
+
+void TelemetryService::Init(Worker& worker,
+                            PubSub& pubsub,
+                            Board& board,
+                            RequestIntervalCallback&& request_interval) {
+  worker_ = &worker;
+  board_ = &board;
+  request_interval_ = std::move(request_interval);
+  PW_CHECK((pubsub.SubscribeToAny<AirMeasurement,
+                                  AmbientLightSample,
+                                  ProximitySample,
+                                  SenseState>(
+      [this](const Event& event) { HandleEvent(event); })));
+}
+
+void TelemetryService::Subscribe(const telemetry_SubscribeRequest& request,
+                                 ServerWriter<telemetry_Frame>& writer) {
+  const Clock::time_point now = Clock::now();
+  TelemetrySchedule schedule;
+  pw::Status status = request.channels_count == 0
+                          ? pw::Status::InvalidArgument()
+                          : pw::OkStatus();
+  for (pb_size_t i = 0; i < request.channels_count && status.ok(); ++i) {
+    const telemetry_ChannelRate& rate = request.channels[i];
+    if (rate.channel < _telemetry_Channel_MIN ||
+        rate.channel > _telemetry_Channel_MAX) {
+      status = pw::Status::InvalidArgument();
+      break;
+    }
+    const auto interval = std::chrono::milliseconds(rate.interval_ms);
+    if (interval < (rate.channel == telemetry_Channel_AIR ? kMinAirInterval
+                                                          : kMinInterval)) {
+      status = pw::Status::InvalidArgument();
+      break;
+    }
+    schedule.Configure(static_cast<Channel>(rate.channel),
+                       Clock::for_at_least(interval),
+                       now);
+  }
+
+  std::lock_guard lock(lock_);
+  Stream* stream = nullptr;
+  if (status.ok()) {
+    auto free =
+        std::find_if(streams_.begin(), streams_.end(), [](const Stream& s) {
+          return !s.writer.active();
+        });
+    if (free == streams_.end()) {
+      status = pw::Status::ResourceExhausted();
+    } else {
+      stream = &*free;
+    }
+  }
+  if (!status.ok()) {
+    if (const auto finish = writer.Finish(status); !finish.ok()) {
+      PW_LOG_ERROR("Failed to write response: %s", finish.str());
+    }
+    return;
+  }
+
+  stream->writer = std::move(writer);
+  stream->schedule = schedule;
+  stream->dropped = 0;
+  UpdateRequestedIntervalsLocked();
+  ScheduleTickLocked();
+}
+
+void TelemetryService::HandleEvent(const Event& event) {
+  std::lock_guard lock(lock_);
+  if (auto* air = std::get_if<AirMeasurement>(&event)) {
+    air_ = *air;
+  } else if (auto* light = std::get_if<AmbientLightSample>(&event)) {
+    ambient_light_lux_ = light->sample_lux;
+  } else if (auto* proximity = std::get_if<ProximitySample>(&event)) {
+    proximity_ = proximity->sample;
+  } else if (auto* state = std::get_if<SenseState>(&event)) {
+    state_ = *state;
+  }
+}
+
+void TelemetryService::Tick() {
+  const Clock::time_point now = Clock::now();
+  const auto timestamp_ms = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          now.time_since_epoch())
+          .count());
+
+  std::lock_guard lock(lock_);
+  bool read_board_temperature = false;
+  bool stream_closed = false;
+  for (Stream& stream : streams_) {
+    if (!stream.writer.active()) {
+      // A stream the client cancelled keeps its schedule until a tick sees
+      // it, so that its channels stop being requested.
+      stream_closed |= stream.schedule.next_deadline().has_value();
+      continue;
+    }
+    const TelemetrySchedule::ChannelMask due = stream.schedule.TakeDue(now);
+    if (due == 0) {
+      continue;
+    }
+    // Read the board temperature at most once per tick, however many streams
+    // want it.
+    if ((due & Bit(TelemetrySchedule::kBoardTemperature)) != 0 &&
+        !read_board_temperature) {
+      board_temperature_ = board_->ReadInternalTemperature();
+      read_board_temperature = true;
+    }
+
+    telemetry_Frame frame = telemetry_Frame_init_default;
+    frame.timestamp_ms = timestamp_ms;
+    FillFrame(due, frame);
+    frame.dropped = stream.dropped;
+    if (stream.writer.Write(frame).ok()) {
+      stream.dropped = 0;
+    } else if (stream.writer.active()) {
+      ++stream.dropped;
+    } else {
+      stream_closed = true;
+    }
+  }
+
+  if (stream_closed) {
+    PW_LOG_INFO("Telemetry stream closed");
+    for (Stream& stream : streams_) {
+      if (!stream.writer.active()) {
+        stream.schedule.Clear();
+      }
+    }
+    UpdateRequestedIntervalsLocked();
+  }
+  ScheduleTickLocked();
+}
+
+void TelemetryService::FillFrame(TelemetrySchedule::ChannelMask due,
+                                 telemetry_Frame& frame) const {
+  if ((due & Bit(TelemetrySchedule::kBoardTemperature)) != 0 &&
+      board_temperature_.has_value()) {
+    frame.has_board_temperature = true;
+    frame.board_temperature = *board_temperature_;
+  }
+  if ((due & Bit(TelemetrySchedule::kAir)) != 0 && air_.has_value()) {
+    frame.has_air = true;
+    frame.air = {
+        .temperature = air_->temperature(),
+        .pressure = air_->pressure,
+        .humidity = air_->humidity(),
+        .gas_resistance = air_->gas_resistance,
+        .score = air_->score,
+    };
+  }
+  if ((due & Bit(TelemetrySchedule::kLight)) != 0 &&
+      ambient_light_lux_.has_value()) {
+    frame.has_ambient_light_lux = true;
+    frame.ambient_light_lux = *ambient_light_lux_;
+  }
+  if ((due & Bit(TelemetrySchedule::kProximity)) != 0 &&
+      proximity_.has_value()) {
+    frame.has_proximity = true;
+    frame.proximity = *proximity_;
+  }
+  if ((due & Bit(TelemetrySchedule::kState)) != 0 && state_.has_value()) {
+    frame.has_state = true;
+    frame.state = {
+        .alarm = state_->alarm,
+        .alarm_threshold = state_->alarm_threshold,
+        .air_quality = state_->air_quality,
+    };
+  }
+}
+
+void TelemetryService::ScheduleTickLocked() {
+  std::optional<Clock::time_point> next;
+  for (const Stream& stream : streams_) {
+    if (!stream.writer.active()) {
+      continue;
+    }
+    const auto deadline = stream.schedule.next_deadline();
+    if (deadline.has_value() && (!next.has_value() || *deadline < *next)) {
+      next = deadline;
+    }
+  }
+  if (next.has_value()) {
+    timer_.InvokeAt(*next);
+  } else {
+    timer_.Cancel();
+  }
+}
+
+void TelemetryService::UpdateRequestedIntervalsLocked() {
+  for (size_t i = 0; i < TelemetrySchedule::kNumChannels; ++i) {
+    const auto channel = static_cast<Channel>(i);
+    Clock::duration fastest = Clock::duration::zero();
+    for (const Stream& stream : streams_) {
+      const Clock::duration interval = stream.writer.active()
+                                           ? stream.schedule.interval(channel)
+                                           : Clock::duration::zero();
+      if (interval != Clock::duration::zero() &&
+          (fastest == Clock::duration::zero() || interval < fastest)) {
+        fastest = interval;
+      }
+    }
+    if (fastest != requested_intervals_[i]) {
+      requested_intervals_[i] = fastest;
+      if (request_interval_ != nullptr) {
+        request_interval_(channel, fastest);
+      }
+    }
+  }
+}
+
+}  // namespace sense
@@ -0,0 +1,113 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "modules/board/board.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/telemetry/schedule.h"
+#include "modules/telemetry/telemetry.rpc.pb.h"
+#include "modules/worker/work_item.h"
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_function/function.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_sync/mutex.h"
+
+namespace sense {
+
+/// Streams readings from several sources over one RPC call per client.
+///
+/// Every stream has its own channel intervals, but all of them are served
+/// by a single timer, and each tick sends the due channels of a stream in
+/// one frame. Sensor channels send the latest reading seen on PubSub; the
+/// board temperature is read when it is due.
+class TelemetryService final
+    : public ::telemetry::pw_rpc::nanopb::Telemetry::Service<
+          TelemetryService> {
+ public:
+  /// Called with the shortest interval any open stream needs for a channel,
+  /// or zero when no stream samples it.
+  using RequestIntervalCallback =
+      pw::Function<void(TelemetrySchedule::Channel,
+                        pw::chrono::SystemClock::duration)>;
+
+  /// Number of `Subscribe` calls that may be open at once.
+  static constexpr size_t kMaxStreams = 3;
+
+  static constexpr auto kMinInterval = std::chrono::milliseconds(100);
+  static constexpr auto kMinAirInterval = std::chrono::milliseconds(500);
+
+  TelemetryService();
+
+  /// Ticks run on `worker`. `request_interval`, if provided, should have
+  /// whatever publishes the sensor readings do so at least as often as the
+  /// fastest stream needs them.
+  void Init(Worker& worker,
+            PubSub& pubsub,
+            Board& board,
+            RequestIntervalCallback&& request_interval = nullptr);
+
+  void Subscribe(const telemetry_SubscribeRequest& request,
+                 ServerWriter<telemetry_Frame>& writer)
+      PW_LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct Stream {
+    ServerWriter<telemetry_Frame> writer;
+    TelemetrySchedule schedule;
+    uint32_t dropped = 0;
+  };
+
+  void HandleEvent(const Event& event) PW_LOCKS_EXCLUDED(lock_);
+
+  /// Sends the due channels of every stream and rearms the timer.
+  void Tick() PW_LOCKS_EXCLUDED(lock_);
+
+  /// Fills in the latest values of the channels in `due`.
+  void FillFrame(TelemetrySchedule::ChannelMask due,
+                 telemetry_Frame& frame) const
+      PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  void ScheduleTickLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /// Reports each channel's fastest interval if it changed.
+  void UpdateRequestedIntervalsLocked() PW_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Worker* worker_ = nullptr;
+  Board* board_ = nullptr;
+  RequestIntervalCallback request_interval_;
+  pw::chrono::SystemTimer timer_;
+  WorkItem tick_;
+
+  pw::sync::Mutex lock_;
+  std::array<Stream, kMaxStreams> streams_ PW_GUARDED_BY(lock_);
+  std::array<pw::chrono::SystemClock::duration, TelemetrySchedule::kNumChannels>
+      requested_intervals_ PW_GUARDED_BY(lock_) = {};
+
+  // Latest readings.
+  std::optional<float> board_temperature_ PW_GUARDED_BY(lock_);
+  std::optional<AirMeasurement> air_ PW_GUARDED_BY(lock_);
+  std::optional<float> ambient_light_lux_ PW_GUARDED_BY(lock_);
+  std::optional<uint16_t> proximity_ PW_GUARDED_BY(lock_);
+  std::optional<SenseState> state_ PW_GUARDED_BY(lock_);
+};
+
+}  // namespace sense
@@ -0,0 +1,76 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/telemetry/service.h"
+
+#include <atomic>
+#include <chrono>
+
+#include "modules/board/board_fake.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/worker/test_worker.h"
+#include "pw_rpc/nanopb/test_method_context.h"
+#include "pw_sync/timed_thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::literals::chrono_literals;
+
+class TelemetryServiceTest : public ::testing::Test {
+ protected:
+  TelemetryServiceTest() : pubsub_(worker_) {}
+
+  void TearDown() override { worker_.Stop(); }
+
+  TestWorker<> worker_;
+  GenericPubSubBuffer<Event, 4, 4> pubsub_;
+  BoardFake board_;
+};
+
+TEST_F(TelemetryServiceTest, CancelledStreamStopsRequestingItsChannels) {
+  PW_NANOPB_TEST_METHOD_CONTEXT(TelemetryService, Subscribe) ctx;
+  std::atomic<bool> requested = false;
+  pw::sync::TimedThreadNotification released;
+  ctx.service().Init(
+      worker_,
+      pubsub_,
+      board_,
+      [&](TelemetrySchedule::Channel channel,
+          pw::chrono::SystemClock::duration interval) {
+        if (channel != TelemetrySchedule::kProximity) {
+          return;
+        }
+        if (interval == pw::chrono::SystemClock::duration::zero()) {
+          released.release();
+        } else {
+          requested = true;
+        }
+      });
+
+  telemetry_SubscribeRequest request = telemetry_SubscribeRequest_init_default;
+  request.channels_count = 1;
+  request.channels[0] = {.channel = telemetry_Channel_PROXIMITY,
+                         .interval_ms = 100};
+  ctx.call(request);
+  EXPECT_TRUE(requested);
+
+  // The next tick notices that the client went away.
+  ctx.SendClientError(pw::Status::Cancelled());
+  EXPECT_TRUE(released.try_acquire_for(5s));
+}
+
+}  // namespace
+}  // namespace sense
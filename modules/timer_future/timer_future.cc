@@ -41,9 +41,16 @@ TimerFuture AsyncTimer::WaitFor(SystemClock::duration duration) {
   return WaitUntil(SystemClock::now() + duration);
 }
 
+void AsyncTimer::Wake() {
+  woken_.store(true, std::memory_order_release);
+  // Run the expiration callback right away to wake the waiting task.
+  timer_.InvokeAt(SystemClock::now());
+}
+
 Poll<> TimerFuture::Pend(Context& cx) {
   async_timer_.waker_ = cx.GetWaker(WaitReason::Unspecified());
-  if (SystemClock::now() < async_timer_.deadline_) {
+  if (!async_timer_.woken_.exchange(false, std::memory_order_acq_rel) &&
+      SystemClock::now() < async_timer_.deadline_) {
     return Pending();
   }
   async_timer_.waker_.Clear();
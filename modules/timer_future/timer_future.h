@@ -13,6 +13,8 @@
 // the License.
 #pragma once
 
+#include <atomic>
+
 #include "pw_async2/dispatcher.h"
 #include "pw_chrono/system_clock.h"
 #include "pw_chrono/system_timer.h"
@@ -35,10 +37,16 @@ class AsyncTimer {
   TimerFuture WaitUntil(pw::chrono::SystemClock::time_point deadline);
   TimerFuture WaitFor(pw::chrono::SystemClock::duration duration);
 
+  /// Completes the current or next wait early. May be called from any thread,
+  /// so a task can sleep until its next deadline and still react promptly to
+  /// requests from elsewhere.
+  void Wake();
+
  private:
   friend class TimerFuture;
 
   pw::async2::Waker waker_;
+  std::atomic<bool> woken_ = false;
   pw::chrono::SystemClock::time_point deadline_;
   pw::chrono::SystemTimer timer_;
 };
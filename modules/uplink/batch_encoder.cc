@@ -0,0 +1,108 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/uplink/batch_encoder.h"
+
+#include <limits>
+
+#include "pw_varint/varint.h"
+
+namespace sense {
+
+// Longest possible section header: series, period, count and start time.
+constexpr size_t kMaxSectionHeaderSize = 1 + 5 + 2 + 5;
+
+BatchEncoder::BatchEncoder(pw::ByteSpan buffer, const Header& header)
+    : buffer_(buffer) {
+  overflowed_ = !(PutByte(kVersion) && PutVarint(header.device_id) &&
+                  PutVarint(header.sequence) && PutVarint(header.uptime_s) &&
+                  PutByte(header.alarm ? 1 : 0) &&
+                  PutVarint(header.air_quality));
+}
+
+bool BatchEncoder::PutByte(uint8_t value) {
+  if (size_ >= buffer_.size()) {
+    return false;
+  }
+  buffer_[size_++] = static_cast<std::byte>(value);
+  return true;
+}
+
+bool BatchEncoder::PutVarint(uint64_t value) {
+  const size_t written = pw::varint::Encode(value, buffer_.subspan(size_));
+  size_ += written;
+  return written != 0;
+}
+
+bool BatchEncoder::BeginSeries(uint8_t series, uint32_t period_s) {
+  EndSeries();
+  if (overflowed_ || buffer_.size() - size_ < kMaxSectionHeaderSize + 2) {
+    return false;
+  }
+  section_start_ = size_;
+  PutByte(series);
+  PutVarint(period_s);
+  count_offset_ = size_;
+  size_ += sizeof(uint16_t);
+  in_series_ = true;
+  count_ = 0;
+  period_s_ = period_s == 0 ? 1 : period_s;
+  last_mean_ = 0;
+  return true;
+}
+
+bool BatchEncoder::Add(const HistoryTier::Point& point) {
+  if (!in_series_ || count_ == std::numeric_limits<uint16_t>::max()) {
+    return false;
+  }
+  const size_t start = size_;
+  bool fits = true;
+  if (count_ == 0) {
+    fits = PutVarint(point.time_s) && PutVarint(0);
+  } else {
+    fits = point.time_s >= last_s_ &&
+           PutVarint((point.time_s - last_s_) / period_s_);
+  }
+  const int64_t delta = int64_t{point.mean} - last_mean_;
+  if (!fits || !PutVarint(pw::varint::ZigZagEncode(delta))) {
+    size_ = start;
+    return false;
+  }
+  last_s_ = point.time_s;
+  last_mean_ = point.mean;
+  ++count_;
+  ++points_;
+  return true;
+}
+
+void BatchEncoder::EndSeries() {
+  if (!in_series_) {
+    return;
+  }
+  in_series_ = false;
+  if (count_ == 0) {
+    // Drop the empty section's header.
+    size_ = section_start_;
+    return;
+  }
+  buffer_[count_offset_] = static_cast<std::byte>(count_ & 0xff);
+  buffer_[count_offset_ + 1] = static_cast<std::byte>(count_ >> 8);
+}
+
+pw::ConstByteSpan BatchEncoder::Finish() {
+  EndSeries();
+  return buffer_.first(size_);
+}
+
+}  // namespace sense
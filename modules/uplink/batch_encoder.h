@@ -0,0 +1,104 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/history/history_tier.h"
+#include "pw_bytes/span.h"
+
+namespace sense {
+
+/// Packs history points into a compact uplink datagram.
+///
+/// Readings change slowly, so each point is stored as varint deltas from the
+/// previous one and typically takes two or three bytes. The layout is:
+///
+///   uint8   version
+///   varint  device id
+///   varint  datagram sequence number
+///   varint  uptime in seconds
+///   uint8   flags: bit 0 set while the alarm is active
+///   varint  air quality score
+///
+/// followed by sections until the end of the datagram, each of
+///
+///   uint8   series, as in `History::Series`
+///   varint  period in seconds
+///   uint16  point count n, little-endian
+///   varint  time of the first point, in seconds since boot
+///   n times:
+///     varint         periods since the previous point, 0 for the first
+///     zigzag varint  mean minus the previous mean, which starts at 0
+///
+/// Means are quantized as in the history store. Minima and maxima are not
+/// sent.
+class BatchEncoder {
+ public:
+  static constexpr uint8_t kVersion = 1;
+
+  struct Header {
+    uint64_t device_id = 0;
+    uint32_t sequence = 0;
+    uint32_t uptime_s = 0;
+    bool alarm = false;
+    uint16_t air_quality = 0;
+  };
+
+  /// Starts a datagram in `buffer`, which must stay valid until `Finish`.
+  BatchEncoder(pw::ByteSpan buffer, const Header& header);
+
+  BatchEncoder(const BatchEncoder&) = delete;
+  BatchEncoder& operator=(const BatchEncoder&) = delete;
+
+  /// Starts a section for points of one series. Returns false if there is no
+  /// room for it.
+  bool BeginSeries(uint8_t series, uint32_t period_s);
+
+  /// Adds a point to the current section. Points must be added in time
+  /// order. Returns false if it does not fit, in which case it should start
+  /// the next datagram.
+  bool Add(const HistoryTier::Point& point);
+
+  /// Returns the datagram. No more points can be added afterwards.
+  pw::ConstByteSpan Finish();
+
+  /// Points added across all sections.
+  size_t points() const { return points_; }
+
+  /// Whether the header did not fit, so nothing can be added.
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  bool PutByte(uint8_t value);
+  bool PutVarint(uint64_t value);
+  void EndSeries();
+
+  pw::ByteSpan buffer_;
+  size_t size_ = 0;
+  size_t points_ = 0;
+  bool overflowed_ = false;
+
+  // State of the current section.
+  bool in_series_ = false;
+  size_t section_start_ = 0;
+  size_t count_offset_ = 0;
+  uint16_t count_ = 0;
+  uint32_t period_s_ = 1;
+  uint32_t last_s_ = 0;
+  int32_t last_mean_ = 0;
+};
+
+}  // namespace sense
@@ -0,0 +1,167 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/uplink/batch_encoder.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "pw_unit_test/framework.h"
+#include "pw_varint/varint.h"
+
+namespace sense {
+namespace {
+
+using Point = HistoryTier::Point;
+
+Point At(uint32_t time_s, int32_t mean) {
+  return {.time_s = time_s, .mean = mean, .min = mean, .max = mean};
+}
+
+// Reads a datagram back, as a collector would.
+class Reader {
+ public:
+  explicit Reader(pw::ConstByteSpan data) : data_(data) {}
+
+  bool done() const { return data_.empty(); }
+
+  uint8_t Byte() {
+    const auto value = static_cast<uint8_t>(data_[0]);
+    data_ = data_.subspan(1);
+    return value;
+  }
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    const size_t size = pw::varint::Decode(data_, &value);
+    EXPECT_NE(size, 0u);
+    data_ = data_.subspan(size);
+    return value;
+  }
+
+  void SkipHeader() {
+    Byte();
+    Varint();
+    Varint();
+    Varint();
+    Byte();
+    Varint();
+  }
+
+  struct Section {
+    uint8_t series;
+    std::vector<Point> points;
+  };
+
+  Section ReadSection() {
+    Section section = {.series = Byte(), .points = {}};
+    const auto period_s = static_cast<uint32_t>(Varint());
+    const uint16_t count = Byte() | (Byte() << 8);
+    uint32_t time_s = static_cast<uint32_t>(Varint());
+    int32_t mean = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+      time_s += static_cast<uint32_t>(Varint()) * period_s;
+      mean += static_cast<int32_t>(pw::varint::ZigZagDecode(Varint()));
+      section.points.push_back(At(time_s, mean));
+    }
+    return section;
+  }
+
+ private:
+  pw::ConstByteSpan data_;
+};
+
+constexpr BatchEncoder::Header kHeader = {
+    .device_id = 0xaabbccddeeff,
+    .sequence = 7,
+    .uptime_s = 3600,
+    .alarm = true,
+    .air_quality = 512,
+};
+
+TEST(BatchEncoderTest, RoundTripsSections) {
+  std::array<std::byte, 128> buffer;
+  BatchEncoder encoder(buffer, kHeader);
+  ASSERT_TRUE(encoder.BeginSeries(0, 60));
+  ASSERT_TRUE(encoder.Add(At(600, 700)));
+  ASSERT_TRUE(encoder.Add(At(660, 702)));
+  ASSERT_TRUE(encoder.Add(At(840, 650)));
+  ASSERT_TRUE(encoder.BeginSeries(2, 60));
+  ASSERT_TRUE(encoder.Add(At(600, -150)));
+  EXPECT_EQ(encoder.points(), 4u);
+
+  Reader reader(encoder.Finish());
+  EXPECT_EQ(reader.Byte(), BatchEncoder::kVersion);
+  EXPECT_EQ(reader.Varint(), kHeader.device_id);
+  EXPECT_EQ(reader.Varint(), 7u);
+  EXPECT_EQ(reader.Varint(), 3600u);
+  EXPECT_EQ(reader.Byte(), 1u);
+  EXPECT_EQ(reader.Varint(), 512u);
+
+  const Reader::Section air = reader.ReadSection();
+  EXPECT_EQ(air.series, 0u);
+  ASSERT_EQ(air.points.size(), 3u);
+  EXPECT_EQ(air.points[1].time_s, 660u);
+  EXPECT_EQ(air.points[1].mean, 702);
+  EXPECT_EQ(air.points[2].time_s, 840u);
+  EXPECT_EQ(air.points[2].mean, 650);
+
+  const Reader::Section temperature = reader.ReadSection();
+  EXPECT_EQ(temperature.series, 2u);
+  ASSERT_EQ(temperature.points.size(), 1u);
+  EXPECT_EQ(temperature.points[0].mean, -150);
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(BatchEncoderTest, SlowChangesTakeAFewBytesPerPoint) {
+  std::array<std::byte, 256> buffer;
+  BatchEncoder encoder(buffer, kHeader);
+  const size_t header_size = BatchEncoder(buffer, kHeader).Finish().size();
+  ASSERT_TRUE(encoder.BeginSeries(0, 60));
+  for (uint32_t i = 0; i < 60; ++i) {
+    ASSERT_TRUE(encoder.Add(
+        At(i * 60, 800 + static_cast<int32_t>(i % 5))));
+  }
+  // 60 points of 12 bytes each in the history store.
+  EXPECT_LT(encoder.Finish().size() - header_size, 140u);
+}
+
+TEST(BatchEncoderTest, RejectsPointsThatDoNotFit) {
+  std::array<std::byte, 40> buffer;
+  BatchEncoder encoder(buffer, kHeader);
+  ASSERT_TRUE(encoder.BeginSeries(0, 1));
+  size_t added = 0;
+  while (encoder.Add(At(static_cast<uint32_t>(added),
+                        static_cast<int32_t>(added) * 1000))) {
+    ++added;
+  }
+  EXPECT_GT(added, 0u);
+  EXPECT_EQ(encoder.points(), added);
+
+  Reader reader(encoder.Finish());
+  reader.SkipHeader();
+  EXPECT_EQ(reader.ReadSection().points.size(), added);
+}
+
+TEST(BatchEncoderTest, DropsEmptySections) {
+  std::array<std::byte, 64> buffer;
+  const size_t header_size = BatchEncoder(buffer, kHeader).Finish().size();
+  BatchEncoder encoder(buffer, kHeader);
+  ASSERT_TRUE(encoder.BeginSeries(1, 60));
+  EXPECT_EQ(encoder.Finish().size(), header_size);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,54 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+
+#include "pw_bytes/span.h"
+#include "pw_status/status.h"
+
+namespace sense {
+
+/// Radio link that `Uplink` sends its batches over.
+///
+/// The radio is only powered while connected, so that it draws nothing
+/// between bursts. Calls may block for as long as joining the network takes,
+/// so make them from a blocking worker.
+class Radio {
+ public:
+  virtual ~Radio() = default;
+
+  /// Powers the radio on and joins the network, if not already connected.
+  pw::Status Connect() { return DoConnect(); }
+
+  /// Sends one datagram to the collector.
+  ///
+  /// @returns FailedPrecondition if not connected, and ResourceExhausted if
+  /// the datagram is larger than `max_datagram_size`.
+  pw::Status Send(pw::ConstByteSpan datagram) { return DoSend(datagram); }
+
+  /// Leaves the network and powers the radio off.
+  void PowerOff() { DoPowerOff(); }
+
+  /// Largest datagram `Send` accepts.
+  size_t max_datagram_size() const { return DoMaxDatagramSize(); }
+
+ private:
+  virtual pw::Status DoConnect() = 0;
+  virtual pw::Status DoSend(pw::ConstByteSpan datagram) = 0;
+  virtual void DoPowerOff() = 0;
+  virtual size_t DoMaxDatagramSize() const = 0;
+};
+
+}  // namespace sense
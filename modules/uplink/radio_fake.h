@@ -0,0 +1,66 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "modules/uplink/radio.h"
+
+namespace sense {
+
+/// Radio that keeps what it sends. Host only.
+class RadioFake final : public Radio {
+ public:
+  explicit RadioFake(size_t max_datagram_size = 256)
+      : max_datagram_size_(max_datagram_size) {}
+
+  /// Makes the next `Connect` calls fail with `status`.
+  void set_connect_status(pw::Status status) { connect_status_ = status; }
+
+  bool powered() const { return powered_; }
+  size_t connects() const { return connects_; }
+  const std::vector<std::vector<std::byte>>& sent() const { return sent_; }
+  void clear_sent() { sent_.clear(); }
+
+ private:
+  pw::Status DoConnect() override {
+    ++connects_;
+    powered_ = connect_status_.ok();
+    return connect_status_;
+  }
+
+  pw::Status DoSend(pw::ConstByteSpan datagram) override {
+    if (!powered_) {
+      return pw::Status::FailedPrecondition();
+    }
+    if (datagram.size() > max_datagram_size_) {
+      return pw::Status::ResourceExhausted();
+    }
+    sent_.emplace_back(datagram.begin(), datagram.end());
+    return pw::OkStatus();
+  }
+
+  void DoPowerOff() override { powered_ = false; }
+
+  size_t DoMaxDatagramSize() const override { return max_datagram_size_; }
+
+  const size_t max_datagram_size_;
+  pw::Status connect_status_;
+  bool powered_ = false;
+  size_t connects_ = 0;
+  std::vector<std::vector<std::byte>> sent_;
+};
+
+}  // namespace sense
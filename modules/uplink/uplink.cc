@@ -0,0 +1,182 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "UPLINK"
+
+#include "modules/uplink/uplink.h"
+
+#include <algorithm>
+#include <optional>
+#include <tuple>
+
+#include "pw_assert/check.h"
+#include "pw_log/log.h"
+#include "pw_status/try.h"
+
+namespace sense {
+
+using std::chrono::duration_cast;
+
+Uplink::Uplink(History& history, Radio& radio)
+    : history_(history),
+      radio_(radio),
+      timer_([this](Clock::time_point) { RequestBurst(); }) {}
+
+void Uplink::Init(Worker& worker,
+                  PubSub& pubsub,
+                  uint64_t device_id,
+                  const Config& config) {
+  worker_ = &worker;
+  device_id_ = device_id;
+  config_ = config;
+  PW_CHECK(pubsub.SubscribeTo<SenseState>(
+      [this](const SenseState& state) { HandleState(state); }));
+  timer_.InvokeAfter(config_.interval);
+}
+
+void Uplink::HandleState(const SenseState& state) {
+  air_quality_.store(state.air_quality, std::memory_order_relaxed);
+  const bool was_alarm =
+      alarm_.exchange(state.alarm, std::memory_order_relaxed);
+  if (config_.send_on_alarm && state.alarm && !was_alarm) {
+    RequestBurst();
+  }
+}
+
+void Uplink::RequestBurst() {
+  if (burst_pending_.exchange(true)) {
+    return;
+  }
+  if (!worker_->RunOnce([this] {
+        burst_pending_.store(false);
+        std::ignore = Burst();
+      })) {
+    // Only a burst re-arms the timer, so without one the uplink would stop.
+    // `retry_delay_` belongs to the worker, so retry after the initial delay.
+    burst_pending_.store(false);
+    PW_LOG_WARN("Failed to queue uplink burst");
+    timer_.InvokeAfter(
+        std::min<Clock::duration>(kInitialRetryDelay, config_.interval));
+  }
+}
+
+pw::Status Uplink::Burst() {
+  const Clock::time_point start = Clock::now();
+  if (burst_run_ && start - last_burst_ < config_.min_interval) {
+    timer_.InvokeAfter(config_.min_interval - (start - last_burst_));
+    return pw::Status::Unavailable();
+  }
+  burst_run_ = true;
+  last_burst_ = start;
+  bursts_.Increment();
+
+  pw::Status status = radio_.Connect();
+  if (status.ok()) {
+    status = SendPoints();
+  }
+  radio_.PowerOff();
+  radio_on_ms_.Increment(static_cast<uint32_t>(
+      duration_cast<std::chrono::milliseconds>(Clock::now() - start).count()));
+
+  if (status.ok()) {
+    retry_delay_ = kInitialRetryDelay;
+    timer_.InvokeAfter(config_.interval);
+    return pw::OkStatus();
+  }
+  failed_bursts_.Increment();
+  PW_LOG_WARN("Uplink burst failed: %s", status.str());
+  timer_.InvokeAfter(std::min<Clock::duration>(retry_delay_, config_.interval));
+  retry_delay_ = std::min<Clock::duration>(retry_delay_ * 2, config_.interval);
+  return status;
+}
+
+BatchEncoder::Header Uplink::NextHeader() const {
+  return {
+      .device_id = device_id_,
+      .sequence = sequence_,
+      .uptime_s = static_cast<uint32_t>(
+          duration_cast<std::chrono::seconds>(Clock::now().time_since_epoch())
+              .count()),
+      .alarm = alarm_.load(std::memory_order_relaxed),
+      .air_quality = air_quality_.load(std::memory_order_relaxed),
+  };
+}
+
+pw::Status Uplink::SendPoints() {
+  std::array<std::byte, SENSE_UPLINK_MAX_DATAGRAM_SIZE> buffer;
+  const pw::ByteSpan datagram_buffer = pw::ByteSpan(buffer).first(
+      std::min(buffer.size(), radio_.max_datagram_size()));
+  const uint32_t period_s = History::period_s(config_.tier);
+
+  // Points added to the encoder, including the datagram being built.
+  std::array<uint32_t, History::kNumSeries> added_until_s = sent_until_s_;
+  const uint32_t first_sequence = sequence_;
+  std::optional<BatchEncoder> encoder;
+  encoder.emplace(datagram_buffer, NextHeader());
+
+  auto flush = [&]() -> pw::Status {
+    const pw::ConstByteSpan datagram = encoder->Finish();
+    PW_TRY(radio_.Send(datagram));
+    datagrams_.Increment();
+    bytes_.Increment(static_cast<uint32_t>(datagram.size()));
+    points_.Increment(static_cast<uint32_t>(encoder->points()));
+    sent_until_s_ = added_until_s;
+    ++sequence_;
+    encoder.emplace(datagram_buffer, NextHeader());
+    return pw::OkStatus();
+  };
+
+  for (size_t i = 0; i < History::kNumSeries; ++i) {
+    const auto series = static_cast<History::Series>(i);
+    const auto id = static_cast<uint8_t>(i);
+    bool begun = false;
+    const auto [oldest, end] = history_.BlockRange(series, config_.tier);
+    for (uint32_t sequence = oldest; sequence != end; ++sequence) {
+      HistoryTier::Block block;
+      if (!history_.ReadBlock(series, config_.tier, sequence, block) ||
+          block.end_s(period_s) <= added_until_s[i]) {
+        continue;
+      }
+      std::array<HistoryTier::Point, HistoryTier::kBlockPoints> points;
+      const size_t count = block.Decode(period_s, points);
+      for (size_t p = 0; p < count; ++p) {
+        const HistoryTier::Point& point = points[p];
+        if (point.time_s < added_until_s[i]) {
+          continue;
+        }
+        if (!begun) {
+          if (!encoder->BeginSeries(id, period_s)) {
+            PW_TRY(flush());
+            PW_CHECK(encoder->BeginSeries(id, period_s));
+          }
+          begun = true;
+        }
+        if (!encoder->Add(point)) {
+          PW_TRY(flush());
+          // A point always fits in a new section of an empty datagram.
+          PW_CHECK(encoder->BeginSeries(id, period_s));
+          PW_CHECK(encoder->Add(point));
+        }
+        added_until_s[i] = point.time_s + period_s;
+      }
+    }
+  }
+  // A burst with no new points still reports the state, e.g. for an alarm.
+  if (encoder->points() > 0 || sequence_ == first_sequence) {
+    PW_TRY(flush());
+  }
+  return pw::OkStatus();
+}
+
+}  // namespace sense
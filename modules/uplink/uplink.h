@@ -0,0 +1,129 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/history/history.h"
+#include "modules/pubsub/pubsub_events.h"
+#include "modules/uplink/batch_encoder.h"
+#include "modules/uplink/radio.h"
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_metric/metric.h"
+
+#ifndef SENSE_UPLINK_MAX_DATAGRAM_SIZE
+#define SENSE_UPLINK_MAX_DATAGRAM_SIZE 512
+#endif  // SENSE_UPLINK_MAX_DATAGRAM_SIZE
+
+namespace sense {
+
+/// Sends the history store's readings over a radio in occasional bursts.
+///
+/// The radio is powered on for a burst, sends every point recorded since the
+/// previous burst as compressed datagrams, and is powered off again. Bursts
+/// run on a schedule, and as soon as the alarm turns on. A burst that fails
+/// keeps its unsent points for the next one, which is retried sooner.
+class Uplink {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  struct Config {
+    /// Time between scheduled bursts.
+    Clock::duration interval = std::chrono::minutes(15);
+
+    /// Resolution of the readings sent. Must keep at least `interval` of
+    /// history, so the minute tier suits intervals up to about two hours.
+    History::Tier tier = History::Tier::kMinute;
+
+    /// Whether the alarm turning on starts a burst.
+    bool send_on_alarm = true;
+
+    /// Shortest time between bursts, so that a flapping alarm does not keep
+    /// the radio on.
+    Clock::duration min_interval = std::chrono::minutes(1);
+  };
+
+  Uplink(History& history, Radio& radio);
+
+  Uplink(const Uplink&) = delete;
+  Uplink& operator=(const Uplink&) = delete;
+
+  /// Starts sending. Bursts run on `worker`, which may block for as long as
+  /// the radio takes to join the network.
+  void Init(Worker& worker, PubSub& pubsub, uint64_t device_id) {
+    Init(worker, pubsub, device_id, Config{});
+  }
+
+  void Init(Worker& worker,
+            PubSub& pubsub,
+            uint64_t device_id,
+            const Config& config);
+
+  /// Starts a burst soon, unless one is already pending.
+  void RequestBurst();
+
+  /// Runs a burst now. Must be called from the worker given to `Init`.
+  pw::Status Burst();
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+  /// Points sent since boot.
+  uint32_t points_sent() const { return points_.value(); }
+
+ private:
+  // Delay before a failed burst is retried; doubles up to `interval`.
+  static constexpr auto kInitialRetryDelay = std::chrono::seconds(30);
+
+  void HandleState(const SenseState& state);
+
+  // Sends every point not yet sent. Points are only marked as sent once the
+  // datagram carrying them is, so a failure partway resends the rest.
+  pw::Status SendPoints();
+  BatchEncoder::Header NextHeader() const;
+
+  History& history_;
+  Radio& radio_;
+  Worker* worker_ = nullptr;
+  Config config_;
+  uint64_t device_id_ = 0;
+  pw::chrono::SystemTimer timer_;
+
+  std::atomic<bool> burst_pending_ = false;
+  std::atomic<bool> alarm_ = false;
+  std::atomic<uint16_t> air_quality_ = 0;
+
+  // Only used from the worker. Points of each series earlier than
+  // `sent_until_s_` have been sent.
+  std::array<uint32_t, History::kNumSeries> sent_until_s_ = {};
+  uint32_t sequence_ = 0;
+  Clock::duration retry_delay_ = kInitialRetryDelay;
+  Clock::time_point last_burst_;
+  bool burst_run_ = false;
+
+  PW_METRIC_GROUP(metrics_, "uplink");
+  PW_METRIC(metrics_, bursts_, "bursts", 0u);
+  PW_METRIC(metrics_, failed_bursts_, "failed bursts", 0u);
+  PW_METRIC(metrics_, datagrams_, "datagrams", 0u);
+  PW_METRIC(metrics_, bytes_, "bytes", 0u);
+  PW_METRIC(metrics_, points_, "points", 0u);
+  PW_METRIC(metrics_, radio_on_ms_, "radio on ms", 0u);
+};
+
+}  // namespace sense
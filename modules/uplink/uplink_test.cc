@@ -0,0 +1,181 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/uplink/uplink.h"
+
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include "modules/uplink/radio_fake.h"
+#include "pw_containers/vector.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::literals::chrono_literals;
+
+// Holds work until the test runs it, or rejects it like a full queue.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (rejecting_) {
+      return false;
+    }
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void set_rejecting(bool rejecting) { rejecting_ = rejecting; }
+
+  size_t pending() const { return work_.size(); }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+  bool rejecting_ = false;
+};
+
+pw::chrono::SystemClock::time_point At(std::chrono::seconds time) {
+  return pw::chrono::SystemClock::time_point(
+      std::chrono::duration_cast<pw::chrono::SystemClock::duration>(time));
+}
+
+SenseState State(bool alarm) {
+  return {.alarm = alarm,
+          .alarm_threshold = 0,
+          .air_quality = 700,
+          .air_quality_rating = AirQualityRating::kGood};
+}
+
+class UplinkTest : public ::testing::Test {
+ protected:
+  UplinkTest() : pubsub_(worker_) {}
+
+  void Init(size_t max_datagram_size = 256) {
+    radio_.emplace(max_datagram_size);
+    uplink_.emplace(history_, *radio_);
+    uplink_->Init(worker_,
+                  pubsub_,
+                  /*device_id=*/42,
+                  {.interval = 15min,
+                   .tier = History::Tier::kSecond,
+                   .send_on_alarm = true,
+                   .min_interval = 0s});
+  }
+
+  // Records a reading each second from `start` to `end`. The last second is
+  // still being averaged, so only earlier ones are points in the history.
+  void Record(uint32_t start, uint32_t end) {
+    for (uint32_t s = start; s <= end; ++s) {
+      history_.Add(History::Series::kAirQuality,
+                   At(std::chrono::seconds(s)),
+                   static_cast<float>(500 + s));
+    }
+  }
+
+  ManualWorker worker_;
+  GenericPubSubBuffer<Event, 4, 4> pubsub_;
+  History history_;
+  std::optional<RadioFake> radio_;
+  std::optional<Uplink> uplink_;
+};
+
+TEST_F(UplinkTest, BurstSendsNewPointsWithTheRadioOn) {
+  Init();
+  Record(1, 6);
+
+  ASSERT_EQ(uplink_->Burst(), pw::OkStatus());
+  EXPECT_EQ(radio_->connects(), 1u);
+  EXPECT_FALSE(radio_->powered());
+  EXPECT_EQ(radio_->sent().size(), 1u);
+  EXPECT_EQ(uplink_->points_sent(), 5u);
+
+  // Only points recorded since are sent next time.
+  Record(7, 9);
+  ASSERT_EQ(uplink_->Burst(), pw::OkStatus());
+  EXPECT_EQ(uplink_->points_sent(), 8u);
+}
+
+TEST_F(UplinkTest, BurstWithoutPointsStillReports) {
+  Init();
+  ASSERT_EQ(uplink_->Burst(), pw::OkStatus());
+  EXPECT_EQ(radio_->sent().size(), 1u);
+  EXPECT_EQ(uplink_->points_sent(), 0u);
+}
+
+TEST_F(UplinkTest, FailedBurstKeepsPointsForTheNext) {
+  Init();
+  Record(1, 6);
+  radio_->set_connect_status(pw::Status::Unavailable());
+  EXPECT_EQ(uplink_->Burst(), pw::Status::Unavailable());
+  EXPECT_FALSE(radio_->powered());
+  EXPECT_EQ(uplink_->points_sent(), 0u);
+
+  radio_->set_connect_status(pw::OkStatus());
+  ASSERT_EQ(uplink_->Burst(), pw::OkStatus());
+  EXPECT_EQ(uplink_->points_sent(), 5u);
+}
+
+TEST_F(UplinkTest, SplitsPointsAcrossDatagrams) {
+  Init(/*max_datagram_size=*/40);
+  Record(1, 41);
+
+  ASSERT_EQ(uplink_->Burst(), pw::OkStatus());
+  EXPECT_GT(radio_->sent().size(), 1u);
+  for (const auto& datagram : radio_->sent()) {
+    EXPECT_LE(datagram.size(), 40u);
+  }
+  EXPECT_EQ(uplink_->points_sent(), 40u);
+}
+
+TEST_F(UplinkTest, AlarmStartsABurst) {
+  Init();
+  ASSERT_TRUE(pubsub_.Publish(State(false)));
+  worker_.RunAll();
+  EXPECT_EQ(radio_->connects(), 0u);
+
+  ASSERT_TRUE(pubsub_.Publish(State(true)));
+  worker_.RunAll();  // Dispatches the state, which queues the burst.
+  worker_.RunAll();
+  EXPECT_EQ(radio_->connects(), 1u);
+
+  // Staying in alarm does not start another.
+  ASSERT_TRUE(pubsub_.Publish(State(true)));
+  worker_.RunAll();
+  EXPECT_EQ(worker_.pending(), 0u);
+}
+
+TEST_F(UplinkTest, RejectedBurstCanBeRequestedAgain) {
+  Init();
+  worker_.set_rejecting(true);
+  uplink_->RequestBurst();
+  EXPECT_EQ(worker_.pending(), 0u);
+
+  worker_.set_rejecting(false);
+  uplink_->RequestBurst();
+  ASSERT_EQ(worker_.pending(), 1u);
+  worker_.RunAll();
+  EXPECT_EQ(radio_->connects(), 1u);
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,135 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/worker/instrumented_worker.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "pw_log/log.h"
+
+namespace sense::internal {
+namespace {
+
+uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+}  // namespace
+
+GenericInstrumentedWorker::GenericInstrumentedWorker(
+    Worker& worker,
+    pw::InlineDeque<pw::Function<void()>>& pending,
+    pw::tokenizer::Token name)
+    : worker_(&worker), pending_(&pending), metrics_(name) {}
+
+bool GenericInstrumentedWorker::RunOnce(pw::Function<void()>&& work) {
+  {
+    std::lock_guard lock(lock_);
+    // This may run in an interrupt, so drops are only counted, not logged.
+    if (pending_->full()) {
+      dropped_.Increment();
+      return false;
+    }
+    pending_->push_back(std::move(work));
+    posted_.Increment();
+    const auto depth = static_cast<uint32_t>(pending_->size());
+    if (depth > queue_high_water_mark_.value()) {
+      queue_high_water_mark_.Set(depth);
+    }
+  }
+  if (worker_->RunOnce([this]() { RunNext(); })) {
+    return true;
+  }
+
+  // The wrapped worker dropped the thunk, so remove an entry to keep one per
+  // thunk. Thunks run the oldest entry, so which entry goes does not matter
+  // for the count, and it is normally this one.
+  std::lock_guard lock(lock_);
+  pending_->pop_back();
+  posted_.Set(posted_.value() - 1);
+  dropped_.Increment();
+  return false;
+}
+
+void GenericInstrumentedWorker::RunNext() {
+  pw::Function<void()> work;
+  {
+    std::lock_guard lock(lock_);
+    if (pending_->empty()) {
+      return;
+    }
+    work = std::move(pending_->front());
+    pending_->pop_front();
+  }
+
+  const auto start = pw::chrono::SystemClock::now();
+  work();
+  RecordTask(start, pw::chrono::SystemClock::now());
+}
+
+void GenericInstrumentedWorker::RecordTask(
+    pw::chrono::SystemClock::time_point start,
+    pw::chrono::SystemClock::time_point end) {
+  completed_.Increment();
+
+  const uint32_t duration_us = ToMicroseconds(end - start);
+  max_task_us_.Set(std::max(max_task_us_.value(), duration_us));
+  if (duration_us < kBucketLimitsUs[0]) {
+    tasks_under_100us_.Increment();
+  } else if (duration_us < kBucketLimitsUs[1]) {
+    tasks_under_1ms_.Increment();
+  } else if (duration_us < kBucketLimitsUs[2]) {
+    tasks_under_10ms_.Increment();
+  } else if (duration_us < kBucketLimitsUs[3]) {
+    tasks_under_100ms_.Increment();
+  } else {
+    tasks_over_100ms_.Increment();
+  }
+
+  if (end - start > task_budget_) {
+    slow_tasks_.Increment();
+    PW_LOG_WARN("Worker task took %u us, over its %u us budget",
+                static_cast<unsigned>(duration_us),
+                static_cast<unsigned>(ToMicroseconds(task_budget_)));
+  }
+
+  // Report throughput over the most recent whole second.
+  ++window_tasks_;
+  if (end - window_start_ >= std::chrono::seconds(1)) {
+    tasks_per_second_.Set(window_tasks_);
+    window_tasks_ = 0;
+    window_start_ = end;
+  }
+}
+
+uint32_t GenericInstrumentedWorker::task_time_bucket(size_t bucket) const {
+  switch (bucket) {
+    case 0:
+      return tasks_under_100us_.value();
+    case 1:
+      return tasks_under_1ms_.value();
+    case 2:
+      return tasks_under_10ms_.value();
+    case 3:
+      return tasks_under_100ms_.value();
+    case 4:
+      return tasks_over_100ms_.value();
+    default:
+      return 0;
+  }
+}
+
+}  // namespace sense::internal
@@ -0,0 +1,128 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_containers/inline_deque.h"
+#include "pw_function/function.h"
+#include "pw_metric/metric.h"
+#include "pw_sync/interrupt_spin_lock.h"
+#include "pw_sync/lock_annotations.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+namespace internal {
+
+/// A worker which measures the work it forwards to another worker. Callers
+/// should use `InstrumentedWorker` instead.
+///
+/// Work is held in a FIFO owned by this object, and the wrapped worker is
+/// given a thunk that runs the oldest item. This lets the thunk fit in the
+/// wrapped worker's inline function storage while still timing each item.
+/// The wrapped worker must run work in the order it was posted.
+class GenericInstrumentedWorker : public Worker {
+ public:
+  /// Upper bounds, in microseconds, of the task time histogram buckets. A
+  /// final bucket counts everything slower.
+  static constexpr std::array<uint32_t, 4> kBucketLimitsUs = {
+      100, 1'000, 10'000, 100'000};
+
+  static constexpr pw::chrono::SystemClock::duration kDefaultTaskBudget =
+      std::chrono::milliseconds(10);
+
+  GenericInstrumentedWorker(const GenericInstrumentedWorker&) = delete;
+  GenericInstrumentedWorker& operator=(const GenericInstrumentedWorker&) =
+      delete;
+
+  bool RunOnce(pw::Function<void()>&& work) final;
+
+  /// Sets the execution time above which a task is logged as slow.
+  void set_task_budget(pw::chrono::SystemClock::duration budget) {
+    task_budget_ = budget;
+  }
+
+  uint32_t posted() const { return posted_.value(); }
+  uint32_t dropped() const { return dropped_.value(); }
+  uint32_t completed() const { return completed_.value(); }
+  uint32_t slow_tasks() const { return slow_tasks_.value(); }
+  uint32_t queue_high_water_mark() const {
+    return queue_high_water_mark_.value();
+  }
+  uint32_t tasks_per_second() const { return tasks_per_second_.value(); }
+  uint32_t max_task_us() const { return max_task_us_.value(); }
+  uint32_t task_time_bucket(size_t bucket) const;
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+ protected:
+  GenericInstrumentedWorker(Worker& worker,
+                            pw::InlineDeque<pw::Function<void()>>& pending,
+                            pw::tokenizer::Token name);
+  ~GenericInstrumentedWorker() = default;
+
+ private:
+  void RunNext();
+  void RecordTask(pw::chrono::SystemClock::time_point start,
+                  pw::chrono::SystemClock::time_point end);
+
+  Worker* worker_;
+  pw::sync::InterruptSpinLock lock_;
+  pw::InlineDeque<pw::Function<void()>>* pending_ PW_GUARDED_BY(lock_);
+
+  // Only accessed from the wrapped worker's context.
+  pw::chrono::SystemClock::duration task_budget_ = kDefaultTaskBudget;
+  pw::chrono::SystemClock::time_point window_start_;
+  uint32_t window_tasks_ = 0;
+
+  PW_METRIC_GROUP(metrics_, "worker");
+  PW_METRIC(metrics_, posted_, "posted", 0u);
+  PW_METRIC(metrics_, dropped_, "dropped", 0u);
+  PW_METRIC(metrics_, completed_, "completed", 0u);
+  PW_METRIC(metrics_, slow_tasks_, "slow tasks", 0u);
+  PW_METRIC(metrics_, queue_high_water_mark_, "queue high water mark", 0u);
+  PW_METRIC(metrics_, tasks_per_second_, "tasks per second", 0u);
+  PW_METRIC(metrics_, max_task_us_, "max task us", 0u);
+  PW_METRIC(metrics_, tasks_under_100us_, "tasks under 100us", 0u);
+  PW_METRIC(metrics_, tasks_under_1ms_, "tasks under 1ms", 0u);
+  PW_METRIC(metrics_, tasks_under_10ms_, "tasks under 10ms", 0u);
+  PW_METRIC(metrics_, tasks_under_100ms_, "tasks under 100ms", 0u);
+  PW_METRIC(metrics_, tasks_over_100ms_, "tasks over 100ms", 0u);
+};
+
+}  // namespace internal
+
+/// Wraps a worker with queue depth, throughput and task time metrics, and logs
+/// any task which runs longer than its budget.
+///
+/// `kMaxPending` bounds the number of tasks which may be queued at once. It
+/// should not exceed the capacity of the wrapped worker's queue.
+template <size_t kMaxPending>
+class InstrumentedWorker final : public internal::GenericInstrumentedWorker {
+ public:
+  /// Creates a worker whose metric group is named by `name`, e.g.
+  /// `PW_METRIC_TOKEN("system worker")`.
+  InstrumentedWorker(Worker& worker, pw::tokenizer::Token name)
+      : GenericInstrumentedWorker(worker, pending_, name) {}
+
+ private:
+  pw::InlineDeque<pw::Function<void()>, kMaxPending> pending_;
+};
+
+}  // namespace sense
@@ -0,0 +1,148 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/worker/instrumented_worker.h"
+
+#include <chrono>
+#include <initializer_list>
+#include <utility>
+
+#include "modules/worker/test_worker.h"
+#include "pw_containers/vector.h"
+#include "pw_sync/binary_semaphore.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_thread/sleep.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+// Holds work until the test runs it, or drops it when closed.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (closed_ || work_.full()) {
+      return false;
+    }
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+  void set_closed(bool closed) { closed_ = closed; }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+  bool closed_ = false;
+};
+
+// Blocks until every task posted to `worker` so far has run and been recorded.
+void Flush(Worker& worker, Worker& test_worker) {
+  for (Worker* w : {&worker, &test_worker}) {
+    pw::sync::ThreadNotification notification;
+    // Retry while the queue is still full of earlier tasks.
+    while (!w->RunOnce([&notification]() { notification.release(); })) {
+      pw::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    notification.acquire();
+  }
+}
+
+TEST(InstrumentedWorkerTest, CountsTasksAndQueueDepth) {
+  TestWorker<> test_worker;
+  InstrumentedWorker<4> worker(test_worker, PW_METRIC_TOKEN("test worker"));
+  pw::sync::BinarySemaphore pause;
+  int runs = 0;
+
+  worker.RunOnce([&pause]() { pause.acquire(); });
+  worker.RunOnce([&runs]() { ++runs; });
+  worker.RunOnce([&runs]() { ++runs; });
+  pause.release();
+  Flush(worker, test_worker);
+
+  EXPECT_EQ(runs, 2);
+  EXPECT_EQ(worker.posted(), 4u);
+  EXPECT_EQ(worker.completed(), 4u);
+  EXPECT_EQ(worker.dropped(), 0u);
+  EXPECT_GE(worker.queue_high_water_mark(), 3u);
+  test_worker.Stop();
+}
+
+TEST(InstrumentedWorkerTest, DropsWhenFull) {
+  TestWorker<> test_worker;
+  InstrumentedWorker<2> worker(test_worker, PW_METRIC_TOKEN("test worker"));
+  pw::sync::BinarySemaphore pause;
+  pw::sync::BinarySemaphore started;
+
+  worker.RunOnce([&pause, &started]() {
+    started.release();
+    pause.acquire();
+  });
+  started.acquire();
+  worker.RunOnce([]() {});
+  worker.RunOnce([]() {});
+  worker.RunOnce([]() {});
+  EXPECT_EQ(worker.dropped(), 1u);
+
+  pause.release();
+  Flush(worker, test_worker);
+  test_worker.Stop();
+}
+
+TEST(InstrumentedWorkerTest, RollsBackWhenWrappedWorkerDrops) {
+  ManualWorker inner;
+  InstrumentedWorker<1> worker(inner, PW_METRIC_TOKEN("test worker"));
+  int runs = 0;
+
+  inner.set_closed(true);
+  EXPECT_FALSE(worker.RunOnce([&runs]() { ++runs; }));
+  EXPECT_EQ(worker.dropped(), 1u);
+  EXPECT_EQ(worker.posted(), 0u);
+
+  // The dropped task does not hold the only slot.
+  inner.set_closed(false);
+  EXPECT_TRUE(worker.RunOnce([&runs]() { runs += 10; }));
+  inner.RunAll();
+  EXPECT_EQ(runs, 10);
+  EXPECT_EQ(worker.completed(), 1u);
+}
+
+TEST(InstrumentedWorkerTest, RecordsSlowTasks) {
+  TestWorker<> test_worker;
+  InstrumentedWorker<4> worker(test_worker, PW_METRIC_TOKEN("test worker"));
+  worker.set_task_budget(std::chrono::milliseconds(1));
+
+  worker.RunOnce([]() {});
+  worker.RunOnce(
+      []() { pw::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+  Flush(worker, test_worker);
+
+  EXPECT_EQ(worker.slow_tasks(), 1u);
+  EXPECT_GE(worker.max_task_us(), 5'000u);
+  uint32_t total = 0;
+  for (size_t i = 0; i <= worker.kBucketLimitsUs.size(); ++i) {
+    total += worker.task_time_bucket(i);
+  }
+  EXPECT_EQ(total, worker.completed());
+  test_worker.Stop();
+}
+
+}  // namespace
+}  // namespace sense
@@ -0,0 +1,156 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "WATCHDOG"
+
+#include "modules/worker/latency_watchdog.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#include "modules/log_policy/deferred_log.h"
+#include "pw_assert/check.h"
+#include "pw_log/log.h"
+
+namespace sense {
+namespace {
+
+uint32_t ToMicroseconds(pw::chrono::SystemClock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<uint32_t>(std::clamp<int64_t>(us.count(), 0, UINT32_MAX));
+}
+
+}  // namespace
+
+LatencyWatchdog::LatencyWatchdog(Clock::duration period)
+    : period_(period), timer_([this](Clock::time_point) {
+        if (ProbeAll() && healthy_ != nullptr) {
+          healthy_();
+        }
+        timer_.InvokeAfter(period_);
+      }) {}
+
+pw::Status LatencyWatchdog::Watch(Worker& worker,
+                                  pw::tokenizer::Token name,
+                                  Clock::duration slo) {
+  if (num_probes_ == kMaxWorkers) {
+    return pw::Status::ResourceExhausted();
+  }
+  Probe& probe = probes_[num_probes_++].emplace(worker, name, slo);
+  metrics_.Add(probe.metrics_);
+  return pw::OkStatus();
+}
+
+void LatencyWatchdog::Start(HealthyCallback&& healthy) {
+  healthy_ = std::move(healthy);
+  timer_.InvokeAfter(period_);
+}
+
+bool LatencyWatchdog::ProbeAll() {
+  bool finished = true;
+  for (size_t i = 0; i < num_probes_; ++i) {
+    finished &= probes_[i]->Post();
+  }
+  return finished;
+}
+
+uint32_t LatencyWatchdog::percentile_us(size_t worker,
+                                        uint32_t percentile) const {
+  PW_CHECK_UINT_LT(worker, num_probes_);
+  return probes_[worker]->Percentile(percentile);
+}
+
+uint32_t LatencyWatchdog::probes(size_t worker) const {
+  PW_CHECK_UINT_LT(worker, num_probes_);
+  return probes_[worker]->probes_.value();
+}
+
+uint32_t LatencyWatchdog::breaches(size_t worker) const {
+  PW_CHECK_UINT_LT(worker, num_probes_);
+  return probes_[worker]->breaches_.value();
+}
+
+uint32_t LatencyWatchdog::stalls(size_t worker) const {
+  PW_CHECK_UINT_LT(worker, num_probes_);
+  return probes_[worker]->stalls_.value();
+}
+
+bool LatencyWatchdog::Probe::Post() {
+  if (outstanding_.exchange(true, std::memory_order_acquire)) {
+    // Leave the waiting probe in place so that it measures how long the
+    // worker was stuck.
+    stalls_.Increment();
+    SENSE_LOG_DEFERRED(PW_LOG_WARN,
+                       "Worker " PW_TOKEN_FMT() " has not run its probe",
+                       name_);
+    return false;
+  }
+  posted_ = Clock::now();
+  if (!worker_.RunOnce([this] { Record(Clock::now()); })) {
+    // The probe never reached the queue, so nothing will clear the flag. Try
+    // again next round, but count this one as a stall.
+    outstanding_.store(false, std::memory_order_relaxed);
+    stalls_.Increment();
+    SENSE_LOG_DEFERRED(PW_LOG_WARN,
+                       "Worker " PW_TOKEN_FMT() " rejected its probe",
+                       name_);
+    return false;
+  }
+  return true;
+}
+
+void LatencyWatchdog::Probe::Record(Clock::time_point now) {
+  const Clock::duration latency = now - posted_;
+  outstanding_.store(false, std::memory_order_release);
+
+  const uint32_t latency_us = ToMicroseconds(latency);
+  const size_t bucket =
+      std::min<size_t>(std::bit_width(latency_us), kBuckets - 1);
+  ++histogram_[bucket];
+  ++total_;
+
+  probes_.Increment();
+  max_us_.Set(std::max(max_us_.value(), latency_us));
+  p50_us_.Set(Percentile(50));
+  p90_us_.Set(Percentile(90));
+  p99_us_.Set(Percentile(99));
+
+  if (latency > slo_) {
+    breaches_.Increment();
+    SENSE_LOG_DEFERRED(PW_LOG_WARN,
+                       "Worker " PW_TOKEN_FMT() " missed its SLO: %u us",
+                       name_,
+                       latency_us);
+  }
+}
+
+uint32_t LatencyWatchdog::Probe::Percentile(uint32_t percentile) const {
+  if (total_ == 0) {
+    return 0;
+  }
+  // Rank of the sample at the percentile, rounded up.
+  const uint64_t rank =
+      (static_cast<uint64_t>(total_) * percentile + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < kBuckets - 1; ++bucket) {
+    seen += histogram_[bucket];
+    if (seen >= rank) {
+      return std::min(uint32_t{1} << bucket, max_us_.value());
+    }
+  }
+  return max_us_.value();
+}
+
+}  // namespace sense
@@ -0,0 +1,132 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "modules/worker/worker.h"
+#include "pw_chrono/system_clock.h"
+#include "pw_chrono/system_timer.h"
+#include "pw_function/function.h"
+#include "pw_metric/metric.h"
+#include "pw_status/status.h"
+#include "pw_tokenizer/tokenize.h"
+
+namespace sense {
+
+/// Measures how long work waits on each watched worker before it runs.
+///
+/// Every period, a timestamped probe is posted to each worker. The time from
+/// posting to running is kept in a histogram, from which percentiles are
+/// reported as metrics. A probe that waits longer than its worker's SLO is a
+/// breach, and one that has not run by the next period is a stall; both are
+/// logged. Rounds in which every worker ran its last probe are reported as
+/// healthy, e.g. to feed a hardware watchdog.
+class LatencyWatchdog {
+ public:
+  using Clock = pw::chrono::SystemClock;
+
+  static constexpr size_t kMaxWorkers = 4;
+
+  /// Histogram bucket `i` counts latencies below 2^i microseconds that did
+  /// not fit an earlier bucket. The last bucket counts everything slower.
+  static constexpr size_t kBuckets = 22;
+
+  static constexpr Clock::duration kDefaultPeriod = std::chrono::seconds(1);
+
+  /// Called from the timer after each healthy round.
+  using HealthyCallback = pw::Function<void()>;
+
+  explicit LatencyWatchdog(Clock::duration period = kDefaultPeriod);
+
+  LatencyWatchdog(const LatencyWatchdog&) = delete;
+  LatencyWatchdog& operator=(const LatencyWatchdog&) = delete;
+
+  /// Probes `worker`, whose metric group is named by `name`. Probes waiting
+  /// longer than `slo` are breaches. Must be called before `Start`.
+  pw::Status Watch(Worker& worker,
+                   pw::tokenizer::Token name,
+                   Clock::duration slo);
+
+  /// Probes the watched workers every period.
+  void Start(HealthyCallback&& healthy = nullptr);
+
+  /// Posts a round of probes and returns whether the previous round has
+  /// finished. Called by the timer once started.
+  bool ProbeAll();
+
+  /// Upper bound of the given latency percentile of a watched worker, in
+  /// microseconds, or zero before any probe has run.
+  uint32_t percentile_us(size_t worker, uint32_t percentile) const;
+
+  uint32_t probes(size_t worker) const;
+  uint32_t breaches(size_t worker) const;
+  uint32_t stalls(size_t worker) const;
+
+  pw::metric::Group& metrics() { return metrics_; }
+
+ private:
+  class Probe {
+   public:
+    Probe(Worker& worker, pw::tokenizer::Token name, Clock::duration slo)
+        : worker_(worker), name_(name), slo_(slo), metrics_(name) {}
+
+    // Posts a probe unless the last one is still waiting. Returns false if
+    // it is, or if the worker rejects the probe.
+    bool Post();
+
+    uint32_t Percentile(uint32_t percentile) const;
+
+   private:
+    friend class LatencyWatchdog;
+
+    void Record(Clock::time_point now);
+
+    Worker& worker_;
+    const pw::tokenizer::Token name_;
+    const Clock::duration slo_;
+
+    std::atomic<bool> outstanding_ = false;
+    Clock::time_point posted_;
+
+    // Only written from the worker.
+    std::array<uint32_t, kBuckets> histogram_ = {};
+    uint32_t total_ = 0;
+
+    pw::metric::Group metrics_;
+    PW_METRIC(metrics_, probes_, "probes", 0u);
+    PW_METRIC(metrics_, breaches_, "slo breaches", 0u);
+    PW_METRIC(metrics_, stalls_, "stalls", 0u);
+    PW_METRIC(metrics_, max_us_, "max latency us", 0u);
+    PW_METRIC(metrics_, p50_us_, "p50 latency us", 0u);
+    PW_METRIC(metrics_, p90_us_, "p90 latency us", 0u);
+    PW_METRIC(metrics_, p99_us_, "p99 latency us", 0u);
+  };
+
+  const Clock::duration period_;
+  pw::chrono::SystemTimer timer_;
+  HealthyCallback healthy_;
+
+  std::array<std::optional<Probe>, kMaxWorkers> probes_;
+  size_t num_probes_ = 0;
+
+  PW_METRIC_GROUP(metrics_, "latency watchdog");
+};
+
+}  // namespace sense
@@ -0,0 +1,167 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/worker/latency_watchdog.h"
+
+#include <chrono>
+#include <utility>
+
+#include "pw_containers/vector.h"
+#include "pw_thread/sleep.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+using namespace std::literals::chrono_literals;
+
+// Holds work until the test runs it, or rejects it like a full queue.
+class ManualWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (rejecting_) {
+      return false;
+    }
+    work_.push_back(std::move(work));
+    return true;
+  }
+
+  void set_rejecting(bool rejecting) { rejecting_ = rejecting; }
+
+  size_t pending() const { return work_.size(); }
+
+  void RunAll() {
+    for (size_t i = 0; i < work_.size(); ++i) {
+      work_[i]();
+    }
+    work_.clear();
+  }
+
+ private:
+  pw::Vector<pw::Function<void()>, 4> work_;
+  bool rejecting_ = false;
+};
+
+TEST(LatencyWatchdogTest, RecordsProbes) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+            pw::OkStatus());
+  EXPECT_EQ(watchdog.percentile_us(0, 50), 0u);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(watchdog.ProbeAll());
+    EXPECT_EQ(worker.pending(), 1u);
+    worker.RunAll();
+  }
+  EXPECT_EQ(watchdog.probes(0), 3u);
+  EXPECT_EQ(watchdog.breaches(0), 0u);
+  EXPECT_EQ(watchdog.stalls(0), 0u);
+}
+
+TEST(LatencyWatchdogTest, SlowProbeBreachesSlo) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1ms),
+            pw::OkStatus());
+
+  EXPECT_TRUE(watchdog.ProbeAll());
+  pw::this_thread::sleep_for(5ms);
+  worker.RunAll();
+  EXPECT_EQ(watchdog.breaches(0), 1u);
+  EXPECT_GE(watchdog.percentile_us(0, 99), 5'000u);
+}
+
+TEST(LatencyWatchdogTest, StalledWorkerIsNotProbedAgain) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+            pw::OkStatus());
+
+  EXPECT_TRUE(watchdog.ProbeAll());
+  EXPECT_FALSE(watchdog.ProbeAll());
+  EXPECT_FALSE(watchdog.ProbeAll());
+  EXPECT_EQ(watchdog.stalls(0), 2u);
+  EXPECT_EQ(worker.pending(), 1u);
+
+  worker.RunAll();
+  EXPECT_EQ(watchdog.probes(0), 1u);
+  EXPECT_TRUE(watchdog.ProbeAll());
+}
+
+TEST(LatencyWatchdogTest, RejectedProbeIsRetriedNextRound) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+            pw::OkStatus());
+
+  worker.set_rejecting(true);
+  EXPECT_FALSE(watchdog.ProbeAll());
+  EXPECT_EQ(watchdog.stalls(0), 1u);
+
+  worker.set_rejecting(false);
+  EXPECT_TRUE(watchdog.ProbeAll());
+  EXPECT_EQ(worker.pending(), 1u);
+  worker.RunAll();
+  EXPECT_EQ(watchdog.probes(0), 1u);
+  EXPECT_TRUE(watchdog.ProbeAll());
+  EXPECT_EQ(watchdog.stalls(0), 1u);
+}
+
+TEST(LatencyWatchdogTest, RoundFinishesOnlyWhenEveryWorkerRan) {
+  ManualWorker fast;
+  ManualWorker slow;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(fast, PW_METRIC_TOKEN("fast"), 1s), pw::OkStatus());
+  ASSERT_EQ(watchdog.Watch(slow, PW_METRIC_TOKEN("slow"), 1s), pw::OkStatus());
+
+  EXPECT_TRUE(watchdog.ProbeAll());
+  fast.RunAll();
+  EXPECT_FALSE(watchdog.ProbeAll());
+  EXPECT_EQ(watchdog.stalls(0), 0u);
+  EXPECT_EQ(watchdog.stalls(1), 1u);
+}
+
+TEST(LatencyWatchdogTest, PercentilesUseBucketBounds) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  ASSERT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+            pw::OkStatus());
+
+  // Nine fast probes and one slow one.
+  for (int i = 0; i < 9; ++i) {
+    EXPECT_TRUE(watchdog.ProbeAll());
+    worker.RunAll();
+  }
+  EXPECT_TRUE(watchdog.ProbeAll());
+  pw::this_thread::sleep_for(20ms);
+  worker.RunAll();
+
+  EXPECT_LT(watchdog.percentile_us(0, 50), 20'000u);
+  EXPECT_GE(watchdog.percentile_us(0, 99), 20'000u);
+}
+
+TEST(LatencyWatchdogTest, WatchesLimitedNumberOfWorkers) {
+  ManualWorker worker;
+  LatencyWatchdog watchdog;
+  for (size_t i = 0; i < LatencyWatchdog::kMaxWorkers; ++i) {
+    EXPECT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+              pw::OkStatus());
+  }
+  EXPECT_EQ(watchdog.Watch(worker, PW_METRIC_TOKEN("test"), 1s),
+            pw::Status::ResourceExhausted());
+}
+
+}  // namespace
+}  // namespace sense
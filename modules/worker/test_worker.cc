@@ -25,11 +25,11 @@ void GenericTestWorker::Start() {
   work_thread_ = pw::thread::Thread(context_.options(), *work_queue_);
 }
 
-void GenericTestWorker::RunOnce(pw::Function<void()>&& work) {
+bool GenericTestWorker::RunOnce(pw::Function<void()>&& work) {
   // TODO: CHECK-ing this error causes flakes in the state manager tests due to
   // their repeated use of the work queue. Investigate whether that can be
   // resolved.
-  work_queue_->PushWork(std::move(work)).IgnoreError();
+  return work_queue_->PushWork(std::move(work)).ok();
 }
 
 GenericTestWorker::~GenericTestWorker() {
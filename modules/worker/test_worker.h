@@ -38,7 +38,7 @@ class GenericTestWorker : public Worker {
 
   void Start();
 
-  void RunOnce(pw::Function<void()>&& work) final;
+  bool RunOnce(pw::Function<void()>&& work) final;
 
   // Stops the work queue. This method MUST be called before leaving the test
   // body. Otherwise, the work queue may reference objects that have gone out of
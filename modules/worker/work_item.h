@@ -0,0 +1,72 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <atomic>
+
+#include "modules/worker/worker.h"
+#include "pw_function/function.h"
+
+namespace sense {
+
+/// A unit of work owned by a component and posted to a `Worker` repeatedly.
+///
+/// The work function is set once when the item is constructed, so posting it
+/// never builds a new closure. At most one post of an item is pending at a
+/// time: posting an item that has not yet run is a no-op. Periodic tasks that
+/// use a `WorkItem` therefore take at most one work queue slot each.
+///
+/// The item is marked as no longer pending just before its function runs, so
+/// posting it from within that function, or while it runs, schedules it again.
+///
+/// `Post` may be called from any thread, but not from an interrupt unless the
+/// worker supports that.
+class WorkItem {
+ public:
+  explicit WorkItem(pw::Function<void()>&& work) : work_(std::move(work)) {}
+
+  WorkItem(const WorkItem&) = delete;
+  WorkItem& operator=(const WorkItem&) = delete;
+
+  /// Schedules the item to run on `worker`. Returns false if the item was
+  /// already pending, in which case it is not scheduled again, or if the
+  /// worker dropped it, in which case it is left idle so a later post can
+  /// retry.
+  bool Post(Worker& worker) {
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+      return false;
+    }
+    // The thunk only captures `this`, so it always fits in the inline storage
+    // of the worker's `pw::Function`.
+    if (!worker.RunOnce([this]() { Run(); })) {
+      pending_.store(false, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  /// Returns whether the item has been posted and has not started running.
+  bool pending() const { return pending_.load(std::memory_order_acquire); }
+
+ private:
+  void Run() {
+    pending_.store(false, std::memory_order_release);
+    work_();
+  }
+
+  pw::Function<void()> work_;
+  std::atomic<bool> pending_ = false;
+};
+
+}  // namespace sense
@@ -0,0 +1,114 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/worker/work_item.h"
+
+#include "modules/worker/test_worker.h"
+#include "pw_sync/binary_semaphore.h"
+#include "pw_sync/thread_notification.h"
+#include "pw_unit_test/framework.h"
+
+namespace sense {
+namespace {
+
+/// Worker which runs work inline, or drops it when closed.
+class InlineWorker final : public Worker {
+ public:
+  bool RunOnce(pw::Function<void()>&& work) override {
+    if (closed_) {
+      return false;
+    }
+    work();
+    return true;
+  }
+
+  void set_closed(bool closed) { closed_ = closed; }
+
+ private:
+  bool closed_ = false;
+};
+
+TEST(WorkItemTest, PostRunsWork) {
+  TestWorker<> worker;
+  pw::sync::ThreadNotification notification;
+  WorkItem item([&notification]() { notification.release(); });
+
+  EXPECT_TRUE(item.Post(worker));
+  notification.acquire();
+  EXPECT_FALSE(item.pending());
+  worker.Stop();
+}
+
+TEST(WorkItemTest, PostWhilePendingIsNoOp) {
+  TestWorker<> worker;
+  pw::sync::BinarySemaphore pause;
+  pw::sync::ThreadNotification notification;
+  int runs = 0;
+  WorkItem item([&runs]() { ++runs; });
+
+  // Block the worker so the item stays pending.
+  worker.RunOnce([&pause]() { pause.acquire(); });
+  EXPECT_TRUE(item.Post(worker));
+  EXPECT_FALSE(item.Post(worker));
+  EXPECT_FALSE(item.Post(worker));
+  EXPECT_TRUE(item.pending());
+
+  pause.release();
+  worker.RunOnce([&notification]() { notification.release(); });
+  notification.acquire();
+  EXPECT_EQ(runs, 1);
+  worker.Stop();
+}
+
+TEST(WorkItemTest, RepostFromWorkRunsAgain) {
+  TestWorker<> worker;
+  struct {
+    WorkItem* item = nullptr;
+    Worker* worker = nullptr;
+    int runs = 0;
+    pw::sync::ThreadNotification done;
+  } context;
+  WorkItem item([&context]() {
+    if (++context.runs < 3) {
+      EXPECT_TRUE(context.item->Post(*context.worker));
+    } else {
+      context.done.release();
+    }
+  });
+  context.item = &item;
+  context.worker = &worker;
+
+  EXPECT_TRUE(item.Post(worker));
+  context.done.acquire();
+  EXPECT_EQ(context.runs, 3);
+  worker.Stop();
+}
+
+TEST(WorkItemTest, DroppedPostCanBeRetried) {
+  InlineWorker worker;
+  int runs = 0;
+  WorkItem item([&runs]() { ++runs; });
+
+  worker.set_closed(true);
+  EXPECT_FALSE(item.Post(worker));
+  EXPECT_FALSE(item.pending());
+  EXPECT_EQ(runs, 0);
+
+  worker.set_closed(false);
+  EXPECT_TRUE(item.Post(worker));
+  EXPECT_EQ(runs, 1);
+}
+
+}  // namespace
+}  // namespace sense
@@ -12,21 +12,24 @@
 // License for the specific language governing permissions and limitations under
 // the License.
 
-#include "apps/production/threads.h"
-#include "pw_thread_freertos/context.h"
-#include "pw_thread_freertos/options.h"
+#include "modules/worker/work_queue_worker.h"
+
+#include "pw_log/log.h"
+#include "pw_thread/detached_thread.h"
 
 namespace sense {
 
-pw::thread::freertos::StaticContextWithStack<1024> sensor_thread_context;
+void WorkQueueWorker::Start(const pw::thread::Options& options) {
+  pw::thread::DetachedThread(options, *work_queue_);
+}
 
-const pw::thread::Options& SamplingThreadOptions() {
-  static constexpr auto kOptions =
-      pw::thread::freertos::Options()
-          .set_name("SensorThread")
-          .set_static_context(sensor_thread_context)
-          .set_priority(tskIDLE_PRIORITY + 1);
-  return kOptions;
+bool WorkQueueWorker::RunOnce(pw::Function<void()>&& work) {
+  if (const pw::Status status = work_queue_->PushWork(std::move(work));
+      !status.ok()) {
+    PW_LOG_ERROR("Unable to schedule work on work queue: %s", status.str());
+    return false;
+  }
+  return true;
 }
 
 }  // namespace sense
@@ -0,0 +1,59 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+
+#include "modules/worker/worker.h"
+#include "pw_function/function.h"
+#include "pw_thread/thread.h"
+#include "pw_work_queue/work_queue.h"
+
+namespace sense {
+
+/// A worker which runs work on a dedicated work queue thread.
+///
+/// Several of these can run at different thread priorities, so that
+/// latency-sensitive work is not queued behind slower work.
+class WorkQueueWorker : public Worker {
+ public:
+  explicit WorkQueueWorker(pw::work_queue::WorkQueue& work_queue)
+      : work_queue_(&work_queue) {}
+
+  WorkQueueWorker(const WorkQueueWorker&) = delete;
+  WorkQueueWorker& operator=(const WorkQueueWorker&) = delete;
+
+  /// Starts the thread which runs the work queue. Must be called once.
+  void Start(const pw::thread::Options& options);
+
+  bool RunOnce(pw::Function<void()>&& work) final;
+
+ protected:
+  ~WorkQueueWorker() = default;
+
+ private:
+  pw::work_queue::WorkQueue* work_queue_;
+};
+
+/// `WorkQueueWorker` with its own work queue storage.
+template <size_t kBufferSize>
+class WorkQueueWorkerWithBuffer final : public WorkQueueWorker {
+ public:
+  WorkQueueWorkerWithBuffer() : WorkQueueWorker(work_queue_) {}
+
+ private:
+  pw::work_queue::WorkQueueWithBuffer<kBufferSize> work_queue_;
+};
+
+}  // namespace sense
@@ -23,7 +23,10 @@ namespace sense {
 class Worker {
  public:
   /// Ambiently execute a function.
-  virtual void RunOnce(pw::Function<void()>&& work) = 0;
+  ///
+  /// Returns false if the work could not be queued, in which case it is
+  /// dropped and will never run.
+  virtual bool RunOnce(pw::Function<void()>&& work) = 0;
 
  protected:
   ~Worker() = default;
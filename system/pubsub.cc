@@ -19,10 +19,12 @@
 namespace sense::system {
 
 sense::PubSub& PubSub() {
-  constexpr size_t kMaxEvents = 20;
-  constexpr size_t kMaxSubscribers = 10;
-  static GenericPubSubBuffer<Event, kMaxEvents, kMaxSubscribers> pubsub(
-      GetWorker());
+  static ControlPubSubBuffer pubsub(GetWorker());
+  return pubsub;
+}
+
+sense::PubSub& SensorPubSub() {
+  static SensorPubSubBuffer pubsub(GetWorker());
   return pubsub;
 }
 
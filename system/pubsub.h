@@ -17,6 +17,15 @@
 
 namespace sense::system {
 
+/// The control bus: user input, timers, state changes, and the sensor
+/// readings that drive them.
 PubSub& PubSub();
 
+/// The sensor-data bus, which the sampling thread publishes readings to.
+///
+/// Data consumers such as history and telemetry subscribe here, so that they
+/// do not share a queue, lock or subscriber table with control traffic. Apps
+/// bridge the readings that control subscribers need onto `PubSub()`.
+PubSub& SensorPubSub();
+
 }  // namespace sense::system
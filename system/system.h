@@ -16,10 +16,15 @@
 #include "modules/air_sensor/air_sensor.h"
 #include "modules/board/board.h"
 #include "modules/buttons/manager.h"
+#include "modules/config/config_store.h"
+#include "modules/cpu_usage/cpu_usage.h"
+#include "modules/energy/energy_meter.h"
 #include "modules/led/monochrome_led.h"
 #include "modules/led/polychrome_led.h"
 #include "modules/light/sensor.h"
+#include "modules/light_and_proximity/sensor.h"
 #include "modules/proximity/sensor.h"
+#include "modules/uplink/radio.h"
 
 // The functions in this file return specific implementations of singleton types
 // provided by the system.
@@ -38,6 +43,9 @@ ProximitySensor& ProximitySensor();
 
 AmbientLightSensor& AmbientLightSensor();
 
+/// Reads `AmbientLightSensor` and `ProximitySensor` together.
+LightAndProximitySensor& LightAndProximitySensor();
+
 Board& Board();
 
 ButtonManager& ButtonManager();
@@ -46,4 +54,23 @@ MonochromeLed& MonochromeLed();
 
 PolychromeLed& PolychromeLed();
 
+/// Radio for `Uplink`, or null if the board has none.
+sense::Radio* Radio();
+
+/// Settings that survive a reboot. Only kept in RAM on targets without
+/// persistent storage.
+sense::ConfigStore& ConfigStore();
+
+/// Per-thread CPU counters, or null if the RTOS does not keep them.
+sense::CpuCounterSource* CpuCounterSource();
+
+/// Estimates the board's charge per subsystem, or null if the target has no
+/// current model. Must be started on the system worker, which drives the LED.
+sense::EnergyMeter* EnergyMeter();
+
+/// Restarts the hardware watchdog's countdown, enabling it on the first call.
+/// The device resets if the watchdog is not fed again within its timeout.
+/// Does nothing on targets without one or where it is disabled.
+void FeedHardwareWatchdog();
+
 }  // namespace sense::system
@@ -14,7 +14,12 @@
 
 #include "system/worker.h"
 
+#include <chrono>
+
+#include "modules/worker/instrumented_worker.h"
+#include "modules/worker/work_queue_worker.h"
 #include "pw_log/log.h"
+#include "pw_metric/global.h"
 #include "pw_system/system.h"
 
 namespace sense::system {
@@ -23,17 +28,55 @@ namespace internal {
 /// A worker which delegates work to `pw::System`.
 class SystemWorker final : public Worker {
  public:
-  void RunOnce(pw::Function<void()>&& work) override {
+  bool RunOnce(pw::Function<void()>&& work) override {
     if (!pw::System().RunOnce(std::move(work))) {
       PW_LOG_ERROR("Unable to schedule work on system worker.");
+      return false;
     }
+    return true;
   }
 };
 
+// Tasks which may be queued on each worker at once.
+constexpr size_t kMaxPendingTasks = 16;
+
 }  // namespace internal
 
-Worker& GetWorker() {
-  static internal::SystemWorker worker;
+Worker& GetWorker(LatencyClass latency) {
+  if (latency == LatencyClass::kInteractive) {
+    static WorkQueueWorkerWithBuffer<internal::kMaxPendingTasks> work_queue;
+    static InstrumentedWorker<internal::kMaxPendingTasks> interactive_worker(
+        work_queue, PW_METRIC_TOKEN("interactive worker"));
+    [[maybe_unused]] static const bool started = [] {
+      work_queue.Start(InteractiveWorkerThreadOptions());
+      pw::metric::global_groups.push_back(interactive_worker.metrics());
+      return true;
+    }();
+    return interactive_worker;
+  }
+
+  if (latency == LatencyClass::kBlocking) {
+    static WorkQueueWorkerWithBuffer<internal::kMaxPendingTasks> work_queue;
+    static InstrumentedWorker<internal::kMaxPendingTasks> blocking_worker(
+        work_queue, PW_METRIC_TOKEN("blocking worker"));
+    [[maybe_unused]] static const bool started = [] {
+      // Blocking work is expected to be slow, so only log tasks that hold the
+      // queue for much longer than usual.
+      blocking_worker.set_task_budget(std::chrono::milliseconds(500));
+      work_queue.Start(BlockingWorkerThreadOptions());
+      pw::metric::global_groups.push_back(blocking_worker.metrics());
+      return true;
+    }();
+    return blocking_worker;
+  }
+
+  static internal::SystemWorker system_worker;
+  static InstrumentedWorker<internal::kMaxPendingTasks> worker(
+      system_worker, PW_METRIC_TOKEN("system worker"));
+  [[maybe_unused]] static const bool registered = [] {
+    pw::metric::global_groups.push_back(worker.metrics());
+    return true;
+  }();
   return worker;
 }
 
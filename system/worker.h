@@ -14,10 +14,35 @@
 #pragma once
 
 #include "modules/worker/worker.h"
+#include "pw_thread/thread.h"
 
 namespace sense::system {
 
-/// Returns a worker which delegates work to `pw::System`.
-Worker& GetWorker();
+/// Latency requirements a component can request for its work.
+enum class LatencyClass {
+  /// Runs on the `pw::System` work queue, shared with PubSub dispatch and RPC
+  /// stream writes.
+  kDefault,
+
+  /// Runs on a dedicated, higher-priority work queue. Use this for short,
+  /// timing-sensitive work such as button debouncing and Morse playback.
+  kInteractive,
+
+  /// Runs on a dedicated, low-priority work queue. Use this for work that may
+  /// block for a while, such as RPC handlers that wait on a sensor, so that it
+  /// does not hold up RPC dispatch or the system work queue.
+  kBlocking,
+};
+
+/// Returns a worker for the requested latency class.
+Worker& GetWorker(LatencyClass latency = LatencyClass::kDefault);
+
+/// Thread options for the `LatencyClass::kInteractive` work queue. Must be
+/// implemented by the target.
+const pw::thread::Options& InteractiveWorkerThreadOptions();
+
+/// Thread options for the `LatencyClass::kBlocking` work queue. Must be
+/// implemented by the target.
+const pw::thread::Options& BlockingWorkerThreadOptions();
 
 }  // namespace sense::system
@@ -16,6 +16,7 @@
 
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "modules/air_sensor/air_sensor_fake.h"
 #include "modules/board/board_fake.h"
@@ -28,6 +29,15 @@
 #include "pw_system/io.h"
 #include "pw_system/system.h"
 #include "pw_thread_stl/options.h"
+#include "system/worker.h"
+
+#ifndef SENSE_SOCKET_SERVER
+#define SENSE_SOCKET_SERVER 0
+#endif  // SENSE_SOCKET_SERVER
+
+#if SENSE_SOCKET_SERVER
+#include "modules/rpc_mux/socket_server.h"
+#endif  // SENSE_SOCKET_SERVER
 
 using ::pw::channel::StreamChannel;
 using ::pw::digital_io::DigitalIn;
@@ -86,15 +96,33 @@ void Start() {
   printf("where <app> is e.g. blinky, factory, or production, or launch\n");
   printf("one from VSCode under the 'Bazel Build Targets' explorer tab.\n");
   printf("\n");
+#if SENSE_SOCKET_SERVER
+  printf("Any number of consoles may be connected at once. Set\n");
+  printf("SENSE_SIMULATOR_SOCKET to also listen on a Unix socket.\n");
+  printf("\n");
+#endif  // SENSE_SOCKET_SERVER
   printf("Press Ctrl-C to exit\n");
 
+#if SENSE_SOCKET_SERVER
+  static sense::SocketServer server;
+  PW_CHECK_OK(server.Start({
+      .tcp_port = 33000,
+      .unix_socket_path = getenv("SENSE_SIMULATOR_SOCKET"),
+  }));
+  pw::stream::Reader& reader = server.reader();
+  pw::stream::Writer& writer = server.writer();
+#else
+  pw::stream::Reader& reader = pw::system::GetReader();
+  pw::stream::Writer& writer = pw::system::GetWriter();
+#endif  // SENSE_SOCKET_SERVER
+
   static std::byte channel_buffer[16384];
   static pw::multibuf::SimpleAllocator multibuf_alloc(channel_buffer,
                                                       pw::System().allocator());
   static pw::NoDestructor<StreamChannel> channel(multibuf_alloc,
-                                                 pw::system::GetReader(),
+                                                 reader,
                                                  pw::thread::stl::Options(),
-                                                 pw::system::GetWriter(),
+                                                 writer,
                                                  pw::thread::stl::Options());
 
   pw::SystemStart(*channel);
@@ -126,4 +154,37 @@ sense::ProximitySensor& ProximitySensor() {
   return fake_prox;
 }
 
+sense::LightAndProximitySensor& LightAndProximitySensor() {
+  static ::sense::SeparateLightAndProximitySensors sensors(
+      AmbientLightSensor(), ProximitySensor());
+  return sensors;
+}
+
+sense::Radio* Radio() { return nullptr; }
+
+sense::CpuCounterSource* CpuCounterSource() { return nullptr; }
+
+sense::EnergyMeter* EnergyMeter() { return nullptr; }
+
+void FeedHardwareWatchdog() {}
+
+sense::ConfigStore& ConfigStore() {
+  static sense::ConfigStore& store = []() -> sense::ConfigStore& {
+    static sense::ConfigStore config_store;
+    config_store.Init(GetWorker(LatencyClass::kBlocking));
+    return config_store;
+  }();
+  return store;
+}
+
+const pw::thread::Options& InteractiveWorkerThreadOptions() {
+  static constexpr pw::thread::stl::Options kOptions;
+  return kOptions;
+}
+
+const pw::thread::Options& BlockingWorkerThreadOptions() {
+  static constexpr pw::thread::stl::Options kOptions;
+  return kOptions;
+}
+
 }  // namespace sense::system
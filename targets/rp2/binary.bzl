@@ -23,7 +23,6 @@ load("@pigweed//targets/rp2040:transition.bzl", "RP2_SYSTEM_FLAGS")
 _COMMON_FLAGS = merge_flags_for_transition_impl(
     base = RP2_SYSTEM_FLAGS,
     override = {
-        "//apps/production:threads": "//targets/rp2:production_app_threads",
         "//system:system": "//targets/rp2:system",
         "@freertos//:freertos_config": "//targets/rp2:freertos_config",
         "@pico-sdk//bazel/config:PICO_CLIB": "llvm_libc",
@@ -37,7 +37,8 @@ extern uint32_t SystemCoreClock;
 
 #define configUSE_PREEMPTION                    1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
-#define configUSE_TICKLESS_IDLE                 0
+#define configUSE_TICKLESS_IDLE                 1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
 #define configCPU_CLOCK_HZ                      (SystemCoreClock)
 #define configTICK_RATE_HZ                      ((TickType_t)1000)
 #define configMAX_PRIORITIES                    5
@@ -57,6 +58,7 @@ extern uint32_t SystemCoreClock;
 #define configENABLE_BACKWARD_COMPATIBILITY     0
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
 #define configSTACK_DEPTH_TYPE                  uint32_t
+#define configRECORD_STACK_HIGH_ADDRESS         1
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
 #define configSUPPORT_STATIC_ALLOCATION         1
@@ -64,14 +66,37 @@ extern uint32_t SystemCoreClock;
 #define configTOTAL_HEAP_SIZE                   ((size_t)(1 * 1024))
 #define configAPPLICATION_ALLOCATED_HEAP        1
 
+// Tickless idle reports each sleep to the power manager in power.cc. Ticks are
+// milliseconds, so the expected idle time is passed through as is.
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+void SensePreSleepProcessing(uint32_t* expected_idle_ticks);
+void SensePostSleepProcessing(uint32_t* expected_idle_ticks);
+uint32_t SenseRunTimeCounter(void);
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#define configPRE_SLEEP_PROCESSING(x)           SensePreSleepProcessing(&(x))
+#define configPOST_SLEEP_PROCESSING(x)          SensePostSleepProcessing(&(x))
+
 #define configUSE_IDLE_HOOK                     0
 #define configUSE_TICK_HOOK                     0
-#define configCHECK_FOR_STACK_OVERFLOW          0
+// Checks the stack guard pattern on every context switch. The hook that
+// crashes on overflow comes from @pigweed//third_party/freertos:support.
+#define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-#define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_TRACE_FACILITY                0
+// Run time is counted in microseconds of the free-running hardware timer, so
+// it needs no setup. Each task's trace number counts the times it is switched
+// in. Both feed the CPU usage service through cpu_counters.cc.
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        SenseRunTimeCounter()
+#define traceTASK_SWITCHED_IN()                 (pxCurrentTCB->uxTaskNumber++)
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 #define configUSE_CO_ROUTINES                   0
@@ -103,7 +128,7 @@ extern uint32_t SystemCoreClock;
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
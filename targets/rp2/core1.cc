@@ -0,0 +1,88 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "targets/rp2/core1.h"
+
+#include <optional>
+
+#include "hardware/irq.h"
+#include "modules/pubsub/inter_core_queue.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "pw_assert/check.h"
+#include "pw_metric/global.h"
+#include "pw_metric/metric.h"
+#include "system/pubsub.h"
+
+namespace sense::system {
+namespace {
+
+constexpr size_t kMaxCore1Events = 16;
+
+InterCoreQueue<Event, kMaxCore1Events> core1_events;
+void (*core1_entry)() = nullptr;
+
+PW_METRIC_GROUP(core1_metrics, "core1");
+// Events from core 1 that the bus did not accept. Only written by the
+// doorbell handler.
+PW_METRIC(core1_metrics, core1_dropped, "dropped events", 0u);
+
+// Runs on core 0 whenever core 1 writes to the inter-core FIFO.
+void Core1DoorbellHandler() {
+  multicore_fifo_drain();
+  multicore_fifo_clear_irq();
+  while (std::optional<Event> event = core1_events.pop()) {
+    if (!PubSub().PublishFromInterrupt(*event)) {
+      core1_dropped.Increment();
+    }
+  }
+}
+
+void Core1Main() {
+  // Lets flash_safe_execute pause this core while core 0 writes flash.
+  flash_safe_execute_core_init();
+  core1_entry();
+  while (true) {
+    __wfe();
+  }
+}
+
+}  // namespace
+
+void LaunchCore1(void (*entry)()) {
+  PW_CHECK(core1_entry == nullptr, "Core 1 is already running");
+  core1_entry = entry;
+  pw::metric::global_groups.push_back(core1_metrics);
+  multicore_launch_core1(Core1Main);
+
+  // The launch handshake uses the FIFO, so only take its interrupt once it is
+  // done.
+  multicore_fifo_drain();
+  irq_set_exclusive_handler(SIO_FIFO_IRQ_NUM(0), Core1DoorbellHandler);
+  irq_set_enabled(SIO_FIFO_IRQ_NUM(0), true);
+}
+
+bool PublishFromCore1(const Event& event) {
+  if (!core1_events.push(event)) {
+    return false;
+  }
+  // The FIFO only rings the doorbell; its values are ignored. When it is full,
+  // core 0 has yet to handle an earlier ring, and will see this event too.
+  if (multicore_fifo_wready()) {
+    multicore_fifo_push_blocking(0);
+  }
+  return true;
+}
+
+}  // namespace sense::system
@@ -0,0 +1,32 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include "modules/pubsub/pubsub_events.h"
+
+namespace sense::system {
+
+/// Starts `entry` on the second core, outside of FreeRTOS.
+///
+/// Code on core 1 must not use FreeRTOS or anything built on it, including
+/// `InterruptSpinLock`, which only masks interrupts on the calling core. It
+/// may drive hardware that core 0 leaves alone and pass events to core 0 with
+/// `PublishFromCore1`. Flash writes on core 0 pause core 1 while they run.
+void LaunchCore1(void (*entry)());
+
+/// Queues an event for core 0 to publish. Must only be called from core 1.
+/// Returns false if the queue is full.
+bool PublishFromCore1(const Event& event);
+
+}  // namespace sense::system
@@ -0,0 +1,72 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "hardware/timer.h"
+#include "modules/cpu_usage/cpu_usage.h"
+#include "system/system.h"
+#include "task.h"
+
+// FreeRTOS reads this on every context switch to account run time.
+extern "C" uint32_t SenseRunTimeCounter(void) { return time_us_32(); }
+
+namespace sense::system {
+namespace {
+
+/// Reads FreeRTOS run-time stats. Context switches are counted in each task's
+/// trace number by `traceTASK_SWITCHED_IN` in FreeRTOSConfig.h.
+class FreeRtosCpuCounterSource final : public sense::CpuCounterSource {
+ private:
+  pw::StatusWithSize DoRead(pw::span<ThreadCpuCounters> threads) override {
+    // FreeRTOS fills nothing if the array is too small for every task.
+    if (uxTaskGetNumberOfTasks() > tasks_.size()) {
+      return pw::StatusWithSize::ResourceExhausted();
+    }
+    const size_t count =
+        uxTaskGetSystemState(tasks_.data(), tasks_.size(), nullptr);
+
+    size_t written = 0;
+    for (size_t i = 0; i < count && written < threads.size(); ++i) {
+      const TaskStatus_t& task = tasks_[i];
+      ThreadCpuCounters& thread = threads[written++];
+      thread.id = task.xTaskNumber;
+      std::strncpy(thread.name, task.pcTaskName, sizeof(thread.name) - 1);
+      thread.name[sizeof(thread.name) - 1] = '\0';
+      thread.idle = std::strcmp(task.pcTaskName, configIDLE_TASK_NAME) == 0;
+      thread.run_time = task.ulRunTimeCounter;
+      thread.context_switches = uxTaskGetTaskNumber(task.xHandle);
+    }
+    if (written < count) {
+      return pw::StatusWithSize::ResourceExhausted(written);
+    }
+    return pw::StatusWithSize(written);
+  }
+
+  // Room for a few more tasks than are tracked, so that the rest still
+  // report if more are added. Only used from the CPU usage tracker's worker.
+  std::array<TaskStatus_t, CpuUsageTracker::kMaxThreads + 4> tasks_;
+};
+
+}  // namespace
+
+sense::CpuCounterSource* CpuCounterSource() {
+  static FreeRtosCpuCounterSource source;
+  return &source;
+}
+
+}  // namespace sense::system
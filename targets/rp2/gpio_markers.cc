@@ -0,0 +1,53 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "modules/profiling/gpio_markers.h"
+
+#include <array>
+
+#include "hardware/gpio.h"
+#include "hardware/structs/sio.h"
+#include "targets/rp2/enviro_pins.h"
+
+namespace sense {
+namespace {
+
+// The Enviro's LCD header, which this firmware leaves unused. Listed in
+// `GpioMarker` order.
+constexpr std::array<unsigned int, kNumGpioMarkers> kMarkerPins = {
+    board::kEnviroLcdDc,
+    board::kEnviroLcdCs,
+    board::kEnviroLcdSclk,
+    board::kEnviroLcdMosi,
+    board::kEnviroBacklightEn,
+    board::kEnviroLcdVSync,
+};
+
+}  // namespace
+
+void InitGpioMarkers() {
+  for (unsigned int pin : kMarkerPins) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+    gpio_put(pin, false);
+  }
+}
+
+void ToggleGpioMarker(GpioMarker marker) {
+  // SIO writes are single-cycle and atomic, so this is safe from any core or
+  // interrupt.
+  sio_hw->gpio_togl = 1u << kMarkerPins[static_cast<size_t>(marker)];
+}
+
+}  // namespace sense
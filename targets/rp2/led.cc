@@ -13,6 +13,7 @@
 // the License.
 
 #include "device/pico_pwm_gpio.h"
+#include "device/pico_rgb_dma_stream.h"
 #include "modules/led/monochrome_led.h"
 #include "modules/led/polychrome_led.h"
 #include "pico/stdlib.h"
@@ -49,11 +50,22 @@ static constexpr pw::digital_io::Rp2040Config kBlueLedConfig = {
     .polarity = pw::digital_io::Polarity::kActiveLow,
 };
 
+// PWM slice that paces LED animations. Its pins are used by the buttons, so
+// its outputs are never enabled.
+static constexpr unsigned kLedPacingSlice = 7;
+
 sense::PolychromeLed& PolychromeLed() {
   static ::sense::PicoPwmGpio red_pwm(kRedLedConfig);
   static ::sense::PicoPwmGpio green_pwm(kGreenLedConfig);
   static ::sense::PicoPwmGpio blue_pwm(kBlueLedConfig);
-  static ::sense::PolychromeLed rgb_led(red_pwm, green_pwm, blue_pwm);
+  static ::sense::PicoRgbDmaStream level_stream(
+      kRedLedConfig, kGreenLedConfig, kBlueLedConfig, kLedPacingSlice);
+  static ::sense::PolychromeLed& rgb_led = []() -> ::sense::PolychromeLed& {
+    static ::sense::PolychromeLed led(red_pwm, green_pwm, blue_pwm);
+    led.UseLevelStream(level_stream);
+    led.UseWorker(GetWorker());
+    return led;
+  }();
   return rgb_led;
 }
 
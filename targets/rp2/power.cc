@@ -0,0 +1,49 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "targets/rp2/power.h"
+
+#include <cstdint>
+
+#include "modules/power/power_manager.h"
+#include "pico/time.h"
+#include "pw_metric/global.h"
+
+namespace sense::system {
+
+PowerManager& GetPowerManager() {
+  static PowerManager& power_manager = []() -> PowerManager& {
+    static PowerManager manager;
+    pw::metric::global_groups.push_back(manager.metrics());
+    return manager;
+  }();
+  return power_manager;
+}
+
+void InitPower() { GetPowerManager(); }
+
+}  // namespace sense::system
+
+// FreeRTOS calls these from the idle task with interrupts masked, just before
+// and just after executing WFI with the tick suppressed. The sleep is the
+// cheap kind that keeps every clock running, so the USB and UART transports
+// and the PWM, DMA and I2C interrupts all wake the CPU as usual.
+extern "C" void SensePreSleepProcessing(uint32_t* expected_idle_ticks) {
+  sense::system::GetPowerManager().BeginSleep(time_us_64(),
+                                              *expected_idle_ticks);
+}
+
+extern "C" void SensePostSleepProcessing(uint32_t*) {
+  sense::system::GetPowerManager().EndSleep(time_us_64());
+}
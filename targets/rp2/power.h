@@ -11,15 +11,20 @@
 // WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
 // License for the specific language governing permissions and limitations under
 // the License.
-
-#include "apps/production/threads.h"
-#include "pw_thread_stl/options.h"
+#pragma once
 
 namespace sense {
+class PowerManager;
+}  // namespace sense
 
-const pw::thread::Options& SamplingThreadOptions() {
-  static constexpr pw::thread::stl::Options kOptions;
-  return kOptions;
-}
+namespace sense::system {
 
-}  // namespace sense
+/// Starts accounting for idle sleep and registers the "power" metrics. Must be
+/// called before the scheduler starts so that the idle hooks never construct
+/// the power manager themselves.
+void InitPower();
+
+/// Returns the idle sleep accounting started by `InitPower`.
+PowerManager& GetPowerManager();
+
+}  // namespace sense::system
@@ -14,20 +14,36 @@
 
 #include "system/system.h"
 
+#include <tuple>
+
 #include "device/bme688.h"
 #include "device/ltr559_light_and_prox_sensor.h"
 #include "device/pico_board.h"
+#include "device/pico_digital_interrupt.h"
+#include "device/pico_dma_i2c.h"
+#include "device/pico_flash_memory.h"
+#include "device/pico_gpio_port.h"
+#include "device/pico_usb_cdc_channel.h"
 #include "hardware/adc.h"
 #include "hardware/exception.h"
+#include "hardware/watchdog.h"
 #include "modules/air_sensor/air_sensor.h"
+#include "modules/air_sensor/kvs_baseline_store.h"
 #include "modules/buttons/manager.h"
+#include "modules/energy/energy_meter.h"
+#include "modules/i2c/bus_arbiter.h"
+#include "modules/power/power_manager.h"
+#include "modules/profiling/gpio_markers.h"
 #include "pico/stdlib.h"
-#include "pw_channel/rp2_stdio_channel.h"
 #include "pw_cpu_exception/entry.h"
-#include "pw_digital_io_rp2040/digital_io.h"
-#include "pw_i2c_rp2040/initiator.h"
+#include "pw_kvs/crc16_checksum.h"
+#include "pw_kvs/flash_memory.h"
+#include "pw_kvs/key_value_store.h"
+#include "pw_metric/global.h"
 #include "pw_multibuf/simple_allocator.h"
 #include "pw_system/system.h"
+#include "pw_thread_freertos/context.h"
+#include "pw_thread_freertos/options.h"
 #if defined(PICO_RP2040) && PICO_RP2040
 #include "system_RP2040.h"
 #endif  // defined(PICO_RP2040) && PICO_RP2040
@@ -37,21 +53,41 @@
 #include "system/pubsub.h"
 #include "system/worker.h"
 #include "targets/rp2/enviro_pins.h"
+#include "targets/rp2/power.h"
+
+#ifndef SENSE_HAS_CYW43_RADIO
+#define SENSE_HAS_CYW43_RADIO 0
+#endif  // SENSE_HAS_CYW43_RADIO
+
+#if SENSE_HAS_CYW43_RADIO
+#include "device/pico_cyw43_radio.h"
+#endif  // SENSE_HAS_CYW43_RADIO
+
+/// Bytes in the multibuf pool behind the USB channel.
+#ifndef SENSE_USB_CHANNEL_BUFFER_SIZE
+#define SENSE_USB_CHANNEL_BUFFER_SIZE 8192
+#endif  // SENSE_USB_CHANNEL_BUFFER_SIZE
 
-using pw::digital_io::Rp2040DigitalIn;
+/// Milliseconds the hardware watchdog waits to be fed before it resets the
+/// device. Must be longer than the longest blocking task, such as joining
+/// Wi-Fi, and at most the RP2's limit of about 8 seconds. Zero leaves the
+/// hardware watchdog off.
+#ifndef SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS
+#define SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS 0
+#endif  // SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS
 
 namespace sense::system {
 namespace {
 
 pw::i2c::Initiator& I2cInitiator() {
-  static constexpr pw::i2c::Rp2040Initiator::Config kI2c0Config{
+  static constexpr PicoDmaI2cInitiator::Config kI2c0Config{
       .clock_frequency = 400'000,
       .sda_pin = board::kEnviroPinSda,
       .scl_pin = board::kEnviroPinScl,
   };
 
   static pw::i2c::Initiator& i2c0_bus = []() -> pw::i2c::Initiator& {
-    static pw::i2c::Rp2040Initiator bus(kI2c0Config, i2c0);
+    static PicoDmaI2cInitiator bus(kI2c0Config, i2c0);
     bus.Enable();
     return bus;
   }();
@@ -59,33 +95,128 @@ pw::i2c::Initiator& I2cInitiator() {
   return i2c0_bus;
 }
 
+// The key-value store is not thread safe. Its users are serialized by
+// running on the blocking worker, which is a single thread: `ConfigStore`
+// flushes there and the air sensor saves its baseline there. Loads happen
+// while those users initialize, before they have anything to write.
+pw::kvs::KeyValueStore& KeyValueStore() {
+  // Several sectors so that erases are spread out as entries are rewritten.
+  static constexpr size_t kSectors = 4;
+  static constexpr size_t kMaxEntries = 16;
+  static constexpr uint32_t kMagic = 0x5e45e001;
+
+  static pw::kvs::KeyValueStore& kvs = []() -> pw::kvs::KeyValueStore& {
+    static PicoFlashMemory flash(kSectors);
+    static pw::kvs::FlashPartition partition(&flash);
+    static pw::kvs::ChecksumCrc16 checksum;
+    static pw::kvs::KeyValueStoreBuffer<kMaxEntries, kSectors> store(
+        &partition, {.magic = kMagic, .checksum = &checksum});
+    if (pw::Status status = store.Init(); !status.ok()) {
+      PW_LOG_WARN("Key-value store init returned %s", status.str());
+    }
+    return store;
+  }();
+  return kvs;
+}
+
+I2cBusArbiter& I2cBus() {
+  static I2cBusArbiter& arbiter = []() -> I2cBusArbiter& {
+    static I2cBusArbiter bus(I2cInitiator());
+    pw::metric::global_groups.push_back(bus.metrics());
+    return bus;
+  }();
+  return arbiter;
+}
+
 Ltr559ProxAndLightSensorImpl& Ltr559() {
-  static Ltr559ProxAndLightSensorImpl sensor(I2cInitiator());
+  // Proximity drives interactive state, so the LTR559 goes ahead of the
+  // BME688 when both want the bus.
+  static I2cBusArbiter::Client& client = []() -> I2cBusArbiter::Client& {
+    static I2cBusArbiter::Client ltr559(I2cBus(),
+                                        I2cBusArbiter::Priority::kHigh,
+                                        PW_METRIC_TOKEN("ltr559"));
+    pw::metric::global_groups.push_back(ltr559.metrics());
+    return ltr559;
+  }();
+  static PicoDigitalInterrupt interrupt({
+      .pin = board::kEnviroLtr550Int,
+      .polarity = pw::digital_io::Polarity::kActiveLow,
+      .enable_pull_up = true,
+  });
+  static Ltr559ProxAndLightSensorImpl& sensor =
+      []() -> Ltr559ProxAndLightSensorImpl& {
+    static Ltr559ProxAndLightSensorImpl ltr559(client);
+    ltr559.InitThresholdInterrupt(interrupt,
+                                  GetWorker(LatencyClass::kInteractive));
+    return ltr559;
+  }();
   return sensor;
 }
 
+Bme688& Bme688Sensor() {
+  static I2cBusArbiter::Client& client = []() -> I2cBusArbiter::Client& {
+    static I2cBusArbiter::Client bme688(I2cBus(),
+                                        I2cBusArbiter::Priority::kNormal,
+                                        PW_METRIC_TOKEN("bme688"));
+    pw::metric::global_groups.push_back(bme688.metrics());
+    return bme688;
+  }();
+  static Bme688& air_sensor = []() -> Bme688& {
+    // Forced mode only heats for each measurement, which the sampling
+    // back-off relies on to save power.
+    static Bme688 bme688(client, sense::system::GetWorker());
+    bme688.SetBusyWait(busy_wait_us_32);
+    // Halve the weight of old readings about daily at the default 3 s air
+    // sampling period, so that the score follows seasonal changes.
+    bme688.UseExponentialBaseline(28800);
+    // Every 13 minutes or so at the default 3 s air sampling period. Flash
+    // writes stall execute-in-place, so saves run on the low-priority worker.
+    static KvsBaselineStore baseline_store(KeyValueStore());
+    bme688.SetBaselineStore(
+        baseline_store, 256, GetWorker(LatencyClass::kBlocking));
+    return bme688;
+  }();
+  return air_sensor;
+}
+
 }  // namespace
 
 namespace {
-Rp2040DigitalIn io_sw_a({
+// The switches are on consecutive pins, so they are all read at once.
+constexpr uint32_t kSwitchPins[] = {
+    board::kEnviroPinSwA,
+    board::kEnviroPinSwB,
+    board::kEnviroPinSwX,
+    board::kEnviroPinSwY,
+};
+
+PicoGpioPort io_switches({
+    .pins = kSwitchPins,
+    .polarity = pw::digital_io::Polarity::kActiveLow,
+    .enable_pull_up = true,
+});
+
+// Interrupts on the same pins as the switches, so that the buttons are only
+// sampled after they change.
+PicoDigitalInterrupt irq_sw_a({
     .pin = board::kEnviroPinSwA,
     .polarity = pw::digital_io::Polarity::kActiveLow,
     .enable_pull_up = true,
 });
 
-Rp2040DigitalIn io_sw_b({
+PicoDigitalInterrupt irq_sw_b({
     .pin = board::kEnviroPinSwB,
     .polarity = pw::digital_io::Polarity::kActiveLow,
     .enable_pull_up = true,
 });
 
-Rp2040DigitalIn io_sw_x({
+PicoDigitalInterrupt irq_sw_x({
     .pin = board::kEnviroPinSwX,
     .polarity = pw::digital_io::Polarity::kActiveLow,
     .enable_pull_up = true,
 });
 
-Rp2040DigitalIn io_sw_y({
+PicoDigitalInterrupt irq_sw_y({
     .pin = board::kEnviroPinSwY,
     .polarity = pw::digital_io::Polarity::kActiveLow,
     .enable_pull_up = true,
@@ -102,20 +233,26 @@ void Init() {
 
   // Install the CPU exception handler.
   exception_set_exclusive_handler(HARDFAULT_EXCEPTION, pw_cpu_exception_Entry);
+
+  InitPower();
+#if SENSE_GPIO_MARKERS_ENABLED
+  InitGpioMarkers();
+#endif  // SENSE_GPIO_MARKERS_ENABLED
 }
 
 void Start() {
-  static std::byte channel_buffer[2048];
+  // Shared by USB reads and writes, so it bounds how much RPC, log and
+  // streaming data may be in flight at once.
+  static std::byte channel_buffer[SENSE_USB_CHANNEL_BUFFER_SIZE];
   static pw::multibuf::SimpleAllocator multibuf_alloc(channel_buffer,
                                                       pw::System().allocator());
-  pw::SystemStart(pw::channel::Rp2StdioChannelInit(multibuf_alloc));
+  static PicoUsbCdcChannel channel(multibuf_alloc);
+  channel.Enable();
+  pw::SystemStart(channel);
   PW_UNREACHABLE;
 }
 
-sense::AirSensor& AirSensor() {
-  static Bme688 air_sensor(I2cInitiator(), sense::system::GetWorker());
-  return air_sensor;
-}
+sense::AirSensor& AirSensor() { return Bme688Sensor(); }
 
 sense::Board& Board() {
   static ::sense::PicoBoard board;
@@ -123,12 +260,120 @@ sense::Board& Board() {
 }
 
 sense::ButtonManager& ButtonManager() {
-  static ::sense::ButtonManager manager(io_sw_a, io_sw_b, io_sw_x, io_sw_y);
-  return manager;
+  static ::sense::ButtonManager& button_manager =
+      []() -> ::sense::ButtonManager& {
+    static ::sense::ButtonManager manager(io_switches);
+    manager.UseInterrupts(irq_sw_a, irq_sw_b, irq_sw_x, irq_sw_y);
+    return manager;
+  }();
+  return button_manager;
 }
 
 sense::AmbientLightSensor& AmbientLightSensor() { return Ltr559(); }
 
 sense::ProximitySensor& ProximitySensor() { return Ltr559(); }
 
+sense::LightAndProximitySensor& LightAndProximitySensor() { return Ltr559(); }
+
+sense::Radio* Radio() {
+#if SENSE_HAS_CYW43_RADIO
+  static ::sense::PicoCyw43Radio radio;
+  return &radio;
+#else
+  return nullptr;
+#endif  // SENSE_HAS_CYW43_RADIO
+}
+
+void FeedHardwareWatchdog() {
+#if SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS > 0
+  [[maybe_unused]] static const bool enabled = [] {
+    watchdog_enable(SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS,
+                    /*pause_on_debug=*/true);
+    return true;
+  }();
+  watchdog_update();
+#endif  // SENSE_HARDWARE_WATCHDOG_TIMEOUT_MS > 0
+}
+
+sense::ConfigStore& ConfigStore() {
+  static sense::ConfigStore& store = []() -> sense::ConfigStore& {
+    static sense::ConfigStore config_store;
+    // Flash writes stall execute-in-place, so saves run on the low-priority
+    // worker. Settings that fail to load keep their defaults.
+    std::ignore = config_store.Init(GetWorker(LatencyClass::kBlocking),
+                                    KeyValueStore());
+    return config_store;
+  }();
+  return store;
+}
+
+namespace {
+
+// Rough typical currents for an Enviro board on a Pico or Pico 2. CPU sleep
+// is the WFI kind, with every clock running. The radio on W boards is not
+// accounted for.
+constexpr CurrentModel kEnviroCurrentModel = {
+#if defined(PICO_RP2350) && PICO_RP2350
+    .cpu_awake_ua = 22'000,
+    .cpu_sleep_ua = 9'000,
+#else
+    .cpu_awake_ua = 24'000,
+    .cpu_sleep_ua = 10'000,
+#endif  // defined(PICO_RP2350) && PICO_RP2350
+    .air_heater_ua = 12'000,
+    .led_red_ua = 6'000,
+    .led_green_ua = 5'000,
+    .led_blue_ua = 5'000,
+    .i2c_busy_ua = 1'500,
+};
+
+class EnviroEnergyCounterSource final : public EnergyCounterSource {
+ private:
+  EnergyCounters DoRead() override {
+    const PowerManager& power = GetPowerManager();
+    const LedAnimation::Levels led = PolychromeLed().mean_levels();
+    return {
+        .cpu_awake_ms = static_cast<uint32_t>(power.awake_us() / 1000),
+        .cpu_sleep_ms = static_cast<uint32_t>(power.sleep_us() / 1000),
+        .air_heater_ms = Bme688Sensor().heater_on_ms(),
+        .i2c_busy_ms = I2cBus().busy_ms(),
+        .led_red = led.red,
+        .led_green = led.green,
+        .led_blue = led.blue,
+    };
+  }
+};
+
+}  // namespace
+
+sense::EnergyMeter* EnergyMeter() {
+  static EnviroEnergyCounterSource source;
+  static sense::EnergyMeter meter(source, kEnviroCurrentModel);
+  return &meter;
+}
+
+const pw::thread::Options& InteractiveWorkerThreadOptions() {
+  // Above the system work queue, but below the FreeRTOS timer task so that
+  // timer callbacks can still preempt it.
+  static pw::thread::freertos::StaticContextWithStack<512> context;
+  static constexpr auto kOptions =
+      pw::thread::freertos::Options()
+          .set_name("InteractiveWorker")
+          .set_static_context(context)
+          .set_priority(tskIDLE_PRIORITY + 2);
+  return kOptions;
+}
+
+const pw::thread::Options& BlockingWorkerThreadOptions() {
+  // Just above idle, so that handlers waiting on sensors never delay RPC
+  // dispatch or the other work queues.
+  static pw::thread::freertos::StaticContextWithStack<1024> context;
+  static constexpr auto kOptions =
+      pw::thread::freertos::Options()
+          .set_name("BlockingWorker")
+          .set_static_context(context)
+          .set_priority(tskIDLE_PRIORITY + 1);
+  return kOptions;
+}
+
 }  // namespace sense::system
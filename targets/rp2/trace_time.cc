@@ -0,0 +1,26 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include <cstddef>
+
+#include "hardware/timer.h"
+#include "pw_trace_tokenized/config.h"
+
+// Trace timestamps come from the 1 MHz hardware timer rather than a cycle
+// counter: the RP2040's Cortex-M0+ has no DWT, and the timer keeps counting
+// while the core sleeps in tickless idle.
+
+PW_TRACE_TIME_TYPE pw_trace_GetTraceTime() { return time_us_32(); }
+
+size_t pw_trace_GetTraceTimeTicksPerSecond() { return 1'000'000; }
@@ -0,0 +1,148 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "tools/gateway/connection.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+namespace sense::gateway {
+namespace {
+
+constexpr std::string_view kTcpPrefix = "tcp:";
+constexpr std::string_view kUnixPrefix = "unix:";
+
+bool HasPrefix(std::string_view text, std::string_view prefix) {
+  return text.substr(0, prefix.size()) == prefix;
+}
+
+pw::Result<int> ConnectTcp(std::string_view host_and_port) {
+  const size_t colon = host_and_port.rfind(':');
+  if (colon == std::string_view::npos) {
+    return pw::Status::InvalidArgument();
+  }
+  const std::string host(host_and_port.substr(0, colon));
+  const std::string port(host_and_port.substr(colon + 1));
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return pw::Status::Unavailable();
+  }
+  int fd = -1;
+  for (addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      continue;
+    }
+    if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) {
+    return pw::Status::Unavailable();
+  }
+  const int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  return fd;
+}
+
+pw::Result<int> ConnectUnix(std::string_view path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    return pw::Status::InvalidArgument();
+  }
+  std::memcpy(address.sun_path, path.data(), path.size());
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return pw::Status::Unavailable();
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+      0) {
+    close(fd);
+    return pw::Status::Unavailable();
+  }
+  return fd;
+}
+
+pw::Result<int> Connect(std::string_view endpoint) {
+  if (HasPrefix(endpoint, kTcpPrefix)) {
+    return ConnectTcp(endpoint.substr(kTcpPrefix.size()));
+  }
+  return ConnectUnix(endpoint.substr(kUnixPrefix.size()));
+}
+
+pw::Result<int> OpenSerial(std::string_view path) {
+  const std::string device(path);
+  const int fd = open(device.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0) {
+    return pw::Status::Unavailable();
+  }
+  // USB CDC ignores the baud rate, but echo and line editing must be off.
+  termios options;
+  if (tcgetattr(fd, &options) == 0) {
+    cfmakeraw(&options);
+    tcsetattr(fd, TCSANOW, &options);
+  }
+  return fd;
+}
+
+bool IsSocket(std::string_view endpoint) {
+  return HasPrefix(endpoint, kTcpPrefix) || HasPrefix(endpoint, kUnixPrefix);
+}
+
+}  // namespace
+
+pw::Result<int> OpenDevice(std::string_view endpoint) {
+  pw::Result<int> fd = IsSocket(endpoint) ? Connect(endpoint)
+                                          : OpenSerial(endpoint);
+  if (fd.ok()) {
+    fcntl(*fd, F_SETFL, fcntl(*fd, F_GETFL) | O_NONBLOCK);
+  }
+  return fd;
+}
+
+pw::Result<int> OpenOutput(std::string_view endpoint) {
+  if (endpoint == "-") {
+    return STDOUT_FILENO;
+  }
+  if (IsSocket(endpoint)) {
+    return Connect(endpoint);
+  }
+  const std::string path(endpoint);
+  const int fd =
+      open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return pw::Status::Unavailable();
+  }
+  return fd;
+}
+
+}  // namespace sense::gateway
@@ -0,0 +1,35 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <string_view>
+
+#include "pw_result/result.h"
+
+namespace sense::gateway {
+
+/// Opens a non-blocking connection to a device. The endpoint is one of
+///
+/// - `tcp:<host>:<port>`, e.g. a simulator's socket server,
+/// - `unix:<path>`, a simulator's Unix socket, or
+/// - the path of a USB serial device, which is set to raw mode.
+///
+/// @returns the file descriptor, or Unavailable if it could not be opened.
+pw::Result<int> OpenDevice(std::string_view endpoint);
+
+/// Opens where merged events are written: `-` for standard output, a
+/// `tcp:` or `unix:` endpoint as above, or otherwise a file to create.
+pw::Result<int> OpenOutput(std::string_view endpoint);
+
+}  // namespace sense::gateway
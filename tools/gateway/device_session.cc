@@ -0,0 +1,156 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#define PW_LOG_MODULE_NAME "GATEWAY"
+
+#include "tools/gateway/device_session.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <tuple>
+#include <utility>
+
+#include "pw_hdlc/default_addresses.h"
+#include "pw_hdlc/encoder.h"
+#include "pw_log/log.h"
+#include "pw_status/try.h"
+#include "pw_stream/memory_stream.h"
+#include "tools/gateway/connection.h"
+
+namespace sense::gateway {
+namespace {
+
+// How long a request may wait for a device to accept it.
+constexpr int kWriteTimeoutMs = 100;
+
+}  // namespace
+
+DeviceSession::DeviceSession(uint32_t id,
+                             std::string endpoint,
+                             BatchCallback&& on_batch)
+    : id_(id),
+      endpoint_(std::move(endpoint)),
+      on_batch_(std::move(on_batch)),
+      output_(*this),
+      channels_{pw::rpc::Channel::Create<kChannelId>(&output_)},
+      client_(channels_) {}
+
+pw::Status DeviceSession::Connect(
+    const pubsub_SubscribeBatchedRequest& request) {
+  pw::Result<int> fd = OpenDevice(endpoint_);
+  if (!fd.ok()) {
+    return fd.status();
+  }
+  fd_ = *fd;
+  decoder_.Clear();
+  stats_.connects += 1;
+
+  ::pubsub::pw_rpc::nanopb::PubSub::Client pubsub(client_, kChannelId);
+  stream_ = pubsub.SubscribeBatched(
+      request,
+      [this](const pubsub_EventBatch& batch) {
+        stats_.batches += 1;
+        stats_.device_dropped += batch.dropped;
+        on_batch_(*this, batch);
+      },
+      [this](pw::Status status) {
+        PW_LOG_WARN("Device %u ended its stream: %s",
+                    static_cast<unsigned>(id_),
+                    status.str());
+      },
+      [this](pw::Status status) {
+        PW_LOG_WARN("Device %u stream failed: %s",
+                    static_cast<unsigned>(id_),
+                    status.str());
+      });
+  if (!stream_.active()) {
+    Disconnect();
+    return pw::Status::Unavailable();
+  }
+  PW_LOG_INFO("Device %u connected at %s",
+              static_cast<unsigned>(id_),
+              endpoint_.c_str());
+  return pw::OkStatus();
+}
+
+void DeviceSession::Disconnect() {
+  if (fd_ < 0) {
+    return;
+  }
+  // Tell the device to stop streaming, in case the connection stays up.
+  std::ignore = stream_.Cancel();
+  close(fd_);
+  fd_ = -1;
+}
+
+bool DeviceSession::Read() {
+  std::array<std::byte, kReadSize> buffer;
+  ssize_t received;
+  do {
+    received = read(fd_, buffer.data(), buffer.size());
+  } while (received < 0 && errno == EINTR);
+  if (received < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+  if (received == 0) {
+    return false;
+  }
+  stats_.bytes += static_cast<size_t>(received);
+  for (ssize_t i = 0; i < received; ++i) {
+    pw::Result<pw::hdlc::Frame> frame = decoder_.Process(buffer[i]);
+    if (frame.ok()) {
+      // Logs and other frames are for the device's console, not us.
+      if (frame->address() == pw::hdlc::kDefaultRpcAddress &&
+          !client_.ProcessPacket(frame->data()).ok()) {
+        stats_.bad_frames += 1;
+      }
+    } else if (frame.status() != pw::Status::Unavailable()) {
+      stats_.bad_frames += 1;
+    }
+  }
+  return true;
+}
+
+pw::Status DeviceSession::Output::Send(pw::span<const std::byte> packet) {
+  pw::stream::MemoryWriterBuffer<2 * kMaxFrameSize> frame;
+  PW_TRY(pw::hdlc::WriteUIFrame(pw::hdlc::kDefaultRpcAddress, packet, frame));
+  return session_.Write(frame.WrittenData());
+}
+
+pw::Status DeviceSession::Write(pw::ConstByteSpan data) {
+  while (!data.empty()) {
+    if (fd_ < 0) {
+      return pw::Status::Unavailable();
+    }
+    const ssize_t written = write(fd_, data.data(), data.size());
+    if (written > 0) {
+      data = data.subspan(static_cast<size_t>(written));
+      continue;
+    }
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    pollfd ready = {.fd = fd_, .events = POLLOUT, .revents = 0};
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        poll(&ready, 1, kWriteTimeoutMs) == 1) {
+      continue;
+    }
+    return pw::Status::Unavailable();
+  }
+  return pw::OkStatus();
+}
+
+}  // namespace sense::gateway
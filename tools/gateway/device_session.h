@@ -0,0 +1,105 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "modules/pubsub/pubsub_pb/pubsub.rpc.pb.h"
+#include "pw_bytes/span.h"
+#include "pw_function/function.h"
+#include "pw_hdlc/decoder.h"
+#include "pw_rpc/channel.h"
+#include "pw_rpc/client.h"
+#include "pw_status/status.h"
+
+namespace sense::gateway {
+
+/// The gateway's RPC session with one device: its connection, HDLC framing,
+/// RPC client, and batched PubSub stream.
+///
+/// Sessions do no work of their own; the gateway's event loop calls `Read`
+/// when the connection has data, so an idle device costs nothing.
+class DeviceSession {
+ public:
+  using BatchCallback =
+      pw::Function<void(DeviceSession&, const pubsub_EventBatch&)>;
+
+  struct Stats {
+    uint64_t bytes = 0;
+    uint32_t batches = 0;
+    /// Events the device reported dropping from the stream.
+    uint32_t device_dropped = 0;
+    uint32_t bad_frames = 0;
+    uint32_t connects = 0;
+  };
+
+  DeviceSession(uint32_t id, std::string endpoint, BatchCallback&& on_batch);
+  ~DeviceSession() { Disconnect(); }
+
+  DeviceSession(const DeviceSession&) = delete;
+  DeviceSession& operator=(const DeviceSession&) = delete;
+
+  /// Connects to the device and opens its batched PubSub stream.
+  pw::Status Connect(const pubsub_SubscribeBatchedRequest& request);
+
+  /// Closes the connection. The stream is reopened by the next `Connect`.
+  void Disconnect();
+
+  /// Processes up to one read's worth of what the device has sent, without
+  /// blocking, so that a busy device cannot starve the others. Returns false
+  /// if the connection was closed.
+  bool Read();
+
+  uint32_t id() const { return id_; }
+  const std::string& endpoint() const { return endpoint_; }
+  int fd() const { return fd_; }
+  bool connected() const { return fd_ >= 0; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // pw_system serves RPCs on this channel.
+  static constexpr uint32_t kChannelId = 1;
+  static constexpr size_t kMaxFrameSize = 1024;
+  static constexpr size_t kReadSize = 4096;
+
+  class Output final : public pw::rpc::ChannelOutput {
+   public:
+    explicit Output(DeviceSession& session)
+        : pw::rpc::ChannelOutput("gateway"), session_(session) {}
+
+    pw::Status Send(pw::span<const std::byte> packet) override;
+
+   private:
+    DeviceSession& session_;
+  };
+
+  pw::Status Write(pw::ConstByteSpan data);
+
+  const uint32_t id_;
+  const std::string endpoint_;
+  BatchCallback on_batch_;
+  int fd_ = -1;
+
+  Output output_;
+  std::array<pw::rpc::Channel, 1> channels_;
+  pw::rpc::Client client_;
+  pw::hdlc::DecoderBuffer<kMaxFrameSize> decoder_;
+  pw::rpc::NanopbClientReader<pubsub_EventBatch> stream_;
+  Stats stats_;
+};
+
+}  // namespace sense::gateway
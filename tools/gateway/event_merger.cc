@@ -0,0 +1,104 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "tools/gateway/event_merger.h"
+
+#include <algorithm>
+
+namespace sense::gateway {
+
+EventMerger::Device& EventMerger::GetDevice(uint32_t device) {
+  if (device >= devices_.size()) {
+    devices_.resize(device + 1);
+  }
+  return devices_[device];
+}
+
+int64_t EventMerger::ToGatewayTime(uint32_t device,
+                                   int64_t device_time_us,
+                                   int64_t receive_time_us) {
+  Device& state = GetDevice(device);
+  const int64_t offset_us = receive_time_us - device_time_us;
+  const bool jumped = state.mapped && offset_us - state.offset_us > kMaxDelayUs;
+  if (!state.mapped || jumped || offset_us < state.offset_us) {
+    if (jumped) {
+      stats_.clock_resets += 1;
+    }
+    state.mapped = true;
+    state.offset_us = offset_us;
+  }
+  return device_time_us + state.offset_us;
+}
+
+bool EventMerger::Add(uint32_t device,
+                      int64_t time_us,
+                      const pubsub_Event& event) {
+  Device& state = GetDevice(device);
+  if (time_us < last_emitted_us_) {
+    time_us = last_emitted_us_;
+    stats_.late += 1;
+  }
+  queue_.push({.record = {.device = device, .time_us = time_us, .event = event},
+               .sequence = sequence_++});
+  state.pending += 1;
+  stats_.events += 1;
+  return state.pending <= options_.max_pending_per_device;
+}
+
+bool EventMerger::CanResume(uint32_t device) const {
+  return pending(device) <= options_.max_pending_per_device / 2;
+}
+
+size_t EventMerger::pending(uint32_t device) const {
+  return device < devices_.size() ? devices_[device].pending : 0;
+}
+
+void EventMerger::Pop(const pw::Function<void(const Record&)>& emit) {
+  const Record& record = queue_.top().record;
+  last_emitted_us_ = std::max(last_emitted_us_, record.time_us);
+  devices_[record.device].pending -= 1;
+  emit(record);
+  queue_.pop();
+}
+
+size_t EventMerger::Flush(int64_t now_us,
+                          size_t max_records,
+                          const pw::Function<void(const Record&)>& emit) {
+  const int64_t cutoff_us = now_us - options_.window.count();
+  size_t emitted = 0;
+  while (emitted < max_records && !queue_.empty() &&
+         queue_.top().record.time_us <= cutoff_us) {
+    Pop(emit);
+    emitted += 1;
+  }
+  return emitted;
+}
+
+size_t EventMerger::FlushAll(const pw::Function<void(const Record&)>& emit) {
+  size_t emitted = 0;
+  while (!queue_.empty()) {
+    Pop(emit);
+    emitted += 1;
+  }
+  return emitted;
+}
+
+int64_t EventMerger::next_due_us() const {
+  if (queue_.empty()) {
+    return INT64_MAX;
+  }
+  return queue_.top().record.time_us + options_.window.count();
+}
+
+}  // namespace sense::gateway
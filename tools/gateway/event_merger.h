@@ -0,0 +1,132 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "modules/pubsub/pubsub_pb/pubsub.pb.h"
+#include "pw_function/function.h"
+
+namespace sense::gateway {
+
+/// Merges the event streams of many devices into one stream ordered by time.
+///
+/// Devices stream in batches and over links of different latency, so events
+/// are held for a reorder window before they are emitted. Each device's clock
+/// is mapped onto the gateway's, so that the merged times are comparable.
+///
+/// Work is proportional to the number of events: idle devices cost nothing.
+class EventMerger {
+ public:
+  struct Options {
+    /// How long events are held for events from slower links to catch up.
+    std::chrono::microseconds window = std::chrono::milliseconds(250);
+
+    /// Events a device may have waiting before it is over budget.
+    size_t max_pending_per_device = 256;
+  };
+
+  struct Record {
+    uint32_t device;
+    /// Gateway clock, in microseconds.
+    int64_t time_us;
+    pubsub_Event event;
+  };
+
+  struct Stats {
+    uint64_t events = 0;
+    /// Events that arrived after later events were emitted, and so were
+    /// emitted with the time of the last emitted event.
+    uint64_t late = 0;
+    /// Times a device's clock jumped, e.g. when it rebooted.
+    uint32_t clock_resets = 0;
+  };
+
+  explicit EventMerger(const Options& options) : options_(options) {}
+
+  /// Converts a time on a device's clock to the gateway clock, given when
+  /// the gateway received it.
+  ///
+  /// The offset between the clocks is the smallest one seen, which is the
+  /// one with the least transport delay. A large jump resets it.
+  int64_t ToGatewayTime(uint32_t device,
+                        int64_t device_time_us,
+                        int64_t receive_time_us);
+
+  /// Adds an event to be emitted in order. Returns false if the device is
+  /// now over budget, in which case the caller should stop reading from it
+  /// until `CanResume` returns true.
+  bool Add(uint32_t device, int64_t time_us, const pubsub_Event& event);
+
+  /// Returns whether a device that went over budget has drained enough to
+  /// be read again.
+  bool CanResume(uint32_t device) const;
+
+  /// Emits up to `max_records` records that are older than the reorder
+  /// window at `now_us`, oldest first. Returns the number emitted.
+  size_t Flush(int64_t now_us,
+               size_t max_records,
+               const pw::Function<void(const Record&)>& emit);
+
+  /// Emits every held record, e.g. at shutdown.
+  size_t FlushAll(const pw::Function<void(const Record&)>& emit);
+
+  /// Returns when the oldest held record is due on the gateway clock, or
+  /// INT64_MAX if none are held.
+  int64_t next_due_us() const;
+
+  size_t pending() const { return queue_.size(); }
+  size_t pending(uint32_t device) const;
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // Offsets that grow by more than this are treated as a new clock rather
+  // than transport delay.
+  static constexpr int64_t kMaxDelayUs = 2'000'000;
+
+  struct Entry {
+    Record record;
+    uint64_t sequence;
+
+    // Orders the priority queue oldest first, ties in arrival order.
+    bool operator<(const Entry& other) const {
+      if (record.time_us != other.record.time_us) {
+        return record.time_us > other.record.time_us;
+      }
+      return sequence > other.sequence;
+    }
+  };
+
+  struct Device {
+    bool mapped = false;
+    int64_t offset_us = 0;
+    size_t pending = 0;
+  };
+
+  Device& GetDevice(uint32_t device);
+  void Pop(const pw::Function<void(const Record&)>& emit);
+
+  const Options options_;
+  std::priority_queue<Entry> queue_;
+  std::vector<Device> devices_;
+  uint64_t sequence_ = 0;
+  int64_t last_emitted_us_ = INT64_MIN;
+  Stats stats_;
+};
+
+}  // namespace sense::gateway
@@ -0,0 +1,115 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "tools/gateway/event_merger.h"
+
+#include <vector>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense::gateway {
+namespace {
+
+using std::chrono::milliseconds;
+
+pubsub_Event AirQuality(uint32_t score) {
+  pubsub_Event event = pubsub_Event_init_default;
+  event.which_type = pubsub_Event_air_quality_tag;
+  event.type.air_quality = score;
+  return event;
+}
+
+class EventMergerTest : public ::testing::Test {
+ protected:
+  EventMergerTest()
+      : merger_({.window = milliseconds(10), .max_pending_per_device = 4}) {}
+
+  size_t Flush(int64_t now_us) {
+    return merger_.Flush(now_us, SIZE_MAX, [this](const auto& record) {
+      emitted_.push_back(record);
+    });
+  }
+
+  EventMerger merger_;
+  std::vector<EventMerger::Record> emitted_;
+};
+
+TEST_F(EventMergerTest, EmitsAcrossDevicesInTimeOrder) {
+  EXPECT_TRUE(merger_.Add(0, 3'000, AirQuality(3)));
+  EXPECT_TRUE(merger_.Add(1, 1'000, AirQuality(1)));
+  EXPECT_TRUE(merger_.Add(0, 2'000, AirQuality(2)));
+
+  EXPECT_EQ(Flush(11'000), 1u);
+  EXPECT_EQ(Flush(20'000), 2u);
+
+  ASSERT_EQ(emitted_.size(), 3u);
+  EXPECT_EQ(emitted_[0].device, 1u);
+  EXPECT_EQ(emitted_[0].event.type.air_quality, 1u);
+  EXPECT_EQ(emitted_[1].event.type.air_quality, 2u);
+  EXPECT_EQ(emitted_[2].event.type.air_quality, 3u);
+  EXPECT_EQ(merger_.pending(), 0u);
+}
+
+TEST_F(EventMergerTest, HoldsEventsForTheWindow) {
+  ASSERT_TRUE(merger_.Add(0, 5'000, AirQuality(1)));
+  EXPECT_EQ(merger_.next_due_us(), 15'000);
+  EXPECT_EQ(Flush(14'999), 0u);
+  EXPECT_EQ(Flush(15'000), 1u);
+  EXPECT_EQ(merger_.next_due_us(), INT64_MAX);
+}
+
+TEST_F(EventMergerTest, LateEventsKeepTheOutputOrdered) {
+  ASSERT_TRUE(merger_.Add(0, 50'000, AirQuality(1)));
+  ASSERT_EQ(Flush(60'000), 1u);
+  ASSERT_TRUE(merger_.Add(1, 10'000, AirQuality(2)));
+  ASSERT_EQ(Flush(60'000), 1u);
+
+  EXPECT_EQ(emitted_[1].time_us, 50'000);
+  EXPECT_EQ(merger_.stats().late, 1u);
+}
+
+TEST_F(EventMergerTest, DeviceOverBudgetResumesAfterDraining) {
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(merger_.Add(2, i, AirQuality(0)));
+  }
+  EXPECT_FALSE(merger_.Add(2, 4, AirQuality(0)));
+  EXPECT_TRUE(merger_.Add(0, 4, AirQuality(0)));
+  EXPECT_FALSE(merger_.CanResume(2));
+
+  ASSERT_EQ(merger_.Flush(100'000, 3, [](const auto&) {}), 3u);
+  EXPECT_TRUE(merger_.CanResume(2));
+  EXPECT_EQ(merger_.pending(2), 2u);
+}
+
+TEST_F(EventMergerTest, MapsDeviceClocksByTheSmallestDelay) {
+  // Device clock 1000us behind the gateway, with 300us, 100us, then 400us
+  // of delay. Later times keep the 100us estimate.
+  EXPECT_EQ(merger_.ToGatewayTime(0, 5'000, 6'300), 6'300);
+  EXPECT_EQ(merger_.ToGatewayTime(0, 6'000, 7'100), 7'100);
+  EXPECT_EQ(merger_.ToGatewayTime(0, 7'000, 8'400), 8'100);
+  EXPECT_EQ(merger_.stats().clock_resets, 0u);
+
+  // Another device's clock is mapped on its own.
+  EXPECT_EQ(merger_.ToGatewayTime(1, 100, 8'500), 8'500);
+}
+
+TEST_F(EventMergerTest, RebootResetsTheClockMapping) {
+  ASSERT_EQ(merger_.ToGatewayTime(0, 50'000'000, 50'000'100), 50'000'100);
+  // The device restarted from zero.
+  EXPECT_EQ(merger_.ToGatewayTime(0, 1'000, 60'000'000), 60'000'000);
+  EXPECT_EQ(merger_.stats().clock_resets, 1u);
+}
+
+}  // namespace
+}  // namespace sense::gateway
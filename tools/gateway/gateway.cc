@@ -0,0 +1,309 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Holds RPC sessions to many Sense devices and merges their PubSub streams
+// into one time-ordered output, e.g.
+//
+//   bazelisk run //tools/gateway -- --output=/tmp/fleet.jsonl
+//       /dev/ttyACM0 /dev/ttyACM1 tcp:localhost:33000 unix:/tmp/sense.sock
+//
+// Each device streams batched events, which are mapped onto the gateway's
+// clock and written as one JSON object per line, ordered by time across
+// devices. One thread serves every device from a single epoll loop, so CPU
+// use follows the event rate rather than the number of devices.
+//
+// A device with too many events waiting to be merged is not read again until
+// they drain, so a burst from one device holds back only that device. Devices
+// that disconnect are reconnected every few seconds. Stop with Ctrl-C.
+
+#define PW_LOG_MODULE_NAME "GATEWAY"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "pw_log/log.h"
+#include "tools/gateway/connection.h"
+#include "tools/gateway/device_session.h"
+#include "tools/gateway/event_merger.h"
+#include "tools/gateway/output.h"
+
+namespace sense::gateway {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kReconnectInterval = std::chrono::seconds(2);
+// Records written per flush, to bound the time spent away from the devices.
+constexpr size_t kMaxRecordsPerFlush = 4096;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+struct Options {
+  std::string output = "-";
+  uint32_t window_ms = 250;
+  uint32_t batch_ms = 100;
+  uint32_t max_pending = 256;
+  std::deque<std::string> devices;
+};
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+int Usage(const char* program) {
+  std::fprintf(stderr,
+               "usage: %s [--output=-|<file>|tcp:<host>:<port>|unix:<path>] "
+               "[--window_ms=N] [--batch_ms=N] [--max_pending=N] "
+               "<device>...\n",
+               program);
+  return EXIT_FAILURE;
+}
+
+bool ParseFlag(std::string_view arg, std::string_view name, uint32_t& value) {
+  if (arg.substr(0, name.size()) != name || arg.size() == name.size()) {
+    return false;
+  }
+  char* end = nullptr;
+  value = static_cast<uint32_t>(
+      std::strtoul(arg.data() + name.size(), &end, 10));
+  return *end == '\0';
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+  constexpr std::string_view kOutput = "--output=";
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg.substr(0, kOutput.size()) == kOutput) {
+      options.output = arg.substr(kOutput.size());
+    } else if (arg.substr(0, 2) != "--") {
+      options.devices.emplace_back(arg);
+    } else if (!ParseFlag(arg, "--window_ms=", options.window_ms) &&
+               !ParseFlag(arg, "--batch_ms=", options.batch_ms) &&
+               !ParseFlag(arg, "--max_pending=", options.max_pending)) {
+      return false;
+    }
+  }
+  return !options.devices.empty() && options.max_pending > 0;
+}
+
+class Gateway {
+ public:
+  Gateway(const Options& options, int output_fd)
+      : merger_({.window = std::chrono::milliseconds(options.window_ms),
+                 .max_pending_per_device = options.max_pending}),
+        writer_(output_fd),
+        epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+    request_.max_delay_ms = options.batch_ms;
+    for (const std::string& endpoint : options.devices) {
+      const auto id = static_cast<uint32_t>(sessions_.size());
+      sessions_.emplace_back(
+          id, endpoint, [this](DeviceSession& session, const auto& batch) {
+            OnBatch(session, batch);
+          });
+      paused_.push_back(false);
+      retry_at_.push_back(Clock::now());
+    }
+  }
+
+  ~Gateway() { close(epoll_fd_); }
+
+  /// Serves the devices until a stop is requested or the output closes.
+  void Run() {
+    WriteDeviceTable();
+    std::array<epoll_event, 64> ready;
+    while (stop_requested == 0) {
+      Reconnect();
+      const int count = epoll_wait(
+          epoll_fd_, ready.data(), static_cast<int>(ready.size()), Timeout());
+      for (int i = 0; i < count; ++i) {
+        DeviceSession& session = sessions_[ready[i].data.u32];
+        if (!session.Read()) {
+          Drop(session);
+        }
+      }
+      if (!Flush(/*all=*/false)) {
+        break;
+      }
+    }
+    Flush(/*all=*/true);
+    LogSummary();
+  }
+
+ private:
+  void OnBatch(DeviceSession& session, const pubsub_EventBatch& batch) {
+    const int64_t now_us = NowUs();
+    for (pb_size_t i = 0; i < batch.events_count; ++i) {
+      const pubsub_Event& event = batch.events[i];
+      // Only sensor samples are stamped on the device; the rest are placed
+      // when they arrive.
+      const int64_t time_us =
+          event.timestamp_us != 0
+              ? merger_.ToGatewayTime(session.id(), event.timestamp_us, now_us)
+              : now_us;
+      if (!merger_.Add(session.id(), time_us, event)) {
+        Pause(session);
+      }
+    }
+  }
+
+  void Pause(DeviceSession& session) {
+    if (paused_[session.id()]) {
+      return;
+    }
+    paused_[session.id()] = true;
+    Watch(session, EPOLL_CTL_MOD, 0);
+  }
+
+  void Watch(DeviceSession& session, int operation, uint32_t events) {
+    epoll_event event = {.events = events, .data = {.u32 = session.id()}};
+    epoll_ctl(epoll_fd_, operation, session.fd(), &event);
+  }
+
+  void Reconnect() {
+    const Clock::time_point now = Clock::now();
+    for (DeviceSession& session : sessions_) {
+      if (session.connected() || retry_at_[session.id()] > now) {
+        continue;
+      }
+      retry_at_[session.id()] = now + kReconnectInterval;
+      if (session.Connect(request_).ok()) {
+        paused_[session.id()] = false;
+        Watch(session, EPOLL_CTL_ADD, EPOLLIN);
+      }
+    }
+  }
+
+  void Drop(DeviceSession& session) {
+    PW_LOG_WARN("Device %u disconnected", static_cast<unsigned>(session.id()));
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, session.fd(), nullptr);
+    session.Disconnect();
+    retry_at_[session.id()] = Clock::now() + kReconnectInterval;
+  }
+
+  // Returns how long to wait for devices before the next flush or retry.
+  int Timeout() const {
+    int64_t wait_us = merger_.next_due_us() - NowUs();
+    const Clock::time_point now = Clock::now();
+    for (const DeviceSession& session : sessions_) {
+      if (!session.connected()) {
+        wait_us = std::min<int64_t>(
+            wait_us,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                retry_at_[session.id()] - now)
+                .count());
+      }
+    }
+    // Wake up now and then to notice a stop request.
+    constexpr int64_t kMaxWaitUs = 500'000;
+    return static_cast<int>(std::clamp<int64_t>(wait_us, 0, kMaxWaitUs) /
+                            1000);
+  }
+
+  bool Flush(bool all) {
+    auto emit = [this](const EventMerger::Record& record) {
+      writer_.Add(record);
+    };
+    if (all) {
+      merger_.FlushAll(emit);
+    } else {
+      merger_.Flush(NowUs(), kMaxRecordsPerFlush, emit);
+    }
+    if (!writer_.Flush().ok()) {
+      PW_LOG_ERROR("Output closed; stopping");
+      return false;
+    }
+    for (DeviceSession& session : sessions_) {
+      if (paused_[session.id()] && session.connected() &&
+          merger_.CanResume(session.id())) {
+        paused_[session.id()] = false;
+        Watch(session, EPOLL_CTL_MOD, EPOLLIN);
+      }
+    }
+    return true;
+  }
+
+  // Starts the output with which endpoint each device number refers to.
+  void WriteDeviceTable() {
+    std::string line = "{\"devices\": [";
+    for (const DeviceSession& session : sessions_) {
+      line += session.id() == 0 ? "\"" : ", \"";
+      line += session.endpoint();
+      line += '"';
+    }
+    line += "]}\n";
+    writer_.AddLine(line);
+  }
+
+  void LogSummary() const {
+    const EventMerger::Stats& stats = merger_.stats();
+    PW_LOG_INFO("Merged %u events, %u late, %u clock resets",
+                static_cast<unsigned>(stats.events),
+                static_cast<unsigned>(stats.late),
+                static_cast<unsigned>(stats.clock_resets));
+    for (const DeviceSession& session : sessions_) {
+      const DeviceSession::Stats& device = session.stats();
+      PW_LOG_INFO(
+          "Device %u: %u batches, %u dropped by device, %u bad frames, "
+          "%u connects",
+          static_cast<unsigned>(session.id()),
+          static_cast<unsigned>(device.batches),
+          static_cast<unsigned>(device.device_dropped),
+          static_cast<unsigned>(device.bad_frames),
+          static_cast<unsigned>(device.connects));
+    }
+  }
+
+  EventMerger merger_;
+  BatchWriter writer_;
+  const int epoll_fd_;
+  pubsub_SubscribeBatchedRequest request_ =
+      pubsub_SubscribeBatchedRequest_init_default;
+  std::deque<DeviceSession> sessions_;
+  std::deque<bool> paused_;
+  std::deque<Clock::time_point> retry_at_;
+};
+
+}  // namespace
+}  // namespace sense::gateway
+
+int main(int argc, char* argv[]) {
+  sense::gateway::Options options;
+  if (!sense::gateway::ParseOptions(argc, argv, options)) {
+    return sense::gateway::Usage(argv[0]);
+  }
+  pw::Result<int> output = sense::gateway::OpenOutput(options.output);
+  if (!output.ok()) {
+    std::fprintf(stderr, "Failed to open %s\n", options.output.c_str());
+    return EXIT_FAILURE;
+  }
+  std::signal(SIGINT, [](int) { sense::gateway::stop_requested = 1; });
+  std::signal(SIGPIPE, SIG_IGN);
+
+  sense::gateway::Gateway gateway(options, *output);
+  gateway.Run();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "tools/gateway/output.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+
+namespace sense::gateway {
+namespace {
+
+void Append(std::string& out, const char* format, auto... args) {
+  char text[160];
+  const int size = std::snprintf(text, sizeof(text), format, args...);
+  if (size > 0) {
+    out.append(text, std::min(static_cast<size_t>(size), sizeof(text) - 1));
+  }
+}
+
+void AppendEscaped(std::string& out, const char* text) {
+  out.push_back('"');
+  for (; *text != '\0'; ++text) {
+    const char c = *text;
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      Append(out, "\\u%04x", static_cast<unsigned>(c));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+const char* Bool(bool value) { return value ? "true" : "false"; }
+
+void AppendEvent(const pubsub_Event& event, std::string& out) {
+  const auto& type = event.type;
+  switch (event.which_type) {
+    case pubsub_Event_button_a_pressed_tag:
+      Append(out, "\"button_a\", \"value\": %s", Bool(type.button_a_pressed));
+      break;
+    case pubsub_Event_button_b_pressed_tag:
+      Append(out, "\"button_b\", \"value\": %s", Bool(type.button_b_pressed));
+      break;
+    case pubsub_Event_button_x_pressed_tag:
+      Append(out, "\"button_x\", \"value\": %s", Bool(type.button_x_pressed));
+      break;
+    case pubsub_Event_button_y_pressed_tag:
+      Append(out, "\"button_y\", \"value\": %s", Bool(type.button_y_pressed));
+      break;
+    case pubsub_Event_proximity_tag:
+      Append(out, "\"proximity\", \"value\": %s", Bool(type.proximity));
+      break;
+    case pubsub_Event_proximity_level_tag:
+      Append(out,
+             "\"proximity_level\", \"value\": %" PRIu32,
+             type.proximity_level);
+      break;
+    case pubsub_Event_air_quality_tag:
+      Append(out,
+             "\"air_quality\", \"value\": %" PRIu32 ", \"warming_up\": %s",
+             type.air_quality,
+             Bool(event.warming_up));
+      if (event.has_iaq) {
+        Append(out,
+               ", \"iaq\": %" PRIu32 ", \"co2_ppm\": %" PRIu32
+               ", \"iaq_accuracy\": %d",
+               event.iaq.index,
+               event.iaq.co2_ppm,
+               static_cast<int>(event.iaq.accuracy));
+      }
+      break;
+    case pubsub_Event_ambient_light_lux_tag:
+      Append(out,
+             "\"ambient_light_lux\", \"value\": %.2f",
+             static_cast<double>(type.ambient_light_lux));
+      break;
+    case pubsub_Event_morse_code_value_tag:
+      Append(out,
+             "\"morse_code_value\", \"turn_on\": %s, \"message_finished\": %s",
+             Bool(type.morse_code_value.turn_on),
+             Bool(type.morse_code_value.message_finished));
+      break;
+    case pubsub_Event_morse_encode_request_tag:
+      out.append("\"morse_encode_request\", \"msg\": ");
+      AppendEscaped(out, type.morse_encode_request.msg);
+      Append(out, ", \"repeat\": %" PRIu32, type.morse_encode_request.repeat);
+      break;
+    case pubsub_Event_timer_request_tag:
+      Append(out,
+             "\"timer_request\", \"token\": %" PRIu32
+             ", \"timeout_ms\": %" PRIu32 ", \"period_ms\": %" PRIu32,
+             type.timer_request.token,
+             type.timer_request.timeout_ms,
+             type.timer_request.period_ms);
+      break;
+    case pubsub_Event_timer_expired_tag:
+      Append(out,
+             "\"timer_expired\", \"token\": %" PRIu32,
+             type.timer_expired.token);
+      break;
+    case pubsub_Event_timer_cancel_tag:
+      Append(out,
+             "\"timer_cancel\", \"token\": %" PRIu32,
+             type.timer_cancel.token);
+      break;
+    case pubsub_Event_button_gesture_tag:
+      Append(out,
+             "\"button_gesture\", \"kind\": %d, \"buttons\": %" PRIu32
+             ", \"count\": %" PRIu32,
+             static_cast<int>(type.button_gesture.kind),
+             type.button_gesture.buttons,
+             type.button_gesture.count);
+      break;
+    case pubsub_Event_sense_state_tag:
+      Append(out,
+             "\"sense_state\", \"alarm\": %s, \"alarm_threshold\": %" PRIu32
+             ", \"aq_score\": %" PRIu32 ", \"aq_rating\": %d",
+             Bool(type.sense_state.alarm_active),
+             type.sense_state.alarm_threshold,
+             type.sense_state.aq_score,
+             static_cast<int>(type.sense_state.aq_rating));
+      break;
+    case pubsub_Event_state_manager_control_tag:
+      Append(out,
+             "\"state_manager_control\", \"action\": %d",
+             static_cast<int>(type.state_manager_control.action));
+      break;
+    case pubsub_Event_air_measurement_tag:
+      Append(out,
+             "\"air_measurement\", \"temperature\": %.2f, \"pressure\": %.2f",
+             static_cast<double>(type.air_measurement.temperature),
+             static_cast<double>(type.air_measurement.pressure));
+      Append(out,
+             ", \"humidity\": %.2f, \"gas_resistance\": %.0f",
+             static_cast<double>(type.air_measurement.humidity),
+             static_cast<double>(type.air_measurement.gas_resistance));
+      Append(out, ", \"score\": %" PRIu32, type.air_measurement.score);
+      break;
+    default:
+      Append(out, "\"unknown\", \"tag\": %u", event.which_type);
+      break;
+  }
+}
+
+}  // namespace
+
+void AppendJsonLine(const EventMerger::Record& record, std::string& out) {
+  Append(out,
+         "{\"device\": %" PRIu32 ", \"time_us\": %" PRId64 ", \"type\": ",
+         record.device,
+         record.time_us);
+  AppendEvent(record.event, out);
+  if (record.event.dropped != 0) {
+    Append(out, ", \"dropped\": %" PRIu32, record.event.dropped);
+  }
+  out.append("}\n");
+}
+
+pw::Status BatchWriter::Flush() {
+  size_t written = 0;
+  while (written < buffer_.size()) {
+    const ssize_t result =
+        write(fd_, buffer_.data() + written, buffer_.size() - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      buffer_.clear();
+      return pw::Status::DataLoss();
+    }
+    written += static_cast<size_t>(result);
+  }
+  buffer_.clear();
+  return pw::OkStatus();
+}
+
+}  // namespace sense::gateway
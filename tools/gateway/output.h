@@ -0,0 +1,60 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "pw_status/status.h"
+#include "tools/gateway/event_merger.h"
+
+namespace sense::gateway {
+
+/// Appends a record as one line of JSON, e.g.
+///
+///   {"device": 3, "time_us": 1712, "type": "air_quality", "value": 812}
+///
+/// Message-valued events spell out their fields instead of `value`.
+void AppendJsonLine(const EventMerger::Record& record, std::string& out);
+
+/// Writes merged records to a file descriptor in batches, so that each flush
+/// costs one system call however many devices contributed to it.
+///
+/// Writes block: a slow reader stalls the gateway's event loop, which stops
+/// reading from the devices and so pushes back on them too.
+class BatchWriter {
+ public:
+  explicit BatchWriter(int fd) : fd_(fd) {}
+
+  void Add(const EventMerger::Record& record) {
+    AppendJsonLine(record, buffer_);
+  }
+
+  /// Appends a line as is. It must end with a newline.
+  void AddLine(std::string_view line) { buffer_.append(line); }
+
+  /// Writes everything added since the last flush.
+  ///
+  /// @returns DataLoss if the output was closed.
+  pw::Status Flush();
+
+  size_t buffered_bytes() const { return buffer_.size(); }
+
+ private:
+  const int fd_;
+  std::string buffer_;
+};
+
+}  // namespace sense::gateway
@@ -0,0 +1,82 @@
+// Copyright 2024 The Pigweed Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "tools/gateway/output.h"
+
+#include <cstring>
+#include <string>
+
+#include "pw_unit_test/framework.h"
+
+namespace sense::gateway {
+namespace {
+
+TEST(OutputTest, FormatsScalarEvents) {
+  EventMerger::Record record = {.device = 3,
+                                .time_us = 1712,
+                                .event = pubsub_Event_init_default};
+  record.event.which_type = pubsub_Event_air_quality_tag;
+  record.event.type.air_quality = 812;
+  std::string line;
+  AppendJsonLine(record, line);
+  EXPECT_EQ(line,
+            "{\"device\": 3, \"time_us\": 1712, \"type\": \"air_quality\", "
+            "\"value\": 812, \"warming_up\": false}\n");
+
+  record.event.has_iaq = true;
+  record.event.iaq.index = 40;
+  record.event.iaq.co2_ppm = 720;
+  record.event.iaq.accuracy = pubsub_IaqEstimate_Accuracy_HIGH;
+  line.clear();
+  AppendJsonLine(record, line);
+  EXPECT_EQ(line,
+            "{\"device\": 3, \"time_us\": 1712, \"type\": \"air_quality\", "
+            "\"value\": 812, \"warming_up\": false, \"iaq\": 40, "
+            "\"co2_ppm\": 720, \"iaq_accuracy\": 3}\n");
+}
+
+TEST(OutputTest, FormatsMessageEventsAndDrops) {
+  EventMerger::Record record = {.device = 0,
+                                .time_us = 5,
+                                .event = pubsub_Event_init_default};
+  record.event.which_type = pubsub_Event_sense_state_tag;
+  record.event.type.sense_state.alarm_active = true;
+  record.event.type.sense_state.alarm_threshold = 7;
+  record.event.type.sense_state.aq_score = 300;
+  record.event.dropped = 2;
+  std::string line;
+  AppendJsonLine(record, line);
+  EXPECT_EQ(line,
+            "{\"device\": 0, \"time_us\": 5, \"type\": \"sense_state\", "
+            "\"alarm\": true, \"alarm_threshold\": 7, \"aq_score\": 300, "
+            "\"aq_rating\": 0, \"dropped\": 2}\n");
+}
+
+TEST(OutputTest, EscapesMorseMessages) {
+  EventMerger::Record record = {.device = 1,
+                                .time_us = 0,
+                                .event = pubsub_Event_init_default};
+  record.event.which_type = pubsub_Event_morse_encode_request_tag;
+  std::strcpy(record.event.type.morse_encode_request.msg, "say \"hi\"\n");
+  record.event.type.morse_encode_request.repeat = 1;
+  std::string line;
+  AppendJsonLine(record, line);
+  EXPECT_EQ(line,
+            "{\"device\": 1, \"time_us\": 0, \"type\": "
+            "\"morse_encode_request\", \"msg\": \"say \\\"hi\\\"\\u000a\", "
+            "\"repeat\": 1}\n");
+}
+
+}  // namespace
+}  // namespace sense::gateway
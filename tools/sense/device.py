@@ -34,6 +34,13 @@ from pw_system.device_connection import (
 from blinky_pb import blinky_pb2
 from modules.air_sensor import air_sensor_pb2
 from modules.board import board_pb2
+from modules.cpu_usage import cpu_usage_pb2
+from modules.energy import energy_pb2
+from modules.history import history_pb2
+from modules.memory import memory_pb2
+from modules.profiling import profiling_pb2
+from modules.sampling_thread import sampling_pb2
+from modules.telemetry import telemetry_pb2
 from factory_pb import factory_pb2
 from pubsub_pb import pubsub_pb2
 import morse_code_pb2
@@ -89,6 +96,7 @@ class Device(PwSystemDevice):
             prefix = ''
 
             if event_type in [
+                'air_measurement',
                 'air_quality',
                 'ambient_light_lux',
                 'proximity_level',
@@ -148,11 +156,18 @@ def get_all_protos() -> list[ModuleType]:
         blinky_pb2,
         board_pb2,
         common_pb2,
+        cpu_usage_pb2,
         echo_pb2,
+        energy_pb2,
         factory_pb2,
+        history_pb2,
+        memory_pb2,
         morse_code_pb2,
+        profiling_pb2,
         pubsub_pb2,
+        sampling_pb2,
         state_manager_pb2,
+        telemetry_pb2,
     ]
 
 
@@ -343,6 +343,35 @@ class Samples:
         print_message(f'{" " * indent}Mean      {self.max_value:.2f}{suffix}')
 
 
+def _run_burst(
+    factory_service,
+    test: factory_pb2.Test.Type,
+    samples: int,
+    limits: factory_pb2.Limits | None = None,
+) -> Tuple[bool, Samples]:
+    """Has the device take a burst of samples and summarize them.
+
+    Returns whether the burst passed, along with its statistics.
+    """
+    request = factory_pb2.BurstRequest(test=test, samples=samples)
+    if limits is not None:
+        request.limits.CopyFrom(limits)
+    status, result = factory_service.RunBurst(request)
+    if status is not Status.OK:
+        return False, Samples()
+
+    statistics = result.statistics
+    summary = Samples(
+        count=statistics.count,
+        total_value=statistics.mean * statistics.count,
+        min_value=statistics.min,
+        max_value=statistics.max,
+    )
+    if result.errors:
+        print_message(f'{result.errors} of {samples} reads failed')
+    return result.passed, summary
+
+
 def _sample_until(
     max_samples: int,
     sample_rpc_method,
@@ -452,15 +481,12 @@ class Ltr559Test(Test):
     def _test_prox(self) -> bool:
         prompt_enter('Place your Enviro+ pack in a well-lit area')
 
-        with patch_stdout():
-            with ProgressBar(title='Getting initial sensor readings') as pb:
-                baseline_samples = Samples()
-                for i in pb(range(5)):
-                    status, response = self._factory_service.SampleLtr559Prox()
-                    if status is not Status.OK:
-                        return False
-
-                    baseline_samples.update(response.value)
+        print_message('Getting initial sensor readings')
+        success, baseline_samples = _run_burst(
+            self._factory_service, factory_pb2.Test.Type.LTR559_PROX, 50
+        )
+        if not success:
+            return False
 
         print_message(_COLOR.green(' DONE'))
         baseline_samples.print_formatted(indent=4)
@@ -498,16 +524,12 @@ class Ltr559Test(Test):
 
     def _test_light(self) -> bool:
         prompt_enter('Place your Enviro+ pack in an area with neutral light')
-        with patch_stdout():
-            with ProgressBar(title='Getting initial sensor readings') as pb:
-                baseline_samples = Samples()
-
-                for i in pb(range(5)):
-                    status, response = self._factory_service.SampleLtr559Light()
-                    if status is not Status.OK:
-                        return False
-
-                    baseline_samples.update(response.lux)
+        print_message('Getting initial sensor readings')
+        success, baseline_samples = _run_burst(
+            self._factory_service, factory_pb2.Test.Type.LTR559_LIGHT, 50
+        )
+        if not success:
+            return False
 
         print_message(_COLOR.green(' DONE'))
         baseline_samples.print_formatted(indent=4, units='lux')
@@ -662,17 +684,14 @@ class Bme688Test(Test):
             _COLOR.bold_white("\nTesting BME688's temperature sensor.")
         )
 
-        def log_received(_):
+        print_message('Getting initial sensor readings')
+        success, baseline_samples = _run_burst(
+            self._factory_service, factory_pb2.Test.Type.BME688, 10
+        )
+        if not success:
+            self.fail_test('bme688_temperature_baseline')
             return False
 
-        _, baseline_samples = _sample_until(
-            10,
-            self._air_sensor_service.Measure,
-            log_received,
-            field='temperature',
-            delay=0.25,
-            message='Getting initial sensor readings',
-        )
         print_message(_COLOR.green(' DONE'))
         baseline_samples.print_formatted(indent=4, units='C')
 
@@ -719,6 +738,61 @@ class Bme688Test(Test):
         return True
 
 
+class SensorPlanTest(Test):
+    """Checks that every sensor reads steadily, all at once on the device."""
+
+    _TIMEOUT_S = 15.0
+    _SAMPLES = {
+        factory_pb2.Test.Type.LTR559_PROX: 100,
+        factory_pb2.Test.Type.LTR559_LIGHT: 100,
+        factory_pb2.Test.Type.BME688: 10,
+    }
+
+    def __init__(self, rpcs):
+        super().__init__('SensorPlanTest', rpcs)
+        self._factory_service = rpcs.factory.Factory
+
+    def run(self) -> bool:
+        plan = factory_pb2.TestPlan(
+            tests=[
+                factory_pb2.BurstRequest(test=test, samples=samples)
+                for test, samples in SensorPlanTest._SAMPLES.items()
+            ]
+        )
+        print_message('Sampling all sensors')
+        call = self._factory_service.RunTestPlan.invoke(
+            plan, on_next=self._on_result
+        )
+        try:
+            status, _ = call.wait(timeout_s=SensorPlanTest._TIMEOUT_S)
+        except RpcTimeout:
+            call.cancel()
+            self.fail_test('sensor_plan: timed out')
+            return False
+        if status is not Status.OK:
+            self.fail_test(f'sensor_plan: {status}')
+            return False
+        return self.failed_tests == 0
+
+    def _on_result(self, _, result: factory_pb2.TestResult) -> None:
+        name = factory_pb2.Test.Type.Name(result.test).lower()
+        if result.status != Status.OK.value:
+            self.fail_test(f'{name}_burst: {Status(result.status)}')
+            return
+
+        statistics = result.result.statistics
+        print_message(
+            f'    {name}: {statistics.count} samples in '
+            f'{result.result.duration_ms} ms; min: {statistics.min:.2f}, '
+            f'max: {statistics.max:.2f}, mean: {statistics.mean:.2f}, '
+            f'stddev: {statistics.stddev:.2f}'
+        )
+        if result.result.passed:
+            self.pass_test(f'{name}_burst')
+        else:
+            self.fail_test(f'{name}_burst')
+
+
 @dataclass
 class FactoryRunMetadata:
     operator: str
@@ -743,6 +817,7 @@ def _run_tests(run_metadata: FactoryRunMetadata, rpcs) -> bool:
     run_metadata.print_formatted()
 
     tests_to_run = [
+        SensorPlanTest(rpcs),
         LedTest(rpcs),
         ButtonsTest(rpcs),
         Ltr559Test(rpcs),
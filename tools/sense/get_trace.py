@@ -0,0 +1,191 @@
+# Copyright 2024 The Pigweed Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+"""Reads the tokenized trace from a device and converts it for viewing.
+
+Requires firmware built with `--config=trace`. Writes a Chrome trace JSON
+file that chrome://tracing and https://ui.perfetto.dev can open, for example:
+
+  bazelisk run //tools:get_trace -- --device /dev/ttyACM0 \
+      --token-databases $PWD/bazel-bin/apps/production/rp2040.elf \
+      --output /tmp/sense_trace.json
+
+Tracing starts at boot. By default the trace is stopped, read, and restarted
+so that the next read covers the time since this one.
+"""
+
+import argparse
+import json
+import logging
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional, Tuple
+
+from sense.device import get_device_connection
+
+_LOG = logging.getLogger(__file__)
+
+# Chrome trace phases for the pw_trace event types, and whether the event
+# carries a trace ID.
+_PHASES: Dict[str, Tuple[str, bool]] = {
+    'PW_TRACE_EVENT_TYPE_INSTANT': ('i', False),
+    'PW_TRACE_EVENT_TYPE_INSTANT_GROUP': ('i', False),
+    'PW_TRACE_EVENT_TYPE_ASYNC_START': ('b', True),
+    'PW_TRACE_EVENT_TYPE_ASYNC_STEP': ('n', True),
+    'PW_TRACE_EVENT_TYPE_ASYNC_END': ('e', True),
+    'PW_TRACE_EVENT_TYPE_DURATION_START': ('B', False),
+    'PW_TRACE_EVENT_TYPE_DURATION_END': ('E', False),
+    'PW_TRACE_EVENT_TYPE_DURATION_GROUP_START': ('B', False),
+    'PW_TRACE_EVENT_TYPE_DURATION_GROUP_END': ('E', False),
+}
+
+
+def _parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        '--output',
+        type=Path,
+        default=Path('sense_trace.json'),
+        help='Chrome trace JSON file to write',
+    )
+    parser.add_argument(
+        '--no-restart',
+        action='store_true',
+        help='Leave tracing stopped after reading the trace',
+    )
+    args, _remaining_args = parser.parse_known_args()
+    return args
+
+
+def _read_varint(data: bytes, pos: int) -> Tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError('Truncated varint in trace')
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def _entries(raw: bytes) -> Iterator[bytes]:
+    """Splits the size-prefixed entries of a dering'd trace buffer."""
+    pos = 0
+    while pos < len(raw):
+        size, pos = _read_varint(raw, pos)
+        yield raw[pos : pos + size]
+        pos += size
+
+
+def _describe(detokenizer: Any, token: int) -> List[str]:
+    """Returns the type, flags, module, group, and label of a trace token."""
+    if detokenizer is not None:
+        entries = detokenizer.database.token_to_entries.get(token, [])
+        if entries:
+            fields = str(entries[0]).split('|')
+            if len(fields) == 5:
+                return fields
+    return ['PW_TRACE_EVENT_TYPE_INSTANT', '0', '', '', f'${token:08x}']
+
+
+def convert(
+    raw: bytes, ticks_per_second: int, detokenizer: Any
+) -> List[Dict[str, Any]]:
+    """Converts pw_trace_tokenized entries into Chrome trace events."""
+    events: List[Dict[str, Any]] = []
+    tids: Dict[str, int] = {}
+    ticks = 0
+    for entry in _entries(raw):
+        token = int.from_bytes(entry[:4], 'little')
+        delta, pos = _read_varint(entry, 4)
+        ticks += delta
+        event_type, _flags, module, group, label = _describe(detokenizer, token)
+        phase, has_id = _PHASES.get(event_type, ('i', False))
+
+        # Each group gets its own track, so nested scopes from different
+        # contexts do not interleave.
+        track = group or module or 'default'
+        if track not in tids:
+            tids[track] = len(tids) + 1
+            events.append(
+                {
+                    'name': 'thread_name',
+                    'ph': 'M',
+                    'pid': 0,
+                    'tid': tids[track],
+                    'args': {'name': track},
+                }
+            )
+
+        event: Dict[str, Any] = {
+            'name': label,
+            'cat': module or group or 'sense',
+            'ph': phase,
+            'ts': ticks * 1_000_000 / ticks_per_second,
+            'pid': 0,
+            'tid': tids[track],
+        }
+        if has_id and pos < len(entry):
+            trace_id, pos = _read_varint(entry, pos)
+            event['id'] = trace_id
+        if phase == 'i':
+            event['s'] = 't'
+        if pos < len(entry):
+            event['args'] = {'data': entry[pos:].hex()}
+        events.append(event)
+    return events
+
+
+def _read_trace(profiling: Any) -> Tuple[bytes, int]:
+    data = bytearray()
+    ticks_per_second = 0
+    while True:
+        chunk = profiling.ReadTrace(offset=len(data)).unwrap_or_raise()
+        ticks_per_second = chunk.ticks_per_second
+        data += chunk.data
+        if not chunk.data or len(data) >= chunk.total_size:
+            return bytes(data), ticks_per_second
+
+
+def main() -> None:
+    args = _parse_args()
+    device_connection = get_device_connection()
+
+    with device_connection as device:
+        profiling = device.rpcs.profiling.Profiling
+        profiling.Stop().unwrap_or_raise()
+        try:
+            raw, ticks_per_second = _read_trace(profiling)
+        finally:
+            if not args.no_restart:
+                profiling.Start().unwrap_or_raise()
+        detokenizer: Optional[Any] = getattr(device, 'detokenizer', None)
+
+    if ticks_per_second == 0:
+        _LOG.error('The device did not report its trace clock rate')
+        return
+
+    events = convert(raw, ticks_per_second, detokenizer)
+    args.output.write_text(json.dumps({'traceEvents': events}))
+    _LOG.info(
+        'Wrote %d trace events (%d bytes of trace) to %s',
+        len(events),
+        len(raw),
+        args.output,
+    )
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,143 @@
+# Copyright 2024 The Pigweed Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+"""Breaks down button-to-LED latency from a logic-analyzer capture.
+
+Build the firmware with GPIO markers enabled, capture GP16 to GP21 while
+pressing buttons, and export the capture as CSV with a time column followed
+by one column per channel. For example:
+
+  bazelisk build --config=rp2040 --config=gpio_markers \
+      //apps/production:rp2040.elf
+  bazelisk run //tools:marker_latency -- $PWD/capture.csv
+
+Every marker toggles its pin, so each edge on a channel is one event. Each
+button edge that follows a quiet period starts a press, and every later stage
+is matched to its first edge after the previous stage.
+"""
+
+import argparse
+import csv
+from pathlib import Path
+import statistics
+from typing import Dict, List, Optional, Sequence
+
+# Stages in the order they happen, matching `sense::GpioMarker`.
+STAGES = (
+    'ButtonEdge',
+    'ButtonPublish',
+    'Publish',
+    'NotifySubscribers',
+    'StateManagerUpdate',
+    'LedUpdate',
+)
+
+
+def read_edges(path: Path) -> List[List[float]]:
+    """Returns the times, in seconds, of the edges on each channel."""
+    edges: List[List[float]] = []
+    previous: Optional[List[str]] = None
+    with path.open(newline='') as capture:
+        rows = csv.reader(capture)
+        next(rows)  # Header
+        for row in rows:
+            if not row:
+                continue
+            time, levels = float(row[0]), [v.strip() for v in row[1:]]
+            if previous is None:
+                edges = [[] for _ in levels]
+            else:
+                for channel, (old, new) in enumerate(zip(previous, levels)):
+                    if old != new:
+                        edges[channel].append(time)
+            previous = levels
+    return edges
+
+
+def _first_after(times: Sequence[float], start: float) -> Optional[float]:
+    for time in times:
+        if time >= start:
+            return time
+    return None
+
+
+def press_latencies(
+    edges: List[List[float]], quiet: float, window: float
+) -> Dict[str, List[float]]:
+    """Returns the delay from the previous stage for each stage and press."""
+    deltas: Dict[str, List[float]] = {stage: [] for stage in STAGES[1:]}
+    deltas['Total'] = []
+    last_edge = float('-inf')
+    for edge in edges[0]:
+        is_press = edge - last_edge >= quiet
+        last_edge = edge
+        if not is_press:
+            continue
+        previous = edge
+        for stage, times in zip(STAGES[1:], edges[1:]):
+            time = _first_after(times, previous)
+            if time is None or time - edge > window:
+                break
+            deltas[stage].append(time - previous)
+            previous = time
+        else:
+            deltas['Total'].append(previous - edge)
+    return deltas
+
+
+def _parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', type=Path, help='CSV export to analyze')
+    parser.add_argument(
+        '--quiet',
+        type=float,
+        default=0.2,
+        help='Seconds without a button edge before an edge starts a press',
+    )
+    parser.add_argument(
+        '--window',
+        type=float,
+        default=0.1,
+        help='Seconds after a press within which every stage must happen',
+    )
+    return parser.parse_args()
+
+
+def _us(seconds: float) -> str:
+    return f'{seconds * 1e6:>10.1f}'
+
+
+def main() -> None:
+    args = _parse_args()
+    edges = read_edges(args.capture)
+    if len(edges) < len(STAGES):
+        raise SystemExit(
+            f'Expected {len(STAGES)} channels, found {len(edges)}'
+        )
+    deltas = press_latencies(edges, args.quiet, args.window)
+
+    print(f'{"Stage (us)":<20} {"Count":>6} {"Min":>10} {"Median":>10} '
+          f'{"P90":>10} {"Max":>10}')
+    for stage, values in deltas.items():
+        if not values:
+            print(f'{stage:<20} {0:>6}')
+            continue
+        values.sort()
+        p90 = values[min(len(values) - 1, int(0.9 * len(values)))]
+        print(f'{stage:<20} {len(values):>6} {_us(values[0])} '
+              f'{_us(statistics.median(values))} {_us(p90)} '
+              f'{_us(values[-1])}')
+
+
+if __name__ == '__main__':
+    main()
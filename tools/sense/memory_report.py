@@ -0,0 +1,128 @@
+# Copyright 2024 The Pigweed Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+"""Reports the static RAM each module of a firmware image uses.
+
+Groups the .data and .bss symbols of an ELF by the source directory they are
+defined in, using the debug line information. Run it on a firmware image,
+for example:
+
+  bazelisk build //apps/production:rp2040.elf
+  bazelisk run //tools:memory_report -- \
+      $PWD/bazel-bin/apps/production/rp2040.elf
+"""
+
+import argparse
+from collections import defaultdict
+from dataclasses import dataclass, field
+import re
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+# nm symbol types for initialized and zero-initialized data.
+_RAM_SYMBOL_TYPES = frozenset('bBdD')
+
+# Source directories that make up a module, most specific first.
+_MODULE_PATTERNS = (
+    re.compile(r'(?:^|/)((?:modules|apps|targets)/[^/]+)/'),
+    re.compile(r'(?:^|/)(device|system)/'),
+    re.compile(r'(?:^|/)(pw_[a-z0-9_]+)/'),
+    re.compile(r'(?:^|/)(freertos|FreeRTOS[^/]*)/', re.IGNORECASE),
+    re.compile(r'(?:^|/)(pico-sdk|tinyusb)/'),
+)
+
+_NM_LINE = re.compile(
+    r'^(?P<address>[0-9a-f]+) (?P<size>[0-9a-f]+) (?P<type>\w) '
+    r'(?P<name>\S+)(?:\t(?P<path>[^:]+):\d+)?$'
+)
+
+
+@dataclass
+class Module:
+    name: str
+    size: int = 0
+    symbols: List[Tuple[int, str]] = field(default_factory=list)
+
+
+def _module_for(path: Optional[str]) -> str:
+    if not path:
+        return '(no debug info)'
+    for pattern in _MODULE_PATTERNS:
+        match = pattern.search(path)
+        if match:
+            return match.group(1)
+    return '(other)'
+
+
+def _find_nm(requested: Optional[str]) -> str:
+    for candidate in (requested, 'arm-none-eabi-nm', 'nm'):
+        if candidate and shutil.which(candidate):
+            return candidate
+    sys.exit('No GNU nm found; pass one with --nm')
+
+
+def collect(elf: Path, nm: str) -> Dict[str, Module]:
+    """Returns the static RAM of each module in the ELF."""
+    output = subprocess.run(
+        [nm, '--print-size', '--line-numbers', '--defined-only', str(elf)],
+        check=True,
+        capture_output=True,
+        text=True,
+    ).stdout
+
+    modules: Dict[str, Module] = {}
+    for line in output.splitlines():
+        match = _NM_LINE.match(line)
+        if not match or match['type'] not in _RAM_SYMBOL_TYPES:
+            continue
+        name = _module_for(match['path'])
+        module = modules.setdefault(name, Module(name))
+        size = int(match['size'], 16)
+        module.size += size
+        module.symbols.append((size, match['name']))
+    return modules
+
+
+def _parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', type=Path, help='Firmware image to inspect')
+    parser.add_argument('--nm', help='GNU nm binary to use')
+    parser.add_argument(
+        '--symbols',
+        type=int,
+        default=0,
+        help='List this many of the largest symbols in each module',
+    )
+    return parser.parse_args()
+
+
+def main() -> None:
+    args = _parse_args()
+    modules = collect(args.elf, _find_nm(args.nm))
+    total = sum(module.size for module in modules.values())
+
+    print(f'{"Module":<40} {"Bytes":>8} {"Share":>6}')
+    for module in sorted(modules.values(), key=lambda m: -m.size):
+        share = 100 * module.size / total if total else 0
+        print(f'{module.name:<40} {module.size:>8} {share:>5.1f}%')
+        largest = sorted(module.symbols, reverse=True)[: args.symbols]
+        for size, symbol in largest:
+            print(f'    {symbol[:36]:<36} {size:>8}')
+    print(f'{"Total":<40} {total:>8}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,120 @@
+# Copyright 2024 The Pigweed Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+"""Records the live PubSub event stream of a device to a file.
+
+The recording can be replayed on the host at full speed with the simulation
+replay tool, for example:
+
+  bazelisk run //tools:record_events -- --device /dev/ttyACM0 \
+      --output /tmp/office.snsrec
+  bazelisk run //modules/simulation:replay -- /tmp/office.snsrec
+
+Recording runs until interrupted with Ctrl-C.
+
+The file starts with the 6 byte magic `SNSREC` and a version byte, followed
+by each event as a varint length and a serialized `pubsub.Event`. Events
+carry `dispatch_time_us`, the time the device sent them.
+"""
+
+import argparse
+import logging
+from pathlib import Path
+import threading
+import time
+from typing import BinaryIO
+
+from pubsub_pb import pubsub_pb2
+from sense.device import get_device_connection
+
+_LOG = logging.getLogger(__file__)
+
+MAGIC = b'SNSREC'
+VERSION = 1
+
+
+def _parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        '--output',
+        type=Path,
+        default=Path('sense_events.snsrec'),
+        help='Recording file to write',
+    )
+    args, _remaining_args = parser.parse_known_args()
+    return args
+
+
+def _encode_varint(value: int) -> bytes:
+    data = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            data.append(byte | 0x80)
+        else:
+            data.append(byte)
+            return bytes(data)
+
+
+class _Recorder:
+    def __init__(self, output: BinaryIO) -> None:
+        self._output = output
+        self._lock = threading.Lock()
+        self.events = 0
+        self.dropped = 0
+
+    def record(self, event: pubsub_pb2.Event) -> None:
+        # Firmware without capture support leaves the time unset, so fall back
+        # to when the host received the event.
+        if not event.dispatch_time_us:
+            event.dispatch_time_us = time.monotonic_ns() // 1000
+        data = event.SerializeToString()
+        with self._lock:
+            self._output.write(_encode_varint(len(data)) + data)
+            self.events += 1
+            if event.dropped:
+                self.dropped += event.dropped
+                _LOG.warning('The device dropped %d events', event.dropped)
+
+
+def main() -> None:
+    args = _parse_args()
+    device_connection = get_device_connection()
+
+    with device_connection as device, args.output.open('wb') as output:
+        output.write(MAGIC + bytes([VERSION]))
+        recorder = _Recorder(output)
+        call = device.rpcs.pubsub.PubSub.Subscribe.invoke(
+            pubsub_pb2.SubscribeRequest(capture=True),
+            on_next=lambda _call, event: recorder.record(event),
+        )
+        _LOG.info('Recording events to %s; press Ctrl-C to stop', args.output)
+        try:
+            while True:
+                time.sleep(1)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            call.cancel()
+
+    _LOG.info(
+        'Recorded %d events (%d dropped by the device) to %s',
+        recorder.events,
+        recorder.dropped,
+        args.output,
+    )
+
+
+if __name__ == '__main__':
+    main()
@@ -37,6 +37,10 @@ const protos: ProtoSet[] = [
     prefix: "board",
     protos: ["../modules/board/board.proto"],
   },
+  {
+    prefix: "history",
+    protos: ["../modules/history/history.proto"],
+  },
   {
     prefix: "state_manager",
     protos: ["../modules/state_manager/state_manager.proto"],
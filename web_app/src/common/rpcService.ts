@@ -23,7 +23,34 @@ import {
   MeasureStreamRequest,
   Measurement,
 } from "../../protos/collection/air_sensor/air_sensor_pb";
+import {
+  ExportChunk,
+  ExportRequest,
+  Series,
+  Tier,
+} from "../../protos/collection/history/history_pb";
 import { State } from "../../protos/collection/state_manager/state_manager_pb";
+
+/** Points of one history series, decoded from `ExportHistory` chunks. */
+export interface HistoryPoints {
+  /** Start of each point's period, in seconds since boot. */
+  times: Uint32Array;
+  means: Float32Array;
+  /** Only present when the export included ranges. */
+  mins?: Float32Array;
+  maxs?: Float32Array;
+}
+
+// Copies a little-endian column out of a chunk, since typed arrays need
+// aligned offsets and protobuf bytes fields have none.
+function column<T>(
+  data: Uint8Array,
+  offset: number,
+  length: number,
+  type: { new (buffer: ArrayBuffer): T },
+): T {
+  return new type(data.slice(offset, offset + length).buffer);
+}
 class RPCService {
   transport;
   decoder;
@@ -35,6 +62,7 @@ class RPCService {
   boardTempService;
   measureService;
   stateService;
+  historyExportService;
   constructor(rpcAddress = 82) {
     this.transport = new WebSerial.WebSerialTransport();
     this.decoder = new pw_hdlc.Decoder();
@@ -61,6 +89,9 @@ class RPCService {
     this.stateService = this.client
       .channel()
       .methodStub("state_manager.StateManager.GetState");
+    this.historyExportService = this.client
+      .channel()
+      .methodStub("history.History.ExportHistory");
   }
 
   async connect() {
@@ -133,6 +164,71 @@ class RPCService {
     const [status, response] = await this.stateService.call();
     return response;
   }
+
+  /**
+   * Fetches a history series in packed chunks, following the pagination
+   * until the requested range has been exported.
+   */
+  async exportHistory(
+    series: Series,
+    tier: Tier,
+    startS: number = 0,
+    includeRange: boolean = false,
+  ): Promise<HistoryPoints> {
+    const chunks: ExportChunk[] = [];
+    let total = 0;
+    let next: number | undefined = startS;
+    while (next !== undefined) {
+      const req = new ExportRequest();
+      req.setSeries(series);
+      req.setTier(tier);
+      req.setStartS(next);
+      req.setIncludeRange(includeRange);
+      const [status, chunk] = await this.historyExportService.call(req);
+      if (status !== pw_status.Status.OK) {
+        throw new Error(`ExportHistory failed: ${pw_status.Status[status]}`);
+      }
+      chunks.push(chunk);
+      total += chunk.getCount();
+      next = chunk.hasNextStartS() ? chunk.getNextStartS() : undefined;
+    }
+
+    const points: HistoryPoints = {
+      times: new Uint32Array(total),
+      means: new Float32Array(total),
+    };
+    if (includeRange) {
+      points.mins = new Float32Array(total);
+      points.maxs = new Float32Array(total);
+    }
+    let index = 0;
+    for (const chunk of chunks) {
+      const data = chunk.getData_asU8();
+      const count = chunk.getCount();
+      const scale = chunk.getScale();
+      const lanes = [points.means, points.mins, points.maxs].slice(
+        0,
+        chunk.getIncludeRange() ? 3 : 1,
+      );
+      lanes.forEach((lane, i) => {
+        const values = column(data, i * count * 4, count * 4, Int32Array);
+        values.forEach((value, j) => (lane![index + j] = value / scale));
+      });
+      const deltas = column(
+        data,
+        lanes.length * count * 4,
+        count * 2,
+        Uint16Array,
+      );
+      let time = chunk.getStartS();
+      deltas.forEach((delta, j) => {
+        time += delta * chunk.getPeriodS();
+        points.times[index + j] = time;
+      });
+      index += count;
+    }
+    return points;
+  }
 }
 
 // We keep a singleton of this service.
@@ -15,6 +15,19 @@
 import React, { useEffect, useState } from 'react'
 import { getRpcService } from '../common/rpcService';
 import { useAppState } from '../common/state';
+import { AirQualityRating } from '../../protos/collection/state_manager/state_manager_pb';
+
+const AQ_DESCRIPTIONS = {
+    [AirQualityRating.AIR_QUALITY_RATING_INVALID]: "invalid",
+    [AirQualityRating.AIR_QUALITY_RATING_TERRIBLE]: "terrible",
+    [AirQualityRating.AIR_QUALITY_RATING_BAD]: "bad",
+    [AirQualityRating.AIR_QUALITY_RATING_MEDIOCRE]: "mediocre",
+    [AirQualityRating.AIR_QUALITY_RATING_OKAY]: "okay",
+    [AirQualityRating.AIR_QUALITY_RATING_GOOD]: "good",
+    [AirQualityRating.AIR_QUALITY_RATING_VERY_GOOD]: "very good",
+    [AirQualityRating.AIR_QUALITY_RATING_EXCELLENT]: "excellent",
+    [AirQualityRating.AIR_QUALITY_RATING_SUPERB]: "superb",
+} as const;
 
 function formatDate() {
     const date = new Date();
@@ -72,7 +85,7 @@ export function Header(){
                             alarmState: {
                             alarmActive: state.getAlarmActive(),
                             alarmThreshold: state.getAlarmThreshold(),
-                            aqDescription: state.getAqDescription().toLowerCase() as any
+                            aqDescription: AQ_DESCRIPTIONS[state.getAqRating()] ?? "invalid"
                             }
                         })
                         });